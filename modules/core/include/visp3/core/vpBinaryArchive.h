@@ -0,0 +1,307 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Versioned and endian-safe binary archive.
+ *
+ *****************************************************************************/
+
+#ifndef vpBinaryArchive_h
+#define vpBinaryArchive_h
+
+/*!
+  \file vpBinaryArchive.h
+  \brief Versioned and endian-safe binary archive.
+*/
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpArray2D.h>
+#include <visp3/core/vpCameraParameters.h>
+#include <visp3/core/vpException.h>
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpRGBa.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*!
+  \class vpBinaryArchive
+  \ingroup group_core_files_io
+
+  \brief Versioned and endian-safe binary archive used to save and load ViSP objects.
+
+  An archive starts with a magic number and a format version, followed by the
+  serialized objects. Each object is written as a section made of a tag and a
+  version number followed by its data, so that a reader can check what it loads
+  and keep compatibility with older versions of an object. Numbers are always
+  stored in little-endian order and swapped on big-endian hosts.
+
+  An archive can be written to or read from a file, a std::ostream/std::istream
+  or a memory buffer. When a file is opened for reading under Unix, it is
+  memory-mapped: loading an object only copies its data from the mapping, and
+  the raw data can also be accessed without copy with map().
+
+  Objects are saved with operator<< and loaded with operator>>. Overloads are
+  provided for vpArray2D (and thus vpMatrix, vpColVector, vpHomogeneousMatrix,
+  vpPoseVector...), vpImage and vpCameraParameters. Other modules provide
+  their own overloads (see for example vpMe or vpMbTracker::saveState()).
+
+  \code
+#include <visp3/core/vpBinaryArchive.h>
+#include <visp3/core/vpHomogeneousMatrix.h>
+
+int main()
+{
+  vpHomogeneousMatrix cMo(0.1, 0.2, 0.5, 0, 0, M_PI);
+  vpImage<unsigned char> I(480, 640, 128);
+  vpCameraParameters cam(600, 600, 320, 240);
+
+  {
+    vpBinaryArchive ar("snapshot.bin", vpBinaryArchive::WRITE);
+    ar << cMo << I << cam;
+  }
+
+  vpBinaryArchive ar("snapshot.bin", vpBinaryArchive::READ);
+  ar >> cMo >> I >> cam;
+}
+  \endcode
+*/
+class VISP_EXPORT vpBinaryArchive
+{
+public:
+  /*!
+    Archive opening mode.
+  */
+  typedef enum {
+    READ,  /*!< The archive is read. */
+    WRITE  /*!< The archive is written. */
+  } vpArchiveMode;
+
+  vpBinaryArchive();
+  vpBinaryArchive(const char *filename, const vpArchiveMode &mode);
+  vpBinaryArchive(const std::string &filename, const vpArchiveMode &mode);
+  explicit vpBinaryArchive(std::ostream &os);
+  explicit vpBinaryArchive(std::istream &is);
+  vpBinaryArchive(const void *buffer, const size_t &size);
+  virtual ~vpBinaryArchive();
+
+  void close();
+
+  /*!
+    Return the format version of the archive.
+  */
+  inline unsigned int getVersion() const { return m_version; }
+
+  /*!
+    Return true if the archive is opened for reading, false if it is opened for writing.
+  */
+  inline bool isReading() const { return m_mode == READ; }
+
+  /*!
+    Return true if the data are read from memory (memory-mapped file or user buffer).
+    In that case map() gives a direct access to the archive data.
+  */
+  inline bool isMemoryBased() const { return m_buffer != NULL; }
+
+  static bool isLittleEndian();
+
+  const void *map(const size_t &size);
+
+  void open(const std::string &filename, const vpArchiveMode &mode);
+
+  void readBytes(void *data, const size_t &size);
+  unsigned int readSection(const unsigned int &tag, const unsigned int &maxVersion);
+
+  /*!
+    Read a number stored in little-endian order.
+    \param value : Read value. \e T has to be an arithmetic type.
+  */
+  template<class T> void readValue(T &value) { readValues(&value, 1); }
+  template<class T> void readValues(T *values, const size_t &n);
+
+  void writeBytes(const void *data, const size_t &size);
+  void writeSection(const unsigned int &tag, const unsigned int &version);
+
+  /*!
+    Write a number in little-endian order.
+    \param value : Value to write. \e T has to be an arithmetic type.
+  */
+  template<class T> void writeValue(const T &value) { writeValues(&value, 1); }
+  template<class T> void writeValues(const T *values, const size_t &n);
+
+  //! Current version of the archive format.
+  static const unsigned int FORMAT_VERSION;
+
+private:
+  vpBinaryArchive(const vpBinaryArchive &);
+  vpBinaryArchive &operator=(const vpBinaryArchive &);
+
+  void readHeader();
+  static void swapBytes(void *data, const size_t &elemSize, const size_t &n);
+  void writeHeader();
+
+  vpArchiveMode m_mode;
+  unsigned int m_version;
+  std::ostream *m_os;
+  std::istream *m_is;
+  std::fstream m_file;
+  const char *m_buffer;
+  size_t m_bufferSize;
+  size_t m_bufferPos;
+  const unsigned char *m_mapping;
+  size_t m_mappingSize;
+};
+
+/*!
+  Read \e n numbers stored in little-endian order.
+
+  \param values : Pointer to the memory where the \e n values are read. \e T has to be an arithmetic type.
+  \param n : Number of values to read.
+*/
+template<class T>
+void vpBinaryArchive::readValues(T *values, const size_t &n)
+{
+  readBytes(values, n * sizeof(T));
+  if (sizeof(T) > 1 && ! isLittleEndian())
+    swapBytes(values, sizeof(T), n);
+}
+
+/*!
+  Write \e n numbers in little-endian order.
+
+  \param values : Pointer to the \e n values to write. \e T has to be an arithmetic type.
+  \param n : Number of values to write.
+*/
+template<class T>
+void vpBinaryArchive::writeValues(const T *values, const size_t &n)
+{
+  if (sizeof(T) == 1 || isLittleEndian()) {
+    writeBytes(values, n * sizeof(T));
+  }
+  else {
+    // Swap by chunks to avoid a copy of the whole array
+    T buf[256];
+    for (size_t i = 0; i < n; i += 256) {
+      size_t chunk = (n - i < 256) ? n - i : 256;
+      for (size_t j = 0; j < chunk; j++)
+        buf[j] = values[i + j];
+      swapBytes(buf, sizeof(T), chunk);
+      writeBytes(buf, chunk * sizeof(T));
+    }
+  }
+}
+
+//! Section tag of a vpArray2D.
+#define VP_ARCHIVE_TAG_ARRAY2D 0x44325241 // "AR2D"
+//! Section tag of a vpImage.
+#define VP_ARCHIVE_TAG_IMAGE   0x20474d49 // "IMG "
+//! Section tag of a vpCameraParameters.
+#define VP_ARCHIVE_TAG_CAMERA  0x204d4143 // "CAM "
+
+/*!
+  Save an array (vpMatrix, vpColVector, vpHomogeneousMatrix, vpPoseVector...) in an archive.
+  \e Type has to be an arithmetic type.
+*/
+template<class Type>
+vpBinaryArchive &operator<<(vpBinaryArchive &ar, const vpArray2D<Type> &A)
+{
+  ar.writeSection(VP_ARCHIVE_TAG_ARRAY2D, 1);
+  ar.writeValue((unsigned int)sizeof(Type));
+  ar.writeValue(A.getRows());
+  ar.writeValue(A.getCols());
+  ar.writeValues(A.data, A.size());
+  return ar;
+}
+
+/*!
+  Load an array (vpMatrix, vpColVector, vpHomogeneousMatrix, vpPoseVector...) from an archive.
+  The array is resized if needed. \e Type has to be an arithmetic type.
+*/
+template<class Type>
+vpBinaryArchive &operator>>(vpBinaryArchive &ar, vpArray2D<Type> &A)
+{
+  ar.readSection(VP_ARCHIVE_TAG_ARRAY2D, 1);
+  unsigned int elemSize, rows, cols;
+  ar.readValue(elemSize);
+  ar.readValue(rows);
+  ar.readValue(cols);
+  if (elemSize != sizeof(Type)) {
+    throw(vpException(vpException::ioError, "Cannot load an array of elements of size %d in an array of elements of size %d",
+                      elemSize, (unsigned int)sizeof(Type)));
+  }
+  if (A.getRows() != rows || A.getCols() != cols)
+    A.resize(rows, cols, false);
+  ar.readValues(A.data, (size_t)rows * cols);
+  return ar;
+}
+
+/*!
+  Save an image in an archive. \e Type has to be an arithmetic type.
+*/
+template<class Type>
+vpBinaryArchive &operator<<(vpBinaryArchive &ar, const vpImage<Type> &I)
+{
+  ar.writeSection(VP_ARCHIVE_TAG_IMAGE, 1);
+  ar.writeValue((unsigned int)sizeof(Type));
+  ar.writeValue(I.getHeight());
+  ar.writeValue(I.getWidth());
+  ar.writeValues(I.bitmap, I.getSize());
+  return ar;
+}
+
+/*!
+  Load an image from an archive. The image is resized if needed.
+  \e Type has to be an arithmetic type.
+*/
+template<class Type>
+vpBinaryArchive &operator>>(vpBinaryArchive &ar, vpImage<Type> &I)
+{
+  ar.readSection(VP_ARCHIVE_TAG_IMAGE, 1);
+  unsigned int elemSize, height, width;
+  ar.readValue(elemSize);
+  ar.readValue(height);
+  ar.readValue(width);
+  if (elemSize != sizeof(Type)) {
+    throw(vpException(vpException::ioError, "Cannot load an image of pixels of size %d in an image of pixels of size %d",
+                      elemSize, (unsigned int)sizeof(Type)));
+  }
+  if (I.getHeight() != height || I.getWidth() != width)
+    I.resize(height, width);
+  ar.readValues(I.bitmap, (size_t)height * width);
+  return ar;
+}
+
+VISP_EXPORT vpBinaryArchive &operator<<(vpBinaryArchive &ar, const vpImage<vpRGBa> &I);
+VISP_EXPORT vpBinaryArchive &operator>>(vpBinaryArchive &ar, vpImage<vpRGBa> &I);
+VISP_EXPORT vpBinaryArchive &operator<<(vpBinaryArchive &ar, const vpCameraParameters &cam);
+VISP_EXPORT vpBinaryArchive &operator>>(vpBinaryArchive &ar, vpCameraParameters &cam);
+
+#endif
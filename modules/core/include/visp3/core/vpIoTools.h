@@ -154,6 +154,7 @@ class VISP_EXPORT vpIoTools
 public:
   static void getUserName(std::string &username);
   static std::string getUserName();
+  static std::string getTempPath();
   static std::string getenv(const char *env);
   static std::string getenv(const std::string &env);
   static std::string getViSPImagesDataPath();
@@ -193,6 +194,13 @@ public:
   static std::pair<std::string, std::string> splitDrive(const std::string& pathname);
   static std::vector<std::string> splitChain(const std::string & chain, const std::string & sep);
 
+  static std::vector<std::string> getDirFiles(const std::string &dirname);
+  static std::vector<long> getFileSequence(const std::string &genericName);
+  static void clearFileSequenceCache();
+  static bool mapFile(const std::string &filename, const unsigned char *&data, size_t &size);
+  static void unmapFile(const unsigned char *data, const size_t size);
+  static void readAhead(const std::string &filename);
+
   /*!
     @name Configuration file parsing
   */
@@ -40,8 +40,12 @@
 
 #include <visp3/core/vpConfig.h>
 #include <visp3/core/vpRequest.h>
+#include <visp3/core/vpArray2D.h>
+#include <visp3/core/vpImage.h>
 
 #include <vector>
+#include <map>
+#include <deque>
 #include <stdio.h>
 #include <string.h>
 #include <iostream>
@@ -52,6 +56,11 @@
 #  include <netinet/in.h>
 #  include <arpa/inet.h>
 #  include <netdb.h>
+#  include <sys/uio.h>
+#  include <poll.h>
+#  if defined(__linux__)
+#    include <sys/epoll.h>
+#  endif
 #else
 #  include<io.h>
 //#  include<winsock.h>
@@ -73,6 +82,18 @@
   \warning This class shouldn't be used directly. You better use vpClient and
   vpServer to simulate your network. Some exemples are provided in these classes.
 
+  Under Linux, the receptors are watched with an epoll instance rather than
+  select(), so that a server can handle a large number of clients without
+  rebuilding a file descriptor set at each call. All the sockets ready at once
+  are retrieved by a single epoll call, and handled by the following calls.
+
+  Images and arrays (vpMatrix, vpColVector, vpPoseVector...) can be exchanged
+  as length-prefixed frames using sendImageTo(), sendArrayTo(), receiveImageFrom()
+  and receiveArrayFrom(). A frame is made of a small header followed by the raw
+  data of the container, that is sent (scatter/gather) and received directly
+  from/to the container memory without intermediate string encoding as done
+  in the "request" mode.
+
   \sa vpServer
   \sa vpNetwork
 */
@@ -109,6 +130,24 @@ protected:
       socketFileDescriptorEmitter = 0;
     }
   };
+
+  /*!
+    Type of the data carried by a frame.
+  */
+  typedef enum {
+    FRAME_IMAGE = 1, /*!< Frame containing a vpImage. */
+    FRAME_ARRAY = 2  /*!< Frame containing a vpArray2D (vpMatrix, vpColVector, vpPoseVector...). */
+  } vpFrameType;
+
+  struct vpFrameHeader{
+    unsigned int          magic;
+    unsigned int          type;
+    unsigned int          rows;
+    unsigned int          cols;
+    unsigned int          elemSize;
+
+    vpFrameHeader() : magic(0), type(0), rows(0), cols(0), elemSize(0) {}
+  };
   
   //######## PARAMETERS ########
   //#                          #
@@ -139,8 +178,30 @@ protected:
   long                    tv_usec;
   
   bool                    verboseMode;
+
+#if defined(__linux__)
+  int                     epollFileDescriptor;
+  //! Index in receptor_list of each receptor socket registered in the epoll instance
+  std::map<int, unsigned int> epollReceptorIndex;
+  //! Sockets reported ready by epoll and not handled yet by _waitForReceptor()
+  std::deque<int>         epollPendingSockets;
+#endif
   
+  void              _addReceptor(const vpReceptor &receptor);
+  void              _removeReceptor(const unsigned int &index);
+  int               _waitForReceptor(const int &receptorEmitting = -1);
+#if defined(__linux__)
+  void              _discardPendingSocket(const int &socketFileDescriptor);
+#endif
+
+  int               _sendFrameTo(const vpFrameHeader &header, const void *data, const unsigned int &dest);
+  int               _receiveFrameHeaderFrom(vpFrameHeader &header, const unsigned int &receptorEmitting);
+  int               _receiveAllFrom(void *data, const size_t &size, const unsigned int &receptorEmitting);
+  int               _skipFrameData(const vpFrameHeader &header, const unsigned int &receptorEmitting);
+
 private:
+  vpNetwork(const vpNetwork &);
+  vpNetwork &operator=(const vpNetwork &);
   
   std::vector<int>  _handleRequests();
   int               _handleFirstRequest();
@@ -187,6 +248,11 @@ public:
   int               receive(T* object, const unsigned int &sizeOfObject = sizeof(T));
   template<typename T>
   int               receiveFrom(T* object, const unsigned int &receptorEmitting, const unsigned int &sizeOfObject = sizeof(T));
+
+  template<class Type>
+  int               receiveArrayFrom(vpArray2D<Type> &A, const unsigned int &receptorEmitting);
+  template<class Type>
+  int               receiveImageFrom(vpImage<Type> &I, const unsigned int &receptorEmitting);
   
   std::vector<int>  receiveRequest();
   std::vector<int>  receiveRequestFrom(const unsigned int &receptorEmitting);
@@ -204,6 +270,11 @@ public:
   int               send(T* object, const int unsigned &sizeOfObject = sizeof(T));
   template<typename T>
   int               sendTo(T* object, const unsigned int &dest, const unsigned int &sizeOfObject = sizeof(T));
+
+  template<class Type>
+  int               sendArrayTo(const vpArray2D<Type> &A, const unsigned int &dest);
+  template<class Type>
+  int               sendImageTo(const vpImage<Type> &I, const unsigned int &dest);
   
   int               sendRequest(vpRequest &req);
   int               sendRequestTo(vpRequest &req, const unsigned int &dest);
@@ -281,49 +352,29 @@ int vpNetwork::receive(T* object, const unsigned int &sizeOfObject)
     return -1;
   }
   
-  tv.tv_sec = tv_sec;
-  tv.tv_usec = tv_usec;
-  
-  FD_ZERO(&readFileDescriptor);        
-  
-  for(unsigned int i=0; i<receptor_list.size(); i++){
-    FD_SET((unsigned int)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor);
-
-    if(i == 0)
-      socketMax = receptor_list[i].socketFileDescriptorReceptor;
-   
-    if(socketMax < receptor_list[i].socketFileDescriptorReceptor) socketMax = receptor_list[i].socketFileDescriptorReceptor; 
-  }
-
-  int value = select((int)socketMax+1,&readFileDescriptor,NULL,NULL,&tv);
+  int i = _waitForReceptor();
   int numbytes = 0;
   
-  if(value == -1){
+  if(i == -2){
     if(verboseMode)
       vpERROR_TRACE( "Select error" );
     return -1;
   }
-  else if(value == 0){
+  else if(i == -1){
     //Timeout
     return 0;
   }
   else{
-    for(unsigned int i=0; i<receptor_list.size(); i++){
-      if(FD_ISSET((unsigned int)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor)){
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
-        numbytes = recv(receptor_list[i].socketFileDescriptorReceptor, (char*)(void*)object, sizeOfObject, 0);
+    numbytes = recv(receptor_list[(unsigned)i].socketFileDescriptorReceptor, (char*)(void*)object, sizeOfObject, 0);
 #else
-        numbytes = recv((unsigned int)receptor_list[i].socketFileDescriptorReceptor, (char*)(void*)object, (int)sizeOfObject, 0);
+    numbytes = recv((unsigned int)receptor_list[(unsigned)i].socketFileDescriptorReceptor, (char*)(void*)object, (int)sizeOfObject, 0);
 #endif
-        if(numbytes <= 0)
-        {
-          std::cout << "Disconnected : " << inet_ntoa(receptor_list[i].receptorAddress.sin_addr) << std::endl;
-          receptor_list.erase(receptor_list.begin()+(int)i);
-          return numbytes;
-        }
-        
-        break;
-      }
+    if(numbytes <= 0)
+    {
+      std::cout << "Disconnected : " << inet_ntoa(receptor_list[(unsigned)i].receptorAddress.sin_addr) << std::endl;
+      _removeReceptor((unsigned)i);
+      return numbytes;
     }
   }
   
@@ -361,39 +412,29 @@ int vpNetwork::receiveFrom(T* object, const unsigned int &receptorEmitting, cons
     return -1;
   }
   
-  tv.tv_sec = tv_sec;
-  tv.tv_usec = tv_usec;
-  
-  FD_ZERO(&readFileDescriptor);
-  
-  socketMax = receptor_list[receptorEmitting].socketFileDescriptorReceptor;
-  FD_SET((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor,&readFileDescriptor);
-    
-  int value = select((int)socketMax+1,&readFileDescriptor,NULL,NULL,&tv);
+  int value = _waitForReceptor((int)receptorEmitting);
   int numbytes = 0;
   
-  if(value == -1){
+  if(value == -2){
     if(verboseMode)
       vpERROR_TRACE( "Select error" );
     return -1;
   }
-  else if(value == 0){
+  else if(value == -1){
     //timeout
     return 0;
   }
   else{
-    if(FD_ISSET((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor,&readFileDescriptor)){
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
-      numbytes = recv(receptor_list[receptorEmitting].socketFileDescriptorReceptor, (char*)(void*)object, sizeOfObject, 0);
+    numbytes = recv(receptor_list[receptorEmitting].socketFileDescriptorReceptor, (char*)(void*)object, sizeOfObject, 0);
 #else
-      numbytes = recv((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor, (char*)(void*)object, (int)sizeOfObject, 0);
+    numbytes = recv((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor, (char*)(void*)object, (int)sizeOfObject, 0);
 #endif
-      if(numbytes <= 0)
-      {
-        std::cout << "Disconnected : " << inet_ntoa(receptor_list[receptorEmitting].receptorAddress.sin_addr) << std::endl;
-        receptor_list.erase(receptor_list.begin()+(int)receptorEmitting);
-        return numbytes;
-      }
+    if(numbytes <= 0)
+    {
+      std::cout << "Disconnected : " << inet_ntoa(receptor_list[receptorEmitting].receptorAddress.sin_addr) << std::endl;
+      _removeReceptor(receptorEmitting);
+      return numbytes;
     }
   }
   
@@ -492,4 +533,141 @@ int vpNetwork::sendTo(T* object, const unsigned int &dest, const unsigned int &s
 #endif
 }
 
+/*!
+  Send an array (vpMatrix, vpColVector, vpRowVector, vpPoseVector...) as a frame to a specific receptor.
+  The frame header and the array data are sent in a single scatter/gather
+  operation, without copying the data in an intermediate buffer.
+
+  \warning The data are sent with the memory layout of the emitter. Both sides of the
+  network are supposed to share the same endianness and the same type \e Type.
+
+  \sa vpNetwork::receiveArrayFrom()
+  \sa vpNetwork::sendImageTo()
+
+  \param A : Array to send.
+  \param dest : Index of the receptor that you are sending the array.
+
+  \return The number of bytes sent (header included), or -1 if an error happened.
+*/
+template<class Type>
+int vpNetwork::sendArrayTo(const vpArray2D<Type> &A, const unsigned int &dest)
+{
+  vpFrameHeader header;
+  header.type = FRAME_ARRAY;
+  header.rows = A.getRows();
+  header.cols = A.getCols();
+  header.elemSize = (unsigned int)sizeof(Type);
+
+  return _sendFrameTo(header, A.data, dest);
+}
+
+/*!
+  Send an image as a frame to a specific receptor.
+  The frame header and the image bitmap are sent in a single scatter/gather
+  operation, without copying the bitmap in an intermediate buffer.
+
+  \warning Both sides of the network are supposed to share the same type \e Type.
+
+  \sa vpNetwork::receiveImageFrom()
+  \sa vpNetwork::sendArrayTo()
+
+  \param I : Image to send.
+  \param dest : Index of the receptor that you are sending the image.
+
+  \return The number of bytes sent (header included), or -1 if an error happened.
+*/
+template<class Type>
+int vpNetwork::sendImageTo(const vpImage<Type> &I, const unsigned int &dest)
+{
+  vpFrameHeader header;
+  header.type = FRAME_IMAGE;
+  header.rows = I.getHeight();
+  header.cols = I.getWidth();
+  header.elemSize = (unsigned int)sizeof(Type);
+
+  return _sendFrameTo(header, I.bitmap, dest);
+}
+
+/*!
+  Receives an array frame sent with sendArrayTo() from a specific receptor.
+  The array is resized if needed and the data are received directly in its memory.
+
+  If no frame is available in the limit of the timeout (see setTimeoutSec() and
+  setTimeoutUSec()), the function returns 0 and \e A is left unchanged. Once a frame
+  header is received, the function waits for the whole frame.
+
+  \sa vpNetwork::sendArrayTo()
+
+  \param A : Received array.
+  \param receptorEmitting : Index of the receptor emitting the frame.
+
+  \return The number of bytes received (header included), 0 on timeout, or -1 if an error
+  occured (including a frame that doesn't contain an array of \e Type).
+*/
+template<class Type>
+int vpNetwork::receiveArrayFrom(vpArray2D<Type> &A, const unsigned int &receptorEmitting)
+{
+  vpFrameHeader header;
+  int numbytes = _receiveFrameHeaderFrom(header, receptorEmitting);
+  if(numbytes <= 0)
+    return numbytes;
+
+  if(header.type != FRAME_ARRAY || header.elemSize != sizeof(Type)){
+    if(verboseMode)
+      vpTRACE( "Received frame doesn't contain the expected array type" );
+    _skipFrameData(header, receptorEmitting);
+    return -1;
+  }
+
+  if(A.getRows() != header.rows || A.getCols() != header.cols)
+    A.resize(header.rows, header.cols, false);
+
+  int res = _receiveAllFrom(A.data, (size_t)header.rows * header.cols * sizeof(Type), receptorEmitting);
+  if(res < 0)
+    return -1;
+
+  return numbytes + res;
+}
+
+/*!
+  Receives an image frame sent with sendImageTo() from a specific receptor.
+  The image is resized if needed and the bitmap is received directly in its memory.
+
+  If no frame is available in the limit of the timeout (see setTimeoutSec() and
+  setTimeoutUSec()), the function returns 0 and \e I is left unchanged. Once a frame
+  header is received, the function waits for the whole frame.
+
+  \sa vpNetwork::sendImageTo()
+
+  \param I : Received image.
+  \param receptorEmitting : Index of the receptor emitting the frame.
+
+  \return The number of bytes received (header included), 0 on timeout, or -1 if an error
+  occured (including a frame that doesn't contain an image of \e Type).
+*/
+template<class Type>
+int vpNetwork::receiveImageFrom(vpImage<Type> &I, const unsigned int &receptorEmitting)
+{
+  vpFrameHeader header;
+  int numbytes = _receiveFrameHeaderFrom(header, receptorEmitting);
+  if(numbytes <= 0)
+    return numbytes;
+
+  if(header.type != FRAME_IMAGE || header.elemSize != sizeof(Type)){
+    if(verboseMode)
+      vpTRACE( "Received frame doesn't contain the expected image type" );
+    _skipFrameData(header, receptorEmitting);
+    return -1;
+  }
+
+  if(I.getHeight() != header.rows || I.getWidth() != header.cols)
+    I.resize(header.rows, header.cols);
+
+  int res = _receiveAllFrom(I.bitmap, (size_t)header.rows * header.cols * sizeof(Type), receptorEmitting);
+  if(res < 0)
+    return -1;
+
+  return numbytes + res;
+}
+
 #endif
@@ -168,6 +168,10 @@ private:
   int          port;
   bool         started;
   unsigned int max_clients;
+
+#if defined(__linux__)
+  bool         _checkForConnectionsEpoll();
+#endif
   
 public:
   
@@ -169,6 +169,18 @@
     xmlWriteIntChild(node, "size_filter", m_size_filter);
   }
   \endcode
+
+  When the same configuration files are loaded many times by the same process
+  (for example when several trackers are started), the parsed documents can be
+  kept in memory with setCacheEnabled(). A document is parsed again only if the
+  modification time or the size of the file changed.
+
+  \code
+  vpXmlParser::setCacheEnabled(true);
+  vpDataParser parser1, parser2;
+  parser1.parse("config.xml"); // The file is read and parsed
+  parser2.parse("config.xml"); // The parsed document is reused
+  \endcode
     
 */
 class VISP_EXPORT vpXmlParser
@@ -303,8 +315,16 @@ public:
     */
   static void cleanup()
   {
+    clearCache();
     xmlCleanupParser();
   }
+
+  static void clearCache();
+  static unsigned int getCacheSize();
+  static bool isCacheEnabled();
+  static xmlDocPtr readDocument(const std::string &filename);
+  static void releaseDocument(xmlDocPtr doc);
+  static void setCacheEnabled(const bool enable);
   //@}
 
 };
@@ -146,7 +146,7 @@ vpXmlParserCamera::parse(vpCameraParameters &cam, const std::string &filename,
   xmlDocPtr doc;
   xmlNodePtr node;
 
-  doc = xmlParseFile(filename.c_str());
+  doc = vpXmlParser::readDocument(filename);
   if (doc == NULL)
   {
     return SEQUENCE_ERROR;
@@ -155,7 +155,7 @@ vpXmlParserCamera::parse(vpCameraParameters &cam, const std::string &filename,
   node = xmlDocGetRootElement(doc);
   if (node == NULL)
   {
-    xmlFreeDoc(doc);
+    vpXmlParser::releaseDocument(doc);
     return SEQUENCE_ERROR;
   }
 
@@ -163,7 +163,7 @@ vpXmlParserCamera::parse(vpCameraParameters &cam, const std::string &filename,
 
   cam = camera ;
 
-  xmlFreeDoc(doc);
+  vpXmlParser::releaseDocument(doc);
 
   return ret;
 }
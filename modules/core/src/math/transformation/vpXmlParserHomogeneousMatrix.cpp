@@ -113,7 +113,7 @@ vpXmlParserHomogeneousMatrix::parse(vpHomogeneousMatrix &M, const std::string &f
   xmlDocPtr doc;
   xmlNodePtr node;
 
-  doc = xmlParseFile(filename.c_str());
+  doc = vpXmlParser::readDocument(filename);
   if (doc == NULL)
   {
     std::cerr << std::endl
@@ -126,7 +126,7 @@ vpXmlParserHomogeneousMatrix::parse(vpHomogeneousMatrix &M, const std::string &f
   node = xmlDocGetRootElement(doc);
   if (node == NULL)
   {
-    xmlFreeDoc(doc);
+    vpXmlParser::releaseDocument(doc);
     return SEQUENCE_ERROR;
   }
 
@@ -134,7 +134,7 @@ vpXmlParserHomogeneousMatrix::parse(vpHomogeneousMatrix &M, const std::string &f
 
   M = m_M ;
 
-  xmlFreeDoc(doc);
+  vpXmlParser::releaseDocument(doc);
 
   return ret;
 }
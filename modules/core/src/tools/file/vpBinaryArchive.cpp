@@ -0,0 +1,420 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Versioned and endian-safe binary archive.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpBinaryArchive.cpp
+  \brief Versioned and endian-safe binary archive.
+*/
+
+#include <string.h>
+
+#include <visp3/core/vpBinaryArchive.h>
+#include <visp3/core/vpIoTools.h>
+
+// Magic number ("VPBA") at the beginning of an archive
+#define VP_ARCHIVE_MAGIC 0x41425056
+
+const unsigned int vpBinaryArchive::FORMAT_VERSION = 1;
+
+/*!
+  Default constructor. The archive has to be opened with open() before use.
+*/
+vpBinaryArchive::vpBinaryArchive()
+  : m_mode(READ), m_version(0), m_os(NULL), m_is(NULL), m_file(), m_buffer(NULL), m_bufferSize(0),
+    m_bufferPos(0), m_mapping(NULL), m_mappingSize(0)
+{
+}
+
+/*!
+  Open an archive file.
+
+  \param filename : Name of the archive file.
+  \param mode : Opening mode.
+
+  \exception vpException::ioError : If the file cannot be opened or is not a valid archive.
+  \sa open()
+*/
+vpBinaryArchive::vpBinaryArchive(const char *filename, const vpArchiveMode &mode)
+  : m_mode(READ), m_version(0), m_os(NULL), m_is(NULL), m_file(), m_buffer(NULL), m_bufferSize(0),
+    m_bufferPos(0), m_mapping(NULL), m_mappingSize(0)
+{
+  open(std::string(filename), mode);
+}
+
+/*!
+  Open an archive file.
+
+  \param filename : Name of the archive file.
+  \param mode : Opening mode.
+
+  \exception vpException::ioError : If the file cannot be opened or is not a valid archive.
+  \sa open()
+*/
+vpBinaryArchive::vpBinaryArchive(const std::string &filename, const vpArchiveMode &mode)
+  : m_mode(READ), m_version(0), m_os(NULL), m_is(NULL), m_file(), m_buffer(NULL), m_bufferSize(0),
+    m_bufferPos(0), m_mapping(NULL), m_mappingSize(0)
+{
+  open(filename, mode);
+}
+
+/*!
+  Create an archive written in an output stream. The stream has to be opened
+  in binary mode and has to remain valid while the archive is used.
+
+  \param os : Output stream.
+*/
+vpBinaryArchive::vpBinaryArchive(std::ostream &os)
+  : m_mode(WRITE), m_version(FORMAT_VERSION), m_os(&os), m_is(NULL), m_file(), m_buffer(NULL), m_bufferSize(0),
+    m_bufferPos(0), m_mapping(NULL), m_mappingSize(0)
+{
+  writeHeader();
+}
+
+/*!
+  Create an archive read from an input stream. The stream has to be opened
+  in binary mode and has to remain valid while the archive is used.
+
+  \param is : Input stream.
+
+  \exception vpException::ioError : If the stream doesn't contain a valid archive.
+*/
+vpBinaryArchive::vpBinaryArchive(std::istream &is)
+  : m_mode(READ), m_version(0), m_os(NULL), m_is(&is), m_file(), m_buffer(NULL), m_bufferSize(0),
+    m_bufferPos(0), m_mapping(NULL), m_mappingSize(0)
+{
+  readHeader();
+}
+
+/*!
+  Create an archive read from a memory buffer. The buffer is not copied and
+  has to remain valid while the archive is used.
+
+  \param buffer : Pointer to the archive data.
+  \param size : Size in bytes of the buffer.
+
+  \exception vpException::ioError : If the buffer doesn't contain a valid archive.
+*/
+vpBinaryArchive::vpBinaryArchive(const void *buffer, const size_t &size)
+  : m_mode(READ), m_version(0), m_os(NULL), m_is(NULL), m_file(), m_buffer((const char *)buffer), m_bufferSize(size),
+    m_bufferPos(0), m_mapping(NULL), m_mappingSize(0)
+{
+  readHeader();
+}
+
+/*!
+  Destructor that closes the archive.
+*/
+vpBinaryArchive::~vpBinaryArchive()
+{
+  close();
+}
+
+/*!
+  Close the archive. If the archive was written in a file, the file is flushed and closed.
+  If the archive was memory-mapped, the mapping is released.
+*/
+void vpBinaryArchive::close()
+{
+  vpIoTools::unmapFile(m_mapping, m_mappingSize);
+  m_mapping = NULL;
+  m_mappingSize = 0;
+
+  if (m_file.is_open())
+    m_file.close();
+
+  m_os = NULL;
+  m_is = NULL;
+  m_buffer = NULL;
+  m_bufferSize = 0;
+  m_bufferPos = 0;
+}
+
+/*!
+  Return true if the host stores numbers in little-endian order.
+*/
+bool vpBinaryArchive::isLittleEndian()
+{
+  const unsigned int one = 1;
+  return *((const unsigned char *)&one) == 1;
+}
+
+/*!
+  Give a direct access to the next \e size bytes of an archive read from memory
+  (memory-mapped file or user buffer), and move the read position after them.
+  This allows to use large data stored in an archive without copying them.
+
+  \param size : Number of bytes to access.
+
+  \return Pointer to the data, that remains valid until the archive is closed.
+
+  \exception vpException::ioError : If the archive is not read from memory or if the end of
+  the archive is reached.
+*/
+const void *vpBinaryArchive::map(const size_t &size)
+{
+  if (m_buffer == NULL) {
+    throw(vpException(vpException::ioError, "The archive is not read from memory"));
+  }
+  if (size > m_bufferSize - m_bufferPos) {
+    throw(vpException(vpException::ioError, "Unexpected end of archive"));
+  }
+  const void *data = m_buffer + m_bufferPos;
+  m_bufferPos += size;
+  return data;
+}
+
+/*!
+  Open an archive file. Under Unix, a file opened for reading is memory-mapped.
+
+  \param filename : Name of the archive file.
+  \param mode : Opening mode.
+
+  \exception vpException::ioError : If the file cannot be opened or is not a valid archive.
+*/
+void vpBinaryArchive::open(const std::string &filename, const vpArchiveMode &mode)
+{
+  close();
+  m_mode = mode;
+
+  if (mode == WRITE) {
+    m_file.open(filename.c_str(), std::fstream::out | std::fstream::binary | std::fstream::trunc);
+    if (! m_file.is_open()) {
+      throw(vpException(vpException::ioError, "Cannot open archive %s for writing", filename.c_str()));
+    }
+    m_os = &m_file;
+    m_version = FORMAT_VERSION;
+    writeHeader();
+    return;
+  }
+
+  if (vpIoTools::mapFile(filename, m_mapping, m_mappingSize) && m_mapping != NULL) {
+    m_buffer = (const char *)m_mapping;
+    m_bufferSize = m_mappingSize;
+    m_bufferPos = 0;
+    readHeader();
+    return;
+  }
+
+  m_file.open(filename.c_str(), std::fstream::in | std::fstream::binary);
+  if (! m_file.is_open()) {
+    throw(vpException(vpException::ioError, "Cannot open archive %s for reading", filename.c_str()));
+  }
+  m_is = &m_file;
+  readHeader();
+}
+
+/*!
+  Read raw bytes from the archive.
+
+  \param data : Memory where the bytes are copied.
+  \param size : Number of bytes to read.
+
+  \exception vpException::ioError : If the archive is not opened for reading or if the end of
+  the archive is reached.
+*/
+void vpBinaryArchive::readBytes(void *data, const size_t &size)
+{
+  if (size == 0)
+    return;
+
+  if (m_buffer != NULL) {
+    memcpy(data, map(size), size);
+  }
+  else if (m_is != NULL) {
+    m_is->read((char *)data, (std::streamsize)size);
+    if (m_is->gcount() != (std::streamsize)size) {
+      throw(vpException(vpException::ioError, "Unexpected end of archive"));
+    }
+  }
+  else {
+    throw(vpException(vpException::ioError, "The archive is not opened for reading"));
+  }
+}
+
+/*!
+  Read the header of an object section.
+
+  \param tag : Expected tag of the section.
+  \param maxVersion : Highest version of the section supported by the caller.
+
+  \return The version of the section, that allows to load objects saved with an older version.
+
+  \exception vpException::ioError : If the tag doesn't match or if the version is not supported.
+*/
+unsigned int vpBinaryArchive::readSection(const unsigned int &tag, const unsigned int &maxVersion)
+{
+  unsigned int readTag, version;
+  readValue(readTag);
+  readValue(version);
+  if (readTag != tag) {
+    throw(vpException(vpException::ioError, "Unexpected section 0x%08x in archive (0x%08x expected)", readTag, tag));
+  }
+  if (version > maxVersion) {
+    throw(vpException(vpException::ioError, "Unsupported version %d of section 0x%08x (%d at most)", version, tag, maxVersion));
+  }
+  return version;
+}
+
+/*!
+  Write raw bytes in the archive.
+
+  \param data : Data to write.
+  \param size : Number of bytes to write.
+
+  \exception vpException::ioError : If the archive is not opened for writing or if an error occurs.
+*/
+void vpBinaryArchive::writeBytes(const void *data, const size_t &size)
+{
+  if (m_os == NULL) {
+    throw(vpException(vpException::ioError, "The archive is not opened for writing"));
+  }
+  m_os->write((const char *)data, (std::streamsize)size);
+  if (m_os->fail()) {
+    throw(vpException(vpException::ioError, "Cannot write in archive"));
+  }
+}
+
+/*!
+  Write the header of an object section.
+
+  \param tag : Tag identifying the kind of object.
+  \param version : Version of the object serialization.
+*/
+void vpBinaryArchive::writeSection(const unsigned int &tag, const unsigned int &version)
+{
+  writeValue(tag);
+  writeValue(version);
+}
+
+void vpBinaryArchive::readHeader()
+{
+  unsigned int magic;
+  readValue(magic);
+  if (magic != VP_ARCHIVE_MAGIC) {
+    throw(vpException(vpException::ioError, "Not a ViSP binary archive"));
+  }
+  readValue(m_version);
+  if (m_version > FORMAT_VERSION) {
+    throw(vpException(vpException::ioError, "Unsupported archive version %d (%d at most)", m_version, FORMAT_VERSION));
+  }
+}
+
+void vpBinaryArchive::swapBytes(void *data, const size_t &elemSize, const size_t &n)
+{
+  unsigned char *ptr = (unsigned char *)data;
+  for (size_t i = 0; i < n; i++, ptr += elemSize) {
+    for (size_t j = 0; j < elemSize / 2; j++) {
+      unsigned char tmp = ptr[j];
+      ptr[j] = ptr[elemSize - 1 - j];
+      ptr[elemSize - 1 - j] = tmp;
+    }
+  }
+}
+
+void vpBinaryArchive::writeHeader()
+{
+  writeValue((unsigned int)VP_ARCHIVE_MAGIC);
+  writeValue(FORMAT_VERSION);
+}
+
+/*!
+  Save a color image in an archive.
+*/
+vpBinaryArchive &operator<<(vpBinaryArchive &ar, const vpImage<vpRGBa> &I)
+{
+  ar.writeSection(VP_ARCHIVE_TAG_IMAGE, 1);
+  ar.writeValue((unsigned int)sizeof(vpRGBa));
+  ar.writeValue(I.getHeight());
+  ar.writeValue(I.getWidth());
+  ar.writeBytes(I.bitmap, I.getSize() * sizeof(vpRGBa));
+  return ar;
+}
+
+/*!
+  Load a color image from an archive. The image is resized if needed.
+*/
+vpBinaryArchive &operator>>(vpBinaryArchive &ar, vpImage<vpRGBa> &I)
+{
+  ar.readSection(VP_ARCHIVE_TAG_IMAGE, 1);
+  unsigned int elemSize, height, width;
+  ar.readValue(elemSize);
+  ar.readValue(height);
+  ar.readValue(width);
+  if (elemSize != sizeof(vpRGBa)) {
+    throw(vpException(vpException::ioError, "Cannot load an image of pixels of size %d in a color image", elemSize));
+  }
+  if (I.getHeight() != height || I.getWidth() != width)
+    I.resize(height, width);
+  ar.readBytes(I.bitmap, (size_t)height * width * sizeof(vpRGBa));
+  return ar;
+}
+
+/*!
+  Save camera parameters in an archive. The field of view is not saved; it has to be
+  computed again with vpCameraParameters::computeFov() if needed.
+*/
+vpBinaryArchive &operator<<(vpBinaryArchive &ar, const vpCameraParameters &cam)
+{
+  ar.writeSection(VP_ARCHIVE_TAG_CAMERA, 1);
+  ar.writeValue((int)cam.get_projModel());
+  ar.writeValue(cam.get_px());
+  ar.writeValue(cam.get_py());
+  ar.writeValue(cam.get_u0());
+  ar.writeValue(cam.get_v0());
+  ar.writeValue(cam.get_kud());
+  ar.writeValue(cam.get_kdu());
+  return ar;
+}
+
+/*!
+  Load camera parameters from an archive.
+*/
+vpBinaryArchive &operator>>(vpBinaryArchive &ar, vpCameraParameters &cam)
+{
+  ar.readSection(VP_ARCHIVE_TAG_CAMERA, 1);
+  int projModel;
+  double px, py, u0, v0, kud, kdu;
+  ar.readValue(projModel);
+  ar.readValue(px);
+  ar.readValue(py);
+  ar.readValue(u0);
+  ar.readValue(v0);
+  ar.readValue(kud);
+  ar.readValue(kdu);
+  if (projModel == (int)vpCameraParameters::perspectiveProjWithDistortion)
+    cam.initPersProjWithDistortion(px, py, u0, v0, kud, kdu);
+  else
+    cam.initPersProjWithoutDistortion(px, py, u0, v0);
+  return ar;
+}
@@ -42,6 +42,7 @@
 #include <visp3/core/vpIoTools.h>
 #include <visp3/core/vpDebug.h>
 #include <visp3/core/vpIoException.h>
+#include <visp3/core/vpMutex.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <fstream>
@@ -52,8 +53,11 @@
 #include <limits>
 #include <cmath>
 #include <algorithm>
+#include <map>
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
 #  include <unistd.h>
+#  include <dirent.h>
+#  include <sys/mman.h>
 #elif defined(_WIN32)
 #  include <windows.h>
 #  include <direct.h>
@@ -193,6 +197,29 @@ vpIoTools::getUserName()
   return username;
 }
 
+/*!
+  Get the directory in which temporary files can be written.
+
+  - Under unix, the content of the TMPDIR environment variable if set, "/tmp" otherwise.
+  - Under windows, the content of the TEMP environment variable if set, "C:/temp" otherwise.
+
+  \return The path of the temporary directory.
+*/
+std::string
+vpIoTools::getTempPath()
+{
+#if defined(_WIN32)
+  const char *tmp = ::getenv("TEMP");
+  if (tmp == NULL || tmp[0] == '\0')
+    return "C:/temp";
+#else
+  const char *tmp = ::getenv("TMPDIR");
+  if (tmp == NULL || tmp[0] == '\0')
+    return "/tmp";
+#endif
+  return tmp;
+}
+
 /*!
   Get the content of an environment variable.
 
@@ -1508,3 +1535,336 @@ std::vector<std::string> vpIoTools::splitChain(const std::string & chain, const
 
   return subChain;
 }
+
+/*!
+  Return the sorted list of the names of the files contained in a directory.
+  The special entries "." and ".." as well as the sub-directories are not part
+  of the list.
+
+  \param dirname : Directory to list.
+
+  \exception vpIoException::invalidDirectoryName : If the directory cannot be
+  opened.
+
+  \sa getFileSequence()
+*/
+std::vector<std::string> vpIoTools::getDirFiles(const std::string &dirname)
+{
+  std::vector<std::string> files;
+  std::string _dirname = path(dirname);
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+  DIR *dir = opendir(_dirname.c_str());
+  if (dir == NULL) {
+    throw(vpIoException(vpIoException::invalidDirectoryName,
+                        "Cannot open directory %s", _dirname.c_str()));
+  }
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+#if defined(_DIRENT_HAVE_D_TYPE)
+    if (entry->d_type == DT_DIR)
+      continue;
+#endif
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    files.push_back(entry->d_name);
+  }
+  closedir(dir);
+#elif defined(_WIN32)
+  WIN32_FIND_DATAA data;
+  HANDLE handle = FindFirstFileA((_dirname + "\\*").c_str(), &data);
+  if (handle == INVALID_HANDLE_VALUE) {
+    throw(vpIoException(vpIoException::invalidDirectoryName,
+                        "Cannot open directory %s", _dirname.c_str()));
+  }
+  do {
+    if (! (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+      files.push_back(data.cFileName);
+  } while (FindNextFileA(handle, &data));
+  FindClose(handle);
+#endif
+
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+  struct vpFileSequence
+  {
+    long long mtime_sec;
+    long mtime_nsec;
+    std::vector<long> numbers;
+  };
+
+  std::map<std::string, vpFileSequence> vpFileSequenceCache;
+#if defined(VISP_HAVE_PTHREAD) || defined(_WIN32)
+  vpMutex vpFileSequenceMutex;
+#endif
+
+  bool vpDirectoryStamp(const std::string &dirname, long long &mtime_sec, long &mtime_nsec)
+  {
+    struct stat st;
+    if (stat(dirname.empty() ? "." : dirname.c_str(), &st) != 0)
+      return false;
+    mtime_sec = (long long)st.st_mtime;
+#if defined(__linux__)
+    mtime_nsec = (long)st.st_mtim.tv_nsec;
+#elif defined(__APPLE__) && defined(__MACH__)
+    mtime_nsec = (long)st.st_mtimespec.tv_nsec;
+#else
+    mtime_nsec = 0;
+#endif
+    return true;
+  }
+
+  /*
+    Split a file name template like "image%04d.pgm" into the parts before and
+    after the integer conversion. Return false if the template does not contain
+    exactly one integer conversion.
+  */
+  bool vpSplitFileTemplate(const std::string &name, std::string &prefix, std::string &suffix,
+                           bool &zeroPadded, size_t &width)
+  {
+    size_t start = std::string::npos, end = 0;
+    for (size_t i = 0; i < name.size(); i++) {
+      if (name[i] != '%')
+        continue;
+      if (i + 1 < name.size() && name[i+1] == '%')
+        return false; // Escaped % characters are not supported
+      if (start != std::string::npos)
+        return false;
+      start = i;
+      size_t j = i + 1;
+      zeroPadded = false;
+      while (j < name.size() && (name[j] == '0' || name[j] == '-' || name[j] == '+' || name[j] == ' ')) {
+        if (name[j] == '0')
+          zeroPadded = true;
+        j++;
+      }
+      width = 0;
+      while (j < name.size() && name[j] >= '0' && name[j] <= '9') {
+        width = 10 * width + (size_t)(name[j] - '0');
+        j++;
+      }
+      while (j < name.size() && (name[j] == 'l' || name[j] == 'h'))
+        j++;
+      if (j >= name.size() || (name[j] != 'd' && name[j] != 'i' && name[j] != 'u'))
+        return false;
+      end = j + 1;
+      i = j;
+    }
+    if (start == std::string::npos)
+      return false;
+    prefix = name.substr(0, start);
+    suffix = name.substr(end);
+    return true;
+  }
+}
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+/*!
+  Return the sorted numbers of the files that match a file name template like
+  the ones used by vpDiskGrabber or vpVideoReader, for example
+  "/local/image/image%04d.pgm".
+
+  The directory is listed once and the result is cached. The cache entry is
+  refreshed only if the modification time of the directory changed, that is if
+  files were added or removed. Finding the first and last images of a sequence
+  of thousands of images is then done without testing each file name.
+
+  \param genericName : File name template containing a single integer
+  conversion specification (%d, %04d, %ld...).
+
+  \return The sorted numbers of the existing files. The vector is empty if no
+  file matches or if the template is not supported.
+
+  \sa getDirFiles(), clearFileSequenceCache()
+*/
+std::vector<long> vpIoTools::getFileSequence(const std::string &genericName)
+{
+  std::string dirname, filename;
+  size_t sep = genericName.find_last_of(
+#if defined(_WIN32)
+        "/\\"
+#else
+        "/"
+#endif
+        );
+  if (sep == std::string::npos)
+    filename = genericName;
+  else {
+    dirname = genericName.substr(0, sep + 1);
+    filename = genericName.substr(sep + 1);
+  }
+
+  std::string prefix, suffix;
+  bool zeroPadded = false;
+  size_t width = 0;
+  if (! vpSplitFileTemplate(filename, prefix, suffix, zeroPadded, width))
+    return std::vector<long>();
+
+  long long mtime_sec;
+  long mtime_nsec;
+  if (! vpDirectoryStamp(dirname, mtime_sec, mtime_nsec))
+    return std::vector<long>();
+
+#if defined(VISP_HAVE_PTHREAD) || defined(_WIN32)
+  vpMutex::vpScopedLock lock(vpFileSequenceMutex);
+#endif
+
+  std::map<std::string, vpFileSequence>::const_iterator it = vpFileSequenceCache.find(genericName);
+  if (it != vpFileSequenceCache.end() && it->second.mtime_sec == mtime_sec && it->second.mtime_nsec == mtime_nsec)
+    return it->second.numbers;
+
+  vpFileSequence sequence;
+  sequence.mtime_sec = mtime_sec;
+  sequence.mtime_nsec = mtime_nsec;
+
+  std::vector<std::string> files = getDirFiles(dirname.empty() ? std::string(".") : dirname);
+  for (size_t i = 0; i < files.size(); i++) {
+    const std::string &f = files[i];
+    if (f.size() <= prefix.size() + suffix.size())
+      continue;
+    if (f.compare(0, prefix.size(), prefix) != 0 || f.compare(f.size() - suffix.size(), suffix.size(), suffix) != 0)
+      continue;
+
+    std::string digits = f.substr(prefix.size(), f.size() - prefix.size() - suffix.size());
+    bool valid = true;
+    for (size_t j = 0; j < digits.size() && valid; j++)
+      valid = (digits[j] >= '0' && digits[j] <= '9');
+    if (! valid)
+      continue;
+    // The name has to be the one produced by sprintf() with this template
+    if (zeroPadded) {
+      if (digits.size() < width || (digits.size() > width && digits[0] == '0'))
+        continue;
+    }
+    else if (digits.size() > 1 && digits[0] == '0')
+      continue;
+
+    sequence.numbers.push_back(atol(digits.c_str()));
+  }
+  std::sort(sequence.numbers.begin(), sequence.numbers.end());
+
+  vpFileSequenceCache[genericName] = sequence;
+  return sequence.numbers;
+}
+
+/*!
+  Clear the cache used by getFileSequence().
+*/
+void vpIoTools::clearFileSequenceCache()
+{
+#if defined(VISP_HAVE_PTHREAD) || defined(_WIN32)
+  vpMutex::vpScopedLock lock(vpFileSequenceMutex);
+#endif
+  vpFileSequenceCache.clear();
+}
+
+/*!
+  Map the content of a file in memory. Under Unix, the file is memory-mapped
+  and the pages are read on demand by the system, without intermediate copy.
+  On other platforms, the file is read in an allocated buffer. In both cases
+  the memory has to be released with unmapFile().
+
+  \param filename : Name of the file to map.
+  \param data : Pointer to the content of the file. Set to NULL for an empty file.
+  \param size : Size of the file in bytes.
+
+  \return true if the file could be mapped, false otherwise.
+
+  \sa unmapFile()
+*/
+bool vpIoTools::mapFile(const std::string &filename, const unsigned char *&data, size_t &size)
+{
+  data = NULL;
+  size = 0;
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  if (st.st_size > 0) {
+    void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+#if defined(MADV_SEQUENTIAL)
+    madvise(mapping, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+    data = (const unsigned char *)mapping;
+    size = (size_t)st.st_size;
+  }
+  ::close(fd); // The mapping remains valid after closing the file descriptor
+  return true;
+#else
+  std::ifstream file(filename.c_str(), std::ifstream::in | std::ifstream::binary);
+  if (! file.is_open())
+    return false;
+  file.seekg(0, std::ifstream::end);
+  std::streamoff length = file.tellg();
+  file.seekg(0, std::ifstream::beg);
+  if (length > 0) {
+    unsigned char *buffer = new unsigned char[(size_t)length];
+    if (! file.read((char *)buffer, length)) {
+      delete [] buffer;
+      return false;
+    }
+    data = buffer;
+    size = (size_t)length;
+  }
+  return true;
+#endif
+}
+
+/*!
+  Release the memory obtained with mapFile().
+
+  \param data : Pointer returned by mapFile().
+  \param size : Size returned by mapFile().
+*/
+void vpIoTools::unmapFile(const unsigned char *data, const size_t size)
+{
+  if (data == NULL)
+    return;
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+  munmap((void *)data, size);
+#else
+  (void)size;
+  delete [] data;
+#endif
+}
+
+/*!
+  Ask the system to start reading a file in the background, so that a later
+  read is served from the page cache. This is useful when the frames of a
+  sequence are read one after the other: the next frame is fetched while the
+  current one is processed. This function does nothing if the file does not
+  exist or if the system does not provide posix_fadvise().
+
+  \param filename : Name of the file that will be read soon.
+*/
+void vpIoTools::readAhead(const std::string &filename)
+{
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+#  if defined(POSIX_FADV_WILLNEED)
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+  ::close(fd);
+#  else
+  (void)filename;
+#  endif
+#else
+  (void)filename;
+#endif
+}
@@ -146,7 +146,7 @@ void vpClient::deconnect(const unsigned int &index)
 #else // _WIN32
     shutdown( receptor_list[index].socketFileDescriptorReceptor, SD_BOTH );
 #endif
-    receptor_list.erase(receptor_list.begin()+(int)index);
+    _removeReceptor(index);
   }  
 }
 
@@ -161,7 +161,7 @@ void vpClient::stop()
 #else // _WIN32
     shutdown( receptor_list[i].socketFileDescriptorReceptor, SD_BOTH );
 #endif
-    receptor_list.erase(receptor_list.begin()+(int)i);
+    _removeReceptor(i);
     i--;
   }
 }
@@ -204,7 +204,7 @@ bool vpClient::connectServer(vpNetwork::vpReceptor &serv)
     return false;
   }
   
-  receptor_list.push_back(serv);
+  _addReceptor(serv);
 
 #ifdef SO_NOSIGPIPE
   // Mac OS X does not have the MSG_NOSIGNAL flag. It does have this
@@ -36,16 +36,32 @@
  *****************************************************************************/
 
 
+#include <errno.h>
+
 #include <visp3/core/vpNetwork.h>
 
+// Magic number ("VPFR") at the beginning of each frame, used to detect a desynchronized stream
+#define VP_NETWORK_FRAME_MAGIC 0x56504652
+// Size in bytes of a serialized vpFrameHeader
+#define VP_NETWORK_FRAME_HEADER_SIZE 20
+
 vpNetwork::vpNetwork()
   : emitter(), receptor_list(), readFileDescriptor(), socketMax(0), request_list(),
     max_size_message(999999), separator("[*@*]"), beginning("[*start*]"), end("[*end*]"),
     param_sep("[*|*]"), currentMessageReceived(), tv(), tv_sec(0), tv_usec(10),
     verboseMode(false)
+#if defined(__linux__)
+  , epollFileDescriptor(-1), epollReceptorIndex(), epollPendingSockets()
+#endif
 { 
   tv.tv_sec = tv_sec;
   tv.tv_usec = tv_usec;
+
+#if defined(__linux__)
+  epollFileDescriptor = epoll_create(16); // The size argument is only a hint
+  if(epollFileDescriptor < 0)
+    vpERROR_TRACE( "vpNetwork::vpNetwork(), cannot create epoll instance." );
+#endif
   
 #if defined(_WIN32)
   //Enable the sockets to be used
@@ -58,6 +74,10 @@ vpNetwork::vpNetwork()
 
 vpNetwork::~vpNetwork()
 {
+#if defined(__linux__)
+  if(epollFileDescriptor >= 0)
+    close(epollFileDescriptor);
+#endif
 #if defined(_WIN32)
   WSACleanup();
 #endif
@@ -654,56 +674,38 @@ int vpNetwork::_receiveRequestOnce()
     return -1;
   }
   
-  tv.tv_sec = tv_sec;
-  tv.tv_usec = tv_usec;
-  
-  FD_ZERO(&readFileDescriptor);        
-  
-  for(unsigned int i=0; i<receptor_list.size(); i++){ 
-    if(i == 0)
-      socketMax = receptor_list[i].socketFileDescriptorReceptor;
-    
-    FD_SET((unsigned)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor); 
-    if(socketMax < receptor_list[i].socketFileDescriptorReceptor) socketMax = receptor_list[i].socketFileDescriptorReceptor; 
-  }
-
-  int value = select((int)socketMax+1,&readFileDescriptor,NULL,NULL,&tv);
+  int i = _waitForReceptor();
   int numbytes = 0;
   
-  if(value == -1){
+  if(i == -2){
     if(verboseMode)
       vpERROR_TRACE( "Select error" );
     return -1;
   }
-  else if(value == 0){
+  else if(i == -1){
     //Timeout
     return 0;
   }
   else{
-    for(unsigned int i=0; i<receptor_list.size(); i++){
-      if(FD_ISSET((unsigned int)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor)){
-        char *buf = new char [max_size_message];
+    char *buf = new char [max_size_message];
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
-        numbytes=recv(receptor_list[i].socketFileDescriptorReceptor, buf, max_size_message, 0);
+    numbytes=recv(receptor_list[(unsigned)i].socketFileDescriptorReceptor, buf, max_size_message, 0);
 #else
-        numbytes=recv((unsigned int)receptor_list[i].socketFileDescriptorReceptor, buf, (int)max_size_message, 0);
+    numbytes=recv((unsigned int)receptor_list[(unsigned)i].socketFileDescriptorReceptor, buf, (int)max_size_message, 0);
 #endif
-          
-        if(numbytes <= 0)
-        {
-          std::cout << "Disconnected : " << inet_ntoa(receptor_list[i].receptorAddress.sin_addr) << std::endl;
-          receptor_list.erase(receptor_list.begin()+(int)i);
-          delete [] buf;
-          return numbytes;
-        }
-        else if(numbytes > 0){
-          std::string returnVal(buf, (unsigned int)numbytes);
-          currentMessageReceived.append(returnVal);
-        }
-        delete [] buf;
-        break;
-      }
+      
+    if(numbytes <= 0)
+    {
+      std::cout << "Disconnected : " << inet_ntoa(receptor_list[(unsigned)i].receptorAddress.sin_addr) << std::endl;
+      _removeReceptor((unsigned)i);
+      delete [] buf;
+      return numbytes;
     }
+    else if(numbytes > 0){
+      std::string returnVal(buf, (unsigned int)numbytes);
+      currentMessageReceived.append(returnVal);
+    }
+    delete [] buf;
   }
   
   return numbytes;
@@ -740,50 +742,396 @@ int vpNetwork::_receiveRequestOnceFrom(const unsigned int &receptorEmitting)
     return -1;
   }
   
-  tv.tv_sec = tv_sec;
-  tv.tv_usec = tv_usec;
-  
-  FD_ZERO(&readFileDescriptor);        
-  
-  socketMax = receptor_list[receptorEmitting].socketFileDescriptorReceptor;
-  FD_SET((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor,&readFileDescriptor);
-
-  int value = select((int)socketMax+1,&readFileDescriptor,NULL,NULL,&tv);
+  int value = _waitForReceptor((int)receptorEmitting);
   int numbytes = 0;
-  if(value == -1){
+  if(value == -2){
     if(verboseMode)
       vpERROR_TRACE( "Select error" );
     return -1;
   }
-  else if(value == 0){
+  else if(value == -1){
     //Timeout
     return 0;
   }
   else{
-    if(FD_ISSET((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor,&readFileDescriptor)){
-      char *buf = new char [max_size_message];
+    char *buf = new char [max_size_message];
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
-      numbytes=recv(receptor_list[receptorEmitting].socketFileDescriptorReceptor, buf, max_size_message, 0);
+    numbytes=recv(receptor_list[receptorEmitting].socketFileDescriptorReceptor, buf, max_size_message, 0);
 #else
-      numbytes=recv((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor, buf, (int)max_size_message, 0);
+    numbytes=recv((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor, buf, (int)max_size_message, 0);
 #endif
-      if(numbytes <= 0)
-      {
-        std::cout << "Disconnected : " << inet_ntoa(receptor_list[receptorEmitting].receptorAddress.sin_addr) << std::endl;
-        receptor_list.erase(receptor_list.begin()+(int)receptorEmitting);
-        delete [] buf;
-        return numbytes;
-      }
-      else if(numbytes > 0){
-        std::string returnVal(buf, (unsigned int)numbytes);
-        currentMessageReceived.append(returnVal);
-      }
+    if(numbytes <= 0)
+    {
+      std::cout << "Disconnected : " << inet_ntoa(receptor_list[receptorEmitting].receptorAddress.sin_addr) << std::endl;
+      _removeReceptor(receptorEmitting);
       delete [] buf;
+      return numbytes;
+    }
+    else if(numbytes > 0){
+      std::string returnVal(buf, (unsigned int)numbytes);
+      currentMessageReceived.append(returnVal);
     }
+    delete [] buf;
   }
   
   return numbytes;
 }
 
+/*!
+  Add a receptor to the list of receptors. Under Linux the receptor socket is also
+  registered in the epoll instance used to wait for incoming data.
+
+  \param receptor : Receptor to add.
+*/
+void vpNetwork::_addReceptor(const vpReceptor &receptor)
+{
+  receptor_list.push_back(receptor);
+
+#if defined(__linux__)
+  if(epollFileDescriptor >= 0){
+    epollReceptorIndex[receptor.socketFileDescriptorReceptor] = (unsigned int)receptor_list.size()-1;
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = receptor.socketFileDescriptorReceptor;
+    if(epoll_ctl(epollFileDescriptor, EPOLL_CTL_ADD, receptor.socketFileDescriptorReceptor, &event) < 0 && verboseMode)
+      vpERROR_TRACE( "Cannot register the receptor in the epoll instance" );
+  }
+#endif
+}
+
+/*!
+  Remove a receptor from the list of receptors.
+
+  \param index : Index of the receptor to remove.
+*/
+void vpNetwork::_removeReceptor(const unsigned int &index)
+{
+  if(index >= receptor_list.size())
+    return;
+
+#if defined(__linux__)
+  if(epollFileDescriptor >= 0){
+    int fd = receptor_list[index].socketFileDescriptorReceptor;
+    struct epoll_event event; // Needed by kernels older than 2.6.9
+    memset(&event, 0, sizeof(event));
+    epoll_ctl(epollFileDescriptor, EPOLL_CTL_DEL, fd, &event);
+
+    // The following receptors are shifted in receptor_list
+    epollReceptorIndex.erase(fd);
+    for(std::map<int, unsigned int>::iterator it=epollReceptorIndex.begin(); it!=epollReceptorIndex.end(); ++it){
+      if(it->second > index)
+        it->second--;
+    }
+    _discardPendingSocket(fd);
+  }
+#endif
+
+  receptor_list.erase(receptor_list.begin()+(int)index);
+}
+
+/*!
+  Wait until a receptor has data to read, in the limit of the timeout set with
+  setTimeoutSec() and setTimeoutUSec().
+
+  Under Linux, waiting on all the receptors relies on epoll, so that the cost doesn't
+  depend on the number of connected receptors. All the receptors ready at once are
+  retrieved by a single epoll_wait() call; the ones that are not returned are kept
+  and returned by the next calls, without waiting. Note that in that case the timeout
+  resolution is the millisecond.
+
+  \param receptorEmitting : Index of the receptor to watch, or -1 to watch all the receptors.
+
+  \return Index of a receptor that has data to read, -1 if the timeout expired,
+  -2 if an error occured.
+*/
+int vpNetwork::_waitForReceptor(const int &receptorEmitting)
+{
+  if(receptor_list.size() == 0 || receptorEmitting >= (int)receptor_list.size())
+    return -2;
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+  int timeout = (int)(tv_sec * 1000 + tv_usec / 1000);
+
+#  if defined(__linux__)
+  if(receptorEmitting < 0 && epollFileDescriptor >= 0){
+    if(epollPendingSockets.empty()){
+      struct epoll_event events[64];
+      int value = epoll_wait(epollFileDescriptor, events, 64, timeout);
+      if(value < 0)
+        return (errno == EINTR) ? -1 : -2;
+      else if(value == 0)
+        return -1;
+
+      for(int e=0; e<value; e++)
+        epollPendingSockets.push_back(events[e].data.fd);
+    }
+
+    while(! epollPendingSockets.empty()){
+      std::map<int, unsigned int>::const_iterator it = epollReceptorIndex.find(epollPendingSockets.front());
+      epollPendingSockets.pop_front();
+      if(it != epollReceptorIndex.end())
+        return (int)it->second;
+    }
+    return -1;
+  }
+#  endif
+
+  if(receptorEmitting >= 0){
+    struct pollfd pfd;
+    pfd.fd = receptor_list[(unsigned)receptorEmitting].socketFileDescriptorReceptor;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int value = poll(&pfd, 1, timeout);
+    if(value < 0)
+      return (errno == EINTR) ? -1 : -2;
+    else if(value == 0)
+      return -1;
+#  if defined(__linux__)
+    // The data are read by the caller, a pending event would be outdated
+    _discardPendingSocket(pfd.fd);
+#  endif
+    return receptorEmitting;
+  }
+#endif
+
+  tv.tv_sec = tv_sec;
+  tv.tv_usec = tv_usec;
+
+  FD_ZERO(&readFileDescriptor);
+
+  unsigned int first = (receptorEmitting < 0) ? 0 : (unsigned)receptorEmitting;
+  unsigned int last = (receptorEmitting < 0) ? (unsigned)receptor_list.size() : first+1;
+
+  socketMax = receptor_list[first].socketFileDescriptorReceptor;
+  for(unsigned int i=first; i<last; i++){
+    FD_SET((unsigned)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor);
+    if(socketMax < receptor_list[i].socketFileDescriptorReceptor) socketMax = receptor_list[i].socketFileDescriptorReceptor;
+  }
+
+  int value = select((int)socketMax+1,&readFileDescriptor,NULL,NULL,&tv);
+  if(value == -1)
+    return -2;
+  else if(value == 0)
+    return -1;
+
+  for(unsigned int i=first; i<last; i++){
+    if(FD_ISSET((unsigned int)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor))
+      return (int)i;
+  }
+
+  return -1;
+}
+
+#if defined(__linux__)
+/*!
+  Forget the events reported by epoll for a socket and not handled yet.
+
+  \param socketFileDescriptor : Socket of the receptor.
+*/
+void vpNetwork::_discardPendingSocket(const int &socketFileDescriptor)
+{
+  for(std::deque<int>::iterator it=epollPendingSockets.begin(); it!=epollPendingSockets.end();){
+    if(*it == socketFileDescriptor)
+      it = epollPendingSockets.erase(it);
+    else
+      ++it;
+  }
+}
+#endif
+
+/*!
+  Send a frame made of a header and a data buffer to a specific receptor. The header
+  and the data are sent with a single scatter/gather call when available, so that the
+  data never need to be copied in an intermediate buffer.
+
+  \param header : Header of the frame. The magic number is set by this function.
+  \param data : Pointer to the frame data (header.rows * header.cols * header.elemSize bytes).
+  \param dest : Index of the receptor receiving the frame.
+
+  \return The number of bytes sent, or -1 if an error occured.
+*/
+int vpNetwork::_sendFrameTo(const vpFrameHeader &header, const void *data, const unsigned int &dest)
+{
+  if(receptor_list.size() == 0 || dest > (unsigned int)receptor_list.size()-1 )
+  {
+    if(verboseMode)
+      vpTRACE( "No receptor at the specified index." );
+    return -1;
+  }
+
+  unsigned int buf[VP_NETWORK_FRAME_HEADER_SIZE/sizeof(unsigned int)];
+  buf[0] = htonl(VP_NETWORK_FRAME_MAGIC);
+  buf[1] = htonl(header.type);
+  buf[2] = htonl(header.rows);
+  buf[3] = htonl(header.cols);
+  buf[4] = htonl(header.elemSize);
+
+  size_t dataSize = (size_t)header.rows * header.cols * header.elemSize;
+  size_t totalSize = VP_NETWORK_FRAME_HEADER_SIZE + dataSize;
+  if(totalSize > (size_t)0x7fffffff){
+    if(verboseMode)
+      vpTRACE( "Frame too large." );
+    return -1;
+  }
+
+  int flags = 0;
+#if defined(__linux__)
+  flags = MSG_NOSIGNAL; // Only for Linux
+#endif
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+  struct iovec iov[2];
+  iov[0].iov_base = (void *)buf;
+  iov[0].iov_len = VP_NETWORK_FRAME_HEADER_SIZE;
+  iov[1].iov_base = const_cast<void *>(data);
+  iov[1].iov_len = dataSize;
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = (dataSize > 0) ? 2 : 1;
+
+  size_t sent = 0;
+  while(sent < totalSize){
+    ssize_t n = sendmsg(receptor_list[dest].socketFileDescriptorReceptor, &msg, flags);
+    if(n < 0){
+      if(errno == EINTR)
+        continue;
+      return -1;
+    }
+    sent += (size_t)n;
+    // Advance the io vectors past the bytes already sent
+    while(n > 0 && msg.msg_iovlen > 0){
+      if((size_t)n >= msg.msg_iov[0].iov_len){
+        n -= (ssize_t)msg.msg_iov[0].iov_len;
+        msg.msg_iov++;
+        msg.msg_iovlen--;
+      }
+      else{
+        msg.msg_iov[0].iov_base = (char *)msg.msg_iov[0].iov_base + n;
+        msg.msg_iov[0].iov_len -= (size_t)n;
+        n = 0;
+      }
+    }
+  }
+#else
+  const char *chunks[2] = { (const char *)(void *)buf, (const char *)data };
+  size_t sizes[2] = { VP_NETWORK_FRAME_HEADER_SIZE, dataSize };
+  for(unsigned int c = 0; c < 2; c++){
+    size_t sent = 0;
+    while(sent < sizes[c]){
+      int n = ::send((unsigned)receptor_list[dest].socketFileDescriptorReceptor, chunks[c]+sent, (int)(sizes[c]-sent), flags);
+      if(n < 0)
+        return -1;
+      sent += (size_t)n;
+    }
+  }
+#endif
+
+  return (int)totalSize;
+}
+
+/*!
+  Wait for a frame from a specific receptor, in the limit of the timeout, and receive its header.
 
+  \param header : Received header.
+  \param receptorEmitting : Index of the receptor emitting the frame.
 
+  \return The number of bytes received, 0 on timeout, or -1 if an error occured.
+*/
+int vpNetwork::_receiveFrameHeaderFrom(vpFrameHeader &header, const unsigned int &receptorEmitting)
+{
+  if(receptor_list.size() == 0 || receptorEmitting > (unsigned int)receptor_list.size()-1 )
+  {
+    if(verboseMode)
+      vpTRACE( "No receptor at the specified index" );
+    return -1;
+  }
+
+  int value = _waitForReceptor((int)receptorEmitting);
+  if(value == -2){
+    if(verboseMode)
+      vpERROR_TRACE( "Select error" );
+    return -1;
+  }
+  else if(value == -1){
+    //Timeout
+    return 0;
+  }
+
+  unsigned int buf[VP_NETWORK_FRAME_HEADER_SIZE/sizeof(unsigned int)];
+  if(_receiveAllFrom(buf, VP_NETWORK_FRAME_HEADER_SIZE, receptorEmitting) < 0)
+    return -1;
+
+  header.magic = ntohl(buf[0]);
+  header.type = ntohl(buf[1]);
+  header.rows = ntohl(buf[2]);
+  header.cols = ntohl(buf[3]);
+  header.elemSize = ntohl(buf[4]);
+
+  if(header.magic != VP_NETWORK_FRAME_MAGIC){
+    if(verboseMode)
+      vpTRACE( "Incorrect frame" );
+    return -1;
+  }
+
+  return VP_NETWORK_FRAME_HEADER_SIZE;
+}
+
+/*!
+  Receive exactly \e size bytes from a specific receptor. If the receptor disconnects,
+  it is removed from the list of receptors.
+
+  \param data : Buffer where the received bytes are written.
+  \param size : Number of bytes to receive.
+  \param receptorEmitting : Index of the receptor emitting the data.
+
+  \return The number of bytes received, or -1 if an error occured.
+*/
+int vpNetwork::_receiveAllFrom(void *data, const size_t &size, const unsigned int &receptorEmitting)
+{
+  char *ptr = (char *)data;
+  size_t received = 0;
+  while(received < size){
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+    ssize_t n = recv(receptor_list[receptorEmitting].socketFileDescriptorReceptor, ptr + received, size - received, MSG_WAITALL);
+    if(n < 0 && errno == EINTR)
+      continue;
+#else
+    int n = recv((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor, ptr + received, (int)(size - received), 0);
+#endif
+    if(n <= 0){
+      std::cout << "Disconnected : " << inet_ntoa(receptor_list[receptorEmitting].receptorAddress.sin_addr) << std::endl;
+      _removeReceptor(receptorEmitting);
+      return -1;
+    }
+    received += (size_t)n;
+  }
+
+  return (int)received;
+}
+
+/*!
+  Drop the data of a frame whose header has already been received.
+
+  \param header : Header of the frame.
+  \param receptorEmitting : Index of the receptor emitting the frame.
+
+  \return The number of bytes dropped, or -1 if an error occured.
+*/
+int vpNetwork::_skipFrameData(const vpFrameHeader &header, const unsigned int &receptorEmitting)
+{
+  size_t size = (size_t)header.rows * header.cols * header.elemSize;
+  char buf[4096];
+  size_t skipped = 0;
+  while(skipped < size){
+    size_t chunk = (size - skipped < sizeof(buf)) ? size - skipped : sizeof(buf);
+    if(_receiveAllFrom(buf, chunk, receptorEmitting) < 0)
+      return -1;
+    skipped += chunk;
+  }
+
+  return (int)skipped;
+}
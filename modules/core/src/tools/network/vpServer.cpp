@@ -198,6 +198,11 @@ bool vpServer::checkForConnections()
       return false;
     }
   
+#if defined(__linux__)
+  if(epollFileDescriptor >= 0)
+    return _checkForConnectionsEpoll();
+#endif
+
   tv.tv_sec = tv_sec;
   tv.tv_usec = tv_usec;
   
@@ -242,7 +247,7 @@ bool vpServer::checkForConnections()
       
       client.receptorIP = inet_ntoa(client.receptorAddress.sin_addr);
       printf("New client connected : %s\n", inet_ntoa(client.receptorAddress.sin_addr));
-      receptor_list.push_back(client);
+      _addReceptor(client);
       
       return true;
     }
@@ -260,7 +265,7 @@ bool vpServer::checkForConnections()
           if(numbytes == 0)
           {
             std::cout << "Disconnected : " << inet_ntoa(receptor_list[i].receptorAddress.sin_addr) << std::endl;
-            receptor_list.erase(receptor_list.begin()+(int)i);
+            _removeReceptor(i);
             return 0;
           }
         }
@@ -271,6 +276,72 @@ bool vpServer::checkForConnections()
   return false;
 }
 
+#if defined(__linux__)
+/*!
+  Linux implementation of checkForConnections(). The listening socket and the epoll
+  instance watching the clients are polled together, so that only the clients that
+  have pending events are inspected.
+
+  \return True if a client connected, false otherwise (as with select(), a client
+  that disconnected is removed but false is returned).
+*/
+bool vpServer::_checkForConnectionsEpoll()
+{
+  struct pollfd pfd[2];
+  pfd[0].fd = emitter.socketFileDescriptorEmitter;
+  pfd[0].events = POLLIN;
+  pfd[0].revents = 0;
+  pfd[1].fd = epollFileDescriptor;
+  pfd[1].events = POLLIN;
+  pfd[1].revents = 0;
+
+  int timeout = (int)(tv_sec * 1000 + tv_usec / 1000);
+  int value = poll(pfd, 2, timeout);
+  if(value <= 0){
+    return false;
+  }
+
+  if(pfd[0].revents & POLLIN){
+    vpNetwork::vpReceptor client;
+    client.receptorAddressSize = sizeof(client.receptorAddress);
+    client.socketFileDescriptorReceptor = accept(emitter.socketFileDescriptorEmitter,(struct sockaddr*) &client.receptorAddress, &client.receptorAddressSize);
+
+    if((client.socketFileDescriptorReceptor) == -1){
+      vpERROR_TRACE( "vpServer::run(), accept()" );
+      return false;
+    }
+
+    client.receptorIP = inet_ntoa(client.receptorAddress.sin_addr);
+    printf("New client connected : %s\n", inet_ntoa(client.receptorAddress.sin_addr));
+    _addReceptor(client);
+
+    return true;
+  }
+
+  if(pfd[1].revents & POLLIN){
+    struct epoll_event events[64];
+    int nevents = epoll_wait(epollFileDescriptor, events, 64, 0);
+    for(int e=0; e<nevents; e++){
+      std::map<int, unsigned int>::const_iterator it = epollReceptorIndex.find(events[e].data.fd);
+      if(it == epollReceptorIndex.end())
+        continue;
+
+      unsigned int i = it->second;
+      char deco;
+      int numbytes = recv(receptor_list[i].socketFileDescriptorReceptor, &deco, 1, MSG_PEEK);
+      if(numbytes == 0)
+      {
+        std::cout << "Disconnected : " << inet_ntoa(receptor_list[i].receptorAddress.sin_addr) << std::endl;
+        _removeReceptor(i);
+        return false;
+      }
+    }
+  }
+
+  return false;
+}
+#endif
+
 /*!
   Print the connected clients. 
 */
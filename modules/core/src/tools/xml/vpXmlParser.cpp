@@ -42,12 +42,103 @@
 
 #include <visp3/core/vpException.h>
 #include <visp3/core/vpDebug.h>
+#include <visp3/core/vpMutex.h>
 #include <libxml/parser.h>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #include <string>
 #include <sstream>
 #include <iomanip>
 #include <typeinfo>
+#include <vector>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+  /*
+    A parsed document kept in the cache. The document is shared read-only
+    between all the parsers that load the same file. It is only freed once it
+    is no more referenced by the cache (stale) and no more used by a parser.
+  */
+  struct vpXmlCachedDocument
+  {
+    xmlDocPtr doc;
+    long long mtime_sec;
+    long mtime_nsec;
+    long long size;
+    unsigned int users;
+    bool stale;
+  };
+
+  typedef std::map<std::string, vpXmlCachedDocument *> vpXmlCachePathMap;
+  typedef std::map<xmlDocPtr, vpXmlCachedDocument *> vpXmlCacheDocMap;
+
+  bool vpXmlCacheEnabled = false;
+  vpXmlCachePathMap vpXmlCacheByPath;
+  vpXmlCacheDocMap vpXmlCacheByDoc;
+#if defined(VISP_HAVE_PTHREAD) || defined(_WIN32)
+  vpMutex vpXmlCacheMutex;
+#endif
+
+  class vpXmlCacheLock
+  {
+  public:
+    vpXmlCacheLock()
+    {
+#if defined(VISP_HAVE_PTHREAD) || defined(_WIN32)
+      vpXmlCacheMutex.lock();
+#endif
+    }
+    ~vpXmlCacheLock()
+    {
+#if defined(VISP_HAVE_PTHREAD) || defined(_WIN32)
+      vpXmlCacheMutex.unlock();
+#endif
+    }
+  };
+
+  bool vpXmlFileStamp(const std::string &filename, long long &mtime_sec, long &mtime_nsec, long long &size)
+  {
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0)
+      return false;
+    mtime_sec = (long long)st.st_mtime;
+#if defined(__linux__)
+    mtime_nsec = (long)st.st_mtim.tv_nsec;
+#elif defined(__APPLE__) && defined(__MACH__)
+    mtime_nsec = (long)st.st_mtimespec.tv_nsec;
+#else
+    mtime_nsec = 0;
+#endif
+    size = (long long)st.st_size;
+    return true;
+  }
+
+  // Has to be called with the cache lock held
+  void vpXmlCacheRetire(vpXmlCachedDocument *entry)
+  {
+    entry->stale = true;
+    if (entry->users == 0) {
+      vpXmlCacheByDoc.erase(entry->doc);
+      xmlFreeDoc(entry->doc);
+      delete entry;
+    }
+  }
+
+  // Has to be called with the cache lock held
+  void vpXmlCacheInvalidate(const std::string &filename)
+  {
+    vpXmlCachePathMap::iterator it = vpXmlCacheByPath.find(filename);
+    if (it != vpXmlCacheByPath.end()) {
+      vpXmlCachedDocument *entry = it->second;
+      vpXmlCacheByPath.erase(it);
+      vpXmlCacheRetire(entry);
+    }
+  }
+}
+#endif // DOXYGEN_SHOULD_SKIP_THIS
 
 /*!
   Basic constructor.
@@ -341,7 +432,7 @@ vpXmlParser::parse(const std::string& filename)
   xmlDocPtr doc;
   xmlNodePtr root_node;
 
-  doc = xmlParseFile(filename.c_str());
+  doc = readDocument(filename);
   if(doc == NULL){
   	vpERROR_TRACE("cannot open file");
   	throw vpException(vpException::ioError, "cannot open file");
@@ -349,13 +440,20 @@ vpXmlParser::parse(const std::string& filename)
 
   root_node = xmlDocGetRootElement(doc);
   if(root_node == NULL){
+    releaseDocument(doc);
   	vpERROR_TRACE("cannot get root element");
   	throw vpException(vpException::ioError, "cannot get root element");
   }
 
-  readMainClass(doc, root_node);
+  try {
+    readMainClass(doc, root_node);
+  }
+  catch(...) {
+    releaseDocument(doc);
+    throw;
+  }
 
-  xmlFreeDoc(doc);
+  releaseDocument(doc);
 }
 
 /*!
@@ -403,6 +501,180 @@ vpXmlParser::save(const std::string& filename, const bool append)
 
   xmlSaveFormatFile(filename.c_str(), doc, 1);
   xmlFreeDoc(doc);
+
+  {
+    vpXmlCacheLock lock;
+    vpXmlCacheInvalidate(filename);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              DOCUMENT CACHE                                */
+/* -------------------------------------------------------------------------- */
+
+/*!
+  Load the xml document corresponding to \e filename.
+
+  When the cache is enabled (see setCacheEnabled()), the parsed document is
+  kept in memory and shared between all the parsers that read the same file, as
+  long as the modification time and the size of the file do not change. Loading
+  a configuration that was already loaded is then reduced to a stat() call.
+
+  The returned document has to be considered as read-only and must be given
+  back with releaseDocument() instead of being freed with xmlFreeDoc().
+
+  \param filename : Name of the xml file to load.
+  \return The parsed document, or NULL if the file cannot be read or parsed.
+
+  \sa releaseDocument(), setCacheEnabled()
+*/
+xmlDocPtr
+vpXmlParser::readDocument(const std::string &filename)
+{
+  const int options = XML_PARSE_COMPACT | XML_PARSE_NONET;
+  long long mtime_sec, size;
+  long mtime_nsec;
+
+  // The lock is only held to access the cache, the files are parsed without
+  // it so that several threads can load their configuration at once.
+  bool enabled;
+  {
+    vpXmlCacheLock lock;
+    enabled = vpXmlCacheEnabled;
+  }
+  if (! enabled || ! vpXmlFileStamp(filename, mtime_sec, mtime_nsec, size))
+    return xmlReadFile(filename.c_str(), NULL, options);
+
+  {
+    vpXmlCacheLock lock;
+    vpXmlCachePathMap::iterator it = vpXmlCacheByPath.find(filename);
+    if (it != vpXmlCacheByPath.end()) {
+      vpXmlCachedDocument *entry = it->second;
+      if (entry->mtime_sec == mtime_sec && entry->mtime_nsec == mtime_nsec && entry->size == size) {
+        entry->users ++;
+        return entry->doc;
+      }
+    }
+  }
+
+  xmlDocPtr doc = xmlReadFile(filename.c_str(), NULL, options);
+  if (doc == NULL)
+    return NULL;
+
+  vpXmlCacheLock lock;
+
+  // The cache was disabled while parsing: the document is not shared and is
+  // freed by releaseDocument()
+  if (! vpXmlCacheEnabled)
+    return doc;
+
+  vpXmlCachePathMap::iterator it = vpXmlCacheByPath.find(filename);
+  if (it != vpXmlCacheByPath.end()) {
+    vpXmlCachedDocument *entry = it->second;
+    if (entry->mtime_sec == mtime_sec && entry->mtime_nsec == mtime_nsec && entry->size == size) {
+      // Another parser loaded the same file meanwhile
+      xmlFreeDoc(doc);
+      entry->users ++;
+      return entry->doc;
+    }
+    vpXmlCacheInvalidate(filename);
+  }
+
+  vpXmlCachedDocument *entry = new vpXmlCachedDocument;
+  entry->doc = doc;
+  entry->mtime_sec = mtime_sec;
+  entry->mtime_nsec = mtime_nsec;
+  entry->size = size;
+  entry->users = 1;
+  entry->stale = false;
+  vpXmlCacheByPath[filename] = entry;
+  vpXmlCacheByDoc[doc] = entry;
+
+  return doc;
+}
+
+/*!
+  Give back a document obtained with readDocument(). Documents that are not
+  owned by the cache are freed immediately.
+
+  \param doc : Document to release.
+*/
+void
+vpXmlParser::releaseDocument(xmlDocPtr doc)
+{
+  if (doc == NULL)
+    return;
+
+  vpXmlCacheLock lock;
+
+  vpXmlCacheDocMap::iterator it = vpXmlCacheByDoc.find(doc);
+  if (it == vpXmlCacheByDoc.end()) {
+    xmlFreeDoc(doc);
+    return;
+  }
+
+  vpXmlCachedDocument *entry = it->second;
+  if (entry->users > 0)
+    entry->users --;
+  if (entry->stale && entry->users == 0)
+    vpXmlCacheRetire(entry);
+}
+
+/*!
+  Enable or disable the cache of parsed documents shared by all the parsers.
+  The cache is disabled by default. Disabling the cache also clears it.
+
+  \param enable : true to keep the parsed documents in memory.
+
+  \sa clearCache(), readDocument()
+*/
+void
+vpXmlParser::setCacheEnabled(const bool enable)
+{
+  {
+    vpXmlCacheLock lock;
+    vpXmlCacheEnabled = enable;
+  }
+  if (! enable)
+    clearCache();
+}
+
+/*!
+  \return true if the cache of parsed documents is enabled.
+*/
+bool
+vpXmlParser::isCacheEnabled()
+{
+  vpXmlCacheLock lock;
+  return vpXmlCacheEnabled;
+}
+
+/*!
+  Free all the documents kept in the cache. Documents still in use by a parser
+  are freed as soon as they are released.
+*/
+void
+vpXmlParser::clearCache()
+{
+  vpXmlCacheLock lock;
+
+  std::vector<vpXmlCachedDocument *> entries;
+  for (vpXmlCachePathMap::iterator it = vpXmlCacheByPath.begin(); it != vpXmlCacheByPath.end(); ++it)
+    entries.push_back(it->second);
+  vpXmlCacheByPath.clear();
+
+  for (size_t i = 0; i < entries.size(); i++)
+    vpXmlCacheRetire(entries[i]);
+}
+
+/*!
+  \return The number of documents currently kept in the cache.
+*/
+unsigned int
+vpXmlParser::getCacheSize()
+{
+  vpXmlCacheLock lock;
+  return (unsigned int)vpXmlCacheByPath.size();
 }
 
 #elif !defined(VISP_BUILD_SHARED_LIBS)
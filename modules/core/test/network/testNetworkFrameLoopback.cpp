@@ -0,0 +1,138 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Benchmark of TCP framed messages over the loopback interface.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testNetworkFrameLoopback.cpp
+
+  Benchmark streaming VGA images and pose vectors between a vpClient and a
+  vpServer running in the same process over the loopback interface, using the
+  framed messages (vpNetwork::sendImageTo(), vpNetwork::sendArrayTo()).
+*/
+
+#include <visp3/core/vpConfig.h>
+
+#if defined(VISP_HAVE_PTHREAD) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+
+#include <iostream>
+
+#include <visp3/core/vpClient.h>
+#include <visp3/core/vpServer.h>
+#include <visp3/core/vpPoseVector.h>
+#include <visp3/core/vpThread.h>
+#include <visp3/core/vpTime.h>
+
+#define NB_FRAMES 200
+#define PORT 35001
+
+vpThread::Return clientFunction(vpThread::Args args)
+{
+  (void)(args); // Avoid warning: unused parameter args
+  vpClient client;
+  if(! client.connectToIP("127.0.0.1", PORT))
+    return 0;
+
+  vpImage<unsigned char> I(480, 640);
+  vpPoseVector cMo(0.1, 0.2, 0.5, 0.01, 0.02, 0.03);
+
+  for(unsigned int n=0; n<NB_FRAMES; n++){
+    I[0][0] = (unsigned char)n;
+    cMo[0] = n;
+    if(client.sendImageTo(I, 0) < 0 || client.sendArrayTo(cMo, 0) < 0){
+      std::cout << "Error while sending frame " << n << std::endl;
+      break;
+    }
+  }
+
+  // Wait for the server to acknowledge the reception before disconnecting
+  int ack;
+  client.setTimeoutSec(10);
+  client.receive(&ack);
+
+  return 0;
+}
+
+int main()
+{
+  try {
+    vpServer serv(PORT);
+    serv.setTimeoutSec(1);
+    if(! serv.start())
+      return 1;
+
+    vpThread client((vpThread::Fn)clientFunction);
+
+    while(serv.getNumberOfClients() == 0)
+      serv.checkForConnections();
+
+    vpImage<unsigned char> I;
+    vpPoseVector cMo;
+    serv.setTimeoutSec(5);
+
+    double t = vpTime::measureTimeMs();
+    unsigned int nbFrames = 0;
+    for( ; nbFrames<NB_FRAMES; nbFrames++){
+      if(serv.receiveImageFrom(I, 0) <= 0 || serv.receiveArrayFrom(cMo, 0) <= 0)
+        break;
+      if(I[0][0] != (unsigned char)nbFrames || cMo[0] != nbFrames){
+        std::cout << "Frame " << nbFrames << " corrupted" << std::endl;
+        break;
+      }
+    }
+    t = vpTime::measureTimeMs() - t;
+
+    int ack = 1;
+    serv.send(&ack);
+    client.join();
+
+    double size = (double)nbFrames * (I.getSize() + 6*sizeof(double)) / (1024.*1024.);
+    std::cout << "Received " << nbFrames << " VGA images and poses in " << t << " ms: "
+              << nbFrames * 1000. / t << " fps, " << size * 1000. / t << " MB/s" << std::endl;
+
+    return (nbFrames == NB_FRAMES) ? 0 : 1;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+}
+
+#else
+
+#include <iostream>
+
+int main()
+{
+  std::cout << "This benchmark requires pthread under Unix..." << std::endl;
+}
+#endif
@@ -0,0 +1,177 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test vpBinaryArchive.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testBinaryArchive.cpp
+
+  \brief Test saving and loading objects with vpBinaryArchive, and compare
+  the loading time with the text format of vpMatrix::loadMatrix().
+*/
+
+#include <iostream>
+#include <sstream>
+
+#include <visp3/core/vpBinaryArchive.h>
+#include <visp3/core/vpHomogeneousMatrix.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/core/vpMatrix.h>
+#include <visp3/core/vpTime.h>
+
+bool loadAndCheck(vpBinaryArchive &ar, const vpMatrix &M, const vpHomogeneousMatrix &cMo,
+                  const vpImage<unsigned char> &I, const vpImage<vpRGBa> &Ic, const vpCameraParameters &cam)
+{
+  vpMatrix M2;
+  vpHomogeneousMatrix cMo2;
+  vpImage<unsigned char> I2;
+  vpImage<vpRGBa> Ic2;
+  vpCameraParameters cam2;
+
+  ar >> M2 >> cMo2 >> I2 >> Ic2 >> cam2;
+
+  if (M2.getRows() != M.getRows() || M2.getCols() != M.getCols()) {
+    std::cerr << "Bad matrix size" << std::endl;
+    return false;
+  }
+  for (unsigned int i = 0; i < M.size(); i++) {
+    if (M2.data[i] != M.data[i]) {
+      std::cerr << "Bad matrix content" << std::endl;
+      return false;
+    }
+  }
+  for (unsigned int i = 0; i < 16; i++) {
+    if (cMo2.data[i] != cMo.data[i]) {
+      std::cerr << "Bad homogeneous matrix content" << std::endl;
+      return false;
+    }
+  }
+  if (I2.getHeight() != I.getHeight() || I2.getWidth() != I.getWidth() || ! (I2 == I)) {
+    std::cerr << "Bad image content" << std::endl;
+    return false;
+  }
+  if (Ic2.getHeight() != Ic.getHeight() || Ic2.getWidth() != Ic.getWidth() || ! (Ic2 == Ic)) {
+    std::cerr << "Bad color image content" << std::endl;
+    return false;
+  }
+  if (cam2.get_projModel() != cam.get_projModel() || cam2.get_px() != cam.get_px() || cam2.get_py() != cam.get_py()
+      || cam2.get_u0() != cam.get_u0() || cam2.get_v0() != cam.get_v0() || cam2.get_kud() != cam.get_kud()
+      || cam2.get_kdu() != cam.get_kdu()) {
+    std::cerr << "Bad camera parameters" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool testArchive(const std::string &filename, const std::string &textFilename)
+{
+  vpMatrix M(300, 200);
+  for (unsigned int i = 0; i < M.size(); i++)
+    M.data[i] = i / 7.;
+  vpHomogeneousMatrix cMo(0.1, -0.2, 0.5, 0.1, 0.2, M_PI / 3);
+  vpImage<unsigned char> I(480, 640);
+  for (unsigned int i = 0; i < I.getSize(); i++)
+    I.bitmap[i] = (unsigned char)i;
+  vpImage<vpRGBa> Ic(120, 160, vpRGBa(10, 20, 30, 40));
+  vpCameraParameters cam(600, 610, 320, 240, -0.1, 0.1);
+
+  {
+    vpBinaryArchive ar(filename, vpBinaryArchive::WRITE);
+    ar << M << cMo << I << Ic << cam;
+  }
+
+  // Read back the memory-mapped file
+  {
+    vpBinaryArchive ar(filename, vpBinaryArchive::READ);
+    if (! loadAndCheck(ar, M, cMo, I, Ic, cam))
+      return false;
+    std::cout << "Archive read from file: ok" << std::endl;
+  }
+
+  // Read back from a stream
+  {
+    std::ifstream file(filename.c_str(), std::ifstream::in | std::ifstream::binary);
+    vpBinaryArchive ar(file);
+    if (! loadAndCheck(ar, M, cMo, I, Ic, cam))
+      return false;
+    std::cout << "Archive read from stream: ok" << std::endl;
+  }
+
+  // Loading an unexpected object has to throw an exception
+  {
+    vpBinaryArchive ar(filename, vpBinaryArchive::READ);
+    vpImage<unsigned char> I2;
+    try {
+      ar >> I2;
+      std::cerr << "Loading an image from a matrix section should fail" << std::endl;
+      return false;
+    }
+    catch(vpException &) {
+    }
+  }
+
+  // Compare with the text format
+  vpMatrix::saveMatrix(textFilename, M);
+  double t = vpTime::measureTimeMs();
+  vpMatrix M2;
+  vpMatrix::loadMatrix(textFilename, M2);
+  double t_text = vpTime::measureTimeMs() - t;
+  t = vpTime::measureTimeMs();
+  {
+    vpBinaryArchive ar(filename, vpBinaryArchive::READ);
+    ar >> M2;
+  }
+  double t_archive = vpTime::measureTimeMs() - t;
+  std::cout << "Load a " << M.getRows() << "x" << M.getCols() << " matrix: " << t_text << " ms (text), "
+            << t_archive << " ms (binary archive)" << std::endl;
+
+  return true;
+}
+
+int main()
+{
+  std::string filename = vpIoTools::createFilePath(vpIoTools::getTempPath(), "testBinaryArchive.bin");
+  std::string textFilename = vpIoTools::createFilePath(vpIoTools::getTempPath(), "testBinaryArchive.mat");
+  bool ok = false;
+  try {
+    ok = testArchive(filename, textFilename);
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+  }
+
+  if (vpIoTools::checkFilename(filename))
+    vpIoTools::remove(filename);
+  if (vpIoTools::checkFilename(textFilename))
+    vpIoTools::remove(textFilename);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *
+ * Description:
+ * Test the directory and file helpers of vpIoTools used to read image sequences.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testFileSequence.cpp
+
+  \brief Test vpIoTools::getFileSequence(), vpIoTools::mapFile() and
+  vpIoTools::readAhead(), and compare the time needed to find the frames of a
+  sequence with the cached directory listing and with one test per file.
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <visp3/core/vpIoTools.h>
+#include <visp3/core/vpTime.h>
+
+int main()
+{
+  try {
+    std::string dirname = "testFileSequence-data";
+    if (vpIoTools::checkDirectory(dirname))
+      vpIoTools::remove(dirname);
+    vpIoTools::makeDirectory(dirname);
+
+    const long first = 3, last = 1002;
+    char name[FILENAME_MAX];
+    std::string genericName = vpIoTools::createFilePath(dirname, "image%04d.pgm");
+    for (long i = first; i <= last; i++) {
+      sprintf(name, genericName.c_str(), i);
+      std::ofstream file(name, std::ofstream::out | std::ofstream::binary);
+      file << "frame " << i;
+    }
+    // Files that do not belong to the sequence
+    std::ofstream(vpIoTools::createFilePath(dirname, "image12.pgm").c_str()) << "x";
+    std::ofstream(vpIoTools::createFilePath(dirname, "image0001.ppm").c_str()) << "x";
+    std::ofstream(vpIoTools::createFilePath(dirname, "image00a1.pgm").c_str()) << "x";
+
+    vpIoTools::clearFileSequenceCache();
+    double t = vpTime::measureTimeMs();
+    std::vector<long> numbers = vpIoTools::getFileSequence(genericName);
+    double t_list = vpTime::measureTimeMs() - t;
+
+    if (numbers.size() != (size_t)(last - first + 1) || numbers.front() != first || numbers.back() != last) {
+      std::cerr << "Bad sequence: found " << numbers.size() << " files" << std::endl;
+      return 1;
+    }
+    for (size_t i = 1; i < numbers.size(); i++) {
+      if (numbers[i] != numbers[i-1] + 1) {
+        std::cerr << "The sequence is not sorted" << std::endl;
+        return 1;
+      }
+    }
+
+    t = vpTime::measureTimeMs();
+    numbers = vpIoTools::getFileSequence(genericName);
+    double t_cached = vpTime::measureTimeMs() - t;
+
+    t = vpTime::measureTimeMs();
+    long image_number = first;
+    while (true) {
+      sprintf(name, genericName.c_str(), image_number);
+      if (! vpIoTools::checkFilename(name))
+        break;
+      image_number++;
+    }
+    double t_check = vpTime::measureTimeMs() - t;
+    if (image_number != last + 1) {
+      std::cerr << "Bad last image" << std::endl;
+      return 1;
+    }
+
+    std::cout << "Find " << numbers.size() << " frames: " << t_check << " ms with one test per file, "
+              << t_list << " ms with a directory listing, " << t_cached << " ms from the cache" << std::endl;
+
+    // A new file has to be seen
+    sprintf(name, genericName.c_str(), last + 1);
+    std::ofstream(name) << "frame " << last + 1;
+    numbers = vpIoTools::getFileSequence(genericName);
+    if (numbers.back() != last + 1) {
+      std::cerr << "The cache was not refreshed after adding a file" << std::endl;
+      return 1;
+    }
+
+    // Map a frame in memory
+    vpIoTools::readAhead(name);
+    const unsigned char *data;
+    size_t size;
+    if (! vpIoTools::mapFile(name, data, size)) {
+      std::cerr << "Cannot map " << name << std::endl;
+      return 1;
+    }
+    std::string content((const char *)data, size);
+    vpIoTools::unmapFile(data, size);
+    if (content != "frame 1003") {
+      std::cerr << "Bad mapped content: " << content << std::endl;
+      return 1;
+    }
+
+    std::vector<std::string> files = vpIoTools::getDirFiles(dirname);
+    if (files.size() != (size_t)(last - first + 2) + 3) {
+      std::cerr << "Bad number of files in " << dirname << ": " << files.size() << std::endl;
+      return 1;
+    }
+    vpIoTools::remove(dirname);
+
+    return 0;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,260 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *
+ * Description:
+ * Test the cache of parsed xml documents.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testXmlParserCache.cpp
+
+  \brief Test the cache of parsed documents of vpXmlParser, and compare the
+  time needed to load the same tracker and camera configurations many times
+  with and without the cache.
+
+  Additional configuration files (for example the ones bundled with the
+  tutorials) can be given on the command line to be part of the benchmark.
+*/
+
+#include <visp3/core/vpConfig.h>
+
+#include <iostream>
+
+#if defined(VISP_HAVE_XML2)
+
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <visp3/core/vpCameraParameters.h>
+#include <visp3/core/vpTime.h>
+#include <visp3/core/vpXmlParser.h>
+#include <visp3/core/vpXmlParserCamera.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+/*!
+  Generic parser that reads the content of all the leaf nodes, as the parsers
+  of the trackers do.
+*/
+class vpLeafDataParser: public vpXmlParser
+{
+public:
+  unsigned int m_nbLeaves;
+  double m_sum;
+
+  vpLeafDataParser() : vpXmlParser(), m_nbLeaves(0), m_sum(0.) {}
+
+protected:
+  virtual void readMainClass(xmlDocPtr doc, xmlNodePtr node)
+  {
+    for (xmlNodePtr dataNode = node->xmlChildrenNode; dataNode != NULL; dataNode = dataNode->next) {
+      if (dataNode->type != XML_ELEMENT_NODE)
+        continue;
+
+      bool leaf = true;
+      for (xmlNodePtr child = dataNode->xmlChildrenNode; child != NULL; child = child->next) {
+        if (child->type == XML_ELEMENT_NODE) {
+          leaf = false;
+          break;
+        }
+      }
+
+      if (leaf) {
+        if (dataNode->xmlChildrenNode != NULL) {
+          std::string value = xmlReadStringChild(doc, dataNode);
+          m_sum += atof(value.c_str());
+        }
+        m_nbLeaves ++;
+      }
+      else
+        readMainClass(doc, dataNode);
+    }
+  }
+  virtual void writeMainClass(xmlNodePtr /*node*/) {}
+};
+
+void writeTrackerConfig(const std::string &filename, int step)
+{
+  std::ofstream file(filename.c_str());
+  file << "<?xml version=\"1.0\"?>\n"
+          "<conf>\n"
+          "  <ecm>\n"
+          "    <mask>\n"
+          "      <size>5</size>\n"
+          "      <nb_mask>180</nb_mask>\n"
+          "    </mask>\n"
+          "    <range>\n"
+          "      <tracking>8</tracking>\n"
+          "    </range>\n"
+          "    <contrast>\n"
+          "      <edge_threshold>10000</edge_threshold>\n"
+          "      <mu1>0.5</mu1>\n"
+          "      <mu2>0.5</mu2>\n"
+          "    </contrast>\n"
+          "    <sample>\n"
+          "      <step>" << step << "</step>\n"
+          "    </sample>\n"
+          "  </ecm>\n"
+          "  <klt>\n"
+          "    <mask_border>5</mask_border>\n"
+          "    <max_features>300</max_features>\n"
+          "    <window_size>5</window_size>\n"
+          "    <quality>0.015</quality>\n"
+          "    <min_distance>8</min_distance>\n"
+          "    <harris>0.01</harris>\n"
+          "    <size_block>3</size_block>\n"
+          "    <pyramid_lvl>3</pyramid_lvl>\n"
+          "  </klt>\n"
+          "  <camera>\n"
+          "    <u0>325.66776</u0>\n"
+          "    <v0>243.69727</v0>\n"
+          "    <px>839.21470</px>\n"
+          "    <py>839.44555</py>\n"
+          "  </camera>\n"
+          "  <face>\n"
+          "    <angle_appear>70</angle_appear>\n"
+          "    <angle_disappear>80</angle_disappear>\n"
+          "    <near_clipping>0.1</near_clipping>\n"
+          "    <far_clipping>100</far_clipping>\n"
+          "    <fov_clipping>1</fov_clipping>\n"
+          "  </face>\n"
+          "</conf>\n";
+}
+
+double loadConfigs(const std::vector<std::string> &configs, const std::string &camera_file,
+                   unsigned int nbLoads, double &sum)
+{
+  double t = vpTime::measureTimeMs();
+  sum = 0.;
+  for (unsigned int n = 0; n < nbLoads; n++) {
+    for (size_t i = 0; i < configs.size(); i++) {
+      vpLeafDataParser parser;
+      parser.parse(configs[i]);
+      sum += parser.m_sum;
+    }
+    vpLeafDataParser parser;
+    parser.parse(camera_file);
+    sum += parser.m_sum;
+  }
+  return vpTime::measureTimeMs() - t;
+}
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+int main(int argc, const char **argv)
+{
+  try {
+    const unsigned int nbLoads = 500;
+    std::vector<std::string> configs;
+    configs.push_back("testXmlParserCache-tracker.xml");
+    // Extra configuration files may be given, other options are ignored
+    for (int i = 1; i < argc; i++)
+      if (argv[i][0] != '-')
+        configs.push_back(argv[i]);
+    std::string camera_file = "testXmlParserCache-camera.xml";
+
+    writeTrackerConfig(configs[0], 4);
+    remove(camera_file.c_str());
+    {
+      vpXmlParserCamera parser;
+      vpCameraParameters cam(600., 610., 320., 240., -0.1, 0.1);
+      parser.save(cam, camera_file, "Camera", 640, 480);
+    }
+
+    vpXmlParser::setCacheEnabled(false);
+    double sum_nocache;
+    double t_nocache = loadConfigs(configs, camera_file, nbLoads, sum_nocache);
+
+    vpXmlParser::setCacheEnabled(true);
+    double sum_cache;
+    double t_cache = loadConfigs(configs, camera_file, nbLoads, sum_cache);
+
+    std::cout << "Load " << nbLoads << " times " << configs.size() + 1 << " configuration files: "
+              << t_nocache << " ms without cache, " << t_cache << " ms with cache" << std::endl;
+
+    if (sum_nocache != sum_cache) {
+      std::cerr << "Cached documents do not give the same values" << std::endl;
+      return 1;
+    }
+    if (vpXmlParser::getCacheSize() != configs.size() + 1) {
+      std::cerr << "Unexpected cache size: " << vpXmlParser::getCacheSize() << std::endl;
+      return 1;
+    }
+
+    // Camera parameters read from a cached document
+    {
+      vpXmlParserCamera parser;
+      vpCameraParameters cam;
+      if (parser.parse(cam, camera_file, "Camera", vpCameraParameters::perspectiveProjWithDistortion)
+          != vpXmlParserCamera::SEQUENCE_OK || cam.get_px() != 600. || cam.get_kud() != -0.1) {
+        std::cerr << "Cannot read camera parameters from the cache" << std::endl;
+        return 1;
+      }
+    }
+
+    // A modified file has to be parsed again
+    {
+      vpLeafDataParser before, after, cached;
+      before.parse(configs[0]);
+      writeTrackerConfig(configs[0], 12345);
+      after.parse(configs[0]);
+      cached.parse(configs[0]);
+      if (std::fabs(after.m_sum - before.m_sum - (12345 - 4)) > 1e-6 || cached.m_sum != after.m_sum) {
+        std::cerr << "The cache was not refreshed after a modification of the file" << std::endl;
+        return 1;
+      }
+    }
+
+    vpXmlParser::cleanup();
+    if (vpXmlParser::getCacheSize() != 0) {
+      std::cerr << "The cache was not cleared" << std::endl;
+      return 1;
+    }
+
+    return 0;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+}
+
+#else
+int main()
+{
+  std::cout << "Xml parser requires libxml2." << std::endl;
+  return 0;
+}
+#endif
@@ -117,6 +117,8 @@ private:
   bool useGenericName;
   char genericName[FILENAME_MAX];
 
+  void readAhead(long number) const;
+
 public:
   vpDiskGrabber();
   vpDiskGrabber(const char *genericName);
@@ -45,6 +45,8 @@
 #include <visp3/core/vpImageConvert.h> //image  conversion
 #include <visp3/core/vpIoTools.h>
 
+#include <vector>
+
 const int vpImageIo::vpMAX_LEN = 100;
 
 /*!
@@ -1453,21 +1455,22 @@ vpImageIo::readPPM(vpImage<vpRGBa> &I, const char *filename)
     I.resize(h,w) ;
   }
 
+  // Read the pixels row by row rather than byte by byte
+  std::vector<unsigned char> row(3*I.getWidth());
   for(unsigned int i=0;i<I.getHeight();i++)
   {
+    if (row.size() > 0 && fread(&row[0], sizeof(unsigned char), row.size(), fd) != row.size())
+    {
+      fclose (fd);
+      throw (vpImageException(vpImageException::ioError,
+            "Cannot read bytes in file \"%s\"\n", filename));
+    }
+    vpRGBa *dst = I[i];
+    const unsigned char *src = row.empty() ? NULL : &row[0];
     for(unsigned int j=0;j<I.getWidth();j++)
     {
-      vpRGBa v ;
-      size_t res = fread(&v.R,sizeof(v.R),1,fd) ;
-      res |= fread(&v.G,sizeof(v.G),1,fd) ;
-      res |= fread(&v.B,sizeof(v.B),1,fd) ;
-      if (res==0)
-      {
-        fclose (fd);
-        throw (vpImageException(vpImageException::ioError,
-              "Cannot read bytes in file \"%s\"\n", filename));
-      }
-      I[i][j] = v ;
+      dst[j] = vpRGBa(src[0], src[1], src[2]) ;
+      src += 3;
     }
   }
 
@@ -36,6 +36,7 @@
  *****************************************************************************/
 
 
+#include <visp3/core/vpIoTools.h>
 #include <visp3/io/vpDiskGrabber.h>
 
 
@@ -180,6 +181,7 @@ vpDiskGrabber::acquire(vpImage<unsigned char> &I)
   vpDEBUG_TRACE(2, "load: %s\n", name);
 
   vpImageIo::read(I, name) ;
+  readAhead(image_number) ;
 
   width = I.getWidth();
   height = I.getHeight();
@@ -207,6 +209,7 @@ vpDiskGrabber::acquire(vpImage<vpRGBa> &I)
   vpDEBUG_TRACE(2, "load: %s\n", name);
 
   vpImageIo::read(I, name) ;
+  readAhead(image_number) ;
 
   width = I.getWidth();
   height = I.getHeight();
@@ -235,6 +238,7 @@ vpDiskGrabber::acquire(vpImage<float> &I)
   vpDEBUG_TRACE(2, "load: %s\n", name);
 
   vpImageIo::readPFM(I, name) ;
+  readAhead(image_number) ;
 
   width = I.getWidth();
   height = I.getHeight();
@@ -322,6 +326,25 @@ vpDiskGrabber::acquire(vpImage<float> &I, long img_number)
 
 }
 
+/*!
+  Ask the system to read in the background the image \e number, so that it is
+  already in memory when it is acquired.
+
+  \param number : The number of the next image to be read.
+ */
+void
+vpDiskGrabber::readAhead(long number) const
+{
+  char name[FILENAME_MAX] ;
+
+  if(useGenericName)
+    sprintf(name,genericName,number) ;
+  else
+    sprintf(name,"%s/%s%0*ld.%s",directory,base_name,number_of_zero,number,extension) ;
+
+  vpIoTools::readAhead(name) ;
+}
+
 /*!
   Not useful
 
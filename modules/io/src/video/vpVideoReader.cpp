@@ -42,11 +42,14 @@
 */
 
 #include <visp3/core/vpDebug.h>
+#include <visp3/core/vpIoTools.h>
 #include <visp3/io/vpVideoReader.h>
 
 #include <iostream>
 #include <fstream>
 #include <limits>   // numeric_limits
+#include <algorithm>
+#include <vector>
 
 /*!
 Basic constructor.
@@ -625,19 +628,30 @@ void vpVideoReader::findLastFrameIndex()
   
   if (imSequence != NULL) {
     if (! lastFrameIndexIsSet) {
-      char name[FILENAME_MAX];
       long image_number = firstFrame;
-      bool failed;
-      do {
-        std::fstream file;
-        sprintf(name,fileName,image_number) ;
-        file.open(name, std::ios::in);
-        failed = file.fail();
-        if (!failed) {
-          file.close();
+      // The sequence ends at the first missing image
+      std::vector<long> numbers = vpIoTools::getFileSequence(fileName);
+      if (! numbers.empty()) {
+        std::vector<long>::const_iterator it = std::lower_bound(numbers.begin(), numbers.end(), image_number);
+        while (it != numbers.end() && *it == image_number) {
+          ++ it;
           image_number++;
         }
-      } while(!failed);
+      }
+      else {
+        char name[FILENAME_MAX];
+        bool failed;
+        do {
+          std::fstream file;
+          sprintf(name,fileName,image_number) ;
+          file.open(name, std::ios::in);
+          failed = file.fail();
+          if (!failed) {
+            file.close();
+            image_number++;
+          }
+        } while(!failed);
+      }
       
       lastFrame = image_number -1;
     }
@@ -682,19 +696,26 @@ void
 	if (imSequence != NULL)
 	{
 		if (! firstFrameIndexIsSet) {
-			char name[FILENAME_MAX];
-			int image_number = 0;
-			bool failed;
-			do {
-				std::fstream file;
-				sprintf(name, fileName, image_number) ;
-				file.open(name, std::ios::in);
-				failed = file.fail();
-				if (!failed) file.close();
-				image_number++;
-			} while(failed);
-
-			firstFrame = image_number - 1;
+			std::vector<long> numbers = vpIoTools::getFileSequence(fileName);
+			std::vector<long>::const_iterator it = std::lower_bound(numbers.begin(), numbers.end(), 0L);
+			if (it != numbers.end()) {
+				firstFrame = *it;
+			}
+			else {
+				char name[FILENAME_MAX];
+				int image_number = 0;
+				bool failed;
+				do {
+					std::fstream file;
+					sprintf(name, fileName, image_number) ;
+					file.open(name, std::ios::in);
+					failed = file.fail();
+					if (!failed) file.close();
+					image_number++;
+				} while(failed);
+
+				firstFrame = image_number - 1;
+			}
 			imSequence->setImageNumber(firstFrame);
 		}
 	}
@@ -94,6 +94,12 @@
   Note that track() and searchDotsInArea() are the most important features
   of this class.
 
+  When many dots have to be tracked in each image, the run-length extraction
+  of the dots can be enabled with setRunLengthExtraction(). The dot is then
+  extracted as a set of horizontal runs of pixels having the right gray
+  levels, instead of following its border with the Freeman chain code, and
+  the moments are computed from the pixels of the runs.
+
   - track() estimate the current position of the dot using its previous
     position, then try to compute the new parameters of the dot. If everything
     went ok, tracking succeeds, otherwise we search this dot in a window
@@ -222,6 +228,14 @@ public:
 
   double getHeight() const;
   double getMaxSizeSearchDistancePrecision() const;
+  /*!
+    Return true if the dots are extracted as runs of pixels.
+
+    \sa setRunLengthExtraction()
+  */
+  inline bool getRunLengthExtraction() const {
+    return runLengthExtraction;
+  }
   /*!
   \return The mean gray level value of the dot.
   */
@@ -357,6 +371,7 @@ public:
   void setGrayLevelPrecision( const double & grayLevelPrecision );
   void setHeight( const double & height );
   void setMaxSizeSearchDistancePrecision(const double & maxSizeSearchDistancePrecision);
+  void setRunLengthExtraction(const bool activate);
   void setSizePrecision( const double & sizePrecision );
   void setWidth( const double & width );
 
@@ -450,6 +465,31 @@ private:
 			 const double &u = -1.0,
 			 const double &v = -1.0);
 
+  //! Horizontal run of pixels of a dot, from u_min to u_max on the row v
+  struct vpRun {
+    int v;
+    int u_min;
+    int u_max;
+  };
+
+  /*!
+    Check if the pixel of coordinates (u, v) has a gray level between the min
+    and max levels. Unlike hasGoodLevel() this test is not virtual and does
+    not check that the pixel is in the area.
+  */
+  inline bool isInLevel(const vpImage<unsigned char>& I,
+                        const unsigned int u, const unsigned int v) const {
+    return I[v][u] >= gray_level_min && I[v][u] <= gray_level_max;
+  }
+  bool computeRunLengthParameters(const vpImage<unsigned char> &I,
+                                  const unsigned int u, const unsigned int v);
+  bool computeRunLengthParameters(const vpImage<unsigned char> &I,
+                                  const std::vector<vpRun> &runs);
+  void searchDotsInAreaRunLength(const vpImage<unsigned char>& I,
+                                 int area_u, int area_v,
+                                 unsigned int area_w, unsigned int area_h,
+                                 std::list<vpDot2> &niceDots);
+
 
 
   bool findFirstBorder(const vpImage<unsigned char> &I, const unsigned int &u,
@@ -535,6 +575,7 @@ private:
 
   // flag
   bool compute_moment ; // true moment are computed
+  bool runLengthExtraction ; // true if the dot is extracted as runs of pixels
   bool graphics ; // true for graphic overlay display
 
   unsigned int thickness; // Graphics thickness
@@ -94,6 +94,7 @@ void vpDot2::init()
   firstBorder_v = 0;
 
   compute_moment = false ;
+  runLengthExtraction = false;
   graphics = false;
   thickness = 1;
 }
@@ -107,7 +108,7 @@ vpDot2::vpDot2()
     gray_level_min(128), gray_level_max(255), mean_gray_level(0), grayLevelPrecision(0.8), gamma(1.5),
     sizePrecision(0.65), ellipsoidShapePrecision(0.65), maxSizeSearchDistancePrecision(0.65),
     allowedBadPointsPercentage_(0.), area(), direction_list(), ip_edges_list(), compute_moment(false),
-    graphics(false), thickness(1), bbox_u_min(0), bbox_u_max(0), bbox_v_min(0), bbox_v_max(0),
+    runLengthExtraction(false), graphics(false), thickness(1), bbox_u_min(0), bbox_u_max(0), bbox_v_min(0), bbox_v_max(0),
     firstBorder_u(0), firstBorder_v()
 {
 }
@@ -126,7 +127,7 @@ vpDot2::vpDot2(const vpImagePoint &ip)
     gray_level_min(128), gray_level_max(255), mean_gray_level(0), grayLevelPrecision(0.8), gamma(1.5),
     sizePrecision(0.65), ellipsoidShapePrecision(0.65), maxSizeSearchDistancePrecision(0.65),
     allowedBadPointsPercentage_(0.), area(), direction_list(), ip_edges_list(), compute_moment(false),
-    graphics(false), thickness(1), bbox_u_min(0), bbox_u_max(0), bbox_v_min(0), bbox_v_max(0),
+    runLengthExtraction(false), graphics(false), thickness(1), bbox_u_min(0), bbox_u_max(0), bbox_v_min(0), bbox_v_max(0),
     firstBorder_u(0), firstBorder_v()
 {
   cog = ip;
@@ -142,7 +143,7 @@ vpDot2::vpDot2(const vpDot2& twinDot )
     gray_level_min(128), gray_level_max(255), mean_gray_level(0), grayLevelPrecision(0.8), gamma(1.5),
     sizePrecision(0.65), ellipsoidShapePrecision(0.65), maxSizeSearchDistancePrecision(0.65),
     allowedBadPointsPercentage_(0.), area(), direction_list(), ip_edges_list(), compute_moment(false),
-    graphics(false), thickness(1), bbox_u_min(0), bbox_u_max(0), bbox_v_min(0), bbox_v_max(0),
+    runLengthExtraction(false), graphics(false), thickness(1), bbox_u_min(0), bbox_u_max(0), bbox_v_min(0), bbox_v_max(0),
     firstBorder_u(0), firstBorder_v()
 {
   *this = twinDot;
@@ -173,6 +174,7 @@ vpDot2& vpDot2::operator=(const vpDot2& twinDot )
   ip_edges_list =  twinDot.ip_edges_list;
 
   compute_moment = twinDot.compute_moment;
+  runLengthExtraction = twinDot.runLengthExtraction;
   graphics = twinDot.graphics;
   thickness = twinDot.thickness;
 
@@ -901,6 +903,41 @@ void vpDot2::setMaxSizeSearchDistancePrecision( const double & precision )
   }
 }
 
+/*!
+
+  Activates the run-length extraction of the dot.
+
+  By default the dot is extracted by following its border with the Freeman
+  chain code, testing the gray level of the neighbours of each border pixel.
+  When the run-length extraction is activated:
+  - track() and initTracking() fill the dot from its previous center of
+    gravity row by row, as a set of horizontal runs of pixels having the
+    right gray levels.
+  - searchDotsInArea() scans each row of the area only once to get its runs,
+    merges the 8-connected runs of consecutive rows into dots and computes the
+    parameters of all the dots at once, instead of following the border of a
+    dot from each point of the search grid.
+
+  In this mode the moments are computed from the pixels of the dot, while
+  they are computed from the polygon joining the border pixels with the
+  Freeman chain code. The surface of a dot is thus its number of pixels. The
+  border of the dot given by getEdges() is made of the first and last pixels
+  of each row, and the Freeman chain given by getFreemanChain() is empty.
+
+  \warning The gray level of the pixels is directly compared to the min and
+  max levels (see setGrayLevelMin() and setGrayLevelMax()), without calling
+  hasGoodLevel(). This mode should thus not be used by a class that inherits
+  from vpDot2 to redefine the level test.
+
+  \param activate : true to extract the dot as runs of pixels, false to
+  follow its border with the Freeman chain code.
+
+*/
+void vpDot2::setRunLengthExtraction(const bool activate)
+{
+  runLengthExtraction = activate;
+}
+
 /*!
 
   Set the parameters of the area in which a dot is search to the image
@@ -1063,6 +1100,11 @@ void vpDot2::searchDotsInArea(const vpImage<unsigned char>& I,
     //vpDisplay::flush(I);
   }
 
+  if (runLengthExtraction) {
+    searchDotsInAreaRunLength(I, area_u, area_v, area_w, area_h, niceDots);
+    return;
+  }
+
 #ifdef DEBUG
   vpDisplay::displayRectangle(I, area, vpColor::blue);
   vpDisplay::flush(I);
@@ -1706,6 +1748,9 @@ bool vpDot2::computeParameters(const vpImage<unsigned char> &I,
     return false;
   }
 
+  if( runLengthExtraction )
+    return computeRunLengthParameters(I, (unsigned int) est_u, (unsigned int) est_v);
+
   bbox_u_min = (int)I.getWidth();
   bbox_u_max = 0;
   bbox_v_min = (int)I.getHeight();
@@ -1889,6 +1934,384 @@ bool vpDot2::computeParameters(const vpImage<unsigned char> &I,
 }
 
 
+/*!
+
+  Compute the parameters of the dot (center, width, height, surface, inertia
+  moments...) when the run-length extraction is activated, see
+  setRunLengthExtraction().
+
+  The dot is filled from the pixel (u, v), row by row: the run of pixels
+  having the right level that contains a seed is stored, then the pixels of
+  the rows above and below that are 8-connected to this run become new seeds.
+  When the size of the dot is known, the dot is only searched in a window
+  around (u, v) whose size is given by getMaxSizeSearchDistancePrecision(),
+  and it is rejected if it reaches the border of this window.
+
+  \param I : The image we are working with.
+  \param u : The column coordinate of a pixel inside the dot.
+  \param v : The row coordinate of a pixel inside the dot.
+
+  \return false : If a dot can't be found around pixel (u, v), true otherwise.
+
+  \sa computeParameters()
+*/
+bool vpDot2::computeRunLengthParameters(const vpImage<unsigned char> &I,
+                                        const unsigned int u, const unsigned int v)
+{
+  if( !isInLevel( I, u, v ) )
+  {
+    vpDEBUG_TRACE(3, "Can't find a dot from pixel (%d, %d) coordinates",
+                  (int) u, (int) v) ;
+    return false;
+  }
+
+  // Window in which the dot is searched
+  int u_min = (int) area.getLeft();
+  int u_max = (int) area.getRight();
+  int v_min = (int) area.getTop();
+  int v_max = (int) area.getBottom();
+  bool limited_u_min = false, limited_u_max = false;
+  bool limited_v_min = false, limited_v_max = false;
+  double epsilon = 0.001;
+  if( getWidth() > 0 && getHeight() > 0 ) {
+    int max_width  = (int) (getWidth()/(getMaxSizeSearchDistancePrecision()+epsilon)) + 1;
+    int max_height = (int) (getHeight()/(getMaxSizeSearchDistancePrecision()+epsilon)) + 1;
+    if( (int)u - max_width > u_min ) { u_min = (int)u - max_width; limited_u_min = true; }
+    if( (int)u + max_width < u_max ) { u_max = (int)u + max_width; limited_u_max = true; }
+    if( (int)v - max_height > v_min ) { v_min = (int)v - max_height; limited_v_min = true; }
+    if( (int)v + max_height < v_max ) { v_max = (int)v + max_height; limited_v_max = true; }
+  }
+
+  unsigned int window_w = (unsigned int) (u_max - u_min + 1);
+  unsigned int window_h = (unsigned int) (v_max - v_min + 1);
+  std::vector<unsigned char> visited(window_w * window_h, 0);
+  std::vector<vpRun> runs;
+  std::vector<vpRun> seeds;
+  vpRun seed;
+  seed.v = (int) v;
+  seed.u_min = seed.u_max = (int) u;
+  seeds.push_back(seed);
+
+  while( !seeds.empty() ) {
+    seed = seeds.back();
+    seeds.pop_back();
+    unsigned char *row_visited = &visited[(unsigned int)(seed.v - v_min) * window_w];
+    if( row_visited[seed.u_min - u_min] )
+      continue;
+
+    // Extend the seed to the run of pixels having the right level
+    vpRun run = seed;
+    while( run.u_min > u_min && isInLevel( I, (unsigned int)run.u_min - 1, (unsigned int)run.v ) )
+      run.u_min--;
+    while( run.u_max < u_max && isInLevel( I, (unsigned int)run.u_max + 1, (unsigned int)run.v ) )
+      run.u_max++;
+
+    // The dot is bigger than the window
+    if( (limited_u_min && run.u_min == u_min) || (limited_u_max && run.u_max == u_max)
+        || (limited_v_min && run.v == v_min) || (limited_v_max && run.v == v_max) ) {
+      vpDEBUG_TRACE(3, "The found dot (%d, %d) has a greater size than the required one", u, v);
+      return false;
+    }
+
+    for( int i = run.u_min; i <= run.u_max; i++ )
+      row_visited[i - u_min] = 1;
+    runs.push_back(run);
+
+    // The pixels of the previous and next rows connected to the run are new seeds
+    for( int next_v = run.v - 1; next_v <= run.v + 1; next_v += 2 ) {
+      if( next_v < v_min || next_v > v_max )
+        continue;
+      unsigned char *next_visited = &visited[(unsigned int)(next_v - v_min) * window_w];
+      int next_u_min = vpMath::maximum(run.u_min - 1, u_min);
+      int next_u_max = vpMath::minimum(run.u_max + 1, u_max);
+      bool in_run = false;
+      for( int i = next_u_min; i <= next_u_max; i++ ) {
+        if( !next_visited[i - u_min] && isInLevel( I, (unsigned int)i, (unsigned int)next_v ) ) {
+          if( !in_run ) {
+            seed.v = next_v;
+            seed.u_min = seed.u_max = i;
+            seeds.push_back(seed);
+            in_run = true;
+          }
+        }
+        else
+          in_run = false;
+      }
+    }
+  }
+
+  return computeRunLengthParameters(I, runs);
+}
+
+/*!
+
+  Compute the parameters of the dot (center, width, height, surface, inertia
+  moments...) from the runs of pixels of the dot.
+
+  The moments are the sums over the pixels of the dot, for instance \f$ m_{10}
+  = \sum u \f$. The border of the dot is made of the first pixel of each row
+  from top to bottom, then of the last pixel of each row from bottom to top.
+
+  \param I : The image we are working with.
+  \param runs : The runs of pixels of the dot, in any order.
+
+  \return false : If the dot has less than two pixels, true otherwise.
+*/
+bool vpDot2::computeRunLengthParameters(const vpImage<unsigned char> &I,
+                                        const std::vector<vpRun> &runs)
+{
+  direction_list.clear();
+  ip_edges_list.clear();
+
+  m00 = m10 = m01 = m11 = m20 = m02 = 0.0;
+  bbox_u_min = (int)I.getWidth();
+  bbox_u_max = 0;
+  bbox_v_min = (int)I.getHeight();
+  bbox_v_max = 0;
+
+  for( std::vector<vpRun>::const_iterator it = runs.begin(); it != runs.end(); ++it ) {
+    double n = it->u_max - it->u_min + 1;
+    double v = it->v;
+    // Sum of u and of u^2 over the run
+    double sum_u = 0.5 * n * (it->u_min + it->u_max);
+    m00 += n;
+    m10 += sum_u;
+    m01 += n * v;
+    if (compute_moment) {
+      double a = it->u_min - 1;
+      double b = it->u_max;
+      m11 += sum_u * v;
+      m20 += (b * (b + 1) * (2 * b + 1) - a * (a + 1) * (2 * a + 1)) / 6.0;
+      m02 += n * v * v;
+    }
+
+    if( it->v < bbox_v_min ) bbox_v_min = it->v;
+    if( it->v > bbox_v_max ) bbox_v_max = it->v;
+    if( it->u_min < bbox_u_min ) bbox_u_min = it->u_min;
+    if( it->u_max > bbox_u_max ) bbox_u_max = it->u_max;
+  }
+
+  // if the surface is one or zero , the center of gravity wasn't properly
+  // detected.
+  if( m00 < 2. )
+  {
+    vpDEBUG_TRACE(3, "The center of gravity of the dot wasn't properly detected");
+    return false;
+  }
+
+  double tmpCenter_u = m10 / m00;
+  double tmpCenter_v = m01 / m00;
+  if (compute_moment)
+  {
+    mu11 = m11 - tmpCenter_u*m01;
+    mu02 = m02 - tmpCenter_v*m01;
+    mu20 = m20 - tmpCenter_u*m10;
+  }
+  cog.set_u( tmpCenter_u );
+  cog.set_v( tmpCenter_v );
+
+  width   = bbox_u_max - bbox_u_min + 1;
+  height  = bbox_v_max - bbox_v_min + 1;
+  surface = m00;
+
+  // First and last pixels of each row
+  unsigned int nb_rows = (unsigned int) (bbox_v_max - bbox_v_min + 1);
+  std::vector<int> row_u_min(nb_rows, bbox_u_max);
+  std::vector<int> row_u_max(nb_rows, bbox_u_min);
+  for( std::vector<vpRun>::const_iterator it = runs.begin(); it != runs.end(); ++it ) {
+    unsigned int row = (unsigned int) (it->v - bbox_v_min);
+    if( it->u_min < row_u_min[row] ) row_u_min[row] = it->u_min;
+    if( it->u_max > row_u_max[row] ) row_u_max[row] = it->u_max;
+  }
+  vpImagePoint ip;
+  for( unsigned int row = 0; row < nb_rows; row++ ) {
+    ip.set_u( row_u_min[row] );
+    ip.set_v( bbox_v_min + (int) row );
+    ip_edges_list.push_back( ip );
+  }
+  for( unsigned int row = nb_rows; row-- > 0; ) {
+    ip.set_u( row_u_max[row] );
+    ip.set_v( bbox_v_min + (int) row );
+    ip_edges_list.push_back( ip );
+  }
+
+  // if it was asked, show the border
+  if (graphics) {
+    for( std::list<vpImagePoint>::const_iterator it = ip_edges_list.begin(); it != ip_edges_list.end(); ++it ) {
+      for(int t=0; t< (int)thickness; t++) {
+        ip.set_u ( it->get_u() + t );
+        ip.set_v ( it->get_v() );
+        vpDisplay::displayPoint(I, ip, vpColor::red) ;
+      }
+    }
+  }
+
+  computeMeanGrayLevel(I);
+  return true;
+}
+
+/*!
+  Return the root of the set containing the run \e i. The parent of a run is
+  never after the run.
+*/
+static unsigned int vpDot2FindRoot(std::vector<unsigned int> &parent, unsigned int i)
+{
+  while( parent[i] != i ) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+/*!
+
+  Look for the dots matching this dot parameters within a region of interest
+  when the run-length extraction is activated, see setRunLengthExtraction().
+
+  Each row of the area is scanned once to get its runs of pixels having the
+  right level. The runs are merged with the 8-connected runs of the previous
+  row in a union-find structure, so that each set of runs is a dot. The
+  parameters of each dot are then computed from its runs and the valid dots
+  are sorted by their distance to the center of the area, as done by
+  searchDotsInArea().
+
+  \param I : Image to process.
+  \param area_u : Coordinate (column) of the upper-left area corner.
+  \param area_v : Coordinate (row) of the upper-left area corner.
+  \param area_w : Width or the area in which a dot is searched.
+  \param area_h : Height or the area in which a dot is searched.
+  \param niceDots: List of the dots that are found.
+*/
+void vpDot2::searchDotsInAreaRunLength(const vpImage<unsigned char>& I,
+                                       int area_u, int area_v,
+                                       unsigned int area_w, unsigned int area_h,
+                                       std::list<vpDot2> &niceDots)
+{
+  int u_min = (int) area.getLeft();
+  int u_max = (int) area.getRight();
+  int v_min = (int) area.getTop();
+  int v_max = (int) area.getBottom();
+
+  // Runs of the area, row by row, and their union-find parent
+  std::vector<vpRun> runs;
+  std::vector<unsigned int> parent;
+  unsigned int previous_begin = 0;
+  unsigned int previous_end = 0;
+  for( int v = v_min; v <= v_max; v++ ) {
+    unsigned int current_begin = (unsigned int) runs.size();
+    int u = u_min;
+    while( u <= u_max ) {
+      if( !isInLevel( I, (unsigned int)u, (unsigned int)v ) ) {
+        u++;
+        continue;
+      }
+      vpRun run;
+      run.v = v;
+      run.u_min = u;
+      while( u < u_max && isInLevel( I, (unsigned int)u + 1, (unsigned int)v ) )
+        u++;
+      run.u_max = u;
+      u += 2;
+
+      unsigned int index = (unsigned int) runs.size();
+      runs.push_back(run);
+      parent.push_back(index);
+
+      // Merge with the 8-connected runs of the previous row
+      while( previous_begin < previous_end && runs[previous_begin].u_max < run.u_min - 1 )
+        previous_begin++;
+      for( unsigned int k = previous_begin; k < previous_end && runs[k].u_min <= run.u_max + 1; k++ ) {
+        unsigned int root1 = vpDot2FindRoot(parent, k);
+        unsigned int root2 = vpDot2FindRoot(parent, index);
+        if( root1 < root2 ) parent[root2] = root1;
+        else parent[root1] = root2;
+      }
+    }
+    previous_begin = current_begin;
+    previous_end = (unsigned int) runs.size();
+  }
+
+  // Group the runs of each dot, keeping their order
+  unsigned int nb_runs = (unsigned int) runs.size();
+  std::vector<unsigned int> label(nb_runs);
+  std::vector<unsigned int> first;
+  for( unsigned int i = 0; i < nb_runs; i++ ) {
+    // The parent of a run is already a root
+    parent[i] = parent[parent[i]];
+    if( parent[i] == i ) {
+      label[i] = (unsigned int) first.size();
+      first.push_back(0);
+    }
+    else
+      label[i] = label[parent[i]];
+    first[label[i]]++;
+  }
+  unsigned int nb_dots = (unsigned int) first.size();
+  unsigned int offset = 0;
+  for( unsigned int d = 0; d < nb_dots; d++ ) {
+    unsigned int nb = first[d];
+    first[d] = offset;
+    offset += nb;
+  }
+  first.push_back(offset);
+  std::vector<vpRun> sorted_runs(nb_runs);
+  std::vector<unsigned int> next(first.begin(), first.end() - 1);
+  for( unsigned int i = 0; i < nb_runs; i++ )
+    sorted_runs[next[label[i]]++] = runs[i];
+
+  // The center used here is not the area center but the center of the input
+  // area which may be partially outside the image.
+  double area_center_u = area_u + area_w/2.0 - 0.5;
+  double area_center_v = area_v + area_h/2.0 - 0.5;
+
+  vpDot2* dotToTest = getInstance();
+  dotToTest->setGrayLevelMin ( getGrayLevelMin() );
+  dotToTest->setGrayLevelMax ( getGrayLevelMax() );
+  dotToTest->setGrayLevelPrecision( getGrayLevelPrecision() );
+  dotToTest->setSizePrecision( getSizePrecision() );
+  dotToTest->setGraphics( graphics );
+  dotToTest->setGraphicsThickness( thickness );
+  dotToTest->setComputeMoments( true );
+  dotToTest->setRunLengthExtraction( true );
+  dotToTest->setArea( area );
+  dotToTest->setEllipsoidShapePrecision( ellipsoidShapePrecision );
+
+  std::vector<vpRun> dot_runs;
+  for( unsigned int d = 0; d < nb_dots; d++ ) {
+    dot_runs.assign(sorted_runs.begin() + first[d], sorted_runs.begin() + first[d+1]);
+    if( !dotToTest->computeRunLengthParameters( I, dot_runs ) )
+      continue;
+    if( !dotToTest->isValid( I, *this ) )
+      continue;
+
+    vpImagePoint cogDotToTest = dotToTest->getCog();
+    double thisDist = sqrt( vpMath::sqr(cogDotToTest.get_u() - area_center_u)
+                            + vpMath::sqr(cogDotToTest.get_v() - area_center_v) );
+
+    // Insert the dot before the first dot farther from the center, unless a
+    // dot with the same center was already found
+    bool found = false;
+    std::list<vpDot2>::iterator itnice = niceDots.begin();
+    while( itnice != niceDots.end() ) {
+      vpImagePoint cogTmpDot = itnice->getCog();
+      double epsilon = 3.0;
+      if( fabs( cogTmpDot.get_u() - cogDotToTest.get_u() ) < epsilon &&
+          fabs( cogTmpDot.get_v() - cogDotToTest.get_v() ) < epsilon ) {
+        found = true;
+        break;
+      }
+      double otherDist = sqrt( vpMath::sqr(cogTmpDot.get_u() - area_center_u)
+                               + vpMath::sqr(cogTmpDot.get_v() - area_center_v) );
+      if( otherDist > thisDist )
+        break;
+      ++itnice;
+    }
+    if( !found )
+      niceDots.insert( itnice, *dotToTest );
+  }
+  delete dotToTest;
+}
+
 /*!
   Find the starting point on a dot border from an other point in the dot.
   the dot border is computed from this point.
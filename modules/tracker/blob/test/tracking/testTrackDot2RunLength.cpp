@@ -0,0 +1,168 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Benchmark of the run-length extraction of the dots.
+ *
+ *****************************************************************************/
+/*!
+  \example testTrackDot2RunLength.cpp
+
+  \brief Track 64 moving dots in synthetic images with vpDot2, following
+  the dot borders with the Freeman chain code or extracting the dots as runs
+  of pixels, and compare the precision and the time of both modes.
+*/
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <list>
+#include <vector>
+
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpImagePoint.h>
+#include <visp3/core/vpMath.h>
+#include <visp3/core/vpTime.h>
+#include <visp3/core/vpTrackingException.h>
+#include <visp3/blob/vpDot2.h>
+
+namespace {
+const unsigned int nbDotsPerRow = 8;
+const unsigned int nbDotsPerColumn = 8;
+const unsigned int nbDots = nbDotsPerRow * nbDotsPerColumn;
+const unsigned int nbFrames = 50;
+
+// Center of the dot i at frame k
+vpImagePoint dotCenter(unsigned int i, unsigned int k)
+{
+  double u0 = 40 + 80 * (i % nbDotsPerRow);
+  double v0 = 30 + 60 * (i / nbDotsPerRow);
+  return vpImagePoint(v0 + 6 * sin(0.13 * k + i), u0 + 8 * cos(0.11 * k + 0.5 * i));
+}
+
+// Draw the dots, ellipses of different sizes, on a textured background
+void makeImage(vpImage<unsigned char> &I, unsigned int k)
+{
+  I.resize(480, 640);
+  for (unsigned int i = 0; i < I.getHeight(); i++)
+    for (unsigned int j = 0; j < I.getWidth(); j++)
+      I[i][j] = (unsigned char)vpMath::round(40 + 15 * sin(0.05 * i) * cos(0.07 * j));
+
+  for (unsigned int d = 0; d < nbDots; d++) {
+    vpImagePoint c = dotCenter(d, k);
+    double a = 8 + (d % 4), b = 7 + (d % 3);
+    for (int i = (int)(c.get_v() - b - 1); i <= (int)(c.get_v() + b + 1); i++) {
+      for (int j = (int)(c.get_u() - a - 1); j <= (int)(c.get_u() + a + 1); j++) {
+        if (vpMath::sqr((j - c.get_u()) / a) + vpMath::sqr((i - c.get_v()) / b) <= 1.)
+          I[(unsigned int)i][(unsigned int)j] = (unsigned char)(200 + 3 * (d % 10));
+      }
+    }
+  }
+}
+
+// Track the dots over the sequence, return false if a dot is lost or badly located
+bool trackDots(bool runLength, double &time, double &maxError)
+{
+  vpImage<unsigned char> I;
+  makeImage(I, 0);
+  std::vector<vpDot2> dots(nbDots);
+  for (unsigned int d = 0; d < nbDots; d++) {
+    dots[d].setRunLengthExtraction(runLength);
+    dots[d].setComputeMoments(true);
+    dots[d].initTracking(I, dotCenter(d, 0));
+  }
+
+  time = 0;
+  maxError = 0;
+  for (unsigned int k = 1; k <= nbFrames; k++) {
+    makeImage(I, k);
+    double t = vpTime::measureTimeMs();
+    try {
+      for (unsigned int d = 0; d < nbDots; d++)
+        dots[d].track(I);
+    }
+    catch(const vpTrackingException &e) {
+      std::cout << "Dot lost at frame " << k << ": " << e.getMessage() << std::endl;
+      return false;
+    }
+    time += vpTime::measureTimeMs() - t;
+
+    for (unsigned int d = 0; d < nbDots; d++) {
+      double error = vpImagePoint::distance(dots[d].getCog(), dotCenter(d, k));
+      if (error > maxError)
+        maxError = error;
+    }
+  }
+  time /= nbFrames;
+  return maxError < 0.5;
+}
+
+// Search all the dots in the first image
+bool searchDots(bool runLength, double &time)
+{
+  vpImage<unsigned char> I;
+  makeImage(I, 0);
+  vpDot2 dot;
+  dot.setRunLengthExtraction(runLength);
+  dot.initTracking(I, dotCenter(0, 0));
+  dot.setSizePrecision(0.4);
+
+  std::list<vpDot2> dots;
+  double t = vpTime::measureTimeMs();
+  dot.searchDotsInArea(I, dots);
+  time = vpTime::measureTimeMs() - t;
+
+  std::cout << "  " << dots.size() << " dots found in the image" << std::endl;
+  return dots.size() == nbDots;
+}
+}
+
+int main()
+{
+  const char *names[2] = { "Freeman chain", "Run-length" };
+  double trackTime[2], searchTime[2];
+  for (unsigned int mode = 0; mode < 2; mode++) {
+    std::cout << names[mode] << " extraction:" << std::endl;
+    double maxError;
+    if (! trackDots(mode == 1, trackTime[mode], maxError)) {
+      std::cout << "  Tracking failed, max error " << maxError << " pixel" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << "  Tracking of " << nbDots << " dots: " << trackTime[mode] << " ms per frame, max error "
+              << maxError << " pixel" << std::endl;
+    if (! searchDots(mode == 1, searchTime[mode])) {
+      std::cout << "  Search failed" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << "  Search in the image: " << searchTime[mode] << " ms" << std::endl;
+  }
+  std::cout << "Speed-up: tracking " << trackTime[0] / trackTime[1] << ", search "
+            << searchTime[0] / searchTime[1] << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,215 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * KLT (Kanade-Lucas-Tomasi) feature tracker working on ViSP images.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpKltNative.h
+
+  \brief KLT (Kanade-Lucas-Tomasi) feature tracker that does not depend
+  on OpenCV.
+*/
+
+#ifndef vpKltNative_h
+#define vpKltNative_h
+
+#include <vector>
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpColor.h>
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpImagePoint.h>
+#include <visp3/core/vpRect.h>
+
+/*!
+  \class vpKltNative
+
+  \ingroup module_klt
+
+  \brief KLT (Kanade-Lucas-Tomasi) feature tracker working directly on
+  vpImage.
+
+  This class is a replacement of vpKltOpencv that is always available. It
+  offers the same interface, the OpenCV points being replaced by
+  vpImagePoint and the cv::Mat images by vpImage<unsigned char>:
+
+  - initTracking() detects corners with the Harris response or the
+    minimal eigenvalue of the gradient matrix (Shi-Tomasi, see
+    setUseHarris()), keeps the strongest ones spaced by at least
+    getMinDistance() and refines them at the sub-pixel level;
+  - track() follows the features with a pyramidal inverse compositional
+    Lucas-Kanade; the gradient of the template window is computed once
+    per pyramid level. A feature is lost if it leaves the image, if its
+    window is not textured enough (see setMinEigThreshold()) or, when
+    setForwardBackwardThreshold() is used, if tracking it back to the
+    previous image does not bring it back to its previous position.
+
+  The parameters have the same meaning and default values as in
+  vpKltOpencv, so that both trackers can be configured the same way. When
+  OpenMP is available, the features are tracked in parallel.
+
+  \code
+#include <visp3/klt/vpKltNative.h>
+
+int main()
+{
+  vpImage<unsigned char> I;
+  vpKltNative tracker;
+  tracker.setMaxFeatures(200);
+  tracker.setWindowSize(10);
+  tracker.setQuality(0.01);
+  tracker.setMinDistance(15);
+  tracker.setPyramidLevels(3);
+
+  // acquire I
+  tracker.initTracking(I);
+  for(;;) {
+    // acquire I
+    tracker.track(I);
+    for(int i = 0; i < tracker.getNbFeatures(); i++) {
+      int id;
+      float x, y;
+      tracker.getFeature(i, id, x, y);
+    }
+  }
+}
+  \endcode
+*/
+class VISP_EXPORT vpKltNative
+{
+public:
+  vpKltNative();
+  virtual ~vpKltNative();
+
+  void addFeature(const float &x, const float &y);
+  void addFeature(const long &id, const float &x, const float &y);
+  void addFeature(const vpImagePoint &f);
+
+  void detectNewFeatures(const vpRect &roi, const int maxCount, std::vector<vpImagePoint> &features) const;
+
+  void display(const vpImage<unsigned char> &I,
+               const vpColor &color = vpColor::red, unsigned int thickness=1);
+  static void display(const vpImage<unsigned char> &I, const std::vector<vpImagePoint> &features,
+                      const vpColor &color = vpColor::green, unsigned int thickness=1);
+  static void display(const vpImage<vpRGBa> &I, const std::vector<vpImagePoint> &features,
+                      const vpColor &color = vpColor::green, unsigned int thickness=1);
+  static void display(const vpImage<unsigned char> &I, const std::vector<vpImagePoint> &features,
+                      const std::vector<long> &featuresid,
+                      const vpColor &color = vpColor::green, unsigned int thickness=1);
+  static void display(const vpImage<vpRGBa> &I, const std::vector<vpImagePoint> &features,
+                      const std::vector<long> &featuresid,
+                      const vpColor &color = vpColor::green, unsigned int thickness=1);
+
+  //! Get the size of the averaging block used to detect the features.
+  int getBlockSize() const {return m_blockSize;}
+  void getFeature(const int &index, int &id, float &x, float &y) const;
+  //! Get the list of current features.
+  std::vector<vpImagePoint> getFeatures() const {return m_points[1];}
+  //! Get the unique id of each feature.
+  std::vector<long> getFeaturesId() const {return m_points_id;}
+  //! Get the maximal distance in pixel allowed by the forward-backward check.
+  double getForwardBackwardThreshold() const {return m_fbThreshold;}
+  //! Get the free parameter of the Harris detector.
+  double getHarrisFreeParameter() const {return m_harris_k;}
+  //! Get the maximum number of features to track in the image.
+  int getMaxFeatures() const {return m_maxCount;}
+  //! Get the minimal Euclidean distance between detected corners during initialization.
+  double getMinDistance() const {return m_minDistance;}
+  //! Get the minimal eigen value threshold used to reject a point during the tracking.
+  double getMinEigThreshold() const {return m_minEigThreshold;}
+  //! Get the number of current features
+  int getNbFeatures() const { return (int)m_points[1].size(); }
+  //! Get the number of previous features.
+  int getNbPrevFeatures() const { return (int)m_points[0].size(); }
+  //! Get the list of previous features
+  std::vector<vpImagePoint> getPrevFeatures() const {return m_points[0];}
+  //! Get the maximal pyramid level.
+  int getPyramidLevels() const {return m_pyrMaxLevel;}
+  //! Get the parameter characterizing the minimal accepted quality of image corners.
+  double getQuality() const {return m_qualityLevel;}
+  //! Get the window size used to track and refine the features.
+  int getWindowSize() const {return m_winSize;}
+
+  void initTracking(const vpImage<unsigned char> &I);
+  void initTracking(const vpImage<unsigned char> &I, const vpImage<unsigned char> &mask);
+  void initTracking(const vpImage<unsigned char> &I, const std::vector<vpImagePoint> &pts);
+  void initTracking(const vpImage<unsigned char> &I, const std::vector<vpImagePoint> &pts, const std::vector<long> &ids);
+
+  void track(const vpImage<unsigned char> &I);
+  void setBlockSize(const int blockSize);
+  void setForwardBackwardThreshold(const double threshold);
+  void setHarrisFreeParameter(double harris_k);
+  void setInitialGuess(const std::vector<vpImagePoint> &guess_pts);
+  void setInitialGuess(const std::vector<vpImagePoint> &init_pts, const std::vector<vpImagePoint> &guess_pts, const std::vector<long> &fid);
+  void setMaxFeatures(const int maxCount);
+  void setMinDistance(double minDistance);
+  void setMinEigThreshold(double minEigThreshold);
+  void setPyramidLevels(const int pyrMaxLevel);
+  void setQuality(double qualityLevel);
+  //! Does nothing. Just here for compat with vpKltOpencv.
+  void setTrackerId(int tid) {(void)tid;}
+  void setUseHarris(const int useHarrisDetector);
+  void setWindowSize(const int winSize);
+  void suppressFeature(const int &index);
+
+protected:
+  void buildPyramid(const vpImage<unsigned char> &I);
+  void detectFeatures(const unsigned int top, const unsigned int left, const unsigned int bottom, const unsigned int right,
+                      const vpImage<unsigned char> *mask, const size_t maxCount, std::vector<vpImagePoint> &points) const;
+  void refineFeatures(std::vector<vpImagePoint> &points, const size_t first) const;
+  bool trackFeature(const std::vector<vpImage<float> > &pyrPrev, const std::vector<vpImage<float> > &gradXPrev,
+                    const std::vector<vpImage<float> > &gradYPrev, const std::vector<vpImage<float> > &pyrCur,
+                    const vpImagePoint &prevPt, vpImagePoint &nextPt, const bool useGuess,
+                    std::vector<float> &buffer) const;
+
+  std::vector<vpImage<float> > m_pyr[2];   //!< Pyramid of the previous [0] and current [1] image
+  std::vector<vpImage<float> > m_gradX[2]; //!< Horizontal gradient of the pyramids
+  std::vector<vpImage<float> > m_gradY[2]; //!< Vertical gradient of the pyramids
+  std::vector<vpImagePoint> m_points[2];   //!< Previous [0] and current [1] keypoint location
+  std::vector<long> m_points_id;           //!< Keypoint id
+  int m_maxCount;
+  int m_maxIter;
+  double m_epsilon;
+  int m_winSize;
+  double m_qualityLevel;
+  double m_minDistance;
+  double m_minEigThreshold;
+  double m_harris_k;
+  int m_blockSize;
+  int m_useHarrisDetector;
+  int m_pyrMaxLevel;
+  double m_fbThreshold;
+  long m_next_points_id;
+  bool m_initial_guess;
+};
+
+#endif
@@ -83,6 +83,8 @@ public:
   void addFeature(const long &id, const float &x, const float &y);
   void addFeature(const cv::Point2f &f);
 
+  void detectNewFeatures(const cv::Rect &roi, const int maxCount, std::vector<cv::Point2f> &features) const;
+
   void display(const vpImage<unsigned char> &I,
                const vpColor &color = vpColor::red, unsigned int thickness=1);
   static void display(const vpImage<unsigned char> &I, const std::vector<cv::Point2f> &features,
@@ -0,0 +1,1239 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * KLT (Kanade-Lucas-Tomasi) feature tracker working on ViSP images.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpKltNative.cpp
+
+  \brief KLT (Kanade-Lucas-Tomasi) feature tracker that does not depend
+  on OpenCV.
+*/
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include <visp3/core/vpDisplay.h>
+#include <visp3/core/vpMath.h>
+#include <visp3/core/vpTrackingException.h>
+#include <visp3/klt/vpKltNative.h>
+
+#ifdef VISP_HAVE_OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+//! Candidate corner for the detection.
+struct vpKltCorner
+{
+  float value;
+  unsigned int i;
+  unsigned int j;
+};
+
+//! Strongest corners first, scan order for equal responses.
+bool cornerGreater(const vpKltCorner &a, const vpKltCorner &b)
+{
+  if(a.value != b.value)
+    return a.value > b.value;
+  if(a.i != b.i)
+    return a.i < b.i;
+  return a.j < b.j;
+}
+
+inline int clampIndex(const int k, const int size)
+{
+  return k < 0 ? 0 : (k >= size ? size - 1 : k);
+}
+
+/*
+  Sample a win x win window of I with a bilinear interpolation, the top left
+  corner of the window being at (u,v). As the window is translated, the four
+  interpolation weights are the same for all the pixels and the rows are read
+  contiguously.
+*/
+void sampleWindow(const vpImage<float> &I, const double u, const double v, const int win, float *out)
+{
+  const int width = (int)I.getWidth();
+  const int height = (int)I.getHeight();
+  const int u0 = (int)floor(u);
+  const int v0 = (int)floor(v);
+  const float au = (float)(u - u0);
+  const float av = (float)(v - v0);
+  const float w00 = (1.f - au) * (1.f - av);
+  const float w01 = au * (1.f - av);
+  const float w10 = (1.f - au) * av;
+  const float w11 = au * av;
+
+  if(u0 >= 0 && v0 >= 0 && u0 + win < width && v0 + win < height) {
+    for(int r = 0; r < win; r++) {
+      const float *row0 = I[v0 + r] + u0;
+      const float *row1 = I[v0 + r + 1] + u0;
+      float *dst = out + r*win;
+      for(int c = 0; c < win; c++)
+        dst[c] = w00*row0[c] + w01*row0[c+1] + w10*row1[c] + w11*row1[c+1];
+    }
+  }
+  else {
+    // window crossing the border of the image: replicate the border
+    for(int r = 0; r < win; r++) {
+      const float *row0 = I[clampIndex(v0 + r, height)];
+      const float *row1 = I[clampIndex(v0 + r + 1, height)];
+      float *dst = out + r*win;
+      for(int c = 0; c < win; c++) {
+        const int c0 = clampIndex(u0 + c, width);
+        const int c1 = clampIndex(u0 + c + 1, width);
+        dst[c] = w00*row0[c0] + w01*row0[c1] + w10*row1[c0] + w11*row1[c1];
+      }
+    }
+  }
+}
+
+/*
+  Half size image smoothed with the [1 4 6 4 1]/16 gaussian kernel.
+*/
+void pyrDown(const vpImage<float> &src, vpImage<float> &dst, std::vector<float> &tmp)
+{
+  const int width = (int)src.getWidth();
+  const int height = (int)src.getHeight();
+  const int dwidth = (width + 1) / 2;
+  const int dheight = (height + 1) / 2;
+  dst.resize((unsigned int)dheight, (unsigned int)dwidth);
+  tmp.resize((size_t)dwidth * 5);
+
+  for(int i = 0; i < dheight; i++) {
+    // horizontal filtering of the 5 source rows used by the destination row
+    for(int k = 0; k < 5; k++) {
+      const float *s = src[clampIndex(2*i + k - 2, height)];
+      float *t = &tmp[(size_t)(k*dwidth)];
+      for(int j = 0; j < dwidth; j++) {
+        const int c = 2*j;
+        if(c >= 2 && c + 2 < width)
+          t[j] = s[c-2] + 4.f*(s[c-1] + s[c+1]) + 6.f*s[c] + s[c+2];
+        else
+          t[j] = s[clampIndex(c-2, width)] + 4.f*(s[clampIndex(c-1, width)] + s[clampIndex(c+1, width)])
+              + 6.f*s[c] + s[clampIndex(c+2, width)];
+      }
+    }
+    const float *t0 = &tmp[0];
+    const float *t1 = t0 + dwidth;
+    const float *t2 = t1 + dwidth;
+    const float *t3 = t2 + dwidth;
+    const float *t4 = t3 + dwidth;
+    float *d = dst[i];
+    for(int j = 0; j < dwidth; j++)
+      d[j] = (t0[j] + 4.f*(t1[j] + t3[j]) + 6.f*t2[j] + t4[j]) * (1.f/256.f);
+  }
+}
+
+/*
+  Scharr derivatives of I, normalized to get a gradient in grey level by
+  pixel.
+*/
+void scharr(const vpImage<float> &I, vpImage<float> &gx, vpImage<float> &gy)
+{
+  const int width = (int)I.getWidth();
+  const int height = (int)I.getHeight();
+  gx.resize((unsigned int)height, (unsigned int)width);
+  gy.resize((unsigned int)height, (unsigned int)width);
+
+  for(int i = 0; i < height; i++) {
+    const float *rm = I[clampIndex(i-1, height)];
+    const float *r0 = I[i];
+    const float *rp = I[clampIndex(i+1, height)];
+    float *dx = gx[i];
+    float *dy = gy[i];
+    for(int j = 1; j < width - 1; j++) {
+      dx[j] = (3.f*(rm[j+1] - rm[j-1] + rp[j+1] - rp[j-1]) + 10.f*(r0[j+1] - r0[j-1])) * (1.f/32.f);
+      dy[j] = (3.f*(rp[j-1] - rm[j-1] + rp[j+1] - rm[j+1]) + 10.f*(rp[j] - rm[j])) * (1.f/32.f);
+    }
+    const int borders[2] = {0, width - 1};
+    for(int k = 0; k < 2; k++) {
+      const int j = borders[k];
+      const int jm = clampIndex(j-1, width);
+      const int jp = clampIndex(j+1, width);
+      dx[j] = (3.f*(rm[jp] - rm[jm] + rp[jp] - rp[jm]) + 10.f*(r0[jp] - r0[jm])) * (1.f/32.f);
+      dy[j] = (3.f*(rp[jm] - rm[jm] + rp[jp] - rm[jp]) + 10.f*(rp[j] - rm[j])) * (1.f/32.f);
+    }
+  }
+}
+
+/*
+  Sum of the values of I over a block x block window centered on each pixel.
+*/
+void boxFilter(const vpImage<float> &I, const int block, vpImage<float> &dst, std::vector<float> &tmp)
+{
+  const int width = (int)I.getWidth();
+  const int height = (int)I.getHeight();
+  const int half = block / 2;
+  dst.resize((unsigned int)height, (unsigned int)width);
+  tmp.resize((size_t)width);
+
+  for(int i = 0; i < height; i++) {
+    std::fill(tmp.begin(), tmp.end(), 0.f);
+    for(int k = -half; k < block - half; k++) {
+      const float *s = I[clampIndex(i + k, height)];
+      for(int j = 0; j < width; j++)
+        tmp[(size_t)j] += s[j];
+    }
+    float *d = dst[i];
+    for(int j = 0; j < width; j++) {
+      float sum = 0.f;
+      for(int k = -half; k < block - half; k++)
+        sum += tmp[(size_t)clampIndex(j + k, width)];
+      d[j] = sum;
+    }
+  }
+}
+}
+
+/*!
+  Default constructor.
+ */
+vpKltNative::vpKltNative()
+  : m_points_id(), m_maxCount(500), m_maxIter(20), m_epsilon(0.03), m_winSize(10), m_qualityLevel(0.01),
+    m_minDistance(15), m_minEigThreshold(1e-4), m_harris_k(0.04), m_blockSize(3), m_useHarrisDetector(1), m_pyrMaxLevel(3),
+    m_fbThreshold(-1), m_next_points_id(0), m_initial_guess(false)
+{
+}
+
+vpKltNative::~vpKltNative()
+{
+}
+
+/*!
+  Compute the pyramid of the image and the gradient of each level. The result
+  is stored as the current image.
+*/
+void vpKltNative::buildPyramid(const vpImage<unsigned char> &I)
+{
+  int nbLevels = 1;
+  unsigned int width = I.getWidth(), height = I.getHeight();
+  while(nbLevels <= m_pyrMaxLevel) {
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+    if(width < (unsigned int)m_winSize + 2 || height < (unsigned int)m_winSize + 2)
+      break;
+    nbLevels++;
+  }
+
+  m_pyr[1].resize((size_t)nbLevels);
+  m_gradX[1].resize((size_t)nbLevels);
+  m_gradY[1].resize((size_t)nbLevels);
+
+  vpImage<float> &I0 = m_pyr[1][0];
+  I0.resize(I.getHeight(), I.getWidth());
+  const unsigned char *src = I.bitmap;
+  float *dst = I0.bitmap;
+  for(unsigned int k = 0; k < I.getSize(); k++)
+    dst[k] = (float)src[k];
+
+  std::vector<float> tmp;
+  for(int l = 1; l < nbLevels; l++)
+    pyrDown(m_pyr[1][(size_t)(l-1)], m_pyr[1][(size_t)l], tmp);
+
+  for(int l = 0; l < nbLevels; l++)
+    scharr(m_pyr[1][(size_t)l], m_gradX[1][(size_t)l], m_gradY[1][(size_t)l]);
+}
+
+/*!
+  Detect the corners of the current image in the area [top, bottom[ x [left,
+  right[. The corner response is computed from the gradient matrix averaged on
+  a getBlockSize() window. Only the local maxima with a response larger than
+  getQuality() times the best one of the area are kept, the strongest first,
+  and a corner closer than getMinDistance() to a point of \e points or to an
+  already selected corner is discarded.
+
+  \param top, left, bottom, right : Area of the image where the corners are
+  searched.
+  \param mask : If not NULL, only the pixels with a non null value in the
+  mask are considered.
+  \param maxCount : Maximal number of corners to add.
+  \param points : Points to keep away from. The new corners are appended.
+*/
+void vpKltNative::detectFeatures(const unsigned int top, const unsigned int left, const unsigned int bottom,
+                                 const unsigned int right, const vpImage<unsigned char> *mask, const size_t maxCount,
+                                 std::vector<vpImagePoint> &points) const
+{
+  const vpImage<float> &gx = m_gradX[1][0];
+  const vpImage<float> &gy = m_gradY[1][0];
+  const int width = (int)gx.getWidth();
+  const int height = (int)gx.getHeight();
+  if(top >= bottom || left >= right || maxCount == 0)
+    return;
+
+  // The local maxima test needs the response around the area, which needs
+  // the gradient products on the averaging block around it
+  const int margin = 1 + std::max(m_blockSize / 2, m_blockSize - m_blockSize / 2 - 1);
+  const int gTop = std::max((int)top - margin, 0);
+  const int gLeft = std::max((int)left - margin, 0);
+  const int gBottom = std::min((int)bottom + margin, height);
+  const int gRight = std::min((int)right + margin, width);
+  const unsigned int gHeight = (unsigned int)(gBottom - gTop);
+  const unsigned int gWidth = (unsigned int)(gRight - gLeft);
+
+  vpImage<float> xx(gHeight, gWidth), xy(gHeight, gWidth), yy(gHeight, gWidth);
+  for(unsigned int r = 0; r < gHeight; r++) {
+    const float *dx = gx[gTop + (int)r] + gLeft;
+    const float *dy = gy[gTop + (int)r] + gLeft;
+    float *pxx = xx[r], *pxy = xy[r], *pyy = yy[r];
+    for(unsigned int c = 0; c < gWidth; c++) {
+      pxx[c] = dx[c] * dx[c];
+      pxy[c] = dx[c] * dy[c];
+      pyy[c] = dy[c] * dy[c];
+    }
+  }
+
+  vpImage<float> sxx, sxy, syy;
+  std::vector<float> tmp;
+  boxFilter(xx, m_blockSize, sxx, tmp);
+  boxFilter(xy, m_blockSize, sxy, tmp);
+  boxFilter(yy, m_blockSize, syy, tmp);
+
+  // response in image coordinates i, j at response[i - gTop][j - gLeft]
+  vpImage<float> response(gHeight, gWidth, 0.f);
+  float maxValue = 0.f;
+  const int rTop = std::max((int)top - 1, 0), rBottom = std::min((int)bottom + 1, height);
+  const int rLeft = std::max((int)left - 1, 0), rRight = std::min((int)right + 1, width);
+  for(int i = rTop; i < rBottom; i++) {
+    const unsigned int r = (unsigned int)(i - gTop);
+    const bool inside = (i >= (int)top && i < (int)bottom);
+    for(int j = rLeft; j < rRight; j++) {
+      const unsigned int c = (unsigned int)(j - gLeft);
+      const float a = sxx[r][c], b = sxy[r][c], d = syy[r][c];
+      float value;
+      if(m_useHarrisDetector)
+        value = a*d - b*b - (float)m_harris_k * (a + d)*(a + d);
+      else
+        value = 0.5f * ((a + d) - sqrtf((a - d)*(a - d) + 4.f*b*b));
+      response[r][c] = value;
+      if(inside && j >= (int)left && j < (int)right && (mask == NULL || (*mask)[(unsigned int)i][(unsigned int)j])
+         && value > maxValue)
+        maxValue = value;
+    }
+  }
+
+  // local maxima above the quality threshold
+  const float threshold = (float)(m_qualityLevel * maxValue);
+  std::vector<vpKltCorner> corners;
+  const int iEnd = std::min((int)bottom, height - 1);
+  const int jEnd = std::min((int)right, width - 1);
+  for(int i = std::max((int)top, 1); i < iEnd; i++) {
+    const unsigned int r = (unsigned int)(i - gTop);
+    for(int j = std::max((int)left, 1); j < jEnd; j++) {
+      const unsigned int c = (unsigned int)(j - gLeft);
+      const float value = response[r][c];
+      if(value <= threshold || value <= 0.f || (mask != NULL && (*mask)[(unsigned int)i][(unsigned int)j] == 0))
+        continue;
+
+      bool isMax = true;
+      for(unsigned int rr = r-1; rr <= r+1 && isMax; rr++)
+        for(unsigned int cc = c-1; cc <= c+1; cc++)
+          if(response[rr][cc] > value) {
+            isMax = false;
+            break;
+          }
+
+      if(isMax) {
+        vpKltCorner corner;
+        corner.value = value;
+        corner.i = (unsigned int)i;
+        corner.j = (unsigned int)j;
+        corners.push_back(corner);
+      }
+    }
+  }
+  std::sort(corners.begin(), corners.end(), cornerGreater);
+
+  // keep the strongest corners that are far enough from the points and from
+  // each other
+  const size_t first = points.size();
+  if(m_minDistance >= 1) {
+    // grid over the area and a band of one cell around it, the points further
+    // away cannot be closer than getMinDistance() to a corner
+    const int cellSize = (int)ceil(m_minDistance);
+    const int oTop = std::max((int)top - cellSize, 0);
+    const int oLeft = std::max((int)left - cellSize, 0);
+    const int oBottom = std::min((int)bottom + cellSize, height);
+    const int oRight = std::min((int)right + cellSize, width);
+    const int gridWidth = (oRight - oLeft + cellSize - 1) / cellSize;
+    const int gridHeight = (oBottom - oTop + cellSize - 1) / cellSize;
+    std::vector<std::vector<size_t> > grid((size_t)(gridWidth * gridHeight));
+    const double minDist2 = m_minDistance * m_minDistance;
+
+    for(size_t k = 0; k < first; k++) {
+      const int ci = (int)floor(points[k].get_i()) - oTop;
+      const int cj = (int)floor(points[k].get_j()) - oLeft;
+      if(ci >= 0 && cj >= 0 && ci < oBottom - oTop && cj < oRight - oLeft)
+        grid[(size_t)((ci / cellSize)*gridWidth + cj / cellSize)].push_back(k);
+    }
+
+    for(size_t k = 0; k < corners.size() && points.size() - first < maxCount; k++) {
+      const int ci = ((int)corners[k].i - oTop) / cellSize;
+      const int cj = ((int)corners[k].j - oLeft) / cellSize;
+      bool good = true;
+      for(int gi = std::max(ci - 1, 0); gi <= std::min(ci + 1, gridHeight - 1) && good; gi++) {
+        for(int gj = std::max(cj - 1, 0); gj <= std::min(cj + 1, gridWidth - 1) && good; gj++) {
+          const std::vector<size_t> &cell = grid[(size_t)(gi*gridWidth + gj)];
+          for(size_t n = 0; n < cell.size(); n++) {
+            const double di = points[cell[n]].get_i() - (double)corners[k].i;
+            const double dj = points[cell[n]].get_j() - (double)corners[k].j;
+            if(di*di + dj*dj < minDist2) {
+              good = false;
+              break;
+            }
+          }
+        }
+      }
+
+      if(good) {
+        grid[(size_t)(ci*gridWidth + cj)].push_back(points.size());
+        points.push_back(vpImagePoint(corners[k].i, corners[k].j));
+      }
+    }
+  }
+  else {
+    for(size_t k = 0; k < corners.size() && k < maxCount; k++)
+      points.push_back(vpImagePoint(corners[k].i, corners[k].j));
+  }
+}
+
+/*!
+  Refine the position of features at the sub-pixel level in the current
+  image. The corner is moved to the point where the gradients of its
+  neighbours, weighted by a gaussian, are orthogonal to the direction to this
+  point. A feature that moves more than getWindowSize() pixels keeps its
+  initial position.
+
+  \param points : Features to refine.
+  \param first : Index of the first feature to refine.
+*/
+void vpKltNative::refineFeatures(std::vector<vpImagePoint> &points, const size_t first) const
+{
+  const vpImage<float> &I = m_pyr[1][0];
+  const int win = m_winSize;
+  const int size = 2*win + 1;
+  const int sampled = size + 2;
+  const double eps2 = m_epsilon * m_epsilon;
+  const double width = (double)I.getWidth();
+  const double height = (double)I.getHeight();
+
+  std::vector<float> weights((size_t)(size*size));
+  for(int r = 0; r < size; r++)
+    for(int c = 0; c < size; c++) {
+      const double y = (double)(r - win), x = (double)(c - win);
+      weights[(size_t)(r*size + c)] = (float)exp(-(x*x + y*y) / (double)(win*win));
+    }
+
+  const int nbPoints = (int)(points.size() - first);
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel
+#endif
+  {
+    std::vector<float> patch((size_t)(sampled*sampled));
+#ifdef VISP_HAVE_OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+    for(int k = 0; k < nbPoints; k++) {
+      vpImagePoint &point = points[first + (size_t)k];
+      const double u0 = point.get_j(), v0 = point.get_i();
+      double u = u0, v = v0;
+
+      for(int iter = 0; iter < m_maxIter; iter++) {
+        sampleWindow(I, u - win - 1, v - win - 1, sampled, &patch[0]);
+
+        double a = 0, b = 0, c = 0, bb1 = 0, bb2 = 0;
+        for(int r = 0; r < size; r++) {
+          const float *pm = &patch[(size_t)(r*sampled)];
+          const float *p0 = pm + sampled;
+          const float *pp = p0 + sampled;
+          const float *w = &weights[(size_t)(r*size)];
+          const double py = (double)(r - win);
+          for(int col = 0; col < size; col++) {
+            const double tgx = p0[col+2] - p0[col];
+            const double tgy = pp[col+1] - pm[col+1];
+            const double gxx = tgx*tgx*w[col];
+            const double gxy = tgx*tgy*w[col];
+            const double gyy = tgy*tgy*w[col];
+            const double px = (double)(col - win);
+            a += gxx;
+            b += gxy;
+            c += gyy;
+            bb1 += gxx*px + gxy*py;
+            bb2 += gxy*px + gyy*py;
+          }
+        }
+
+        const double det = a*c - b*b;
+        if(fabs(det) <= DBL_EPSILON*DBL_EPSILON)
+          break;
+
+        const double du = (c*bb1 - b*bb2) / det;
+        const double dv = (a*bb2 - b*bb1) / det;
+        u += du;
+        v += dv;
+        if(u < 0 || u >= width || v < 0 || v >= height || du*du + dv*dv <= eps2)
+          break;
+      }
+
+      if(fabs(u - u0) > win || fabs(v - v0) > win)
+        continue;
+      point.set_ij(v, u);
+    }
+  }
+}
+
+/*!
+  Track a feature from the previous to the current image with the pyramidal
+  Lucas-Kanade algorithm. On each level, the template window and its gradient
+  are sampled once; each iteration only samples the current image and
+  updates the displacement with the inverse of the gradient matrix.
+
+  \param pyrPrev, gradXPrev, gradYPrev : Pyramid of the previous image and its gradients.
+  \param pyrCur : Pyramid of the current image.
+  \param prevPt : Position of the feature in the previous image.
+  \param nextPt : Position of the feature in the current image. If useGuess is true,
+  it is used as initial position.
+  \param useGuess : True to start from nextPt instead of prevPt.
+  \param buffer : Working memory.
+
+  \return true if the feature is tracked.
+*/
+bool vpKltNative::trackFeature(const std::vector<vpImage<float> > &pyrPrev, const std::vector<vpImage<float> > &gradXPrev,
+                               const std::vector<vpImage<float> > &gradYPrev, const std::vector<vpImage<float> > &pyrCur,
+                               const vpImagePoint &prevPt, vpImagePoint &nextPt, const bool useGuess,
+                               std::vector<float> &buffer) const
+{
+  const int win = m_winSize;
+  const int area = win * win;
+  const double halfWin = (win - 1) * 0.5;
+  const double eps2 = m_epsilon * m_epsilon;
+  buffer.resize((size_t)(4*area));
+  float *T = &buffer[0];
+  float *Ix = T + area;
+  float *Iy = Ix + area;
+  float *J = Iy + area;
+
+  const int maxLevel = (int)std::min(pyrPrev.size(), pyrCur.size()) - 1;
+  double scale = 1.0 / (double)(1 << maxLevel);
+  double u, v;
+  if(useGuess) {
+    u = nextPt.get_j() * scale;
+    v = nextPt.get_i() * scale;
+  }
+  else {
+    u = prevPt.get_j() * scale;
+    v = prevPt.get_i() * scale;
+  }
+
+  for(int level = maxLevel; level >= 0; level--) {
+    if(level != maxLevel) {
+      u *= 2;
+      v *= 2;
+    }
+    scale = 1.0 / (double)(1 << level);
+    const vpImage<float> &Iprev = pyrPrev[(size_t)level];
+    const vpImage<float> &Icur = pyrCur[(size_t)level];
+    const double width = (double)Iprev.getWidth();
+    const double height = (double)Iprev.getHeight();
+    const double pu = prevPt.get_j() * scale;
+    const double pv = prevPt.get_i() * scale;
+
+    if(pu < 0 || pv < 0 || pu > width - 1 || pv > height - 1) {
+      if(level == 0)
+        return false;
+      continue;
+    }
+
+    sampleWindow(Iprev, pu - halfWin, pv - halfWin, win, T);
+    sampleWindow(gradXPrev[(size_t)level], pu - halfWin, pv - halfWin, win, Ix);
+    sampleWindow(gradYPrev[(size_t)level], pu - halfWin, pv - halfWin, win, Iy);
+
+    double gxx = 0, gxy = 0, gyy = 0;
+    for(int k = 0; k < area; k++) {
+      gxx += Ix[k]*Ix[k];
+      gxy += Ix[k]*Iy[k];
+      gyy += Iy[k]*Iy[k];
+    }
+
+    // Normalised as in cv::calcOpticalFlowPyrLK() so that the same threshold can be used.
+    const double minEig = (gxx + gyy - sqrt((gxx - gyy)*(gxx - gyy) + 4.0*gxy*gxy)) / (2.0 * area * 1024.0);
+    const double det = gxx*gyy - gxy*gxy;
+    if(minEig < m_minEigThreshold || det < DBL_EPSILON) {
+      if(level == 0)
+        return false;
+      continue;
+    }
+
+    double prevDu = 0, prevDv = 0;
+    for(int iter = 0; iter < m_maxIter; iter++) {
+      if(u < 0 || v < 0 || u > Icur.getWidth() - 1 || v > Icur.getHeight() - 1) {
+        if(level == 0)
+          return false;
+        break;
+      }
+
+      sampleWindow(Icur, u - halfWin, v - halfWin, win, J);
+      double bx = 0, by = 0;
+      for(int k = 0; k < area; k++) {
+        const float diff = J[k] - T[k];
+        bx += diff*Ix[k];
+        by += diff*Iy[k];
+      }
+
+      const double du = -(gyy*bx - gxy*by) / det;
+      const double dv = -(gxx*by - gxy*bx) / det;
+      u += du;
+      v += dv;
+
+      if(du*du + dv*dv <= eps2)
+        break;
+
+      // oscillation around the solution
+      if(iter > 0 && fabs(du + prevDu) < 0.01 && fabs(dv + prevDv) < 0.01) {
+        u -= du*0.5;
+        v -= dv*0.5;
+        break;
+      }
+      prevDu = du;
+      prevDv = dv;
+    }
+  }
+
+  if(u < 0 || v < 0 || u > pyrCur[0].getWidth() - 1 || v > pyrCur[0].getHeight() - 1)
+    return false;
+
+  nextPt.set_ij(v, u);
+  return true;
+}
+
+/*!
+  Initialise the tracking by extracting KLT keypoints on the provided image.
+
+  \param I : Grey level image used as input.
+
+  \exception vpTrackingException::initializationError : If the image I is not
+  initialized.
+*/
+void vpKltNative::initTracking(const vpImage<unsigned char> &I)
+{
+  if(I.getSize() == 0)
+    throw vpTrackingException(vpTrackingException::initializationError, "Image not initialized");
+
+  m_next_points_id = 0;
+  m_initial_guess = false;
+  for (size_t i=0; i<2; i++) {
+    m_points[i].clear();
+    m_pyr[i].clear();
+  }
+  m_points_id.clear();
+
+  buildPyramid(I);
+  detectFeatures(0, 0, I.getHeight(), I.getWidth(), NULL,
+                 m_maxCount > 0 ? (size_t)m_maxCount : (std::numeric_limits<size_t>::max)(), m_points[1]);
+  refineFeatures(m_points[1], 0);
+
+  for (size_t i=0; i < m_points[1].size(); i++)
+    m_points_id.push_back(m_next_points_id++);
+}
+
+/*!
+  Initialise the tracking by extracting KLT keypoints on the provided image.
+
+  \param I : Grey level image used as input.
+  \param mask : Image mask used to restrict the keypoint detection area. Only
+  the pixels with a non null value are considered.
+
+  \exception vpTrackingException::initializationError : If the image I is not
+  initialized, or if the mask does not have the size of the image.
+*/
+void vpKltNative::initTracking(const vpImage<unsigned char> &I, const vpImage<unsigned char> &mask)
+{
+  if(I.getSize() == 0)
+    throw vpTrackingException(vpTrackingException::initializationError, "Image not initialized");
+  if(mask.getWidth() != I.getWidth() || mask.getHeight() != I.getHeight())
+    throw vpTrackingException(vpTrackingException::initializationError, "The mask does not have the size of the image");
+
+  m_next_points_id = 0;
+  m_initial_guess = false;
+  for (size_t i=0; i<2; i++) {
+    m_points[i].clear();
+    m_pyr[i].clear();
+  }
+  m_points_id.clear();
+
+  buildPyramid(I);
+  detectFeatures(0, 0, I.getHeight(), I.getWidth(), &mask,
+                 m_maxCount > 0 ? (size_t)m_maxCount : (std::numeric_limits<size_t>::max)(), m_points[1]);
+  refineFeatures(m_points[1], 0);
+
+  for (size_t i=0; i < m_points[1].size(); i++)
+    m_points_id.push_back(m_next_points_id++);
+}
+
+/*!
+  Set the points that will be used as initialization during the next call to track().
+
+  \param I : Input image.
+  \param pts : Vector of points that should be tracked.
+*/
+void vpKltNative::initTracking(const vpImage<unsigned char> &I, const std::vector<vpImagePoint> &pts)
+{
+  m_initial_guess = false;
+  m_points[1] = pts;
+  m_next_points_id = 0;
+  m_points_id.clear();
+  for(size_t i=0; i < m_points[1].size(); i++) {
+    m_points_id.push_back(m_next_points_id ++);
+  }
+
+  m_pyr[0].clear();
+  buildPyramid(I);
+}
+
+/*!
+  Set the points that will be used as initialization during the next call to track().
+
+  \param I : Input image.
+  \param pts : Vector of points that should be tracked.
+  \param ids : Identifiers of the points. If the size of this vector is not the size of
+  the vector of points, new identifiers are generated.
+*/
+void vpKltNative::initTracking(const vpImage<unsigned char> &I, const std::vector<vpImagePoint> &pts, const std::vector<long> &ids)
+{
+  m_initial_guess = false;
+  m_points[1] = pts;
+  m_points_id.clear();
+
+  if(ids.size() != pts.size()){
+    m_next_points_id = 0;
+    for(size_t i=0; i < m_points[1].size(); i++)
+      m_points_id.push_back(m_next_points_id ++);
+  }
+  else{
+    long max = 0;
+    for(size_t i=0; i < m_points[1].size(); i++){
+      m_points_id.push_back(ids[i]);
+      if(ids[i] > max) max = ids[i];
+    }
+    m_next_points_id = max + 1;
+  }
+
+  m_pyr[0].clear();
+  buildPyramid(I);
+}
+
+/*!
+   Track KLT keypoints using the iterative Lucas-Kanade method with pyramids.
+   The lost features are removed.
+
+   \param I : Input image.
+
+   \exception vpTrackingException::fatalError : If there is no feature to track.
+ */
+void vpKltNative::track(const vpImage<unsigned char> &I)
+{
+  if(m_points[1].size() == 0)
+    throw vpTrackingException(vpTrackingException::fatalError, "Not enough key points to track.");
+
+  std::swap(m_pyr[0], m_pyr[1]);
+  std::swap(m_gradX[0], m_gradX[1]);
+  std::swap(m_gradY[0], m_gradY[1]);
+
+  bool useGuess = m_initial_guess;
+  if (m_initial_guess) {
+    m_initial_guess = false;
+  }
+  else {
+    std::swap(m_points[1], m_points[0]);
+    m_points[1] = m_points[0];
+  }
+
+  buildPyramid(I);
+
+  if(m_pyr[0].empty() || m_pyr[0][0].getWidth() != I.getWidth() || m_pyr[0][0].getHeight() != I.getHeight()) {
+    m_pyr[0] = m_pyr[1];
+    m_gradX[0] = m_gradX[1];
+    m_gradY[0] = m_gradY[1];
+  }
+
+  const int nbPoints = (int)m_points[0].size();
+  std::vector<unsigned char> status((size_t)nbPoints, 0);
+  const bool checkBack = m_fbThreshold > 0;
+  const double fbThreshold2 = m_fbThreshold * m_fbThreshold;
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel
+#endif
+  {
+    std::vector<float> buffer;
+#ifdef VISP_HAVE_OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+    for(int k = 0; k < nbPoints; k++) {
+      const vpImagePoint &prevPt = m_points[0][(size_t)k];
+      vpImagePoint &nextPt = m_points[1][(size_t)k];
+      bool tracked = trackFeature(m_pyr[0], m_gradX[0], m_gradY[0], m_pyr[1], prevPt, nextPt, useGuess, buffer);
+
+      if(tracked && checkBack) {
+        vpImagePoint backPt;
+        tracked = trackFeature(m_pyr[1], m_gradX[1], m_gradY[1], m_pyr[0], nextPt, backPt, false, buffer)
+            && vpImagePoint::sqrDistance(backPt, prevPt) <= fbThreshold2;
+      }
+      status[(size_t)k] = tracked ? 1 : 0;
+    }
+  }
+
+  // Remove points that are lost
+  size_t nbKept = 0;
+  for(size_t k = 0; k < (size_t)nbPoints; k++) {
+    if(status[k]) {
+      m_points[0][nbKept] = m_points[0][k];
+      m_points[1][nbKept] = m_points[1][k];
+      m_points_id[nbKept] = m_points_id[k];
+      nbKept++;
+    }
+  }
+  m_points[0].resize(nbKept);
+  m_points[1].resize(nbKept);
+  m_points_id.resize(nbKept);
+}
+
+/*!
+  Detect new features in a region of the last image given to initTracking()
+  or track(). The current features are not modified: the detected corners
+  are further than getMinDistance() from them and can be added with
+  addFeature(). This allows to replenish the features in the regions where
+  they were lost without a new full detection.
+
+  \param roi : Region of the image where the corners are searched.
+  \param maxCount : Maximal number of corners to detect.
+  \param features : Detected corners, refined at the sub-pixel level.
+*/
+void vpKltNative::detectNewFeatures(const vpRect &roi, const int maxCount, std::vector<vpImagePoint> &features) const
+{
+  features.clear();
+  if(m_pyr[1].empty() || maxCount <= 0)
+    return;
+
+  const int width = (int)m_pyr[1][0].getWidth();
+  const int height = (int)m_pyr[1][0].getHeight();
+  const int top = std::max(vpMath::round(roi.getTop()), 0);
+  const int left = std::max(vpMath::round(roi.getLeft()), 0);
+  const int bottom = std::min(vpMath::round(roi.getBottom()) + 1, height);
+  const int right = std::min(vpMath::round(roi.getRight()) + 1, width);
+  if(top >= bottom || left >= right)
+    return;
+
+  std::vector<vpImagePoint> points = m_points[1];
+  const size_t first = points.size();
+  detectFeatures((unsigned int)top, (unsigned int)left, (unsigned int)bottom, (unsigned int)right, NULL,
+                 (size_t)maxCount, points);
+  refineFeatures(points, first);
+  features.assign(points.begin() + (std::ptrdiff_t)first, points.end());
+}
+
+/*!
+
+  Get the 'index'th feature image coordinates.  Beware that
+  getFeature(i,...) may not represent the same feature before and
+  after a tracking iteration (if a feature is lost, features are
+  shifted in the array).
+
+  \param index : Index of feature.
+  \param id : id of the feature.
+  \param x : x coordinate.
+  \param y : y coordinate.
+
+*/
+void vpKltNative::getFeature(const int &index, int &id, float &x, float &y) const
+{
+  if ((size_t)index >= m_points[1].size()){
+    throw(vpException(vpException::badValue, "Feature [%d] doesn't exist", index));
+  }
+
+  x = (float)m_points[1][(size_t)index].get_j();
+  y = (float)m_points[1][(size_t)index].get_i();
+  id = (int)m_points_id[(size_t)index];
+}
+
+/*!
+  Display features position and id.
+
+  \param I : Image used as background. Display should be initialized on it.
+  \param color : Color used to display the features.
+  \param thickness : Thickness of the drawings.
+  */
+void vpKltNative::display(const vpImage<unsigned char> &I,
+                          const vpColor &color, unsigned int thickness)
+{
+  vpKltNative::display(I, m_points[1], m_points_id, color, thickness);
+}
+
+/*!
+
+  Display features list.
+
+  \param I : The image used as background.
+
+  \param features : Vector of features.
+
+  \param color : Color used to display the points.
+
+  \param thickness : Thickness of the points.
+*/
+void vpKltNative::display(const vpImage<unsigned char> &I, const std::vector<vpImagePoint> &features,
+                          const vpColor &color, unsigned int thickness)
+{
+  vpImagePoint ip;
+  for (size_t i = 0 ; i < features.size() ; i++) {
+    ip.set_u( vpMath::round(features[i].get_u() ) );
+    ip.set_v( vpMath::round(features[i].get_v() ) );
+    vpDisplay::displayCross(I, ip, 10+thickness, color, thickness);
+  }
+}
+
+/*!
+
+  Display features list.
+
+  \param I : The image used as background.
+
+  \param features : Vector of features.
+
+  \param color : Color used to display the points.
+
+  \param thickness : Thickness of the points.
+*/
+void vpKltNative::display(const vpImage<vpRGBa> &I, const std::vector<vpImagePoint> &features,
+                          const vpColor &color, unsigned int thickness)
+{
+  vpImagePoint ip;
+  for (size_t i = 0 ; i < features.size() ; i++) {
+    ip.set_u( vpMath::round(features[i].get_u() ) );
+    ip.set_v( vpMath::round(features[i].get_v() ) );
+    vpDisplay::displayCross(I, ip, 10+thickness, color, thickness);
+  }
+}
+
+/*!
+
+  Display features list with ids.
+
+  \param I : The image used as background.
+
+  \param features : Vector of features.
+
+  \param featuresid : Vector of ids corresponding to the features.
+
+  \param color : Color used to display the points.
+
+  \param thickness : Thickness of the points
+*/
+void vpKltNative::display(const vpImage<unsigned char> &I, const std::vector<vpImagePoint> &features,
+                          const std::vector<long> &featuresid,
+                          const vpColor &color, unsigned int thickness)
+{
+  vpImagePoint ip;
+  for (size_t i = 0; i < features.size(); i++) {
+    ip.set_u( vpMath::round(features[i].get_u() ) );
+    ip.set_v( vpMath::round(features[i].get_v() ) );
+    vpDisplay::displayCross(I, ip, 10, color, thickness);
+
+    std::ostringstream id;
+    id << featuresid[i];
+    ip.set_u( vpMath::round( features[i].get_u() + 5 ) );
+    vpDisplay::displayText(I, ip, id.str(), color);
+  }
+}
+
+/*!
+
+  Display features list with ids.
+
+  \param I : The image used as background.
+
+  \param features : Vector of features.
+
+  \param featuresid : Vector of ids corresponding to the features.
+
+  \param color : Color used to display the points.
+
+  \param thickness : Thickness of the points
+*/
+void vpKltNative::display(const vpImage<vpRGBa> &I, const std::vector<vpImagePoint> &features,
+                          const std::vector<long> &featuresid,
+                          const vpColor &color, unsigned int thickness)
+{
+  vpImagePoint ip;
+  for (size_t i = 0 ; i < features.size() ; i++) {
+    ip.set_u( vpMath::round(features[i].get_u() ) );
+    ip.set_v( vpMath::round(features[i].get_v() ) );
+    vpDisplay::displayCross(I, ip, 10, color, thickness);
+
+    std::ostringstream id;
+    id << featuresid[i];
+    ip.set_u( vpMath::round( features[i].get_u() + 5 ) );
+    vpDisplay::displayText(I, ip, id.str(), color);
+  }
+}
+
+/*!
+  Set the maximum number of features to track in the image.
+
+  \param maxCount : Maximum number of features to detect and track. Default value is set to 500.
+  If it is not positive, all the detected features are kept.
+*/
+void vpKltNative::setMaxFeatures(const int maxCount)
+{
+  m_maxCount = maxCount;
+}
+
+/*!
+  Set the window size used to track and refine the features.
+
+  \param winSize : Size of the window. Default value is set to 10.
+  A winSize \f$\times\f$ winSize window is used to track the features and a
+  2*winSize+1 \f$\times\f$ 2*winSize+1 window to refine the detected corners, as in vpKltOpencv.
+*/
+void vpKltNative::setWindowSize(const int winSize)
+{
+  if(winSize < 2)
+    throw vpException(vpException::badValue, "The window size must be at least 2");
+  m_winSize = winSize;
+}
+
+/*!
+  Set the parameter characterizing the minimal accepted quality of image corners.
+
+  \param qualityLevel : Quality level parameter. Default value is set to 0.01. The parameter value is multiplied by the
+  best corner quality measure, which is the minimal eigenvalue or the Harris function response. The corners with
+  the quality measure less than the product are rejected. For example, if the best corner has the quality
+  measure = 1500, and the qualityLevel=0.01, then all the corners with the quality measure less than 15 are rejected.
+ */
+void vpKltNative::setQuality(double qualityLevel)
+{
+  m_qualityLevel = qualityLevel;
+}
+
+/*!
+  Set the free parameter of the Harris detector.
+
+  \param harris_k : Free parameter of the Harris detector. Default value is set to 0.04.
+*/
+void vpKltNative::setHarrisFreeParameter(double harris_k)
+{
+  m_harris_k = harris_k;
+}
+
+/*!
+  Set the parameter indicating whether to use a Harris detector or
+  the minimal eigenvalue of gradient matrices for corner detection.
+  \param useHarrisDetector : If 1 (default value), use the Harris detector. If 0 use the eigenvalue.
+*/
+void vpKltNative::setUseHarris(const int useHarrisDetector)
+{
+  m_useHarrisDetector = useHarrisDetector;
+}
+
+/*!
+  Set the minimal Euclidean distance between detected corners during initialization.
+
+  \param minDistance : Minimal possible Euclidean distance between the detected corners.
+  Default value is set to 15.
+*/
+void vpKltNative::setMinDistance(double minDistance)
+{
+  m_minDistance = minDistance;
+}
+
+/*!
+  Set the minimal eigen value threshold used to reject a point during the tracking.
+  \param minEigThreshold : Minimal eigen value threshold. Default value is set to 1e-4.
+*/
+void vpKltNative::setMinEigThreshold(double minEigThreshold)
+{
+  m_minEigThreshold = minEigThreshold;
+}
+
+/*!
+  Set the size of the averaging block used to detect the features.
+
+  \param blockSize : Size of an average block for computing a derivative covariation
+  matrix over each pixel neighborhood. Default value is set to 3.
+*/
+void vpKltNative::setBlockSize(const int blockSize)
+{
+  if(blockSize < 1)
+    throw vpException(vpException::badValue, "The block size must be positive");
+  m_blockSize = blockSize;
+}
+
+/*!
+  Set the maximal pyramid level. If the level is zero, then no pyramid is
+  computed for the optical flow.
+
+  \param pyrMaxLevel : 0-based maximal pyramid level number; if set to 0, pyramids are not used (single level),
+  if set to 1, two levels are used, and so on. Default value is set to 3.
+*/
+void vpKltNative::setPyramidLevels(const int pyrMaxLevel)
+{
+  m_pyrMaxLevel = pyrMaxLevel < 0 ? 0 : pyrMaxLevel;
+}
+
+/*!
+  Enable the forward-backward check. Each tracked feature is tracked back from
+  the current to the previous image and is lost if it does not come back
+  close to its previous position. This doubles the tracking time but removes
+  most of the features that drift on occlusions or on repetitive textures.
+
+  \param threshold : Maximal distance in pixel between the previous position
+  of a feature and the position obtained by tracking it back. If it is not
+  positive (default), the check is disabled.
+*/
+void vpKltNative::setForwardBackwardThreshold(const double threshold)
+{
+  m_fbThreshold = threshold;
+}
+
+/*!
+  Set the points that will be used as initial guess during the next call to track().
+  A typical usage of this function is to predict the position of the features before the
+  next call to track().
+
+  \param guess_pts : Vector of points that should be tracked. The size of this
+  vector should be the same as the one returned by getFeatures(). If this is not the case,
+  an exception is returned. Note also that the id of the points is not modified.
+
+  \sa initTracking()
+*/
+void
+vpKltNative::setInitialGuess(const std::vector<vpImagePoint> &guess_pts)
+{
+  if(guess_pts.size() != m_points[1].size()){
+    throw(vpException(vpException::badValue,
+                      "Cannot set initial guess: size feature vector [%d] and guess vector [%d] doesn't match",
+                      m_points[1].size(), guess_pts.size()));
+  }
+
+  m_points[0] = m_points[1];
+  m_points[1] = guess_pts;
+  m_initial_guess = true;
+}
+
+/*!
+  Set the points that will be used as initial guess during the next call to track().
+  A typical usage of this function is to predict the position of the features before the
+  next call to track().
+
+  \param init_pts : Initial points (could be obtained from getPrevFeatures() or getFeatures()).
+  \param guess_pts : Prediction of the new position of the initial points. The size of this vector must be the same as the size of the vector of initial points.
+  \param fid : Identifiers of the initial points.
+
+  \sa getPrevFeatures()
+  \sa getFeatures(), getFeaturesId
+  \sa initTracking()
+*/
+void
+vpKltNative::setInitialGuess(const std::vector<vpImagePoint> &init_pts, const std::vector<vpImagePoint> &guess_pts, const std::vector<long> &fid)
+{
+  if(guess_pts.size() != init_pts.size() || fid.size() != init_pts.size()){
+    throw(vpException(vpException::badValue,
+                      "Cannot set initial guess: size init vector [%d], guess vector [%d] and id vector [%d] doesn't match",
+                      init_pts.size(), guess_pts.size(), fid.size()));
+  }
+
+  m_points[0] = init_pts;
+  m_points[1] = guess_pts;
+  m_points_id = fid;
+  m_initial_guess = true;
+}
+
+/*!
+
+  Add a keypoint at the end of the feature list. The id of the feature is set to ensure that it is unique.
+  \param x,y : Coordinates of the feature in the image.
+
+*/
+void vpKltNative::addFeature(const float &x, const float &y)
+{
+  m_points[1].push_back(vpImagePoint(y, x));
+  m_points_id.push_back(m_next_points_id++);
+}
+
+/*!
+
+  Add a keypoint at the end of the feature list.
+
+ \warning This function doesn't ensure that the id of the feature is unique.
+  You should rather use addFeature(const float &, const float &) or addFeature(const vpImagePoint &).
+
+  \param id : Feature id. Should be unique
+  \param x,y : Coordinates of the feature in the image.
+
+*/
+void vpKltNative::addFeature(const long &id, const float &x, const float &y)
+{
+  m_points[1].push_back(vpImagePoint(y, x));
+  m_points_id.push_back(id);
+  if (id >= m_next_points_id)
+    m_next_points_id = id + 1;
+}
+
+/*!
+
+  Add a keypoint at the end of the feature list. The id of the feature is set to ensure that it is unique.
+  \param f : Coordinates of the feature in the image.
+
+*/
+void vpKltNative::addFeature(const vpImagePoint &f)
+{
+  m_points[1].push_back(f);
+  m_points_id.push_back(m_next_points_id++);
+}
+
+/*!
+   Remove the feature with the given index as parameter.
+   \param index : Index of the feature to remove.
+ */
+void vpKltNative::suppressFeature(const int &index)
+{
+  if ((size_t)index >= m_points[1].size()){
+    throw(vpException(vpException::badValue, "Feature [%d] doesn't exist", index));
+  }
+
+  m_points[1].erase(m_points[1].begin()+index);
+  m_points_id.erase(m_points_id.begin()+index);
+}
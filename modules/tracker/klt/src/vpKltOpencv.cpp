@@ -572,6 +572,45 @@ void vpKltOpencv::addFeature(const cv::Point2f &f)
   m_points_id.push_back(m_next_points_id++);
 }
 
+/*!
+  Detect new features in a region of the last image given to initTracking()
+  or track(). The current features are not modified: the detected corners
+  are further than getMinDistance() from them and can be added with
+  addFeature(). This allows to replenish the features in the regions where
+  they were lost without a new full detection.
+
+  \param roi : Region of the image where the corners are searched.
+  \param maxCount : Maximal number of corners to detect.
+  \param features : Detected corners, refined at the sub-pixel level.
+*/
+void vpKltOpencv::detectNewFeatures(const cv::Rect &roi, const int maxCount, std::vector<cv::Point2f> &features) const
+{
+  features.clear();
+  cv::Rect rect = roi & cv::Rect(0, 0, m_gray.cols, m_gray.rows);
+  if(m_gray.empty() || maxCount <= 0 || rect.area() == 0)
+    return;
+
+  // forbid the neighbourhood of the current features
+  cv::Mat mask(rect.size(), CV_8UC1, cv::Scalar(255));
+  const int radius = (int)ceil(m_minDistance);
+  for (size_t i=0; i < m_points[1].size(); i++) {
+    const cv::Point2f &p = m_points[1][i];
+    if(p.x > rect.x - radius && p.x < rect.x + rect.width + radius &&
+       p.y > rect.y - radius && p.y < rect.y + rect.height + radius)
+      cv::circle(mask, cv::Point(cvRound(p.x) - rect.x, cvRound(p.y) - rect.y), radius, cv::Scalar(0), -1);
+  }
+
+  cv::goodFeaturesToTrack(m_gray(rect), features, maxCount, m_qualityLevel, m_minDistance, mask, m_blockSize, 0, m_harris_k);
+
+  if(features.size() > 0){
+    for (size_t i=0; i < features.size(); i++) {
+      features[i].x += (float)rect.x;
+      features[i].y += (float)rect.y;
+    }
+    cv::cornerSubPix(m_gray, features, cv::Size(m_winSize, m_winSize), cv::Size(-1,-1), m_termcrit);
+  }
+}
+
 /*!
    Remove the feature with the given index as parameter.
    \param index : Index of the feature to remove.
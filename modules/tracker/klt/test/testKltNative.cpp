@@ -0,0 +1,187 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *
+ * Description:
+ * Detection and tracking of KLT features without OpenCV.
+ *
+ *****************************************************************************/
+/*!
+  \example testKltNative.cpp
+
+  \brief Detect KLT features on a synthetic texture, track them in a
+  translated copy of the texture and check the estimated displacement.
+*/
+
+#include <iostream>
+#include <cmath>
+
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpTime.h>
+#include <visp3/klt/vpKltNative.h>
+
+namespace {
+// Smooth texture with blobs, shifted by (du, dv)
+void makeImage(vpImage<unsigned char> &I, double du, double dv)
+{
+  I.resize(480, 640);
+  for (unsigned int i = 0; i < I.getHeight(); i++) {
+    for (unsigned int j = 0; j < I.getWidth(); j++) {
+      double x = j - du, y = i - dv;
+      double value = 128 + 50*sin(0.19*x)*sin(0.23*y) + 30*sin(0.071*x - 0.053*y + 1.0)
+          + 25*cos(0.11*x + 0.09*y) * sin(0.05*y);
+      I[i][j] = (unsigned char)vpMath::round(value);
+    }
+  }
+}
+
+// Check that the features moved by (du, dv)
+bool checkDisplacement(const std::string &name, const vpKltNative &tracker, const std::vector<vpImagePoint> &initial,
+                       const std::vector<long> &initialIds, double du, double dv, unsigned int minTracked)
+{
+  double error = 0;
+  unsigned int nbTracked = 0;
+  std::vector<long> ids = tracker.getFeaturesId();
+  std::vector<vpImagePoint> features = tracker.getFeatures();
+  for (size_t k = 0; k < features.size(); k++) {
+    for (size_t n = 0; n < initial.size(); n++) {
+      if (initialIds[n] == ids[k]) {
+        error += sqrt(vpMath::sqr(features[k].get_u() - initial[n].get_u() - du)
+                      + vpMath::sqr(features[k].get_v() - initial[n].get_v() - dv));
+        nbTracked++;
+        break;
+      }
+    }
+  }
+  if (nbTracked)
+    error /= nbTracked;
+
+  std::cout << name << ": " << nbTracked << "/" << initial.size() << " features tracked, mean error "
+            << error << " pixel" << std::endl;
+  if (nbTracked < minTracked || error > 0.1) {
+    std::cerr << name << ": bad tracking" << std::endl;
+    return false;
+  }
+  return true;
+}
+}
+
+int main()
+{
+  try {
+    vpImage<unsigned char> I0, I1;
+    const double du = 6.3, dv = -4.6;
+    makeImage(I0, 0, 0);
+    makeImage(I1, du, dv);
+
+    vpKltNative tracker;
+    tracker.setMaxFeatures(300);
+    tracker.setWindowSize(9);
+    tracker.setQuality(0.01);
+    tracker.setMinDistance(10);
+    tracker.setPyramidLevels(3);
+
+    double t = vpTime::measureTimeMs();
+    tracker.initTracking(I0);
+    std::cout << "Detection of " << tracker.getNbFeatures() << " features in "
+              << vpTime::measureTimeMs() - t << " ms" << std::endl;
+    if (tracker.getNbFeatures() < 100) {
+      std::cerr << "Not enough features detected" << std::endl;
+      return 1;
+    }
+
+    std::vector<vpImagePoint> initial = tracker.getFeatures();
+    std::vector<long> initialIds = tracker.getFeaturesId();
+
+    t = vpTime::measureTimeMs();
+    tracker.track(I1);
+    double t_track = vpTime::measureTimeMs() - t;
+    if (! checkDisplacement("Tracking", tracker, initial, initialIds, du, dv, (unsigned int)(0.9*initial.size())))
+      return 1;
+    std::cout << "Tracking time: " << t_track << " ms" << std::endl;
+
+    // Start from a prediction of the displacement
+    tracker.initTracking(I0, initial, initialIds);
+    std::vector<vpImagePoint> guess = initial;
+    for (size_t k = 0; k < guess.size(); k++)
+      guess[k].set_uv(guess[k].get_u() + du + 0.8, guess[k].get_v() + dv - 0.5);
+    tracker.setInitialGuess(initial, guess, initialIds);
+    tracker.track(I1);
+    if (! checkDisplacement("Tracking with initial guess", tracker, initial, initialIds, du, dv, (unsigned int)(0.9*initial.size())))
+      return 1;
+
+    // Forward-backward check
+    tracker.initTracking(I0, initial, initialIds);
+    tracker.setForwardBackwardThreshold(0.5);
+    tracker.track(I1);
+    if (! checkDisplacement("Forward-backward tracking", tracker, initial, initialIds, du, dv, (unsigned int)(0.8*initial.size())))
+      return 1;
+
+    // Detection restricted to the left half of the image
+    vpImage<unsigned char> mask(I0.getHeight(), I0.getWidth(), 0);
+    for (unsigned int i = 0; i < mask.getHeight(); i++)
+      for (unsigned int j = 0; j < mask.getWidth()/2; j++)
+        mask[i][j] = 255;
+    tracker.initTracking(I0, mask);
+    for (int k = 0; k < tracker.getNbFeatures(); k++) {
+      int id;
+      float x, y;
+      tracker.getFeature(k, id, x, y);
+      if (x > mask.getWidth()/2 + 1) {
+        std::cerr << "Feature detected outside of the mask" << std::endl;
+        return 1;
+      }
+    }
+    std::cout << "Detection of " << tracker.getNbFeatures() << " features in the mask" << std::endl;
+
+    // Detection of new features away from the current ones
+    std::vector<vpImagePoint> current = tracker.getFeatures();
+    std::vector<vpImagePoint> added;
+    tracker.detectNewFeatures(vpRect(0, 0, I0.getWidth(), I0.getHeight()), 50, added);
+    if (added.empty() || added.size() > 50) {
+      std::cerr << "Bad number of new features: " << added.size() << std::endl;
+      return 1;
+    }
+    for (size_t k = 0; k < added.size(); k++) {
+      for (size_t n = 0; n < current.size(); n++) {
+        if (vpImagePoint::distance(added[k], current[n]) < 9.) {
+          std::cerr << "New feature too close to a tracked one" << std::endl;
+          return 1;
+        }
+      }
+    }
+    std::cout << "Detection of " << added.size() << " new features" << std::endl;
+
+    return 0;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+}
@@ -50,7 +50,7 @@
 
 #include <visp3/core/vpConfig.h>
 
-#if (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 #include <visp3/mbt/vpMbEdgeMultiTracker.h>
 #include <visp3/mbt/vpMbKltMultiTracker.h>
@@ -58,7 +58,8 @@
 /*!
   \class vpMbEdgeKltMultiTracker
   \ingroup group_mbt_trackers
-  \warning This class is only available if OpenCV is installed, and used.
+  \note The KLT features are tracked with vpKltOpencv or vpKltNative (see
+  vpMbKltTracker::setKltBackend()).
 
   \brief Hybrid stereo (or more) tracker based on moving-edges and keypoints tracked using KLT
   tracker.
@@ -128,6 +129,13 @@ public:
 
   virtual std::vector<std::string> getCameraNames() const;
 
+  /*!
+    Return true if the cameras are processed in parallel.
+
+    \sa setCamerasThreaded()
+  */
+  inline bool getCamerasThreaded() const { return vpMbEdgeMultiTracker::m_camerasThreaded; }
+
   virtual void getCameraParameters(vpCameraParameters &camera) const;
   virtual void getCameraParameters(vpCameraParameters &cam1, vpCameraParameters &cam2) const;
   virtual void getCameraParameters(const std::string &cameraName, vpCameraParameters &camera) const;
@@ -249,6 +257,8 @@ public:
 
   virtual void setCameraParameters(const std::map<std::string, vpCameraParameters> &mapOfCameraParameters);
 
+  virtual void setCamerasThreaded(const bool threaded);
+
   virtual void setCameraTransformationMatrix(const std::string &cameraName,
       const vpHomogeneousMatrix &cameraTransformationMatrix);
 
@@ -314,6 +324,8 @@ public:
   virtual void setMinPolygonAreaThresh(const double minPolygonAreaThresh, const std::string &cameraName,
       const std::string &name);
 
+  virtual void setModelCacheDirectory(const std::string &directory);
+
   virtual void setNearClippingDistance(const double &dist);
   virtual void setNearClippingDistance(const std::string &cameraName, const double &dist);
 
@@ -323,6 +335,11 @@ public:
 
   virtual void setOptimizationMethod(const vpMbtOptimizationMethod &opt);
 
+  virtual void setPosePrediction(const vpMbtPosePredictionMethod &method);
+
+  virtual void setPosePredictionKalmanParameters(const double stateVariance, const double measureVariance,
+                                                 const double rho);
+
   virtual void setPose(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &cMo);
 
   virtual void setPose(const vpImage<unsigned char> &I1, const vpImage<unsigned char> &I2, const vpHomogeneousMatrix &c1Mo,
@@ -338,6 +355,8 @@ public:
 
   virtual void setReferenceCameraName(const std::string &referenceCameraName);
 
+  virtual void setScanLineThreaded(const bool threaded);
+
   virtual void setScanLineVisibilityTest(const bool &v);
 
   virtual void setThresholdAcceptation(const double th);
@@ -380,5 +399,5 @@ protected:
   virtual void trackMovingEdges(std::map<std::string, const vpImage<unsigned char> *> &mapOfImages);
 };
 
-#endif // VISP_HAVE_OPENCV
+#endif // VISP_HAVE_MODULE_KLT
 #endif //__vpMbEdgeKltMultiTracker_h__
@@ -46,14 +46,17 @@
 
 #include <visp3/core/vpConfig.h>
 
-#if defined(VISP_HAVE_MODULE_KLT) && (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 #include <visp3/core/vpRobust.h>
 #include <visp3/core/vpSubMatrix.h>
 #include <visp3/core/vpSubColVector.h>
 #include <visp3/core/vpExponentialMap.h>
 #include <visp3/mbt/vpMbTracker.h>
-#include <visp3/klt/vpKltOpencv.h>
+#include <visp3/klt/vpKltNative.h>
+#if defined(VISP_HAVE_OPENCV)
+#  include <visp3/klt/vpKltOpencv.h>
+#endif
 #include <visp3/mbt/vpMbEdgeTracker.h>
 #include <visp3/core/vpPoseVector.h>
 #include <visp3/mbt/vpMbtEdgeKltXmlParser.h>
@@ -62,7 +65,8 @@
 /*!
   \class vpMbEdgeKltTracker
   \ingroup group_mbt_trackers
-  \warning This class is only available if OpenCV is installed, and used.
+  \note The KLT features are tracked with vpKltOpencv or vpKltNative (see
+  vpMbKltTracker::setKltBackend()).
   
   \brief Hybrid tracker based on moving-edges and keypoints tracked using KLT 
   tracker.
@@ -376,4 +380,4 @@ protected:
 
 #endif
 
-#endif //VISP_HAVE_OPENCV
+#endif //VISP_HAVE_MODULE_KLT
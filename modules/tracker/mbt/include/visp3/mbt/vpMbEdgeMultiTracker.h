@@ -79,6 +79,9 @@ protected:
   //! Name of the reference camera
   std::string m_referenceCameraName;
 
+  //! Flag to process the cameras in parallel
+  bool m_camerasThreaded;
+
 
 public:
   // Default constructor <==> equivalent to vpMbEdgeTracker
@@ -118,6 +121,13 @@ public:
 
   virtual std::vector<std::string> getCameraNames() const;
 
+  /*!
+    Return true if the cameras are processed in parallel.
+
+    \sa setCamerasThreaded()
+  */
+  inline bool getCamerasThreaded() const { return m_camerasThreaded; }
+
   virtual void getCameraParameters(vpCameraParameters &camera) const;
   virtual void getCameraParameters(vpCameraParameters &cam1, vpCameraParameters &cam2) const;
   virtual void getCameraParameters(const std::string &cameraName, vpCameraParameters &camera) const;
@@ -231,6 +241,20 @@ public:
 
   virtual void setCameraParameters(const std::map<std::string, vpCameraParameters> &mapOfCameraParameters);
 
+  /*!
+    Enable or disable the processing of the cameras in parallel. The moving
+    edges of each camera are tracked and their interaction matrix and error
+    vector are computed concurrently, the estimated pose does not depend on
+    this setting. This has an effect only if ViSP was built with OpenMP.
+
+    The visibility tests are done sequentially when Ogre is used
+    (see setOgreVisibilityTest()).
+
+    \param threaded : true to process the cameras in parallel. Default is
+    false.
+  */
+  virtual void setCamerasThreaded(const bool threaded) { m_camerasThreaded = threaded; }
+
   virtual void setCameraTransformationMatrix(const std::string &cameraName,
       const vpHomogeneousMatrix &cameraTransformationMatrix);
 
@@ -246,6 +270,8 @@ public:
   virtual void setFarClippingDistance(const double &dist);
   virtual void setFarClippingDistance(const std::string &cameraName, const double &dist);
 
+  virtual void setFeatureBudget(const unsigned int nbSites, const double latency = 0);
+
   virtual void setGoodMovingEdgesRatioThreshold(const double threshold);
 
 #ifdef VISP_HAVE_OGRE
@@ -280,6 +306,8 @@ public:
   virtual void setMinPolygonAreaThresh(const double minPolygonAreaThresh, const std::string &cameraName,
       const std::string &name);
 
+  virtual void setModelCacheDirectory(const std::string &directory);
+
   virtual void setMovingEdge(const vpMe &me);
   virtual void setMovingEdge(const std::string &cameraName, const vpMe &me);
 
@@ -302,6 +330,11 @@ public:
 
   virtual void setOptimizationMethod(const vpMbtOptimizationMethod &opt);
 
+  virtual void setPosePrediction(const vpMbtPosePredictionMethod &method);
+
+  virtual void setPosePredictionKalmanParameters(const double stateVariance, const double measureVariance,
+                                                 const double rho);
+
   virtual void setPose(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &cMo);
 
   virtual void setPose(const vpImage<unsigned char> &I1, const vpImage<unsigned char> &I2, const vpHomogeneousMatrix &c1Mo,
@@ -319,6 +352,8 @@ public:
 
   virtual void setScales(const std::vector<bool>& scales);
 
+  virtual void setScanLineThreaded(const bool threaded);
+
   virtual void setScanLineVisibilityTest(const bool &v);
 
   virtual void track(const vpImage<unsigned char> &I);
@@ -333,6 +368,8 @@ protected:
 
   /** @name Protected Member Functions Inherited from vpMbEdgeMultiTracker */
   //@{
+  virtual void adaptFeatureBudget(const double time);
+
   virtual void cleanPyramid(std::map<std::string, std::vector<const vpImage<unsigned char>* > >& pyramid);
 
   virtual void computeProjectionError();
@@ -340,8 +377,7 @@ protected:
   virtual void computeVVS(std::map<std::string, const vpImage<unsigned char> *> &mapOfImages,
       const unsigned int lvl);
 
-  virtual void computeVVSSecondPhaseWeights(const unsigned int iter, const unsigned int nerror,
-      vpColVector &weighted_error, vpColVector &w_lines, vpColVector &w_cylinders, vpColVector &w_circles,
+  virtual void computeVVSSecondPhaseWeights(const unsigned int iter, vpColVector &w_lines, vpColVector &w_cylinders, vpColVector &w_circles,
       std::map<std::string, unsigned int> &mapOfNumberOfLines,
       std::map<std::string, unsigned int> &mapOfNumberOfCylinders, std::map<std::string, unsigned int> &mapOfNumberOfCircles,
       std::map<std::string, vpColVector> &mapOfWeightLines, std::map<std::string, vpColVector> &mapOfWeightCylinders,
@@ -352,6 +388,8 @@ protected:
 
   virtual void initPyramid(const std::map<std::string, const vpImage<unsigned char> * >& mapOfImages,
       std::map<std::string, std::vector<const vpImage<unsigned char>* > >& pyramid);
+
+  void predictMovingEdge();
   //@}
 };
 
@@ -52,6 +52,7 @@
 #include <visp3/mbt/vpMbtDistanceLine.h>
 #include <visp3/mbt/vpMbtDistanceCircle.h>
 #include <visp3/mbt/vpMbtDistanceCylinder.h>
+#include <visp3/mbt/vpMbtVVSSolver.h>
 #include <visp3/core/vpXmlParser.h>
 #include <visp3/core/vpRobust.h>
 
@@ -59,6 +60,7 @@
 #include <fstream>
 #include <vector>
 #include <list>
+#include <map>
 
 #if defined(VISP_HAVE_COIN3D)
 //Inventor includes
@@ -311,6 +313,30 @@ class VISP_EXPORT vpMbEdgeTracker: virtual public vpMbTracker
     //! Number of features used in the computation of the projection error
     unsigned int nbFeaturesForProjErrorComputation;
 
+    //! If true, the moving edges of the different primitives are tracked in parallel.
+    bool threadedMovingEdge;
+
+    //! Number of moving edges distributed over the visible primitives at each frame, 0 if not used (see setFeatureBudget()).
+    unsigned int m_featureBudget;
+    //! Targeted duration of a call to track() in ms, 0 if not used.
+    double m_featureBudgetLatency;
+    //! Number of moving edges currently distributed, adapted to meet the targeted duration.
+    double m_featureBudgetCurrent;
+    //! Number of visible primitives tracked at the last frame.
+    unsigned int m_nbTrackedPrimitives;
+    //! Number of moving edges tracked at the last frame.
+    unsigned int m_nbTrackedSites;
+    //! Number of moving edges kept by the robust estimation at the last frame.
+    unsigned int m_nbValidSites;
+    //! Duration of the last call to track() in ms.
+    double m_trackingTime;
+    //! Cell of the grid in which the extremities of the lines are indexed.
+    typedef std::pair<long long, std::pair<long long, long long> > vpMbtLineIndexKey;
+    //! For each scale, the lines indexed by the cells of their extremities, to find the duplicated lines in addLine().
+    std::vector< std::multimap<vpMbtLineIndexKey, vpMbtDistanceLine*> > m_lineIndex;
+    //! For each scale, number of lines in m_lineIndex. The index is rebuilt when it differs from the size of lines.
+    std::vector<size_t> m_lineIndexSize;
+
 public:
   
   vpMbEdgeTracker(); 
@@ -331,6 +357,18 @@ public:
   */
   virtual inline double getLambda() const {return lambda;}
   
+  /*!
+    \return The number of moving edges currently distributed over the
+    visible primitives, which is adapted to the targeted duration of a frame,
+    or 0 if the budget is not used.
+
+    \sa setFeatureBudget()
+  */
+  inline unsigned int getFeatureBudget() const { return m_featureBudget ? (unsigned int)vpMath::round(m_featureBudgetCurrent) : 0;}
+
+  void getFeatureStatistics(unsigned int &nbPrimitives, unsigned int &nbSites, unsigned int &nbValidSites,
+                            double &time) const;
+
   void getLline(std::list<vpMbtDistanceLine *>& linesList, const unsigned int level = 0) const;
   void getLcircle(std::list<vpMbtDistanceCircle *>& circlesList, const unsigned int level = 0) const;
   void getLcylinder(std::list<vpMbtDistanceCylinder *>& cylindersList, const unsigned int level = 0) const;
@@ -348,6 +386,13 @@ public:
   */
   virtual inline vpMe getMovingEdge() const { return this->me;}
 
+  /*!
+    \return true if the moving edges of the different primitives are tracked in parallel.
+
+    \sa setMovingEdgeThreaded()
+  */
+  inline bool getMovingEdgeThreaded() const { return threadedMovingEdge;}
+
   virtual unsigned int getNbPoints(const unsigned int level=0) const;
   
   /*!
@@ -368,11 +413,14 @@ public:
 
   void loadConfigFile(const std::string &configFile);
   void loadConfigFile(const char* configFile);
+  virtual void loadState(vpBinaryArchive &ar);
   virtual void reInitModel(const vpImage<unsigned char>& I, const std::string &cad_name, const vpHomogeneousMatrix& cMo_,
 		  const bool verbose=false);
   void reInitModel(const vpImage<unsigned char>& I, const char* cad_name, const vpHomogeneousMatrix& cMo,
 		  const bool verbose=false);
   void resetTracker();
+
+  virtual void saveState(vpBinaryArchive &ar) const;
   
   /*!
     Set the camera parameters.
@@ -436,6 +484,8 @@ public:
     }
   }
 
+  virtual void setFeatureBudget(const unsigned int nbSites, const double latency = 0);
+
   /*!
      Set the threshold value between 0 and 1 over good moving edges ratio. It allows to
      decide if the tracker has enough valid moving edges to compute a pose. 1 means that all
@@ -459,6 +509,20 @@ public:
   
   void setMovingEdge(const vpMe &me);
 
+  /*!
+    Enable or disable the parallel tracking of the moving edges. When enabled,
+    the lines, cylinders and circles are distributed over the OpenMP threads in
+    trackMovingEdge() and updateMovingEdge(). Each primitive only depends on
+    the image and on the pose, so the result is the same as with the
+    sequential tracking. This setting has no effect if ViSP is built without
+    OpenMP.
+
+    \param threaded : true to track the primitives in parallel. Default is false.
+
+    \sa getMovingEdgeThreaded()
+  */
+  void setMovingEdgeThreaded(const bool threaded) { threadedMovingEdge = threaded;}
+
   virtual void setPose(const vpImage<unsigned char> &I, const vpHomogeneousMatrix& cdMo);
   
   void setScales(const std::vector<bool>& _scales);
@@ -476,6 +540,7 @@ protected:
   void addCylinder(const vpPoint &P1, const vpPoint &P2, const double r, int idFace = -1, const std::string& name = "");
   void addLine(vpPoint &p1, vpPoint &p2, int polygon = -1, std::string name = "");
   void addPolygon(vpMbtPolygon &p) ;
+  virtual void adaptFeatureBudget(const double time);
 
   void cleanPyramid(std::vector<const vpImage<unsigned char>* >& _pyramid);
   void computeProjectionError(const vpImage<unsigned char>& _I);
@@ -484,19 +549,15 @@ protected:
   void computeVVSFirstPhase(const vpImage<unsigned char>& I, const unsigned int iter,
       vpMatrix &L, vpColVector &factor, double &count, vpColVector &error, vpColVector &w_mbt, const unsigned int lvl = 0);
   void computeVVSFirstPhaseFactor(const vpImage<unsigned char>& I, vpColVector &factor, const unsigned int lvl = 0);
-  void computeVVSFirstPhasePoseEstimation(const unsigned int nerror, const unsigned int iter, const vpColVector &factor,
-      vpColVector &weighted_error, vpMatrix &L, bool &isoJoIdentity_);
+  void computeVVSFirstPhasePoseEstimation(const unsigned int iter, const vpColVector &factor, const vpMatrix &L,
+      bool &isoJoIdentity_);
   void computeVVSSecondPhase(const vpImage<unsigned char>& I, vpMatrix &L, vpColVector &error_lines,
       vpColVector &error_cylinders, vpColVector &error_circles, vpColVector &error, const unsigned int lvl);
-  void computeVVSSecondPhaseCheckLevenbergMarquardt(const unsigned int iter, const unsigned int nbrow,
-      const vpColVector &m_error_prev, const vpColVector &m_w_prev, const vpHomogeneousMatrix &cMoPrev,
-      double &mu, bool &reStartFromLastIncrement);
-  void computeVVSSecondPhasePoseEstimation(const unsigned int nerror, vpMatrix &L, vpMatrix &L_true, vpMatrix &LVJ_true,
-      vpColVector &W_true, const vpColVector &factor, const unsigned int iter, const bool isoJoIdentity_,
-      vpColVector &weighted_error, double &mu, vpColVector &m_error_prev, vpColVector &m_w_prev,
-      vpHomogeneousMatrix &cMoPrev, double &residu_1, double &r);
-  void computeVVSSecondPhaseWeights(const unsigned int iter, const unsigned int nerror,
-      const unsigned int nbrow, vpColVector &weighted_error,
+  void computeVVSSecondPhaseCovariance(const vpMatrix &L_true, const vpColVector &W_true, const bool isoJoIdentity_,
+      const vpHomogeneousMatrix &cMoPrev);
+  void computeVVSSecondPhasePoseEstimation(vpMbtVVSSolver &solver, const vpMatrix &L, vpMatrix &L_true,
+      const vpColVector &factor, const bool isoJoIdentity_, vpHomogeneousMatrix &cMoPrev);
+  void computeVVSSecondPhaseWeights(const unsigned int iter, const unsigned int nbrow,
       vpRobust &robust_lines, vpRobust &robust_cylinders, vpRobust &robust_circles,
       vpColVector &w_lines, vpColVector &w_cylinders, vpColVector &w_circles,
       vpColVector &error_lines, vpColVector &error_cylinders, vpColVector &error_circles,
@@ -513,7 +574,10 @@ protected:
   virtual void initFaceFromLines(vpMbtPolygon &polygon);
   unsigned int initMbtTracking(unsigned int &nberrors_lines, unsigned int &nberrors_cylinders, unsigned int &nberrors_circles);
   void initMovingEdge(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &_cMo) ;
+  void findLines(const unsigned int scale, const vpPoint &P1, const vpPoint &P2, std::vector<vpMbtDistanceLine*> &found);
+  void indexLine(const unsigned int scale, vpMbtDistanceLine *l);
   void initPyramid(const vpImage<unsigned char>& _I, std::vector<const vpImage<unsigned char>* >& _pyramid);
+  void predictMovingEdge();
   void reInitLevel(const unsigned int _lvl);
   void reinitMovingEdge(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &_cMo);
   void removeCircle(const std::string& name);
@@ -522,6 +586,7 @@ protected:
   void resetMovingEdge();
   void testTracking();
   void trackMovingEdge(const vpImage<unsigned char> &I) ;
+  void updateFeatureBudget();
   void updateMovingEdge(const vpImage<unsigned char> &I) ;
   void updateMovingEdgeWeights();
   void upScale(const unsigned int _scale); 
@@ -51,6 +51,7 @@
   #include <visp3/ar/vpAROgre.h>
 #endif
 
+#include <algorithm>
 #include <vector>
 #include <limits>
 
@@ -71,6 +72,36 @@ class vpMbHiddenFaces
   //! Number of visible polygon
   unsigned int nbVisiblePolygon;
   vpMbScanLine scanlineRender;
+  //! Clipped polygons given to the scanline renderer, kept from one rendering to the next
+  std::vector<std::vector<std::pair<vpPoint, unsigned int> > > scanlinePolygons;
+
+  //! Node of the bounding volume hierarchy used to cull back-facing polygons
+  struct vpCullingNode
+  {
+    //! Bounding sphere of the centers of the polygons of the node (object frame)
+    double center[3];
+    double radius;
+    //! Range of the inverse of the number of points of the polygons of the node
+    double minInvNbPoint;
+    double maxInvNbPoint;
+    //! Cone containing the normals of the polygons of the node (object frame)
+    double axis[3];
+    double coneAngle;
+    //! Range [first, last[ of the polygons of the node in cullingFaces
+    unsigned int first;
+    unsigned int last;
+    //! Children of the node, 0 for a leaf
+    unsigned int left;
+    unsigned int right;
+  };
+  //! Nodes of the culling hierarchy, the root is the first one
+  std::vector<vpCullingNode> cullingNodes;
+  //! Indexes of the polygons sorted by node
+  std::vector<unsigned int> cullingFaces;
+  //! Indexes of the polygons that cannot be culled (lines, non oriented or degenerated faces)
+  std::vector<unsigned int> uncullableFaces;
+  //! Indicates if the culling hierarchy has to be rebuilt
+  bool cullingModified;
   
 #ifdef VISP_HAVE_OGRE
   vpImage<unsigned char> ogreBackground;
@@ -88,6 +119,21 @@ class vpMbHiddenFaces
                            const vpImage<unsigned char> &I = vpImage<unsigned char>(),
                            const vpCameraParameters &cam = vpCameraParameters()) ;
 
+  void          buildCullingHierarchy();
+  unsigned int  buildCullingNode(const unsigned int first, const unsigned int last,
+                                 const std::vector<double> &centers, const std::vector<double> &normals);
+
+  //! Sort the polygons indexes along one coordinate of a per polygon 3D vector
+  struct vpCullingCompare
+  {
+    const std::vector<double> *values;
+    unsigned int dim;
+    bool operator()(const unsigned int a, const unsigned int b) const
+    {
+      return (*values)[3*a+dim] < (*values)[3*b+dim];
+    }
+  };
+
   public :
                     vpMbHiddenFaces() ;
                   ~vpMbHiddenFaces() ;
@@ -110,6 +156,7 @@ class vpMbHiddenFaces
                               std::vector<std::pair<vpPoint, vpPoint> > &lines, const bool &displayResults = false);
 
     vpMbScanLine& getMbScanLineRenderer() { return scanlineRender; }
+    const vpMbScanLine& getMbScanLineRenderer() const { return scanlineRender; }
 
 #ifdef VISP_HAVE_OGRE
     void          displayOgre(const vpHomogeneousMatrix &cMo);
@@ -259,7 +306,8 @@ class vpMbHiddenFaces
 */
 template<class PolygonType>
 vpMbHiddenFaces<PolygonType>::vpMbHiddenFaces()
-  : Lpol(), nbVisiblePolygon(0), scanlineRender()
+  : Lpol(), nbVisiblePolygon(0), scanlineRender(), scanlinePolygons(),
+    cullingNodes(), cullingFaces(), uncullableFaces(), cullingModified(true)
 {
 #ifdef VISP_HAVE_OGRE
   ogreInitialised = false;
@@ -325,6 +373,7 @@ vpMbHiddenFaces<PolygonType>::addPolygon(PolygonType *p)
   for(unsigned int i = 0; i < p->nbpt; i++)
     p_new->p[i]= p->p[i];
   Lpol.push_back(p_new);
+  cullingModified = true;
 }
 
 /*!
@@ -335,6 +384,7 @@ void
 vpMbHiddenFaces<PolygonType>::reset()
 {
   nbVisiblePolygon = 0;
+  cullingModified = true;
   for(unsigned int i = 0 ; i < Lpol.size() ; i++){
     if (Lpol[i]!=NULL){
       delete Lpol[i] ;
@@ -398,7 +448,8 @@ vpMbHiddenFaces<PolygonType>::computeClippedPolygons(const vpHomogeneousMatrix &
 template<class PolygonType>
 void
 vpMbHiddenFaces<PolygonType>::computeScanLineRender(const vpCameraParameters &cam, const unsigned int &w, const unsigned int &h){
-  std::vector<std::vector<std::pair<vpPoint, unsigned int> > > polyClipped(Lpol.size());
+  // The clipped polygons are copied over the previous ones to reuse their storage
+  scanlinePolygons.resize(Lpol.size());
   std::vector<std::vector<std::pair<vpPoint, unsigned int> > * > listPolyClipped;
   std::vector<int> listPolyIndices;
 
@@ -407,11 +458,10 @@ vpMbHiddenFaces<PolygonType>::computeScanLineRender(const vpCameraParameters &ca
     // However using all of them gives us the possibility to return more information in the scanline visibility results
 //    if(Lpol[i]->isVisible())
     {
-      polyClipped[i].clear();
-      Lpol[i]->getPolygonClipped(polyClipped[i]);
-      if(polyClipped[i].size() != 0)
+      Lpol[i]->getPolygonClipped(scanlinePolygons[i]);
+      if(scanlinePolygons[i].size() != 0)
       {
-        listPolyClipped.push_back(&polyClipped[i]);
+        listPolyClipped.push_back(&scanlinePolygons[i]);
         listPolyIndices.push_back(Lpol[i]->getIndex());
       }
     }
@@ -441,6 +491,11 @@ vpMbHiddenFaces<PolygonType>::computeScanLineQuery(const vpPoint &a, const vpPoi
 
 /*!
   Compute the number of visible polygons.
+
+  Without Ogre, the oriented faces are tested through a bounding volume
+  hierarchy: the groups of faces that are all turned away from the camera are
+  set as not visible without testing each face. The faces of these groups are
+  not moved in the camera frame.
   
   \param cMo : The pose of the camera
   \param angleAppears : Angle used to test the appearance of a face
@@ -475,14 +530,249 @@ vpMbHiddenFaces<PolygonType>::setVisiblePrivate(const vpHomogeneousMatrix &cMo,
 #endif
   }
   
-  for (unsigned int i = 0; i < Lpol.size(); i++){
-    //std::cout << "Calling poly: " << i << std::endl;
-    if (computeVisibility(cMo, angleAppears, angleDisappears, changed, useOgre, testRoi, I, cam, cameraPos, i))
+  if(useOgre){
+    for (unsigned int i = 0; i < Lpol.size(); i++){
+      //std::cout << "Calling poly: " << i << std::endl;
+      if (computeVisibility(cMo, angleAppears, angleDisappears, changed, useOgre, testRoi, I, cam, cameraPos, i))
+        nbVisiblePolygon ++;
+    }
+    return nbVisiblePolygon;
+  }
+
+  if(cullingModified)
+    buildCullingHierarchy();
+
+  for (unsigned int i = 0; i < uncullableFaces.size(); i++){
+    if (computeVisibility(cMo, angleAppears, angleDisappears, changed, useOgre, testRoi, I, cam, cameraPos, uncullableFaces[i]))
       nbVisiblePolygon ++;
   }
+
+  if(cullingNodes.empty())
+    return nbVisiblePolygon;
+
+  // Position and optical axis of the camera in the object frame
+  double camPos[3], camAxis[3];
+  for (unsigned int i = 0; i < 3; i++){
+    camPos[i] = -(cMo[0][i]*cMo[0][3] + cMo[1][i]*cMo[1][3] + cMo[2][i]*cMo[2][3]);
+    camAxis[i] = cMo[2][i];
+  }
+
+  // A polygon is neither visible nor appearing when the angle between its
+  // normal and the direction of the camera is above the threshold plus one
+  // degree (see vpMbtPolygon::isVisible()). The angle between any normal of a
+  // node and the direction of the camera seen from any polygon of the node
+  // is bounded below by the angle between the cone axis and the direction of
+  // the camera, minus the cone half angle and the half angle under which the
+  // bounding sphere is seen.
+  // vpMbtPolygon::isVisible() measures the direction of the camera from the
+  // center of the polygon shifted by 1/nbpt along the optical axis, so the
+  // bounding sphere is enlarged to contain all these shifted centers.
+  double threshold = (std::max)(angleAppears, angleDisappears) + vpMath::rad(1) + 1e-6;
+
+  std::vector<unsigned int> stack;
+  stack.push_back(0);
+  while(!stack.empty()){
+    const vpCullingNode &node = cullingNodes[stack.back()];
+    stack.pop_back();
+
+    bool culled = false;
+    if(node.coneAngle < M_PI){
+      double shift = (node.minInvNbPoint + node.maxInvNbPoint) / 2.;
+      double radius = node.radius + (node.maxInvNbPoint - node.minInvNbPoint) / 2.;
+      double w[3];
+      for (unsigned int k = 0; k < 3; k++)
+        w[k] = camPos[k] - node.center[k] - shift*camAxis[k];
+      double d = sqrt(w[0]*w[0] + w[1]*w[1] + w[2]*w[2]);
+      if(d > radius){
+        double cosBeta = (node.axis[0]*w[0] + node.axis[1]*w[1] + node.axis[2]*w[2]) / d;
+        double beta = acos((std::max)(-1.0, (std::min)(1.0, cosBeta)));
+        culled = (beta - node.coneAngle - asin(radius / d) > threshold);
+      }
+    }
+
+    if(culled){
+      for (unsigned int k = node.first; k < node.last; k++){
+        PolygonType *poly = Lpol[cullingFaces[k]];
+        poly->isappearing = false;
+        if(poly->isvisible)
+          changed = true;
+        poly->isvisible = false;
+      }
+    }
+    else if(node.left == 0){
+      for (unsigned int k = node.first; k < node.last; k++){
+        if (computeVisibility(cMo, angleAppears, angleDisappears, changed, useOgre, testRoi, I, cam, cameraPos, cullingFaces[k]))
+          nbVisiblePolygon ++;
+      }
+    }
+    else{
+      stack.push_back(node.right);
+      stack.push_back(node.left);
+    }
+  }
+
   return nbVisiblePolygon;
 }
 
+/*!
+  Build the bounding volume hierarchy used by setVisible() to skip the
+  polygons that face away from the camera. Each node stores a bounding
+  sphere of the centers of its polygons and a cone containing their normals.
+  The hierarchy is rebuilt after a polygon has been added or after reset().
+*/
+template<class PolygonType>
+void
+vpMbHiddenFaces<PolygonType>::buildCullingHierarchy()
+{
+  cullingNodes.clear();
+  cullingFaces.clear();
+  uncullableFaces.clear();
+
+  std::vector<double> centers(3*Lpol.size(), 0.);
+  std::vector<double> normals(3*Lpol.size(), 0.);
+  for (unsigned int i = 0; i < Lpol.size(); i++){
+    PolygonType *poly = Lpol[i];
+    unsigned int nbpt = poly->getNbPoint();
+    if(nbpt <= 2 || !poly->isPolygonOriented()){
+      uncullableFaces.push_back(i);
+      continue;
+    }
+
+    // Newell's method, as in vpMbtPolygon::isVisible()
+    double *n = &normals[3*i];
+    double *c = &centers[3*i];
+    for (unsigned int k = 0; k < nbpt; k++){
+      const vpPoint &cur = poly->p[k];
+      const vpPoint &next = poly->p[(k+1) % nbpt];
+      n[0] += (cur.get_oY() - next.get_oY()) * (cur.get_oZ() + next.get_oZ());
+      n[1] += (cur.get_oZ() - next.get_oZ()) * (cur.get_oX() + next.get_oX());
+      n[2] += (cur.get_oX() - next.get_oX()) * (cur.get_oY() + next.get_oY());
+      c[0] += cur.get_oX();
+      c[1] += cur.get_oY();
+      c[2] += cur.get_oZ();
+    }
+    double norm = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+    if(norm <= std::numeric_limits<double>::epsilon()){
+      uncullableFaces.push_back(i);
+      continue;
+    }
+    for (unsigned int k = 0; k < 3; k++){
+      n[k] /= norm;
+      c[k] /= (double)nbpt;
+    }
+    cullingFaces.push_back(i);
+  }
+
+  if(!cullingFaces.empty())
+    buildCullingNode(0, (unsigned int)cullingFaces.size(), centers, normals);
+
+  cullingModified = false;
+}
+
+/*!
+  Create the node containing the polygons cullingFaces[first] to
+  cullingFaces[last-1] and its children.
+
+  \param first : Index of the first polygon of the node in cullingFaces.
+  \param last : Index following the last polygon of the node in cullingFaces.
+  \param centers : Centers of the polygons in the object frame.
+  \param normals : Unit normals of the polygons in the object frame.
+
+  
+eturn Index of the node in cullingNodes.
+*/
+template<class PolygonType>
+unsigned int
+vpMbHiddenFaces<PolygonType>::buildCullingNode(const unsigned int first, const unsigned int last,
+                                               const std::vector<double> &centers,
+                                               const std::vector<double> &normals)
+{
+  unsigned int index = (unsigned int)cullingNodes.size();
+  cullingNodes.push_back(vpCullingNode());
+
+  vpCullingNode node;
+  node.first = first;
+  node.last = last;
+  node.left = 0;
+  node.right = 0;
+
+  double cmin[3], cmax[3], nmin[3], nmax[3];
+  for (unsigned int k = 0; k < 3; k++){
+    node.center[k] = 0.;
+    node.axis[k] = 0.;
+    cmin[k] = nmin[k] = std::numeric_limits<double>::max();
+    cmax[k] = nmax[k] = -std::numeric_limits<double>::max();
+  }
+  for (unsigned int i = first; i < last; i++){
+    const double *c = &centers[3*cullingFaces[i]];
+    const double *n = &normals[3*cullingFaces[i]];
+    for (unsigned int k = 0; k < 3; k++){
+      node.center[k] += c[k];
+      node.axis[k] += n[k];
+      cmin[k] = (std::min)(cmin[k], c[k]);
+      cmax[k] = (std::max)(cmax[k], c[k]);
+      nmin[k] = (std::min)(nmin[k], n[k]);
+      nmax[k] = (std::max)(nmax[k], n[k]);
+    }
+  }
+  for (unsigned int k = 0; k < 3; k++)
+    node.center[k] /= (double)(last - first);
+
+  node.radius = 0.;
+  node.minInvNbPoint = 1.;
+  node.maxInvNbPoint = 0.;
+  for (unsigned int i = first; i < last; i++){
+    const double *c = &centers[3*cullingFaces[i]];
+    double d = sqrt(vpMath::sqr(c[0]-node.center[0]) + vpMath::sqr(c[1]-node.center[1]) + vpMath::sqr(c[2]-node.center[2]));
+    node.radius = (std::max)(node.radius, d);
+    double invNbPoint = 1. / (double)Lpol[cullingFaces[i]]->getNbPoint();
+    node.minInvNbPoint = (std::min)(node.minInvNbPoint, invNbPoint);
+    node.maxInvNbPoint = (std::max)(node.maxInvNbPoint, invNbPoint);
+  }
+
+  double norm = sqrt(node.axis[0]*node.axis[0] + node.axis[1]*node.axis[1] + node.axis[2]*node.axis[2]);
+  if(norm > 1e-6){
+    node.coneAngle = 0.;
+    for (unsigned int k = 0; k < 3; k++)
+      node.axis[k] /= norm;
+    for (unsigned int i = first; i < last; i++){
+      const double *n = &normals[3*cullingFaces[i]];
+      double cosAngle = node.axis[0]*n[0] + node.axis[1]*n[1] + node.axis[2]*n[2];
+      node.coneAngle = (std::max)(node.coneAngle, acos((std::max)(-1.0, (std::min)(1.0, cosAngle))));
+    }
+  }
+  else{
+    // The normals are spread in all the directions, the node cannot be culled
+    node.coneAngle = M_PI;
+  }
+
+  const unsigned int leafSize = 8;
+  if(last - first > leafSize){
+    // Group the polygons by orientation while the normals are spread, then by position
+    vpCullingCompare compare;
+    const double *vmin = cmin, *vmax = cmax;
+    compare.values = &centers;
+    if(node.coneAngle > M_PI/4.){
+      vmin = nmin;
+      vmax = nmax;
+      compare.values = &normals;
+    }
+    compare.dim = 0;
+    for (unsigned int k = 1; k < 3; k++){
+      if(vmax[k] - vmin[k] > vmax[compare.dim] - vmin[compare.dim])
+        compare.dim = k;
+    }
+
+    unsigned int middle = (first + last) / 2;
+    std::nth_element(cullingFaces.begin() + first, cullingFaces.begin() + middle, cullingFaces.begin() + last, compare);
+    node.left = buildCullingNode(first, middle, centers, normals);
+    node.right = buildCullingNode(middle, last, centers, normals);
+  }
+
+  cullingNodes[index] = node;
+  return index;
+}
+
 /*!
   Compute the visibility of a given face index.
 
@@ -50,7 +50,7 @@
 
 #include <visp3/core/vpConfig.h>
 
-#if (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 #include <visp3/mbt/vpMbKltTracker.h>
 
@@ -58,7 +58,8 @@
 /*!
   \class vpMbKltMultiTracker
   \ingroup group_mbt_trackers
-  \warning This class is only available if OpenCV is installed, and used.
+  \note The KLT features are tracked with vpKltOpencv or vpKltNative (see
+  vpMbKltTracker::setKltBackend()).
 
   \brief Model based stereo (or more) tracker using only KLT.
 
@@ -81,6 +82,9 @@ protected:
   //! Name of the reference camera
   std::string m_referenceCameraName;
 
+  //! Flag to process the cameras in parallel
+  bool m_camerasThreaded;
+
 public:
   vpMbKltMultiTracker();
   vpMbKltMultiTracker(const unsigned int nbCameras);
@@ -118,6 +122,13 @@ public:
 
   virtual std::vector<std::string> getCameraNames() const;
 
+  /*!
+    Return true if the cameras are processed in parallel.
+
+    \sa setCamerasThreaded()
+  */
+  inline bool getCamerasThreaded() const { return m_camerasThreaded; }
+
   virtual void getCameraParameters(vpCameraParameters &camera) const;
   virtual void getCameraParameters(vpCameraParameters &cam1, vpCameraParameters &cam2) const;
   virtual void getCameraParameters(const std::string &cameraName, vpCameraParameters &camera) const;
@@ -143,12 +154,15 @@ public:
 
   virtual std::map<std::string, std::map<int, vpImagePoint> > getKltImagePointsWithId() const;
 
+  virtual std::map<std::string, vpKltNative> getKltNative() const;
+#if defined(VISP_HAVE_OPENCV)
   virtual std::map<std::string, vpKltOpencv> getKltOpencv() const;
 
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
   virtual std::map<std::string, std::vector<cv::Point2f> > getKltPoints() const;
-#else
+#  else
   virtual std::map<std::string, CvPoint2D32f*> getKltPoints();
+#  endif
 #endif
 
   virtual std::map<std::string, int> getNbKltPoints() const;
@@ -232,6 +246,20 @@ public:
 
   virtual void setCameraParameters(const std::map<std::string, vpCameraParameters> &mapOfCameraParameters);
 
+  /*!
+    Enable or disable the processing of the cameras in parallel. The KLT
+    points of each camera are tracked and their interaction matrix and error
+    vector are computed concurrently, the estimated pose does not depend on
+    this setting. This has an effect only if ViSP was built with OpenMP.
+
+    The visibility tests are done sequentially when Ogre is used
+    (see setOgreVisibilityTest()).
+
+    \param threaded : true to process the cameras in parallel. Default is
+    false.
+  */
+  virtual void setCamerasThreaded(const bool threaded) { m_camerasThreaded = threaded; }
+
   virtual void setCameraTransformationMatrix(const std::string &cameraName,
       const vpHomogeneousMatrix &cameraTransformationMatrix);
 
@@ -253,8 +281,17 @@ public:
   void setNbRayCastingAttemptsForVisibility(const unsigned int &attempts);
 #endif
 
+  virtual void setKltBackend(const vpMbtKltBackend backend);
+
+  virtual void setKltNative(const vpKltNative& t);
+  virtual void setKltNative(const std::map<std::string, vpKltNative> &mapOfKltTrackers);
+#if defined(VISP_HAVE_OPENCV)
   virtual void setKltOpencv(const vpKltOpencv& t);
   virtual void setKltOpencv(const std::map<std::string, vpKltOpencv> &mapOfOpenCVTrackers);
+#endif
+
+  virtual void setKltRedetection(const bool activate, const unsigned int cellSize=32, const unsigned int nbPoints=8,
+                                 const double timeBudget=2.0);
 
   virtual void setLod(const bool useLod, const std::string &name="");
   virtual void setLod(const bool useLod, const std::string &cameraName, const std::string &name);
@@ -267,6 +304,8 @@ public:
   virtual void setMinPolygonAreaThresh(const double minPolygonAreaThresh, const std::string &cameraName,
       const std::string &name);
 
+  virtual void setModelCacheDirectory(const std::string &directory);
+
   virtual void setNearClippingDistance(const double &dist);
   virtual void setNearClippingDistance(const std::string &cameraName, const double &dist);
 
@@ -276,6 +315,11 @@ public:
 
   virtual void setOptimizationMethod(const vpMbtOptimizationMethod &opt);
 
+  virtual void setPosePrediction(const vpMbtPosePredictionMethod &method);
+
+  virtual void setPosePredictionKalmanParameters(const double stateVariance, const double measureVariance,
+                                                 const double rho);
+
   virtual void setPose(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &cMo);
 
   virtual void setPose(const vpImage<unsigned char> &I1, const vpImage<unsigned char> &I2, const vpHomogeneousMatrix &c1Mo,
@@ -289,6 +333,8 @@ public:
 
   virtual void setReferenceCameraName(const std::string &referenceCameraName);
 
+  virtual void setScanLineThreaded(const bool threaded);
+
   virtual void setScanLineVisibilityTest(const bool &v);
 
   virtual void setThresholdAcceptation(const double th);
@@ -305,9 +351,11 @@ protected:
   //@{
   virtual void computeVVS(std::map<std::string, unsigned int> &mapOfNbInfos, vpColVector &w);
   virtual void computeVVSWeights(const unsigned int iter, const unsigned int nbInfos,
-      std::map<std::string, unsigned int> &mapOfNbInfos, vpColVector &R, vpColVector &w_true, vpColVector &w,
+      std::map<std::string, unsigned int> &mapOfNbInfos, vpColVector &R, vpColVector &w,
       std::map<std::string, vpRobust> &mapOfRobusts, double threshold);
 
+  void predictKltPoints();
+
   virtual void preTracking(std::map<std::string, const vpImage<unsigned char> *> &mapOfImages,
       std::map<std::string, unsigned int> &mapOfNbInfos,
       std::map<std::string, unsigned int> &mapOfNbFaceUsed);
@@ -319,5 +367,5 @@ protected:
   //@}
 };
 
-#endif // VISP_HAVE_OPENCV
+#endif // VISP_HAVE_MODULE_KLT
 #endif //__vpMbKltMultiTracker_h__
@@ -45,10 +45,13 @@
 
 #include <visp3/core/vpConfig.h>
 
-#if defined(VISP_HAVE_MODULE_KLT) && (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 #include <visp3/mbt/vpMbTracker.h>
-#include <visp3/klt/vpKltOpencv.h>
+#include <visp3/klt/vpKltNative.h>
+#if defined(VISP_HAVE_OPENCV)
+#  include <visp3/klt/vpKltOpencv.h>
+#endif
 #include <visp3/core/vpMeterPixelConversion.h>
 #include <visp3/core/vpPixelMeterConversion.h>
 #include <visp3/mbt/vpMbtKltXmlParser.h>
@@ -60,11 +63,14 @@
 #include <visp3/mbt/vpMbtDistanceKltPoints.h>
 #include <visp3/mbt/vpMbtDistanceCircle.h>
 #include <visp3/mbt/vpMbtDistanceKltCylinder.h>
+#include <visp3/mbt/vpMbtVVSSolver.h>
 
 /*!
   \class vpMbKltTracker
   \ingroup group_mbt_trackers
-  \warning This class is only available if OpenCV is installed, and used.
+  \note The KLT features are detected and tracked either with vpKltOpencv
+  or with vpKltNative, which does not depend on OpenCV (see setKltBackend()).
+  vpKltOpencv is used by default when OpenCV is available.
   
   \brief Model based tracker using only KLT.
 
@@ -228,12 +234,24 @@ class VISP_EXPORT vpMbKltTracker: virtual public vpMbTracker
   friend class vpMbKltMultiTracker;
   friend class vpMbEdgeKltMultiTracker;
 
+public:
+  /*!
+    Implementation of the KLT tracker used to detect and track the points
+    (see setKltBackend()).
+  */
+  typedef enum {
+    NATIVE_KLT,  /*!< vpKltNative, always available. */
+    OPENCV_KLT   /*!< vpKltOpencv, only available with OpenCV. */
+  } vpMbtKltBackend;
+
 protected:
+#if defined(VISP_HAVE_OPENCV)
   //! Temporary OpenCV image for fast conversion.
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
   cv::Mat cur;
-#else
+#  else
   IplImage *cur;
+#  endif
 #endif
   //! Initial pose.
   vpHomogeneousMatrix c0Mo;
@@ -253,14 +271,30 @@ protected:
   double percentGood;
   //! The estimated displacement of the pose between the current instant and the initial position.
   vpHomogeneousMatrix ctTc0;
+#if defined(VISP_HAVE_OPENCV)
   //! Points tracker.
   vpKltOpencv tracker;
+#endif
+  //! Points tracker that does not depend on OpenCV.
+  vpKltNative m_kltNative;
+  //! Implementation of the KLT tracker used to track the points.
+  vpMbtKltBackend m_kltBackend;
   //!
   std::list<vpMbtDistanceKltPoints*> kltPolygons;
   //!
   std::list<vpMbtDistanceKltCylinder*> kltCylinders;
   //! Vector of the circles used here only to display the full model.
   std::list<vpMbtDistanceCircle*> circles_disp;
+  //! If true, new KLT points are detected where they were lost after each tracking step (see setKltRedetection()).
+  bool kltRedetection;
+  //! Size in pixel of the cells of the redetection grid.
+  unsigned int kltRedetectionCellSize;
+  //! Number of KLT points wanted in a cell of the redetection grid.
+  unsigned int kltRedetectionNbPoints;
+  //! Maximal time in ms spent in the redetection at each tracking step.
+  double kltRedetectionTimeBudget;
+  //! Cell of the redetection grid where the next redetection starts.
+  unsigned int kltRedetectionCell;
 
 public:
   vpMbKltTracker();
@@ -284,14 +318,18 @@ public:
   virtual std::list<vpMbtDistanceKltPoints*> &getFeaturesKlt() { return kltPolygons; }
 
   /*!
-    Get the current list of KLT points.
-            
-     \return the list of KLT points through vpKltOpencv.
+    Get the implementation of the KLT tracker used to track the points.
+
+    \return NATIVE_KLT or OPENCV_KLT.
    */
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
-  inline  std::vector<cv::Point2f> getKltPoints() const {return tracker.getFeatures();}
-#else
-  inline  CvPoint2D32f*   getKltPoints() {return tracker.getFeatures();}
+  inline  vpMbtKltBackend getKltBackend() const { return m_kltBackend; }
+
+#if defined(VISP_HAVE_OPENCV)
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+  std::vector<cv::Point2f> getKltPoints() const;
+#  else
+  CvPoint2D32f* getKltPoints();
+#  endif
 #endif
   
   std::vector<vpImagePoint> getKltImagePoints() const;
@@ -299,11 +337,20 @@ public:
   std::map<int, vpImagePoint> getKltImagePointsWithId() const;
 
   /*!
-    Get the klt tracker at the current state.
+    Get the native klt tracker at the current state.
+
+    \return klt tracker.
+   */
+  inline  vpKltNative getKltNative() const { return m_kltNative; }
+
+#if defined(VISP_HAVE_OPENCV)
+  /*!
+    Get the OpenCV klt tracker at the current state.
             
     \return klt tracker.
    */
   inline  vpKltOpencv getKltOpencv() const { return tracker; }
+#endif
 
   /*!
     Get the value of the gain used to compute the control law.
@@ -331,7 +378,13 @@ public:
             
     \return the number of features
    */
-  inline  int  getNbKltPoints() const {return tracker.getNbFeatures();}
+  inline  int  getNbKltPoints() const {
+#if defined(VISP_HAVE_OPENCV)
+    if(m_kltBackend == OPENCV_KLT)
+      return tracker.getNbFeatures();
+#endif
+    return m_kltNative.getNbFeatures();
+  }
 
   /*!
     Get the threshold for the acceptation of a point.
@@ -351,7 +404,15 @@ public:
 
   void setCameraParameters(const vpCameraParameters& cam);
 
+  virtual void setKltBackend(const vpMbtKltBackend backend);
+
+  virtual void setKltNative(const vpKltNative& t);
+#if defined(VISP_HAVE_OPENCV)
   virtual void setKltOpencv(const vpKltOpencv& t);
+#endif
+
+  virtual void setKltRedetection(const bool activate, const unsigned int cellSize=32, const unsigned int nbPoints=8,
+                                 const double timeBudget=2.0);
 
   /*!
     Set the value of the gain used to compute the control law.
@@ -432,20 +493,14 @@ protected:
   /** @name Protected Member Functions Inherited from vpMbKltTracker */
   //@{
   void computeVVS(const unsigned int &nbInfos, vpColVector &w);
-  void computeVVSCheckLevenbergMarquardtKlt(const unsigned int iter, const unsigned int nbInfos,
-                                            const vpHomogeneousMatrix &cMoPrev, const vpColVector &error_prev, const vpHomogeneousMatrix &ctTc0_Prev,
-                                            double &mu, bool &reStartFromLastIncrement);
-  void computeVVSCovariance(const vpColVector &w_true, const vpHomogeneousMatrix &cMoPrev,
-                            const vpMatrix &L_true, const vpMatrix &LVJ_true);
+  void computeVVSCovariance(const vpColVector &w_true, const vpHomogeneousMatrix &cMoPrev, const vpMatrix &L_true);
   void computeVVSInteractionMatrixAndResidu(unsigned int shift, vpColVector &R, vpMatrix &L, vpHomography &H,
                                             std::list<vpMbtDistanceKltPoints*> &kltPolygons_, std::list<vpMbtDistanceKltCylinder*> &kltCylinders_,
                                             const vpHomogeneousMatrix &ctTc0_);
-  void computeVVSPoseEstimation(const unsigned int iter, vpMatrix &L,
-                                const vpColVector &w, vpMatrix &L_true, vpMatrix &LVJ_true, double &normRes, double &normRes_1, vpColVector &w_true,
-                                vpColVector &R, vpMatrix &LTL, vpColVector &LTR, vpColVector &error_prev, vpColVector &v, double &mu,
+  void computeVVSPoseEstimation(vpMbtVVSSolver &solver, const vpMatrix &L, const vpColVector &w, vpMatrix &L_true,
                                 vpHomogeneousMatrix &cMoPrev, vpHomogeneousMatrix &ctTc0_Prev);
   void computeVVSWeights(const unsigned int iter, const unsigned int nbInfos, const vpColVector &R,
-                         vpColVector &w_true, vpColVector &w, vpRobust &robust);
+                         vpColVector &w, vpRobust &robust);
 
   virtual void init(const vpImage<unsigned char>& I);
   virtual void initFaceFromCorners(vpMbtPolygon &polygon);
@@ -455,11 +510,13 @@ protected:
   virtual void initCylinder(const vpPoint&, const vpPoint &, const double, const int,
                             const std::string &name="");
 
+  void predictKltPoints();
   void preTracking(const vpImage<unsigned char>& I, unsigned int &nbInfos, unsigned int &nbFaceUsed);
   bool postTracking(const vpImage<unsigned char>& I, vpColVector &w);
+  void redetectKltPoints(const vpImage<unsigned char>& I);
   virtual void reinit(const vpImage<unsigned char>& I);
   //@}
 };
 
 #endif
-#endif // VISP_HAVE_OPENCV
+#endif // VISP_HAVE_MODULE_KLT
@@ -83,9 +83,9 @@ public:
   //! Structure to define a scanline intersection.
   struct vpMbScanLineSegment
   {
-    vpMbScanLineSegment() : type(START), edge(), p(0), P1(0), P2(0), Z1(0), Z2(0), ID(0), b_sample_Y(false) {};
+    vpMbScanLineSegment() : type(START), edge(0), p(0), P1(0), P2(0), Z1(0), Z2(0), ID(0), b_sample_Y(false) {};
     vpMbScanLineType type;
-    vpMbScanLineEdge edge;
+    unsigned int edge; // Index of the edge in the table of the edges of the scene.
     double p; // This value can be either x or y-coordinate value depending if the structure is used in X or Y-axis scanlines computation.
     double P1, P2; // Same comment as previous value.
     double Z1, Z2;
@@ -133,8 +133,22 @@ private:
   unsigned int            maskBorder;
   vpImage<unsigned char>  mask;
   vpImage<int>            primitive_ids;
-  std::map<vpMbScanLineEdge, std::set<int>, vpMbScanLineEdgeComparator> visibility_samples;
+  std::map<vpMbScanLineEdge, unsigned int, vpMbScanLineEdgeComparator> edge_indices;
+  std::vector<std::vector<int> > visibility_samples;
   double                  depthTreshold;
+  bool                    threaded;
+
+  // Storage reused from one rendering to the next to avoid reallocations
+  std::vector<unsigned int> polygon_edges;
+  std::vector<unsigned int> polygon_edges_offsets;
+  std::vector<std::vector<vpMbScanLineSegment> > scanlinesY;
+  std::vector<std::vector<vpMbScanLineSegment> > scanlinesX;
+  std::vector<std::vector<vpMbScanLineSegment> > local_scanlinesY;
+  std::vector<std::vector<vpMbScanLineSegment> > local_scanlinesX;
+  std::vector<std::vector<int> > visibility_samplesY;
+  std::vector<std::vector<int> > visibility_samplesX;
+  vpImage<unsigned char>  maskY;
+  vpImage<unsigned char>  maskX;
 
 public:
 #if defined(DEBUG_DISP)
@@ -158,6 +172,10 @@ public:
   */
   double                        getDepthTreshold() { return depthTreshold; }
   unsigned int                  getMaskBorder() { return maskBorder; }
+  /*!
+    \return true if the scanlines along both axes are rendered in parallel.
+  */
+  bool                          getThreaded() const { return threaded; }
   const vpImage<unsigned char>& getMask() const  { return mask; }
   const vpImage<int>&           getPrimitiveIDs() const  { return primitive_ids; }
 
@@ -173,36 +191,55 @@ public:
   */
   void                          setDepthTreshold(const double &treshold) { depthTreshold = treshold; }
   void                          setMaskBorder(const unsigned int &mb){ maskBorder = mb; }
+  /*!
+    Enable or disable the rendering of the scanlines along both axes in two
+    OpenMP sections. It only pays off for scenes of several thousands of
+    polygons, and it is skipped when drawScene() is already called from a
+    parallel region. This setting has no effect if ViSP is built without
+    OpenMP.
+
+    \param thread : true to render both axes in parallel. Default is false.
+  */
+  void                          setThreaded(const bool thread) { threaded = thread; }
 
 
 private:
   void createScanLinesFromLocals(std::vector<std::vector<vpMbScanLineSegment> > &scanlines,
                                  std::vector<std::vector<vpMbScanLineSegment> > &localScanlines,
-                                 const unsigned int &size);
+                                 const unsigned int &first, const unsigned int &last);
 
-  void drawLineY(const vpColVector &a,
-                 const vpColVector &b,
-                 const vpMbScanLineEdge &line_ID,
+  void drawLineY(const double a[3],
+                 const double b[3],
+                 const unsigned int edge,
                  const int ID,
                  std::vector<std::vector<vpMbScanLineSegment> > &scanlines);
 
-  void drawLineX(const vpColVector &a,
-                 const vpColVector &b,
-                 const vpMbScanLineEdge &line_ID,
+  void drawLineX(const double a[3],
+                 const double b[3],
+                 const unsigned int edge,
                  const int ID,
                  std::vector<std::vector<vpMbScanLineSegment> > &scanlines);
 
   void drawPolygonY(const std::vector<std::pair<vpPoint, unsigned int> > &polygon,
+                    const unsigned int *edges,
                     const int ID,
                     std::vector<std::vector<vpMbScanLineSegment> > &scanlines);
 
   void drawPolygonX(const std::vector<std::pair<vpPoint, unsigned int> > &polygon,
+                    const unsigned int *edges,
                     const int ID,
                     std::vector<std::vector<vpMbScanLineSegment> > &scanlines);
 
+  unsigned int getEdgeIndex(const vpPoint &a, const vpPoint &b);
+
+  void renderY(const std::vector<std::vector<std::pair<vpPoint, unsigned int> > * > &polygons,
+               const std::vector<int> &listPolyIndices);
+  void renderX(const std::vector<std::vector<std::pair<vpPoint, unsigned int> > * > &polygons,
+               const std::vector<int> &listPolyIndices);
+
   // Static functions
   static vpMbScanLineEdge makeMbScanLineEdge(const vpPoint &a, const vpPoint &b);
-  static void             createVectorFromPoint(const vpPoint &p, vpColVector &v, const vpCameraParameters &K);
+  static void             createVectorFromPoint(const vpPoint &p, double v[3], const vpCameraParameters &K);
   static double           getAlpha(double x, double X0, double Z0, double X1, double Z1);
   static double           mix(double a, double b, double alpha);
   static vpPoint          mix(const vpPoint &a, const vpPoint &b, double alpha);
@@ -66,6 +66,9 @@
 #include <visp3/mbt/vpMbtPolygon.h>
 #include <visp3/mbt/vpMbHiddenFaces.h>
 #include <visp3/core/vpPolygon.h>
+#include <visp3/core/vpBinaryArchive.h>
+#include <visp3/core/vpLinearKalmanFilterInstantiation.h>
+#include <visp3/mbt/vpMbtKeyFrameDatabase.h>
 
 #ifdef VISP_HAVE_COIN3D
 //Work around to avoid type redefinition int8_t with Coin
@@ -108,6 +111,13 @@ public:
     LEVENBERG_MARQUARDT_OPT = 1
   } vpMbtOptimizationMethod;
 
+  //! Motion model used to predict the pose before the tracking of a new image
+  typedef enum {
+    NO_PREDICTION = 0,                /*!< The tracking starts from the previous pose. */
+    CONSTANT_VELOCITY_PREDICTION = 1, /*!< The last displacement of the camera is applied again. */
+    KALMAN_PREDICTION = 2             /*!< The displacement is predicted by a Kalman filter of the camera velocity. */
+  } vpMbtPosePredictionMethod;
+
 protected:
   //! The camera parameters.
   vpCameraParameters cam;
@@ -139,6 +149,36 @@ protected:
   vpColVector m_error;
   //! Optimization method used
   vpMbtOptimizationMethod m_optimizationMethod;
+  //! The pose minimization stops when the weighted residual varies by less than this threshold
+  double m_stopCriteriaResidual;
+  //! The pose minimization stops when the norm of the pose increment is below this threshold
+  double m_stopCriteriaIncrement;
+  //! Motion model used to predict the pose
+  vpMbtPosePredictionMethod m_posePrediction;
+  //! Kalman filter of the camera velocity (6 signals, constant velocity with colored noise)
+  vpLinearKalmanFilterInstantiation m_poseKalman;
+  //! Variance of the acceleration used by the Kalman filter
+  double m_poseKalmanStateVariance;
+  //! Variance of the measured velocity used by the Kalman filter
+  double m_poseKalmanMeasureVariance;
+  //! Correlation between successive accelerations used by the Kalman filter
+  double m_poseKalmanRho;
+  //! Pose at the end of the last successful tracking
+  vpHomogeneousMatrix m_cMoTracked;
+  //! True if m_cMoTracked is set
+  bool m_cMoTrackedValid;
+  //! Camera velocity (displacement per image) predicted by the motion model
+  vpColVector m_predictedVelocity;
+  //! True if m_predictedVelocity can be used
+  bool m_predictedVelocityValid;
+  //! Displacement of the camera given by setCameraVelocity(), applied to the next image
+  vpHomogeneousMatrix m_cameraDisplacement;
+  //! True if m_cameraDisplacement has to be applied to the next image
+  bool m_cameraDisplacementValid;
+  //! Keyframes used to relocalize the tracker
+  vpMbtKeyFrameDatabase m_keyFrameDatabase;
+  //! True if keyframes are recorded after each successful tracking
+  bool m_keyFrameRecording;
 
   //! Set of faces describing the object.
   vpMbHiddenFaces<vpMbtPolygon> faces;
@@ -180,6 +220,33 @@ protected:
   //! Map with [map.first]=parameter_names and [map.second]=type (string, number or boolean)
   std::map<std::string, std::string> mapOfParameterNames;
 
+  //! Type of a primitive of the model, as stored in the binary model cache
+  typedef enum {
+    MODEL_FACE_FROM_LINES = 0,
+    MODEL_FACE_FROM_CORNERS = 1,
+    MODEL_CYLINDER = 2,
+    MODEL_CIRCLE = 3
+  } vpMbtModelPrimitiveType;
+
+  //! Primitive of the model, as stored in the binary model cache
+  struct vpMbtModelPrimitive
+  {
+    vpMbtModelPrimitiveType type;
+    //! Object frame coordinates (X, Y, Z) of the points of the primitive
+    std::vector<double> points;
+    int idFace;
+    std::string name;
+    bool useLod;
+    double minPolygonAreaThreshold;
+    double minLineLengthThreshold;
+    double radius;
+  };
+
+  //! Directory of the binary model cache, the cache is not used if empty
+  std::string modelCacheDirectory;
+  //! Primitives added while parsing a model, written in the binary model cache
+  std::vector<vpMbtModelPrimitive> modelPrimitives;
+
 public:
   vpMbTracker();
   virtual ~vpMbTracker();
@@ -247,6 +314,13 @@ public:
   /*! Return a reference to the faces structure. */
   virtual inline vpMbHiddenFaces<vpMbtPolygon>& getFaces() { return faces;}
 
+  /*!
+    Return a reference to the database of keyframes used by relocalize().
+
+    \sa setKeyFrameRecording()
+  */
+  inline vpMbtKeyFrameDatabase &getKeyFrameDatabase() { return m_keyFrameDatabase; }
+
   /*!
     Get the far distance for clipping.
 
@@ -320,6 +394,16 @@ public:
     return faces[index];
   }
 
+  /*!
+    Get the motion model used to predict the pose before the tracking of a
+    new image.
+
+    \return Pose prediction method.
+
+    \sa setPosePrediction()
+  */
+  inline vpMbtPosePredictionMethod getPosePrediction() const { return m_posePrediction; }
+
   virtual std::pair<std::vector<vpPolygon>, std::vector<std::vector<vpPoint> > > getPolygonFaces(const bool orderPolygons=true,
       const bool useVisibility=true);
 
@@ -341,6 +425,13 @@ public:
   */
   virtual inline vpHomogeneousMatrix getPose() const {return this->cMo;}
 
+  /*!
+    \return true if the scanline visibility test renders both image axes in parallel.
+
+    \sa setScanLineThreaded()
+  */
+  inline bool getScanLineThreaded() const { return faces.getMbScanLineRenderer().getThreaded(); }
+
   // Intializer
 
 #ifdef VISP_HAVE_MODULE_GUI
@@ -359,6 +450,19 @@ public:
   virtual void loadModel(const char *modelFile, const bool verbose=false);
   virtual void loadModel(const std::string &modelFile, const bool verbose=false);
 
+  /*!
+    Get the directory of the binary model cache.
+
+    \return The directory of the cache, empty if the cache is not used.
+
+    \sa setModelCacheDirectory()
+  */
+  virtual inline std::string getModelCacheDirectory() const { return modelCacheDirectory; }
+
+  virtual void loadState(vpBinaryArchive &ar);
+
+  virtual bool relocalize(const vpImage<unsigned char> &I);
+
   /*!
     Set the angle used to test polygons appearance.
     If the angle between the normal of the polygon and the line going
@@ -420,6 +524,8 @@ public:
 
   virtual void setMinPolygonAreaThresh(const double minPolygonAreaThresh, const std::string &name="");
 
+  virtual void setModelCacheDirectory(const std::string &directory);
+
   virtual void setNearClippingDistance(const double &dist);
 
   /*!
@@ -436,12 +542,66 @@ public:
   */
   virtual void setProjectionErrorComputation(const bool &flag) { computeProjError = flag; }
 
+  /*!
+    Enable or disable the parallel rendering of the scanline visibility test
+    (see setScanLineVisibilityTest()). The scanlines along both image axes
+    are then computed in two OpenMP sections, which only pays off for models
+    of several thousands of faces. The rendering stays sequential when it is
+    already called from a parallel region. This setting has no effect if ViSP
+    is built without OpenMP.
+
+    \param threaded : true to render both axes in parallel. Default is false.
+
+    \sa getScanLineThreaded()
+  */
+  virtual void setScanLineThreaded(const bool threaded) { faces.getMbScanLineRenderer().setThreaded(threaded); }
+
   virtual void setScanLineVisibilityTest(const bool &v){ useScanLine = v; }
 
+  /*!
+    Set the criteria that stop the minimization of the pose before the maximum
+    number of iterations.
+
+    \param residualThreshold : The minimization stops when the weighted
+    residual varies by less than this threshold between two iterations.
+    \param incrementThreshold : The minimization stops when the norm of the
+    pose increment is below this threshold. 0 to disable this criterion.
+
+    \sa vpMbtVVSSolver
+  */
+  virtual inline void setStopCriteria(const double residualThreshold, const double incrementThreshold) {
+    m_stopCriteriaResidual = residualThreshold;
+    m_stopCriteriaIncrement = incrementThreshold;
+  }
+
   virtual void setOgreVisibilityTest(const bool &v);
+
+  void setCameraVelocity(const vpColVector &v, const double dt);
+
+  /*!
+    Enable or disable the recording of keyframes. When enabled, a keyframe is
+    added to the keyframe database at the end of the tracking of an image if
+    the pose is far enough from the poses of the recorded keyframes. The
+    keyframes are used by relocalize().
+
+    \param record : True to record keyframes.
+
+    \note The multi-camera trackers do not record keyframes, but they can be
+    relocalized from a database filled by a single camera tracker.
+
+    \sa getKeyFrameDatabase()
+  */
+  inline void setKeyFrameRecording(const bool record) { m_keyFrameRecording = record; }
+
+  virtual void setPosePrediction(const vpMbtPosePredictionMethod &method);
+
+  virtual void setPosePredictionKalmanParameters(const double stateVariance, const double measureVariance,
+                                                 const double rho);
   
   void savePose(const std::string &filename) const;
 
+  virtual void saveState(vpBinaryArchive &ar) const;
+
 #ifdef VISP_HAVE_OGRE
   /*!
     Set the ratio of visibility attempts that has to be successful to consider a polygon as visible.
@@ -543,6 +703,8 @@ public:
   */
   virtual void resetTracker() = 0;
 
+  void resetPosePrediction();
+
   /*!
     Set the pose to be used in entry of the next call to the track() function.
     This pose will be just used once.
@@ -581,9 +743,21 @@ protected:
   void addPolygon(const std::vector<std::vector<vpPoint> > &listFaces, const int idFace=-1, const std::string &polygonName="",
       const bool useLod=false, const double minLineLengthThreshold=50);
 
+  void addModelCircle(const vpPoint& p1, const vpPoint &p2, const vpPoint &p3, const double radius, const int idFace,
+      const std::string &polygonName, const bool useLod, const double minPolygonAreaThreshold);
+  void addModelCylinder(const vpPoint& p1, const vpPoint &p2, const double radius, const int idFace,
+      const std::string &polygonName, const bool useLod, const double minLineLengthThreshold);
+  void addModelFace(const std::vector<vpPoint>& corners, const int idFace, const std::string &polygonName,
+      const bool useLod, const double minPolygonAreaThreshold, const double minLineLengthThreshold, const bool fromLines);
+
   void createCylinderBBox(const vpPoint& p1, const vpPoint &p2, const double &radius, std::vector<std::vector<vpPoint> > &listFaces);
 
   void computeJTR(const vpMatrix& J, const vpColVector& R, vpColVector& JTR) const;
+
+  void initPosePredictionKalman();
+  bool predictPose();
+  void recordKeyFrame(const vpImage<unsigned char> &I);
+  void updatePosePrediction();
   
 #ifdef VISP_HAVE_COIN3D
   virtual void extractGroup(SoVRMLGroup *sceneGraphVRML2, vpHomogeneousMatrix &transform, int &idFace);
@@ -637,6 +811,10 @@ protected:
   virtual void loadCAOModel(const std::string& modelFile, std::vector<std::string>& vectorOfModelFilename, int& startIdFace,
                             const bool verbose=false, const bool parent=true);
 
+  bool loadModelCache(const std::string &cacheFile, const int startIdFace, const bool isCaoModel);
+  void saveModelCache(const std::string &cacheFile, const std::vector<std::string> &vectorOfModelFilename,
+                      const int startIdFace, const bool isCaoModel) const;
+
   void removeComment(std::ifstream& fileId);
 
   inline bool parseBoolean(std::string &input) {
@@ -67,6 +67,9 @@ class VISP_EXPORT vpMbtDistanceCircle
     //double alpha;
     double wmean;
     vpFeatureEllipse featureEllipse ;
+    //! Normalized coordinates of the moving edges, computed once before the VVS iterations
+    std::vector<double> xSites;
+    std::vector<double> ySites;
     //! Polygon describing the circle bbox
 //    vpMbtPolygon poly;
     bool isTrackedCircle;
@@ -243,6 +246,7 @@ class VISP_EXPORT vpMbtDistanceCircle
     void updateMovingEdge(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &cMo);
 
   private:
+    void computeSitesCoordinates();
     void project(const vpHomogeneousMatrix &cMo);
 } ;
 
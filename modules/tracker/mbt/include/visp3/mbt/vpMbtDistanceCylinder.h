@@ -73,7 +73,14 @@ class VISP_EXPORT vpMbtDistanceCylinder
     double wmean2;
     vpFeatureLine featureline1 ;
     vpFeatureLine featureline2 ;
+    //! Normalized coordinates of the moving edges, computed once before the VVS iterations
+    std::vector<double> xSites;
+    std::vector<double> ySites;
     bool isTrackedCylinder;
+    //! Sample step of the moving edges of the first line, 0 to use the one of the moving edges parameters
+    double sampleStep1;
+    //! Sample step of the moving edges of the second line
+    double sampleStep2;
     
   public: 
     //! The moving edge containers (first line of the cylinder)
@@ -200,6 +207,8 @@ class VISP_EXPORT vpMbtDistanceCylinder
     */
     inline bool isVisible() const {return isvisible; }
 
+    void predictMovingEdge(const vpHomogeneousMatrix &cMo);
+
     void reinitMovingEdge(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &cMo);
     
     /*!
@@ -237,6 +246,8 @@ class VISP_EXPORT vpMbtDistanceCylinder
     inline void setMeanWeight2(const double wmean) {this->wmean2 = wmean;}
     
     void setMovingEdge(vpMe *Me);
+
+    void setSampleStep(const double step1, const double step2);
     
     /*!
       Set the name of the cylinder.
@@ -264,6 +275,7 @@ class VISP_EXPORT vpMbtDistanceCylinder
     void updateMovingEdge(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &cMo);
 
   private:
+    void computeSitesCoordinates();
     void project(const vpHomogeneousMatrix &cMo);
 } ;
 
@@ -40,12 +40,15 @@
 
 #include <visp3/core/vpConfig.h>
 
-#if defined(VISP_HAVE_MODULE_KLT) && (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 #include <map>
 
 #include <visp3/core/vpPolygon3D.h>
-#include <visp3/klt/vpKltOpencv.h>
+#include <visp3/klt/vpKltNative.h>
+#if defined(VISP_HAVE_OPENCV)
+#  include <visp3/klt/vpKltOpencv.h>
+#endif
 #include <visp3/core/vpPlane.h>
 #include <visp3/core/vpDisplay.h>
 #include <visp3/core/vpGEMM.h>
@@ -59,7 +62,8 @@
 
   \brief Implementation of a polygon of the model containing points of interest. It is used by the model-based tracker KLT, and hybrid.
 
-  \warning This class is only available if OpenCV is installed, and used.
+  \note The KLT features can be tracked with vpKltNative or vpKltOpencv
+  (see vpMbKltTracker::setKltBackend()).
 
   \ingroup group_mbt_features
 */
@@ -110,6 +114,10 @@ public:
 private:
   double              computeZ(const double &x, const double &y);
   bool                isTrackedFeature(const int id);
+  template <class KltTracker>
+  unsigned int        computeNbDetectedCurrentFrom(const KltTracker &_tracker);
+  template <class KltTracker>
+  void                initFrom(const KltTracker &_tracker, const vpHomogeneousMatrix &cMo);
 
 //private:
 //#ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -133,7 +141,10 @@ public:
 
   void                buildFrom(const vpPoint &p1, const vpPoint &p2, const double &r);
 
+#if defined(VISP_HAVE_OPENCV)
   unsigned int        computeNbDetectedCurrent(const vpKltOpencv& _tracker);
+#endif
+  unsigned int        computeNbDetectedCurrent(const vpKltNative& _tracker);
   void                computeInteractionMatrixAndResidu(const vpHomogeneousMatrix &cMc0, vpColVector& _R, vpMatrix& _J);
 
   void                display(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &cMo, const vpCameraParameters &cam, const vpColor col, const unsigned int thickness = 1, const bool displayFullModel = false);
@@ -186,7 +197,10 @@ public:
   */
   inline  bool        isTracked() const {return isTrackedKltCylinder;}
 
+#if defined(VISP_HAVE_OPENCV)
   void                init(const vpKltOpencv& _tracker, const vpHomogeneousMatrix &cMo);
+#endif
+  void                init(const vpKltNative& _tracker, const vpHomogeneousMatrix &cMo);
 
   void                removeOutliers(const vpColVector& weight, const double &threshold_outlier);
 
@@ -204,13 +218,16 @@ public:
   */
   inline void         setTracked(const bool& track) {this->isTrackedKltCylinder = track;}
 
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+  void updateMask(vpImage<unsigned char> &mask, unsigned char _nb = 255, unsigned int _shiftBorder = 0);
+#if defined(VISP_HAVE_OPENCV)
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
   void updateMask(cv::Mat &mask, unsigned char _nb = 255, unsigned int _shiftBorder = 0);
-#else
+#  else
   void updateMask(IplImage* mask, unsigned char _nb = 255, unsigned int _shiftBorder = 0);
+#  endif
 #endif
 };
 
 #endif
 
-#endif // VISP_HAVE_OPENCV
+#endif // VISP_HAVE_MODULE_KLT
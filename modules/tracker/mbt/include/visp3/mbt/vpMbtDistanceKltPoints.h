@@ -41,12 +41,16 @@
 
 #include <visp3/core/vpConfig.h>
 
-#if defined(VISP_HAVE_MODULE_KLT) && (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 #include <map>
+#include <vector>
 
 #include <visp3/core/vpPolygon3D.h>
-#include <visp3/klt/vpKltOpencv.h>
+#include <visp3/klt/vpKltNative.h>
+#if defined(VISP_HAVE_OPENCV)
+#  include <visp3/klt/vpKltOpencv.h>
+#endif
 #include <visp3/core/vpPlane.h>
 #include <visp3/core/vpDisplay.h>
 #include <visp3/core/vpGEMM.h>
@@ -58,7 +62,8 @@
 
   \brief Implementation of a polygon of the model containing points of interest. It is used by the model-based tracker KLT, and hybrid.
 
-  \warning This class is only available if OpenCV is installed, and used.
+  \note The KLT features can be tracked with vpKltNative or vpKltOpencv
+  (see vpMbKltTracker::setKltBackend()).
 
   \ingroup group_mbt_features
 */
@@ -75,15 +80,35 @@ private:
   double invd0;
   //! cRc0_0n (temporary variable to speed up the computation)
   vpColVector cRc0_0n;
-  //! Initial points and their ID
-  std::map<int, vpImagePoint> initPoints;
-  //! Current points and their ID
-  std::map<int, vpImagePoint> curPoints;
-  //! Current points ID and their indexes
-  std::map<int, int> curPointsInd;
+  //! ID of the initial points
+  std::vector<int> initIds;
+  //! Initial points in pixel (i coordinate)
+  std::vector<double> initI;
+  //! Initial points in pixel (j coordinate)
+  std::vector<double> initJ;
+  //! Initial points in meter (x coordinate)
+  std::vector<double> initX;
+  //! Initial points in meter (y coordinate)
+  std::vector<double> initY;
+  //! Smallest ID of the initial points, origin of the slot table
+  int idOffset;
+  //! Slot of an initial point in the init arrays from its ID minus idOffset, -1 if not tracked
+  std::vector<int> idToSlot;
+  //! Slot in the init arrays of the current points
+  std::vector<unsigned int> curSlots;
+  //! Index in the KLT tracker of the current points
+  std::vector<int> curInd;
+  //! Current points in pixel (i coordinate)
+  std::vector<double> curI;
+  //! Current points in pixel (j coordinate)
+  std::vector<double> curJ;
+  //! Current points in meter (x coordinate)
+  std::vector<double> curX;
+  //! Current points in meter (y coordinate)
+  std::vector<double> curY;
   //! number of points detected
   unsigned int nbPointsCur;
-  //! initial number of points
+  //! number of points detected at the initialisation
   unsigned int nbPointsInit;
   //! Minimal number of points to be tracked
   unsigned int minNbPoint;
@@ -108,14 +133,17 @@ public:
 
 private:
 
-  double              compute_1_over_Z(const double x, const double y);
-  void                computeP_mu_t(const double x_in, const double y_in, double& x_out, double& y_out, const vpMatrix& cHc0);
-  bool                isTrackedFeature(const int id);
+  int                 getSlot(const int id) const;
+  template <class KltTracker>
+  unsigned int        computeNbDetectedCurrentFrom(const KltTracker &_tracker);
+  template <class KltTracker>
+  void                initFrom(const KltTracker &_tracker);
 
 //private:
 //#ifndef DOXYGEN_SHOULD_SKIP_THIS
 //    vpMbtDistanceKltPoints(const vpMbtDistanceKltPoints &)
-//      : H(), N(), N_cur(), invd0(1.), cRc0_0n(), initPoints(), curPoints(), curPointsInd(),
+//      : H(), N(), N_cur(), invd0(1.), cRc0_0n(), initIds(), initI(), initJ(), initX(), initY(),
+//        idOffset(0), idToSlot(), curSlots(), curInd(), curI(), curJ(), curX(), curY(),
 //        nbPointsCur(0), nbPointsInit(0), minNbPoint(4), enoughPoints(false), dt(1.), d0(1.),
 //        cam(), isTrackedKltPoints(true), polygon(NULL), hiddenface(NULL), useScanLine(false)
 //    {
@@ -131,7 +159,11 @@ public:
                       vpMbtDistanceKltPoints();
   virtual             ~vpMbtDistanceKltPoints();
 
+  bool                addPoint(const int id, const vpImagePoint &ip, const vpHomogeneousMatrix &cTc0);
+#if defined(VISP_HAVE_OPENCV)
   unsigned int        computeNbDetectedCurrent(const vpKltOpencv& _tracker);
+#endif
+  unsigned int        computeNbDetectedCurrent(const vpKltNative& _tracker);
   void                computeHomography(const vpHomogeneousMatrix& _cTc0, vpHomography& cHc0);
   void                computeInteractionMatrixAndResidu(vpColVector& _R, vpMatrix& _J);
 
@@ -150,9 +182,36 @@ public:
 
   inline vpColVector  getCurrentNormal() const {return N_cur; }
 
-  inline std::map<int, vpImagePoint>& getCurrentPoints() {return curPoints; }
+  /*!
+    Get the k-th point detected in the last image.
+
+    \param k : Index of the point, between 0 and getCurrentNumberPoints()-1.
+
+    \return the image coordinates of the point.
+  */
+  inline vpImagePoint getCurrentPoint(const unsigned int k) const {return vpImagePoint(curI[k], curJ[k]); }
+
+  /*!
+    Get the ID of the k-th point detected in the last image.
+
+    \param k : Index of the point, between 0 and getCurrentNumberPoints()-1.
+
+    \return the ID of the point in the KLT tracker.
+  */
+  inline int getCurrentPointId(const unsigned int k) const {return initIds[curSlots[k]]; }
+
+  /*!
+    Get the index in the KLT tracker of the k-th point detected in the last image.
+
+    \param k : Index of the point, between 0 and getCurrentNumberPoints()-1.
+
+    \return the index of the point in the KLT tracker.
+  */
+  inline int getCurrentPointInd(const unsigned int k) const {return curInd[k]; }
+
+  std::map<int, vpImagePoint> getCurrentPoints() const;
 
-  inline std::map<int, int>& getCurrentPointsInd() {return curPointsInd; }
+  std::map<int, int> getCurrentPointsInd() const;
 
   /*!
     Get the number of point that was belonging to the face at the initialisation
@@ -176,7 +235,10 @@ public:
 
   inline  bool        hasEnoughPoints() const {return enoughPoints;}
 
+#if defined(VISP_HAVE_OPENCV)
           void        init(const vpKltOpencv& _tracker);
+#endif
+          void        init(const vpKltNative& _tracker);
 
   /*!
    Return if the klt points are used for tracking.
@@ -185,14 +247,12 @@ public:
   */
   inline  bool        isTracked() const {return isTrackedKltPoints;}
 
-          void        removeOutliers(const vpColVector& weight, const double &threshold_outlier);
+          void        predictPoints(const vpHomogeneousMatrix &cTc0, const std::vector<long> &ids,
+                                    std::vector<vpImagePoint> &points);
 
-  /*!
-    Set the camera parameters
+          void        removeOutliers(const vpColVector& weight, const double &threshold_outlier);
 
-    \param _cam : the new camera parameters
-  */
-  virtual inline void setCameraParameters(const vpCameraParameters& _cam){ cam = _cam; }
+  virtual void        setCameraParameters(const vpCameraParameters& _cam);
 
   /*!
     Set if the klt points have to considered during tracking phase.
@@ -201,13 +261,16 @@ public:
   */
   inline void setTracked(const bool& track) {this->isTrackedKltPoints = track;}
 
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+  void updateMask(vpImage<unsigned char> &mask, unsigned char _nb = 255, unsigned int _shiftBorder = 0);
+#if defined(VISP_HAVE_OPENCV)
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
   void updateMask(cv::Mat &mask, unsigned char _nb = 255, unsigned int _shiftBorder = 0);
-#else
+#  else
   void updateMask(IplImage* mask, unsigned char _nb = 255, unsigned int _shiftBorder = 0);
+#  endif
 #endif
 };
 
 #endif
 
-#endif // VISP_HAVE_OPENCV
+#endif // VISP_HAVE_MODULE_KLT
@@ -75,6 +75,11 @@ class VISP_EXPORT vpMbtDistanceLine
     vpFeatureLine featureline ;
     //! Polygon describing the line
     vpMbtPolygon poly;
+    //! Normalized coordinates of the moving edges, computed once before the VVS iterations
+    std::vector<double> xSites;
+    std::vector<double> ySites;
+    //! Sample step of the moving edges, 0 to use the one of the moving edges parameters
+    double sampleStep;
     
   public: 
     //! Use scanline rendering
@@ -192,7 +197,9 @@ class VISP_EXPORT vpMbtDistanceLine
       \return Return true if the line is visible
     */
     inline bool isVisible() const {return isvisible; }
-    
+
+    void predictMovingEdge(const vpHomogeneousMatrix &cMo);
+
     void reinitMovingEdge(const vpImage<unsigned char> &I, const vpHomogeneousMatrix &cMo);
     
     /*!
@@ -216,6 +223,8 @@ class VISP_EXPORT vpMbtDistanceLine
     inline void setMeanWeight(const double w_mean) {this->wmean = w_mean;}
     
     void setMovingEdge(vpMe *Me);
+
+    void setSampleStep(const double step);
     
     /*!
       Set the name of the line.
@@ -247,6 +256,7 @@ class VISP_EXPORT vpMbtDistanceLine
     void updateTracked();
 
   private:
+    void computeSitesCoordinates();
     void project(const vpHomogeneousMatrix &cMo);
 } ;
 
@@ -0,0 +1,236 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Database of keyframes used to relocalize the model-based trackers.
+ *
+ *****************************************************************************/
+
+/*!
+ \file vpMbtKeyFrameDatabase.h
+ \brief Database of keyframes used to relocalize the model-based trackers.
+*/
+
+#ifndef __vpMbtKeyFrameDatabase_h_
+#define __vpMbtKeyFrameDatabase_h_
+
+#include <utility>
+#include <vector>
+
+#include <visp3/core/vpBinaryArchive.h>
+#include <visp3/core/vpCameraParameters.h>
+#include <visp3/core/vpHomogeneousMatrix.h>
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpImagePoint.h>
+#include <visp3/core/vpPoint.h>
+#include <visp3/core/vpPolygon.h>
+
+/*!
+  \class vpMbtKeyFrameDatabase
+
+  \brief Database of keyframes used to recover the pose of the object when
+  the tracking is lost.
+
+  A keyframe is made of a pose of the camera and of the keypoints detected in
+  the image at this pose. Each keypoint is stored with its 3D coordinates in
+  the object frame, obtained by intersecting its line of sight with the
+  visible faces of the model, and with a binary descriptor. Only the
+  descriptors and the 3D points are kept, not the images.
+
+  The keypoints are FAST corners. Their descriptor is a 256 bits rotated BRIEF
+  descriptor: the intensities of 256 pairs of pixels of a smoothed patch
+  around the keypoint are compared, the pattern being rotated along the main
+  orientation of the patch. The descriptors are indexed by several hash
+  tables, each one using a different chunk of the descriptor bits as key, so
+  that a query only compares the descriptor to the database descriptors
+  sharing at least one chunk with it.
+
+  A new keyframe is only recorded when the pose of the camera is far enough
+  from the poses of the keyframes already in the database (see
+  setKeyFrameDistance()).
+
+  To localize the camera in a new image, its keypoints are matched with the
+  database. Each keyframe gets a vote per matched keypoint, and the pose is
+  computed by RANSAC from the matches with the keyframes with the most votes.
+
+  The database is usually filled and used by the model-based trackers (see
+  vpMbTracker::setKeyFrameRecording() and vpMbTracker::relocalize()):
+  \code
+  tracker.setKeyFrameRecording(true);
+  while (acquire(I)) {
+    try {
+      if (lost)
+        lost = ! tracker.relocalize(I);
+      if (! lost)
+        tracker.track(I);
+    }
+    catch(...) {
+      lost = true;
+    }
+  }
+  \endcode
+
+  It can be saved with saveState() to relocalize the tracker in another run.
+
+  \note The descriptors are not scale invariant: the relocalization succeeds
+  when the camera is close to the pose of a keyframe.
+
+  \ingroup group_mbt_trackers
+*/
+class VISP_EXPORT vpMbtKeyFrameDatabase
+{
+public:
+  vpMbtKeyFrameDatabase();
+
+  bool addKeyFrame(const vpImage<unsigned char> &I, const vpCameraParameters &cam, const vpHomogeneousMatrix &cMo,
+                   const std::pair<std::vector<vpPolygon>, std::vector<std::vector<vpPoint> > > &faces);
+
+  void clear();
+
+  void extract(const vpImage<unsigned char> &I, std::vector<vpImagePoint> &keyPoints,
+               std::vector<unsigned char> &descriptors) const;
+
+  /*!
+    \return The pose of the camera of a keyframe.
+
+    \param index : Index of the keyframe.
+  */
+  inline vpHomogeneousMatrix getKeyFramePose(const unsigned int index) const { return m_keyFramePoses[index]; }
+
+  /*!
+    \return The number of keyframes.
+  */
+  inline unsigned int getNbKeyFrames() const { return (unsigned int)m_keyFramePoses.size(); }
+
+  /*!
+    \return The number of keypoints of all the keyframes.
+  */
+  inline unsigned int getNbPoints() const { return (unsigned int)m_pointKeyFrame.size(); }
+
+  bool isNewKeyFrame(const vpHomogeneousMatrix &cMo) const;
+
+  bool localize(const vpImage<unsigned char> &I, const vpCameraParameters &cam, vpHomogeneousMatrix &cMo) const;
+
+  void loadState(vpBinaryArchive &ar);
+  void saveState(vpBinaryArchive &ar) const;
+
+  /*!
+    Set the threshold of the FAST detector, i.e. the minimal intensity
+    difference between the keypoint and the pixels of the circle around it.
+
+    \param threshold : Intensity threshold (default 10).
+  */
+  inline void setFastThreshold(const int threshold) { m_fastThreshold = threshold; }
+
+  void setKeyFrameDistance(const double translationRatio, const double rotation);
+
+  /*!
+    Set the maximal number of keyframes. When it is reached, no keyframe is
+    added anymore.
+
+    \param maxKeyFrames : Maximal number of keyframes (default 200).
+  */
+  inline void setMaxKeyFrames(const unsigned int maxKeyFrames) { m_maxKeyFrames = maxKeyFrames; }
+
+  /*!
+    Set the maximal number of keypoints detected in an image.
+
+    \param maxKeyPoints : Maximal number of keypoints (default 500).
+  */
+  inline void setMaxKeyPoints(const unsigned int maxKeyPoints) { m_maxKeyPoints = maxKeyPoints; }
+
+  void setMatchingThreshold(const unsigned int maxDistance, const double ratio);
+
+  /*!
+    Set the minimal number of inliers of the pose computed by localize().
+
+    \param minInliers : Minimal number of inliers (default 15).
+  */
+  inline void setMinInliers(const unsigned int minInliers) { m_minInliers = minInliers < 4 ? 4 : minInliers; }
+
+  void setRansacThreshold(const double threshold);
+
+private:
+  //! Number of bytes of a descriptor
+  static const unsigned int DESCRIPTOR_SIZE = 32;
+  //! Number of hash tables indexing the descriptors
+  static const unsigned int NB_HASH_TABLES = 16;
+  //! Number of bits of the keys of the hash tables
+  static const unsigned int HASH_KEY_BITS = 12;
+  //! Number of orientations of the rotated sampling patterns
+  static const unsigned int NB_ORIENTATIONS = 30;
+  //! Radius of the patch used to compute the orientation
+  static const int PATCH_RADIUS = 15;
+
+  static unsigned int hammingDistance(const unsigned char *d1, const unsigned char *d2);
+  static unsigned int hashKey(const unsigned char *descriptor, const unsigned int table);
+  void indexPoints(const unsigned int first);
+  void match(const std::vector<unsigned char> &descriptors,
+             std::vector<std::pair<unsigned int, unsigned int> > &matches) const;
+  static void smooth(const vpImage<unsigned char> &I, vpImage<unsigned char> &S);
+
+  //! Threshold of the FAST detector
+  int m_fastThreshold;
+  //! Maximal number of keypoints detected in an image
+  unsigned int m_maxKeyPoints;
+  //! Maximal number of keyframes
+  unsigned int m_maxKeyFrames;
+  //! Minimal distance between the camera centers of two keyframes, relative to the distance to the object
+  double m_keyFrameTranslationRatio;
+  //! Minimal rotation between two keyframes (rad)
+  double m_keyFrameRotation;
+  //! Maximal Hamming distance between two matched descriptors
+  unsigned int m_maxHammingDistance;
+  //! Maximal ratio between the distances to the best and second best descriptors of a keyframe
+  double m_matchingRatio;
+  //! Minimal number of inliers of a localization
+  unsigned int m_minInliers;
+  //! RANSAC reprojection threshold (pixel)
+  double m_ransacThreshold;
+  //! Number of keyframes with the most votes used by localize()
+  unsigned int m_nbKeyFrameCandidates;
+
+  //! Sampling patterns of the descriptor (dx1, dy1, dx2, dy2 for each bit), for each orientation
+  std::vector<int> m_patterns;
+  //! Half width of each row of the circular orientation patch
+  std::vector<int> m_patchHalfWidth;
+
+  //! Poses of the keyframes
+  std::vector<vpHomogeneousMatrix> m_keyFramePoses;
+  //! Keyframe of each keypoint
+  std::vector<unsigned int> m_pointKeyFrame;
+  //! Coordinates of the keypoints in the object frame (X, Y, Z for each keypoint)
+  std::vector<double> m_points;
+  //! Descriptors of the keypoints
+  std::vector<unsigned char> m_descriptors;
+  //! Hash tables, made of (key, keypoint) pairs sorted by key
+  std::vector<std::pair<unsigned int, unsigned int> > m_hashTables[NB_HASH_TABLES];
+};
+
+#endif
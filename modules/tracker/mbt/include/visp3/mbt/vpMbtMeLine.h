@@ -45,6 +45,7 @@
 #ifndef vpMbtMeLine_HH
 #define vpMbtMeLine_HH
 
+#include <visp3/core/vpMath.h>
 #include <visp3/core/vpPoint.h>
 #include <visp3/me/vpMe.h>
 #include <visp3/me/vpMeTracker.h>
@@ -65,6 +66,10 @@ class VISP_EXPORT vpMbtMeLine : public vpMeTracker
     double delta ,delta_1;
     int sign;
     double a,b,c;
+    //! Sample step of the line, 0 to use the one of the moving edges parameters
+    double sampleStep;
+    //! Sample step used by the last sampling of the line
+    double sampledStep;
   
   public: 
     int imin, imax;
@@ -100,9 +105,39 @@ class VISP_EXPORT vpMbtMeLine : public vpMeTracker
      \return : The c coefficient of the moving edge  
     */
     inline double get_c() const { return this->c;}
+
+    /*!
+     Get the length of the line between its two extremities.
+
+     \return : The length of the line in pixels.
+    */
+    inline double getLength() const {
+      return sqrt(vpMath::sqr(PExt[0].ifloat-PExt[1].ifloat) + vpMath::sqr(PExt[0].jfloat-PExt[1].jfloat));
+    }
+
+     /*!
+     Get the distance between two consecutive moving edges along the line.
+
+     \return : The sample step set with setSampleStep() if any, the one of the
+     moving edges parameters otherwise.
+    */
+    inline double getSampleStep() const { return sampleStep > 0 ? sampleStep : me->getSampleStep();}
     
     void initTracking(const vpImage<unsigned char> &I, const vpImagePoint &ip1, const vpImagePoint &ip2, double rho, double theta);
 
+    /*!
+     Set the distance between two consecutive moving edges along the line,
+     instead of the sample step of the moving edges parameters. It is applied
+     when the line is updated: the moving edges are thinned out if the step
+     increases, and the line is resampled if it decreases.
+
+     \param step : The sample step in pixels, 0 to use the one of the moving
+     edges parameters.
+    */
+    inline void setSampleStep(const double step) { sampleStep = step;}
+
+    void shiftSites(double rho, double theta);
+
     void track(const vpImage<unsigned char> &I);
     
     void updateParameters(const vpImage<unsigned char> &I, double rho, double theta);
@@ -118,6 +153,7 @@ class VISP_EXPORT vpMbtMeLine : public vpMeTracker
     void suppressPoints(const vpImage<unsigned char> &I);
     void reSample(const vpImage<unsigned char>&image);
     void reSample(const vpImage<unsigned char>&image, vpImagePoint ip1, vpImagePoint ip2);
+    void thinOut();
     void updateDelta();
 } ;
 
@@ -0,0 +1,165 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Robust pose minimization shared by the model-based trackers.
+ *
+ *****************************************************************************/
+
+/*!
+ \file vpMbtVVSSolver.h
+ \brief Robust pose minimization shared by the model-based trackers.
+*/
+
+#ifndef __vpMbtVVSSolver_h_
+#define __vpMbtVVSSolver_h_
+
+#include <visp3/core/vpColVector.h>
+#include <visp3/core/vpHomogeneousMatrix.h>
+#include <visp3/core/vpMatrix.h>
+#include <visp3/mbt/vpMbTracker.h>
+
+/*!
+  \class vpMbtVVSSolver
+
+  \brief Iterations of the virtual visual servoing (VVS) loop used by the
+  model-based trackers to estimate the pose.
+
+  At each iteration the tracker fills the interaction matrix \f$ \bf L \f$
+  (one row of 6 columns per feature) and the error \f$ \bf e \f$ of its
+  features at the current pose, and computes their robust weights
+  \f$ \bf w \f$. The solver accumulates the weighted normal equations
+  \f$ {\bf L}^T {\bf W}^2 {\bf L} \f$ and \f$ {\bf L}^T {\bf W}^2 {\bf e} \f$
+  in a single pass over the rows, without copying or scaling \f$ \bf L \f$,
+  and solves the resulting \f$ 6 \times 6 \f$ system with a Gauss-Newton or
+  a Levenberg-Marquardt step.
+
+  The loop stops after the maximum number of iterations, when the weighted
+  residual does not change anymore, or when the norm of the pose increment is
+  below a threshold.
+
+  A typical loop is:
+  \code
+  vpMbtVVSSolver solver(m_optimizationMethod, lambda, maxIter);
+  while (! solver.hasConverged()) {
+    // Fill L and error at cMo, compute the weights w
+    if (solver.rejectIncrement(error, w)) {
+      // Levenberg-Marquardt: go back to the previous pose
+      cMo = cMoPrev;
+    }
+    else {
+      solver.computeIncrement(L, error, w);
+      solver.getIncrement(cMo, isoJoIdentity, oJo, v);
+      cMoPrev = cMo;
+      cMo = vpExponentialMap::direct(v).inverse() * cMo;
+    }
+    solver.nextIteration();
+  }
+  \endcode
+
+  \ingroup group_mbt_trackers
+*/
+class VISP_EXPORT vpMbtVVSSolver
+{
+public:
+  vpMbtVVSSolver(const vpMbTracker::vpMbtOptimizationMethod &method, const double gain, const unsigned int maxIter);
+
+  void computeIncrement(const vpMatrix &L, const vpColVector &error, const vpColVector &w,
+                        const vpColVector *factor = NULL, const bool weightInteraction = true);
+
+  /*!
+    \return The number of iterations done.
+  */
+  inline unsigned int getIteration() const { return m_iter; }
+
+  void getIncrement(const vpHomogeneousMatrix &cMo, const bool isoJoIdentity, const vpMatrix &oJo, vpColVector &v);
+
+  /*!
+    \return The weighted residual \f$ \sqrt{\sum w_i e_i^2 / \sum w_i} \f$
+    of the last call to computeIncrement().
+  */
+  inline double getResidual() const { return m_residual; }
+
+  /*!
+    \return The weights of the rows used by the last call to
+    computeIncrement(), including the factors.
+  */
+  inline const vpColVector &getWeights() const { return m_weights; }
+
+  bool hasConverged() const;
+
+  unsigned int kernel(const vpHomogeneousMatrix &cMo, vpMatrix &K) const;
+
+  /*!
+    Start the next iteration.
+  */
+  inline void nextIteration() { m_iter++; }
+
+  bool rejectIncrement(vpColVector &error, vpColVector &w);
+
+  void setStopCriteria(const double residualThreshold, const double incrementThreshold);
+
+private:
+  //! Optimization method
+  vpMbTracker::vpMbtOptimizationMethod m_method;
+  //! Gain of the increment
+  double m_gain;
+  //! Levenberg-Marquardt damping factor
+  double m_mu;
+  //! Maximum number of iterations
+  unsigned int m_maxIter;
+  //! Current iteration
+  unsigned int m_iter;
+  //! The loop stops when the residual varies by less than this threshold
+  double m_residualThreshold;
+  //! The loop stops when the norm of the increment is below this threshold
+  double m_incrementThreshold;
+  //! Number of increments computed
+  unsigned int m_nbIncrements;
+  //! Weighted residual of the last increment
+  double m_residual;
+  //! Weighted residual of the previous increment
+  double m_residualPrev;
+  //! Norm of the last increment
+  double m_incrementNorm;
+  //! Upper triangle of L^T W^2 L
+  double m_LTL[6][6];
+  //! L^T W^2 e
+  double m_LTR[6];
+  //! Weights of the rows, including the factors
+  vpColVector m_weights;
+  //! Error at the last accepted pose (Levenberg-Marquardt)
+  vpColVector m_errorPrev;
+  //! Weights at the last accepted pose (Levenberg-Marquardt)
+  vpColVector m_wPrev;
+  //! Mean of the squared error at the last accepted pose (Levenberg-Marquardt)
+  double m_meanSquarePrev;
+};
+
+#endif
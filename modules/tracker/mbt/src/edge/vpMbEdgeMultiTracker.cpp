@@ -45,15 +45,17 @@
 #include <visp3/core/vpDebug.h>
 #include <visp3/mbt/vpMbEdgeMultiTracker.h>
 #include <visp3/core/vpExponentialMap.h>
+#include <visp3/core/vpTime.h>
 #include <visp3/core/vpTrackingException.h>
 #include <visp3/core/vpVelocityTwistMatrix.h>
 
+#include "../vpMbtParallelError_impl.h"
 
 /*!
   Basic constructor
 */
 vpMbEdgeMultiTracker::vpMbEdgeMultiTracker() : m_mapOfCameraTransformationMatrix(), m_mapOfEdgeTrackers(),
-    m_mapOfPyramidalImages(), m_referenceCameraName("Camera") {
+    m_mapOfPyramidalImages(), m_referenceCameraName("Camera"), m_camerasThreaded(false) {
   m_mapOfEdgeTrackers["Camera"] = new vpMbEdgeTracker();
 
   //Add default camera transformation matrix
@@ -66,7 +68,7 @@ vpMbEdgeMultiTracker::vpMbEdgeMultiTracker() : m_mapOfCameraTransformationMatrix
   \param nbCameras : Number of cameras to use.
 */
 vpMbEdgeMultiTracker::vpMbEdgeMultiTracker(const unsigned int nbCameras) : m_mapOfCameraTransformationMatrix(),
-    m_mapOfEdgeTrackers(), m_mapOfPyramidalImages(), m_referenceCameraName("Camera") {
+    m_mapOfEdgeTrackers(), m_mapOfPyramidalImages(), m_referenceCameraName("Camera"), m_camerasThreaded(false) {
 
   if(nbCameras == 0) {
     throw vpException(vpTrackingException::fatalError, "Cannot construct a vpMbEdgeMultiTracker with no camera !");
@@ -107,7 +109,7 @@ vpMbEdgeMultiTracker::vpMbEdgeMultiTracker(const unsigned int nbCameras) : m_map
   \param cameraNames : List of camera names.
 */
 vpMbEdgeMultiTracker::vpMbEdgeMultiTracker(const std::vector<std::string> &cameraNames) : m_mapOfCameraTransformationMatrix(),
-    m_mapOfEdgeTrackers(), m_mapOfPyramidalImages(), m_referenceCameraName("Camera") {
+    m_mapOfEdgeTrackers(), m_mapOfPyramidalImages(), m_referenceCameraName("Camera"), m_camerasThreaded(false) {
 
   if(cameraNames.empty()) {
     throw vpException(vpTrackingException::fatalError, "Cannot construct a vpMbEdgeMultiTracker with no camera !");
@@ -135,6 +137,28 @@ vpMbEdgeMultiTracker::~vpMbEdgeMultiTracker() {
   cleanPyramid(m_mapOfPyramidalImages);
 }
 
+/*!
+  Adapt the budget of moving edges of each camera to the duration of the last
+  frame, and sum up the statistics of the cameras (see
+  vpMbEdgeTracker::setFeatureBudget()).
+
+  \param time : Duration of the last call to track() in ms.
+*/
+void vpMbEdgeMultiTracker::adaptFeatureBudget(const double time) {
+  vpMbEdgeTracker::adaptFeatureBudget(time);
+
+  m_nbTrackedPrimitives = 0;
+  m_nbTrackedSites = 0;
+  m_nbValidSites = 0;
+  for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
+      it != m_mapOfEdgeTrackers.end(); ++it) {
+    it->second->adaptFeatureBudget(time);
+    m_nbTrackedPrimitives += it->second->m_nbTrackedPrimitives;
+    m_nbTrackedSites += it->second->m_nbTrackedSites;
+    m_nbValidSites += it->second->m_nbValidSites;
+  }
+}
+
 void vpMbEdgeMultiTracker::cleanPyramid(std::map<std::string, std::vector<const vpImage<unsigned char>* > >& pyramid) {
   for(std::map<std::string, std::vector<const vpImage<unsigned char>* > >::iterator it1 = pyramid.begin();
       it1 != pyramid.end(); ++it1) {
@@ -179,9 +203,6 @@ void vpMbEdgeMultiTracker::computeProjectionError() {
 void vpMbEdgeMultiTracker::computeVVS(std::map<std::string, const vpImage<unsigned char> *> &mapOfImages, const unsigned int lvl) {
   //Number of moving edges
   unsigned int nbrow = 0;
-  //unsigned int nberrors_lines = 0;
-  //unsigned int nberrors_cylinders = 0;
-  //unsigned int nberrors_circles = 0;
 
   std::vector<FeatureType> indexOfFeatures;
   std::map<std::string, unsigned int> mapOfNumberOfRows;
@@ -189,6 +210,17 @@ void vpMbEdgeMultiTracker::computeVVS(std::map<std::string, const vpImage<unsign
   std::map<std::string, unsigned int> mapOfNumberOfCylinders;
   std::map<std::string, unsigned int> mapOfNumberOfCircles;
 
+  //Each camera fills its own slice of the stacked system, the offsets have an
+  //extra element with the total size
+  std::vector<vpMbEdgeTracker *> trackers;
+  std::vector<const vpImage<unsigned char> *> images;
+  std::vector<vpHomogeneousMatrix> cameraTransformations;
+  std::vector<vpVelocityTwistMatrix> velocityTwists;
+  std::vector<unsigned int> rowOffsets, lineOffsets, cylinderOffsets, circleOffsets;
+  unsigned int nberrors_lines = 0;
+  unsigned int nberrors_cylinders = 0;
+  unsigned int nberrors_circles = 0;
+
   for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it1 = m_mapOfEdgeTrackers.begin();
       it1 != m_mapOfEdgeTrackers.end(); ++it1) {
     unsigned int nrows = 0;
@@ -203,10 +235,21 @@ void vpMbEdgeMultiTracker::computeVVS(std::map<std::string, const vpImage<unsign
     mapOfNumberOfCylinders[it1->first] = ncylinders;
     mapOfNumberOfCircles[it1->first] = ncircles;
 
+    trackers.push_back(it1->second);
+    images.push_back(mapOfImages[it1->first]);
+    cameraTransformations.push_back(m_mapOfCameraTransformationMatrix[it1->first]);
+    vpVelocityTwistMatrix cVo;
+    cVo.buildFrom(cameraTransformations.back());
+    velocityTwists.push_back(cVo);
+    rowOffsets.push_back(nbrow);
+    lineOffsets.push_back(nberrors_lines);
+    cylinderOffsets.push_back(nberrors_cylinders);
+    circleOffsets.push_back(nberrors_circles);
+
     nbrow += nrows;
-    //nberrors_lines += nlines;
-    //nberrors_cylinders += ncylinders;
-    //nberrors_circles += ncircles;
+    nberrors_lines += nlines;
+    nberrors_cylinders += ncylinders;
+    nberrors_circles += ncircles;
 
     for(unsigned int i = 0; i < nlines; i++) {
       indexOfFeatures.push_back(LINE);
@@ -221,6 +264,12 @@ void vpMbEdgeMultiTracker::computeVVS(std::map<std::string, const vpImage<unsign
     }
   }
 
+  int nbCameras = (int) trackers.size();
+  rowOffsets.push_back(nbrow);
+  lineOffsets.push_back(nberrors_lines);
+  cylinderOffsets.push_back(nberrors_cylinders);
+  circleOffsets.push_back(nberrors_circles);
+
   if(nbrow < 4) {
     throw vpTrackingException(vpTrackingException::notEnoughPointError, "No data found to compute the interaction matrix...");
   }
@@ -230,80 +279,78 @@ void vpMbEdgeMultiTracker::computeVVS(std::map<std::string, const vpImage<unsign
   // compute the error vector
   m_error.resize(nbrow);
   unsigned int nerror = m_error.getRows();
-  vpColVector v;
 
 //  double limite = 3; //Une limite de 3 pixels
 //  limite = limite / cam.get_px(); //Transformation limite pixel en limite metre.
   unsigned int iter = 0;
-  vpColVector weighted_error;
   vpColVector factor;
-  std::map<std::string, vpColVector> mapOfFactors;
+  std::vector<vpColVector> factors((size_t) nbCameras);
+  std::vector<double> counts((size_t) nbCameras);
 
   //Parametre pour la premiere phase d'asservissement
   bool reloop = true;
 
   bool isoJoIdentity_ = isoJoIdentity; // Backup since it can be modified if L is not full rank
 
-  std::map<std::string, vpVelocityTwistMatrix> mapOfVelocityTwist;
-  for(std::map<std::string, vpHomogeneousMatrix>::const_iterator it = m_mapOfCameraTransformationMatrix.begin();
-      it != m_mapOfCameraTransformationMatrix.end(); ++it) {
-    vpVelocityTwistMatrix cVo;
-    cVo.buildFrom(it->second);
-    mapOfVelocityTwist[it->first] = cVo;
-  }
-
 //  std::cout << "\n\n\ncMo used before the first phase=\n" << cMo << std::endl;
 
   /*** First phase ***/
 
   while(reloop == true && iter < 10)
   {
-    m_w.resize(0);
-    m_error.resize(0);
-
-    for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
-        it != m_mapOfEdgeTrackers.end(); ++it) {
-      it->second->cMo = m_mapOfCameraTransformationMatrix[it->first] * cMo;
-    }
-
     if(iter == 0)
     {
-      weighted_error.resize(nerror);
+      for(int k = 0; k < nbCameras; k++) {
+        unsigned int nrows = rowOffsets[(size_t) k+1] - rowOffsets[(size_t) k];
+        trackers[(size_t) k]->m_w.resize(nrows);
+        trackers[(size_t) k]->m_w = 0;
 
-      for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
-          it != m_mapOfEdgeTrackers.end(); ++it) {
-        it->second->m_w.resize(mapOfNumberOfRows[it->first]);
-        it->second->m_w = 0;
+        trackers[(size_t) k]->m_error.resize(nrows);
 
-        it->second->m_error.resize(mapOfNumberOfRows[it->first]);
-
-        mapOfFactors[it->first].resize(mapOfNumberOfRows[it->first]);
-        mapOfFactors[it->first] = 1;
+        factors[(size_t) k].resize(nrows);
+        factors[(size_t) k] = 1;
       }
     }
 
-    double count = 0;
     reloop = false;
 
-    L = vpMatrix();
-    factor = vpColVector();
-
-
-    for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
-        it != m_mapOfEdgeTrackers.end(); ++it) {
-      vpMatrix L_tmp(mapOfNumberOfRows[it->first], 6);
-
-      double count_tmp = 0.0;
-      it->second->computeVVSFirstPhase(*mapOfImages[it->first], iter, L_tmp, mapOfFactors[it->first], count_tmp,
-          it->second->m_error, it->second->m_w, lvl);
-      count += count_tmp;
+    L.resize(nbrow, 6, false);
+    factor.resize(nbrow, false);
+    m_w.resize(nbrow, false);
+    m_error.resize(nbrow, false);
 
-      L_tmp = L_tmp*mapOfVelocityTwist[it->first];
+    vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+    #pragma omp parallel for if(m_camerasThreaded)
+#endif
+    for(int k = 0; k < nbCameras; k++) {
+      if(! m_camerasThreaded && error.raised())
+        continue;
+      try {
+        vpMbEdgeTracker *tracker = trackers[(size_t) k];
+        unsigned int offset = rowOffsets[(size_t) k];
+        vpMatrix L_tmp(rowOffsets[(size_t) k+1] - offset, 6);
+
+        tracker->cMo = cameraTransformations[(size_t) k] * cMo;
+
+        counts[(size_t) k] = 0.0;
+        tracker->computeVVSFirstPhase(*images[(size_t) k], iter, L_tmp, factors[(size_t) k], counts[(size_t) k],
+            tracker->m_error, tracker->m_w, lvl);
+
+        L.insert(L_tmp*velocityTwists[(size_t) k], offset, 0);
+        factor.insert(offset, factors[(size_t) k]);
+        m_w.insert(offset, tracker->m_w);
+        m_error.insert(offset, tracker->m_error);
+      }
+      catch(vpException &e) {
+        error.set(k, e);
+      }
+    }
+    error.rethrow();
 
-      L.stack(L_tmp);
-      factor.stack(mapOfFactors[it->first]);
-      m_w.stack(it->second->m_w);
-      m_error.stack(it->second->m_error);
+    double count = 0;
+    for(int k = 0; k < nbCameras; k++) {
+      count += counts[(size_t) k];
     }
 
     count = count / (double) nbrow;
@@ -311,7 +358,7 @@ void vpMbEdgeMultiTracker::computeVVS(std::map<std::string, const vpImage<unsign
       reloop = true;
     }
 
-    computeVVSFirstPhasePoseEstimation(nerror, iter, factor, weighted_error, L, isoJoIdentity_);
+    computeVVSFirstPhasePoseEstimation(iter, factor, L, isoJoIdentity_);
 
     iter++;
   }
@@ -347,74 +394,90 @@ void vpMbEdgeMultiTracker::computeVVS(std::map<std::string, const vpImage<unsign
   std::map<std::string, vpColVector> mapOfWeightCylinders;
   std::map<std::string, vpColVector> mapOfWeightCircles;
 
-  iter = 0;
-
   vpColVector error_lines;
   vpColVector error_cylinders;
   vpColVector error_circles;
 
   vpHomogeneousMatrix cMoPrev;
-  vpColVector W_true;
   vpMatrix L_true;
-  vpMatrix LVJ_true;
 
-  double mu = 0.01;
-  vpColVector m_error_prev(nbrow);
-  vpColVector m_w_prev(nbrow);
+  vpMbtVVSSolver solver(m_optimizationMethod, lambda, 30);
+  solver.setStopCriteria(m_stopCriteriaResidual, m_stopCriteriaIncrement);
 
-  double residu_1 = 1e3;
-  double r =1e3-1;
-
-  while ( ((int)((residu_1 - r)*1e8) != 0 )  && (iter<30))
+  while (! solver.hasConverged())
   {
-    L.resize(0,0);
-    m_error.resize(0);
+    L.resize(nbrow, 6, false);
+    m_error.resize(nbrow, false);
+
+    error_lines.resize(nberrors_lines, false);
+    error_cylinders.resize(nberrors_cylinders, false);
+    error_circles.resize(nberrors_circles, false);
 
-    error_lines.resize(0);
-    error_cylinders.resize(0);
-    error_circles.resize(0);
+    std::vector<vpColVector> errorLines((size_t) nbCameras);
+    std::vector<vpColVector> errorCylinders((size_t) nbCameras);
+    std::vector<vpColVector> errorCircles((size_t) nbCameras);
+
+    vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+    #pragma omp parallel for if(m_camerasThreaded)
+#endif
+    for(int k = 0; k < nbCameras; k++) {
+      if(! m_camerasThreaded && error.raised())
+        continue;
+      try {
+        vpMbEdgeTracker *tracker = trackers[(size_t) k];
+        unsigned int offset = rowOffsets[(size_t) k];
+        vpMatrix L_tmp(rowOffsets[(size_t) k+1] - offset, 6);
+        vpColVector &error_lines_tmp = errorLines[(size_t) k];
+        vpColVector &error_cylinders_tmp = errorCylinders[(size_t) k];
+        vpColVector &error_circles_tmp = errorCircles[(size_t) k];
+        error_lines_tmp.resize(lineOffsets[(size_t) k+1] - lineOffsets[(size_t) k]);
+        error_cylinders_tmp.resize(cylinderOffsets[(size_t) k+1] - cylinderOffsets[(size_t) k]);
+        error_circles_tmp.resize(circleOffsets[(size_t) k+1] - circleOffsets[(size_t) k]);
+
+        tracker->cMo = cameraTransformations[(size_t) k]*cMo;
+
+        vpColVector error_tmp;
+        error_tmp.resize(L_tmp.getRows());
+
+        tracker->computeVVSSecondPhase(*images[(size_t) k], L_tmp, error_lines_tmp,
+            error_cylinders_tmp, error_circles_tmp, error_tmp, lvl);
+
+        L.insert(L_tmp*velocityTwists[(size_t) k], offset, 0);
+        m_error.insert(offset, error_tmp);
+
+        error_lines.insert(lineOffsets[(size_t) k], error_lines_tmp);
+        error_cylinders.insert(cylinderOffsets[(size_t) k], error_cylinders_tmp);
+        error_circles.insert(circleOffsets[(size_t) k], error_circles_tmp);
+      }
+      catch(vpException &e) {
+        error.set(k, e);
+      }
+    }
+    error.rethrow();
 
     std::map<std::string, vpColVector> mapOfErrorLines;
     std::map<std::string, vpColVector> mapOfErrorCylinders;
     std::map<std::string, vpColVector> mapOfErrorCircles;
 
+    int k = 0;
     for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
-        it != m_mapOfEdgeTrackers.end(); ++it) {
-      vpMatrix L_tmp(mapOfNumberOfRows[it->first], 6);
-      vpColVector error_lines_tmp(mapOfNumberOfLines[it->first]);
-      vpColVector error_cylinders_tmp(mapOfNumberOfCylinders[it->first]);
-      vpColVector error_circles_tmp(mapOfNumberOfCircles[it->first]);
-
-      it->second->cMo = m_mapOfCameraTransformationMatrix[it->first]*cMo;
-
-      vpColVector error_tmp;
-      error_tmp.resize(mapOfNumberOfRows[it->first]);
-
-      it->second->computeVVSSecondPhase(*mapOfImages[it->first], L_tmp, error_lines_tmp,
-          error_cylinders_tmp, error_circles_tmp, error_tmp, lvl);
-      L_tmp = L_tmp*mapOfVelocityTwist[it->first];
-
-      L.stack(L_tmp);
-      m_error.stack(error_tmp);
-
-      error_lines.stack(error_lines_tmp);
-      error_cylinders.stack(error_cylinders_tmp);
-      error_circles.stack(error_circles_tmp);
-
-      mapOfErrorLines[it->first] = error_lines_tmp;
-      mapOfErrorCylinders[it->first] = error_cylinders_tmp;
-      mapOfErrorCircles[it->first] = error_circles_tmp;
+        it != m_mapOfEdgeTrackers.end(); ++it, k++) {
+      mapOfErrorLines[it->first] = errorLines[(size_t) k];
+      mapOfErrorCylinders[it->first] = errorCylinders[(size_t) k];
+      mapOfErrorCircles[it->first] = errorCircles[(size_t) k];
     }
 
-    bool reStartFromLastIncrement = false;
-    computeVVSSecondPhaseCheckLevenbergMarquardt(iter, nbrow, m_error_prev, m_w_prev, cMoPrev, mu, reStartFromLastIncrement);
-
-    if(!reStartFromLastIncrement) {
+    if(solver.rejectIncrement(m_error, m_w)) {
+      cMo = cMoPrev;
+    }
+    else {
+      unsigned int iter = solver.getIteration();
       w_lines.resize(0);
       w_cylinders.resize(0);
       w_circles.resize(0);
 
-      computeVVSSecondPhaseWeights(iter, nerror, weighted_error, w_lines, w_cylinders, w_circles, mapOfNumberOfLines,
+      computeVVSSecondPhaseWeights(iter, w_lines, w_cylinders, w_circles, mapOfNumberOfLines,
           mapOfNumberOfCylinders, mapOfNumberOfCircles, mapOfWeightLines, mapOfWeightCylinders, mapOfWeightCircles,
           mapOfErrorLines, mapOfErrorCylinders, mapOfErrorCircles, mapOfRobustLines, mapOfRobustCylinders,
           mapOfRobustCircles, 2.0);
@@ -447,26 +510,16 @@ void vpMbEdgeMultiTracker::computeVVS(std::map<std::string, const vpImage<unsign
         }
       }
 
-      computeVVSSecondPhasePoseEstimation(nerror, L, L_true, LVJ_true, W_true, factor, iter, isoJoIdentity_,
-          weighted_error, mu, m_error_prev, m_w_prev, cMoPrev, residu_1, r);
+      computeVVSSecondPhasePoseEstimation(solver, L, L_true, factor, isoJoIdentity_, cMoPrev);
     }
 
-    iter++;
+    solver.nextIteration();
   }
 
 // std::cout << "VVS estimate pose cMo:\n" << cMo << std::endl;
 
   if(computeCovariance){
-    vpMatrix D;
-    D.diag(W_true);
-
-    // Note that here the covariance is computed on cMoPrev for time computation efficiency
-    if(isoJoIdentity_){
-        covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev, m_error, L_true, D);
-    }
-    else{
-        covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev, m_error, LVJ_true, D);
-    }
+    computeVVSSecondPhaseCovariance(L_true, solver.getWeights(), isoJoIdentity_, cMoPrev);
   }
 
   unsigned int cpt = 0;
@@ -479,8 +532,7 @@ void vpMbEdgeMultiTracker::computeVVS(std::map<std::string, const vpImage<unsign
   }
 }
 
-void vpMbEdgeMultiTracker::computeVVSSecondPhaseWeights(const unsigned int iter, const unsigned int nerror,
-    vpColVector &weighted_error, vpColVector &w_lines, vpColVector &w_cylinders, vpColVector &w_circles,
+void vpMbEdgeMultiTracker::computeVVSSecondPhaseWeights(const unsigned int iter, vpColVector &w_lines, vpColVector &w_cylinders, vpColVector &w_circles,
     std::map<std::string, unsigned int> &mapOfNumberOfLines,
     std::map<std::string, unsigned int> &mapOfNumberOfCylinders, std::map<std::string, unsigned int> &mapOfNumberOfCircles,
     std::map<std::string, vpColVector> &mapOfWeightLines, std::map<std::string, vpColVector> &mapOfWeightCylinders,
@@ -490,8 +542,6 @@ void vpMbEdgeMultiTracker::computeVVSSecondPhaseWeights(const unsigned int iter,
     std::map<std::string, vpRobust> &mapOfRobustCircles, double threshold) {
   if(iter == 0)
   {
-    weighted_error.resize(nerror);
-
     //Init weight size
     for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
         it != m_mapOfEdgeTrackers.end(); ++it) {
@@ -1629,6 +1679,20 @@ void vpMbEdgeMultiTracker::initFromPose(const std::map<std::string, const vpImag
   vpMbEdgeMultiTracker::setPose(mapOfImages, cMo_);
 }
 
+/*!
+  Move the moving edges of each camera onto the model projected with the
+  pose of the camera deduced from the predicted pose of the reference camera
+  (see vpMbEdgeTracker::predictMovingEdge()).
+*/
+void vpMbEdgeMultiTracker::predictMovingEdge() {
+  for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
+      it != m_mapOfEdgeTrackers.end(); ++it) {
+    vpMbEdgeTracker *tracker = it->second;
+    tracker->cMo = m_mapOfCameraTransformationMatrix[it->first] * cMo;
+    tracker->predictMovingEdge();
+  }
+}
+
 /*!
   Initialize the tracking thanks to the pose.
 
@@ -1645,11 +1709,22 @@ void vpMbEdgeMultiTracker::initFromPose(const std::map<std::string, const vpImag
 void vpMbEdgeMultiTracker::initPyramid(const std::map<std::string, const vpImage<unsigned char> * >& mapOfImages,
     std::map<std::string, std::vector<const vpImage<unsigned char>* > >& pyramid)
 {
+  std::vector<const vpImage<unsigned char> *> images;
+  std::vector<std::vector<const vpImage<unsigned char>* > *> pyramids;
   for(std::map<std::string, const vpImage<unsigned char> * >::const_iterator it = mapOfImages.begin();
       it != mapOfImages.end(); ++it) {
     pyramid[it->first].resize(scales.size());
 
-    vpMbEdgeTracker::initPyramid(*it->second, pyramid[it->first]);
+    images.push_back(it->second);
+    pyramids.push_back(&pyramid[it->first]);
+  }
+
+  int nbImages = (int) images.size();
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(m_camerasThreaded)
+#endif
+  for(int k = 0; k < nbImages; k++) {
+    vpMbEdgeTracker::initPyramid(*images[(size_t) k], *pyramids[(size_t) k]);
   }
 }
 
@@ -2006,6 +2081,8 @@ void vpMbEdgeMultiTracker::resetTracker() {
   clippingFlag = vpPolygon3D::NO_CLIPPING;
 
   m_optimizationMethod = vpMbTracker::GAUSS_NEWTON_OPT;
+  m_posePrediction = vpMbTracker::NO_PREDICTION;
+  resetPosePrediction();
 
   // reinitialization of the scales.
   this->setScales(scales);
@@ -2468,6 +2545,22 @@ void vpMbEdgeMultiTracker::setMovingEdge(const std::string &cameraName, const vp
   }
 }
 
+/*!
+  Set the directory of the binary model cache for all the cameras.
+
+  \param directory : Directory of the cache. If empty, the cache is not used.
+
+  \sa vpMbTracker::setModelCacheDirectory()
+*/
+void vpMbEdgeMultiTracker::setModelCacheDirectory(const std::string &directory) {
+  vpMbTracker::setModelCacheDirectory(directory);
+
+  for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
+      it != m_mapOfEdgeTrackers.end(); ++it) {
+    it->second->setModelCacheDirectory(directory);
+  }
+}
+
 /*!
   Set the near distance for clipping.
 
@@ -2551,6 +2644,61 @@ void vpMbEdgeMultiTracker::setOptimizationMethod(const vpMbtOptimizationMethod &
   m_optimizationMethod = opt;
 }
 
+/*!
+  Set the number of moving edges distributed over the visible primitives of
+  each camera at each frame (see vpMbEdgeTracker::setFeatureBudget()). The
+  budget of each camera is adapted to the duration of the tracking of all the
+  cameras.
+
+  \param nbSites : Number of moving edges per camera, 0 to use the sample step
+  of the moving edges parameters (default).
+  \param latency : Targeted duration of a call to track() in ms, 0 to keep a
+  constant budget.
+*/
+void vpMbEdgeMultiTracker::setFeatureBudget(const unsigned int nbSites, const double latency) {
+  vpMbEdgeTracker::setFeatureBudget(nbSites, latency);
+
+  for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
+      it != m_mapOfEdgeTrackers.end(); ++it) {
+    it->second->setFeatureBudget(nbSites, latency);
+  }
+}
+
+/*!
+  Set the motion model used to predict the pose before the tracking of new
+  images, for all the cameras (see vpMbTracker::setPosePrediction()).
+
+  \param method : Motion model.
+*/
+void vpMbEdgeMultiTracker::setPosePrediction(const vpMbtPosePredictionMethod &method) {
+  for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
+      it != m_mapOfEdgeTrackers.end(); ++it) {
+    it->second->setPosePrediction(method);
+  }
+
+  vpMbTracker::setPosePrediction(method);
+}
+
+/*!
+  Set the parameters of the Kalman filter used by the KALMAN_PREDICTION
+  motion model, for all the cameras (see
+  vpMbTracker::setPosePredictionKalmanParameters()).
+
+  \param stateVariance : Variance of the acceleration of the camera.
+  \param measureVariance : Variance of the velocity measured by the tracking.
+  \param rho : Degree of correlation between successive accelerations, in
+  [0, 1[.
+*/
+void vpMbEdgeMultiTracker::setPosePredictionKalmanParameters(const double stateVariance, const double measureVariance,
+                                                  const double rho) {
+  for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
+      it != m_mapOfEdgeTrackers.end(); ++it) {
+    it->second->setPosePredictionKalmanParameters(stateVariance, measureVariance, rho);
+  }
+
+  vpMbTracker::setPosePredictionKalmanParameters(stateVariance, measureVariance, rho);
+}
+
 /*!
   Set the pose to be used in entry of the next call to the track() function.
   This pose will be just used once.
@@ -2773,6 +2921,23 @@ void vpMbEdgeMultiTracker::setScales(const std::vector<bool>& scale) {
   }
 }
 
+/*!
+  Enable or disable the parallel rendering of the scanline visibility test of
+  all the cameras.
+
+  \param threaded : true to render both image axes in parallel.
+
+  \sa vpMbTracker::setScanLineThreaded()
+*/
+void vpMbEdgeMultiTracker::setScanLineThreaded(const bool threaded) {
+  vpMbTracker::setScanLineThreaded(threaded);
+
+  for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
+      it != m_mapOfEdgeTrackers.end(); ++it) {
+    it->second->setScanLineThreaded(threaded);
+  }
+}
+
 void vpMbEdgeMultiTracker::setScanLineVisibilityTest(const bool &v) {
   //Set general setScanLineVisibilityTest
   vpMbTracker::setScanLineVisibilityTest(v);
@@ -2796,8 +2961,15 @@ void vpMbEdgeMultiTracker::track(const vpImage<unsigned char> &I) {
   std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.find(m_referenceCameraName);
 
   if(it != m_mapOfEdgeTrackers.end()) {
+    // The camera velocity is the one of the reference camera
+    if(m_cameraDisplacementValid) {
+      it->second->m_cameraDisplacement = m_cameraDisplacement;
+      it->second->m_cameraDisplacementValid = true;
+      m_cameraDisplacementValid = false;
+    }
     it->second->track(I);
     it->second->getPose(cMo);
+    it->second->getFeatureStatistics(m_nbTrackedPrimitives, m_nbTrackedSites, m_nbValidSites, m_trackingTime);
   } else {
     std::stringstream ss;
     ss << "The reference camera: " << m_referenceCameraName << " does not exist !";
@@ -2854,8 +3026,26 @@ void vpMbEdgeMultiTracker::track(std::map<std::string, const vpImage<unsigned ch
   }
 
 
+  double t0 = vpTime::measureTimeMs();
+
   initPyramid(mapOfImages, m_mapOfPyramidalImages);
 
+  bool posePredicted = predictPose();
+
+  //The per camera stages are processed in parallel on these vectors
+  std::vector<vpMbEdgeTracker *> trackers;
+  std::vector<const vpImage<unsigned char> *> images;
+  std::vector<vpHomogeneousMatrix> cameraTransformations;
+  std::vector<const std::vector<const vpImage<unsigned char>* > *> pyramids;
+  for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
+      it != m_mapOfEdgeTrackers.end(); ++it) {
+    trackers.push_back(it->second);
+    images.push_back(mapOfImages[it->first]);
+    cameraTransformations.push_back(m_mapOfCameraTransformationMatrix[it->first]);
+    pyramids.push_back(&m_mapOfPyramidalImages[it->first]);
+  }
+  int nbCameras = (int) trackers.size();
+
   unsigned int lvl = (unsigned int) scales.size();
   do {
     lvl--;
@@ -2867,19 +3057,31 @@ void vpMbEdgeMultiTracker::track(std::map<std::string, const vpImage<unsigned ch
       try
       {
         downScale(lvl);
-        for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it1 = m_mapOfEdgeTrackers.begin();
-            it1 != m_mapOfEdgeTrackers.end(); ++it1) {
+
+        vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+        #pragma omp parallel for if(m_camerasThreaded)
+#endif
+        for(int k = 0; k < nbCameras; k++) {
+          if(! m_camerasThreaded && error.raised())
+            continue;
           //Downscale for each camera
-          it1->second->downScale(lvl);
+          trackers[(size_t) k]->downScale(lvl);
+
+          if(posePredicted) {
+            trackers[(size_t) k]->cMo = cameraTransformations[(size_t) k]*cMo;
+            trackers[(size_t) k]->predictMovingEdge();
+          }
 
           //Track moving edges
           try {
-            it1->second->trackMovingEdge(*m_mapOfPyramidalImages[it1->first][lvl]);
-          } catch(...) {
+            trackers[(size_t) k]->trackMovingEdge(*(*pyramids[(size_t) k])[lvl]);
+          } catch(vpException &e) {
             vpTRACE("Error in moving edge tracking") ;
-            throw ;
+            error.set(k, e);
           }
         }
+        error.rethrow();
 
         try {
           std::map<std::string, const vpImage<unsigned char> *> mapOfPyramidImages;
@@ -2896,20 +3098,29 @@ void vpMbEdgeMultiTracker::track(std::map<std::string, const vpImage<unsigned ch
 
 
         //Test tracking failed only if all testTracking failed
-        bool isOneTestTrackingOk = false;
-        for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-            it != m_mapOfEdgeTrackers.end(); ++it) {
+        std::vector<int> testTrackingOk((size_t) nbCameras, 0);
+#ifdef VISP_HAVE_OPENMP
+        #pragma omp parallel for if(m_camerasThreaded)
+#endif
+        for(int k = 0; k < nbCameras; k++) {
           //Set the camera pose
-          it->second->cMo = m_mapOfCameraTransformationMatrix[it->first]*cMo;
+          trackers[(size_t) k]->cMo = cameraTransformations[(size_t) k]*cMo;
 
           try {
-            it->second->testTracking();
-            isOneTestTrackingOk = true;
+            trackers[(size_t) k]->testTracking();
+            testTrackingOk[(size_t) k] = 1;
           } catch(/*vpException &e*/...) {
       //      throw e;
           }
         }
 
+        bool isOneTestTrackingOk = false;
+        for(int k = 0; k < nbCameras; k++) {
+          if(testTrackingOk[(size_t) k]) {
+            isOneTestTrackingOk = true;
+          }
+        }
+
         if(!isOneTestTrackingOk) {
           std::ostringstream oss;
           oss << "Not enough moving edges to track the object. Try to reduce the threshold="
@@ -2919,56 +3130,76 @@ void vpMbEdgeMultiTracker::track(std::map<std::string, const vpImage<unsigned ch
 
 
         if(displayFeatures) {
-          for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-                      it != m_mapOfEdgeTrackers.end(); ++it) {
-            it->second->displayFeaturesOnImage(*mapOfImages[it->first], lvl);
+          for(int k = 0; k < nbCameras; k++) {
+            trackers[(size_t) k]->displayFeaturesOnImage(*images[(size_t) k], lvl);
           }
         }
 
-        // Looking for new visible face
-        bool newvisibleface = false;
-        for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-            it != m_mapOfEdgeTrackers.end(); ++it) {
-          it->second->visibleFace(*mapOfImages[it->first], it->second->cMo, newvisibleface);
-        }
-
-        if(useScanLine) {
-          for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-                      it != m_mapOfEdgeTrackers.end(); ++it) {
-            it->second->faces.computeClippedPolygons(it->second->cMo, it->second->cam);
-            it->second->faces.computeScanLineRender(it->second->cam, mapOfImages[it->first]->getWidth(),
-                mapOfImages[it->first]->getHeight());
+        // Looking for new visible face. The Ogre rendering is not thread safe.
+#ifdef VISP_HAVE_OPENMP
+        #pragma omp parallel for if(m_camerasThreaded && ! useOgre)
+#endif
+        for(int k = 0; k < nbCameras; k++) {
+          if((! m_camerasThreaded || useOgre) && error.raised())
+            continue;
+          vpMbEdgeTracker *tracker = trackers[(size_t) k];
+          try {
+            bool newvisibleface = false;
+            tracker->visibleFace(*images[(size_t) k], tracker->cMo, newvisibleface);
+
+            if(useScanLine) {
+              tracker->faces.computeClippedPolygons(tracker->cMo, tracker->cam);
+              tracker->faces.computeScanLineRender(tracker->cam, images[(size_t) k]->getWidth(),
+                  images[(size_t) k]->getHeight());
+            }
+          } catch(vpException &e) {
+            error.set(k, e);
           }
         }
+        error.rethrow();
 
-        try {
-          for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-                      it != m_mapOfEdgeTrackers.end(); ++it) {
-            it->second->updateMovingEdge(*mapOfImages[it->first]);
+#ifdef VISP_HAVE_OPENMP
+        #pragma omp parallel for if(m_camerasThreaded)
+#endif
+        for(int k = 0; k < nbCameras; k++) {
+          if(! m_camerasThreaded && error.raised())
+            continue;
+          try {
+            trackers[(size_t) k]->updateMovingEdge(*images[(size_t) k]);
+          } catch(vpException &e) {
+            error.set(k, e);
           }
-        } catch(...) {
-          throw; // throw the original exception
         }
+        error.rethrow();
 
-        for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-            it != m_mapOfEdgeTrackers.end(); ++it) {
-          it->second->initMovingEdge(*mapOfImages[it->first], it->second->cMo);
+#ifdef VISP_HAVE_OPENMP
+        #pragma omp parallel for if(m_camerasThreaded)
+#endif
+        for(int k = 0; k < nbCameras; k++) {
+          if(! m_camerasThreaded && error.raised())
+            continue;
+          vpMbEdgeTracker *tracker = trackers[(size_t) k];
+          try {
+            tracker->initMovingEdge(*images[(size_t) k], tracker->cMo);
 
-          // Reinit the moving edge for the lines which need it.
-          it->second->reinitMovingEdge(*mapOfImages[it->first], it->second->cMo);
+            // Reinit the moving edge for the lines which need it.
+            tracker->reinitMovingEdge(*images[(size_t) k], tracker->cMo);
 
-          if(computeProjError) {
-            //Compute the projection error
-            it->second->computeProjectionError(*mapOfImages[it->first]);
+            if(computeProjError) {
+              //Compute the projection error
+              tracker->computeProjectionError(*images[(size_t) k]);
+            }
+          } catch(vpException &e) {
+            error.set(k, e);
           }
         }
+        error.rethrow();
 
         computeProjectionError();
 
         upScale(lvl);
-        for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-            it != m_mapOfEdgeTrackers.end(); ++it) {
-          it->second->upScale(lvl);
+        for(int k = 0; k < nbCameras; k++) {
+          trackers[(size_t) k]->upScale(lvl);
         }
       }
       catch(vpException &e)
@@ -2978,18 +3209,16 @@ void vpMbEdgeMultiTracker::track(std::map<std::string, const vpImage<unsigned ch
           reInitLevel(lvl);
           upScale(lvl);
 
-          for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-              it != m_mapOfEdgeTrackers.end(); ++it) {
-            it->second->cMo = cMo_1;
-            it->second->reInitLevel(lvl);
-            it->second->upScale(lvl);
+          for(int k = 0; k < nbCameras; k++) {
+            trackers[(size_t) k]->cMo = cMo_1;
+            trackers[(size_t) k]->reInitLevel(lvl);
+            trackers[(size_t) k]->upScale(lvl);
           }
         }
         else{
           upScale(lvl);
-          for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-              it != m_mapOfEdgeTrackers.end(); ++it) {
-            it->second->upScale(lvl);
+          for(int k = 0; k < nbCameras; k++) {
+            trackers[(size_t) k]->upScale(lvl);
           }
           throw(e) ;
         }
@@ -2998,4 +3227,8 @@ void vpMbEdgeMultiTracker::track(std::map<std::string, const vpImage<unsigned ch
   } while(lvl != 0);
 
   cleanPyramid(m_mapOfPyramidalImages);
+
+  updatePosePrediction();
+
+  adaptFeatureBudget(vpTime::measureTimeMs() - t0);
 }
@@ -51,6 +51,7 @@
 #include <visp3/core/vpMath.h>
 #include <visp3/core/vpException.h>
 #include <visp3/core/vpTrackingException.h>
+#include <visp3/core/vpTime.h>
 #include <visp3/mbt/vpMbEdgeTracker.h>
 #include <visp3/mbt/vpMbtDistanceLine.h>
 #include <visp3/mbt/vpMbtXmlParser.h>
@@ -62,6 +63,9 @@
 #include <sstream>
 #include <float.h>
 #include <map>
+#include <algorithm>
+
+#include "../vpMbtParallelError_impl.h"
 
 
 /*!
@@ -70,7 +74,9 @@
 vpMbEdgeTracker::vpMbEdgeTracker()
   : compute_interaction(1), lambda(1), me(), lines(1), circles(1), cylinders(1), nline(0), ncircle(0), ncylinder(0),
     nbvisiblepolygone(0), percentageGdPt(0.4), scales(1),
-    Ipyramid(0), scaleLevel(0), nbFeaturesForProjErrorComputation(0)
+    Ipyramid(0), scaleLevel(0), nbFeaturesForProjErrorComputation(0), threadedMovingEdge(false),
+    m_featureBudget(0), m_featureBudgetLatency(0), m_featureBudgetCurrent(0), m_nbTrackedPrimitives(0),
+    m_nbTrackedSites(0), m_nbValidSites(0), m_trackingTime(0), m_lineIndex(1), m_lineIndexSize(1, 0)
 {
   angleAppears = vpMath::rad(89);
   angleDisappears = vpMath::rad(89);
@@ -156,6 +162,62 @@ vpMbEdgeTracker::setMovingEdge(const vpMe &p_me)
   }
 }
 
+/*!
+  Set the number of moving edges distributed over the visible lines and
+  cylinders at each frame, instead of sampling every primitive with the sample
+  step of the moving edges parameters.
+
+  After each virtual visual servoing, the budget is shared out between the
+  primitives in proportion to their informativeness: their length in the
+  image, the rarity of their orientation among the visible primitives, as
+  lines with a rare orientation constrain directions of the pose that the
+  others do not, and the ratio of their moving edges kept by the robust
+  estimation at this frame. The sample step of each primitive is set
+  accordingly, between vpMe::getMinSampleStep() and half its length, and is
+  applied when the moving edges are updated. At a pyramid level \e l of the
+  multi-scale tracking, the budget is divided by \f$ 2^l \f$. The circles keep
+  the sample step of the moving edges parameters.
+
+  If a targeted duration is given, the budget is adapted after each call to
+  track() so that its duration converges to the target: it is multiplied by
+  the ratio between the targeted and the measured durations, bounded between
+  0.8 and 1.25 to smooth out the variations, and is kept between 10% and 100%
+  of \e nbSites.
+
+  \param nbSites : Number of moving edges distributed over the primitives at
+  each frame, 0 to use the sample step of the moving edges parameters
+  (default).
+  \param latency : Targeted duration of a call to track() in ms, 0 to keep a
+  constant budget.
+
+  \sa getFeatureBudget(), getFeatureStatistics()
+*/
+void
+vpMbEdgeTracker::setFeatureBudget(const unsigned int nbSites, const double latency)
+{
+  if(latency < 0){
+    throw vpException(vpException::badValue, "The targeted duration of a frame must be positive");
+  }
+
+  m_featureBudget = nbSites;
+  m_featureBudgetLatency = latency;
+  m_featureBudgetCurrent = (double)nbSites;
+
+  if(m_featureBudget == 0){
+    for (unsigned int i = 0; i < scales.size(); i += 1){
+      if(scales[i]){
+        for(std::list<vpMbtDistanceLine*>::const_iterator it=lines[i].begin(); it!=lines[i].end(); ++it){
+          (*it)->setSampleStep(0);
+        }
+
+        for(std::list<vpMbtDistanceCylinder*>::const_iterator it=cylinders[i].begin(); it!=cylinders[i].end(); ++it){
+          (*it)->setSampleStep(0, 0);
+        }
+      }
+    }
+  }
+}
+
 /*!
   Compute the visual servoing loop to get the pose of the feature set.
   
@@ -168,17 +230,7 @@ vpMbEdgeTracker::setMovingEdge(const vpMe &p_me)
 void
 vpMbEdgeTracker::computeVVS(const vpImage<unsigned char>& _I, const unsigned int lvl)
 {
-  double residu_1 = 1e3;
-  double r = 1e3-1;
-  vpMatrix LTL;
-  vpColVector LTR;
-
-  //vpColVector w;
   vpColVector factor;
-  //vpColVector error; // s-s*
-  vpColVector weighted_error; // Weighted error vector wi(s-s)*
-  vpVelocityTwistMatrix cVo;
-
   unsigned int iter = 0;
 
   //Nombre de moving edges
@@ -193,12 +245,11 @@ vpMbEdgeTracker::computeVVS(const vpImage<unsigned char>& _I, const unsigned int
     throw vpTrackingException(vpTrackingException::notEnoughPointError, "No data found to compute the interaction matrix...");
   }
   
-  vpMatrix L(nbrow,6), Lp;
+  vpMatrix L(nbrow,6);
 
   // compute the error vector
   m_error.resize(nbrow);
   unsigned int nerror = m_error.getRows();
-  vpColVector v ;
 
   bool reloop = true;
   
@@ -212,7 +263,6 @@ vpMbEdgeTracker::computeVVS(const vpImage<unsigned char>& _I, const unsigned int
   {
     if(iter==0)
     {
-      weighted_error.resize(nerror) ;
       m_w.resize(nerror);
       m_w = 0;
       factor.resize(nerror);
@@ -231,7 +281,7 @@ vpMbEdgeTracker::computeVVS(const vpImage<unsigned char>& _I, const unsigned int
       reloop = true;
     }
 
-    computeVVSFirstPhasePoseEstimation(nerror, iter, factor, weighted_error, L, isoJoIdentity_);
+    computeVVSFirstPhasePoseEstimation(iter, factor, L, isoJoIdentity_);
 
     iter++;
   }
@@ -247,7 +297,6 @@ vpMbEdgeTracker::computeVVS(const vpImage<unsigned char>& _I, const unsigned int
   robust_lines.setIteration(0) ;
   robust_cylinders.setIteration(0) ;
   robust_circles.setIteration(0) ;
-  iter = 0;
   vpColVector w_lines(nberrors_lines);
   vpColVector w_cylinders(nberrors_cylinders);
   vpColVector w_circles(nberrors_circles);
@@ -256,47 +305,32 @@ vpMbEdgeTracker::computeVVS(const vpImage<unsigned char>& _I, const unsigned int
   vpColVector error_circles(nberrors_circles);
 
   vpHomogeneousMatrix cMoPrev;
-  vpColVector W_true;
   vpMatrix L_true;
-  vpMatrix LVJ_true;
 
-  double mu = 0.01;
-  vpColVector m_error_prev(nbrow);
-  vpColVector m_w_prev(nbrow);
-  
-  while ( ((int)((residu_1 - r)*1e8) !=0 )  && (iter<30))
+  vpMbtVVSSolver solver(m_optimizationMethod, lambda, 30);
+  solver.setStopCriteria(m_stopCriteriaResidual, m_stopCriteriaIncrement);
+
+  while (! solver.hasConverged())
   {
     computeVVSSecondPhase(_I, L, error_lines, error_cylinders, error_circles, m_error, lvl);
 
-    bool reStartFromLastIncrement = false;
-
-    computeVVSSecondPhaseCheckLevenbergMarquardt(iter, nbrow, m_error_prev, m_w_prev, cMoPrev, mu, reStartFromLastIncrement);
-
-    if(!reStartFromLastIncrement){
-      computeVVSSecondPhaseWeights(iter, nerror, nbrow, weighted_error, robust_lines, robust_cylinders, robust_circles,
+    if(solver.rejectIncrement(m_error, m_w)){
+      cMo = cMoPrev;
+    }
+    else{
+      computeVVSSecondPhaseWeights(solver.getIteration(), nbrow, robust_lines, robust_cylinders, robust_circles,
           w_lines, w_cylinders, w_circles, error_lines, error_cylinders, error_circles, nberrors_lines, nberrors_cylinders,
           nberrors_circles);
 
-      computeVVSSecondPhasePoseEstimation(nerror, L, L_true, LVJ_true, W_true, factor, iter, isoJoIdentity_,
-          weighted_error, mu, m_error_prev, m_w_prev, cMoPrev, residu_1, r);
-
-    } // endif(!restartFromLast)
+      computeVVSSecondPhasePoseEstimation(solver, L, L_true, factor, isoJoIdentity_, cMoPrev);
+    }
 
-    iter++;
+    solver.nextIteration();
   }
 
 //   std::cout << "VVS estimate pose cMo:\n" << cMo << std::endl;
   if(computeCovariance){
-    vpMatrix D;
-    D.diag(W_true);
-
-    // Note that here the covariance is computed on cMoPrev for time computation efficiency
-    if(isoJoIdentity_){
-        covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,L_true,D);
-    }
-    else{
-        covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,LVJ_true,D);
-    }
+    computeVVSSecondPhaseCovariance(L_true, solver.getWeights(), isoJoIdentity_, cMoPrev);
   }
 
   updateMovingEdgeWeights();
@@ -365,7 +399,7 @@ vpMbEdgeTracker::computeVVSFirstPhase(const vpImage<unsigned char>& _I, const un
           if (iter == 0)
           {
             factor[n+i] = fac;
-            vpMeSite site = *itListLine;
+            const vpMeSite &site = *itListLine;
             if (site.getState() != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
             ++itListLine;
           }
@@ -444,16 +478,16 @@ vpMbEdgeTracker::computeVVSFirstPhase(const vpImage<unsigned char>& _I, const un
         if (iter == 0)
         {
           factor[n+i] = fac;
-          vpMeSite site;
+          vpMeSite::vpMeSiteState state;
           if(i<cy->nbFeaturel1) {
-            site= *itCyl1;
+            state = itCyl1->getState();
             ++itCyl1;
           }
           else{
-            site= *itCyl2;
+            state = itCyl2->getState();
             ++itCyl2;
           }
-          if (site.getState() != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
+          if (state != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
         }
 
         //If pour la premiere extremite des moving edges
@@ -548,7 +582,7 @@ vpMbEdgeTracker::computeVVSFirstPhase(const vpImage<unsigned char>& _I, const un
         if (iter == 0)
         {
           factor[n+i] = fac;
-          vpMeSite site = *itCir;
+          const vpMeSite &site = *itCir;
           if (site.getState() != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
           ++itCir;
         }
@@ -632,7 +666,7 @@ vpMbEdgeTracker::computeVVSFirstPhaseFactor(const vpImage<unsigned char>& I, vpC
 
           for (unsigned int i=0 ; i < l->nbFeature[a] ; i++){
               factor[n+i] = fac;
-              vpMeSite site = *itListLine;
+              const vpMeSite &site = *itListLine;
               if (site.getState() != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
               ++itListLine;
               indexFeature++;
@@ -658,16 +692,16 @@ vpMbEdgeTracker::computeVVSFirstPhaseFactor(const vpImage<unsigned char>& I, vpC
 
       for(unsigned int i=0 ; i < cy->nbFeature ; i++){
         factor[n+i] = fac;
-        vpMeSite site;
+        vpMeSite::vpMeSiteState state;
         if(i<cy->nbFeaturel1) {
-          site= *itCyl1;
+          state = itCyl1->getState();
           ++itCyl1;
         }
         else{
-          site= *itCyl2;
+          state = itCyl2->getState();
           ++itCyl2;
         }
-        if (site.getState() != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
+        if (state != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
       }
 
       n+= cy->nbFeature ;
@@ -687,7 +721,7 @@ vpMbEdgeTracker::computeVVSFirstPhaseFactor(const vpImage<unsigned char>& I, vpC
 
       for(unsigned int i=0 ; i < ci->nbFeature ; i++){
         factor[n+i] = fac;
-        vpMeSite site = *itCir;
+        const vpMeSite &site = *itCir;
         if (site.getState() != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
         ++itCir;
       }
@@ -698,40 +732,17 @@ vpMbEdgeTracker::computeVVSFirstPhaseFactor(const vpImage<unsigned char>& I, vpC
 }
 
 void
-vpMbEdgeTracker::computeVVSFirstPhasePoseEstimation(const unsigned int nerror, const unsigned int iter, const vpColVector &factor,
-    vpColVector &weighted_error, vpMatrix &L, bool &isoJoIdentity_) {
-
-  double wi, eri;
-  if((iter==0) || compute_interaction) {
-    for (unsigned int i = 0; i < nerror; i++) {
-      wi = m_w[i]*factor[i];
-      eri = m_error[i];
-
-      weighted_error[i] =  wi*eri;
-
-      for (unsigned int j = 0; j < 6; j++) {
-        L[i][j] = wi*L[i][j];
-      }
-    }
-  } else {
-    for(unsigned int i = 0; i < nerror; i++) {
-      wi = m_w[i]*factor[i];
-      eri = m_error[i];
-
-      weighted_error[i] =  wi*eri;
-    }
-  }
-
-  vpVelocityTwistMatrix cVo;
+vpMbEdgeTracker::computeVVSFirstPhasePoseEstimation(const unsigned int iter, const vpColVector &factor,
+    const vpMatrix &L, bool &isoJoIdentity_) {
+  vpMbtVVSSolver solver(vpMbTracker::GAUSS_NEWTON_OPT, 0.7, 1);
+  solver.computeIncrement(L, m_error, m_w, &factor, (iter==0) || compute_interaction);
 
   // If all the 6 dof should be estimated, we check if the interaction matrix is full rank.
   // If not we remove automatically the dof that cannot be estimated
   // This is particularly useful when consering circles (rank 5) and cylinders (rank 4)
   if (isoJoIdentity_) {
-    cVo.buildFrom(cMo);
-
     vpMatrix K; // kernel
-    unsigned int rank = (L*cVo).kernel(K);
+    unsigned int rank = solver.kernel(cMo, K);
     if(rank == 0) {
       throw vpException(vpException::fatalError, "Rank=0, cannot estimate the pose !");
     }
@@ -745,23 +756,7 @@ vpMbEdgeTracker::computeVVSFirstPhasePoseEstimation(const unsigned int nerror, c
   }
 
   vpColVector v;
-  vpMatrix LTL;
-  vpColVector LTR;
-
-  if(isoJoIdentity_){
-      LTL = L.AtA();
-      computeJTR(L, weighted_error, LTR);
-      v = -0.7*LTL.pseudoInverse(LTL.getRows()*std::numeric_limits<double>::epsilon())*LTR;
-  }
-  else{
-      cVo.buildFrom(cMo);
-      vpMatrix LVJ = (L*cVo*oJo);
-      vpMatrix LVJTLVJ = (LVJ).AtA();
-      vpColVector LVJTR;
-      computeJTR(LVJ, weighted_error, LVJTR);
-      v = -0.7*LVJTLVJ.pseudoInverse(LVJTLVJ.getRows()*std::numeric_limits<double>::epsilon())*LVJTR;
-      v = cVo * v;
-  }
+  solver.getIncrement(cMo, isoJoIdentity_, oJo, v);
 
   cMo =  vpExponentialMap::direct(v).inverse() * cMo;
 }
@@ -829,152 +824,57 @@ vpMbEdgeTracker::computeVVSSecondPhase(const vpImage<unsigned char>& _I, vpMatri
   }
 }
 
-void
-vpMbEdgeTracker::computeVVSSecondPhaseCheckLevenbergMarquardt(const unsigned int iter, const unsigned int nbrow,
-    const vpColVector &m_error_prev, const vpColVector &m_w_prev, const vpHomogeneousMatrix &cMoPrev,
-    double &mu, bool &reStartFromLastIncrement) {
-  if(iter != 0 && m_optimizationMethod == vpMbTracker::LEVENBERG_MARQUARDT_OPT){
-    if(m_error.sumSquare()/(double)nbrow > m_error_prev.sumSquare()/(double)nbrow){
-      mu *= 10.0;
-
-      if(mu > 1.0)
-        throw vpTrackingException(vpTrackingException::fatalError, "Optimization diverged");
-
-      cMo = cMoPrev;
-      m_error = m_error_prev;
-      m_w = m_w_prev;
-      reStartFromLastIncrement = true;
-    }
-  }
-}
+/*!
+  Compute the covariance matrix of the pose estimated by the second phase of
+  the virtual visual servoing.
 
+  \param L_true : Interaction matrix at the last pose increment.
+  \param W_true : Weights of the features at the last pose increment.
+  \param isoJoIdentity_ : If false, only the degrees of freedom selected by oJo are estimated.
+  \param cMoPrev : Pose before the last increment.
+*/
 void
-vpMbEdgeTracker::computeVVSSecondPhasePoseEstimation(const unsigned int nerror, vpMatrix &L, vpMatrix &L_true,
-    vpMatrix &LVJ_true, vpColVector &W_true, const vpColVector &factor, const unsigned int iter, const bool isoJoIdentity_,
-    vpColVector &weighted_error, double &mu, vpColVector &m_error_prev, vpColVector &m_w_prev,
-    vpHomogeneousMatrix &cMoPrev, double &residu_1, double &r) {
-  double num=0;
-  double den=0;
-  double wi;
-  double eri;
-
-  vpMatrix LTL;
-  vpColVector LTR;
-
-  L_true = L;
-  W_true = vpColVector(nerror);
-
-  vpVelocityTwistMatrix cVo;
-  if(computeCovariance){
-      L_true = L;
-     if(!isoJoIdentity_){
-       cVo.buildFrom(cMo);
-       LVJ_true = (L*cVo*oJo);
-     }
-  }
-
-  if((iter==0)|| compute_interaction) {
-    for (unsigned int i = 0; i < nerror; i++) {
-      wi = m_w[i]*factor[i];
-      W_true[i] = wi;
-      eri = m_error[i];
-      num += wi*vpMath::sqr(eri);
-      den += wi;
-
-      weighted_error[i] =  wi*eri ;
-
-      for (unsigned int j = 0; j < 6; j++) {
-        L[i][j] = wi*L[i][j];
-      }
-    }
-  } else {
-    for(unsigned int i = 0; i < nerror; i++) {
-      wi = m_w[i]*factor[i];
-      W_true[i] = wi;
-      eri = m_error[i];
-      num += wi*vpMath::sqr(eri);
-      den += wi;
-
-      weighted_error[i] =  wi*eri ;
-    }
-  }
+vpMbEdgeTracker::computeVVSSecondPhaseCovariance(const vpMatrix &L_true, const vpColVector &W_true,
+    const bool isoJoIdentity_, const vpHomogeneousMatrix &cMoPrev) {
+  vpMatrix D;
+  D.diag(W_true);
 
-  vpColVector v;
+  // Note that here the covariance is computed on cMoPrev for time computation efficiency
   if(isoJoIdentity_){
-    LTL = L.AtA();
-    computeJTR(L, weighted_error, LTR);
-
-    switch(m_optimizationMethod){
-    case vpMbTracker::LEVENBERG_MARQUARDT_OPT:
-    {
-      vpMatrix LMA(LTL.getRows(), LTL.getCols());
-      LMA.eye();
-      vpMatrix LTLmuI = LTL + (LMA*mu);
-      v = -lambda*LTLmuI.pseudoInverse(LTLmuI.getRows()*std::numeric_limits<double>::epsilon())*LTR;
-
-      if(iter != 0)
-        mu /= 10.0;
-
-      m_error_prev = m_error;
-      m_w_prev = m_w;
-      break;
-    }
-    case vpMbTracker::GAUSS_NEWTON_OPT:
-    default:
-      v = -lambda*LTL.pseudoInverse(LTL.getRows()*std::numeric_limits<double>::epsilon())*LTR;
-    }
+      covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,L_true,D);
   }
   else{
-    cVo.buildFrom(cMo);
-    vpMatrix LVJ = (L*cVo*oJo);
-    vpMatrix LVJTLVJ = (LVJ).AtA();
-    vpColVector LVJTR;
-    computeJTR(LVJ, weighted_error, LVJTR);
-
-    switch(m_optimizationMethod){
-    case vpMbTracker::LEVENBERG_MARQUARDT_OPT:
-    {
-      vpMatrix LMA(LVJTLVJ.getRows(), LVJTLVJ.getCols());
-      LMA.eye();
-      vpMatrix LTLmuI = LVJTLVJ + (LMA*mu);
-      v = -lambda*LTLmuI.pseudoInverse(LTLmuI.getRows()*std::numeric_limits<double>::epsilon())*LVJTR;
-      v = cVo * v;
+      vpVelocityTwistMatrix cVo;
+      cVo.buildFrom(cMoPrev);
+      vpMatrix LVJ_true = (L_true*cVo*oJo);
+      covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,LVJ_true,D);
+  }
+}
 
-      if(iter != 0)
-        mu /= 10.0;
+void
+vpMbEdgeTracker::computeVVSSecondPhasePoseEstimation(vpMbtVVSSolver &solver, const vpMatrix &L, vpMatrix &L_true,
+    const vpColVector &factor, const bool isoJoIdentity_, vpHomogeneousMatrix &cMoPrev) {
+  if(computeCovariance)
+    L_true = L;
 
-      m_error_prev = m_error;
-      m_w_prev = m_w;
-      break;
-    }
-    case vpMbTracker::GAUSS_NEWTON_OPT:
-    default:
-    {
-      v = -lambda*LVJTLVJ.pseudoInverse(LVJTLVJ.getRows()*std::numeric_limits<double>::epsilon())*LVJTR;
-      v = cVo * v;
-      break;
-    }
-    }
-  }
+  solver.computeIncrement(L, m_error, m_w, &factor, (solver.getIteration()==0) || compute_interaction);
 
-  residu_1 = r;
-  r = sqrt(num/den); //Le critere d'arret prend en compte le poids
+  vpColVector v;
+  solver.getIncrement(cMo, isoJoIdentity_, oJo, v);
 
   cMoPrev = cMo;
   cMo =  vpExponentialMap::direct(v).inverse() * cMo;
 }
 
 void
-vpMbEdgeTracker::computeVVSSecondPhaseWeights(const unsigned int iter, const unsigned int nerror,
-    const unsigned int nbrow, vpColVector &weighted_error,
+vpMbEdgeTracker::computeVVSSecondPhaseWeights(const unsigned int iter, const unsigned int nbrow,
     vpRobust &robust_lines, vpRobust &robust_cylinders, vpRobust &robust_circles,
     vpColVector &w_lines, vpColVector &w_cylinders, vpColVector &w_circles,
     vpColVector &error_lines, vpColVector &error_cylinders, vpColVector &error_circles,
     const unsigned int nberrors_lines, const unsigned int nberrors_cylinders, const unsigned int nberrors_circles) {
   if(iter==0)
   {
-    weighted_error.resize(nerror);
-    m_w.resize(nerror);
+    m_w.resize(nbrow);
     m_w = 1;
     w_lines.resize(nberrors_lines);
     w_lines = 1;
@@ -1116,7 +1016,7 @@ vpMbEdgeTracker::testTracking()
         if(l->meline[a] != NULL){
           nbExpectedPoint += (int)l->meline[a]->expecteddensity;
           for(std::list<vpMeSite>::const_iterator itme=l->meline[a]->getMeList().begin(); itme!=l->meline[a]->getMeList().end(); ++itme){
-            vpMeSite pix = *itme;
+            const vpMeSite &pix = *itme;
             if (pix.getState() == vpMeSite::NO_SUPPRESSION) nbGoodPoint++;
             else nbBadPoint++;
           }
@@ -1131,13 +1031,13 @@ vpMbEdgeTracker::testTracking()
     {
       nbExpectedPoint += (int)cy->meline1->expecteddensity;
       for(std::list<vpMeSite>::const_iterator itme1=cy->meline1->getMeList().begin(); itme1!=cy->meline1->getMeList().end(); ++itme1){
-        vpMeSite pix = *itme1;
+        const vpMeSite &pix = *itme1;
         if (pix.getState() == vpMeSite::NO_SUPPRESSION) nbGoodPoint++;
         else nbBadPoint++;
       }
       nbExpectedPoint += (int)cy->meline2->expecteddensity;
       for(std::list<vpMeSite>::const_iterator itme2=cy->meline2->getMeList().begin(); itme2!=cy->meline2->getMeList().end(); ++itme2){
-        vpMeSite pix = *itme2;
+        const vpMeSite &pix = *itme2;
         if (pix.getState() == vpMeSite::NO_SUPPRESSION) nbGoodPoint++;
         else nbBadPoint++;
       }
@@ -1150,7 +1050,7 @@ vpMbEdgeTracker::testTracking()
     {
       nbExpectedPoint += ci->meEllipse->getExpectedDensity();
       for(std::list<vpMeSite>::const_iterator itme=ci->meEllipse->getMeList().begin(); itme!=ci->meEllipse->getMeList().end(); ++itme){
-        vpMeSite pix = *itme;
+        const vpMeSite &pix = *itme;
         if (pix.getState() == vpMeSite::NO_SUPPRESSION) nbGoodPoint++;
         else nbBadPoint++;
       }
@@ -1184,7 +1084,11 @@ vpMbEdgeTracker::testTracking()
 void
 vpMbEdgeTracker::track(const vpImage<unsigned char> &I)
 { 
+  double t0 = vpTime::measureTimeMs();
+
   initPyramid(I, Ipyramid);
+
+  bool posePredicted = predictPose();
   
 //  for (int lvl = ((int)scales.size()-1); lvl >= 0; lvl -= 1)
   unsigned int lvl = (unsigned int)scales.size();
@@ -1199,6 +1103,9 @@ vpMbEdgeTracker::track(const vpImage<unsigned char> &I)
       {
         downScale(lvl);
 
+        if(posePredicted)
+          predictMovingEdge();
+
         try
         {  
           trackMovingEdge(*Ipyramid[lvl]);
@@ -1303,6 +1210,11 @@ vpMbEdgeTracker::track(const vpImage<unsigned char> &I)
   } while(lvl != 0);
   
   cleanPyramid(Ipyramid);
+
+  updatePosePrediction();
+  recordKeyFrame(I);
+
+  adaptFeatureBudget(vpTime::measureTimeMs() - t0);
 }
 
 /*!
@@ -1718,85 +1630,302 @@ vpMbEdgeTracker::initMovingEdge(const vpImage<unsigned char> &I, const vpHomogen
 
 
 /*!
-  Track the moving edges in the image.
-  
-  \param I : the image.
+  Move the moving edges of the lines and cylinders of the current scale onto
+  the model projected with the current pose, which has just been predicted
+  by the motion model. The circles are not moved.
 */
 void
-vpMbEdgeTracker::trackMovingEdge(const vpImage<unsigned char> &I)
+vpMbEdgeTracker::predictMovingEdge()
 {
   for(std::list<vpMbtDistanceLine*>::const_iterator it=lines[scaleLevel].begin(); it!=lines[scaleLevel].end(); ++it){
     vpMbtDistanceLine *l = *it;
-    if(l->isVisible() && l->isTracked()){
-      if(l->meline.size() == 0){
-        l->initMovingEdge(I, cMo);
-      }
-      l->trackMovingEdge(I, cMo) ;
-    }
+    if(l->isVisible() && l->isTracked())
+      l->predictMovingEdge(cMo);
   }
 
   for(std::list<vpMbtDistanceCylinder*>::const_iterator it=cylinders[scaleLevel].begin(); it!=cylinders[scaleLevel].end(); ++it){
     vpMbtDistanceCylinder *cy = *it;
-    if(cy->isVisible() && cy->isTracked()) {
-        if(cy->meline1 == NULL || cy->meline2 == NULL){
-          cy->initMovingEdge(I, cMo);
-        }
-        cy->trackMovingEdge(I, cMo) ;
-    }
+    if(cy->isVisible() && cy->isTracked())
+      cy->predictMovingEdge(cMo);
   }
+}
 
-  for(std::list<vpMbtDistanceCircle*>::const_iterator it=circles[scaleLevel].begin(); it!=circles[scaleLevel].end(); ++it){
-    vpMbtDistanceCircle *ci = *it;
-    if(ci->isVisible() && ci->isTracked()){
-      if(ci->meEllipse == NULL){
-        ci->initMovingEdge(I, cMo);
+/*!
+  Track the moving edges in the image.
+
+  If setMovingEdgeThreaded() was enabled, the primitives are tracked in
+  parallel.
+
+  \param I : the image.
+*/
+void
+vpMbEdgeTracker::trackMovingEdge(const vpImage<unsigned char> &I)
+{
+  std::vector<vpMbtDistanceLine*> vlines(lines[scaleLevel].begin(), lines[scaleLevel].end());
+  std::vector<vpMbtDistanceCylinder*> vcylinders(cylinders[scaleLevel].begin(), cylinders[scaleLevel].end());
+  std::vector<vpMbtDistanceCircle*> vcircles(circles[scaleLevel].begin(), circles[scaleLevel].end());
+  int nblines = (int)vlines.size();
+  int nbcylinders = (int)vcylinders.size();
+  int nb = nblines + nbcylinders + (int)vcircles.size();
+
+  vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(threadedMovingEdge) schedule(dynamic)
+#endif
+  for(int k = 0; k < nb; k++){
+    // An exception cannot leave the parallel region, even when it is run by a
+    // single thread: the sequential loop stops at the first error instead.
+    if(! threadedMovingEdge && error.raised())
+      continue;
+    try {
+      if(k < nblines){
+        vpMbtDistanceLine *l = vlines[(size_t)k];
+        if(l->isVisible() && l->isTracked()){
+          if(l->meline.size() == 0){
+            l->initMovingEdge(I, cMo);
+          }
+          l->trackMovingEdge(I, cMo) ;
+        }
+      }
+      else if(k < nblines + nbcylinders){
+        vpMbtDistanceCylinder *cy = vcylinders[(size_t)(k - nblines)];
+        if(cy->isVisible() && cy->isTracked()) {
+          if(cy->meline1 == NULL || cy->meline2 == NULL){
+            cy->initMovingEdge(I, cMo);
+          }
+          cy->trackMovingEdge(I, cMo) ;
+        }
+      }
+      else{
+        vpMbtDistanceCircle *ci = vcircles[(size_t)(k - nblines - nbcylinders)];
+        if(ci->isVisible() && ci->isTracked()){
+          if(ci->meEllipse == NULL){
+            ci->initMovingEdge(I, cMo);
+          }
+          ci->trackMovingEdge(I, cMo) ;
+        }
       }
-      ci->trackMovingEdge(I, cMo) ;
+    }
+    catch(vpException &e) {
+      error.set(k, e);
     }
   }
+  error.rethrow();
 }
 
 
 /*!
-  Update the moving edges at the end of the virtual visual servoing.
-  
-  \param I : the image.
+  Adapt the number of moving edges distributed over the primitives to the
+  duration of the last frame (see setFeatureBudget()).
+
+  \param time : Duration of the last call to track() in ms.
 */
 void
-vpMbEdgeTracker::updateMovingEdge(const vpImage<unsigned char> &I)
+vpMbEdgeTracker::adaptFeatureBudget(const double time)
 {
-  vpMbtDistanceLine *l ;
+  m_trackingTime = time;
+
+  if(m_featureBudget > 0 && m_featureBudgetLatency > 0 && time > 0){
+    double ratio = vpMath::minimum(vpMath::maximum(m_featureBudgetLatency / time, 0.8), 1.25);
+    m_featureBudgetCurrent = vpMath::minimum(vpMath::maximum(m_featureBudgetCurrent * ratio, 0.1 * m_featureBudget),
+                                             (double)m_featureBudget);
+  }
+}
+
+/*!
+  Count the primitives and the moving edges tracked at the current scale, and
+  if setFeatureBudget() was used, share out the budget between the visible
+  lines and cylinders by setting their sample step.
+*/
+void
+vpMbEdgeTracker::updateFeatureBudget()
+{
+  // Length, orientation and ratio of valid moving edges of each line, the two
+  // lines of a cylinder being considered separately
+  std::vector<double> length, orientation, reliability;
+  std::vector<vpMbtDistanceLine*> vlines;
+  std::vector<vpMbtDistanceCylinder*> vcylinders;
+  unsigned int nbPrimitives = 0, nbSites = 0, nbValidSites = 0;
+
   for(std::list<vpMbtDistanceLine*>::const_iterator it=lines[scaleLevel].begin(); it!=lines[scaleLevel].end(); ++it){
-    if((*it)->isTracked()){
-      l = *it;
-      l->updateMovingEdge(I, cMo) ;
-      if (l->nbFeatureTotal == 0 && l->isVisible()){
-        l->Reinit = true;
+    vpMbtDistanceLine *l = *it;
+    if(l->isVisible() && l->isTracked() && ! l->meline.empty()){
+      double len = 0;
+      unsigned int n = 0, nbValid = 0;
+      for(unsigned int a = 0 ; a < l->meline.size() ; a++){
+        len += l->meline[a]->getLength();
+        for(std::list<vpMeSite>::const_iterator itme=l->meline[a]->getMeList().begin(); itme!=l->meline[a]->getMeList().end(); ++itme){
+          n++;
+          if (itme->getState() == vpMeSite::NO_SUPPRESSION) nbValid++;
+        }
       }
+      nbPrimitives++;
+      nbSites += n;
+      nbValidSites += nbValid;
+
+      vlines.push_back(l);
+      length.push_back(len);
+      orientation.push_back(atan2(l->meline[0]->get_b(), l->meline[0]->get_a()));
+      reliability.push_back(n > 0 ? (double)nbValid / n : 1.);
     }
   }
 
-  vpMbtDistanceCylinder *cy ;
   for(std::list<vpMbtDistanceCylinder*>::const_iterator it=cylinders[scaleLevel].begin(); it!=cylinders[scaleLevel].end(); ++it){
-    if((*it)->isTracked()){
-      cy = *it;
-      cy->updateMovingEdge(I, cMo) ;
-      if((cy->nbFeaturel1 == 0 || cy->nbFeaturel2 == 0) && cy->isVisible()){
-        cy->Reinit = true;
+    vpMbtDistanceCylinder *cy = *it;
+    if(cy->isVisible() && cy->isTracked() && cy->meline1 != NULL && cy->meline2 != NULL){
+      vpMbtMeLine *melines[2] = {cy->meline1, cy->meline2};
+      for(unsigned int a = 0 ; a < 2 ; a++){
+        unsigned int n = 0, nbValid = 0;
+        for(std::list<vpMeSite>::const_iterator itme=melines[a]->getMeList().begin(); itme!=melines[a]->getMeList().end(); ++itme){
+          n++;
+          if (itme->getState() == vpMeSite::NO_SUPPRESSION) nbValid++;
+        }
+        nbSites += n;
+        nbValidSites += nbValid;
+
+        length.push_back(melines[a]->getLength());
+        orientation.push_back(atan2(melines[a]->get_b(), melines[a]->get_a()));
+        reliability.push_back(n > 0 ? (double)nbValid / n : 1.);
       }
+      nbPrimitives++;
+      vcylinders.push_back(cy);
     }
   }
 
-  vpMbtDistanceCircle *ci ;
   for(std::list<vpMbtDistanceCircle*>::const_iterator it=circles[scaleLevel].begin(); it!=circles[scaleLevel].end(); ++it){
-    if((*it)->isTracked()){
-      ci = *it;
-      ci->updateMovingEdge(I, cMo) ;
-      if(ci->nbFeature == 0  && ci->isVisible()){
-        ci->Reinit = true;
+    vpMbtDistanceCircle *ci = *it;
+    if(ci->isVisible() && ci->isTracked() && ci->meEllipse != NULL){
+      for(std::list<vpMeSite>::const_iterator itme=ci->meEllipse->getMeList().begin(); itme!=ci->meEllipse->getMeList().end(); ++itme){
+        nbSites++;
+        if (itme->getState() == vpMeSite::NO_SUPPRESSION) nbValidSites++;
+      }
+      nbPrimitives++;
+    }
+  }
+
+  m_nbTrackedPrimitives = nbPrimitives;
+  m_nbTrackedSites = nbSites;
+  m_nbValidSites = nbValidSites;
+
+  if(m_featureBudget == 0 || length.empty())
+    return;
+
+  // Histogram of the orientations modulo pi, weighted by the lengths
+  const unsigned int nbBins = 8;
+  double histogram[nbBins];
+  for(unsigned int b = 0; b < nbBins; b++)
+    histogram[b] = 0;
+  std::vector<unsigned int> bin(length.size());
+  for(size_t k = 0; k < length.size(); k++){
+    double angle = orientation[k];
+    if(angle < 0) angle += M_PI;
+    bin[k] = (unsigned int)(angle / M_PI * nbBins) % nbBins;
+    histogram[bin[k]] += length[k];
+  }
+  double sumHistogram = 0;
+  unsigned int nbUsedBins = 0;
+  for(unsigned int b = 0; b < nbBins; b++){
+    if(histogram[b] > 0){
+      sumHistogram += histogram[b];
+      nbUsedBins++;
+    }
+  }
+  if(nbUsedBins == 0)
+    return;
+  const double meanHistogram = sumHistogram / nbUsedBins;
+
+  // A line whose orientation is rare gets more moving edges, as it constrains
+  // the pose along directions that the other lines do not
+  std::vector<double> weight(length.size());
+  double sumWeight = 0;
+  for(size_t k = 0; k < length.size(); k++){
+    double diversity = 1;
+    if(histogram[bin[k]] > 0)
+      diversity = vpMath::minimum(vpMath::maximum(sqrt(meanHistogram / histogram[bin[k]]), 0.5), 2.);
+    weight[k] = length[k] * diversity * (0.5 + 0.5 * reliability[k]);
+    sumWeight += weight[k];
+  }
+  if(sumWeight <= 0)
+    return;
+
+  const double budget = m_featureBudgetCurrent / (double)(1 << scaleLevel);
+  const double minStep = vpMath::maximum(me.getMinSampleStep(), 1.);
+  std::vector<double> step(length.size());
+  for(size_t k = 0; k < length.size(); k++){
+    double nbAllocated = budget * weight[k] / sumWeight;
+    step[k] = nbAllocated > 1 ? length[k] / nbAllocated : length[k];
+    step[k] = vpMath::maximum(vpMath::minimum(step[k], length[k] / 2), minStep);
+  }
+
+  size_t k = 0;
+  for(size_t i = 0; i < vlines.size(); i++, k++)
+    vlines[i]->setSampleStep(step[k]);
+  for(size_t i = 0; i < vcylinders.size(); i++, k += 2)
+    vcylinders[i]->setSampleStep(step[k], step[k+1]);
+}
+
+/*!
+  Update the moving edges at the end of the virtual visual servoing.
+
+  If setFeatureBudget() was used, the sample step of the primitives is first
+  updated. If setMovingEdgeThreaded() was enabled, the primitives are updated
+  in parallel.
+
+  \param I : the image.
+*/
+void
+vpMbEdgeTracker::updateMovingEdge(const vpImage<unsigned char> &I)
+{
+  updateFeatureBudget();
+
+  std::vector<vpMbtDistanceLine*> vlines(lines[scaleLevel].begin(), lines[scaleLevel].end());
+  std::vector<vpMbtDistanceCylinder*> vcylinders(cylinders[scaleLevel].begin(), cylinders[scaleLevel].end());
+  std::vector<vpMbtDistanceCircle*> vcircles(circles[scaleLevel].begin(), circles[scaleLevel].end());
+  int nblines = (int)vlines.size();
+  int nbcylinders = (int)vcylinders.size();
+  int nb = nblines + nbcylinders + (int)vcircles.size();
+
+  vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(threadedMovingEdge) schedule(dynamic)
+#endif
+  for(int k = 0; k < nb; k++){
+    if(! threadedMovingEdge && error.raised())
+      continue;
+    try {
+      if(k < nblines){
+        vpMbtDistanceLine *l = vlines[(size_t)k];
+        if(l->isTracked()){
+          l->updateMovingEdge(I, cMo) ;
+          if (l->nbFeatureTotal == 0 && l->isVisible()){
+            l->Reinit = true;
+          }
+        }
+      }
+      else if(k < nblines + nbcylinders){
+        vpMbtDistanceCylinder *cy = vcylinders[(size_t)(k - nblines)];
+        if(cy->isTracked()){
+          cy->updateMovingEdge(I, cMo) ;
+          if((cy->nbFeaturel1 == 0 || cy->nbFeaturel2 == 0) && cy->isVisible()){
+            cy->Reinit = true;
+          }
+        }
+      }
+      else{
+        vpMbtDistanceCircle *ci = vcircles[(size_t)(k - nblines - nbcylinders)];
+        if(ci->isTracked()){
+          ci->updateMovingEdge(I, cMo) ;
+          if(ci->nbFeature == 0  && ci->isVisible()){
+            ci->Reinit = true;
+          }
+        }
       }
     }
+    catch(vpException &e) {
+      error.set(k, e);
+    }
   }
+  error.rethrow();
 }
 
 void
@@ -1816,11 +1945,8 @@ vpMbEdgeTracker::updateMovingEdgeWeights() {
 
         for (unsigned int i=0 ; i < l->nbFeature[a] ; i++){
           wmean += m_w[n+indexLine] ;
-          vpMeSite p = *itListLine;
           if (m_w[n+indexLine] < 0.5){
-            p.setState(vpMeSite::M_ESTIMATOR);
-
-            *itListLine = p;
+            itListLine->setState(vpMeSite::M_ESTIMATOR);
           }
 
           ++itListLine;
@@ -1858,11 +1984,8 @@ vpMbEdgeTracker::updateMovingEdgeWeights() {
       wmean = 0;
       for(unsigned int i=0 ; i < cy->nbFeaturel1 ; i++){
         wmean += m_w[n+i] ;
-        vpMeSite p = *itListCyl1;
         if (m_w[n+i] < 0.5){
-          p.setState(vpMeSite::M_ESTIMATOR);
-
-          *itListCyl1 = p;
+          itListCyl1->setState(vpMeSite::M_ESTIMATOR);
         }
 
         ++itListCyl1;
@@ -1882,11 +2005,8 @@ vpMbEdgeTracker::updateMovingEdgeWeights() {
       wmean = 0;
       for(unsigned int i=cy->nbFeaturel1 ; i < cy->nbFeature ; i++){
         wmean += m_w[n+i] ;
-        vpMeSite p = *itListCyl2;
         if (m_w[n+i] < 0.5){
-          p.setState(vpMeSite::M_ESTIMATOR);
-
-          *itListCyl2 = p;
+          itListCyl2->setState(vpMeSite::M_ESTIMATOR);
         }
 
         ++itListCyl2;
@@ -1922,11 +2042,8 @@ vpMbEdgeTracker::updateMovingEdgeWeights() {
       wmean = 0;
       for(unsigned int i=0 ; i < ci->nbFeature ; i++){
         wmean += m_w[n+i] ;
-        vpMeSite p = *itListCir;
         if (m_w[n+i] < 0.5){
-          p.setState(vpMeSite::M_ESTIMATOR);
-
-          *itListCir = p;
+          itListCir->setState(vpMeSite::M_ESTIMATOR);
         }
 
         ++itListCir;
@@ -2052,10 +2169,104 @@ vpMbEdgeTracker::samePoint(const vpPoint &P1, const vpPoint &P2) const
 }
 
 
+namespace {
+// Side of the cells of the grid in which the extremities of the lines are indexed
+const double lineIndexCell = 1e-6;
+
+// Range of the cells containing the coordinates within epsilon of x, as compared by samePoint()
+void lineIndexRange(const double x, long long &first, long long &last)
+{
+  first = (long long)floor((x - std::numeric_limits<double>::epsilon()) / lineIndexCell);
+  last = (long long)floor((x + std::numeric_limits<double>::epsilon()) / lineIndexCell);
+}
+}
+
+/*!
+  Add a line to the index used to find the duplicated lines of a scale. The
+  line is indexed by the cells of its two extremities.
+
+  \param scale : The scale of the line.
+  \param l : The line to index.
+*/
+void
+vpMbEdgeTracker::indexLine(const unsigned int scale, vpMbtDistanceLine *l)
+{
+  vpMbtLineIndexKey k1, k2;
+  long long last;
+  lineIndexRange(l->p1->get_oX(), k1.first, last);
+  lineIndexRange(l->p1->get_oY(), k1.second.first, last);
+  lineIndexRange(l->p1->get_oZ(), k1.second.second, last);
+  lineIndexRange(l->p2->get_oX(), k2.first, last);
+  lineIndexRange(l->p2->get_oY(), k2.second.first, last);
+  lineIndexRange(l->p2->get_oZ(), k2.second.second, last);
+
+  m_lineIndex[scale].insert(std::make_pair(k1, l));
+  if(k2 != k1)
+    m_lineIndex[scale].insert(std::make_pair(k2, l));
+  m_lineIndexSize[scale]++;
+}
+
+/*!
+  Find the lines of a scale defined by the two given extremities, in any order.
+  The index of the lines is rebuilt first if lines were added or removed
+  without addLine().
+
+  \param scale : The scale of the lines.
+  \param P1 : The first extremity of the line.
+  \param P2 : The second extremity of the line.
+  \param found : The lines with the same extremities, in the order of the list of lines.
+*/
+void
+vpMbEdgeTracker::findLines(const unsigned int scale, const vpPoint &P1, const vpPoint &P2,
+                           std::vector<vpMbtDistanceLine*> &found)
+{
+  found.clear();
+  if(m_lineIndex.size() != lines.size()){
+    m_lineIndex.resize(lines.size());
+    m_lineIndexSize.resize(lines.size(), 0);
+  }
+  if(m_lineIndexSize[scale] != lines[scale].size()){
+    m_lineIndex[scale].clear();
+    m_lineIndexSize[scale] = 0;
+    for(std::list<vpMbtDistanceLine*>::const_iterator it=lines[scale].begin(); it!=lines[scale].end(); ++it)
+      indexLine(scale, *it);
+  }
+
+  // The first extremity of the line is P1 or P2, so P1 is in one of the cells indexing it
+  long long firstX, lastX, firstY, lastY, firstZ, lastZ;
+  lineIndexRange(P1.get_oX(), firstX, lastX);
+  lineIndexRange(P1.get_oY(), firstY, lastY);
+  lineIndexRange(P1.get_oZ(), firstZ, lastZ);
+  std::multimap<vpMbtLineIndexKey, vpMbtDistanceLine*>::const_iterator it, end;
+  for(long long x = firstX; x <= lastX; x++){
+    for(long long y = firstY; y <= lastY; y++){
+      for(long long z = firstZ; z <= lastZ; z++){
+        end = m_lineIndex[scale].upper_bound(std::make_pair(x, std::make_pair(y, z)));
+        for(it = m_lineIndex[scale].lower_bound(std::make_pair(x, std::make_pair(y, z))); it != end; ++it){
+          vpMbtDistanceLine *l = it->second;
+          if(((samePoint(*(l->p1),P1) && samePoint(*(l->p2),P2)) ||
+              (samePoint(*(l->p1),P2) && samePoint(*(l->p2),P1))) &&
+             std::find(found.begin(), found.end(), l) == found.end())
+            found.push_back(l);
+        }
+      }
+    }
+  }
+
+  if(found.size() > 1){
+    std::vector<vpMbtDistanceLine*> sorted;
+    for(std::list<vpMbtDistanceLine*>::const_iterator itl=lines[scale].begin(); itl!=lines[scale].end(); ++itl)
+      if(std::find(found.begin(), found.end(), *itl) != found.end())
+        sorted.push_back(*itl);
+    found.swap(sorted);
+  }
+}
+
 /*!
   Add a line belonging to the \f$ index \f$ the polygon to the list of lines. It is defined by its two extremities.
   
   If the line already exists, the ploygone's index is added to the list of polygon to which it belongs.
+  The existing lines are found with an index on their extremities (see findLines()).
   
   \param P1 : The first extremity of the line.
   \param P2 : The second extremity of the line.
@@ -2068,18 +2279,17 @@ vpMbEdgeTracker::addLine(vpPoint &P1, vpPoint &P2, int polygon, std::string name
   //suppress line already in the model
   bool already_here = false ;
   vpMbtDistanceLine *l ;
+  std::vector<vpMbtDistanceLine*> found;
   
   for (unsigned int i = 0; i < scales.size(); i += 1){
     if(scales[i]){
       downScale(i);
-      for(std::list<vpMbtDistanceLine*>::const_iterator it=lines[i].begin(); it!=lines[i].end(); ++it){
+      findLines(i, P1, P2, found);
+      for(std::vector<vpMbtDistanceLine*>::const_iterator it=found.begin(); it!=found.end(); ++it){
         l = *it;
-        if((samePoint(*(l->p1),P1) && samePoint(*(l->p2),P2)) ||
-           (samePoint(*(l->p1),P2) && samePoint(*(l->p2),P1)) ){
-          already_here = true ;
-          l->addPolygon(polygon);
-          l->hiddenface = &faces ;
-        }
+        already_here = true ;
+        l->addPolygon(polygon);
+        l->hiddenface = &faces ;
       }
 
       if (!already_here){
@@ -2106,6 +2316,7 @@ vpMbEdgeTracker::addLine(vpPoint &P1, vpPoint &P2, int polygon, std::string name
         
         nline +=1 ;
         lines[i].push_back(l);
+        indexLine(i, l);
       }
       upScale(i);
     }
@@ -2518,6 +2729,8 @@ vpMbEdgeTracker::resetTracker()
   clippingFlag = vpPolygon3D::NO_CLIPPING;
 
   m_optimizationMethod = vpMbTracker::GAUSS_NEWTON_OPT;
+  m_posePrediction = vpMbTracker::NO_PREDICTION;
+  resetPosePrediction();
 
   // reinitialization of the scales.
   this->setScales(scales);
@@ -2596,6 +2809,28 @@ vpMbEdgeTracker::reInitModel(const vpImage<unsigned char>& I, const char* cad_na
   initFromPose(I, cMo_);
 }
 
+/*!
+  Get the statistics of the last frame.
+
+  \param nbPrimitives : Number of visible lines, cylinders and circles tracked
+  at the finest scale.
+  \param nbSites : Number of moving edges tracked at the finest scale.
+  \param nbValidSites : Number of these moving edges kept by the robust
+  estimation.
+  \param time : Duration of the last call to track() in ms.
+
+  \sa setFeatureBudget()
+*/
+void
+vpMbEdgeTracker::getFeatureStatistics(unsigned int &nbPrimitives, unsigned int &nbSites, unsigned int &nbValidSites,
+                                      double &time) const
+{
+  nbPrimitives = m_nbTrackedPrimitives;
+  nbSites = m_nbTrackedSites;
+  nbValidSites = m_nbValidSites;
+  time = m_trackingTime;
+}
+
 /*!
   Return the number of good points (vpMeSite) tracked. A good point is a 
   vpMeSite with its flag "state" equal to 0. Only these points are used
@@ -3053,3 +3288,91 @@ vpMbEdgeTracker::setUseEdgeTracking(const std::string &name, const bool &useEdge
     }
   }
 }
+
+//! Section tag of a vpMbEdgeTracker state in a vpBinaryArchive.
+#define VP_ARCHIVE_TAG_MBT_EDGE 0x4554424d // "MBTE"
+
+/*!
+  Save the tracker state in a binary archive. In addition to the state saved by
+  vpMbTracker::saveState(), the moving-edges settings, the scales, the gain, the
+  good moving-edges ratio threshold, the budget of moving edges and the parallel
+  tracking of the primitives are saved.
+
+  \param ar : Archive opened for writing.
+
+  \sa loadState(), vpBinaryArchive
+*/
+void
+vpMbEdgeTracker::saveState(vpBinaryArchive &ar) const
+{
+  vpMbTracker::saveState(ar);
+
+  ar.writeSection(VP_ARCHIVE_TAG_MBT_EDGE, 2);
+  ar << me;
+  ar.writeValue((unsigned int)scales.size());
+  for (unsigned int i = 0; i < scales.size(); i++)
+    ar.writeValue((unsigned char)scales[i]);
+  ar.writeValue(lambda);
+  ar.writeValue(percentageGdPt);
+
+  // Added in version 2
+  ar.writeValue(m_featureBudget);
+  ar.writeValue(m_featureBudgetLatency);
+  ar.writeValue(m_featureBudgetCurrent);
+  ar.writeValue((unsigned char)threadedMovingEdge);
+}
+
+/*!
+  Load a tracker state saved with saveState(). The model has to be loaded before,
+  with the scales of the saved tracker (see setScales()).
+
+  \param ar : Archive opened for reading.
+
+  \exception vpException::badValue : If the model is loaded with other scales.
+
+  \sa saveState(), vpMbTracker::loadState(), vpBinaryArchive
+*/
+void
+vpMbEdgeTracker::loadState(vpBinaryArchive &ar)
+{
+  vpMbTracker::loadState(ar);
+
+  unsigned int version = ar.readSection(VP_ARCHIVE_TAG_MBT_EDGE, 2);
+  vpMe p_me;
+  ar >> p_me;
+  setMovingEdge(p_me);
+
+  unsigned int nbScales;
+  ar.readValue(nbScales);
+  std::vector<bool> scales_(nbScales);
+  for (unsigned int i = 0; i < nbScales; i++) {
+    unsigned char s;
+    ar.readValue(s);
+    scales_[i] = (s != 0);
+  }
+  // Setting the scales removes the primitives of the model
+  if (scales_ != scales) {
+    if (nline != 0 || ncylinder != 0 || ncircle != 0) {
+      throw vpException(vpException::badValue,
+                        "The scales of the saved tracker differ, they have to be set with setScales() before loading the model");
+    }
+    setScales(scales_);
+  }
+  ar.readValue(lambda);
+  ar.readValue(percentageGdPt);
+
+  // Added in version 2, the current budget and parallel tracking are kept with older archives
+  if (version >= 2) {
+    unsigned int budget;
+    double latency, current;
+    unsigned char threaded;
+    ar.readValue(budget);
+    ar.readValue(latency);
+    ar.readValue(current);
+    ar.readValue(threaded);
+    setMovingEdgeThreaded(threaded != 0);
+    setFeatureBudget(budget, latency);
+    // Budget adapted to the targeted duration when saved
+    m_featureBudgetCurrent = current;
+  }
+}
@@ -59,7 +59,7 @@
 */
 vpMbtDistanceCircle::vpMbtDistanceCircle()
   : name(), index(0), cam(), me(NULL), wmean(1),
-    featureEllipse(), isTrackedCircle(true), meEllipse(NULL),
+    featureEllipse(), xSites(), ySites(), isTrackedCircle(true), meEllipse(NULL),
     circle(NULL), radius(0.), p1(NULL), p2(NULL), p3(NULL),
     L(), error(), nbFeature(0), Reinit(false),
     hiddenface(NULL), index_polygon(-1), isvisible(false)
@@ -368,11 +368,31 @@ vpMbtDistanceCircle::initInteractionMatrixError()
     nbFeature = (unsigned int)meEllipse->getMeList().size();
     L.resize(nbFeature, 6);
     error.resize(nbFeature);
+    computeSitesCoordinates();
   }
   else
     nbFeature = 0 ;
 }
 
+/*!
+  Convert the moving edges positions into normalized coordinates, taking the
+  camera distortion into account. The sites do not move during the virtual
+  visual servoing, so this conversion is done once instead of at each
+  iteration of computeInteractionMatrixError().
+*/
+void
+vpMbtDistanceCircle::computeSitesCoordinates()
+{
+  xSites.clear();
+  ySites.clear();
+  double x=0, y=0;
+  for(std::list<vpMeSite>::const_iterator it=meEllipse->getMeList().begin(); it!=meEllipse->getMeList().end(); ++it){
+    vpPixelMeterConversion::convertPoint(cam, it->j, it->i, x, y);
+    xSites.push_back(x);
+    ySites.push_back(y);
+  }
+}
+
 /*!
   Compute the interaction matrix and the error vector corresponding to the point to ellipse algebraic distance.
 */
@@ -402,10 +422,12 @@ vpMbtDistanceCircle::computeInteractionMatrixError(const vpHomogeneousMatrix &cM
     double mu11 = circle->p[3];
     double mu02 = circle->p[4];
 
-    unsigned int j = 0;
+    if (xSites.size() != nbFeature)
+      computeSitesCoordinates();
 
-    for(std::list<vpMeSite>::const_iterator it=meEllipse->getMeList().begin(); it!=meEllipse->getMeList().end(); ++it){
-      vpPixelMeterConversion::convertPoint(cam, it->j, it->i, x, y);
+    for(unsigned int j = 0; j < nbFeature; j++){
+      x = xSites[j];
+      y = ySites[j];
       H[0] = 2*(mu11*(y-yg)+mu02*(xg-x));
       H[1] = 2*(mu20*(yg-y)+mu11*(x-xg));
       H[2] = vpMath::sqr(y-yg)-mu02;
@@ -419,8 +441,6 @@ vpMbtDistanceCircle::computeInteractionMatrixError(const vpHomogeneousMatrix &cM
           + 2*(mu11*yg-mu02*xg)*x + 2*(mu11*xg-mu20*yg)*y
           + mu02*vpMath::sqr(xg) + mu20*vpMath::sqr(yg) - 2*mu11*xg*yg
           + vpMath::sqr(mu11) - mu20*mu02;
-
-      j++;
     }
   }
 }
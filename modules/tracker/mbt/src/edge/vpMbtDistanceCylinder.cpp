@@ -62,7 +62,7 @@
 */
 vpMbtDistanceCylinder::vpMbtDistanceCylinder()
   : name(), index(0), cam(), me(NULL), wmean1(1), wmean2(1),
-    featureline1(), featureline2(), isTrackedCylinder(true), meline1(NULL), meline2(NULL),
+    featureline1(), featureline2(), xSites(), ySites(), isTrackedCylinder(true), sampleStep1(0), sampleStep2(0), meline1(NULL), meline2(NULL),
     cercle1(NULL), cercle2(NULL), radius(0), p1(NULL), p2(NULL), L(),
     error(), nbFeature(0), nbFeaturel1(0), nbFeaturel2(0), Reinit(false),
     c(NULL), hiddenface(NULL), index_polygon(-1), isvisible(false)
@@ -166,6 +166,26 @@ vpMbtDistanceCylinder::setMovingEdge(vpMe *_me)
   }
 }
 
+/*!
+  Set the distance between two consecutive moving edges along the two lines
+  of the cylinder, instead of the sample step of the moving edges parameters.
+  The moving edges are thinned out or resampled at the next update.
+
+  \param step1 : The sample step of the first line in pixels, 0 to use the
+  one of the moving edges parameters.
+  \param step2 : The sample step of the second line.
+*/
+void
+vpMbtDistanceCylinder::setSampleStep(const double step1, const double step2)
+{
+  sampleStep1 = step1;
+  sampleStep2 = step2;
+  if (meline1 != NULL)
+    meline1->setSampleStep(sampleStep1);
+  if (meline2 != NULL)
+    meline2->setSampleStep(sampleStep2);
+}
+
 /*!
   Initialize the moving edge thanks to a given pose of the camera.
   The 3D model is projected into the image to create moving edges along the lines.
@@ -209,8 +229,10 @@ vpMbtDistanceCylinder::initMovingEdge(const vpImage<unsigned char> &I, const vpH
     // Create the moving edges containers
     meline1 = new vpMbtMeLine ;
     meline1->setMe(me) ;
+    meline1->setSampleStep(sampleStep1);
     meline2 = new vpMbtMeLine ;
     meline2->setMe(me) ;
+    meline2->setSampleStep(sampleStep2);
 
     //    meline->setDisplay(vpMeSite::RANGE_RESULT) ;
     meline1->setInitRange(0);
@@ -419,6 +441,42 @@ vpMbtDistanceCylinder::updateMovingEdge(const vpImage<unsigned char> &I, const v
 }
 
 
+/*!
+  Move the moving edges along their normal onto the limbs projected with a
+  predicted pose, so that they are sought around their expected position in
+  the next image.
+
+  \param cMo : Predicted pose of the camera.
+*/
+void
+vpMbtDistanceCylinder::predictMovingEdge(const vpHomogeneousMatrix &cMo)
+{
+  if(isvisible && meline1 != NULL && meline2 != NULL){
+    c->changeFrame(cMo);
+    c->projection();
+
+    double rho1,theta1;
+    double rho2,theta2;
+    vpMeterPixelConversion::convertLine(cam,c->getRho1(),c->getTheta1(),rho1,theta1);
+    vpMeterPixelConversion::convertLine(cam,c->getRho2(),c->getTheta2(),rho2,theta2);
+
+    while (theta1 > M_PI) { theta1 -= M_PI ; }
+    while (theta1 < -M_PI) { theta1 += M_PI ; }
+
+    if (theta1 < -M_PI/2.0) theta1 = -theta1 - 3*M_PI/2.0;
+    else theta1 = M_PI/2.0 - theta1;
+
+    while (theta2 > M_PI) { theta2 -= M_PI ; }
+    while (theta2 < -M_PI) { theta2 += M_PI ; }
+
+    if (theta2 < -M_PI/2.0) theta2 = -theta2 - 3*M_PI/2.0;
+    else theta2 = M_PI/2.0 - theta2;
+
+    meline1->shiftSites(rho1, theta1);
+    meline2->shiftSites(rho2, theta2);
+  }
+}
+
 /*!
   Reinitialize the cylinder if it is required.
   
@@ -609,6 +667,7 @@ vpMbtDistanceCylinder::initInteractionMatrixError()
     nbFeature = nbFeaturel1 + nbFeaturel2;
     L.resize(nbFeature, 6);
     error.resize(nbFeature);
+    computeSitesCoordinates();
   }
   else {
     nbFeature = 0 ;
@@ -617,30 +676,43 @@ vpMbtDistanceCylinder::initInteractionMatrixError()
   }
 }
 
+/*!
+  Convert the moving edges positions of both lines into normalized
+  coordinates. The sites do not move during the virtual visual servoing, so
+  this conversion is done once instead of at each iteration of
+  computeInteractionMatrixError().
+*/
+void
+vpMbtDistanceCylinder::computeSitesCoordinates()
+{
+  double mx = 1.0/cam.get_px() ;
+  double my = 1.0/cam.get_py() ;
+  double xc = cam.get_u0() ;
+  double yc = cam.get_v0() ;
+
+  xSites.clear();
+  ySites.clear();
+  for(std::list<vpMeSite>::const_iterator it=meline1->getMeList().begin(); it!=meline1->getMeList().end(); ++it){
+    xSites.push_back(((double)it->j-xc)*mx);
+    ySites.push_back(((double)it->i-yc)*my);
+  }
+  for(std::list<vpMeSite>::const_iterator it=meline2->getMeList().begin(); it!=meline2->getMeList().end(); ++it){
+    xSites.push_back(((double)it->j-xc)*mx);
+    ySites.push_back(((double)it->i-yc)*my);
+  }
+}
+
 /*!
   Compute the interaction matrix and the error vector corresponding to the cylinder.
 */
 void
-vpMbtDistanceCylinder::computeInteractionMatrixError(const vpHomogeneousMatrix &cMo, const vpImage<unsigned char> &I)
+vpMbtDistanceCylinder::computeInteractionMatrixError(const vpHomogeneousMatrix &cMo, const vpImage<unsigned char> &/*I*/)
 {
   if (isvisible) {
-    // Perspective projection
+    // Perspective projection. Only the limb lines are needed here, the
+    // circles are projected when the moving edges are initialized or updated.
     c->changeFrame(cMo) ;
     c->projection() ;
-    cercle1->changeFrame(cMo) ;
-    cercle1->changeFrame(cMo) ;
-    try{
-      cercle1->projection();
-    }
-    catch(...){std::cout<<"Problem projection circle 1\n";}
-    try{
-      cercle2->projection();
-    }
-    catch(...){std::cout<<"Problem projection circle 2\n";}
-
-    bool disp = false;
-    bool disp2 = false;
-    if (disp || disp2) vpDisplay::flush(I);
 
     // Build the lines
     vpFeatureBuilder::create(featureline2,*c,vpCylinder::line2) ;
@@ -656,60 +728,35 @@ vpMbtDistanceCylinder::computeInteractionMatrixError(const vpHomogeneousMatrix &
     double co2 = cos(theta2);
     double si2 = sin(theta2);
 
-    double mx = 1.0/cam.get_px() ;
-    double my = 1.0/cam.get_py() ;
-    double xc = cam.get_u0() ;
-    double yc = cam.get_v0() ;
-
     vpMatrix H1 ;
     H1 = featureline1.interaction() ;
     vpMatrix H2 ;
     H2 = featureline2.interaction() ;
 
-    vpMeSite p ;
-    unsigned int j =0 ;
-    for(std::list<vpMeSite>::const_iterator it=meline1->getMeList().begin(); it!=meline1->getMeList().end(); ++it){
-      double x = (double)it->j;
-      double y = (double)it->i;
-
-      x = (x-xc)*mx ;
-      y = (y-yc)*my ;
+    if (xSites.size() != nbFeature)
+      computeSitesCoordinates();
 
-      double alpha1 = x*si1 - y*co1;
+    for(unsigned int j = 0 ; j < nbFeature ; j++){
+      double x = xSites[j];
+      double y = ySites[j];
 
-      double *Lrho = H1[0] ;
-      double *Ltheta = H1[1] ;
-      // Calculate interaction matrix for a distance
-      for (unsigned int k=0 ; k < 6 ; k++){
-        L[j][k] = (Lrho[k] + alpha1*Ltheta[k]);
+      // The sites of the first line come first
+      double rho, co, si;
+      double *Lrho, *Ltheta;
+      if (j < nbFeaturel1) {
+        rho = rho1; co = co1; si = si1; Lrho = H1[0]; Ltheta = H1[1];
+      }
+      else {
+        rho = rho2; co = co2; si = si2; Lrho = H2[0]; Ltheta = H2[1];
       }
-      error[j] = rho1 - ( x*co1 + y*si1) ;
-
-      if (disp) vpDisplay::displayCross(I, it->i, it->j, (unsigned int)(error[j]*100), vpColor::orange,1);
-
-      j++;
-    }
-
-    for(std::list<vpMeSite>::const_iterator it=meline2->getMeList().begin(); it!=meline2->getMeList().end(); ++it){
-      double x = (double)it->j;
-      double y = (double)it->i;
-
-      x = (x-xc)*mx ;
-      y = (y-yc)*my ;
 
-      double alpha2 = x*si2 - y*co2;
+      double alpha = x*si - y*co;
 
-      double *Lrho = H2[0] ;
-      double *Ltheta = H2[1] ;
       // Calculate interaction matrix for a distance
       for (unsigned int k=0 ; k < 6 ; k++){
-        L[j][k] = (Lrho[k] + alpha2*Ltheta[k]);
+        L[j][k] = (Lrho[k] + alpha*Ltheta[k]);
       }
-      error[j] = rho2 - ( x*co2 + y*si2) ;
-
-      if (disp) vpDisplay::displayCross(I, it->i, it->j, (unsigned int)(error[j]*100),vpColor::red,1);
-
-      j++;
+      error[j] = rho - ( x*co + y*si) ;
     }
   }
 }
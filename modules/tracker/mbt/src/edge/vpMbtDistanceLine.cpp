@@ -57,7 +57,7 @@ void buildLine(vpPoint &P1, vpPoint &P2, vpPoint &P3, vpPoint &P4, vpLine &L);
 */
 vpMbtDistanceLine::vpMbtDistanceLine()
   : name(), index(0), cam(), me(NULL), isTrackedLine(true), isTrackedLineWithVisibility(true),
-    wmean(1), featureline(), poly(), useScanLine(false), meline(), line(NULL), p1(NULL), p2(NULL), L(),
+    wmean(1), featureline(), poly(), xSites(), ySites(), sampleStep(0), useScanLine(false), meline(), line(NULL), p1(NULL), p2(NULL), L(),
     error(), nbFeature(), nbFeatureTotal(0), Reinit(false), hiddenface(NULL), Lindex_polygon(),
     Lindex_polygon_tracked(), isvisible(false)
 {
@@ -304,6 +304,24 @@ vpMbtDistanceLine::setMovingEdge(vpMe *_me)
 //  nbFeatureTotal = 0;
 }
 
+/*!
+  Set the distance between two consecutive moving edges along the line,
+  instead of the sample step of the moving edges parameters. The moving edges
+  are thinned out or resampled at the next update.
+
+  \param step : The sample step in pixels, 0 to use the one of the moving
+  edges parameters.
+*/
+void
+vpMbtDistanceLine::setSampleStep(const double step)
+{
+  sampleStep = step;
+
+  for(unsigned int i = 0 ; i < meline.size() ; i++)
+    if (meline[i] != NULL)
+      meline[i]->setSampleStep(sampleStep);
+}
+
 
 /*!
   Initialize the moving edge thanks to a given pose of the camera.                          
@@ -383,6 +401,7 @@ vpMbtDistanceLine::initMovingEdge(const vpImage<unsigned char> &I, const vpHomog
 
         vpMbtMeLine *melinePt = new vpMbtMeLine ;
         melinePt->setMe(me) ;
+        melinePt->setSampleStep(sampleStep);
 
         //    meline[i]->setDisplay(vpMeSite::RANGE_RESULT) ;
         melinePt->setInitRange(0);
@@ -585,6 +604,35 @@ vpMbtDistanceLine::updateMovingEdge(const vpImage<unsigned char> &I, const vpHom
 }
 
 
+/*!
+  Move the moving edges along their normal onto the line projected with a
+  predicted pose, so that they are sought around their expected position in
+  the next image.
+
+  \param cMo : Predicted pose of the camera.
+*/
+void
+vpMbtDistanceLine::predictMovingEdge(const vpHomogeneousMatrix &cMo)
+{
+  if(isvisible && ! meline.empty()){
+    line->changeFrame(cMo);
+    line->projection();
+    double rho,theta;
+    vpMeterPixelConversion::convertLine(cam,line->getRho(),line->getTheta(),rho,theta);
+
+    while (theta > M_PI) { theta -= M_PI ; }
+    while (theta < -M_PI) { theta += M_PI ; }
+
+    if (theta < -M_PI/2.0) theta = -theta - 3*M_PI/2.0;
+    else theta = M_PI/2.0 - theta;
+
+    for(unsigned int i = 0 ; i < meline.size() ; i++){
+      if (meline[i] != NULL)
+        meline[i]->shiftSites(rho, theta);
+    }
+  }
+}
+
 /*!
   Reinitialize the line if it is required.
   
@@ -752,6 +800,7 @@ vpMbtDistanceLine::initInteractionMatrixError()
   {
     L.resize(nbFeatureTotal,6) ;
     error.resize(nbFeatureTotal) ;
+    computeSitesCoordinates();
   }
   else{
     for(unsigned int i = 0 ; i < meline.size() ; i++)
@@ -760,6 +809,29 @@ vpMbtDistanceLine::initInteractionMatrixError()
   }
 }
 
+/*!
+  Convert the moving edges positions into normalized coordinates. The sites do
+  not move during the virtual visual servoing, so this conversion is done once
+  instead of at each iteration of computeInteractionMatrixError().
+*/
+void
+vpMbtDistanceLine::computeSitesCoordinates()
+{
+  double mx = 1.0/cam.get_px() ;
+  double my = 1.0/cam.get_py() ;
+  double xc = cam.get_u0() ;
+  double yc = cam.get_v0() ;
+
+  xSites.clear();
+  ySites.clear();
+  for(unsigned int i = 0 ; i < meline.size() ; i++){
+    for(std::list<vpMeSite>::const_iterator it=meline[i]->getMeList().begin(); it!=meline[i]->getMeList().end(); ++it){
+      xSites.push_back(((double)it->j-xc)*mx);
+      ySites.push_back(((double)it->i-yc)*my);
+    }
+  }
+}
+
 /*!
   Compute the interaction matrix and the error vector corresponding to the line.
 */
@@ -780,39 +852,27 @@ vpMbtDistanceLine::computeInteractionMatrixError(const vpHomogeneousMatrix &cMo)
     double co = cos(theta);
     double si = sin(theta);
 
-    double mx = 1.0/cam.get_px() ;
-    double my = 1.0/cam.get_py() ;
-    double xc = cam.get_u0() ;
-    double yc = cam.get_v0() ;
-
     double alpha_ ;
     vpMatrix H ;
     H = featureline.interaction() ;
 
-    double x,y ;
-    vpMeSite p ;
-    unsigned int j =0 ;
+    if (xSites.size() != nbFeatureTotal)
+      computeSitesCoordinates();
 
-    for(unsigned int i = 0 ; i < meline.size() ; i++){
-      for(std::list<vpMeSite>::const_iterator it=meline[i]->getMeList().begin(); it!=meline[i]->getMeList().end(); ++it){
-        x = (double)it->j ;
-        y = (double)it->i ;
-
-        x = (x-xc)*mx ;
-        y = (y-yc)*my ;
+    double *Lrho = H[0] ;
+    double *Ltheta = H[1] ;
+    for(unsigned int j = 0 ; j < nbFeatureTotal ; j++){
+      double x = xSites[j] ;
+      double y = ySites[j] ;
 
-        alpha_ = x*si - y*co;
+      alpha_ = x*si - y*co;
 
-        double *Lrho = H[0] ;
-        double *Ltheta = H[1] ;
-        // Calculate interaction matrix for a distance
-        for (unsigned int k=0 ; k < 6 ; k++)
-        {
-          L[j][k] = (Lrho[k] + alpha_*Ltheta[k]);
-        }
-        error[j] = rho - ( x*co + y*si) ;
-        j++;
+      // Calculate interaction matrix for a distance
+      for (unsigned int k=0 ; k < 6 ; k++)
+      {
+        L[j][k] = (Lrho[k] + alpha_*Ltheta[k]);
       }
+      error[j] = rho - ( x*co + y*si) ;
     }
   }
 }
@@ -45,6 +45,8 @@
 #include <visp3/core/vpDebug.h>
 #include <visp3/core/vpImagePoint.h>
 
+#include "../vpMbtImageGradient_impl.h"
+
 #include <cmath>    // std::fabs
 #include <limits>   // numeric_limits
 #include <algorithm>    // std::min
@@ -104,100 +106,10 @@ vpMbtMeEllipse::computeProjectionError(const vpImage<unsigned char>& _I, double
   _sumErrorRad = 0;
   _nbFeatures = 0;
 
-//  vpMatrix filterX(3,3);
-//  filterX[0][0] = -1;
-//  filterX[1][0] = -2;
-//  filterX[2][0] = -1;
-
-//  filterX[0][1] = 0;
-//  filterX[1][1] = 0;
-//  filterX[2][1] = 0;
-
-//  filterX[0][2] = 1;
-//  filterX[1][2] = 2;
-//  filterX[2][2] = 1;
-
-//  vpMatrix filterY(3,3);
-//  filterY[0][0] = -1;
-//  filterY[0][1] = -2;
-//  filterY[0][2] = -1;
-
-//  filterY[1][0] = 0;
-//  filterY[1][1] = 0;
-//  filterY[1][2] = 0;
-
-//  filterY[2][0] = 1;
-//  filterY[2][1] = 2;
-//  filterY[2][2] = 1;
-
-  vpMatrix filterX(5,5);
-  filterX[0][0] = -1;
-  filterX[1][0] = -4;
-  filterX[2][0] = -6;
-  filterX[3][0] = -4;
-  filterX[4][0] = -1;
-
-  filterX[0][1] = -2;
-  filterX[1][1] = -8;
-  filterX[2][1] = -12;
-  filterX[3][1] = -8;
-  filterX[4][1] = -2;
-
-  filterX[0][2] = 0;
-  filterX[1][2] = 0;
-  filterX[2][2] = 0;
-  filterX[3][2] = 0;
-  filterX[4][2] = 0;
-
-  filterX[0][3] = 2;
-  filterX[1][3] = 8;
-  filterX[2][3] = 12;
-  filterX[3][3] = 8;
-  filterX[4][3] = 2;
-
-  filterX[0][4] = 1;
-  filterX[1][4] = 4;
-  filterX[2][4] = 6;
-  filterX[3][4] = 4;
-  filterX[4][4] = 1;
-
-  vpMatrix filterY(5,5);
-  filterY[0][0] = -1;
-  filterY[0][1] = -4;
-  filterY[0][2] = -6;
-  filterY[0][3] = -4;
-  filterY[0][4] = -1;
-
-  filterY[1][0] = -2;
-  filterY[1][1] = -8;
-  filterY[1][2] = -12;
-  filterY[1][3] = -8;
-  filterY[1][4] = -2;
-
-  filterY[2][0] = 0;
-  filterY[2][1] = 0;
-  filterY[2][2] = 0;
-  filterY[2][3] = 0;
-  filterY[2][4] = 0;
-
-  filterY[3][0] = 2;
-  filterY[3][1] = 8;
-  filterY[3][2] = 12;
-  filterY[3][3] = 8;
-  filterY[3][4] = 2;
-
-  filterY[4][0] = 1;
-  filterY[4][1] = 4;
-  filterY[4][2] = 6;
-  filterY[4][3] = 4;
-  filterY[4][4] = 1;
-
-  double offset = std::floor(filterX.getRows() / 2.0f);
-//  std::cout << "offset=" << offset << std::endl;
   int height = (int) _I.getHeight() ;
   int width = (int) _I.getWidth() ;
 
-  for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
+  for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
     double iSite = it->ifloat;
     double jSite = it->jfloat;
 
@@ -207,72 +119,10 @@ vpMbtMeEllipse::computeProjectionError(const vpImage<unsigned char>& _I, double
                           / (mu20*iSite - mu11*jSite + mu11*iPc.get_j() - mu20*iPc.get_i()))
                             - M_PI/2;
 
-      double deltaNormalized = theta;
-      while (deltaNormalized<0) deltaNormalized += M_PI;
-      while (deltaNormalized>M_PI) deltaNormalized -= M_PI;
-
-      vpColVector vecSite(2);
-      vecSite[0] = cos(deltaNormalized);
-      vecSite[1] = sin(deltaNormalized);
-      vecSite.normalize();
-
-      double gradientX = 0;
-      double gradientY = 0;
-
-      for(unsigned int i = 0; i<filterX.getRows() ; i++){
-		double iImg = iSite + (i - offset);
-		for (unsigned int j = 0; j< filterX.getCols(); j++){
-          double jImg = jSite + (j-offset);
-
-          if(iImg < 0) iImg = 0.0;
-          if(jImg < 0) jImg = 0.0;
-
-          if(iImg > _I.getHeight()-1) iImg = _I.getHeight()-1;
-          if(jImg > _I.getWidth()-1) jImg = _I.getWidth()-1;
-
-		  gradientX += filterX[i][j] * _I((unsigned int)iImg, (unsigned int)jImg);
-        }
-      }
-
-      for(unsigned int i = 0; i<filterY.getRows() ; i++){
-	    double iImg = iSite + (i - offset);
-		for (unsigned int j = 0; j< filterY.getCols(); j++){
-          double jImg = jSite + (j-offset);
-
-          if(iImg < 0) iImg = 0.0;
-          if(jImg < 0) jImg = 0.0;
-
-          if(iImg > _I.getHeight()-1) iImg = _I.getHeight()-1;
-          if(jImg > _I.getWidth()-1) jImg = _I.getWidth()-1;
-
-		  gradientY += filterY[i][j] * _I((unsigned int)iImg, (unsigned int)jImg);
-        }
-      }
-
-      double angle = atan2(gradientY,gradientX);
-      while (angle<0) angle += M_PI;
-      while (angle>M_PI) angle -= M_PI;
-
-//      if(std::fabs(deltaNormalized-angle) > M_PI / 2)
-//      {
-//        sumErrorRad += sqrt(vpMath::sqr(deltaNormalized-angle)) - M_PI / 2;
-//      } else {
-//        sumErrorRad += sqrt(vpMath::sqr(deltaNormalized-angle));
-//      }
-
-//      double angle1 = sqrt(vpMath::sqr(deltaNormalized-angle));
-//      double angle2 = sqrt(vpMath::sqr(deltaNormalized- (angle-M_PI)));
-
-      vpColVector vecGrad(2);
-      vecGrad[0] = cos(angle);
-      vecGrad[1] = sin(angle);
-      vecGrad.normalize();
-
-      double angle1 = acos(vecSite * vecGrad);
-      double angle2 = acos(vecSite * (-vecGrad));
-
-      _sumErrorRad += std::min(angle1,angle2);
+      double gradientI, gradientJ;
+      vpMbtImageGradient(_I, iSite, jSite, gradientI, gradientJ);
 
+      _sumErrorRad += vpMbtGradientAngleError(cos(theta), sin(theta), gradientJ, gradientI);
       _nbFeatures++;
     }
   }
@@ -396,9 +246,8 @@ vpMbtMeEllipse::reSample(const vpImage<unsigned char>  &I)
 void
 vpMbtMeEllipse::updateTheta()
 {
-  vpMeSite p_me;
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-    p_me = *it;
+    vpMeSite &p_me = *it;
     vpImagePoint iP;
     iP.set_i(p_me.ifloat);
     iP.set_j(p_me.jfloat);
@@ -409,7 +258,6 @@ vpMbtMeEllipse::updateTheta()
         - M_PI/2;
 
     p_me.alpha = theta ;
-    *it = p_me;
   }
 }
 
@@ -421,7 +269,7 @@ vpMbtMeEllipse::suppressPoints()
 {
   // Loop through list of sites to track
   for(std::list<vpMeSite>::iterator itList=list.begin(); itList!=list.end();){
-    vpMeSite s = *itList;//current reference pixel
+    const vpMeSite &s = *itList;//current reference pixel
     if (s.getState() != vpMeSite::NO_SUPPRESSION)
       itList = list.erase(itList);
     else
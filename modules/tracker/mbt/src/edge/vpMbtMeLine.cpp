@@ -51,6 +51,16 @@
 #include <visp3/core/vpTrackingException.h>
 #include <visp3/core/vpRobust.h>
 
+#include "../vpMbtImageGradient_impl.h"
+
+//! Order moving edges by their abscissa along the line
+static bool
+vpMbtCompareAbscissa(const std::pair<double, std::list<vpMeSite>::iterator> &s1,
+                     const std::pair<double, std::list<vpMeSite>::iterator> &s2)
+{
+  return s1.first < s2.first;
+}
+
 //! Normalize an angle between -Pi and Pi
 static void
 normalizeAngle(double &delta)
@@ -65,7 +75,7 @@ normalizeAngle(double &delta)
 */
 vpMbtMeLine::vpMbtMeLine()
   : rho(0.), theta(0.), theta_1(M_PI/2), delta(0.), delta_1(0), sign(1),
-    a(0.), b(0.), c(0.), imin(0), imax(0), jmin(0), jmax(0),
+    a(0.), b(0.), c(0.), sampleStep(0.), sampledStep(0.), imin(0), imax(0), jmin(0), jmax(0),
     expecteddensity(0.)
 {
 }
@@ -143,8 +153,10 @@ vpMbtMeLine::sample(const vpImage<unsigned char>& I)
   int cols = (int)I.getWidth() ;
   double n_sample;
 
+  const double sample_step = getSampleStep();
+
   //if (me->getSampleStep==0)
-  if (std::fabs(me->getSampleStep()) <= std::numeric_limits<double>::epsilon())
+  if (std::fabs(sample_step) <= std::numeric_limits<double>::epsilon())
   {
     throw(vpTrackingException(vpTrackingException::fatalError,
                               "Function vpMbtMeLine::sample() called with moving-edges sample step = 0")) ;
@@ -157,7 +169,8 @@ vpMbtMeLine::sample(const vpImage<unsigned char>& I)
   double length_p = sqrt((vpMath::sqr(diffsi)+vpMath::sqr(diffsj)));
 
   // number of samples along line_p
-  n_sample = length_p/(double)me->getSampleStep();
+  n_sample = length_p/sample_step;
+  sampledStep = sample_step;
 
   double stepi = diffsi/(double)n_sample;
   double stepj = diffsj/(double)n_sample;
@@ -169,7 +182,7 @@ vpMbtMeLine::sample(const vpImage<unsigned char>& I)
   // Delete old list
   list.clear();
 
-  // sample positions at i*me->getSampleStep() interval along the
+  // sample positions at i*sample_step interval along the
   // line_p, starting at PSiteExt[0]
 
   vpImagePoint ip;
@@ -213,7 +226,7 @@ void
 vpMbtMeLine::suppressPoints(const vpImage<unsigned char> & I)
 {
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ){
-    vpMeSite s = *it;//current reference pixel
+    vpMeSite &s = *it;//current reference pixel
 
     if (fabs(sin(theta)) > 0.9) // Vertical line management
     {
@@ -267,8 +280,10 @@ vpMbtMeLine::seekExtremities(const vpImage<unsigned char> &I)
   int cols = (int)I.getWidth() ;
   double n_sample;
 
+  double sample_step = getSampleStep();
+
   //if (me->getSampleStep()==0)
-  if (std::fabs(me->getSampleStep()) <= std::numeric_limits<double>::epsilon())
+  if (std::fabs(sample_step) <= std::numeric_limits<double>::epsilon())
   {
     throw(vpTrackingException(vpTrackingException::fatalError,
                               "Function called with sample step = 0")) ;
@@ -286,15 +301,14 @@ vpMbtMeLine::seekExtremities(const vpImage<unsigned char> &I)
   double length_p = sqrt(s); /*(vpMath::sqr(diffsi)+vpMath::sqr(diffsj))*/
 
   // number of samples along line_p
-  n_sample = length_p/(double)me->getSampleStep();
-  double sample_step = (double)me->getSampleStep();
+  n_sample = length_p/sample_step;
 
   vpMeSite P ;
   P.init((int) PExt[0].ifloat, (int)PExt[0].jfloat, delta_1, 0, sign) ;
   P.setDisplay(selectDisplay) ;
 
-  unsigned int  memory_range = me->getRange() ;
-  me->setRange(1);
+  // Search range of the new points
+  const unsigned int range = 1;
 
   for (int i=0 ; i < 3 ; i++)
   {
@@ -306,9 +320,9 @@ vpMbtMeLine::seekExtremities(const vpImage<unsigned char> &I)
       if (vpDEBUG_ENABLE(3)) vpDisplay::displayCross(I,P.i,P.j,5,vpColor::cyan) ;
     }
     else
-    if(!outOfImage(P.i, P.j, (int)(me->getRange()+me->getMaskSize()+1), (int)rows, (int)cols))
+    if(!outOfImage(P.i, P.j, (int)(range+me->getMaskSize()+1), (int)rows, (int)cols))
     {
-      P.track(I,me,false) ;
+      P.track(I,me,false,range) ;
 
       if (P.getState() == vpMeSite::NO_SUPPRESSION)
       {
@@ -333,9 +347,9 @@ vpMbtMeLine::seekExtremities(const vpImage<unsigned char> &I)
     }
 
     else
-    if(!outOfImage(P.i, P.j, (int)(me->getRange()+me->getMaskSize()+1), (int)rows, (int)cols))
+    if(!outOfImage(P.i, P.j, (int)(range+me->getMaskSize()+1), (int)rows, (int)cols))
     {
-      P.track(I,me,false) ;
+      P.track(I,me,false,range) ;
 
       if (P.getState() == vpMeSite::NO_SUPPRESSION)
       {
@@ -347,8 +361,6 @@ vpMbtMeLine::seekExtremities(const vpImage<unsigned char> &I)
     }
   }
 	
-  me->setRange(memory_range);
-	
   vpCDEBUG(1) <<"end vpMeLine::sample() : " ;
   vpCDEBUG(1) << n_sample << " point inserted in the list " << std::endl  ;
 }
@@ -367,172 +379,22 @@ vpMbtMeLine::computeProjectionError(const vpImage<unsigned char>& _I, double &_s
 {
   _sumErrorRad = 0;
   _nbFeatures = 0;
-  double deltaNormalized = theta;
-  unsigned int iter = 0;
-
-  while (deltaNormalized<0) deltaNormalized += M_PI;
-  while (deltaNormalized>M_PI) deltaNormalized -= M_PI;
-
-  vpColVector vecLine(2);
-  vecLine[0] = cos(deltaNormalized);
-  vecLine[1] = sin(deltaNormalized);
-  vecLine.normalize();
-
-//  vpMatrix filterX(3,3);
-//  filterX[0][0] = -1;
-//  filterX[1][0] = -2;
-//  filterX[2][0] = -1;
-
-//  filterX[0][1] = 0;
-//  filterX[1][1] = 0;
-//  filterX[2][1] = 0;
-
-//  filterX[0][2] = 1;
-//  filterX[1][2] = 2;
-//  filterX[2][2] = 1;
-
-//  vpMatrix filterY(3,3);
-//  filterY[0][0] = -1;
-//  filterY[0][1] = -2;
-//  filterY[0][2] = -1;
-
-//  filterY[1][0] = 0;
-//  filterY[1][1] = 0;
-//  filterY[1][2] = 0;
-
-//  filterY[2][0] = 1;
-//  filterY[2][1] = 2;
-//  filterY[2][2] = 1;
-
-  vpMatrix filterX(5,5);
-  filterX[0][0] = -1;
-  filterX[1][0] = -4;
-  filterX[2][0] = -6;
-  filterX[3][0] = -4;
-  filterX[4][0] = -1;
-
-  filterX[0][1] = -2;
-  filterX[1][1] = -8;
-  filterX[2][1] = -12;
-  filterX[3][1] = -8;
-  filterX[4][1] = -2;
-
-  filterX[0][2] = 0;
-  filterX[1][2] = 0;
-  filterX[2][2] = 0;
-  filterX[3][2] = 0;
-  filterX[4][2] = 0;
-
-  filterX[0][3] = 2;
-  filterX[1][3] = 8;
-  filterX[2][3] = 12;
-  filterX[3][3] = 8;
-  filterX[4][3] = 2;
-
-  filterX[0][4] = 1;
-  filterX[1][4] = 4;
-  filterX[2][4] = 6;
-  filterX[3][4] = 4;
-  filterX[4][4] = 1;
-
-  vpMatrix filterY(5,5);
-  filterY[0][0] = -1;
-  filterY[0][1] = -4;
-  filterY[0][2] = -6;
-  filterY[0][3] = -4;
-  filterY[0][4] = -1;
-
-  filterY[1][0] = -2;
-  filterY[1][1] = -8;
-  filterY[1][2] = -12;
-  filterY[1][3] = -8;
-  filterY[1][4] = -2;
-
-  filterY[2][0] = 0;
-  filterY[2][1] = 0;
-  filterY[2][2] = 0;
-  filterY[2][3] = 0;
-  filterY[2][4] = 0;
-
-  filterY[3][0] = 2;
-  filterY[3][1] = 8;
-  filterY[3][2] = 12;
-  filterY[3][3] = 8;
-  filterY[3][4] = 2;
-
-  filterY[4][0] = 1;
-  filterY[4][1] = 4;
-  filterY[4][2] = 6;
-  filterY[4][3] = 4;
-  filterY[4][4] = 1;
-
-  double offset = std::floor(filterX.getRows() / 2.0f);
 
-  for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-    if(iter != 0 && iter+1 != list.size()){
-      double gradientX = 0;
-      double gradientY = 0;
-
-      double iSite = it->ifloat;
-      double jSite = it->jfloat;
-
-      for(unsigned int i = 0; i<filterX.getRows() ; i++){
-		double iImg = iSite + (i - offset);
-		for (unsigned int j = 0; j< filterX.getCols(); j++){
-          double jImg = jSite + (j-offset);
-
-          if(iImg < 0) iImg = 0.0;
-          if(jImg < 0) jImg = 0.0;
-
-          if(iImg > _I.getHeight()-1) iImg = _I.getHeight()-1;
-          if(jImg > _I.getWidth()-1) jImg = _I.getWidth()-1;
-
-		  gradientX += filterX[i][j] * _I((unsigned int)iImg, (unsigned int)jImg);
-        }
-      }
+  // The gradient sign is ignored, so the line direction is only needed modulo M_PI
+  const double cosTheta = cos(theta);
+  const double sinTheta = sin(theta);
 
-      for(unsigned int i = 0; i<filterY.getRows() ; i++){
-		double iImg = iSite + (i - offset);
-		for (unsigned int j = 0; j< filterY.getCols(); j++){
-          double jImg = jSite + (j-offset);
-
-          if(iImg < 0) iImg = 0.0;
-          if(jImg < 0) jImg = 0.0;
-
-          if(iImg > _I.getHeight()-1) iImg = _I.getHeight()-1;
-          if(jImg > _I.getWidth()-1) jImg = _I.getWidth()-1;
-
-		  gradientY += filterY[i][j] * _I((unsigned int)iImg, (unsigned int)jImg);
-        }
-      }
-
-      double angle = atan2(gradientX,gradientY);
-      while (angle<0) angle += M_PI;
-      while (angle>M_PI) angle -= M_PI;
-
-      vpColVector vecGrad(2);
-      vecGrad[0] = cos(angle);
-      vecGrad[1] = sin(angle);
-      vecGrad.normalize();
-
-      double angle1 = acos(vecLine * vecGrad);
-      double angle2 = acos(vecLine * (-vecGrad));
-
-//      double angle1 = sqrt(vpMath::sqr(deltaNormalized-angle));
-//      double angle2 = sqrt(vpMath::sqr(deltaNormalized- (angle-M_PI)));
-
-      _sumErrorRad += std::min(angle1,angle2);
-
-//      if(std::fabs(deltaNormalized-angle) > M_PI / 2)
-//      {
-//        sumErrorRad += sqrt(vpMath::sqr(deltaNormalized-angle)) - M_PI / 2;
-//      } else {
-//        sumErrorRad += sqrt(vpMath::sqr(deltaNormalized-angle));
-//      }
+  // The extremities are not considered
+  const size_t nbSites = list.size();
+  size_t iter = 0;
+  for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it, ++iter){
+    if(iter != 0 && iter+1 != nbSites){
+      double gradientI, gradientJ;
+      vpMbtImageGradient(_I, it->ifloat, it->jfloat, gradientI, gradientJ);
 
+      _sumErrorRad += vpMbtGradientAngleError(cosTheta, sinTheta, gradientI, gradientJ);
       _nbFeatures++;
     }
-    iter++;
   }
 }
 
@@ -550,8 +412,9 @@ void
 vpMbtMeLine::reSample(const vpImage<unsigned char> &I)
 {
   unsigned int n = numberOfSignal() ;
+  const double step = getSampleStep();
 
-  if ((double)n<0.5*expecteddensity && n > 0)
+  if (((double)n<0.5*expecteddensity || 1.5*step < sampledStep) && n > 0)
   {
     double delta_new = delta;
     delta = delta_1;
@@ -563,6 +426,8 @@ vpMbtMeLine::reSample(const vpImage<unsigned char> &I)
       vpMeTracker::initTracking(I) ;
     }
   }
+  else if (step > 1.5*sampledStep)
+    thinOut();
 }
 
 
@@ -582,8 +447,9 @@ void
 vpMbtMeLine::reSample(const vpImage<unsigned char> &I, vpImagePoint ip1, vpImagePoint ip2)
 {
   size_t n = list.size();
+  const double step = getSampleStep();
 
-  if ((double)n<0.5*expecteddensity /*&& n > 0*/) // n is always > 0
+  if ((double)n<0.5*expecteddensity /*&& n > 0*/ || 1.5*step < sampledStep) // n is always > 0
   {
     double delta_new = delta;
     delta = delta_1;
@@ -596,6 +462,37 @@ vpMbtMeLine::reSample(const vpImage<unsigned char> &I, vpImagePoint ip1, vpImage
     delta = delta_new;
     vpMeTracker::track(I) ;
   }
+  else if (step > 1.5*sampledStep)
+    thinOut();
+}
+
+/*!
+  Remove moving edges so that two consecutive ones along the line are at
+  least getSampleStep() apart, when the sample step has been increased with
+  setSampleStep(). The remaining moving edges keep their tracking state, the
+  line does not need to be resampled.
+*/
+void
+vpMbtMeLine::thinOut()
+{
+  const double step = getSampleStep();
+
+  // Abscissa of the moving edges along the line direction
+  std::vector<std::pair<double, std::list<vpMeSite>::iterator> > sites;
+  sites.reserve(list.size());
+  for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it)
+    sites.push_back(std::make_pair(-b*it->ifloat + a*it->jfloat, it));
+  std::sort(sites.begin(), sites.end(), vpMbtCompareAbscissa);
+
+  for(size_t k = 1, last = 0; k < sites.size(); k++){
+    if (sites[k].first - sites[last].first < 0.99*step)
+      list.erase(sites[k].second);
+    else
+      last = k;
+  }
+
+  sampledStep = step;
+  expecteddensity = (double)list.size();
 }
 
 /*!
@@ -604,8 +501,6 @@ vpMbtMeLine::reSample(const vpImage<unsigned char> &I, vpImagePoint ip1, vpImage
 void
 vpMbtMeLine::updateDelta()
 {
-  vpMeSite p_me ;
-
   double diff = 0;
 
   //if(fabs(theta) == M_PI )
@@ -624,14 +519,60 @@ vpMbtMeLine::updateDelta()
   normalizeAngle(delta);
 
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-    p_me = *it;
-    p_me.alpha = delta ;
-    p_me.mask_sign = sign;
-    *it = p_me;
+    it->alpha = delta ;
+    it->mask_sign = sign;
   }
   delta_1 = delta;
 }
 
+/*!
+  Move the sites and the extremities along their normal onto the line
+  \f$ i \; cos(\theta) + j \; sin(\theta) - \rho = 0 \f$, for instance the
+  line projected at a predicted pose, before tracking them. The last
+  displacement of each site, used by the adaptive range, becomes the part of
+  its previous displacement that is not explained by this shift.
+
+  \param rho_ : The \f$\rho\f$ parameter of the line in pixels.
+  \param theta_ : The \f$\theta\f$ parameter of the line.
+*/
+void
+vpMbtMeLine::shiftSites(double rho_, double theta_)
+{
+  this->rho = rho_;
+  this->theta = theta_;
+  a = cos(theta);
+  b = sin(theta);
+  c = -rho;
+
+  for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
+    vpMeSite &s = *it;
+    double d = a*s.ifloat + b*s.jfloat + c;
+    double di = -d*a;
+    double dj = -d*b;
+    s.ifloat += di;
+    s.jfloat += dj;
+    int i_prev = s.i;
+    int j_prev = s.j;
+    s.i = vpMath::round(s.ifloat);
+    s.j = vpMath::round(s.jfloat);
+    // A newly sampled site keeps its null previous position
+    if (s.i_1 != 0 || s.j_1 != 0) {
+      s.i_1 = s.i - vpMath::round(i_prev - s.i_1 - di);
+      s.j_1 = s.j - vpMath::round(j_prev - s.j_1 - dj);
+    }
+  }
+
+  for(unsigned int k = 0; k < 2; k++){
+    double d = a*PExt[k].ifloat + b*PExt[k].jfloat + c;
+    PExt[k].ifloat -= d*a;
+    PExt[k].jfloat -= d*b;
+    PExt[k].i = vpMath::round(PExt[k].ifloat);
+    PExt[k].j = vpMath::round(PExt[k].jfloat);
+  }
+
+  updateDelta();
+}
+
 /*!
  Track the line in the image I.
  
@@ -730,7 +671,7 @@ vpMbtMeLine::setExtremities()
 
   // Loop through list of sites to track
   for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
-    vpMeSite s = *it;//current reference pixel
+    const vpMeSite &s = *it;//current reference pixel
     if (s.ifloat < i_min)
     {
       i_min = s.ifloat ;
@@ -755,7 +696,7 @@ vpMbtMeLine::setExtremities()
   if (fabs(i_min-i_max) < 25)
   {
     for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
-      vpMeSite s = *it;//current reference pixel
+      const vpMeSite &s = *it;//current reference pixel
       if (s.jfloat < j_min)
       {
         i_min = s.ifloat ;
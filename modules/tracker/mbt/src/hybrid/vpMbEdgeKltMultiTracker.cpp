@@ -44,12 +44,15 @@
 
 #include <visp3/core/vpConfig.h>
 
-#if (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
+#include <visp3/core/vpTime.h>
 #include <visp3/core/vpTrackingException.h>
 #include <visp3/core/vpVelocityTwistMatrix.h>
 #include <visp3/mbt/vpMbEdgeKltMultiTracker.h>
 
+#include "../vpMbtParallelError_impl.h"
+
 
 /*!
   Basic constructor
@@ -171,20 +174,44 @@ void vpMbEdgeKltMultiTracker::computeVVS(std::map<std::string, const vpImage<uns
 
   vpHomogeneousMatrix cMoPrev;
   vpHomogeneousMatrix ctTc0_Prev;
-  //Error vector for MBT + KLT for the previous iteration
-  vpColVector m_error_prev(2*nbInfos + nbrow);
-  //Weighting vector for MBT + KLT for the previous iteration
-  vpColVector m_w_prev(2*nbInfos + nbrow);
-  double mu = 0.01;
-
-  //Create the map of VelocityTwistMatrices
-  std::map<std::string, vpVelocityTwistMatrix> mapOfVelocityTwist;
-  for(std::map<std::string, vpHomogeneousMatrix>::const_iterator it = m_mapOfCameraTransformationMatrix.begin();
-      it != m_mapOfCameraTransformationMatrix.end(); ++it) {
+
+  //Each camera fills its own slice of the stacked MBT and KLT systems, the
+  //offsets have an extra element with the total size
+  std::vector<vpMbEdgeTracker *> edgeTrackers;
+  std::vector<vpMbKltTracker *> kltTrackers;
+  std::vector<const vpImage<unsigned char> *> images;
+  std::vector<vpHomogeneousMatrix> cameraTransformations;
+  std::vector<vpVelocityTwistMatrix> velocityTwists;
+  std::vector<unsigned int> rowOffsets, lineOffsets, cylinderOffsets, circleOffsets, kltOffsets;
+  unsigned int nbMbtRows = 0, nbLines = 0, nbCylinders = 0, nbCircles = 0, nbKltRows = 0;
+  for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
+      it != m_mapOfEdgeTrackers.end(); ++it) {
+    edgeTrackers.push_back(it->second);
+    kltTrackers.push_back(m_mapOfKltTrackers[it->first]);
+    images.push_back(mapOfImages[it->first]);
+    cameraTransformations.push_back(m_mapOfCameraTransformationMatrix[it->first]);
     vpVelocityTwistMatrix cVo;
-    cVo.buildFrom(it->second);
-    mapOfVelocityTwist[it->first] = cVo;
+    cVo.buildFrom(cameraTransformations.back());
+    velocityTwists.push_back(cVo);
+
+    rowOffsets.push_back(nbMbtRows);
+    lineOffsets.push_back(nbLines);
+    cylinderOffsets.push_back(nbCylinders);
+    circleOffsets.push_back(nbCircles);
+    kltOffsets.push_back(nbKltRows);
+    nbMbtRows += mapOfNumberOfRows[it->first];
+    nbLines += mapOfNumberOfLines[it->first];
+    nbCylinders += mapOfNumberOfCylinders[it->first];
+    nbCircles += mapOfNumberOfCircles[it->first];
+    nbKltRows += 2*mapOfNbInfos[it->first];
   }
+  rowOffsets.push_back(nbMbtRows);
+  lineOffsets.push_back(nbLines);
+  cylinderOffsets.push_back(nbCylinders);
+  circleOffsets.push_back(nbCircles);
+  kltOffsets.push_back(nbKltRows);
+  int nbCameras = (int) edgeTrackers.size();
+  bool camerasThreaded = vpMbEdgeMultiTracker::m_camerasThreaded;
 
   //Map of robust for edge trackers
   //Individual weights for each primitives and for each camera
@@ -227,130 +254,153 @@ void vpMbEdgeKltMultiTracker::computeVVS(std::map<std::string, const vpImage<uns
   std::map<std::string, vpColVector> mapOfWeightCircles;
 
   //Variables used in the minimization process
-  double residu = 0;
-  double residu_1 = -1;
-  unsigned int iter = 0;
-
-  vpMatrix *L;
-  vpColVector *R;
+  //Stacked system, MBT first and then KLT
+  vpMatrix L(nbrow + 2*nbInfos, 6);
+  vpColVector R(nbrow + 2*nbInfos);
   vpMatrix L_true;
-  vpMatrix LVJ_true;
-  vpColVector w_true;
 
-  vpColVector v;
-  vpHomography H;
+  vpMbtVVSSolver solver(m_optimizationMethod, lambda, maxIter);
+  solver.setStopCriteria(m_stopCriteriaResidual, m_stopCriteriaIncrement);
 
-  vpMatrix LTL;
-  vpColVector LTR;
+  while(! solver.hasConverged()){
+    const unsigned int iter = solver.getIteration();
 
-  while( ((int)((residu - residu_1)*1e8) !=0 )  && (iter<maxIter) ){
-    L = new vpMatrix();
-    R = new vpColVector();
+    std::map<std::string, vpColVector> mapOfErrorLines;
+    std::map<std::string, vpColVector> mapOfErrorCylinders;
+    std::map<std::string, vpColVector> mapOfErrorCircles;
+
+    std::vector<vpColVector> errorLines((size_t) nbCameras);
+    std::vector<vpColVector> errorCylinders((size_t) nbCameras);
+    std::vector<vpColVector> errorCircles((size_t) nbCameras);
 
     //MBT
     error_lines.resize(0);
     error_cylinders.resize(0);
     error_circles.resize(0);
 
-    std::map<std::string, vpColVector> mapOfErrorLines;
-    std::map<std::string, vpColVector> mapOfErrorCylinders;
-    std::map<std::string, vpColVector> mapOfErrorCircles;
-
     vpColVector R_mbt;
     vpMatrix L_mbt;
     if(nbrow >= 4) {
-      for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
-          it != m_mapOfEdgeTrackers.end(); ++it) {
-        vpMatrix L_tmp(mapOfNumberOfRows[it->first], 6);
-        vpColVector error_lines_tmp(mapOfNumberOfLines[it->first]);
-        vpColVector error_cylinders_tmp(mapOfNumberOfCylinders[it->first]);
-        vpColVector error_circles_tmp(mapOfNumberOfCircles[it->first]);
-
-        //Set the corresponding cMo for the current camera
-        it->second->cMo = m_mapOfCameraTransformationMatrix[it->first]*cMo;
-
-        vpColVector R_tmp;
-        R_tmp.resize(mapOfNumberOfRows[it->first]);
-        it->second->computeVVSSecondPhase(*mapOfImages[it->first], L_tmp, error_lines_tmp,
-            error_cylinders_tmp, error_circles_tmp, R_tmp, 0);
-        //Set the computed weight
-        it->second->m_w = R_tmp;
-        L_tmp = L_tmp*mapOfVelocityTwist[it->first];
-
-        //Stack interaction matrix for MBT
-        L_mbt.stack(L_tmp);
-        //Stack residual for MBT
-        R_mbt.stack(R_tmp);
-
-        error_lines.stack(error_lines_tmp);
-        error_cylinders.stack(error_cylinders_tmp);
-        error_circles.stack(error_circles_tmp);
-
-        mapOfErrorLines[it->first] = error_lines_tmp;
-        mapOfErrorCylinders[it->first] = error_cylinders_tmp;
-        mapOfErrorCircles[it->first] = error_circles_tmp;
-      }
+      L_mbt.resize(nbMbtRows, 6, false);
+      R_mbt.resize(nbMbtRows, false);
+      error_lines.resize(nbLines, false);
+      error_cylinders.resize(nbCylinders, false);
+      error_circles.resize(nbCircles, false);
     }
 
     //KLT
-    vpColVector R_klt;
-    vpMatrix L_klt;
-    for(std::map<std::string, vpMbKltTracker*>::const_iterator it1 = m_mapOfKltTrackers.begin();
-        it1 != m_mapOfKltTrackers.end(); ++it1) {
-      if(mapOfNbInfos[it1->first] > 0) {
-        unsigned int shift = 0;
-        vpColVector R_current;  // residu for the current camera for KLT
-        vpMatrix L_current;     // interaction matrix for the current camera for KLT
-        vpHomography H_current;
-
-        R_current.resize(2 * mapOfNbInfos[it1->first]);
-        L_current.resize(2 * mapOfNbInfos[it1->first], 6, 0);
-
-        //Use the ctTc0 variable instead of the formula in the monocular case
-        //to ensure that we have the same result than vpMbKltTracker
-        //as some slight differences can occur due to numerical imprecision
-        if(m_mapOfKltTrackers.size() == 1) {
-          computeVVSInteractionMatrixAndResidu(shift, R_current, L_current, H_current,
-              it1->second->kltPolygons, it1->second->kltCylinders, ctTc0);
-        } else {
-          vpHomogeneousMatrix c_curr_tTc_curr0 = m_mapOfCameraTransformationMatrix[it1->first] *
-              cMo * it1->second->c0Mo.inverse();
-          computeVVSInteractionMatrixAndResidu(shift, R_current, L_current, H_current,
-              it1->second->kltPolygons, it1->second->kltCylinders, c_curr_tTc_curr0);
+    vpColVector R_klt(nbKltRows);
+    vpMatrix L_klt(nbKltRows, 6);
+
+    vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+    #pragma omp parallel for if(camerasThreaded)
+#endif
+    for(int k = 0; k < nbCameras; k++) {
+      if(! camerasThreaded && error.raised())
+        continue;
+      try {
+        if(nbrow >= 4) {
+          vpMbEdgeTracker *tracker = edgeTrackers[(size_t) k];
+          unsigned int offset = rowOffsets[(size_t) k];
+          vpMatrix L_tmp(rowOffsets[(size_t) k+1] - offset, 6);
+          vpColVector &error_lines_tmp = errorLines[(size_t) k];
+          vpColVector &error_cylinders_tmp = errorCylinders[(size_t) k];
+          vpColVector &error_circles_tmp = errorCircles[(size_t) k];
+          error_lines_tmp.resize(lineOffsets[(size_t) k+1] - lineOffsets[(size_t) k]);
+          error_cylinders_tmp.resize(cylinderOffsets[(size_t) k+1] - cylinderOffsets[(size_t) k]);
+          error_circles_tmp.resize(circleOffsets[(size_t) k+1] - circleOffsets[(size_t) k]);
+
+          //Set the corresponding cMo for the current camera
+          tracker->cMo = cameraTransformations[(size_t) k]*cMo;
+
+          vpColVector R_tmp;
+          R_tmp.resize(L_tmp.getRows());
+          tracker->computeVVSSecondPhase(*images[(size_t) k], L_tmp, error_lines_tmp,
+              error_cylinders_tmp, error_circles_tmp, R_tmp, 0);
+          //Set the computed weight
+          tracker->m_w = R_tmp;
+
+          //Insert interaction matrix and residual for MBT in the slice of the camera
+          L_mbt.insert(L_tmp*velocityTwists[(size_t) k], offset, 0);
+          R_mbt.insert(offset, R_tmp);
+
+          error_lines.insert(lineOffsets[(size_t) k], error_lines_tmp);
+          error_cylinders.insert(cylinderOffsets[(size_t) k], error_cylinders_tmp);
+          error_circles.insert(circleOffsets[(size_t) k], error_circles_tmp);
         }
 
-        //Transform the current interaction matrix with VelocityTwistMatrix
-        L_current = L_current*mapOfVelocityTwist[it1->first];
+        unsigned int kltOffset = kltOffsets[(size_t) k];
+        if(kltOffsets[(size_t) k+1] > kltOffset) {
+          vpMbKltTracker *tracker = kltTrackers[(size_t) k];
+          unsigned int shift = 0;
+          vpColVector R_current;  // residu for the current camera for KLT
+          vpMatrix L_current;     // interaction matrix for the current camera for KLT
+          vpHomography H_current;
+
+          R_current.resize(kltOffsets[(size_t) k+1] - kltOffset);
+          L_current.resize(kltOffsets[(size_t) k+1] - kltOffset, 6, 0);
+
+          //Use the ctTc0 variable instead of the formula in the monocular case
+          //to ensure that we have the same result than vpMbKltTracker
+          //as some slight differences can occur due to numerical imprecision
+          if(m_mapOfKltTrackers.size() == 1) {
+            computeVVSInteractionMatrixAndResidu(shift, R_current, L_current, H_current,
+                tracker->kltPolygons, tracker->kltCylinders, ctTc0);
+          } else {
+            vpHomogeneousMatrix c_curr_tTc_curr0 = cameraTransformations[(size_t) k] *
+                cMo * tracker->c0Mo.inverse();
+            computeVVSInteractionMatrixAndResidu(shift, R_current, L_current, H_current,
+                tracker->kltPolygons, tracker->kltCylinders, c_curr_tTc_curr0);
+          }
 
-        //Stack residual and interaction matrix
-        R_klt.stack(R_current);
-        L_klt.stack(L_current);
+          //Transform the current interaction matrix with VelocityTwistMatrix
+          //and insert it with the residual in the slice of the camera
+          R_klt.insert(kltOffset, R_current);
+          L_klt.insert(L_current*velocityTwists[(size_t) k], kltOffset, 0);
+        }
+      }
+      catch(vpException &e) {
+        error.set(k, e);
       }
     }
+    error.rethrow();
 
+    if(nbrow >= 4) {
+      int k = 0;
+      for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
+          it != m_mapOfEdgeTrackers.end(); ++it, k++) {
+        mapOfErrorLines[it->first] = errorLines[(size_t) k];
+        mapOfErrorCylinders[it->first] = errorCylinders[(size_t) k];
+        mapOfErrorCircles[it->first] = errorCircles[(size_t) k];
+      }
+    }
 
-    bool reStartFromLastIncrement = false;
-    if(iter != 0 && m_optimizationMethod == vpMbTracker::LEVENBERG_MARQUARDT_OPT) {
-      if( m_error.sumSquare()/(double)(2*nbInfos + nbrow) > m_error_prev.sumSquare()/(double)(2*nbInfos + nbrow) ) {
-        mu *= 10.0;
+    if(nbrow > 3) {
+      //Insert interaction matrix and residual from MBT
+      L.insert(L_mbt, 0, 0);
+      R.insert(0, R_mbt);
+    }
 
-        if(mu > 1.0) {
-          throw vpTrackingException(vpTrackingException::fatalError, "Optimization diverged");
-        }
+    if(nbInfos > 3) {
+      //Insert interaction matrix and residual from KLT
+      L.insert(L_klt, nbrow, 0);
+      R.insert(nbrow, R_klt);
+    }
 
-        cMo = cMoPrev;
-        m_error = m_error_prev;
-        m_w = m_w_prev;
-        ctTc0 = ctTc0_Prev;
-        reStartFromLastIncrement = true;
-      }
+    m_error = R;
+
+    bool reStartFromLastIncrement = solver.rejectIncrement(m_error, m_w);
+    if(reStartFromLastIncrement) {
+      cMo = cMoPrev;
+      ctTc0 = ctTc0_Prev;
     }
 
     if(iter == 0) {
       m_w.resize(nbrow + 2*nbInfos);
       m_w = 1;
 
-      w_true.resize(nbrow + 2*nbInfos);
+      w_mbt.resize(nbrow);
     }
 
     if(!reStartFromLastIncrement) {
@@ -360,7 +410,7 @@ void vpMbEdgeKltMultiTracker::computeVVS(std::map<std::string, const vpImage<uns
       w_circles.resize(0);
 
       //Compute the weights for MBT
-      computeVVSSecondPhaseWeights(iter, nbrow, w_mbt, w_lines, w_cylinders, w_circles, mapOfNumberOfLines,
+      computeVVSSecondPhaseWeights(iter, w_lines, w_cylinders, w_circles, mapOfNumberOfLines,
           mapOfNumberOfCylinders, mapOfNumberOfCircles, mapOfWeightLines, mapOfWeightCylinders, mapOfWeightCircles,
           mapOfErrorLines, mapOfErrorCylinders, mapOfErrorCircles, mapOfEdgeRobustLines, mapOfEdgeRobustCylinders,
           mapOfEdgeRobustCircles, thresholdMBT);
@@ -389,24 +439,8 @@ void vpMbEdgeKltMultiTracker::computeVVS(std::map<std::string, const vpImage<uns
       }
 
       //KLT
-      vpColVector w_true_klt; //not used
       //Compute the weights for KLT
-      computeVVSWeights(iter, nbInfos, mapOfNbInfos, R_klt, w_true_klt, w_klt, mapOfKltRobusts, thresholdKLT);
-
-
-      //Stack MBT first and then KLT
-      /* robust */
-      if(nbrow > 3) {
-        //Stack interaction matrix and residual from MBT
-        L->stack(L_mbt);
-        R->stack(R_mbt);
-      }
-
-      if(nbInfos > 3) {
-        //Stack interaction matrix and residual from KLT
-        L->stack(L_klt);
-        R->stack(R_klt);
-      }
+      computeVVSWeights(iter, nbInfos, mapOfNbInfos, R_klt, w_klt, mapOfKltRobusts, thresholdKLT);
 
       //Set weight for m_w with the good weighting between MBT and KLT
       unsigned int cpt = 0;
@@ -420,95 +454,14 @@ void vpMbEdgeKltMultiTracker::computeVVS(std::map<std::string, const vpImage<uns
         cpt++;
       }
 
-      m_error = (*R);
       if(computeCovariance) {
-        L_true = (*L);
-        if(!isoJoIdentity) {
-           vpVelocityTwistMatrix cVo;
-           cVo.buildFrom(cMo);
-           LVJ_true = ( (*L)*cVo*oJo );
-        }
+        L_true = L;
       }
 
-      residu_1 = residu;
-      residu = 0;
-      double num = 0;
-      double den = 0;
-      for (unsigned int i = 0; i < R->getRows(); i++) {
-        num += m_w[i]*vpMath::sqr((*R)[i]);
-        den += m_w[i];
-
-        w_true[i] = m_w[i];
-        (*R)[i] *= m_w[i];
-        if(compute_interaction) {
-          for (unsigned int j = 0; j < 6; j++) {
-            (*L)[i][j] *= m_w[i];
-          }
-        }
-      }
-
-      residu = sqrt(num/den);
-
-      if(isoJoIdentity) {
-        LTL = L->AtA();
-        computeJTR(*L, *R, LTR);
-
-        switch(m_optimizationMethod) {
-        case vpMbTracker::LEVENBERG_MARQUARDT_OPT:
-        {
-          vpMatrix LMA(LTL.getRows(), LTL.getCols());
-          LMA.eye();
-          vpMatrix LTLmuI = LTL + (LMA*mu);
-          v = -lambda*LTLmuI.pseudoInverse(LTLmuI.getRows()*std::numeric_limits<double>::epsilon())*LTR;
-
-          if(iter != 0) {
-            mu /= 10.0;
-          }
-
-          m_error_prev = m_error;
-          m_w_prev = m_w;
-          break;
-        }
-        case vpMbTracker::GAUSS_NEWTON_OPT:
-        default:
-          v = -lambda * LTL.pseudoInverse(LTL.getRows()*std::numeric_limits<double>::epsilon()) * LTR;
-          break;
-        }
-      }
-      else {
-        vpVelocityTwistMatrix cVo;
-        cVo.buildFrom(cMo);
-        vpMatrix LVJ = ((*L)*cVo*oJo);
-        vpMatrix LVJTLVJ = (LVJ).AtA();
-        vpColVector LVJTR;
-        computeJTR(LVJ, *R, LVJTR);
-
-        switch(m_optimizationMethod) {
-        case vpMbTracker::LEVENBERG_MARQUARDT_OPT:
-        {
-          vpMatrix LMA(LVJTLVJ.getRows(), LVJTLVJ.getCols());
-          LMA.eye();
-          vpMatrix LTLmuI = LVJTLVJ + (LMA*mu);
-          v = -lambda*LTLmuI.pseudoInverse(LTLmuI.getRows()*std::numeric_limits<double>::epsilon())*LVJTR;
-          v = cVo * v;
-
-          if(iter != 0) {
-            mu /= 10.0;
-          }
+      solver.computeIncrement(L, m_error, m_w, NULL, compute_interaction);
 
-          m_error_prev = m_error;
-          m_w_prev = m_w;
-          break;
-        }
-        case vpMbTracker::GAUSS_NEWTON_OPT:
-        default:
-        {
-          v = -lambda*LVJTLVJ.pseudoInverse(LVJTLVJ.getRows()*std::numeric_limits<double>::epsilon())*LVJTR;
-          v = cVo * v;
-          break;
-        }
-        }
-      }
+      vpColVector v;
+      solver.getIncrement(cMo, isoJoIdentity, oJo, v);
 
       cMoPrev = cMo;
       ctTc0_Prev = ctTc0;
@@ -516,23 +469,11 @@ void vpMbEdgeKltMultiTracker::computeVVS(std::map<std::string, const vpImage<uns
       cMo = ctTc0 * c0Mo;
     }
 
-    iter++;
-
-    delete L;
-    delete R;
+    solver.nextIteration();
   }
 
   if(computeCovariance) {
-    vpMatrix D;
-    D.diag(w_true);
-
-    // Note that here the covariance is computed on cMoPrev for time computation efficiency
-    if(isoJoIdentity) {
-        covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,L_true,D);
-    }
-    else {
-        covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,LVJ_true,D);
-    }
+    vpMbKltTracker::computeVVSCovariance(solver.getWeights(), cMoPrev, L_true);
   }
 }
 
@@ -1478,42 +1419,75 @@ void vpMbEdgeKltMultiTracker::postTracking(std::map<std::string, const vpImage<u
   //KLT
   vpMbKltMultiTracker::postTracking(mapOfImages, mapOfNbInfos, w_klt);
 
-  // Looking for new visible face
-  bool newvisibleface = false;
+  std::vector<vpMbEdgeTracker *> trackers;
+  std::vector<const vpImage<unsigned char> *> images;
   for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
       it != m_mapOfEdgeTrackers.end(); ++it) {
-    it->second->visibleFace(*mapOfImages[it->first], it->second->cMo, newvisibleface);
+    trackers.push_back(it->second);
+    images.push_back(mapOfImages[it->first]);
   }
+  int nbCameras = (int) trackers.size();
+  bool camerasThreaded = vpMbEdgeMultiTracker::m_camerasThreaded;
 
-  if(useScanLine) {
-    for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-                it != m_mapOfEdgeTrackers.end(); ++it) {
-      it->second->faces.computeClippedPolygons(it->second->cMo, it->second->cam);
-      it->second->faces.computeScanLineRender(it->second->cam, mapOfImages[it->first]->getWidth(),
-          mapOfImages[it->first]->getHeight());
+  // Looking for new visible face. The Ogre rendering is not thread safe.
+  vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(camerasThreaded && ! useOgre)
+#endif
+  for(int k = 0; k < nbCameras; k++) {
+    if((! camerasThreaded || useOgre) && error.raised())
+      continue;
+    vpMbEdgeTracker *tracker = trackers[(size_t) k];
+    try {
+      bool newvisibleface = false;
+      tracker->visibleFace(*images[(size_t) k], tracker->cMo, newvisibleface);
+
+      if(useScanLine) {
+        tracker->faces.computeClippedPolygons(tracker->cMo, tracker->cam);
+        tracker->faces.computeScanLineRender(tracker->cam, images[(size_t) k]->getWidth(),
+            images[(size_t) k]->getHeight());
+      }
+    } catch(vpException &e) {
+      error.set(k, e);
     }
   }
+  error.rethrow();
 
-  try {
-    for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-                it != m_mapOfEdgeTrackers.end(); ++it) {
-      it->second->updateMovingEdge(*mapOfImages[it->first]);
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(camerasThreaded)
+#endif
+  for(int k = 0; k < nbCameras; k++) {
+    if(! camerasThreaded && error.raised())
+      continue;
+    try {
+      trackers[(size_t) k]->updateMovingEdge(*images[(size_t) k]);
+    } catch(vpException &e) {
+      error.set(k, e);
     }
-  } catch(vpException &e) {
-    throw e;
   }
+  error.rethrow();
 
-  for(std::map<std::string, vpMbEdgeTracker*>::const_iterator it = m_mapOfEdgeTrackers.begin();
-      it != m_mapOfEdgeTrackers.end(); ++it) {
-    it->second->initMovingEdge(*mapOfImages[it->first], it->second->cMo);
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(camerasThreaded)
+#endif
+  for(int k = 0; k < nbCameras; k++) {
+    if(! camerasThreaded && error.raised())
+      continue;
+    vpMbEdgeTracker *tracker = trackers[(size_t) k];
+    try {
+      tracker->initMovingEdge(*images[(size_t) k], tracker->cMo);
 
-    // Reinit the moving edge for the lines which need it.
-    it->second->reinitMovingEdge(*mapOfImages[it->first], it->second->cMo);
+      // Reinit the moving edge for the lines which need it.
+      tracker->reinitMovingEdge(*images[(size_t) k], tracker->cMo);
 
-    if(computeProjError) {
-      it->second->computeProjectionError(*mapOfImages[it->first]);
+      if(computeProjError) {
+        tracker->computeProjectionError(*images[(size_t) k]);
+      }
+    } catch(vpException &e) {
+      error.set(k, e);
     }
   }
+  error.rethrow();
 }
 
 void vpMbEdgeKltMultiTracker::reinit(/*const vpImage<unsigned char>& I */) {
@@ -1671,6 +1645,20 @@ void vpMbEdgeKltMultiTracker::setCameraParameters(const std::map<std::string, vp
   }
 }
 
+/*!
+  Enable or disable the processing of the cameras in parallel, for the edge
+  and the KLT trackers.
+
+  \param threaded : true to process the cameras in parallel. Default is
+  false.
+
+  \sa vpMbEdgeMultiTracker::setCamerasThreaded(), vpMbKltMultiTracker::setCamerasThreaded()
+*/
+void vpMbEdgeKltMultiTracker::setCamerasThreaded(const bool threaded) {
+  vpMbEdgeMultiTracker::setCamerasThreaded(threaded);
+  vpMbKltMultiTracker::setCamerasThreaded(threaded);
+}
+
 /*!
   Set the camera transformation matrix for the specified camera (\f$ _{}^{c_{current}}\textrm{M}_{c_{reference}} \f$).
 
@@ -1887,6 +1875,18 @@ void vpMbEdgeKltMultiTracker::setMinPolygonAreaThresh(const double minPolygonAre
   vpMbKltMultiTracker::setMinPolygonAreaThresh(minPolygonAreaThresh, cameraName, name);
 }
 
+/*!
+  Set the directory of the binary model cache for all the cameras.
+
+  \param directory : Directory of the cache. If empty, the cache is not used.
+
+  \sa vpMbTracker::setModelCacheDirectory()
+*/
+void vpMbEdgeKltMultiTracker::setModelCacheDirectory(const std::string &directory) {
+  vpMbEdgeMultiTracker::setModelCacheDirectory(directory);
+  vpMbKltMultiTracker::setModelCacheDirectory(directory);
+}
+
 /*!
   Set the near distance for clipping.
 
@@ -1971,6 +1971,33 @@ void vpMbEdgeKltMultiTracker::setOptimizationMethod(const vpMbtOptimizationMetho
   vpMbKltMultiTracker::setOptimizationMethod(opt);
 }
 
+/*!
+  Set the motion model used to predict the pose before the tracking of new
+  images, for all the cameras (see vpMbTracker::setPosePrediction()).
+
+  \param method : Motion model.
+*/
+void vpMbEdgeKltMultiTracker::setPosePrediction(const vpMbtPosePredictionMethod &method) {
+  vpMbEdgeMultiTracker::setPosePrediction(method);
+  vpMbKltMultiTracker::setPosePrediction(method);
+}
+
+/*!
+  Set the parameters of the Kalman filter used by the KALMAN_PREDICTION
+  motion model, for all the cameras (see
+  vpMbTracker::setPosePredictionKalmanParameters()).
+
+  \param stateVariance : Variance of the acceleration of the camera.
+  \param measureVariance : Variance of the velocity measured by the tracking.
+  \param rho : Degree of correlation between successive accelerations, in
+  [0, 1[.
+*/
+void vpMbEdgeKltMultiTracker::setPosePredictionKalmanParameters(const double stateVariance,
+                                                                const double measureVariance, const double rho) {
+  vpMbEdgeMultiTracker::setPosePredictionKalmanParameters(stateVariance, measureVariance, rho);
+  vpMbKltMultiTracker::setPosePredictionKalmanParameters(stateVariance, measureVariance, rho);
+}
+
 /*!
   Set the pose to be used in entry of the next call to the track() function.
   This pose will be just used once.
@@ -2069,6 +2096,19 @@ void vpMbEdgeKltMultiTracker::setReferenceCameraName(const std::string &referenc
   m_referenceCameraName = referenceCameraName;
 }
 
+/*!
+  Enable or disable the parallel rendering of the scanline visibility test of
+  all the cameras.
+
+  \param threaded : true to render both image axes in parallel.
+
+  \sa vpMbTracker::setScanLineThreaded()
+*/
+void vpMbEdgeKltMultiTracker::setScanLineThreaded(const bool threaded) {
+  vpMbEdgeMultiTracker::setScanLineThreaded(threaded);
+  vpMbKltMultiTracker::setScanLineThreaded(threaded);
+}
+
 /*!
   Use Scanline algorithm for visibility tests
 
@@ -2178,9 +2218,15 @@ void vpMbEdgeKltMultiTracker::track(std::map<std::string, const vpImage<unsigned
     }
   }
 
+  double t0 = vpTime::measureTimeMs();
+
   std::map<std::string, unsigned int> mapOfNbInfos;
   std::map<std::string, unsigned int> mapOfNbFaceUsed;
 
+  bool posePredicted = predictPose();
+  if(posePredicted)
+    vpMbKltMultiTracker::predictKltPoints();
+
   try {
     vpMbKltMultiTracker::preTracking(mapOfImages, mapOfNbInfos, mapOfNbFaceUsed);
   } catch(/*vpException &e*/...) {
@@ -2190,6 +2236,8 @@ void vpMbEdgeKltMultiTracker::track(std::map<std::string, const vpImage<unsigned
   vpColVector w_klt;
 
   //MBT: track moving edges
+  if(posePredicted)
+    vpMbEdgeMultiTracker::predictMovingEdge();
   trackMovingEdges(mapOfImages);
 
   vpColVector w_mbt;
@@ -2201,6 +2249,10 @@ void vpMbEdgeKltMultiTracker::track(std::map<std::string, const vpImage<unsigned
   if(computeProjError) {
     vpMbEdgeMultiTracker::computeProjectionError();
   }
+
+  updatePosePrediction();
+
+  vpMbEdgeMultiTracker::adaptFeatureBudget(vpTime::measureTimeMs() - t0);
 }
 
 unsigned int vpMbEdgeKltMultiTracker::trackFirstLoop(std::map<std::string, const vpImage<unsigned char> *> &mapOfImages,
@@ -2218,38 +2270,79 @@ unsigned int vpMbEdgeKltMultiTracker::trackFirstLoop(std::map<std::string, const
       return nbrow;
   }
 
-  factor = vpColVector();
+  std::vector<vpMbEdgeTracker *> trackers;
+  std::vector<const vpImage<unsigned char> *> images;
+  std::vector<unsigned int> rowOffsets;
+  unsigned int offset = 0;
   for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it = m_mapOfEdgeTrackers.begin();
       it != m_mapOfEdgeTrackers.end(); ++it) {
     //Set the corresponding cMo for each camera
     //Used in computeVVSFirstPhaseFactor with computeInteractionMatrixError
     it->second->cMo = m_mapOfCameraTransformationMatrix[it->first] * cMo;
 
-    vpColVector factor_tmp;
-    factor_tmp.resize(mapOfNumberOfRows[it->first]);
-    factor_tmp = 1;
-    it->second->computeVVSFirstPhaseFactor(*mapOfImages[it->first], factor_tmp, lvl);
-
-    factor.stack(factor_tmp);
+    trackers.push_back(it->second);
+    images.push_back(mapOfImages[it->first]);
+    rowOffsets.push_back(offset);
+    offset += mapOfNumberOfRows[it->first];
   }
+  rowOffsets.push_back(offset);
+
+  factor.resize(nbrow, false);
+  int nbCameras = (int) trackers.size();
+  bool camerasThreaded = vpMbEdgeMultiTracker::m_camerasThreaded;
+  vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(camerasThreaded)
+#endif
+  for(int k = 0; k < nbCameras; k++) {
+    if(! camerasThreaded && error.raised())
+      continue;
+    try {
+      vpColVector factor_tmp;
+      factor_tmp.resize(rowOffsets[(size_t) k+1] - rowOffsets[(size_t) k]);
+      factor_tmp = 1;
+      trackers[(size_t) k]->computeVVSFirstPhaseFactor(*images[(size_t) k], factor_tmp, lvl);
+
+      factor.insert(rowOffsets[(size_t) k], factor_tmp);
+    } catch(vpException &e) {
+      error.set(k, e);
+    }
+  }
+  error.rethrow();
 
   return nbrow;
 }
 
 void vpMbEdgeKltMultiTracker::trackMovingEdges(std::map<std::string, const vpImage<unsigned char> *> &mapOfImages) {
+  std::vector<vpMbEdgeTracker *> trackers;
+  std::vector<const vpImage<unsigned char> *> images;
   for(std::map<std::string, vpMbEdgeTracker *>::const_iterator it1 = m_mapOfEdgeTrackers.begin();
       it1 != m_mapOfEdgeTrackers.end(); ++it1) {
+    trackers.push_back(it1->second);
+    images.push_back(mapOfImages[it1->first]);
+  }
+
+  int nbCameras = (int) trackers.size();
+  bool camerasThreaded = vpMbEdgeMultiTracker::m_camerasThreaded;
+  vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(camerasThreaded)
+#endif
+  for(int k = 0; k < nbCameras; k++) {
+    if(! camerasThreaded && error.raised())
+      continue;
     //Track moving edges
     try {
-      it1->second->trackMovingEdge(*mapOfImages[it1->first]);
-    } catch(...) {
+      trackers[(size_t) k]->trackMovingEdge(*images[(size_t) k]);
+    } catch(vpException &e) {
       std::cerr << "Error in moving edge tracking" << std::endl;
-      throw ;
+      error.set(k, e);
     }
   }
+  error.rethrow();
 }
 
 #elif !defined(VISP_BUILD_SHARED_LIBS)
 // Work arround to avoid warning: libvisp_mbt.a(dummy_vpMbEdgeKltMultiTracker.cpp.o) has no symbols
 void dummy_vpMbEdgeKltMultiTracker() {};
-#endif //VISP_HAVE_OPENCV
+#endif //VISP_HAVE_MODULE_KLT
@@ -40,10 +40,11 @@
 
 #include <visp3/core/vpDebug.h>
 #include <visp3/mbt/vpMbEdgeKltTracker.h>
+#include <visp3/core/vpTime.h>
 #include <visp3/core/vpTrackingException.h>
 #include <visp3/core/vpVelocityTwistMatrix.h>
 
-#if defined(VISP_HAVE_MODULE_KLT) && (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 vpMbEdgeKltTracker::vpMbEdgeKltTracker()
   : compute_interaction(true), lambda(0.8), thresholdKLT(2.), thresholdMBT(2.), maxIter(200)
@@ -329,13 +330,15 @@ vpMbEdgeKltTracker::loadConfigFile(const char* configFile)
   xmlp.getMe(meParser);
   vpMbEdgeTracker::setMovingEdge(meParser);
 
-  tracker.setMaxFeatures((int)xmlp.getMaxFeatures());
-  tracker.setWindowSize((int)xmlp.getWindowSize());
-  tracker.setQuality(xmlp.getQuality());
-  tracker.setMinDistance(xmlp.getMinDistance());
-  tracker.setHarrisFreeParameter(xmlp.getHarrisParam());
-  tracker.setBlockSize((int)xmlp.getBlockSize());
-  tracker.setPyramidLevels((int)xmlp.getPyramidLevels());
+  vpKltNative klt;
+  klt.setMaxFeatures((int)xmlp.getMaxFeatures());
+  klt.setWindowSize((int)xmlp.getWindowSize());
+  klt.setQuality(xmlp.getQuality());
+  klt.setMinDistance(xmlp.getMinDistance());
+  klt.setHarrisFreeParameter(xmlp.getHarrisParam());
+  klt.setBlockSize((int)xmlp.getBlockSize());
+  klt.setPyramidLevels((int)xmlp.getPyramidLevels());
+  vpMbKltTracker::setKltNative(klt);
   maskBorder = xmlp.getMaskBorder();
 
   //if(useScanLine)
@@ -439,10 +442,8 @@ vpMbEdgeKltTracker::postTrackingMbt(vpColVector &w, const unsigned int lvl)
 
         for (unsigned int i=0 ; i < l->nbFeature[a] ; i++){
           wmean += w[n+indexLine] ;
-          vpMeSite p = *itListLine;
           if (w[n+indexLine] < 0.5){
-            p.setState(vpMeSite::M_ESTIMATOR);
-            *itListLine = p;
+            itListLine->setState(vpMeSite::M_ESTIMATOR);
           }
 
           ++itListLine;
@@ -480,11 +481,8 @@ vpMbEdgeKltTracker::postTrackingMbt(vpColVector &w, const unsigned int lvl)
       wmean = 0;
       for(unsigned int i=0 ; i < cy->nbFeaturel1 ; i++){
         wmean += w[n+i] ;
-        vpMeSite p = *itListCyl1;
         if (w[n+i] < 0.5){
-          p.setState(vpMeSite::M_ESTIMATOR);
-
-          *itListCyl1 = p;
+          itListCyl1->setState(vpMeSite::M_ESTIMATOR);
         }
 
         ++itListCyl1;
@@ -504,11 +502,8 @@ vpMbEdgeKltTracker::postTrackingMbt(vpColVector &w, const unsigned int lvl)
       wmean = 0;
       for(unsigned int i=cy->nbFeaturel1 ; i < cy->nbFeature ; i++){
         wmean += w[n+i] ;
-        vpMeSite p = *itListCyl2;
         if (w[n+i] < 0.5){
-          p.setState(vpMeSite::M_ESTIMATOR);
-
-          *itListCyl2 = p;
+          itListCyl2->setState(vpMeSite::M_ESTIMATOR);
         }
 
         ++itListCyl2;
@@ -544,11 +539,8 @@ vpMbEdgeKltTracker::postTrackingMbt(vpColVector &w, const unsigned int lvl)
       wmean = 0;
       for(unsigned int i=0 ; i < ci->nbFeature ; i++){
         wmean += w[n+i] ;
-        vpMeSite p = *itListCir;
         if (w[n+i] < 0.5){
-          p.setState(vpMeSite::M_ESTIMATOR);
-
-          *itListCir = p;
+          itListCir->setState(vpMeSite::M_ESTIMATOR);
         }
 
         ++itListCir;
@@ -592,37 +584,22 @@ vpMbEdgeKltTracker::computeVVS(const vpImage<unsigned char>& I, const unsigned i
   else if(nbrow < 4)
     nbrow = 0;
   
-  double residu = 0;
-  double residu_1 = -1;
-  unsigned int iter = 0;
-
-  vpMatrix *L;
-  vpMatrix L_mbt, L_klt;     // interaction matrix
-  vpColVector *R;
-  vpColVector R_mbt, R_klt;  // residu
+  const unsigned int nbrow_klt = (nbInfos > 3) ? 2*nbInfos : 0;
+
+  vpMatrix L(nbrow + nbrow_klt, 6);     // interaction matrix
+  vpColVector R(nbrow + nbrow_klt);     // residu
+  vpMatrix L_mbt;
+  vpColVector R_mbt;
   vpMatrix L_true;
-  vpMatrix LVJ_true;
-  //vpColVector R_true;
-  vpColVector w_true;
   
   if(nbrow != 0){
     L_mbt.resize(nbrow,6);
     R_mbt.resize(nbrow);
   }
   
-  if(nbInfos != 0){
-    L_klt.resize(2*nbInfos,6);
-    R_klt.resize(2*nbInfos);
-  }
-  
-  //vpColVector w;  // weight from MEstimator
-  vpColVector v;  // "speed" for VVS
   vpRobust robust_mbt(0), robust_klt(0);
   vpHomography H;
 
-  vpMatrix LTL;
-  vpColVector LTR;
-  
   double factorMBT = 1.0;
   double factorKLT = 1.0;
   
@@ -637,75 +614,35 @@ vpMbEdgeKltTracker::computeVVS(const vpImage<unsigned char>& I, const unsigned i
   if (nbInfos < 4)
     factorMBT = 1.;
 
-  double residuMBT = 0;
-  double residuKLT = 0;
-
   vpHomogeneousMatrix cMoPrev;
   vpHomogeneousMatrix ctTc0_Prev;
-  vpColVector m_error_prev(2*nbInfos + nbrow);
-  vpColVector m_w_prev(2*nbInfos + nbrow);
-  double mu = 0.01;
+
+  vpMbtVVSSolver solver(m_optimizationMethod, lambda, maxIter);
+  solver.setStopCriteria(m_stopCriteriaResidual, m_stopCriteriaIncrement);
   
-  while( ((int)((residu - residu_1)*1e8) !=0 )  && (iter<maxIter) ){   
-    L = new vpMatrix();
-    R = new vpColVector();
-    
-    if(nbrow >= 4)
+  while(! solver.hasConverged()){
+    const unsigned int iter = solver.getIteration();
+
+    // The edge rows come first, then the KLT rows are filled in place
+    if(nbrow != 0){
       trackSecondLoop(I,L_mbt,R_mbt,cMo,lvl);
+      L.insert(L_mbt, 0, 0);
+      R.insert(0, R_mbt);
+    }
       
-    if(nbInfos >= 4){
-      unsigned int shift = 0;
-      vpMbtDistanceKltPoints *kltpoly;
-    //  for (unsigned int i = 0; i < faces.size(); i += 1){
-      for(std::list<vpMbtDistanceKltPoints*>::const_iterator it=vpMbKltTracker::kltPolygons.begin(); it!=vpMbKltTracker::kltPolygons.end(); ++it){
-        kltpoly = *it;
-        if(kltpoly->polygon->isVisible() && kltpoly->isTracked() && kltpoly->hasEnoughPoints()){
-          vpSubColVector subR(R_klt, shift, 2*kltpoly->getCurrentNumberPoints());
-          vpSubMatrix subL(L_klt, shift, 0, 2*kltpoly->getCurrentNumberPoints(), 6);
-          kltpoly->computeHomography(ctTc0, H);
-          kltpoly->computeInteractionMatrixAndResidu(subR, subL);
-          shift += 2*kltpoly->getCurrentNumberPoints();
-        }
-      }
-
-      vpMbtDistanceKltCylinder *kltPolyCylinder;
-      for(std::list<vpMbtDistanceKltCylinder*>::const_iterator it=kltCylinders.begin(); it!=kltCylinders.end(); ++it){
-        kltPolyCylinder = *it;
-
-        if(kltPolyCylinder->isTracked() && kltPolyCylinder->hasEnoughPoints())
-        {
-          vpSubColVector subR(R_klt, shift, 2*kltPolyCylinder->getCurrentNumberPoints());
-          vpSubMatrix subL(L_klt, shift, 0, 2*kltPolyCylinder->getCurrentNumberPoints(), 6);
-          try{
-            kltPolyCylinder->computeInteractionMatrixAndResidu(ctTc0,subR, subL);
-          }catch(...){
-            throw vpTrackingException(vpTrackingException::fatalError, "Cannot compute interaction matrix");
-          }
-
-          shift += 2*kltPolyCylinder->getCurrentNumberPoints();
-        }
-      }
+    if(nbrow_klt != 0){
+      vpMbKltTracker::computeVVSInteractionMatrixAndResidu(nbrow, R, L, H, vpMbKltTracker::kltPolygons, kltCylinders, ctTc0);
     }
 
-    bool reStartFromLastIncrement = false;
-    if(iter != 0 && m_optimizationMethod == vpMbTracker::LEVENBERG_MARQUARDT_OPT){
-      if(m_error.sumSquare()/(double)(2*nbInfos + nbrow) > m_error_prev.sumSquare()/(double)(2*nbInfos + nbrow)){
-        mu *= 10.0;
-
-        if(mu > 1.0)
-          throw vpTrackingException(vpTrackingException::fatalError, "Optimization diverged");
+    m_error = R;
 
-        cMo = cMoPrev;
-        m_error = m_error_prev;
-        m_w = m_w_prev;
-        ctTc0 = ctTc0_Prev;
-        reStartFromLastIncrement = true;
-      }
+    if(solver.rejectIncrement(m_error, m_w)){
+      cMo = cMoPrev;
+      ctTc0 = ctTc0_Prev;
     }
-
-    if(!reStartFromLastIncrement){
+    else{
       if(iter == 0){
-        m_w.resize(nbrow + 2*nbInfos);
+        m_w.resize(nbrow + nbrow_klt);
         m_w=1;
 
         if(nbrow != 0){
@@ -714,139 +651,39 @@ vpMbEdgeKltTracker::computeVVS(const vpImage<unsigned char>& I, const unsigned i
           robust_mbt.resize(nbrow);
         }
 
-        if(nbInfos != 0){
-          w_klt.resize(2*nbInfos);
+        if(nbrow_klt != 0){
+          w_klt.resize(nbrow_klt);
           w_klt = 1;
-          robust_klt.resize(2*nbInfos);
+          robust_klt.resize(nbrow_klt);
         }
-
-        w_true.resize(nbrow + 2*nbInfos);
       }
 
         /* robust */
-      if(nbrow > 3){
-        residuMBT = 0;
-        for(unsigned int i = 0; i < R_mbt.getRows(); i++)
-          residuMBT += fabs(R_mbt[i]);
-        residuMBT /= R_mbt.getRows();
-
+      if(nbrow != 0){
         robust_mbt.setIteration(iter);
         robust_mbt.setThreshold(thresholdMBT/cam.get_px());
         robust_mbt.MEstimator( vpRobust::TUKEY, R_mbt, w_mbt);
-        L->stack(L_mbt);
-        R->stack(R_mbt);
       }
 
-      if(nbInfos > 3){
-        residuKLT = 0;
-        for(unsigned int i = 0; i < R_klt.getRows(); i++)
-          residuKLT += fabs(R_klt[i]);
-        residuKLT /= R_klt.getRows();
-
+      if(nbrow_klt != 0){
+        vpSubColVector R_klt(R, nbrow, nbrow_klt);
         robust_klt.setIteration(iter);
         robust_klt.setThreshold(thresholdKLT/cam.get_px());
         robust_klt.MEstimator( vpRobust::TUKEY, R_klt, w_klt);
-
-        L->stack(L_klt);
-        R->stack(R_klt);
       }
 
-      unsigned int cpt = 0;
-      while(cpt< (nbrow+2*nbInfos)){
-        if(cpt<(unsigned)nbrow){
-          m_w[cpt] = ((w_mbt[cpt] * factor[cpt]) * factorMBT) ;
-        }
-        else
-          m_w[cpt] = (w_klt[cpt-nbrow] * factorKLT);
-        cpt++;
-      }
-
-      m_error = (*R);
-      if(computeCovariance){
-        L_true = (*L);
-        if(!isoJoIdentity){
-           vpVelocityTwistMatrix cVo;
-           cVo.buildFrom(cMo);
-           LVJ_true = ((*L)*cVo*oJo);
-        }
-      }
+      for(unsigned int cpt = 0; cpt < nbrow; cpt++)
+        m_w[cpt] = ((w_mbt[cpt] * factor[cpt]) * factorMBT) ;
+      for(unsigned int cpt = 0; cpt < nbrow_klt; cpt++)
+        m_w[nbrow + cpt] = (w_klt[cpt] * factorKLT);
 
-      residu_1 = residu;
-      residu = 0;
-      double num = 0;
-      double den = 0;
-      for (unsigned int i = 0; i < static_cast<unsigned int>(R->getRows()); i++){
-        num += m_w[i]*vpMath::sqr((*R)[i]);
-        den += m_w[i];
-
-        w_true[i] = m_w[i];
-        (*R)[i] *= m_w[i];
-        if(compute_interaction){
-          for (unsigned int j = 0; j < 6; j += 1){
-            (*L)[i][j] *= m_w[i];
-          }
-        }
-      }
+      if(computeCovariance)
+        L_true = L;
 
-      residu = sqrt(num/den);
+      solver.computeIncrement(L, m_error, m_w, NULL, compute_interaction);
 
-      if(isoJoIdentity){
-          LTL = L->AtA();
-          computeJTR(*L, *R, LTR);
-
-          switch(m_optimizationMethod){
-          case vpMbTracker::LEVENBERG_MARQUARDT_OPT:
-          {
-            vpMatrix LMA(LTL.getRows(), LTL.getCols());
-            LMA.eye();
-            vpMatrix LTLmuI = LTL + (LMA*mu);
-            v = -lambda*LTLmuI.pseudoInverse(LTLmuI.getRows()*std::numeric_limits<double>::epsilon())*LTR;
-
-            if(iter != 0)
-              mu /= 10.0;
-
-            m_error_prev = m_error;
-            m_w_prev = m_w;
-            break;
-          }
-          case vpMbTracker::GAUSS_NEWTON_OPT:
-          default:
-            v = -lambda * LTL.pseudoInverse(LTL.getRows()*std::numeric_limits<double>::epsilon()) * LTR;
-          }
-      }
-      else{
-          vpVelocityTwistMatrix cVo;
-          cVo.buildFrom(cMo);
-          vpMatrix LVJ = ((*L)*cVo*oJo);
-          vpMatrix LVJTLVJ = (LVJ).AtA();
-          vpColVector LVJTR;
-          computeJTR(LVJ, *R, LVJTR);
-
-          switch(m_optimizationMethod){
-          case vpMbTracker::LEVENBERG_MARQUARDT_OPT:
-          {
-            vpMatrix LMA(LVJTLVJ.getRows(), LVJTLVJ.getCols());
-            LMA.eye();
-            vpMatrix LTLmuI = LVJTLVJ + (LMA*mu);
-            v = -lambda*LTLmuI.pseudoInverse(LTLmuI.getRows()*std::numeric_limits<double>::epsilon())*LVJTR;
-            v = cVo * v;
-
-            if(iter != 0)
-              mu /= 10.0;
-
-            m_error_prev = m_error;
-            m_w_prev = m_w;
-            break;
-          }
-          case vpMbTracker::GAUSS_NEWTON_OPT:
-          default:
-          {
-            v = -lambda*LVJTLVJ.pseudoInverse(LVJTLVJ.getRows()*std::numeric_limits<double>::epsilon())*LVJTR;
-            v = cVo * v;
-            break;
-          }
-          }
-      }
+      vpColVector v;  // "speed" for VVS
+      solver.getIncrement(cMo, isoJoIdentity, oJo, v);
 
       cMoPrev = cMo;
       ctTc0_Prev = ctTc0;
@@ -854,24 +691,11 @@ vpMbEdgeKltTracker::computeVVS(const vpImage<unsigned char>& I, const unsigned i
       cMo = ctTc0 * c0Mo;
     }
     
-    iter++;
-    
-    delete L;
-    delete R;
+    solver.nextIteration();
   }
   
-  if(computeCovariance){
-    vpMatrix D;
-    D.diag(w_true);
-
-    // Note that here the covariance is computed on cMoPrev for time computation efficiency
-    if(isoJoIdentity){
-        covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,L_true,D);
-    }
-    else{
-        covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,LVJ_true,D);
-    }
-  }
+  if(computeCovariance)
+    vpMbKltTracker::computeVVSCovariance(solver.getWeights(), cMoPrev, L_true);
 }
 
 /*!
@@ -884,10 +708,15 @@ vpMbEdgeKltTracker::computeVVS(const vpImage<unsigned char>& I, const unsigned i
 void
 vpMbEdgeKltTracker::track(const vpImage<unsigned char>& I)
 { 
+  double t0 = vpTime::measureTimeMs();
   unsigned int nbInfos  = 0;
   unsigned int nbFaceUsed = 0;
   vpColVector w_klt;
 
+  bool posePredicted = predictPose();
+  if(posePredicted)
+    vpMbKltTracker::predictKltPoints();
+
   try{
     vpMbKltTracker::preTracking(I, nbInfos, nbFaceUsed);
   }
@@ -899,6 +728,11 @@ vpMbEdgeKltTracker::track(const vpImage<unsigned char>& I)
     nbInfos = 0;
     // std::cout << "[Warning] Unable to init with KLT" << std::endl;
   }
+
+  // The moving edges are moved onto the model projected with the predicted
+  // pose, refined by the KLT features if any
+  if(posePredicted)
+    vpMbEdgeTracker::predictMovingEdge();
   
   vpMbEdgeTracker::trackMovingEdge(I);
  
@@ -924,6 +758,13 @@ vpMbEdgeKltTracker::track(const vpImage<unsigned char>& I)
     
 //    cleanPyramid(Ipyramid);
   }
+  else
+    redetectKltPoints(I);
+
+  updatePosePrediction();
+  recordKeyFrame(I);
+
+  vpMbEdgeTracker::adaptFeatureBudget(vpTime::measureTimeMs() - t0);
 }
 
 unsigned int
@@ -976,7 +817,7 @@ vpMbEdgeKltTracker::trackFirstLoop(const vpImage<unsigned char>& I, vpColVector
 
           for (unsigned int i=0 ; i < l->nbFeature[a] ; i++){
               factor[n+i] = fac;
-              vpMeSite site = *itListLine;
+              const vpMeSite &site = *itListLine;
               if (site.getState() != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
               ++itListLine;
               indexFeature++;
@@ -1002,16 +843,16 @@ vpMbEdgeKltTracker::trackFirstLoop(const vpImage<unsigned char>& I, vpColVector
 
       for(unsigned int i=0 ; i < cy->nbFeature ; i++){
         factor[n+i] = fac;
-        vpMeSite site;
+        vpMeSite::vpMeSiteState state;
         if(i<cy->nbFeaturel1) {
-          site= *itCyl1;
+          state = itCyl1->getState();
           ++itCyl1;
         }
         else{
-          site= *itCyl2;
+          state = itCyl2->getState();
           ++itCyl2;
         }
-        if (site.getState() != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
+        if (state != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
       }
 
       n+= cy->nbFeature ;
@@ -1031,7 +872,7 @@ vpMbEdgeKltTracker::trackFirstLoop(const vpImage<unsigned char>& I, vpColVector
 
       for(unsigned int i=0 ; i < ci->nbFeature ; i++){
         factor[n+i] = fac;
-        vpMeSite site = *itCir;
+        const vpMeSite &site = *itCir;
         if (site.getState() != vpMeSite::NO_SUPPRESSION) factor[n+i] = 0.2;
         ++itCir;
       }
@@ -1304,7 +1145,7 @@ vpMbEdgeKltTracker::reInitModel(const vpImage<unsigned char>& I, const char* cad
                                 const vpHomogeneousMatrix& cMo_, const bool verbose)
 {
   // Reinit klt
-#if (VISP_HAVE_OPENCV_VERSION < 0x020408)
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION < 0x020408)
   if(cur != NULL){
     cvReleaseImage(&cur);
     cur = NULL;
@@ -1395,4 +1236,4 @@ vpMbEdgeKltTracker::reInitModel(const vpImage<unsigned char>& I, const char* cad
 #elif !defined(VISP_BUILD_SHARED_LIBS)
 // Work arround to avoid warning: libvisp_mbt.a(vpMbEdgeKltTracker.cpp.o) has no symbols
 void dummy_vpMbEdgeKltTracker() {};
-#endif //VISP_HAVE_OPENCV
+#endif //VISP_HAVE_MODULE_KLT
@@ -44,18 +44,20 @@
 
 #include <visp3/core/vpConfig.h>
 
-#if (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 #include <visp3/core/vpTrackingException.h>
 #include <visp3/core/vpVelocityTwistMatrix.h>
 #include <visp3/mbt/vpMbKltMultiTracker.h>
 
+#include "../vpMbtParallelError_impl.h"
+
 
 /*!
   Basic constructor
 */
 vpMbKltMultiTracker::vpMbKltMultiTracker() : m_mapOfCameraTransformationMatrix(), m_mapOfKltTrackers(),
-    m_referenceCameraName("Camera") {
+    m_referenceCameraName("Camera"), m_camerasThreaded(false) {
   m_mapOfKltTrackers["Camera"] = new vpMbKltTracker();
 
   //Add default camera transformation matrix
@@ -68,7 +70,7 @@ vpMbKltMultiTracker::vpMbKltMultiTracker() : m_mapOfCameraTransformationMatrix()
   \param nbCameras : Number of cameras to use.
 */
 vpMbKltMultiTracker::vpMbKltMultiTracker(const unsigned int nbCameras) : m_mapOfCameraTransformationMatrix(),
-    m_mapOfKltTrackers(), m_referenceCameraName("Camera") {
+    m_mapOfKltTrackers(), m_referenceCameraName("Camera"), m_camerasThreaded(false) {
 
   if(nbCameras == 0) {
     throw vpException(vpTrackingException::fatalError, "Cannot construct a vpMbkltMultiTracker with no camera !");
@@ -108,7 +110,7 @@ vpMbKltMultiTracker::vpMbKltMultiTracker(const unsigned int nbCameras) : m_mapOf
   \param cameraNames : List of camera names.
 */
 vpMbKltMultiTracker::vpMbKltMultiTracker(const std::vector<std::string> &cameraNames) : m_mapOfCameraTransformationMatrix(),
-    m_mapOfKltTrackers(), m_referenceCameraName("Camera") {
+    m_mapOfKltTrackers(), m_referenceCameraName("Camera"), m_camerasThreaded(false) {
   if(cameraNames.empty()) {
     throw vpException(vpTrackingException::fatalError, "Cannot construct a vpMbKltMultiTracker with no camera !");
   }
@@ -153,10 +155,6 @@ void vpMbKltMultiTracker::computeVVS(std::map<std::string, unsigned int> &mapOfN
   vpMatrix L;     // interaction matrix
   vpColVector R;  // residu
   vpMatrix L_true;     // interaction matrix
-  vpMatrix LVJ_true;
-  //vpColVector R_true;  // residu
-  vpColVector w_true;
-  vpColVector v;  // "speed" for VVS
 
   unsigned int nbInfos = 0;
   for(std::map<std::string, unsigned int>::const_iterator it = mapOfNbInfos.begin(); it != mapOfNbInfos.end(); ++it) {
@@ -170,85 +168,101 @@ void vpMbKltMultiTracker::computeVVS(std::map<std::string, unsigned int> &mapOfN
     mapOfRobusts[it->first] = vpRobust(2*mapOfNbInfos[it->first]);
   }
 
-  vpMatrix LTL;
-  vpColVector LTR;
   vpHomogeneousMatrix cMoPrev;
   vpHomogeneousMatrix ctTc0_Prev;
-  vpColVector error_prev(2*nbInfos);
-  double mu = 0.01;
-
-  double normRes = 0;
-  double normRes_1 = -1;
-  unsigned int iter = 0;
 
-  std::map<std::string, vpVelocityTwistMatrix> mapOfVelocityTwist;
-  for(std::map<std::string, vpHomogeneousMatrix>::const_iterator it = m_mapOfCameraTransformationMatrix.begin();
-      it != m_mapOfCameraTransformationMatrix.end(); ++it) {
+  //Each camera fills its own slice of the stacked system
+  std::vector<vpMbKltTracker *> trackers;
+  std::vector<vpHomogeneousMatrix> cameraTransformations;
+  std::vector<vpVelocityTwistMatrix> velocityTwists;
+  std::vector<unsigned int> rowOffsets;
+  unsigned int nbRows = 0;
+  for(std::map<std::string, vpMbKltTracker*>::const_iterator it = m_mapOfKltTrackers.begin();
+      it != m_mapOfKltTrackers.end(); ++it) {
+    trackers.push_back(it->second);
+    cameraTransformations.push_back(m_mapOfCameraTransformationMatrix[it->first]);
     vpVelocityTwistMatrix cVo;
-    cVo.buildFrom(it->second);
-    mapOfVelocityTwist[it->first] = cVo;
-  }
-
-  while( ((int)((normRes - normRes_1)*1e8) != 0 )  && (iter<maxIter) ) {
-    L.resize(0,0);
-    R.resize(0);
-
-    for(std::map<std::string, vpMbKltTracker*>::const_iterator it1 = m_mapOfKltTrackers.begin();
-        it1 != m_mapOfKltTrackers.end(); ++it1) {
-      unsigned int shift = 0;
-      vpColVector R_current;  // residu
-      vpMatrix L_current;     // interaction matrix
-      vpHomography H_current;
-
-      R_current.resize(2 * mapOfNbInfos[it1->first]);
-      L_current.resize(2 * mapOfNbInfos[it1->first], 6, 0);
-
-      //Use the ctTc0 variable instead of the formula in the monocular case
-      //to ensure that we have the same result than vpMbKltTracker
-      //as some slight differences can occur due to numerical imprecision
-      if(m_mapOfKltTrackers.size() == 1) {
-        computeVVSInteractionMatrixAndResidu(shift, R_current, L_current, H_current,
-            it1->second->kltPolygons, it1->second->kltCylinders, ctTc0);
-      } else {
-        vpHomogeneousMatrix c_curr_tTc_curr0 = m_mapOfCameraTransformationMatrix[it1->first] *
-            cMo * it1->second->c0Mo.inverse();
-        computeVVSInteractionMatrixAndResidu(shift, R_current, L_current, H_current,
-            it1->second->kltPolygons, it1->second->kltCylinders, c_curr_tTc_curr0);
-      }
+    cVo.buildFrom(cameraTransformations.back());
+    velocityTwists.push_back(cVo);
+    rowOffsets.push_back(nbRows);
+    nbRows += 2 * mapOfNbInfos[it->first];
+  }
+  rowOffsets.push_back(nbRows);
+  int nbCameras = (int) trackers.size();
 
-      //VelocityTwistMatrix
-      L_current = L_current*mapOfVelocityTwist[it1->first];
+  vpMbtVVSSolver solver(m_optimizationMethod, lambda, maxIter);
+  solver.setStopCriteria(m_stopCriteriaResidual, m_stopCriteriaIncrement);
 
-      //Stack residu and interaction matrix
-      R.stack(R_current);
-      L.stack(L_current);
+  while(! solver.hasConverged()) {
+    L.resize(nbRows, 6, false);
+    R.resize(nbRows, false);
+
+    vpMbtParallelError error;
+#ifdef VISP_HAVE_OPENMP
+    #pragma omp parallel for if(m_camerasThreaded)
+#endif
+    for(int k = 0; k < nbCameras; k++) {
+      if(! m_camerasThreaded && error.raised())
+        continue;
+      try {
+        vpMbKltTracker *tracker = trackers[(size_t) k];
+        unsigned int offset = rowOffsets[(size_t) k];
+        unsigned int shift = 0;
+        vpColVector R_current;  // residu
+        vpMatrix L_current;     // interaction matrix
+        vpHomography H_current;
+
+        R_current.resize(rowOffsets[(size_t) k+1] - offset);
+        L_current.resize(rowOffsets[(size_t) k+1] - offset, 6, 0);
+
+        //Use the ctTc0 variable instead of the formula in the monocular case
+        //to ensure that we have the same result than vpMbKltTracker
+        //as some slight differences can occur due to numerical imprecision
+        if(nbCameras == 1) {
+          computeVVSInteractionMatrixAndResidu(shift, R_current, L_current, H_current,
+              tracker->kltPolygons, tracker->kltCylinders, ctTc0);
+        } else {
+          vpHomogeneousMatrix c_curr_tTc_curr0 = cameraTransformations[(size_t) k] *
+              cMo * tracker->c0Mo.inverse();
+          computeVVSInteractionMatrixAndResidu(shift, R_current, L_current, H_current,
+              tracker->kltPolygons, tracker->kltCylinders, c_curr_tTc_curr0);
+        }
+
+        //Insert residu and interaction matrix (with the VelocityTwistMatrix) in the slice of the camera
+        R.insert(offset, R_current);
+        L.insert(L_current*velocityTwists[(size_t) k], offset, 0);
+      }
+      catch(vpException &e) {
+        error.set(k, e);
+      }
     }
+    error.rethrow();
 
-    bool reStartFromLastIncrement = false;
-    computeVVSCheckLevenbergMarquardtKlt(iter, nbInfos, cMoPrev, error_prev, ctTc0_Prev, mu, reStartFromLastIncrement);
+    m_error = R;
 
-    if(!reStartFromLastIncrement) {
-      vpMbKltMultiTracker::computeVVSWeights(iter, nbInfos, mapOfNbInfos, R, w_true, w, mapOfRobusts, 2.0);
+    if(solver.rejectIncrement(m_error, w)) {
+      cMo = cMoPrev;
+      ctTc0 = ctTc0_Prev;
+    }
+    else {
+      vpMbKltMultiTracker::computeVVSWeights(solver.getIteration(), nbInfos, mapOfNbInfos, R, w, mapOfRobusts, 2.0);
 
-      computeVVSPoseEstimation(iter, L, w, L_true, LVJ_true, normRes, normRes_1, w_true, R, LTL, LTR,
-          error_prev, v, mu, cMoPrev, ctTc0_Prev);
-    } // endif(!reStartFromLastIncrement)
+      computeVVSPoseEstimation(solver, L, w, L_true, cMoPrev, ctTc0_Prev);
+    }
 
-    iter++;
+    solver.nextIteration();
   }
 
-  computeVVSCovariance(w_true, cMoPrev, L_true, LVJ_true);
+  computeVVSCovariance(solver.getWeights(), cMoPrev, L_true);
 }
 
 void vpMbKltMultiTracker::computeVVSWeights(const unsigned int iter, const unsigned int nbInfos,
-    std::map<std::string, unsigned int> &mapOfNbInfos, vpColVector &R, vpColVector &w_true, vpColVector &w,
+    std::map<std::string, unsigned int> &mapOfNbInfos, vpColVector &R, vpColVector &w,
     std::map<std::string, vpRobust> &mapOfRobusts, double threshold) {
   /* robust */
   if(iter == 0) {
-    w_true.resize(2*nbInfos);
     w.resize(2*nbInfos);
     w = 1;
-    w_true = 1;
 
     for(std::map<std::string, vpMbKltTracker*>::const_iterator it = m_mapOfKltTrackers.begin();
         it != m_mapOfKltTrackers.end(); ++it) {
@@ -682,10 +696,11 @@ std::list<vpMbtDistanceKltCylinder*>& vpMbKltMultiTracker::getFeaturesKltCylinde
 /*!
   Get the current list of KLT points for each camera.
 
-  \warning Contrary to getKltPoints which returns a pointer on CvPoint2D32f.
-  This function convert and copy the openCV KLT points into vpImagePoints.
+  \warning Contrary to getKltPoints which returns OpenCV points.
+  This function convert and copy the KLT points into vpImagePoints, whatever
+  the KLT backend is.
 
-  \return the list of KLT points through vpKltOpencv for each camera.
+  \return the list of KLT points for each camera.
 */
 std::map<std::string, std::vector<vpImagePoint> > vpMbKltMultiTracker::getKltImagePoints() const {
   std::map<std::string, std::vector<vpImagePoint> > mapOfFeatures;
@@ -701,10 +716,11 @@ std::map<std::string, std::vector<vpImagePoint> > vpMbKltMultiTracker::getKltIma
 /*!
   Get the current list of KLT points and their id for each camera.
 
-  \warning Contrary to getKltPoints which returns a pointer on CvPoint2D32f.
-  This function convert and copy the openCV KLT points into vpImagePoints.
+  \warning Contrary to getKltPoints which returns OpenCV points.
+  This function convert and copy the KLT points into vpImagePoints, whatever
+  the KLT backend is.
 
-  \return the list of KLT points and their id through vpKltOpencv for each camera.
+  \return the list of KLT points and their id for each camera.
 */
 std::map<std::string, std::map<int, vpImagePoint> > vpMbKltMultiTracker::getKltImagePointsWithId() const {
   std::map<std::string, std::map<int, vpImagePoint> > mapOfFeatures;
@@ -718,7 +734,24 @@ std::map<std::string, std::map<int, vpImagePoint> > vpMbKltMultiTracker::getKltI
 }
 
 /*!
-  Get the klt tracker at the current state for each camera.
+  Get the native klt tracker at the current state for each camera.
+
+  \return klt tracker.
+*/
+std::map<std::string, vpKltNative> vpMbKltMultiTracker::getKltNative() const {
+  std::map<std::string, vpKltNative> mapOfKltTracker;
+
+  for(std::map<std::string, vpMbKltTracker*>::const_iterator it = m_mapOfKltTrackers.begin();
+      it != m_mapOfKltTrackers.end(); ++it) {
+    mapOfKltTracker[it->first] = it->second->getKltNative();
+  }
+
+  return mapOfKltTracker;
+}
+
+#if defined(VISP_HAVE_OPENCV)
+/*!
+  Get the OpenCV klt tracker at the current state for each camera.
 
   \return klt tracker.
 */
@@ -738,7 +771,7 @@ std::map<std::string, vpKltOpencv> vpMbKltMultiTracker::getKltOpencv() const {
 
   \return The list of KLT points through vpKltOpencv.
 */
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
 std::map<std::string, std::vector<cv::Point2f> > vpMbKltMultiTracker::getKltPoints() const {
   std::map<std::string, std::vector<cv::Point2f> > mapOfFeatures;
 
@@ -749,7 +782,7 @@ std::map<std::string, std::vector<cv::Point2f> > vpMbKltMultiTracker::getKltPoin
 
   return mapOfFeatures;
 }
-#else
+#  else
 std::map<std::string, CvPoint2D32f*> vpMbKltMultiTracker::getKltPoints() {
   std::map<std::string, CvPoint2D32f*> mapOfFeatures;
 
@@ -760,6 +793,7 @@ std::map<std::string, CvPoint2D32f*> vpMbKltMultiTracker::getKltPoints() {
 
   return mapOfFeatures;
 }
+#  endif
 #endif
 
 /*!
@@ -1556,6 +1590,23 @@ void vpMbKltMultiTracker::loadModel(const std::string &modelFile, const bool ver
   modelInitialised = true;
 }
 
+/*!
+  Take into account a pose predicted before the tracking of new images: the
+  pose of each camera is deduced from the predicted pose of the reference
+  camera, and the position of the KLT features is predicted for each camera
+  (see vpMbKltTracker::predictKltPoints()).
+*/
+void vpMbKltMultiTracker::predictKltPoints() {
+  ctTc0 = cMo * c0Mo.inverse();
+
+  for(std::map<std::string, vpMbKltTracker*>::const_iterator it = m_mapOfKltTrackers.begin();
+      it != m_mapOfKltTrackers.end(); ++it) {
+    vpMbKltTracker *tracker = it->second;
+    tracker->cMo = m_mapOfCameraTransformationMatrix[it->first] * cMo;
+    tracker->predictKltPoints();
+  }
+}
+
 void vpMbKltMultiTracker::preTracking(std::map<std::string, const vpImage<unsigned char> *> &mapOfImages,
     std::map<std::string, unsigned int> &mapOfNbInfos,
     std::map<std::string, unsigned int> &mapOfNbFaceUsed) {
@@ -1565,10 +1616,25 @@ void vpMbKltMultiTracker::preTracking(std::map<std::string, const vpImage<unsign
     mapOfNbFaceUsed[it->first] = 0;
   }
 
+  std::vector<vpMbKltTracker *> trackers;
+  std::vector<const vpImage<unsigned char> *> images;
+  std::vector<unsigned int *> nbInfos;
+  std::vector<unsigned int *> nbFaceUsed;
   for (std::map<std::string, vpMbKltTracker*>::const_iterator it =
       m_mapOfKltTrackers.begin(); it != m_mapOfKltTrackers.end(); ++it) {
+    trackers.push_back(it->second);
+    images.push_back(mapOfImages[it->first]);
+    nbInfos.push_back(&mapOfNbInfos[it->first]);
+    nbFaceUsed.push_back(&mapOfNbFaceUsed[it->first]);
+  }
+
+  int nbCameras = (int) trackers.size();
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(m_camerasThreaded)
+#endif
+  for (int k = 0; k < nbCameras; k++) {
     try {
-      it->second->preTracking(*mapOfImages[it->first], mapOfNbInfos[it->first], mapOfNbFaceUsed[it->first]);
+      trackers[(size_t) k]->preTracking(*images[(size_t) k], *nbInfos[(size_t) k], *nbFaceUsed[(size_t) k]);
     } catch (/*vpException &e*/...) {
 //      throw e;
     }
@@ -1577,24 +1643,57 @@ void vpMbKltMultiTracker::preTracking(std::map<std::string, const vpImage<unsign
 
 void vpMbKltMultiTracker::postTracking(std::map<std::string, const vpImage<unsigned char> *> &mapOfImages,
     std::map<std::string, unsigned int> &mapOfNbInfos, vpColVector &w_klt) {
+  std::vector<vpMbKltTracker *> trackers;
+  std::vector<const vpImage<unsigned char> *> images;
+  std::vector<unsigned int> shifts;
+  std::vector<unsigned int> nbInfos;
+  int referenceIndex = -1;
   unsigned int shift = 0;
   for(std::map<std::string, vpMbKltTracker *>::const_iterator it = m_mapOfKltTrackers.begin();
       it != m_mapOfKltTrackers.end(); ++it) {
     //Set the camera pose
     it->second->cMo = m_mapOfCameraTransformationMatrix[it->first]*cMo;
 
-    if(mapOfNbInfos[it->first] > 0) {
-      vpSubColVector sub_w(w_klt, shift, 2*mapOfNbInfos[it->first]);
-      shift += 2*mapOfNbInfos[it->first];
-      if(it->second->postTracking(*mapOfImages[it->first], sub_w)) {
-        it->second->reinit(*mapOfImages[it->first]);
+    if(it->first == m_referenceCameraName) {
+      referenceIndex = (int) trackers.size();
+    }
 
-        //set ctTc0 to identity
-        if(it->first == m_referenceCameraName) {
-          reinit(/*mapOfImages[it->first]*/);
-        }
+    trackers.push_back(it->second);
+    images.push_back(mapOfImages[it->first]);
+    shifts.push_back(shift);
+    nbInfos.push_back(mapOfNbInfos[it->first]);
+    shift += 2*mapOfNbInfos[it->first];
+  }
+
+  int nbCameras = (int) trackers.size();
+  std::vector<int> reinitialised((size_t) nbCameras, 0);
+  vpMbtParallelError error;
+  // The visibility test with Ogre done by postTracking() is not thread safe
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for if(m_camerasThreaded && ! useOgre)
+#endif
+  for(int k = 0; k < nbCameras; k++) {
+    if(nbInfos[(size_t) k] == 0 || ((! m_camerasThreaded || useOgre) && error.raised()))
+      continue;
+    try {
+      vpSubColVector sub_w(w_klt, shifts[(size_t) k], 2*nbInfos[(size_t) k]);
+      if(trackers[(size_t) k]->postTracking(*images[(size_t) k], sub_w)) {
+        trackers[(size_t) k]->reinit(*images[(size_t) k]);
+        reinitialised[(size_t) k] = 1;
+      }
+      else {
+        trackers[(size_t) k]->redetectKltPoints(*images[(size_t) k]);
       }
     }
+    catch(vpException &e) {
+      error.set(k, e);
+    }
+  }
+  error.rethrow();
+
+  //set ctTc0 to identity
+  if(referenceIndex >= 0 && reinitialised[(size_t) referenceIndex]) {
+    reinit(/*mapOfImages[it->first]*/);
   }
 }
 
@@ -1767,6 +1866,8 @@ void vpMbKltMultiTracker::resetTracker() {
   maxIter = 200;
 
   m_optimizationMethod = vpMbTracker::GAUSS_NEWTON_OPT;
+  m_posePrediction = vpMbTracker::NO_PREDICTION;
+  resetPosePrediction();
 
   useScanLine = false;
 
@@ -2070,11 +2171,59 @@ void vpMbKltMultiTracker::setFarClippingDistance(const std::string &cameraName,
   }
 #endif
 
-  /*!
-    Set the new value of the klt tracker.
+/*!
+  Set the implementation of the KLT tracker used to detect and track the
+  points for all the cameras (see vpMbKltTracker::setKltBackend()).
 
-    \param t : Klt tracker containing the new values.
-  */
+  \warning This function has to be called before the initialization of the
+  tracker.
+
+  \param backend : NATIVE_KLT or OPENCV_KLT.
+*/
+void vpMbKltMultiTracker::setKltBackend(const vpMbtKltBackend backend) {
+  vpMbKltTracker::setKltBackend(backend);
+
+  for(std::map<std::string, vpMbKltTracker *>::const_iterator it_klt = m_mapOfKltTrackers.begin();
+      it_klt != m_mapOfKltTrackers.end(); ++it_klt) {
+    it_klt->second->setKltBackend(backend);
+  }
+}
+
+/*!
+  Set the new value of the klt tracker.
+
+  \param t : Klt tracker containing the new values.
+*/
+void vpMbKltMultiTracker::setKltNative(const vpKltNative& t) {
+  for(std::map<std::string, vpMbKltTracker *>::const_iterator it_klt = m_mapOfKltTrackers.begin();
+      it_klt != m_mapOfKltTrackers.end(); ++it_klt) {
+    it_klt->second->setKltNative(t);
+  }
+}
+
+/*!
+  Set the new value of the klt tracker for the specified cameras.
+
+  \param mapOfKltTrackers : Map of Klt trackers containing the new values.
+*/
+void vpMbKltMultiTracker::setKltNative(const std::map<std::string, vpKltNative> &mapOfKltTrackers) {
+  for(std::map<std::string, vpKltNative>::const_iterator it_kltNative = mapOfKltTrackers.begin();
+      it_kltNative != mapOfKltTrackers.end(); ++it_kltNative) {
+    std::map<std::string, vpMbKltTracker*>::const_iterator it_klt = m_mapOfKltTrackers.find(it_kltNative->first);
+    if(it_klt != m_mapOfKltTrackers.end()) {
+      it_klt->second->setKltNative(it_kltNative->second);
+    } else {
+      std::cerr << "The camera: " << it_kltNative->first << " does not exist !" << std::endl;
+    }
+  }
+}
+
+#if defined(VISP_HAVE_OPENCV)
+/*!
+  Set the new value of the klt tracker.
+
+  \param t : Klt tracker containing the new values.
+*/
 void vpMbKltMultiTracker::setKltOpencv(const vpKltOpencv& t) {
   for(std::map<std::string, vpMbKltTracker *>::const_iterator it_klt = m_mapOfKltTrackers.begin();
       it_klt != m_mapOfKltTrackers.end(); ++it_klt) {
@@ -2098,6 +2247,27 @@ void vpMbKltMultiTracker::setKltOpencv(const std::map<std::string, vpKltOpencv>
     }
   }
 }
+#endif
+
+/*!
+  Activate the detection of new KLT points where they were lost for all the
+  cameras (see vpMbKltTracker::setKltRedetection()).
+
+  \param activate : True to detect new points where they were lost.
+  \param cellSize : Size in pixel of the cells.
+  \param nbPoints : Number of points wanted in a cell.
+  \param timeBudget : Maximal time in ms spent in the detection for each
+  camera after each tracking step.
+*/
+void vpMbKltMultiTracker::setKltRedetection(const bool activate, const unsigned int cellSize,
+                                            const unsigned int nbPoints, const double timeBudget) {
+  vpMbKltTracker::setKltRedetection(activate, cellSize, nbPoints, timeBudget);
+
+  for(std::map<std::string, vpMbKltTracker*>::const_iterator it = m_mapOfKltTrackers.begin();
+      it != m_mapOfKltTrackers.end(); ++it) {
+    it->second->setKltRedetection(activate, cellSize, nbPoints, timeBudget);
+  }
+}
 
 /*!
   Set the flag to consider if the level of detail (LOD) is used for all the cameras.
@@ -2191,6 +2361,22 @@ void vpMbKltMultiTracker::setMinPolygonAreaThresh(const double minPolygonAreaThr
   }
 }
 
+/*!
+  Set the directory of the binary model cache for all the cameras.
+
+  \param directory : Directory of the cache. If empty, the cache is not used.
+
+  \sa vpMbTracker::setModelCacheDirectory()
+*/
+void vpMbKltMultiTracker::setModelCacheDirectory(const std::string &directory) {
+  vpMbTracker::setModelCacheDirectory(directory);
+
+  for(std::map<std::string, vpMbKltTracker*>::const_iterator it = m_mapOfKltTrackers.begin();
+      it != m_mapOfKltTrackers.end(); ++it) {
+    it->second->setModelCacheDirectory(directory);
+  }
+}
+
 /*!
   Set the near distance for clipping.
 
@@ -2274,6 +2460,41 @@ void vpMbKltMultiTracker::setOptimizationMethod(const vpMbtOptimizationMethod &o
   m_optimizationMethod = opt;
 }
 
+/*!
+  Set the motion model used to predict the pose before the tracking of new
+  images, for all the cameras (see vpMbTracker::setPosePrediction()).
+
+  \param method : Motion model.
+*/
+void vpMbKltMultiTracker::setPosePrediction(const vpMbtPosePredictionMethod &method) {
+  for(std::map<std::string, vpMbKltTracker*>::const_iterator it = m_mapOfKltTrackers.begin();
+      it != m_mapOfKltTrackers.end(); ++it) {
+    it->second->setPosePrediction(method);
+  }
+
+  vpMbTracker::setPosePrediction(method);
+}
+
+/*!
+  Set the parameters of the Kalman filter used by the KALMAN_PREDICTION
+  motion model, for all the cameras (see
+  vpMbTracker::setPosePredictionKalmanParameters()).
+
+  \param stateVariance : Variance of the acceleration of the camera.
+  \param measureVariance : Variance of the velocity measured by the tracking.
+  \param rho : Degree of correlation between successive accelerations, in
+  [0, 1[.
+*/
+void vpMbKltMultiTracker::setPosePredictionKalmanParameters(const double stateVariance, const double measureVariance,
+                                                  const double rho) {
+  for(std::map<std::string, vpMbKltTracker*>::const_iterator it = m_mapOfKltTrackers.begin();
+      it != m_mapOfKltTrackers.end(); ++it) {
+    it->second->setPosePredictionKalmanParameters(stateVariance, measureVariance, rho);
+  }
+
+  vpMbTracker::setPosePredictionKalmanParameters(stateVariance, measureVariance, rho);
+}
+
 /*!
   Set the pose to be used in entry of the next call to the track() function.
   This pose will be just used once.
@@ -2465,6 +2686,23 @@ void vpMbKltMultiTracker::setReferenceCameraName(const std::string &referenceCam
   }
 }
 
+/*!
+  Enable or disable the parallel rendering of the scanline visibility test of
+  all the cameras.
+
+  \param threaded : true to render both image axes in parallel.
+
+  \sa vpMbTracker::setScanLineThreaded()
+*/
+void vpMbKltMultiTracker::setScanLineThreaded(const bool threaded) {
+  vpMbTracker::setScanLineThreaded(threaded);
+
+  for(std::map<std::string, vpMbKltTracker*>::const_iterator it = m_mapOfKltTrackers.begin();
+      it != m_mapOfKltTrackers.end(); ++it) {
+    it->second->setScanLineThreaded(threaded);
+  }
+}
+
 /*!
   Use Scanline algorithm for visibility tests
 
@@ -2520,6 +2758,12 @@ void vpMbKltMultiTracker::track(const vpImage<unsigned char> &I) {
   std::map<std::string, vpMbKltTracker *>::const_iterator it = m_mapOfKltTrackers.find(m_referenceCameraName);
 
   if(it != m_mapOfKltTrackers.end()) {
+    // The camera velocity is the one of the reference camera
+    if(m_cameraDisplacementValid) {
+      it->second->m_cameraDisplacement = m_cameraDisplacement;
+      it->second->m_cameraDisplacementValid = true;
+      m_cameraDisplacementValid = false;
+    }
     it->second->track(I);
     it->second->getPose(cMo);
   } else {
@@ -2574,6 +2818,9 @@ void vpMbKltMultiTracker::track(std::map<std::string, const vpImage<unsigned cha
   std::map<std::string, unsigned int> mapOfNbInfos;
   std::map<std::string, unsigned int> mapOfNbFaceUsed;
 
+  if(predictPose())
+    predictKltPoints();
+
   preTracking(mapOfImages, mapOfNbInfos, mapOfNbFaceUsed);
 
   bool atLeastOneTrackerOk = false;
@@ -2592,9 +2839,11 @@ void vpMbKltMultiTracker::track(std::map<std::string, const vpImage<unsigned cha
   computeVVS(mapOfNbInfos, m_w);
 
   postTracking(mapOfImages, mapOfNbInfos, m_w);
+
+  updatePosePrediction();
 }
 
 #elif !defined(VISP_BUILD_SHARED_LIBS)
 // Work arround to avoid warning: libvisp_mbt.a(dummy_vpMbKltMultiTracker.cpp.o) has no symbols
 void dummy_vpMbKltMultiTracker() {};
-#endif //VISP_HAVE_OPENCV
+#endif //VISP_HAVE_MODULE_KLT
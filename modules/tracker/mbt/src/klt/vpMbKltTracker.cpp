@@ -40,29 +40,61 @@
 #include <visp3/mbt/vpMbKltTracker.h>
 #include <visp3/core/vpVelocityTwistMatrix.h>
 #include <visp3/core/vpTrackingException.h>
+#include <visp3/core/vpPolygon.h>
+#include <visp3/core/vpTime.h>
 
-#if defined(VISP_HAVE_MODULE_KLT) && (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+
+/*!
+  Copy the detection and tracking parameters of a KLT tracker to another
+  one, which can use a different implementation.
+*/
+template <class KltSource, class KltDestination>
+static void copyKltParameters(const KltSource &src, KltDestination &dst)
+{
+  dst.setMaxFeatures(src.getMaxFeatures());
+  dst.setWindowSize(src.getWindowSize());
+  dst.setQuality(src.getQuality());
+  dst.setMinDistance(src.getMinDistance());
+  dst.setHarrisFreeParameter(src.getHarrisFreeParameter());
+  dst.setBlockSize(src.getBlockSize());
+  dst.setPyramidLevels(src.getPyramidLevels());
+}
 
 vpMbKltTracker::vpMbKltTracker()
   :
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+#if defined(VISP_HAVE_OPENCV)
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
     cur(),
-#else
+#  else
     cur(NULL),
+#  endif
 #endif
     c0Mo(), compute_interaction(true),
     firstInitialisation(true), maskBorder(5), lambda(0.8), maxIter(200), threshold_outlier(0.5),
-    percentGood(0.6), ctTc0(), tracker(), kltPolygons(), kltCylinders(), circles_disp()
+    percentGood(0.6), ctTc0(),
+#if defined(VISP_HAVE_OPENCV)
+    tracker(), m_kltNative(), m_kltBackend(OPENCV_KLT),
+#else
+    m_kltNative(), m_kltBackend(NATIVE_KLT),
+#endif
+    kltPolygons(), kltCylinders(), circles_disp(),
+    kltRedetection(false), kltRedetectionCellSize(32), kltRedetectionNbPoints(8), kltRedetectionTimeBudget(2.0),
+    kltRedetectionCell(0)
 {  
+  m_kltNative.setUseHarris(1);
+  m_kltNative.setMaxFeatures(10000);
+  m_kltNative.setWindowSize(5);
+  m_kltNative.setQuality(0.01);
+  m_kltNative.setMinDistance(5);
+  m_kltNative.setHarrisFreeParameter(0.01);
+  m_kltNative.setBlockSize(3);
+  m_kltNative.setPyramidLevels(3);
+#if defined(VISP_HAVE_OPENCV)
   tracker.setTrackerId(1);
   tracker.setUseHarris(1);
-  tracker.setMaxFeatures(10000);
-  tracker.setWindowSize(5);
-  tracker.setQuality(0.01);
-  tracker.setMinDistance(5);
-  tracker.setHarrisFreeParameter(0.01);
-  tracker.setBlockSize(3);
-  tracker.setPyramidLevels(3);
+  copyKltParameters(m_kltNative, tracker);
+#endif
   
   angleAppears = vpMath::rad(65);
   angleDisappears = vpMath::rad(75);
@@ -78,7 +110,7 @@ vpMbKltTracker::vpMbKltTracker()
 */
 vpMbKltTracker::~vpMbKltTracker()
 {
-#if (VISP_HAVE_OPENCV_VERSION < 0x020408)
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION < 0x020408)
   if(cur != NULL){
     cvReleaseImage(&cur);
     cur = NULL;
@@ -156,8 +188,6 @@ vpMbKltTracker::reinit(const vpImage<unsigned char>& I)
   c0Mo = cMo;
   ctTc0.eye();
 
-  vpImageConvert::convert(I, cur);
-
   cam.computeFov(I.getWidth(), I.getHeight());
 
   if(useScanLine){
@@ -166,17 +196,12 @@ vpMbKltTracker::reinit(const vpImage<unsigned char>& I)
   }
   
   // mask
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
-  cv::Mat mask((int)I.getRows(), (int)I.getCols(), CV_8UC1, cv::Scalar(0));
-#else
-  IplImage* mask = cvCreateImage(cvSize((int)I.getWidth(), (int)I.getHeight()), IPL_DEPTH_8U, 1);
-  cvZero(mask);
-#endif
+  vpImage<unsigned char> mask(I.getHeight(), I.getWidth(), 0);
 
   vpMbtDistanceKltPoints *kltpoly;
   vpMbtDistanceKltCylinder *kltPolyCylinder;
   if(useScanLine){
-    vpImageConvert::convert(faces.getMbScanLineRenderer().getMask(), mask);
+    mask = faces.getMbScanLineRenderer().getMask();
   }
   else{
     unsigned char val = 255/* - i*15*/;
@@ -209,27 +234,50 @@ vpMbKltTracker::reinit(const vpImage<unsigned char>& I)
     }
   }
   
-  tracker.initTracking(cur, mask);
+#if defined(VISP_HAVE_OPENCV)
+  if(m_kltBackend == OPENCV_KLT){
+    vpImageConvert::convert(I, cur);
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+    cv::Mat cvMask;
+    vpImageConvert::convert(mask, cvMask);
+    tracker.initTracking(cur, cvMask);
+#  else
+    IplImage* cvMask = NULL;
+    vpImageConvert::convert(mask, cvMask);
+    tracker.initTracking(cur, cvMask);
+    cvReleaseImage(&cvMask);
+#  endif
+  }
+  else
+#endif
+    m_kltNative.initTracking(I, mask);
 //  tracker.track(cur); // AY: Not sure to be usefull but makes sure that the points are valid for tracking and avoid too fast reinitialisations.
 //  vpCTRACE << "init klt. detected " << tracker.getNbFeatures() << " points" << std::endl;
 
   for(std::list<vpMbtDistanceKltPoints*>::const_iterator it=kltPolygons.begin(); it!=kltPolygons.end(); ++it){
     kltpoly = *it;
     if(kltpoly->polygon->isVisible() && kltpoly->isTracked() && kltpoly->polygon->getNbPoint() > 2){
-      kltpoly->init(tracker);
+#if defined(VISP_HAVE_OPENCV)
+      if(m_kltBackend == OPENCV_KLT)
+        kltpoly->init(tracker);
+      else
+#endif
+        kltpoly->init(m_kltNative);
     }
   }
 
   for(std::list<vpMbtDistanceKltCylinder*>::const_iterator it=kltCylinders.begin(); it!=kltCylinders.end(); ++it){
     kltPolyCylinder = *it;
 
-    if(kltPolyCylinder->isTracked())
-      kltPolyCylinder->init(tracker, cMo);
-  }
-
-#if (VISP_HAVE_OPENCV_VERSION < 0x020408)
-  cvReleaseImage(&mask);
+    if(kltPolyCylinder->isTracked()){
+#if defined(VISP_HAVE_OPENCV)
+      if(m_kltBackend == OPENCV_KLT)
+        kltPolyCylinder->init(tracker, cMo);
+      else
 #endif
+        kltPolyCylinder->init(m_kltNative, cMo);
+    }
+  }
 }
 
 /*!
@@ -241,7 +289,7 @@ vpMbKltTracker::resetTracker()
 {
   cMo.eye();
   
-#if (VISP_HAVE_OPENCV_VERSION < 0x020408)
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION < 0x020408)
   if(cur != NULL){
     cvReleaseImage(&cur);
     cur = NULL;
@@ -284,17 +332,25 @@ vpMbKltTracker::resetTracker()
   compute_interaction = true;
   firstInitialisation = true;
   computeCovariance = false;
+  kltRedetectionCell = 0;
 
+  m_kltNative.setUseHarris(1);
+  
+  m_kltNative.setMaxFeatures(10000);
+  m_kltNative.setWindowSize(5);
+  m_kltNative.setQuality(0.01);
+  m_kltNative.setMinDistance(5);
+  m_kltNative.setHarrisFreeParameter(0.01);
+  m_kltNative.setBlockSize(3);
+  m_kltNative.setPyramidLevels(3);
+#if defined(VISP_HAVE_OPENCV)
   tracker.setTrackerId(1);
   tracker.setUseHarris(1);
-  
-  tracker.setMaxFeatures(10000);
-  tracker.setWindowSize(5);
-  tracker.setQuality(0.01);
-  tracker.setMinDistance(5);
-  tracker.setHarrisFreeParameter(0.01);
-  tracker.setBlockSize(3);
-  tracker.setPyramidLevels(3);
+  copyKltParameters(m_kltNative, tracker);
+  m_kltBackend = OPENCV_KLT;
+#else
+  m_kltBackend = NATIVE_KLT;
+#endif
   
   angleAppears = vpMath::rad(65);
   angleDisappears = vpMath::rad(75);
@@ -311,6 +367,8 @@ vpMbKltTracker::resetTracker()
   faces.reset();
 
   m_optimizationMethod = vpMbTracker::GAUSS_NEWTON_OPT;
+  m_posePrediction = vpMbTracker::NO_PREDICTION;
+  resetPosePrediction();
 
   useScanLine = false;
   
@@ -319,21 +377,64 @@ vpMbKltTracker::resetTracker()
 #endif
 }
 
+#if defined(VISP_HAVE_OPENCV)
+/*!
+  Get the current list of KLT points.
+
+  When the points are tracked with vpKltNative (see setKltBackend()), they
+  are converted into OpenCV points.
+
+  \warning With OpenCV older than 2.4.8, the returned pointer is only valid
+  with the vpKltOpencv backend and NULL with the native one.
+
+  \return the list of KLT points through vpKltOpencv.
+*/
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+std::vector<cv::Point2f>
+vpMbKltTracker::getKltPoints() const
+{
+  if(m_kltBackend == OPENCV_KLT)
+    return tracker.getFeatures();
+
+  std::vector<vpImagePoint> features = m_kltNative.getFeatures();
+  std::vector<cv::Point2f> kltPoints(features.size());
+  for(size_t k = 0; k < features.size(); k++)
+    kltPoints[k] = cv::Point2f((float)features[k].get_u(), (float)features[k].get_v());
+
+  return kltPoints;
+}
+#  else
+CvPoint2D32f*
+vpMbKltTracker::getKltPoints()
+{
+  if(m_kltBackend == OPENCV_KLT)
+    return tracker.getFeatures();
+
+  return NULL;
+}
+#  endif
+#endif
+
 /*!
   Get the current list of KLT points.
   
-  \warning Contrary to getKltPoints which returns a pointer on CvPoint2D32f. This function convert and copy the openCV KLT points into vpImagePoints.
+  \warning Contrary to getKltPoints which returns OpenCV points. This function convert and copy the KLT points into vpImagePoints, whatever the KLT backend is.
   
-  \return the list of KLT points through vpKltOpencv.
+  \return the list of KLT points.
 */
 std::vector<vpImagePoint> 
 vpMbKltTracker::getKltImagePoints() const
 {
   std::vector<vpImagePoint> kltPoints;
-  for (unsigned int i = 0; i < static_cast<unsigned int>(tracker.getNbFeatures()); i ++){
+  for (unsigned int i = 0; i < static_cast<unsigned int>(getNbKltPoints()); i ++){
     int id;
     float x_tmp, y_tmp;
-    tracker.getFeature((int)i, id, x_tmp, y_tmp);
+#if defined(VISP_HAVE_OPENCV)
+    if(m_kltBackend == OPENCV_KLT)
+      tracker.getFeature((int)i, id, x_tmp, y_tmp);
+    else
+#endif
+      m_kltNative.getFeature((int)i, id, x_tmp, y_tmp);
     kltPoints.push_back(vpImagePoint(y_tmp, x_tmp));
   }
   
@@ -343,18 +444,23 @@ vpMbKltTracker::getKltImagePoints() const
 /*!
   Get the current list of KLT points and their id.
   
-  \warning Contrary to getKltPoints which returns a pointer on CvPoint2D32f. This function convert and copy the openCV KLT points into vpImagePoints.
+  \warning Contrary to getKltPoints which returns OpenCV points. This function convert and copy the KLT points into vpImagePoints, whatever the KLT backend is.
   
-  \return the list of KLT points and their id through vpKltOpencv.
+  \return the list of KLT points and their id.
 */
 std::map<int, vpImagePoint> 
 vpMbKltTracker::getKltImagePointsWithId() const
 {
   std::map<int, vpImagePoint> kltPoints;
-  for (unsigned int i = 0; i < static_cast<unsigned int>(tracker.getNbFeatures()); i ++){
+  for (unsigned int i = 0; i < static_cast<unsigned int>(getNbKltPoints()); i ++){
     int id;
     float x_tmp, y_tmp;
-    tracker.getFeature((int)i, id, x_tmp, y_tmp);
+#if defined(VISP_HAVE_OPENCV)
+    if(m_kltBackend == OPENCV_KLT)
+      tracker.getFeature((int)i, id, x_tmp, y_tmp);
+    else
+#endif
+      m_kltNative.getFeature((int)i, id, x_tmp, y_tmp);
     kltPoints[id] = vpImagePoint(y_tmp, x_tmp);
   }
   
@@ -362,19 +468,87 @@ vpMbKltTracker::getKltImagePointsWithId() const
 }
 
 /*!
-  Set the new value of the klt tracker.
+  Set the implementation of the KLT tracker used to detect and track the
+  points. vpKltOpencv is used by default when OpenCV is available, and
+  vpKltNative otherwise. Both implementations share the parameters set with
+  setKltNative(), setKltOpencv() or loadConfigFile().
+
+  \warning This function has to be called before the initialization of the
+  tracker.
+
+  \exception vpException::badValue : If OPENCV_KLT is requested while ViSP
+  is built without OpenCV.
+
+  \param backend : NATIVE_KLT or OPENCV_KLT.
+*/
+void
+vpMbKltTracker::setKltBackend(const vpMbtKltBackend backend)
+{
+#if !defined(VISP_HAVE_OPENCV)
+  if(backend == OPENCV_KLT)
+    throw vpException(vpException::badValue, "The OpenCV KLT tracker is not available without OpenCV");
+#endif
+  m_kltBackend = backend;
+}
+
+/*!
+  Set the new value of the klt tracker. The parameters are used by both KLT
+  backends (see setKltBackend()).
+
+  \param t : Klt tracker containing the new values.
+*/
+void            
+vpMbKltTracker::setKltNative(const vpKltNative& t){
+  copyKltParameters(t, m_kltNative);
+#if defined(VISP_HAVE_OPENCV)
+  copyKltParameters(t, tracker);
+#endif
+}
+
+#if defined(VISP_HAVE_OPENCV)
+/*!
+  Set the new value of the klt tracker. The parameters are used by both KLT
+  backends (see setKltBackend()).
 
   \param t : Klt tracker containing the new values.
 */
 void            
 vpMbKltTracker::setKltOpencv(const vpKltOpencv& t){
-  tracker.setMaxFeatures(t.getMaxFeatures());
-  tracker.setWindowSize(t.getWindowSize());
-  tracker.setQuality(t.getQuality());
-  tracker.setMinDistance(t.getMinDistance());
-  tracker.setHarrisFreeParameter(t.getHarrisFreeParameter());
-  tracker.setBlockSize(t.getBlockSize());
-  tracker.setPyramidLevels(t.getPyramidLevels());
+  copyKltParameters(t, tracker);
+  copyKltParameters(t, m_kltNative);
+}
+#endif
+
+/*!
+  Activate the detection of new KLT points where they were lost. Without it,
+  the points lost during the tracking are only replaced when the tracker is
+  reinitialised, which detects the points again in all the image and makes
+  the tracking of this image much longer than the others.
+
+  When activated, the image is divided in cells after each tracking step. The
+  cells of the tracked faces where less than half of the wanted number of
+  points remain are refilled. The cells are processed in turn until the time
+  budget is spent, and the next tracking step continues with the following
+  cells, so that the cost of the detection is spread over the images.
+
+  \warning Only the planar faces are refilled, not the cylinders. This mode
+  is not available with the vpKltOpencv backend and OpenCV older than 2.4.8.
+
+  \param activate : True to detect new points where they were lost.
+  \param cellSize : Size in pixel of the cells.
+  \param nbPoints : Number of points wanted in a cell.
+  \param timeBudget : Maximal time in ms spent in the detection after each
+  tracking step. At least one cell is processed.
+*/
+void
+vpMbKltTracker::setKltRedetection(const bool activate, const unsigned int cellSize, const unsigned int nbPoints,
+                                  const double timeBudget)
+{
+  kltRedetection = activate;
+  kltRedetectionCellSize = cellSize;
+  kltRedetectionNbPoints = nbPoints;
+  kltRedetectionTimeBudget = timeBudget;
+  kltRedetectionCell = 0;
 }
 
 /*!
@@ -427,26 +601,9 @@ vpMbKltTracker::setPose(const vpImage<unsigned char> &I, const vpHomogeneousMatr
   {
     vpMbtDistanceKltPoints *kltpoly;
 
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
-    std::vector<cv::Point2f> init_pts;
+    std::vector<vpImagePoint> init_pts;
     std::vector<long> init_ids;
-    std::vector<cv::Point2f> guess_pts;
-#else
-    unsigned int nbp = 0;
-    for(std::list<vpMbtDistanceKltPoints*>::const_iterator it=kltPolygons.begin(); it!=kltPolygons.end(); ++it) {
-      kltpoly = *it;
-      if(kltpoly->polygon->isVisible() && kltpoly->polygon->getNbPoint() > 2)
-        nbp += (*it)->getCurrentNumberPoints();
-    }
-
-    CvPoint2D32f* init_pts = NULL;
-    init_pts = (CvPoint2D32f*)cvAlloc(tracker.getMaxFeatures()*sizeof(init_pts[0]));
-    long *init_ids = (long*)cvAlloc((unsigned int)tracker.getMaxFeatures()*sizeof(long));
-    unsigned int iter_pts = 0;
-
-    CvPoint2D32f* guess_pts = NULL;
-    guess_pts = (CvPoint2D32f*)cvAlloc(tracker.getMaxFeatures()*sizeof(guess_pts[0]));
-#endif
+    std::vector<vpImagePoint> guess_pts;
 
     vpHomogeneousMatrix cdMc = cdMo * cMo.inverse();
     vpHomogeneousMatrix cMcd = cdMc.inverse();
@@ -483,21 +640,14 @@ vpMbKltTracker::setPose(const vpImage<unsigned char> &I, const vpHomogeneousMatr
         vpMatrix cdGc = cam.get_K() * cdHc * cam.get_K_inverse();
 
         //Points displacement
-        std::map<int, vpImagePoint>::const_iterator iter = kltpoly->getCurrentPoints().begin();
-        nbCur+= (unsigned int)kltpoly->getCurrentPoints().size();
-        for( ; iter != kltpoly->getCurrentPoints().end(); iter++){
+        nbCur+= kltpoly->getCurrentNumberPoints();
+        for(unsigned int k = 0; k < kltpoly->getCurrentNumberPoints(); k++){
+          vpImagePoint iP = kltpoly->getCurrentPoint(k);
           vpColVector cdp(3);
-          cdp[0] = iter->second.get_j(); cdp[1] = iter->second.get_i(); cdp[2] = 1.0;
+          cdp[0] = iP.get_j(); cdp[1] = iP.get_i(); cdp[2] = 1.0;
 
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
-          cv::Point2f p((float)cdp[0], (float)cdp[1]);
-          init_pts.push_back(p);
-          init_ids.push_back((size_t)(kltpoly->getCurrentPointsInd())[(size_t)iter->first]);
-#else
-          init_pts[iter_pts].x = (float)cdp[0];
-          init_pts[iter_pts].y = (float)cdp[1];
-          init_ids[iter_pts] = (kltpoly->getCurrentPointsInd())[(size_t)iter->first];
-#endif
+          init_pts.push_back(iP);
+          init_ids.push_back(kltpoly->getCurrentPointInd(k));
 
           double p_mu_t_2 = cdp[0] * cdGc[2][0] + cdp[1] * cdGc[2][1] + cdGc[2][2];
 
@@ -511,33 +661,52 @@ vpMbKltTracker::setPose(const vpImage<unsigned char> &I, const vpHomogeneousMatr
           cdp[1] = (cdp[0] * cdGc[1][0] + cdp[1] * cdGc[1][1] + cdGc[1][2]) / p_mu_t_2;
 
           //Set value to the KLT tracker
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
-          cv::Point2f p_guess((float)cdp[0], (float)cdp[1]);
-          guess_pts.push_back(p_guess);
-#else
-          guess_pts[iter_pts].x = (float)cdp[0];
-          guess_pts[iter_pts++].y = (float)cdp[1];
-#endif
+          guess_pts.push_back(vpImagePoint(cdp[1], cdp[0]));
         }
       }
     }
 
-    vpImageConvert::convert(I, cur);
+#if defined(VISP_HAVE_OPENCV)
+    if(m_kltBackend == OPENCV_KLT){
+      vpImageConvert::convert(I, cur);
 
-#if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
-    tracker.setInitialGuess(init_pts, guess_pts, init_ids);
-#else
-    tracker.setInitialGuess(&init_pts, &guess_pts, init_ids, iter_pts);
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+      std::vector<cv::Point2f> cv_init_pts(init_pts.size());
+      std::vector<cv::Point2f> cv_guess_pts(guess_pts.size());
+      for(size_t k = 0; k < init_pts.size(); k++){
+        cv_init_pts[k] = cv::Point2f((float)init_pts[k].get_u(), (float)init_pts[k].get_v());
+        cv_guess_pts[k] = cv::Point2f((float)guess_pts[k].get_u(), (float)guess_pts[k].get_v());
+      }
+      tracker.setInitialGuess(cv_init_pts, cv_guess_pts, init_ids);
+#  else
+      // The arrays are swapped with the ones of the tracker, they have to
+      // hold the maximal number of features
+      int nbp = (int)init_pts.size();
+      CvPoint2D32f* cv_init_pts = (CvPoint2D32f*)cvAlloc(tracker.getMaxFeatures()*sizeof(cv_init_pts[0]));
+      CvPoint2D32f* cv_guess_pts = (CvPoint2D32f*)cvAlloc(tracker.getMaxFeatures()*sizeof(cv_guess_pts[0]));
+      long *cv_init_ids = (long*)cvAlloc((unsigned int)tracker.getMaxFeatures()*sizeof(long));
+      for(int k = 0; k < nbp; k++){
+        cv_init_pts[k].x = (float)init_pts[(size_t)k].get_u();
+        cv_init_pts[k].y = (float)init_pts[(size_t)k].get_v();
+        cv_guess_pts[k].x = (float)guess_pts[(size_t)k].get_u();
+        cv_guess_pts[k].y = (float)guess_pts[(size_t)k].get_v();
+        cv_init_ids[k] = init_ids[(size_t)k];
+      }
+      tracker.setInitialGuess(&cv_init_pts, &cv_guess_pts, cv_init_ids, nbp);
 
-    if(init_pts) cvFree(&init_pts);
-    init_pts = NULL;
+      if(cv_init_pts) cvFree(&cv_init_pts);
+      cv_init_pts = NULL;
 
-    if(guess_pts) cvFree(&guess_pts);
-    guess_pts = NULL;
+      if(cv_guess_pts) cvFree(&cv_guess_pts);
+      cv_guess_pts = NULL;
 
-    if(init_ids)cvFree(&init_ids);
-    init_ids = NULL;
+      if(cv_init_ids)cvFree(&cv_init_ids);
+      cv_init_ids = NULL;
+#  endif
+    }
+    else
 #endif
+      m_kltNative.setInitialGuess(init_pts, guess_pts, init_ids);
 
     bool reInitialisation = false;
     if(!useOgre)
@@ -561,7 +730,12 @@ vpMbKltTracker::setPose(const vpImage<unsigned char> &I, const vpHomogeneousMatr
       kltpoly = *it;
       if(kltpoly->polygon->isVisible() && kltpoly->polygon->getNbPoint() > 2){
         kltpoly->polygon->computePolygonClipped(cam);
-        kltpoly->init(tracker);
+#if defined(VISP_HAVE_OPENCV)
+        if(m_kltBackend == OPENCV_KLT)
+          kltpoly->init(tracker);
+        else
+#endif
+          kltpoly->init(m_kltNative);
       }
     }
 
@@ -602,6 +776,63 @@ vpMbKltTracker::initFaceFromLines(vpMbtPolygon &polygon)
     kltPolygons.push_back(kltPoly);
 }
 
+/*!
+  Take into account a pose predicted before the tracking of a new image: the
+  displacement from the initial position of the features is updated, and the
+  position of the features of the visible faces is predicted with the
+  homography of their plane to initialise the KLT tracking. The features of
+  the cylinders keep their previous position.
+
+  \note The initial guess of the features is not available with the
+  vpKltOpencv backend and OpenCV older than 2.4.8.
+*/
+void
+vpMbKltTracker::predictKltPoints()
+{
+  ctTc0 = cMo * c0Mo.inverse();
+
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION < 0x020408)
+  if(m_kltBackend == OPENCV_KLT)
+    return;
+#endif
+  if(getNbKltPoints() == 0)
+    return;
+
+  std::vector<long> ids;
+  std::vector<vpImagePoint> guess;
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+  std::vector<cv::Point2f> features;
+  if(m_kltBackend == OPENCV_KLT){
+    ids = tracker.getFeaturesId();
+    features = tracker.getFeatures();
+    guess.resize(features.size());
+    for(size_t k = 0; k < features.size(); k++)
+      guess[k].set_uv(features[k].x, features[k].y);
+  }
+  else
+#endif
+  {
+    ids = m_kltNative.getFeaturesId();
+    guess = m_kltNative.getFeatures();
+  }
+
+  for(std::list<vpMbtDistanceKltPoints*>::const_iterator it=kltPolygons.begin(); it!=kltPolygons.end(); ++it){
+    vpMbtDistanceKltPoints *kltpoly = *it;
+    if(kltpoly->polygon->isVisible() && kltpoly->isTracked() && kltpoly->polygon->getNbPoint() > 2)
+      kltpoly->predictPoints(ctTc0, ids, guess);
+  }
+
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+  if(m_kltBackend == OPENCV_KLT){
+    for(size_t k = 0; k < features.size(); k++)
+      features[k] = cv::Point2f((float)guess[k].get_u(), (float)guess[k].get_v());
+    tracker.setInitialGuess(features);
+  }
+  else
+#endif
+    m_kltNative.setInitialGuess(guess);
+}
+
 /*!
   Achieve the tracking of the KLT features and associate the features to the faces.
 
@@ -612,8 +843,14 @@ vpMbKltTracker::initFaceFromLines(vpMbtPolygon &polygon)
 void
 vpMbKltTracker::preTracking(const vpImage<unsigned char>& I, unsigned int &nbInfos, unsigned int &nbFaceUsed)
 {
-  vpImageConvert::convert(I, cur);
-  tracker.track(cur);
+#if defined(VISP_HAVE_OPENCV)
+  if(m_kltBackend == OPENCV_KLT){
+    vpImageConvert::convert(I, cur);
+    tracker.track(cur);
+  }
+  else
+#endif
+    m_kltNative.track(I);
   
   nbInfos = 0;
   nbFaceUsed = 0;
@@ -622,7 +859,12 @@ vpMbKltTracker::preTracking(const vpImage<unsigned char>& I, unsigned int &nbInf
   for(std::list<vpMbtDistanceKltPoints*>::const_iterator it=kltPolygons.begin(); it!=kltPolygons.end(); ++it){
     kltpoly = *it;
     if(kltpoly->polygon->isVisible() && kltpoly->isTracked() && kltpoly->polygon->getNbPoint() > 2){
-      kltpoly->computeNbDetectedCurrent(tracker);
+#if defined(VISP_HAVE_OPENCV)
+      if(m_kltBackend == OPENCV_KLT)
+        kltpoly->computeNbDetectedCurrent(tracker);
+      else
+#endif
+        kltpoly->computeNbDetectedCurrent(m_kltNative);
 //       faces[i]->ransac();
       if(kltpoly->hasEnoughPoints()){
         nbInfos += kltpoly->getCurrentNumberPoints();
@@ -637,7 +879,12 @@ vpMbKltTracker::preTracking(const vpImage<unsigned char>& I, unsigned int &nbInf
 
     if(kltPolyCylinder->isTracked())
     {
-      kltPolyCylinder->computeNbDetectedCurrent(tracker);
+#if defined(VISP_HAVE_OPENCV)
+      if(m_kltBackend == OPENCV_KLT)
+        kltPolyCylinder->computeNbDetectedCurrent(tracker);
+      else
+#endif
+        kltPolyCylinder->computeNbDetectedCurrent(m_kltNative);
       if(kltPolyCylinder->hasEnoughPoints()){
         nbInfos += kltPolyCylinder->getCurrentNumberPoints();
         nbFaceUsed++;
@@ -721,6 +968,151 @@ vpMbKltTracker::postTracking(const vpImage<unsigned char>& I, vpColVector &w)
   return false;
 }
 
+/*!
+  Detect new KLT points in the cells of the tracked faces where points were
+  lost (see setKltRedetection()). The new points are added to the KLT tracker
+  and to the face that contains them.
+
+  \param I : The current image.
+*/
+void
+vpMbKltTracker::redetectKltPoints(const vpImage<unsigned char>& I)
+{
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION < 0x020408)
+  if(m_kltBackend == OPENCV_KLT)
+    return;
+#endif
+  if(!kltRedetection || kltRedetectionCellSize == 0 || kltRedetectionNbPoints == 0)
+    return;
+
+  const double t0 = vpTime::measureTimeMs();
+  const int width = (int)I.getWidth();
+  const int height = (int)I.getHeight();
+  const int cellSize = (int)kltRedetectionCellSize;
+  const unsigned int gridWidth = (I.getWidth() + kltRedetectionCellSize - 1) / kltRedetectionCellSize;
+  const unsigned int nbCells = gridWidth * ((I.getHeight() + kltRedetectionCellSize - 1) / kltRedetectionCellSize);
+  if(nbCells == 0)
+    return;
+
+  // Faces that can receive new points and their bounding box
+  std::vector<vpMbtDistanceKltPoints*> kltFaces;
+  std::vector<std::vector<vpImagePoint> > rois;
+  std::vector<int> boxes;
+  for(std::list<vpMbtDistanceKltPoints*>::const_iterator it=kltPolygons.begin(); it!=kltPolygons.end(); ++it){
+    vpMbtDistanceKltPoints *kltpoly = *it;
+    if(kltpoly->polygon->isVisible() && kltpoly->isTracked() && kltpoly->polygon->getNbPoint() > 2){
+      kltpoly->polygon->changeFrame(cMo);
+      kltpoly->polygon->computePolygonClipped(cam);
+      std::vector<vpImagePoint> roi;
+      kltpoly->polygon->getRoiClipped(cam, roi);
+      if(roi.size() < 3)
+        continue;
+
+      int i_min, i_max, j_min, j_max;
+      vpPolygon3D::getMinMaxRoi(roi, i_min, i_max, j_min, j_max);
+      kltFaces.push_back(kltpoly);
+      rois.push_back(roi);
+      boxes.push_back(i_min);
+      boxes.push_back(i_max);
+      boxes.push_back(j_min);
+      boxes.push_back(j_max);
+    }
+  }
+  if(kltFaces.empty())
+    return;
+
+  // Number of points in each cell
+  std::vector<unsigned int> counts(nbCells, 0);
+  std::vector<vpImagePoint> points = getKltImagePoints();
+  for (size_t k = 0; k < points.size(); k++){
+    const double x = points[k].get_u();
+    const double y = points[k].get_v();
+    if(x >= 0 && y >= 0 && x < width && y < height)
+      counts[((unsigned int)y / kltRedetectionCellSize) * gridWidth + (unsigned int)x / kltRedetectionCellSize]++;
+  }
+
+  const vpHomogeneousMatrix cTc0 = cMo * c0Mo.inverse();
+  const double border = (double)maskBorder;
+  const double shifts[5][2] = { {0, 0}, {border, border}, {-border, border}, {border, -border}, {-border, -border} };
+  bool scanLineRendered = false;
+
+  unsigned int cell = kltRedetectionCell % nbCells;
+  for(unsigned int n = 0; n < nbCells; n++, cell = (cell + 1) % nbCells){
+    if(n > 0 && vpTime::measureTimeMs() - t0 > kltRedetectionTimeBudget)
+      break;
+    if(2 * counts[cell] >= kltRedetectionNbPoints)
+      continue;
+
+    const int top = (int)(cell / gridWidth) * cellSize;
+    const int left = (int)(cell % gridWidth) * cellSize;
+    const int bottom = (std::min)(top + cellSize, height);
+    const int right = (std::min)(left + cellSize, width);
+    bool overlap = false;
+    for(size_t f = 0; f < kltFaces.size() && !overlap; f++)
+      overlap = boxes[4*f] < bottom && boxes[4*f+1] >= top && boxes[4*f+2] < right && boxes[4*f+3] >= left;
+    if(!overlap)
+      continue;
+
+    if(useScanLine && !scanLineRendered){
+      faces.computeClippedPolygons(cMo, cam);
+      faces.computeScanLineRender(cam, I.getWidth(), I.getHeight());
+      scanLineRendered = true;
+    }
+
+    std::vector<vpImagePoint> detected;
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+    if(m_kltBackend == OPENCV_KLT){
+      std::vector<cv::Point2f> features;
+      tracker.detectNewFeatures(cv::Rect(left, top, right - left, bottom - top),
+                                (int)(kltRedetectionNbPoints - counts[cell]), features);
+      detected.resize(features.size());
+      for(size_t k = 0; k < features.size(); k++)
+        detected[k].set_uv(features[k].x, features[k].y);
+    }
+    else
+#endif
+      m_kltNative.detectNewFeatures(vpRect(left, top, right - left, bottom - top),
+                                    (int)(kltRedetectionNbPoints - counts[cell]), detected);
+
+    for(size_t k = 0; k < detected.size(); k++){
+      for(size_t f = 0; f < kltFaces.size(); f++){
+        bool inside = true;
+        for(unsigned int s = 0; s < 5 && inside; s++){
+          const double i = detected[k].get_i() + shifts[s][0];
+          const double j = detected[k].get_j() + shifts[s][1];
+          if(useScanLine)
+            inside = i >= 0 && j >= 0 && i < height && j < width &&
+                faces.getMbScanLineRenderer().getPrimitiveIDs()[(unsigned int)i][(unsigned int)j] == kltFaces[f]->polygon->getIndex();
+          else
+            inside = vpPolygon::isInside(rois[f], i, j);
+        }
+        if(!inside)
+          continue;
+
+        int id;
+        float x, y;
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+        if(m_kltBackend == OPENCV_KLT){
+          tracker.addFeature((float)detected[k].get_u(), (float)detected[k].get_v());
+          tracker.getFeature(tracker.getNbFeatures() - 1, id, x, y);
+          if(!kltFaces[f]->addPoint(id, detected[k], cTc0))
+            tracker.suppressFeature(tracker.getNbFeatures() - 1);
+        }
+        else
+#endif
+        {
+          m_kltNative.addFeature((float)detected[k].get_u(), (float)detected[k].get_v());
+          m_kltNative.getFeature(m_kltNative.getNbFeatures() - 1, id, x, y);
+          if(!kltFaces[f]->addPoint(id, detected[k], cTc0))
+            m_kltNative.suppressFeature(m_kltNative.getNbFeatures() - 1);
+        }
+        break;
+      }
+    }
+  }
+  kltRedetectionCell = cell;
+}
+
 /*!
   Realize the VVS loop for the tracking
 
@@ -733,74 +1125,46 @@ vpMbKltTracker::computeVVS(const unsigned int &nbInfos, vpColVector &w)
   vpMatrix L;     // interaction matrix
   vpColVector R;  // residu
   vpMatrix L_true;     // interaction matrix
-  vpMatrix LVJ_true;
-  //vpColVector R_true;  // residu
-  vpColVector v;  // "speed" for VVS
   vpHomography H;
-  vpColVector w_true;
   vpRobust robust(2*nbInfos);
 
-  vpMatrix LTL;
-  vpColVector LTR;
   vpHomogeneousMatrix cMoPrev;
   vpHomogeneousMatrix ctTc0_Prev;
-  vpColVector error_prev(2*nbInfos);
-  double mu = 0.01;
-  
-  double normRes = 0;
-  double normRes_1 = -1;
-  unsigned int iter = 0;
 
   R.resize(2*nbInfos);
   L.resize(2*nbInfos, 6, 0);
 
-  while( ((int)((normRes - normRes_1)*1e8) != 0 )  && (iter<maxIter) ){
+  vpMbtVVSSolver solver(m_optimizationMethod, lambda, maxIter);
+  solver.setStopCriteria(m_stopCriteriaResidual, m_stopCriteriaIncrement);
+
+  while(! solver.hasConverged()){
     
     unsigned int shift = 0;
 
     computeVVSInteractionMatrixAndResidu(shift, R, L, H, kltPolygons, kltCylinders, ctTc0);
+    m_error = R;
 
-    bool reStartFromLastIncrement = false;
-
-    computeVVSCheckLevenbergMarquardtKlt(iter, nbInfos, cMoPrev, error_prev, ctTc0_Prev, mu, reStartFromLastIncrement);
-
-    if(!reStartFromLastIncrement){
-      computeVVSWeights(iter, nbInfos, R, w_true, w, robust);
+    if(solver.rejectIncrement(m_error, w)){
+      cMo = cMoPrev;
+      ctTc0 = ctTc0_Prev;
+    }
+    else{
+      computeVVSWeights(solver.getIteration(), nbInfos, R, w, robust);
 
-      computeVVSPoseEstimation(iter, L, w, L_true, LVJ_true, normRes, normRes_1, w_true, R, LTL, LTR,
-          error_prev, v, mu, cMoPrev, ctTc0_Prev);
-    } // endif(!reStartFromLastIncrement)
+      computeVVSPoseEstimation(solver, L, w, L_true, cMoPrev, ctTc0_Prev);
+    }
     
-    iter++;
+    solver.nextIteration();
   }
   
   if(computeCovariance){
-    computeVVSCovariance(w_true, cMoPrev, L_true, LVJ_true);
-  }
-}
-
-void
-vpMbKltTracker::computeVVSCheckLevenbergMarquardtKlt(const unsigned int iter, const unsigned int nbInfos,
-    const vpHomogeneousMatrix &cMoPrev, const vpColVector &error_prev, const vpHomogeneousMatrix &ctTc0_Prev,
-    double &mu, bool &reStartFromLastIncrement) {
-  if(iter != 0 && m_optimizationMethod == vpMbTracker::LEVENBERG_MARQUARDT_OPT){
-    if(m_error.sumSquare()/(double)(2*nbInfos) > error_prev.sumSquare()/(double)(2*nbInfos)){
-      mu *= 10.0;
-
-      if(mu > 1.0)
-        throw vpTrackingException(vpTrackingException::fatalError, "Optimization diverged");
-
-      cMo = cMoPrev;
-      m_error = error_prev;
-      ctTc0 = ctTc0_Prev;
-      reStartFromLastIncrement = true;
-    }
+    computeVVSCovariance(solver.getWeights(), cMoPrev, L_true);
   }
 }
 
 void
 vpMbKltTracker::computeVVSCovariance(const vpColVector &w_true, const vpHomogeneousMatrix &cMoPrev,
-    const vpMatrix &L_true, const vpMatrix &LVJ_true) {
+    const vpMatrix &L_true) {
   if(computeCovariance){
     vpMatrix D;
     D.diag(w_true);
@@ -810,6 +1174,9 @@ vpMbKltTracker::computeVVSCovariance(const vpColVector &w_true, const vpHomogene
         covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,L_true,D);
     }
     else{
+        vpVelocityTwistMatrix cVo;
+        cVo.buildFrom(cMoPrev);
+        vpMatrix LVJ_true = (L_true*cVo*oJo);
         covarianceMatrix = vpMatrix::computeCovarianceMatrixVVS(cMoPrev,m_error,LVJ_true,D);
     }
   }
@@ -858,91 +1225,15 @@ vpMbKltTracker::computeVVSInteractionMatrixAndResidu(unsigned int shift, vpColVe
 }
 
 void
-vpMbKltTracker::computeVVSPoseEstimation(const unsigned int iter, vpMatrix &L,
-    const vpColVector &w, vpMatrix &L_true, vpMatrix &LVJ_true, double &normRes, double &normRes_1, vpColVector &w_true,
-    vpColVector &R, vpMatrix &LTL, vpColVector &LTR, vpColVector &error_prev, vpColVector &v, double &mu,
-    vpHomogeneousMatrix &cMoPrev, vpHomogeneousMatrix &ctTc0_Prev) {
-  m_error = R;
-  if(computeCovariance){
+vpMbKltTracker::computeVVSPoseEstimation(vpMbtVVSSolver &solver, const vpMatrix &L, const vpColVector &w,
+    vpMatrix &L_true, vpHomogeneousMatrix &cMoPrev, vpHomogeneousMatrix &ctTc0_Prev) {
+  if(computeCovariance)
     L_true = L;
-    if(!isoJoIdentity){
-       vpVelocityTwistMatrix cVo;
-       cVo.buildFrom(cMo);
-       LVJ_true = (L*cVo*oJo);
-    }
-  }
-
-  normRes_1 = normRes;
-  normRes = 0;
-  for (unsigned int i = 0; i < static_cast<unsigned int>(R.getRows()); i += 1){
-    w_true[i] = w[i];
-    R[i] = R[i] * w[i];
-    normRes += R[i];
-  }
-
-  if((iter == 0) || compute_interaction){
-    for(unsigned int i=0; i<static_cast<unsigned int>(R.getRows()); i++){
-      for(unsigned int j=0; j<6; j++){
-        L[i][j] *= w[i];
-      }
-    }
-  }
-
-  if(isoJoIdentity){
-      LTL = L.AtA();
-      computeJTR(L, R, LTR);
-
-      switch(m_optimizationMethod){
-      case vpMbTracker::LEVENBERG_MARQUARDT_OPT:
-      {
-        vpMatrix LMA(LTL.getRows(), LTL.getCols());
-        LMA.eye();
-        vpMatrix LTLmuI = LTL + (LMA*mu);
-        v = -lambda*LTLmuI.pseudoInverse(LTLmuI.getRows()*std::numeric_limits<double>::epsilon())*LTR;
-
-        if(iter != 0)
-          mu /= 10.0;
-
-        error_prev = m_error;
-        break;
-      }
-      case vpMbTracker::GAUSS_NEWTON_OPT:
-      default:
-        v = -lambda * LTL.pseudoInverse(LTL.getRows()*std::numeric_limits<double>::epsilon()) * LTR;
-      }
-  }
-  else{
-      vpVelocityTwistMatrix cVo;
-      cVo.buildFrom(cMo);
-      vpMatrix LVJ = (L*cVo*oJo);
-      vpMatrix LVJTLVJ = (LVJ).AtA();
-      vpColVector LVJTR;
-      computeJTR(LVJ, R, LVJTR);
-
-      switch(m_optimizationMethod){
-      case vpMbTracker::LEVENBERG_MARQUARDT_OPT:
-      {
-        vpMatrix LMA(LVJTLVJ.getRows(), LVJTLVJ.getCols());
-        LMA.eye();
-        vpMatrix LTLmuI = LVJTLVJ + (LMA*mu);
-        v = -lambda*LTLmuI.pseudoInverse(LTLmuI.getRows()*std::numeric_limits<double>::epsilon())*LVJTR;
-        v = cVo * v;
 
-        if(iter != 0)
-          mu /= 10.0;
+  solver.computeIncrement(L, m_error, w, NULL, (solver.getIteration() == 0) || compute_interaction);
 
-        error_prev = m_error;
-        break;
-      }
-      case vpMbTracker::GAUSS_NEWTON_OPT:
-      default:
-      {
-        v = -lambda*LVJTLVJ.pseudoInverse(LVJTLVJ.getRows()*std::numeric_limits<double>::epsilon())*LVJTR;
-        v = cVo * v;
-        break;
-      }
-      }
-  }
+  vpColVector v;  // "speed" for VVS
+  solver.getIncrement(cMo, isoJoIdentity, oJo, v);
 
   cMoPrev = cMo;
   ctTc0_Prev = ctTc0;
@@ -952,12 +1243,10 @@ vpMbKltTracker::computeVVSPoseEstimation(const unsigned int iter, vpMatrix &L,
 
 void
 vpMbKltTracker::computeVVSWeights(const unsigned int iter, const unsigned int nbInfos, const vpColVector &R,
-    vpColVector &w_true, vpColVector &w, vpRobust &robust) {
+    vpColVector &w, vpRobust &robust) {
   if(iter == 0){
-    w_true.resize(2*nbInfos);
     w.resize(2*nbInfos);
     w = 1;
-    w_true = 1;
   }
   robust.setIteration(iter);
   robust.setThreshold(2/cam.get_px());
@@ -977,6 +1266,9 @@ vpMbKltTracker::track(const vpImage<unsigned char>& I)
   unsigned int nbInfos = 0;
   unsigned int nbFaceUsed = 0;
 
+  if(predictPose())
+    predictKltPoints();
+
   try{
     preTracking(I, nbInfos, nbFaceUsed);
   }
@@ -994,6 +1286,11 @@ vpMbKltTracker::track(const vpImage<unsigned char>& I)
 
   if(postTracking(I, m_w))
     reinit(I);
+  else
+    redetectKltPoints(I);
+
+  updatePosePrediction();
+  recordKeyFrame(I);
 }
 
 /*!
@@ -1089,13 +1386,15 @@ vpMbKltTracker::loadConfigFile(const char* configFile)
   xmlp.getCameraParameters(camera);
   setCameraParameters(camera);
   
-  tracker.setMaxFeatures((int)xmlp.getMaxFeatures());
-  tracker.setWindowSize((int)xmlp.getWindowSize());
-  tracker.setQuality(xmlp.getQuality());
-  tracker.setMinDistance(xmlp.getMinDistance());
-  tracker.setHarrisFreeParameter(xmlp.getHarrisParam());
-  tracker.setBlockSize((int)xmlp.getBlockSize());
-  tracker.setPyramidLevels((int)xmlp.getPyramidLevels());
+  vpKltNative klt;
+  klt.setMaxFeatures((int)xmlp.getMaxFeatures());
+  klt.setWindowSize((int)xmlp.getWindowSize());
+  klt.setQuality(xmlp.getQuality());
+  klt.setMinDistance(xmlp.getMinDistance());
+  klt.setHarrisFreeParameter(xmlp.getHarrisParam());
+  klt.setBlockSize((int)xmlp.getBlockSize());
+  klt.setPyramidLevels((int)xmlp.getPyramidLevels());
+  vpMbKltTracker::setKltNative(klt);
   maskBorder = xmlp.getMaskBorder();
   angleAppears = vpMath::rad(xmlp.getAngleAppear());
   angleDisappears = vpMath::rad(xmlp.getAngleDisappear());
@@ -1401,7 +1700,7 @@ vpMbKltTracker::reInitModel(const vpImage<unsigned char>& I, const char* cad_nam
 {
   this->cMo.eye();
 
-#if (VISP_HAVE_OPENCV_VERSION < 0x020408)
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION < 0x020408)
   if(cur != NULL){
     cvReleaseImage(&cur);
     cur = NULL;
@@ -1470,4 +1769,4 @@ vpMbKltTracker::setUseKltTracking(const std::string &name, const bool &useKltTra
 #elif !defined(VISP_BUILD_SHARED_LIBS)
 // Work arround to avoid warning: libvisp_mbt.a(vpMbKltTracker.cpp.o) has no symbols
 void dummy_vpMbKltTracker() {};
-#endif //VISP_HAVE_OPENCV
+#endif //VISP_HAVE_MODULE_KLT
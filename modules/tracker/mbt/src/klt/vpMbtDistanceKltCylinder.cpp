@@ -40,7 +40,7 @@
 #include <visp3/core/vpPolygon.h>
 
 
-#if defined(VISP_HAVE_MODULE_KLT) && (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 /*!
   Basic constructor.
@@ -96,11 +96,12 @@ vpMbtDistanceKltCylinder::buildFrom(const vpPoint &p1, const vpPoint &p2, const
   map detected in the image, are parsed in order to extract the id of the points
   that are indeed in the face.
 
-  \param _tracker : ViSP OpenCV KLT Tracker.
+  \param _tracker : KLT tracker, vpKltNative or vpKltOpencv.
   \param cMo : Pose of the object in the camera frame at initialization.
 */
+template <class KltTracker>
 void
-vpMbtDistanceKltCylinder::init(const vpKltOpencv& _tracker, const vpHomogeneousMatrix &cMo)
+vpMbtDistanceKltCylinder::initFrom(const KltTracker& _tracker, const vpHomogeneousMatrix &cMo)
 {
   c0Mo = cMo;
   cylinder.changeFrame(cMo);
@@ -175,15 +176,42 @@ vpMbtDistanceKltCylinder::init(const vpKltOpencv& _tracker, const vpHomogeneousM
   //std::cout << "Nb detected points in cylinder : " << nbPointsCur << std::endl;
 }
 
+/*!
+  Initialise the cylinder to track from the points detected by vpKltNative.
+
+  \param _tracker : ViSP KLT Tracker.
+  \param cMo : Pose of the object in the camera frame at initialization.
+*/
+void
+vpMbtDistanceKltCylinder::init(const vpKltNative& _tracker, const vpHomogeneousMatrix &cMo)
+{
+  initFrom(_tracker, cMo);
+}
+
+#if defined(VISP_HAVE_OPENCV)
+/*!
+  Initialise the cylinder to track from the points detected by vpKltOpencv.
+
+  \param _tracker : ViSP OpenCV KLT Tracker.
+  \param cMo : Pose of the object in the camera frame at initialization.
+*/
+void
+vpMbtDistanceKltCylinder::init(const vpKltOpencv& _tracker, const vpHomogeneousMatrix &cMo)
+{
+  initFrom(_tracker, cMo);
+}
+#endif
+
 /*!
   compute the number of point in this instanciation of the tracker that corresponds
   to the points of the cylinder
 
-  \param _tracker : the KLT tracker
+  \param _tracker : the KLT tracker, vpKltNative or vpKltOpencv
   \return the number of points that are tracked in this face and in this instanciation of the tracker
 */
+template <class KltTracker>
 unsigned int
-vpMbtDistanceKltCylinder::computeNbDetectedCurrent(const vpKltOpencv& _tracker)
+vpMbtDistanceKltCylinder::computeNbDetectedCurrentFrom(const KltTracker& _tracker)
 {
   int id;
   float x, y;
@@ -206,6 +234,34 @@ vpMbtDistanceKltCylinder::computeNbDetectedCurrent(const vpKltOpencv& _tracker)
   return nbPointsCur;
 }
 
+/*!
+  compute the number of point tracked by vpKltNative that corresponds to the
+  points of the cylinder
+
+  \param _tracker : the KLT tracker
+  \return the number of points that are tracked in this face and in this instanciation of the tracker
+*/
+unsigned int
+vpMbtDistanceKltCylinder::computeNbDetectedCurrent(const vpKltNative& _tracker)
+{
+  return computeNbDetectedCurrentFrom(_tracker);
+}
+
+#if defined(VISP_HAVE_OPENCV)
+/*!
+  compute the number of point tracked by vpKltOpencv that corresponds to the
+  points of the cylinder
+
+  \param _tracker : the KLT tracker
+  \return the number of points that are tracked in this face and in this instanciation of the tracker
+*/
+unsigned int
+vpMbtDistanceKltCylinder::computeNbDetectedCurrent(const vpKltOpencv& _tracker)
+{
+  return computeNbDetectedCurrentFrom(_tracker);
+}
+#endif
+
 /*!
   This method removes the outliers. A point is considered as outlier when its
   associated weight is below a given threshold (threshold_outlier).
@@ -347,6 +403,70 @@ vpMbtDistanceKltCylinder::isTrackedFeature(const int _id)
   return false;
 }
 
+/*!
+  Modification of all the pixels that are in the roi to the value of _nb (
+  default is 255).
+
+  \param mask : the mask to update (0, not in the object, _nb otherwise).
+  \param nb : Optionnal value to set to the pixels included in the face.
+  \param shiftBorder : Optionnal shift for the border in pixel (sort of built-in erosion) to avoid to consider pixels near the limits of the face.
+*/
+void
+vpMbtDistanceKltCylinder::updateMask(vpImage<unsigned char> &mask, unsigned char nb, unsigned int shiftBorder)
+{
+  int width  = (int)mask.getWidth();
+  int height = (int)mask.getHeight();
+
+  for(unsigned int kc = 0 ; kc < listIndicesCylinderBBox.size() ; kc++)
+  {
+      if((*hiddenface)[(unsigned int) listIndicesCylinderBBox[kc]]->isVisible() &&
+          (*hiddenface)[(unsigned int) listIndicesCylinderBBox[kc]]->getNbPoint() > 2)
+      {
+          int i_min, i_max, j_min, j_max;
+          std::vector<vpImagePoint> roi;
+          (*hiddenface)[(unsigned int) listIndicesCylinderBBox[kc]]->getRoiClipped(cam, roi);
+          vpPolygon3D::getMinMaxRoi(roi, i_min, i_max, j_min,j_max);
+
+          /* check image boundaries */
+          if(i_min > height || i_min < 0){ //underflow
+            i_min = 0;
+          }
+          if(i_max > height){
+            i_max = height;
+          }
+          if(j_min > width || j_min < 0){ //underflow
+            j_min = 0;
+          }
+          if(j_max > width){
+            j_max = width;
+          }
+
+          double shiftBorder_d = (double) shiftBorder;
+          for(int i=i_min; i< i_max; i++){
+            double i_d = (double) i;
+            for(int j=j_min; j< j_max; j++){
+              double j_d = (double) j;
+              if(shiftBorder != 0){
+                if( vpPolygon::isInside(roi, i_d, j_d)
+                    && vpPolygon::isInside(roi, i_d+shiftBorder_d, j_d+shiftBorder_d)
+                    && vpPolygon::isInside(roi, i_d-shiftBorder_d, j_d+shiftBorder_d)
+                    && vpPolygon::isInside(roi, i_d+shiftBorder_d, j_d-shiftBorder_d)
+                    && vpPolygon::isInside(roi, i_d-shiftBorder_d, j_d-shiftBorder_d) ){
+                  mask[(unsigned int)i][(unsigned int)j] = nb;
+                }
+              }
+              else{
+                if(vpPolygon::isInside(roi, i, j)){
+                  mask[(unsigned int)i][(unsigned int)j] = nb;
+                }
+              }
+            }
+          }
+    }
+  }
+}
+
+#if defined(VISP_HAVE_OPENCV)
 /*!
   Modification of all the pixels that are in the roi to the value of _nb (
   default is 255).
@@ -383,13 +503,13 @@ vpMbtDistanceKltCylinder::updateMask(
           vpPolygon3D::getMinMaxRoi(roi, i_min, i_max, j_min,j_max);
 
           /* check image boundaries */
-          if(i_min > height){ //underflow
+          if(i_min > height || i_min < 0){ //underflow
             i_min = 0;
           }
           if(i_max > height){
             i_max = height;
           }
-          if(j_min > width){ //underflow
+          if(j_min > width || j_min < 0){ //underflow
             j_min = 0;
           }
           if(j_max > width){
@@ -451,6 +571,7 @@ vpMbtDistanceKltCylinder::updateMask(
     }
   }
 }
+#endif
 
 /*!
   Display the primitives tracked for the cylinder.
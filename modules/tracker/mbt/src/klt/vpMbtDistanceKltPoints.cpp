@@ -38,21 +38,22 @@
 
 #include <visp3/mbt/vpMbtDistanceKltPoints.h>
 #include <visp3/core/vpPolygon.h>
+#include <visp3/core/vpMeterPixelConversion.h>
 
-#if defined(VISP_HAVE_MODULE_KLT) && (defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+#include <limits>
+
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
 
 /*!
   Basic constructor.
 
 */
 vpMbtDistanceKltPoints::vpMbtDistanceKltPoints()
-  : H(), N(), N_cur(), invd0(1.), cRc0_0n(), initPoints(), curPoints(), curPointsInd(),
+  : H(), N(), N_cur(), invd0(1.), cRc0_0n(), initIds(), initI(), initJ(), initX(), initY(),
+    idOffset(0), idToSlot(), curSlots(), curInd(), curI(), curJ(), curX(), curY(),
     nbPointsCur(0), nbPointsInit(0), minNbPoint(4), enoughPoints(false), dt(1.), d0(1.),
     cam(), isTrackedKltPoints(true), polygon(NULL), hiddenface(NULL), useScanLine(false)
 {
-  initPoints = std::map<int, vpImagePoint>();
-  curPoints = std::map<int, vpImagePoint>();
-  curPointsInd = std::map<int, int>();
 }
 
 /*!
@@ -67,20 +68,28 @@ vpMbtDistanceKltPoints::~vpMbtDistanceKltPoints()
   map detected in the image, are parsed in order to extract the id of the points
   that are indeed in the face.
 
-  \param _tracker : ViSP OpenCV KLT Tracker.
+  \param _tracker : KLT tracker, vpKltNative or vpKltOpencv.
 */
+template <class KltTracker>
 void
-vpMbtDistanceKltPoints::init(const vpKltOpencv& _tracker)
+vpMbtDistanceKltPoints::initFrom(const KltTracker& _tracker)
 {
   // extract ids of the points in the face
   nbPointsInit = 0;
   nbPointsCur = 0;
-  initPoints = std::map<int, vpImagePoint>();
-  curPoints = std::map<int, vpImagePoint>();
-  curPointsInd = std::map<int, int>();
+  initIds.clear();
+  initI.clear();
+  initJ.clear();
+  curSlots.clear();
+  curInd.clear();
+  curI.clear();
+  curJ.clear();
   std::vector<vpImagePoint> roi;
   polygon->getRoiClipped(cam, roi);
 
+  int idMin = (std::numeric_limits<int>::max)();
+  int idMax = (std::numeric_limits<int>::min)();
+
   for (unsigned int i = 0; i < static_cast<unsigned int>(_tracker.getNbFeatures()); i ++){
     int id;
     float x_tmp, y_tmp;
@@ -101,14 +110,37 @@ vpMbtDistanceKltPoints::init(const vpKltOpencv& _tracker)
     }
 
     if(add){
-      initPoints[id] = vpImagePoint(y_tmp, x_tmp);
-      curPoints[id] = vpImagePoint(y_tmp, x_tmp);
-      curPointsInd[id] = (int)i;
+      initIds.push_back(id);
+      initI.push_back(y_tmp);
+      initJ.push_back(x_tmp);
+      curSlots.push_back(nbPointsInit);
+      curInd.push_back((int)i);
+      curI.push_back(y_tmp);
+      curJ.push_back(x_tmp);
+      if(id < idMin) idMin = id;
+      if(id > idMax) idMax = id;
       nbPointsInit++;
       nbPointsCur++;
     }
   }
 
+  // dense table to find the slot of a point from its id
+  idToSlot.clear();
+  idOffset = 0;
+  if(nbPointsInit != 0){
+    idOffset = idMin;
+    idToSlot.resize((size_t)(idMax - idMin) + 1, -1);
+    for(unsigned int k = 0; k < nbPointsInit; k++)
+      idToSlot[(size_t)(initIds[k] - idOffset)] = (int)k;
+  }
+
+  initX.resize(nbPointsInit);
+  initY.resize(nbPointsInit);
+  for(unsigned int k = 0; k < nbPointsInit; k++)
+    vpPixelMeterConversion::convertPoint(cam, initJ[k], initI[k], initX[k], initY[k]);
+  curX = initX;
+  curY = initY;
+
   if(nbPointsCur >= minNbPoint) enoughPoints = true;
   else enoughPoints = false;
 
@@ -123,27 +155,63 @@ vpMbtDistanceKltPoints::init(const vpKltOpencv& _tracker)
   invd0 = 1.0 / d0;
 }
 
+/*!
+  Initialise the face to track from the points detected by vpKltNative.
+
+  \param _tracker : ViSP KLT Tracker.
+*/
+void
+vpMbtDistanceKltPoints::init(const vpKltNative& _tracker)
+{
+  initFrom(_tracker);
+}
+
+#if defined(VISP_HAVE_OPENCV)
+/*!
+  Initialise the face to track from the points detected by vpKltOpencv.
+
+  \param _tracker : ViSP OpenCV KLT Tracker.
+*/
+void
+vpMbtDistanceKltPoints::init(const vpKltOpencv& _tracker)
+{
+  initFrom(_tracker);
+}
+#endif
+
 /*!
   compute the number of point in this instanciation of the tracker that corresponds
   to the points of the face
 
-  \param _tracker : the KLT tracker
+  \param _tracker : the KLT tracker, vpKltNative or vpKltOpencv
   \return the number of points that are tracked in this face and in this instanciation of the tracker
 */
+template <class KltTracker>
 unsigned int
-vpMbtDistanceKltPoints::computeNbDetectedCurrent(const vpKltOpencv& _tracker)
+vpMbtDistanceKltPoints::computeNbDetectedCurrentFrom(const KltTracker& _tracker)
 {
   int id;
   float x, y;
   nbPointsCur = 0;
-  curPoints = std::map<int, vpImagePoint>();
-  curPointsInd = std::map<int, int>();
+  curSlots.clear();
+  curInd.clear();
+  curI.clear();
+  curJ.clear();
+  curX.clear();
+  curY.clear();
 
   for (unsigned int i = 0; i < static_cast<unsigned int>(_tracker.getNbFeatures()); i++){
     _tracker.getFeature((int)i, id, x, y);
-    if(isTrackedFeature(id)){
-      curPoints[id] = vpImagePoint(static_cast<double>(y),static_cast<double>(x));
-      curPointsInd[id] = (int)i;
+    int slot = getSlot(id);
+    if(slot >= 0){
+      double x_cur(0), y_cur(0);
+      vpPixelMeterConversion::convertPoint(cam, static_cast<double>(x), static_cast<double>(y), x_cur, y_cur);
+      curSlots.push_back((unsigned int)slot);
+      curInd.push_back((int)i);
+      curI.push_back(static_cast<double>(y));
+      curJ.push_back(static_cast<double>(x));
+      curX.push_back(x_cur);
+      curY.push_back(y_cur);
       nbPointsCur++;
     }
   }
@@ -154,12 +222,44 @@ vpMbtDistanceKltPoints::computeNbDetectedCurrent(const vpKltOpencv& _tracker)
   return nbPointsCur;
 }
 
+/*!
+  compute the number of point tracked by vpKltNative that corresponds to the
+  points of the face
+
+  \param _tracker : the KLT tracker
+  \return the number of points that are tracked in this face and in this instanciation of the tracker
+*/
+unsigned int
+vpMbtDistanceKltPoints::computeNbDetectedCurrent(const vpKltNative& _tracker)
+{
+  return computeNbDetectedCurrentFrom(_tracker);
+}
+
+#if defined(VISP_HAVE_OPENCV)
+/*!
+  compute the number of point tracked by vpKltOpencv that corresponds to the
+  points of the face
+
+  \param _tracker : the KLT tracker
+  \return the number of points that are tracked in this face and in this instanciation of the tracker
+*/
+unsigned int
+vpMbtDistanceKltPoints::computeNbDetectedCurrent(const vpKltOpencv& _tracker)
+{
+  return computeNbDetectedCurrentFrom(_tracker);
+}
+#endif
+
 /*!
   Compute the interaction matrix and the residu vector for the face.
   The method assumes that these two objects are properly sized in order to be
   able to improve the speed with the use of SubCoVector and subMatrix.
 
-  \warning The function preCompute must be called before the this method.
+  The initial points are transferred in the current image with the homography
+  and compared to the current points. All the coordinates are read from flat
+  arrays already expressed in meter, so that the loop only does arithmetic.
+
+  \warning The function computeHomography() must be called before the this method.
 
   \param _R : the residu vector
   \param _J : the interaction matrix
@@ -167,78 +267,113 @@ vpMbtDistanceKltPoints::computeNbDetectedCurrent(const vpKltOpencv& _tracker)
 void
 vpMbtDistanceKltPoints::computeInteractionMatrixAndResidu(vpColVector& _R, vpMatrix& _J)
 {
-  unsigned int index_ = 0;
-
-  std::map<int, vpImagePoint>::const_iterator iter = curPoints.begin();
-  for( ; iter != curPoints.end(); iter++){
-    int id(iter->first);
-    double i_cur(iter->second.get_i()), j_cur(iter->second.get_j());
-
-    double x_cur(0), y_cur(0);
-    vpPixelMeterConversion::convertPoint(cam, j_cur, i_cur, x_cur, y_cur);
-
-    vpImagePoint iP0 = initPoints[id];
-    double x0(0), y0(0);
-    vpPixelMeterConversion::convertPoint(cam, iP0, x0, y0);
-
-    double x0_transform, y0_transform ;// equivalent x and y in the first image (reference)
-    computeP_mu_t(x0, y0, x0_transform, y0_transform, H );
-
-    double invZ = compute_1_over_Z(x_cur, y_cur);
-
-    _J[2*index_][0] = - invZ;
-    _J[2*index_][1] = 0;
-    _J[2*index_][2] = x_cur * invZ;
-    _J[2*index_][3] = x_cur * y_cur;
-    _J[2*index_][4] = -(1+x_cur*x_cur);
-    _J[2*index_][5] = y_cur;
-
-    _J[2*index_+1][0] = 0;
-    _J[2*index_+1][1] = - invZ;
-    _J[2*index_+1][2] = y_cur * invZ;
-    _J[2*index_+1][3] = (1+y_cur*y_cur);
-    _J[2*index_+1][4] = - y_cur * x_cur;
-    _J[2*index_+1][5] = - x_cur;
-
-    _R[2*index_] =  (x0_transform - x_cur);
-    _R[2*index_+1] = (y0_transform - y_cur);
-    index_++;
+  const double h00 = H[0][0], h01 = H[0][1], h02 = H[0][2];
+  const double h10 = H[1][0], h11 = H[1][1], h12 = H[1][2];
+  const double h20 = H[2][0], h21 = H[2][1], h22 = H[2][2];
+  const double n0 = cRc0_0n[0], n1 = cRc0_0n[1], n2 = cRc0_0n[2];
+  const double den = -(d0 - dt);
+
+  const unsigned int *slots = nbPointsCur ? &curSlots[0] : NULL;
+  const double *x0s = initX.empty() ? NULL : &initX[0];
+  const double *y0s = initY.empty() ? NULL : &initY[0];
+  const double *xs = nbPointsCur ? &curX[0] : NULL;
+  const double *ys = nbPointsCur ? &curY[0] : NULL;
+
+  bool degenerate = false;
+  for(unsigned int k = 0; k < nbPointsCur; k++){
+    const double x_cur = xs[k];
+    const double y_cur = ys[k];
+    const double x0 = x0s[slots[k]];
+    const double y0 = y0s[slots[k]];
+
+    // equivalent x and y in the first image (reference)
+    const double p_mu_t_2 = x0 * h20 + y0 * h21 + h22;
+    degenerate = degenerate || (fabs(p_mu_t_2) < std::numeric_limits<double>::epsilon());
+    const double x0_transform = (x0 * h00 + y0 * h01 + h02) / p_mu_t_2;
+    const double y0_transform = (x0 * h10 + y0 * h11 + h12) / p_mu_t_2;
+
+    const double invZ = (n0 * x_cur + n1 * y_cur + n2) / den;
+
+    double *Jx = _J[2*k];
+    double *Jy = _J[2*k+1];
+    Jx[0] = - invZ;
+    Jx[1] = 0;
+    Jx[2] = x_cur * invZ;
+    Jx[3] = x_cur * y_cur;
+    Jx[4] = -(1+x_cur*x_cur);
+    Jx[5] = y_cur;
+
+    Jy[0] = 0;
+    Jy[1] = - invZ;
+    Jy[2] = y_cur * invZ;
+    Jy[3] = (1+y_cur*y_cur);
+    Jy[4] = - y_cur * x_cur;
+    Jy[5] = - x_cur;
+
+    _R[2*k] =  (x0_transform - x_cur);
+    _R[2*k+1] = (y0_transform - y_cur);
   }
-}
 
-double
-vpMbtDistanceKltPoints::compute_1_over_Z(const double x, const double y)
-{
-  double num = cRc0_0n[0] * x + cRc0_0n[1] * y + cRc0_0n[2];
-  double den = -(d0 - dt);
-  return num/den;
+  if(degenerate)
+    throw vpException(vpException::divideByZeroError, "the depth of the point is calculated to zero");
 }
 
 /*!
-  Compute the new coordinates of a point given by its \f$(x,y)\f$ coordinates
-  after the homography.
-
-  \f$ P_t = {}^{c_t}H_{c_0} . P_0 \f$
-
-  \param x_in : the x coordinates of the input point
-  \param y_in : the y coordinates of the input point
-  \param x_out : the x coordinates of the output point
-  \param y_out : the y coordinates of the output point
-  \param _cHc0 : the homography used to transfer the point
+  Add to the face a point detected after the initialisation. Its position in
+  the initial image is obtained by transferring its current position with
+  the homography of the face plane, so that it is then tracked as the points
+  detected at the initialisation. The point is taken into account from the
+  next call to computeNbDetectedCurrent().
+
+  \param id : ID of the point in the KLT tracker.
+  \param ip : Position of the point in the current image.
+  \param cTc0 : Displacement of the camera between the initial position and
+  the current position.
+
+  \return true if the point was added, false if it is already in the face or
+  if it cannot be transferred in the initial image.
 */
-inline void
-vpMbtDistanceKltPoints::computeP_mu_t(const double x_in, const double y_in, double& x_out, double& y_out, const vpMatrix& _cHc0)
+bool
+vpMbtDistanceKltPoints::addPoint(const int id, const vpImagePoint &ip, const vpHomogeneousMatrix &cTc0)
 {
-  double p_mu_t_2 = x_in * _cHc0[2][0] + y_in * _cHc0[2][1] + _cHc0[2][2];
-
-  if( fabs(p_mu_t_2) < std::numeric_limits<double>::epsilon()){
-    x_out = 0.0;
-    y_out = 0.0;
-    throw vpException(vpException::divideByZeroError, "the depth of the point is calculated to zero");
+  if(getSlot(id) >= 0)
+    return false;
+
+  vpHomography cHc0;
+  computeHomography(cTc0, cHc0);
+  vpMatrix c0Hc = H.inverseByLU();
+
+  double x = 0, y = 0;
+  vpPixelMeterConversion::convertPoint(cam, ip, x, y);
+  const double w = c0Hc[2][0] * x + c0Hc[2][1] * y + c0Hc[2][2];
+  if(fabs(w) < std::numeric_limits<double>::epsilon())
+    return false;
+  const double x0 = (c0Hc[0][0] * x + c0Hc[0][1] * y + c0Hc[0][2]) / w;
+  const double y0 = (c0Hc[1][0] * x + c0Hc[1][1] * y + c0Hc[1][2]) / w;
+
+  double u0 = 0, v0 = 0;
+  vpMeterPixelConversion::convertPoint(cam, x0, y0, u0, v0);
+
+  const int slot = (int)initIds.size();
+  initIds.push_back(id);
+  initI.push_back(v0);
+  initJ.push_back(u0);
+  initX.push_back(x0);
+  initY.push_back(y0);
+
+  if(slot == 0){
+    idToSlot.clear();
+    idOffset = id;
+  }
+  else if(id < idOffset){
+    idToSlot.insert(idToSlot.begin(), (size_t)(idOffset - id), -1);
+    idOffset = id;
   }
+  if((size_t)(id - idOffset) >= idToSlot.size())
+    idToSlot.resize((size_t)(id - idOffset) + 1, -1);
+  idToSlot[(size_t)(id - idOffset)] = slot;
 
-  x_out = (x_in * _cHc0[0][0] + y_in * _cHc0[0][1] + _cHc0[0][2]) / p_mu_t_2;
-  y_out = (x_in * _cHc0[1][0] + y_in * _cHc0[1][1] + _cHc0[1][2]) / p_mu_t_2;
+  return true;
 }
 
 /*!
@@ -293,30 +428,178 @@ vpMbtDistanceKltPoints::computeHomography(const vpHomogeneousMatrix& _cTc0, vpHo
 }
 
 /*!
-  Test whether the feature with identifier id in paramters is in the list of tracked
-  features.
+  Predict the position of the points of the face in the image seen from a
+  predicted displacement of the camera, by transferring their initial
+  position with the homography of the face plane. It is used to give the KLT
+  tracker an initial guess of the position of the features.
+
+  \param cTc0 : Predicted displacement of the camera between the initial
+  position and the next image.
+  \param ids : IDs of the features of the KLT tracker.
+  \param points : Positions of the features, with the same size as \e ids.
+  The positions of the features that belong to the face are replaced by their
+  prediction, the other ones are not modified.
+*/
+void
+vpMbtDistanceKltPoints::predictPoints(const vpHomogeneousMatrix &cTc0, const std::vector<long> &ids,
+                                      std::vector<vpImagePoint> &points)
+{
+  if(initIds.empty())
+    return;
+
+  vpHomography cHc0;
+  computeHomography(cTc0, cHc0);
+
+  for(size_t k = 0; k < ids.size() && k < points.size(); k++){
+    int slot = getSlot((int)ids[k]);
+    if(slot < 0)
+      continue;
+
+    const double x0 = initX[(size_t)slot];
+    const double y0 = initY[(size_t)slot];
+    const double w = H[2][0] * x0 + H[2][1] * y0 + H[2][2];
+    if(fabs(w) < std::numeric_limits<double>::epsilon())
+      continue;
+    const double x = (H[0][0] * x0 + H[0][1] * y0 + H[0][2]) / w;
+    const double y = (H[1][0] * x0 + H[1][1] * y0 + H[1][2]) / w;
+
+    double u = 0, v = 0;
+    vpMeterPixelConversion::convertPoint(cam, x, y, u, v);
+    points[k].set_uv(u, v);
+  }
+}
+
+/*!
+  Get the slot in the initial arrays of the feature with identifier id in
+  parameter.
 
   \param _id : the id of the current feature to test
-  \return true if the id is in the list of tracked feature
+  \return the slot of the feature, or -1 if it is not in the list of tracked
+  features.
 */
-bool
-vpMbtDistanceKltPoints::isTrackedFeature(const int _id)
+int
+vpMbtDistanceKltPoints::getSlot(const int _id) const
 {
-//   std::map<int, vpImagePoint>::const_iterator iter = initPoints.begin();
-//   while(iter != initPoints.end()){
-//     if(iter->first == _id){
-//       return true;
-//     }
-//     iter++;
-//   }
-
-  std::map<int, vpImagePoint>::iterator iter = initPoints.find(_id);
-  if(iter != initPoints.end())
-    return true;
-
-  return false;
+  if(_id < idOffset)
+    return -1;
+
+  size_t index = (size_t)(_id - idOffset);
+  if(index >= idToSlot.size())
+    return -1;
+
+  return idToSlot[index];
+}
+
+/*!
+  Get the points detected in the last image.
+
+  \warning This method builds a copy of the points. Prefer getCurrentPoint()
+  and getCurrentPointId() to parse them.
+
+  \return a map of the current points with their ID as key.
+*/
+std::map<int, vpImagePoint>
+vpMbtDistanceKltPoints::getCurrentPoints() const
+{
+  std::map<int, vpImagePoint> points;
+  for(unsigned int k = 0; k < nbPointsCur; k++)
+    points[getCurrentPointId(k)] = vpImagePoint(curI[k], curJ[k]);
+
+  return points;
+}
+
+/*!
+  Get the indexes in the KLT tracker of the points detected in the last image.
+
+  \warning This method builds a copy of the indexes. Prefer getCurrentPointInd()
+  and getCurrentPointId() to parse them.
+
+  \return a map of the current point indexes with their ID as key.
+*/
+std::map<int, int>
+vpMbtDistanceKltPoints::getCurrentPointsInd() const
+{
+  std::map<int, int> indexes;
+  for(unsigned int k = 0; k < nbPointsCur; k++)
+    indexes[getCurrentPointId(k)] = curInd[k];
+
+  return indexes;
+}
+
+/*!
+  Set the camera parameters. The coordinates in meter of the initial and
+  current points are updated accordingly.
+
+  \param _cam : the new camera parameters
+*/
+void
+vpMbtDistanceKltPoints::setCameraParameters(const vpCameraParameters& _cam)
+{
+  cam = _cam;
+
+  for(unsigned int k = 0; k < initIds.size(); k++)
+    vpPixelMeterConversion::convertPoint(cam, initJ[k], initI[k], initX[k], initY[k]);
+  for(unsigned int k = 0; k < nbPointsCur; k++)
+    vpPixelMeterConversion::convertPoint(cam, curJ[k], curI[k], curX[k], curY[k]);
 }
 
+/*!
+  Modification of all the pixels that are in the roi to the value of _nb (
+  default is 255).
+
+  \param mask : the mask to update (0, not in the object, _nb otherwise).
+  \param nb : Optionnal value to set to the pixels included in the face.
+  \param shiftBorder : Optionnal shift for the border in pixel (sort of built-in erosion) to avoid to consider pixels near the limits of the face.
+*/
+void
+vpMbtDistanceKltPoints::updateMask(vpImage<unsigned char> &mask, unsigned char nb, unsigned int shiftBorder)
+{
+  int width  = (int)mask.getWidth();
+  int height = (int)mask.getHeight();
+
+  int i_min, i_max, j_min, j_max;
+  std::vector<vpImagePoint> roi;
+  polygon->getRoiClipped(cam, roi);
+  vpPolygon3D::getMinMaxRoi(roi, i_min, i_max, j_min,j_max);
+
+  /* check image boundaries */
+  if(i_min > height || i_min < 0){ //underflow
+    i_min = 0;
+  }
+  if(i_max > height){
+    i_max = height;
+  }
+  if(j_min > width || j_min < 0){ //underflow
+    j_min = 0;
+  }
+  if(j_max > width){
+    j_max = width;
+  }
+
+  double shiftBorder_d = (double) shiftBorder;
+  for(int i=i_min; i< i_max; i++){
+    double i_d = (double) i;
+    for(int j=j_min; j< j_max; j++){
+      double j_d = (double) j;
+      if(shiftBorder != 0){
+        if( vpPolygon::isInside(roi, i_d, j_d)
+            && vpPolygon::isInside(roi, i_d+shiftBorder_d, j_d+shiftBorder_d)
+            && vpPolygon::isInside(roi, i_d-shiftBorder_d, j_d+shiftBorder_d)
+            && vpPolygon::isInside(roi, i_d+shiftBorder_d, j_d-shiftBorder_d)
+            && vpPolygon::isInside(roi, i_d-shiftBorder_d, j_d-shiftBorder_d) ){
+          mask[(unsigned int)i][(unsigned int)j] = nb;
+        }
+      }
+      else{
+        if(vpPolygon::isInside(roi, i, j)){
+          mask[(unsigned int)i][(unsigned int)j] = nb;
+        }
+      }
+    }
+  }
+}
+
+#if defined(VISP_HAVE_OPENCV)
 /*!
   Modification of all the pixels that are in the roi to the value of _nb (
   default is 255).
@@ -348,13 +631,13 @@ vpMbtDistanceKltPoints::updateMask(
   vpPolygon3D::getMinMaxRoi(roi, i_min, i_max, j_min,j_max);
 
   /* check image boundaries */
-  if(i_min > height){ //underflow
+  if(i_min > height || i_min < 0){ //underflow
     i_min = 0;
   }
   if(i_max > height){
     i_max = height;
   }
-  if(j_min > width){ //underflow
+  if(j_min > width || j_min < 0){ //underflow
     j_min = 0;
   }
   if(j_max > width){
@@ -414,6 +697,7 @@ vpMbtDistanceKltPoints::updateMask(
   }
 #endif
 }
+#endif
 
 /*!
   This method removes the outliers. A point is considered as outlier when its
@@ -425,31 +709,36 @@ vpMbtDistanceKltPoints::updateMask(
 void
 vpMbtDistanceKltPoints::removeOutliers(const vpColVector& _w, const double &threshold_outlier)
 {
-  std::map<int, vpImagePoint> tmp;
-  std::map<int, int> tmp2;
   unsigned int nbSupp = 0;
-  unsigned int k = 0;
-
-  nbPointsCur = 0;
-  std::map<int, vpImagePoint>::const_iterator iter = curPoints.begin();
-  for( ; iter != curPoints.end(); iter++){
-    if(_w[k] > threshold_outlier && _w[k+1] > threshold_outlier){
-//     if(_w[k] > threshold_outlier || _w[k+1] > threshold_outlier){
-      tmp[iter->first] = vpImagePoint(iter->second.get_i(), iter->second.get_j());
-      tmp2[iter->first] = curPointsInd[iter->first];
-      nbPointsCur++;
+  unsigned int nbKept = 0;
+
+  for(unsigned int k = 0; k < nbPointsCur; k++){
+    if(_w[2*k] > threshold_outlier && _w[2*k+1] > threshold_outlier){
+//     if(_w[2*k] > threshold_outlier || _w[2*k+1] > threshold_outlier){
+      if(nbKept != k){
+        curSlots[nbKept] = curSlots[k];
+        curInd[nbKept] = curInd[k];
+        curI[nbKept] = curI[k];
+        curJ[nbKept] = curJ[k];
+        curX[nbKept] = curX[k];
+        curY[nbKept] = curY[k];
+      }
+      nbKept++;
     }
     else{
       nbSupp++;
-      initPoints.erase(iter->first);
+      idToSlot[(size_t)(initIds[curSlots[k]] - idOffset)] = -1;
     }
-
-    k+=2;
   }
 
   if(nbSupp != 0){
-    curPoints = tmp;
-    curPointsInd = tmp2;
+    nbPointsCur = nbKept;
+    curSlots.resize(nbPointsCur);
+    curInd.resize(nbPointsCur);
+    curI.resize(nbPointsCur);
+    curJ.resize(nbPointsCur);
+    curX.resize(nbPointsCur);
+    curY.resize(nbPointsCur);
     if(nbPointsCur >= minNbPoint) enoughPoints = true;
     else enoughPoints = false;
   }
@@ -463,12 +752,11 @@ vpMbtDistanceKltPoints::removeOutliers(const vpColVector& _w, const double &thre
 void
 vpMbtDistanceKltPoints::displayPrimitive(const vpImage<unsigned char>& _I)
 {
-  std::map<int, vpImagePoint>::const_iterator iter = curPoints.begin();
-  for( ; iter != curPoints.end(); iter++){
-    int id(iter->first);
+  for(unsigned int k = 0; k < nbPointsCur; k++){
+    int id(getCurrentPointId(k));
     vpImagePoint iP;
-    iP.set_i(static_cast<double>(iter->second.get_i()));
-    iP.set_j(static_cast<double>(iter->second.get_j()));
+    iP.set_i(curI[k]);
+    iP.set_j(curJ[k]);
 
     vpDisplay::displayCross(_I, iP, 10, vpColor::red);
 
@@ -488,12 +776,11 @@ vpMbtDistanceKltPoints::displayPrimitive(const vpImage<unsigned char>& _I)
 void
 vpMbtDistanceKltPoints::displayPrimitive(const vpImage<vpRGBa>& _I)
 {
-  std::map<int, vpImagePoint>::const_iterator iter = curPoints.begin();
-  for( ; iter != curPoints.end(); iter++){
-    int id(iter->first);
+  for(unsigned int k = 0; k < nbPointsCur; k++){
+    int id(getCurrentPointId(k));
     vpImagePoint iP;
-    iP.set_i(static_cast<double>(iter->second.get_i()));
-    iP.set_j(static_cast<double>(iter->second.get_j()));
+    iP.set_i(curI[k]);
+    iP.set_j(curJ[k]);
 
     vpDisplay::displayCross(_I, iP, 10, vpColor::red);
 
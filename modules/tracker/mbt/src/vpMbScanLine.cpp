@@ -45,8 +45,14 @@
 #include <algorithm>
 #include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <utility>
 
+#ifdef VISP_HAVE_OPENMP
+#include <omp.h>
+#endif
+
 #include <visp3/mbt/vpMbScanLine.h>
 #include <visp3/core/vpMeterPixelConversion.h>
 
@@ -58,9 +64,22 @@
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
+namespace
+{
+  // The samples of an edge are found in increasing order while sweeping the scanlines
+  inline void addVisibilitySample(std::vector<int> &samples, const int v)
+  {
+    if (samples.empty() || samples.back() != v)
+      samples.push_back(v);
+  }
+}
+
 vpMbScanLine::vpMbScanLine()
   : w(0), h(0), K(), maskBorder(0), mask(), primitive_ids(),
-    visibility_samples(), depthTreshold(1e-06)
+    edge_indices(), visibility_samples(), depthTreshold(1e-06), threaded(false),
+    polygon_edges(), polygon_edges_offsets(), scanlinesY(), scanlinesX(),
+    local_scanlinesY(), local_scanlinesX(), visibility_samplesY(), visibility_samplesX(),
+    maskY(), maskX()
 #if defined(DEBUG_DISP)
   ,dispMaskDebug(NULL), dispLineDebug(NULL), linedebugImg()
 #endif
@@ -86,13 +105,13 @@ vpMbScanLine::~vpMbScanLine()
 
   \param a : First point of the line.
   \param b : Second point of the line.
-  \param edge : Pair with the two points of the line.
+  \param edge : Index of the edge corresponding to the line.
   \param ID : Id of the given line (has to be know when using queries).
   \param scanlines : Resulting intersections.
 */
-void vpMbScanLine::drawLineY(const vpColVector &a,
-               const vpColVector &b,
-               const vpMbScanLineEdge &edge,
+void vpMbScanLine::drawLineY(const double a[3],
+               const double b[3],
+               const unsigned int edge,
                const int ID,
                std::vector<std::vector<vpMbScanLineSegment> > &scanlines)
 {
@@ -139,13 +158,13 @@ void vpMbScanLine::drawLineY(const vpColVector &a,
 
   \param a : First point of the line.
   \param b : Second point of the line.
-  \param edge : Pair with the two points of the line.
+  \param edge : Index of the edge corresponding to the line.
   \param ID : Id of the given line (has to be know when using queries).
   \param scanlines : Resulting intersections.
 */
-void vpMbScanLine::drawLineX(const vpColVector &a,
-               const vpColVector &b,
-               const vpMbScanLineEdge &edge,
+void vpMbScanLine::drawLineX(const double a[3],
+               const double b[3],
+               const unsigned int edge,
                const int ID,
                std::vector<std::vector<vpMbScanLineSegment> > &scanlines)
 {
@@ -192,11 +211,13 @@ void vpMbScanLine::drawLineX(const vpColVector &a,
   Compute the Y-axis scanlines intersections of a polygon.
 
   \param polygon : Polygon composed by an array of lines.
+  \param edges : Indexes of the edges of the polygon.
   \param ID : ID of the polygon (has to be know when using queries).
   \param scanlines : Resulting intersections.
 */
 void
 vpMbScanLine::drawPolygonY(const std::vector<std::pair<vpPoint, unsigned int> > &polygon,
+                  const unsigned int *edges,
                   const int ID,
                   std::vector<std::vector<vpMbScanLineSegment> > &scanlines)
 {
@@ -205,42 +226,51 @@ vpMbScanLine::drawPolygonY(const std::vector<std::pair<vpPoint, unsigned int> >
 
   if (polygon.size() == 2)
   {
-    vpColVector p1, p2;
+    double p1[3], p2[3];
     createVectorFromPoint(polygon.front().first, p1, K);
     createVectorFromPoint(polygon.back().first, p2, K);
 
-    drawLineY(p1,
-              p2,
-              makeMbScanLineEdge(polygon.front().first, polygon.back().first),
-              ID,
-              scanlines);
+    drawLineY(p1, p2, edges[0], ID, scanlines);
     return;
   }
 
-  std::vector<std::vector<vpMbScanLineSegment> > local_scanlines;
-  local_scanlines.resize(h);
-
+  double yMin = std::numeric_limits<double>::max();
+  double yMax = -std::numeric_limits<double>::max();
+  double p1[3], p2[3];
+  createVectorFromPoint(polygon.front().first, p2, K);
   for(size_t i = 0 ; i < polygon.size() ; ++i)
   {
-    vpColVector p1, p2;
-    createVectorFromPoint(polygon[i].first, p1, K);
+    std::copy(p2, p2 + 3, p1);
     createVectorFromPoint(polygon[(i + 1) % polygon.size()].first, p2, K);
 
-    drawLineY(p1, p2, makeMbScanLineEdge(polygon[i].first, polygon[(i + 1) % polygon.size()].first), ID, local_scanlines);
+    const double y = p1[1] / p1[2];
+    yMin = std::min(yMin, y);
+    yMax = std::max(yMax, y);
+
+    drawLineY(p1, p2, edges[i], ID, local_scanlinesY);
   }
 
-  createScanLinesFromLocals(scanlines,local_scanlines,h);
+  // Only the rows spanned by the polygon may have been filled
+  unsigned int first = 0, last = h;
+  if (yMin > 0)
+    first = (unsigned int)std::min<double>(h, std::ceil(yMin));
+  if (yMax < h)
+    last = (unsigned int)std::max<double>(0, std::ceil(yMax));
+
+  createScanLinesFromLocals(scanlines, local_scanlinesY, first, last);
 }
 
 /*!
   Compute the X-axis scanlines intersections of a polygon.
 
   \param polygon : Polygon composed by an array of lines.
+  \param edges : Indexes of the edges of the polygon.
   \param ID : ID of the polygon (has to be know when using queries).
   \param scanlines : Resulting intersections.
 */
 void
 vpMbScanLine::drawPolygonX(const std::vector<std::pair<vpPoint, unsigned int> > &polygon,
+                  const unsigned int *edges,
                   const int ID,
                   std::vector<std::vector<vpMbScanLineSegment> > &scanlines)
 {
@@ -249,48 +279,57 @@ vpMbScanLine::drawPolygonX(const std::vector<std::pair<vpPoint, unsigned int> >
 
   if (polygon.size() == 2)
   {
-    vpColVector p1, p2;
+    double p1[3], p2[3];
     createVectorFromPoint(polygon.front().first, p1, K);
     createVectorFromPoint(polygon.back().first, p2, K);
 
-    drawLineX(p1,
-              p2,
-              makeMbScanLineEdge(polygon.front().first, polygon.back().first),
-              ID,
-              scanlines);
+    drawLineX(p1, p2, edges[0], ID, scanlines);
     return;
   }
 
-  std::vector<std::vector<vpMbScanLineSegment> > local_scanlines;
-  local_scanlines.resize(w);
-
+  double xMin = std::numeric_limits<double>::max();
+  double xMax = -std::numeric_limits<double>::max();
+  double p1[3], p2[3];
+  createVectorFromPoint(polygon.front().first, p2, K);
   for(size_t i = 0 ; i < polygon.size() ; ++i)
   {
-    vpColVector p1, p2;
-    createVectorFromPoint(polygon[i].first, p1, K);
+    std::copy(p2, p2 + 3, p1);
     createVectorFromPoint(polygon[(i + 1) % polygon.size()].first, p2, K);
 
-    drawLineX(p1, p2, makeMbScanLineEdge(polygon[i].first, polygon[(i + 1) % polygon.size()].first), ID, local_scanlines);
+    const double x = p1[0] / p1[2];
+    xMin = std::min(xMin, x);
+    xMax = std::max(xMax, x);
+
+    drawLineX(p1, p2, edges[i], ID, local_scanlinesX);
   }
 
-  createScanLinesFromLocals(scanlines,local_scanlines,w);
+  // Only the columns spanned by the polygon may have been filled
+  unsigned int first = 0, last = w;
+  if (xMin > 0)
+    first = (unsigned int)std::min<double>(w, std::ceil(xMin));
+  if (xMax < w)
+    last = (unsigned int)std::max<double>(0, std::ceil(xMax));
+
+  createScanLinesFromLocals(scanlines, local_scanlinesX, first, last);
 }
 
 /*!
   Organise local scanlines in a global scanline vector.
   It also marks the computed intersections as starting or ending points.
   This function will only be called by the drawPolygons functions.
+  The local scanlines are emptied so that they can be reused for the next polygon.
 
   \param scanlines : Global scanline vector.
   \param localScanlines : Local scanline vector (X or Y-axis).
-  \param size : Corresponding size (typically the width or the height).
+  \param first : First scanline that may contain intersections.
+  \param last : Scanline following the last one that may contain intersections.
 */
 void
 vpMbScanLine::createScanLinesFromLocals(std::vector<std::vector<vpMbScanLineSegment> > &scanlines,
                                         std::vector<std::vector<vpMbScanLineSegment> > &localScanlines,
-                                        const unsigned int &size)
+                                        const unsigned int &first, const unsigned int &last)
 {
-  for(unsigned int j = 0 ; j < size ; ++j)
+  for(unsigned int j = first ; j < last ; ++j)
   {
       std::vector<vpMbScanLineSegment> &scanline = localScanlines[j];
       sort(scanline.begin(), scanline.end(), vpMbScanLineSegmentComparator()); // Not sure its necessary
@@ -318,12 +357,31 @@ vpMbScanLine::createScanLinesFromLocals(std::vector<std::vector<vpMbScanLineSegm
           }
           scanlines[j].push_back(s);
       }
+      scanline.clear();
   }
 }
 
+/*!
+  Get the index of an edge in the table of the edges of the scene, adding it if it is not already there.
+
+  \param a : First point of the edge.
+  \param b : Second point of the edge.
+
+  \return Index of the edge.
+*/
+unsigned int
+vpMbScanLine::getEdgeIndex(const vpPoint &a, const vpPoint &b)
+{
+  const unsigned int index = (unsigned int)edge_indices.size();
+  return edge_indices.insert(std::make_pair(makeMbScanLineEdge(a, b), index)).first->second;
+}
+
 /*!
   Render a scene of polygons and compute scanlines intersections in order to use queries.
 
+  The Y-axis and X-axis scanlines are independent and are computed in parallel when enabled with setThreaded().
+  The scanlines storage is kept from one call to the next.
+
   \param polygons : List of polygons composed by arrays of lines.
   \param listPolyIndices : List of polygons IDs (has to be know when using queries).
   \param cam : Camera parameters.
@@ -339,35 +397,133 @@ vpMbScanLine::drawScene(const std::vector<std::vector<std::pair<vpPoint, unsigne
   this->h = height;
   this->K = cam;
 
-  visibility_samples.clear();
+  // The edges are indexed once for both axes, the scanline segments only refer to their index
+  edge_indices.clear();
+  polygon_edges.clear();
+  polygon_edges_offsets.resize(polygons.size());
+  for(unsigned int ID = 0 ; ID < polygons.size() ; ++ID)
+  {
+      const std::vector<std::pair<vpPoint, unsigned int> > &polygon = *(polygons[ID]);
+      polygon_edges_offsets[ID] = (unsigned int)polygon_edges.size();
+      if (polygon.size() == 2)
+        polygon_edges.push_back(getEdgeIndex(polygon.front().first, polygon.back().first));
+      else if (polygon.size() > 2)
+        for(size_t i = 0 ; i < polygon.size() ; ++i)
+          polygon_edges.push_back(getEdgeIndex(polygon[i].first, polygon[(i + 1) % polygon.size()].first));
+  }
+
+  const size_t nbEdges = edge_indices.size();
+  visibility_samples.resize(nbEdges);
+  visibility_samplesY.resize(nbEdges);
+  visibility_samplesX.resize(nbEdges);
+  for(size_t i = 0 ; i < nbEdges ; ++i)
+  {
+      visibility_samples[i].clear();
+      visibility_samplesY[i].clear();
+      visibility_samplesX[i].clear();
+  }
 
-  std::vector<std::vector<vpMbScanLineSegment> > scanlinesY;
   scanlinesY.resize(h);
-  std::vector<std::vector<vpMbScanLineSegment> > scanlinesX;
   scanlinesX.resize(w);
+  local_scanlinesY.resize(h);
+  local_scanlinesX.resize(w);
 
   mask.resize(h,w,0);
 
-  vpImage<unsigned char> maskY(h,w,0);
-  vpImage<unsigned char> maskX(h,w,0);
+  if(maskBorder != 0)
+  {
+    maskY.resize(h,w,0);
+    maskX.resize(h,w,0);
+  }
 
   primitive_ids.resize(h, w, -1);
 
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel sections if(threaded && ! omp_in_parallel())
+  {
+    #pragma omp section
+    renderY(polygons, listPolyIndices);
+    #pragma omp section
+    renderX(polygons, listPolyIndices);
+  }
+#else
+  renderY(polygons, listPolyIndices);
+  renderX(polygons, listPolyIndices);
+#endif
+
+  // The samples of each axis are sorted and unique
+  for(size_t i = 0 ; i < nbEdges ; ++i)
+  {
+      const std::vector<int> &samplesY = visibility_samplesY[i];
+      const std::vector<int> &samplesX = visibility_samplesX[i];
+      std::set_union(samplesY.begin(), samplesY.end(), samplesX.begin(), samplesX.end(),
+                     std::back_inserter(visibility_samples[i]));
+  }
+
+  if(maskBorder != 0)
+    for(unsigned int i = 0 ; i < h ; i++)
+      for(unsigned int j = 0 ; j < w ; j++)
+        if(maskX[i][j] == 255 && maskY[i][j] == 255)
+          mask[i][j] = 255;
+
+#if (defined(VISP_HAVE_X11) || defined(VISP_HAVE_GDI)) && defined(DEBUG_DISP)
+  if(!dispMaskDebug->isInitialised()){
+    dispMaskDebug->init(mask, 800, 600);
+  }
+
+  vpDisplay::display(mask);
+
   for(unsigned int ID = 0 ; ID < polygons.size() ; ++ID)
   {
-      drawPolygonY(*(polygons[ID]), listPolyIndices[ID], scanlinesY);
-      drawPolygonX(*(polygons[ID]), listPolyIndices[ID], scanlinesX);
+    for(unsigned int i = 0 ; i < polygons[ID]->size() ; i++){
+      vpPoint p1 = (*(polygons[ID]))[i].first;
+      vpPoint p2 = (*(polygons[ID]))[(i+1)%polygons[ID]->size()].first;
+      double i1=0,j1=0,i2=0,j2=0;
+      p1.project();
+      p2.project();
+      vpMeterPixelConversion::convertPoint(K,p1.get_x(), p1.get_y(),j1,i1);
+      vpMeterPixelConversion::convertPoint(K,p2.get_x(), p2.get_y(),j2,i2);
+
+      vpDisplay::displayLine(mask,i1,j1,i2,j2,vpColor::red,3);
+    }
+  }
+
+  vpDisplay::flush(mask);
+
+
+  if(!dispLineDebug->isInitialised()){
+    linedebugImg.resize(h,w,0);
+    dispLineDebug->init(linedebugImg, 800, 100);
   }
+  vpDisplay::display(linedebugImg);
+#endif
+
+}
+
+/*!
+  Compute the Y-axis scanlines of the scene, the visibility samples of the edges that are sampled along the Y-axis,
+  the primitive IDs and the Y-axis mask.
+
+  \param polygons : List of polygons composed by arrays of lines.
+  \param listPolyIndices : List of polygons IDs.
+*/
+void
+vpMbScanLine::renderY(const std::vector<std::vector<std::pair<vpPoint, unsigned int> > * > &polygons,
+                      const std::vector<int> &listPolyIndices)
+{
+  const unsigned int *edges = polygon_edges.empty() ? NULL : &polygon_edges[0];
+  for(unsigned int ID = 0 ; ID < polygons.size() ; ++ID)
+      drawPolygonY(*(polygons[ID]), edges + polygon_edges_offsets[ID], listPolyIndices[ID], scanlinesY);
 
-  // Y
   int last_ID = -1;
   vpMbScanLineSegment last_visible;
+  std::vector<std::pair<double, vpMbScanLineSegment> > stack;
   for(unsigned int y = 0 ; y < scanlinesY.size() ; ++y)
   {
       std::vector<vpMbScanLineSegment> &scanline = scanlinesY[y];
       sort(scanline.begin(), scanline.end(), vpMbScanLineSegmentComparator());
 
-      std::vector<std::pair<double, vpMbScanLineSegment> > stack;
+      stack.clear();
       for(size_t i = 0 ; i < scanline.size() ; ++i)
       {
           const vpMbScanLineSegment &s = scanline[i];
@@ -406,15 +562,15 @@ vpMbScanLine::drawScene(const std::vector<std::vector<std::pair<vpPoint, unsigne
                   {
                   case POINT:
                       if (new_ID == -1 || s.Z1 - depthTreshold <= stack.front().first)
-                          visibility_samples[s.edge].insert((int)y);
+                          addVisibilitySample(visibility_samplesY[s.edge], (int)y);
                       break;
                   case START:
                       if (new_ID == s.ID)
-                          visibility_samples[s.edge].insert((int)y);
+                          addVisibilitySample(visibility_samplesY[s.edge], (int)y);
                       break;
                   case END:
                       if (last_ID == s.ID)
-                          visibility_samples[s.edge].insert((int)y);
+                          addVisibilitySample(visibility_samplesY[s.edge], (int)y);
                       break;
                   }
 
@@ -442,16 +598,34 @@ vpMbScanLine::drawScene(const std::vector<std::vector<std::pair<vpPoint, unsigne
               }
           }
       }
+      scanline.clear();
   }
+}
 
-  // X
-  last_ID = -1;
+/*!
+  Compute the X-axis scanlines of the scene, the visibility samples of the edges that are sampled along the X-axis
+  and the X-axis mask.
+
+  \param polygons : List of polygons composed by arrays of lines.
+  \param listPolyIndices : List of polygons IDs.
+*/
+void
+vpMbScanLine::renderX(const std::vector<std::vector<std::pair<vpPoint, unsigned int> > * > &polygons,
+                      const std::vector<int> &listPolyIndices)
+{
+  const unsigned int *edges = polygon_edges.empty() ? NULL : &polygon_edges[0];
+  for(unsigned int ID = 0 ; ID < polygons.size() ; ++ID)
+      drawPolygonX(*(polygons[ID]), edges + polygon_edges_offsets[ID], listPolyIndices[ID], scanlinesX);
+
+  int last_ID = -1;
+  vpMbScanLineSegment last_visible;
+  std::vector<std::pair<double, vpMbScanLineSegment> > stack;
   for(unsigned int x = 0 ; x < scanlinesX.size() ; ++x)
   {
       std::vector<vpMbScanLineSegment> &scanline = scanlinesX[x];
       sort(scanline.begin(), scanline.end(), vpMbScanLineSegmentComparator());
 
-      std::vector<std::pair<double, vpMbScanLineSegment> > stack;
+      stack.clear();
       for(size_t i = 0 ; i < scanline.size() ; ++i)
       {
           const vpMbScanLineSegment &s = scanline[i];
@@ -490,15 +664,15 @@ vpMbScanLine::drawScene(const std::vector<std::vector<std::pair<vpPoint, unsigne
                   {
                   case POINT:
                       if (new_ID == -1 || s.Z1 - depthTreshold <= stack.front().first)
-                          visibility_samples[s.edge].insert((int)x);
+                          addVisibilitySample(visibility_samplesX[s.edge], (int)x);
                       break;
                   case START:
                       if (new_ID == s.ID)
-                          visibility_samples[s.edge].insert((int)x);
+                          addVisibilitySample(visibility_samplesX[s.edge], (int)x);
                       break;
                   case END:
                       if (last_ID == s.ID)
-                          visibility_samples[s.edge].insert((int)x);
+                          addVisibilitySample(visibility_samplesX[s.edge], (int)x);
                       break;
                   }
 
@@ -522,46 +696,8 @@ vpMbScanLine::drawScene(const std::vector<std::vector<std::pair<vpPoint, unsigne
               }
           }
       }
+      scanline.clear();
   }
-
-  if(maskBorder != 0)
-    for(unsigned int i = 0 ; i < h ; i++)
-      for(unsigned int j = 0 ; j < w ; j++)
-        if(maskX[i][j] == 255 && maskY[i][j] == 255)
-          mask[i][j] = 255;
-
-#if (defined(VISP_HAVE_X11) || defined(VISP_HAVE_GDI)) && defined(DEBUG_DISP)
-  if(!dispMaskDebug->isInitialised()){
-    dispMaskDebug->init(mask, 800, 600);
-  }
-
-  vpDisplay::display(mask);
-
-  for(unsigned int ID = 0 ; ID < polygons.size() ; ++ID)
-  {
-    for(unsigned int i = 0 ; i < polygons[ID]->size() ; i++){
-      vpPoint p1 = (*(polygons[ID]))[i].first;
-      vpPoint p2 = (*(polygons[ID]))[(i+1)%polygons[ID]->size()].first;
-      double i1=0,j1=0,i2=0,j2=0;
-      p1.project();
-      p2.project();
-      vpMeterPixelConversion::convertPoint(K,p1.get_x(), p1.get_y(),j1,i1);
-      vpMeterPixelConversion::convertPoint(K,p2.get_x(), p2.get_y(),j2,i2);
-
-      vpDisplay::displayLine(mask,i1,j1,i2,j2,vpColor::red,3);
-    }
-  }
-
-  vpDisplay::flush(mask);
-
-
-  if(!dispLineDebug->isInitialised()){
-    linedebugImg.resize(h,w,0);
-    dispLineDebug->init(linedebugImg, 800, 100);
-  }
-  vpDisplay::display(linedebugImg);
-#endif
-
 }
 
 /*!
@@ -577,7 +713,7 @@ vpMbScanLine::queryLineVisibility(const vpPoint &a, const vpPoint &b,
                                   std::vector<std::pair<vpPoint, vpPoint> > &lines,
                                   const bool &displayResults)
 {
-  vpColVector _a, _b;
+  double _a[3], _b[3];
   createVectorFromPoint(a, _a, K);
   createVectorFromPoint(b, _b, K);
 
@@ -604,7 +740,8 @@ vpMbScanLine::queryLineVisibility(const vpPoint &a, const vpPoint &b,
 #endif
   }
 
-  if (!visibility_samples.count(edge))
+  std::map<vpMbScanLineEdge, unsigned int, vpMbScanLineEdgeComparator>::const_iterator it_edge = edge_indices.find(edge);
+  if (it_edge == edge_indices.end() || visibility_samples[it_edge->second].empty())
       return;
 
   // Initialized as the biggest difference between the two points is on the X-axis
@@ -646,12 +783,12 @@ vpMbScanLine::queryLineVisibility(const vpPoint &a, const vpPoint &b,
   const int _v0 = std::max(0, int(std::ceil(*v0)));
   const int _v1 = std::min<int>((int)(size - 1), (int)(std::ceil(*v1) - 1));
 
-  const std::set<int> &visible_samples = visibility_samples[edge];
+  const std::vector<int> &visible_samples = visibility_samples[it_edge->second];
   int last = _v0;
   vpPoint line_start;
   vpPoint line_end;
   bool b_line_started = false;
-  for(std::set<int>::const_iterator it = visible_samples.begin() ; it != visible_samples.end() ; ++it)
+  for(std::vector<int>::const_iterator it = visible_samples.begin() ; it != visible_samples.end() ; ++it)
   {
       const int v = *it;
       const double alpha = getAlpha(v, (*v0) * (*w0), (*w0), (*v1) * (*w1), (*w1));
@@ -752,10 +889,8 @@ vpMbScanLine::makeMbScanLineEdge(const vpPoint &a, const vpPoint &b)
   \param K : Camera parameters.
 */
 void
-vpMbScanLine::createVectorFromPoint(const vpPoint &p, vpColVector &v, const vpCameraParameters &K)
+vpMbScanLine::createVectorFromPoint(const vpPoint &p, double v[3], const vpCameraParameters &K)
 {
-    v = vpColVector(3);
-
     v[0] = p.get_X() * K.get_px() + K.get_u0() * p.get_Z();
     v[1] = p.get_Y() * K.get_py() + K.get_v0() * p.get_Z();
     v[2] = p.get_Z();
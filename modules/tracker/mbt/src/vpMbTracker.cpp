@@ -42,13 +42,22 @@
   \brief Generic model based tracker
 */
 
+#include <cstdio>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <algorithm>
 #include <map>
+#include <sstream>
+#if defined(_WIN32)
+#  include <process.h>
+#else
+#  include <unistd.h>
+#endif
 
 #include <visp3/core/vpMatrix.h>
 #include <visp3/core/vpMath.h>
+#include <visp3/core/vpExponentialMap.h>
 #include <visp3/core/vpColVector.h>
 #include <visp3/core/vpPoint.h>
 #include <visp3/vision/vpPose.h>
@@ -119,6 +128,46 @@ struct PolygonFaceInfo {
   vpPolygon polygon;
   std::vector<vpPoint> faceCorners;
 };
+
+/*!
+  Compute the size and the 32 bits FNV-1a hash of the content of a file.
+  Return false if the file cannot be read.
+ */
+static bool computeFileHash(const std::string &filename, unsigned int &size, unsigned int &hash)
+{
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  if (! file.is_open())
+    return false;
+
+  size = 0;
+  hash = 2166136261u;
+  char buffer[4096];
+  while (file) {
+    file.read(buffer, sizeof(buffer));
+    std::streamsize n = file.gcount();
+    for (std::streamsize i = 0; i < n; i++) {
+      hash ^= (unsigned char)buffer[i];
+      hash *= 16777619u;
+    }
+    size += (unsigned int)n;
+  }
+  return ! file.bad();
+}
+
+static void writeString(vpBinaryArchive &ar, const std::string &str)
+{
+  ar.writeValue((unsigned int)str.size());
+  ar.writeBytes(str.data(), str.size());
+}
+
+static void readString(vpBinaryArchive &ar, std::string &str)
+{
+  unsigned int size;
+  ar.readValue(size);
+  str.resize(size);
+  if (size > 0)
+    ar.readBytes(&str[0], size);
+}
 #endif // DOXYGEN_SHOULD_SKIP_THIS
 
 /*!
@@ -130,11 +179,16 @@ vpMbTracker::vpMbTracker()
 : cam(), cMo(), oJo(6,6), isoJoIdentity(true), modelFileName(), modelInitialised(false),
   poseSavingFilename(), computeCovariance(false), covarianceMatrix(), computeProjError(false),
   projectionError(90.0), displayFeatures(false), m_w(), m_error(), m_optimizationMethod(vpMbTracker::GAUSS_NEWTON_OPT),
+  m_stopCriteriaResidual(1e-8), m_stopCriteriaIncrement(1e-6),
+  m_posePrediction(vpMbTracker::NO_PREDICTION), m_poseKalman(), m_poseKalmanStateVariance(1e-5),
+  m_poseKalmanMeasureVariance(1e-6), m_poseKalmanRho(0.3), m_cMoTracked(), m_cMoTrackedValid(false),
+  m_predictedVelocity(6, 0), m_predictedVelocityValid(false), m_cameraDisplacement(), m_cameraDisplacementValid(false),
+  m_keyFrameDatabase(), m_keyFrameRecording(false),
   faces(), angleAppears( vpMath::rad(89) ), angleDisappears( vpMath::rad(89) ), distNearClip(0.001),
   distFarClip(100), clippingFlag(vpPolygon3D::NO_CLIPPING), useOgre(false), ogreShowConfigDialog(false), useScanLine(false),
   nbPoints(0), nbLines(0), nbPolygonLines(0), nbPolygonPoints(0), nbCylinders(0), nbCircles(0),
   useLodGeneral(false), applyLodSettingInConfig(false), minLineLengthThresholdGeneral(50.0),
-  minPolygonAreaThresholdGeneral(2500.0), mapOfParameterNames()
+  minPolygonAreaThresholdGeneral(2500.0), mapOfParameterNames(), modelCacheDirectory(), modelPrimitives()
 {
     oJo.eye();
     //Map used to parse additional information in CAO model files,
@@ -787,6 +841,150 @@ void vpMbTracker::savePose(const std::string &filename) const
 	finitpos.close();
 }
 
+//! Section tag of a vpMbTracker state in a vpBinaryArchive.
+#define VP_ARCHIVE_TAG_MBT 0x2054424d // "MBT "
+
+/*!
+  Save the tracker state in a binary archive: the current pose, the camera parameters
+  and the tracker settings (visibility angles, clipping, level of detail, optimization
+  method and stop criteria...), including the motion model used to predict the pose
+  and its current state. Contrary to savePose(), which writes a text file, the state can be
+  loaded back in a few microseconds with loadState().
+
+  \code
+  vpBinaryArchive ar("tracker-state.bin", vpBinaryArchive::WRITE);
+  tracker.saveState(ar);
+  \endcode
+
+  \param ar : Archive opened for writing.
+
+  \sa loadState(), vpBinaryArchive
+*/
+void vpMbTracker::saveState(vpBinaryArchive &ar) const
+{
+  ar.writeSection(VP_ARCHIVE_TAG_MBT, 2);
+  ar << cMo << cam << oJo;
+  ar.writeValue((unsigned char)isoJoIdentity);
+  ar.writeValue(angleAppears);
+  ar.writeValue(angleDisappears);
+  ar.writeValue(clippingFlag);
+  ar.writeValue(distNearClip);
+  ar.writeValue(distFarClip);
+  ar.writeValue((unsigned char)useScanLine);
+  ar.writeValue((unsigned char)useLodGeneral);
+  ar.writeValue(minLineLengthThresholdGeneral);
+  ar.writeValue(minPolygonAreaThresholdGeneral);
+  ar.writeValue((unsigned char)computeCovariance);
+  ar.writeValue((unsigned char)computeProjError);
+  ar.writeValue((int)m_optimizationMethod);
+
+  // Added in version 2
+  ar.writeValue(m_stopCriteriaResidual);
+  ar.writeValue(m_stopCriteriaIncrement);
+  ar.writeValue((int)m_posePrediction);
+  ar.writeValue(m_poseKalmanStateVariance);
+  ar.writeValue(m_poseKalmanMeasureVariance);
+  ar.writeValue(m_poseKalmanRho);
+  ar.writeValue((unsigned char)m_cMoTrackedValid);
+  ar << m_cMoTracked;
+  ar.writeValue((unsigned char)m_predictedVelocityValid);
+  ar << m_predictedVelocity;
+  if(m_posePrediction == vpMbTracker::KALMAN_PREDICTION && m_predictedVelocityValid)
+    ar << m_poseKalman.Xest << m_poseKalman.Xpre << m_poseKalman.Pest << m_poseKalman.Ppre;
+}
+
+/*!
+  Load a tracker state saved with saveState(). The model has to be loaded before, since
+  the settings are applied to the model faces. The loaded pose is only available with
+  getPose(); to restart the tracking from this pose, call initFromPose().
+
+  \code
+  tracker.loadModel("cube.cao");
+  vpBinaryArchive ar("tracker-state.bin", vpBinaryArchive::READ);
+  tracker.loadState(ar);
+  tracker.initFromPose(I, tracker.getPose());
+  \endcode
+
+  \param ar : Archive opened for reading.
+
+  \sa saveState(), vpBinaryArchive
+*/
+void vpMbTracker::loadState(vpBinaryArchive &ar)
+{
+  unsigned int version = ar.readSection(VP_ARCHIVE_TAG_MBT, 2);
+
+  vpCameraParameters camera;
+  unsigned char identity;
+  ar >> cMo >> camera >> oJo;
+  ar.readValue(identity);
+  isoJoIdentity = (identity != 0);
+  setCameraParameters(camera);
+
+  unsigned int clipping;
+  double nearClip, farClip, minLineLength, minPolygonArea;
+  unsigned char scanLine, lod, covariance, projError;
+  int optimizationMethod;
+  ar.readValue(angleAppears);
+  ar.readValue(angleDisappears);
+  ar.readValue(clipping);
+  ar.readValue(nearClip);
+  ar.readValue(farClip);
+  ar.readValue(scanLine);
+  ar.readValue(lod);
+  ar.readValue(minLineLength);
+  ar.readValue(minPolygonArea);
+  ar.readValue(covariance);
+  ar.readValue(projError);
+  ar.readValue(optimizationMethod);
+
+  // Reset the clipping first, since near and far distances are checked against each other
+  setClipping(vpPolygon3D::NO_CLIPPING);
+  setFarClippingDistance(farClip);
+  setNearClippingDistance(nearClip);
+  setClipping(clipping);
+
+  setScanLineVisibilityTest(scanLine != 0);
+  useLodGeneral = (lod != 0);
+  minLineLengthThresholdGeneral = minLineLength;
+  minPolygonAreaThresholdGeneral = minPolygonArea;
+  setLod(useLodGeneral);
+  setMinLineLengthThresh(minLineLengthThresholdGeneral);
+  setMinPolygonAreaThresh(minPolygonAreaThresholdGeneral);
+  setCovarianceComputation(covariance != 0);
+  setProjectionErrorComputation(projError != 0);
+  setOptimizationMethod((vpMbtOptimizationMethod)optimizationMethod);
+
+  // Added in version 2, the current stop criteria and motion model are kept with older archives
+  if (version >= 2) {
+    double residualThreshold, incrementThreshold;
+    ar.readValue(residualThreshold);
+    ar.readValue(incrementThreshold);
+    setStopCriteria(residualThreshold, incrementThreshold);
+
+    int posePrediction;
+    unsigned char trackedValid, velocityValid;
+    ar.readValue(posePrediction);
+    ar.readValue(m_poseKalmanStateVariance);
+    ar.readValue(m_poseKalmanMeasureVariance);
+    ar.readValue(m_poseKalmanRho);
+    ar.readValue(trackedValid);
+    ar >> m_cMoTracked;
+    ar.readValue(velocityValid);
+    ar >> m_predictedVelocity;
+    m_posePrediction = (vpMbtPosePredictionMethod)posePrediction;
+    m_cMoTrackedValid = (trackedValid != 0);
+    m_predictedVelocityValid = (velocityValid != 0);
+
+    if(m_posePrediction == vpMbTracker::KALMAN_PREDICTION && m_predictedVelocityValid){
+      initPosePredictionKalman();
+      // The first filtering only initializes the filter, its state is then replaced by the saved one
+      vpColVector v(6, 0);
+      m_poseKalman.filter(v);
+      ar >> m_poseKalman.Xest >> m_poseKalman.Xpre >> m_poseKalman.Pest >> m_poseKalman.Ppre;
+    }
+  }
+}
+
 
 void vpMbTracker::addPolygon(const std::vector<vpPoint>& corners, const int idFace, const std::string &polygonName,
     const bool useLod, const double minPolygonAreaThreshold, const double minLineLengthThreshold)
@@ -985,6 +1183,125 @@ void vpMbTracker::addPolygon(const std::vector<std::vector<vpPoint> > &listFaces
     }
 }
 
+/*!
+  Add a face of the model and initialise its features, with initFaceFromLines() or initFaceFromCorners().
+  The face is recorded to be written in the binary model cache.
+
+  \param corners : Corners of the face.
+  \param idFace : Id of the face.
+  \param polygonName : Name of the face.
+  \param useLod : True if the LOD mode is used for this face.
+  \param minPolygonAreaThreshold : Minimum polygon area threshold for the LOD mode.
+  \param minLineLengthThreshold : Minimum line length threshold for the LOD mode.
+  \param fromLines : True to initialise the face with initFaceFromLines(), false for initFaceFromCorners().
+*/
+void vpMbTracker::addModelFace(const std::vector<vpPoint>& corners, const int idFace, const std::string &polygonName,
+    const bool useLod, const double minPolygonAreaThreshold, const double minLineLengthThreshold, const bool fromLines)
+{
+  addPolygon(corners, idFace, polygonName, useLod, minPolygonAreaThreshold, minLineLengthThreshold);
+  if(fromLines)
+    initFaceFromLines(*(faces.getPolygon().back())); // Init from the last polygon that was added
+  else
+    initFaceFromCorners(*(faces.getPolygon().back())); // Init from the last polygon that was added
+
+  if(! modelCacheDirectory.empty()) {
+    vpMbtModelPrimitive primitive;
+    primitive.type = fromLines ? MODEL_FACE_FROM_LINES : MODEL_FACE_FROM_CORNERS;
+    for(size_t i = 0; i < corners.size(); i++) {
+      primitive.points.push_back(corners[i].get_oX());
+      primitive.points.push_back(corners[i].get_oY());
+      primitive.points.push_back(corners[i].get_oZ());
+    }
+    primitive.idFace = idFace;
+    primitive.name = polygonName;
+    primitive.useLod = useLod;
+    primitive.minPolygonAreaThreshold = minPolygonAreaThreshold;
+    primitive.minLineLengthThreshold = minLineLengthThreshold;
+    primitive.radius = 0;
+    modelPrimitives.push_back(primitive);
+  }
+}
+
+/*!
+  Add a cylinder of the model: its revolution axis and the four faces of its bounding box, with the ids
+  \e idFace to \e idFace + 4, then initialise it with initCylinder().
+  The cylinder is recorded to be written in the binary model cache.
+
+  \param p1 : First point on the axis.
+  \param p2 : Second point on the axis.
+  \param radius : Radius of the cylinder.
+  \param idFace : Id of the revolution axis.
+  \param polygonName : Name of the cylinder.
+  \param useLod : True if the LOD mode is used for this cylinder.
+  \param minLineLengthThreshold : Minimum line length threshold for the LOD mode.
+*/
+void vpMbTracker::addModelCylinder(const vpPoint& p1, const vpPoint &p2, const double radius, const int idFace,
+    const std::string &polygonName, const bool useLod, const double minLineLengthThreshold)
+{
+  addPolygon(p1, p2, idFace, polygonName, useLod, minLineLengthThreshold);
+
+  std::vector<std::vector<vpPoint> > listFaces;
+  createCylinderBBox(p1, p2, radius, listFaces);
+  addPolygon(listFaces, idFace + 1, polygonName, useLod, minLineLengthThreshold);
+
+  initCylinder(p1, p2, radius, idFace, polygonName);
+
+  if(! modelCacheDirectory.empty()) {
+    vpMbtModelPrimitive primitive;
+    primitive.type = MODEL_CYLINDER;
+    const vpPoint *points[2] = { &p1, &p2 };
+    for(unsigned int i = 0; i < 2; i++) {
+      primitive.points.push_back(points[i]->get_oX());
+      primitive.points.push_back(points[i]->get_oY());
+      primitive.points.push_back(points[i]->get_oZ());
+    }
+    primitive.idFace = idFace;
+    primitive.name = polygonName;
+    primitive.useLod = useLod;
+    primitive.minPolygonAreaThreshold = minPolygonAreaThresholdGeneral;
+    primitive.minLineLengthThreshold = minLineLengthThreshold;
+    primitive.radius = radius;
+    modelPrimitives.push_back(primitive);
+  }
+}
+
+/*!
+  Add a circle of the model and initialise it with initCircle().
+  The circle is recorded to be written in the binary model cache.
+
+  \param p1 : Center of the circle.
+  \param p2,p3 : Two points on the plane containing the circle.
+  \param radius : Radius of the circle.
+  \param idFace : Id of the face associated to the circle.
+  \param polygonName : Name of the circle.
+  \param useLod : True if the LOD mode is used for this circle.
+  \param minPolygonAreaThreshold : Minimum polygon area threshold for the LOD mode.
+*/
+void vpMbTracker::addModelCircle(const vpPoint& p1, const vpPoint &p2, const vpPoint &p3, const double radius,
+    const int idFace, const std::string &polygonName, const bool useLod, const double minPolygonAreaThreshold)
+{
+  addPolygon(p1, p2, p3, radius, idFace, polygonName, useLod, minPolygonAreaThreshold);
+  initCircle(p1, p2, p3, radius, idFace, polygonName);
+
+  if(! modelCacheDirectory.empty()) {
+    vpMbtModelPrimitive primitive;
+    primitive.type = MODEL_CIRCLE;
+    const vpPoint *points[3] = { &p1, &p2, &p3 };
+    for(unsigned int i = 0; i < 3; i++) {
+      primitive.points.push_back(points[i]->get_oX());
+      primitive.points.push_back(points[i]->get_oY());
+      primitive.points.push_back(points[i]->get_oZ());
+    }
+    primitive.idFace = idFace;
+    primitive.name = polygonName;
+    primitive.useLod = useLod;
+    primitive.minPolygonAreaThreshold = minPolygonAreaThreshold;
+    primitive.minLineLengthThreshold = minLineLengthThresholdGeneral;
+    primitive.radius = radius;
+    modelPrimitives.push_back(primitive);
+  }
+}
+
 /*!
   Load a 3D model from the file in parameter. This file must either be a vrml
   file (.wrl) or a CAO file (.cao). CAO format is described in the 
@@ -1033,6 +1350,9 @@ int main()
 }
   \endcode
 
+  If a cache directory is set with setModelCacheDirectory(), the model is loaded
+  from its binary version when it is up to date.
+
   \throw vpException::ioError if the file cannot be open, or if its extension is
   not wrl or cao.
 
@@ -1048,25 +1368,55 @@ vpMbTracker::loadModel(const std::string& modelFile, const bool verbose)
   
   if(vpIoTools::checkFilename(modelFile)) {
     it = modelFile.end();
-    if((*(it-1) == 'o' && *(it-2) == 'a' && *(it-3) == 'c' && *(it-4) == '.') ||
-       (*(it-1) == 'O' && *(it-2) == 'A' && *(it-3) == 'C' && *(it-4) == '.') ){
-      std::vector<std::string> vectorOfModelFilename;
-      int startIdFace = (int)faces.size();
-      nbPoints = 0;
-      nbLines = 0;
-      nbPolygonLines = 0;
-      nbPolygonPoints = 0;
-      nbCylinders = 0;
-      nbCircles = 0;
-      loadCAOModel(modelFile, vectorOfModelFilename, startIdFace, verbose, true);
+    bool isCaoModel = (*(it-1) == 'o' && *(it-2) == 'a' && *(it-3) == 'c' && *(it-4) == '.') ||
+                      (*(it-1) == 'O' && *(it-2) == 'A' && *(it-3) == 'C' && *(it-4) == '.');
+    bool isVrmlModel = (*(it-1) == 'l' && *(it-2) == 'r' && *(it-3) == 'w' && *(it-4) == '.') ||
+                       (*(it-1) == 'L' && *(it-2) == 'R' && *(it-3) == 'W' && *(it-4) == '.');
+    if(! isCaoModel && ! isVrmlModel){
+      throw vpException(vpException::ioError, "Error: File %s doesn't contain a cao or wrl model", modelFile.c_str());
     }
-    else if((*(it-1) == 'l' && *(it-2) == 'r' && *(it-3) == 'w' && *(it-4) == '.') ||
-            (*(it-1) == 'L' && *(it-2) == 'R' && *(it-3) == 'W' && *(it-4) == '.') ){
-      loadVRMLModel(modelFile);
+
+    int startIdFace = (int)faces.size();
+
+    // The cache file is named after the hash of the model file
+    std::string cacheFile;
+    bool loadedFromCache = false;
+    unsigned int size, hash;
+    if(! modelCacheDirectory.empty() && computeFileHash(modelFile, size, hash)) {
+      std::ostringstream key;
+      key << std::hex << std::setw(8) << std::setfill('0') << hash;
+      cacheFile = vpIoTools::createFilePath(modelCacheDirectory, vpIoTools::getNameWE(modelFile) + "." + key.str() + ".bin");
+      loadedFromCache = loadModelCache(cacheFile, startIdFace, isCaoModel);
     }
-    else{
-      throw vpException(vpException::ioError, "Error: File %s doesn't contain a cao or wrl model", modelFile.c_str());
+
+    if(loadedFromCache) {
+      if(verbose) {
+        std::cout << "Model loaded from the cache " << cacheFile << std::endl;
+      }
     }
+    else {
+      std::vector<std::string> vectorOfModelFilename;
+      modelPrimitives.clear();
+      if(isCaoModel){
+        int idFace = startIdFace;
+        nbPoints = 0;
+        nbLines = 0;
+        nbPolygonLines = 0;
+        nbPolygonPoints = 0;
+        nbCylinders = 0;
+        nbCircles = 0;
+        loadCAOModel(modelFile, vectorOfModelFilename, idFace, verbose, true);
+      }
+      else{
+        vectorOfModelFilename.push_back(modelFile);
+        loadVRMLModel(modelFile);
+      }
+
+      if(! cacheFile.empty()) {
+        saveModelCache(cacheFile, vectorOfModelFilename, startIdFace, isCaoModel);
+      }
+    }
+    modelPrimitives.clear();
   }
   else{
     throw vpException(vpException::ioError, "Error: File %s doesn't exist", modelFile.c_str());
@@ -1076,6 +1426,225 @@ vpMbTracker::loadModel(const std::string& modelFile, const bool verbose)
   this->modelFileName = modelFile;
 }
 
+/*!
+  Set the directory of the binary model cache. When it is set, loadModel() looks in this directory
+  for a binary version of the model, named after the hash of the model file.
+  - If it exists and if the model files (including the files included by a CAO model) and the LOD
+    settings did not change since it was written, the model is loaded from it without parsing the
+    model files. A vrml model loaded from the cache does not need Coin.
+  - Otherwise, the model files are parsed and the cache is written for the next loads.
+
+  Starting several trackers on the same model then only parses the model files once.
+
+  \param directory : Directory of the cache, created if needed. If empty, the cache is not used.
+
+  \sa loadModel(), getModelCacheDirectory()
+*/
+void
+vpMbTracker::setModelCacheDirectory(const std::string &directory)
+{
+  modelCacheDirectory = directory;
+}
+
+//! Section tag of a model in the binary model cache.
+#define VP_ARCHIVE_TAG_MBT_MODEL 0x4d54424d // "MBTM"
+
+/*!
+  Load the model from the binary model cache.
+
+  \param cacheFile : Cache file.
+  \param startIdFace : Id of the first face of the model.
+  \param isCaoModel : True if the model is a CAO model, false if it is a vrml model.
+
+  \return true if the model was loaded, false if the cache file does not exist, cannot be read or is out of date.
+  In that case, the model is not modified.
+*/
+bool
+vpMbTracker::loadModelCache(const std::string &cacheFile, const int startIdFace, const bool isCaoModel)
+{
+  if(! vpIoTools::checkFilename(cacheFile))
+    return false;
+
+  std::vector<vpMbtModelPrimitive> primitives;
+  unsigned int counters[6];
+  try {
+    vpBinaryArchive ar(cacheFile, vpBinaryArchive::READ);
+    ar.readSection(VP_ARCHIVE_TAG_MBT_MODEL, 1);
+
+    unsigned int nbFiles;
+    ar.readValue(nbFiles);
+    for(unsigned int i = 0; i < nbFiles; i++) {
+      std::string filename;
+      unsigned int size, hash, currentSize, currentHash;
+      readString(ar, filename);
+      ar.readValue(size);
+      ar.readValue(hash);
+      if(! computeFileHash(filename, currentSize, currentHash) || currentSize != size || currentHash != hash)
+        return false;
+    }
+
+    // The LOD settings are applied to the primitives while parsing the model
+    unsigned char caoModel, lod, applyLodSetting;
+    double minLineLength, minPolygonArea;
+    ar.readValue(caoModel);
+    ar.readValue(lod);
+    ar.readValue(applyLodSetting);
+    ar.readValue(minLineLength);
+    ar.readValue(minPolygonArea);
+    if((caoModel != 0) != isCaoModel || (lod != 0) != useLodGeneral || (applyLodSetting != 0) != applyLodSettingInConfig
+       || std::fabs(minLineLength - minLineLengthThresholdGeneral) > std::numeric_limits<double>::epsilon()
+       || std::fabs(minPolygonArea - minPolygonAreaThresholdGeneral) > std::numeric_limits<double>::epsilon())
+      return false;
+
+    ar.readValues(counters, 6);
+
+    unsigned int nbPrimitives;
+    ar.readValue(nbPrimitives);
+    primitives.resize(nbPrimitives);
+    for(unsigned int i = 0; i < nbPrimitives; i++) {
+      vpMbtModelPrimitive &primitive = primitives[i];
+      unsigned char type, useLod;
+      unsigned int nbValues;
+      ar.readValue(type);
+      ar.readValue(primitive.idFace);
+      readString(ar, primitive.name);
+      ar.readValue(useLod);
+      ar.readValue(primitive.minPolygonAreaThreshold);
+      ar.readValue(primitive.minLineLengthThreshold);
+      ar.readValue(primitive.radius);
+      ar.readValue(nbValues);
+      primitive.type = (vpMbtModelPrimitiveType)type;
+      primitive.useLod = (useLod != 0);
+      primitive.points.resize(nbValues);
+      if(nbValues > 0)
+        ar.readValues(&primitive.points[0], nbValues);
+
+      if(type > MODEL_CIRCLE || nbValues % 3 != 0 || (type == MODEL_CYLINDER && nbValues != 6)
+         || (type == MODEL_CIRCLE && nbValues != 9) || nbValues == 0)
+        return false;
+    }
+  }
+  catch(vpException &) {
+    return false;
+  }
+
+  if(isCaoModel) {
+    nbPoints = counters[0];
+    nbLines = counters[1];
+    nbPolygonLines = counters[2];
+    nbPolygonPoints = counters[3];
+    nbCylinders = counters[4];
+    nbCircles = counters[5];
+  }
+
+  for(size_t i = 0; i < primitives.size(); i++) {
+    const vpMbtModelPrimitive &primitive = primitives[i];
+    std::vector<vpPoint> points(primitive.points.size() / 3);
+    for(size_t j = 0; j < points.size(); j++)
+      points[j].setWorldCoordinates(primitive.points[3*j], primitive.points[3*j+1], primitive.points[3*j+2]);
+
+    const int idFace = startIdFace + primitive.idFace;
+    switch(primitive.type) {
+    case MODEL_FACE_FROM_LINES:
+    case MODEL_FACE_FROM_CORNERS:
+      addModelFace(points, idFace, primitive.name, primitive.useLod, primitive.minPolygonAreaThreshold,
+                   primitive.minLineLengthThreshold, primitive.type == MODEL_FACE_FROM_LINES);
+      break;
+    case MODEL_CYLINDER:
+      addModelCylinder(points[0], points[1], primitive.radius, idFace, primitive.name, primitive.useLod,
+                       primitive.minLineLengthThreshold);
+      break;
+    case MODEL_CIRCLE:
+      addModelCircle(points[0], points[1], points[2], primitive.radius, idFace, primitive.name, primitive.useLod,
+                     primitive.minPolygonAreaThreshold);
+      break;
+    }
+  }
+
+  return true;
+}
+
+/*!
+  Write the model that was just parsed in the binary model cache. An error while writing the
+  cache is reported but does not prevent the tracking.
+
+  \param cacheFile : Cache file.
+  \param vectorOfModelFilename : Files the model was parsed from.
+  \param startIdFace : Id of the first face of the model.
+  \param isCaoModel : True if the model is a CAO model, false if it is a vrml model.
+*/
+void
+vpMbTracker::saveModelCache(const std::string &cacheFile, const std::vector<std::string> &vectorOfModelFilename,
+                            const int startIdFace, const bool isCaoModel) const
+{
+  // The cache is renamed once complete, so that it is never read partially written by another tracker.
+  // The temporary file is specific to the process and to the tracker, as several of them may write the cache.
+  std::ostringstream tmpName;
+#if defined(_WIN32)
+  tmpName << cacheFile << ".tmp." << _getpid() << "." << (const void *)this;
+#else
+  tmpName << cacheFile << ".tmp." << getpid() << "." << (const void *)this;
+#endif
+  const std::string tmpFile = tmpName.str();
+
+  try {
+    if(! vpIoTools::checkDirectory(modelCacheDirectory))
+      vpIoTools::makeDirectory(modelCacheDirectory);
+
+    {
+      vpBinaryArchive ar(tmpFile, vpBinaryArchive::WRITE);
+      ar.writeSection(VP_ARCHIVE_TAG_MBT_MODEL, 1);
+
+      ar.writeValue((unsigned int)vectorOfModelFilename.size());
+      for(size_t i = 0; i < vectorOfModelFilename.size(); i++) {
+        unsigned int size, hash;
+        if(! computeFileHash(vectorOfModelFilename[i], size, hash)) {
+          throw vpException(vpException::ioError, "Cannot read %s", vectorOfModelFilename[i].c_str());
+        }
+        writeString(ar, vectorOfModelFilename[i]);
+        ar.writeValue(size);
+        ar.writeValue(hash);
+      }
+
+      ar.writeValue((unsigned char)isCaoModel);
+      ar.writeValue((unsigned char)useLodGeneral);
+      ar.writeValue((unsigned char)applyLodSettingInConfig);
+      ar.writeValue(minLineLengthThresholdGeneral);
+      ar.writeValue(minPolygonAreaThresholdGeneral);
+
+      unsigned int counters[6] = { nbPoints, nbLines, nbPolygonLines, nbPolygonPoints, nbCylinders, nbCircles };
+      ar.writeValues(counters, 6);
+
+      ar.writeValue((unsigned int)modelPrimitives.size());
+      for(size_t i = 0; i < modelPrimitives.size(); i++) {
+        const vpMbtModelPrimitive &primitive = modelPrimitives[i];
+        ar.writeValue((unsigned char)primitive.type);
+        ar.writeValue(primitive.idFace - startIdFace);
+        writeString(ar, primitive.name);
+        ar.writeValue((unsigned char)primitive.useLod);
+        ar.writeValue(primitive.minPolygonAreaThreshold);
+        ar.writeValue(primitive.minLineLengthThreshold);
+        ar.writeValue(primitive.radius);
+        ar.writeValue((unsigned int)primitive.points.size());
+        if(! primitive.points.empty())
+          ar.writeValues(&primitive.points[0], primitive.points.size());
+      }
+    }
+
+    if(std::rename(tmpFile.c_str(), cacheFile.c_str()) != 0) {
+      // Under Windows, an existing file is not replaced
+      std::remove(cacheFile.c_str());
+      if(std::rename(tmpFile.c_str(), cacheFile.c_str()) != 0) {
+        throw vpException(vpException::ioError, "Cannot rename %s", tmpFile.c_str());
+      }
+    }
+  }
+  catch(vpException &e) {
+    std::remove(tmpFile.c_str());
+    std::cerr << "Cannot write the model cache " << cacheFile << ": " << e.getMessage() << std::endl;
+  }
+}
+
 
 /*!
   Load the 3D model of the object from a vrml file. Only LineSet and FaceSet are
@@ -1568,18 +2137,15 @@ vpMbTracker::loadCAOModel(const std::string& modelFile,
             useLod = parseBoolean(mapOfParams["useLod"]);
           }
 
-          addPolygon(corners, idFace++, polygonName, useLod, minPolygonAreaThreshold, minLineLengthThresholdGeneral);
-      //      initFaceFromCorners(*(faces.getPolygon().back())); // Init from the last polygon that was added
-          initFaceFromLines(*(faces.getPolygon().back())); // Init from the last polygon that was added
+          addModelFace(corners, idFace++, polygonName, useLod, minPolygonAreaThreshold, minLineLengthThresholdGeneral, true);
       }
 
       //Add the segments which were not already added in the face segment case
       for(std::map<std::pair<unsigned int, unsigned int>, SegmentInfo >::const_iterator it =
           segmentTemporaryMap.begin(); it != segmentTemporaryMap.end(); ++it) {
         if(std::find(faceSegmentKeyVector.begin(), faceSegmentKeyVector.end(), it->first) == faceSegmentKeyVector.end()) {
-          addPolygon(it->second.extremities, idFace++, it->second.name, it->second.useLod, minPolygonAreaThresholdGeneral,
-              it->second.minLineLengthThresh);
-          initFaceFromCorners(*(faces.getPolygon().back())); // Init from the last polygon that was added
+          addModelFace(it->second.extremities, idFace++, it->second.name, it->second.useLod, minPolygonAreaThresholdGeneral,
+              it->second.minLineLengthThresh, false);
         }
       }
 
@@ -1646,8 +2212,7 @@ vpMbTracker::loadCAOModel(const std::string& modelFile,
           }
 
 
-          addPolygon(corners, idFace++, polygonName, useLod, minPolygonAreaThreshold, minLineLengthThresholdGeneral);
-          initFaceFromCorners(*(faces.getPolygon().back())); // Init from the last polygon that was added
+          addModelFace(corners, idFace++, polygonName, useLod, minPolygonAreaThreshold, minLineLengthThresholdGeneral, false);
       }
 
       //////////////////////////Read the cylinder declaration part//////////////////////////
@@ -1706,15 +2271,9 @@ vpMbTracker::loadCAOModel(const std::string& modelFile,
                 useLod = parseBoolean(mapOfParams["useLod"]);
               }
 
-              int idRevolutionAxis = idFace;
-              addPolygon(caoPoints[indexP1], caoPoints[indexP2], idFace++, polygonName, useLod, minLineLengthThreshold);
-
-              std::vector<std::vector<vpPoint> > listFaces;
-              createCylinderBBox(caoPoints[indexP1], caoPoints[indexP2], radius,listFaces);
-              addPolygon(listFaces, idFace, polygonName, useLod, minLineLengthThreshold);
-              idFace+=4;
-
-              initCylinder(caoPoints[indexP1], caoPoints[indexP2], radius, idRevolutionAxis, polygonName);
+              // The revolution axis and the 4 faces of the bounding box
+              addModelCylinder(caoPoints[indexP1], caoPoints[indexP2], radius, idFace, polygonName, useLod, minLineLengthThreshold);
+              idFace+=5;
           }
 
       } catch (...) {
@@ -1782,11 +2341,8 @@ vpMbTracker::loadCAOModel(const std::string& modelFile,
                 useLod = parseBoolean(mapOfParams["useLod"]);
               }
 
-              addPolygon(caoPoints[indexP1], caoPoints[indexP2],
-                      caoPoints[indexP3], radius, idFace, polygonName, useLod, minPolygonAreaThreshold);
-
-              initCircle(caoPoints[indexP1], caoPoints[indexP2],
-                      caoPoints[indexP3], radius, idFace++, polygonName);
+              addModelCircle(caoPoints[indexP1], caoPoints[indexP2],
+                      caoPoints[indexP3], radius, idFace++, polygonName, useLod, minPolygonAreaThreshold);
           }
 
       } catch (...) {
@@ -1942,8 +2498,7 @@ vpMbTracker::extractFaces(SoVRMLIndexedFaceSet* face_set, vpHomogeneousMatrix &t
     {
       if(corners.size() > 1)
       {
-        addPolygon(corners, idFace++, polygonName);
-        initFaceFromCorners(*(faces.getPolygon().back())); // Init from the last polygon that was added
+        addModelFace(corners, idFace++, polygonName, false, 2500.0, 50.0, false);
         corners.resize(0);
       }
     }
@@ -2036,15 +2591,9 @@ vpMbTracker::extractCylinders(SoVRMLIndexedFaceSet* face_set, vpHomogeneousMatri
   //addPolygon(p1, p2, idFace, polygonName);
   //initCylinder(p1, p2, radius_c1, idFace++);
 
-  int idRevolutionAxis = idFace;
-  addPolygon(p1, p2, idFace++, polygonName);
-
-  std::vector<std::vector<vpPoint> > listFaces;
-  createCylinderBBox(p1, p2, radius_c1, listFaces);
-  addPolygon(listFaces, idFace, polygonName);
-  idFace+=4;
-
-  initCylinder(p1, p2, radius_c1, idRevolutionAxis, polygonName);
+  // The revolution axis and the 4 faces of the bounding box
+  addModelCylinder(p1, p2, radius_c1, idFace, polygonName, false, 50.0);
+  idFace+=5;
 }
 
 /*!
@@ -2073,8 +2622,7 @@ vpMbTracker::extractLines(SoVRMLIndexedLineSet* line_set, int &idFace, const std
     {
       if(corners.size() > 1)
       {
-        addPolygon(corners, idFace++, polygonName);
-        initFaceFromCorners(*(faces.getPolygon().back())); // Init from the last polygon that was added
+        addModelFace(corners, idFace++, polygonName, false, 2500.0, 50.0, false);
         corners.resize(0);
       }
     }
@@ -2381,6 +2929,222 @@ vpMbTracker::computeJTR(const vpMatrix& interaction, const vpColVector& error, v
   }
 }
 
+/*!
+  Set the motion model used to predict the pose before the tracking of each
+  new image. The prediction brings the initial pose of the minimization and
+  the moving edges closer to their position in the new image, so that the
+  number of iterations decreases and a smaller moving edges range (see
+  vpMe::setRange() and vpMe::setAdaptiveRange()) can be used for the same
+  camera motion.
+
+  - NO_PREDICTION: the tracking starts from the previous pose.
+  - CONSTANT_VELOCITY_PREDICTION: the displacement of the camera between the
+    last two images is applied again.
+  - KALMAN_PREDICTION: the velocity of the camera is filtered with a constant
+    velocity model with colored noise (see vpLinearKalmanFilterInstantiation
+    and setPosePredictionKalmanParameters()), which is more robust to the
+    noise of the estimated poses.
+
+  The motion model is reset when the pose is modified outside of the
+  tracking, for instance by initFromPose() or setPose().
+
+  \param method : Motion model. Default is NO_PREDICTION.
+
+  \sa setCameraVelocity()
+*/
+void
+vpMbTracker::setPosePrediction(const vpMbtPosePredictionMethod &method)
+{
+  m_posePrediction = method;
+  resetPosePrediction();
+}
+
+/*!
+  Set the parameters of the Kalman filter of the camera velocity used by the
+  KALMAN_PREDICTION motion model. The velocity is expressed as the
+  displacement of the camera between two images (meter and radian).
+
+  \param stateVariance : Variance of the acceleration of the camera.
+  \param measureVariance : Variance of the velocity measured by the tracking.
+  \param rho : Degree of correlation between successive accelerations, in
+  [0, 1[.
+
+  \exception vpException::badValue : If \e rho is not in [0, 1[ or if a
+  variance is negative.
+
+  \sa setPosePrediction()
+*/
+void
+vpMbTracker::setPosePredictionKalmanParameters(const double stateVariance, const double measureVariance,
+                                               const double rho)
+{
+  if(rho < 0 || rho >= 1 || stateVariance < 0 || measureVariance < 0)
+    throw vpException(vpException::badValue, "Bad Kalman filter parameters for the pose prediction");
+
+  m_poseKalmanStateVariance = stateVariance;
+  m_poseKalmanMeasureVariance = measureVariance;
+  m_poseKalmanRho = rho;
+  resetPosePrediction();
+}
+
+/*!
+  Give the velocity of the camera measured by another sensor, typically the
+  velocity of a robot that carries the camera. The corresponding
+  displacement is applied to the pose before the next call to track(), in
+  place of the prediction of the motion model. The velocity is only used
+  once, it has to be given again before each image.
+
+  \param v : Velocity of the camera \f$(v_x, v_y, v_z, \omega_x, \omega_y,
+  \omega_z)\f$ expressed in the camera frame (m/s and rad/s).
+  \param dt : Time between the previous image and the next one (s).
+
+  \exception vpException::dimensionError : If \e v is not of size 6.
+
+  \sa setPosePrediction()
+*/
+void
+vpMbTracker::setCameraVelocity(const vpColVector &v, const double dt)
+{
+  if(v.getRows() != 6)
+    throw vpException(vpException::dimensionError, "The camera velocity must be of size 6");
+
+  m_cameraDisplacement = vpExponentialMap::direct(v, dt).inverse();
+  m_cameraDisplacementValid = true;
+}
+
+/*!
+  Forget the motion of the camera used to predict the pose: the next image
+  is tracked from the current pose, and the motion model starts again from
+  the following one.
+*/
+void
+vpMbTracker::resetPosePrediction()
+{
+  m_cMoTrackedValid = false;
+  m_predictedVelocity = 0;
+  m_predictedVelocityValid = false;
+}
+
+/*!
+  Initialize the Kalman filter of the camera velocity with the parameters set
+  with setPosePredictionKalmanParameters().
+*/
+void
+vpMbTracker::initPosePredictionKalman()
+{
+  vpColVector sigma_state(12, 0);
+  vpColVector sigma_measure(6, m_poseKalmanMeasureVariance);
+  for(unsigned int i = 0; i < 6; i++)
+    sigma_state[2*i+1] = m_poseKalmanStateVariance;
+  m_poseKalman.setStateModel(vpLinearKalmanFilterInstantiation::stateConstVelWithColoredNoise_MeasureVel);
+  m_poseKalman.initStateConstVelWithColoredNoise_MeasureVel(6, sigma_state, sigma_measure, m_poseKalmanRho);
+}
+
+/*!
+  Predict the pose of the camera in the next image, before its tracking. The
+  displacement given by setCameraVelocity() is used if any, otherwise the one
+  of the motion model selected with setPosePrediction().
+
+  \return true if the pose was modified.
+*/
+bool
+vpMbTracker::predictPose()
+{
+  // A pose set outside of the tracking breaks the motion model
+  if(m_cMoTrackedValid){
+    for(unsigned int i = 0; i < 3 && m_cMoTrackedValid; i++)
+      for(unsigned int j = 0; j < 4; j++)
+        if(cMo[i][j] != m_cMoTracked[i][j]){
+          resetPosePrediction();
+          break;
+        }
+  }
+
+  bool predicted = false;
+  if(m_cameraDisplacementValid){
+    cMo = m_cameraDisplacement * cMo;
+    m_cameraDisplacementValid = false;
+    predicted = true;
+  }
+  else if(m_posePrediction != vpMbTracker::NO_PREDICTION && m_predictedVelocityValid){
+    cMo = vpExponentialMap::direct(m_predictedVelocity).inverse() * cMo;
+    predicted = true;
+  }
+
+  return predicted;
+}
+
+/*!
+  Update the motion model with the pose estimated by the tracking of the
+  current image. It has to be called at the end of a successful tracking.
+*/
+void
+vpMbTracker::updatePosePrediction()
+{
+  if(m_posePrediction != vpMbTracker::NO_PREDICTION && m_cMoTrackedValid){
+    // Displacement of the camera between the previous and the current images
+    vpColVector v = vpExponentialMap::inverse(m_cMoTracked * cMo.inverse());
+
+    if(m_posePrediction == vpMbTracker::KALMAN_PREDICTION){
+      if(! m_predictedVelocityValid)
+        initPosePredictionKalman();
+      m_poseKalman.filter(v);
+      for(unsigned int i = 0; i < 6; i++)
+        m_predictedVelocity[i] = m_poseKalman.Xpre[2*i];
+    }
+    else {
+      m_predictedVelocity = v;
+    }
+    m_predictedVelocityValid = true;
+  }
+
+  m_cMoTracked = cMo;
+  m_cMoTrackedValid = true;
+}
+
+/*!
+  Add a keyframe to the keyframe database if the recording is enabled and if
+  the current pose is far enough from the recorded keyframes. It has to be
+  called at the end of a successful tracking.
+
+  \param I : The current image.
+
+  \sa setKeyFrameRecording()
+*/
+void
+vpMbTracker::recordKeyFrame(const vpImage<unsigned char> &I)
+{
+  if(! m_keyFrameRecording || ! m_keyFrameDatabase.isNewKeyFrame(cMo))
+    return;
+
+  m_keyFrameDatabase.addKeyFrame(I, cam, cMo, getPolygonFaces(true, true));
+}
+
+/*!
+  Recover the pose of the object after a tracking failure, without user
+  interaction. The pose is computed from the keyframes recorded during the
+  tracking (see setKeyFrameRecording()) or loaded in the keyframe database
+  (see getKeyFrameDatabase()), and the tracker is initialized at this pose
+  with initFromPose().
+
+  When the relocalization fails, it can be tried again on the next images.
+
+  \param I : The current image.
+
+  \return true if the tracker is initialized at the recovered pose.
+*/
+bool
+vpMbTracker::relocalize(const vpImage<unsigned char> &I)
+{
+  vpHomogeneousMatrix cMo_;
+  if(! m_keyFrameDatabase.localize(I, cam, cMo_))
+    return false;
+
+  initFromPose(I, cMo_);
+  resetPosePrediction();
+  return true;
+}
+
 /*!
   Get a 1x6 vpColVector representing the estimated degrees of freedom.
   vpColVector[0] = 1 if translation on X is estimated, 0 otherwise;
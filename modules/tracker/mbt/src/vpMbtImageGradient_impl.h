@@ -0,0 +1,101 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Image gradient used to compute the projection error of the edge features.
+ *
+ *****************************************************************************/
+
+#ifndef __vpMbtImageGradient_impl_h_
+#define __vpMbtImageGradient_impl_h_
+
+#include <cmath>
+
+#include <visp3/core/vpImage.h>
+
+/*
+  Gradient of the image at a site, computed with the 5x5 Sobel-like filters
+  (smoothing [1 4 6 4 1] times derivative [-1 -2 0 2 1]) used by the
+  projection error. The filters are separable, so each row of the
+  neighbourhood is read once. The pixels outside the image are replaced by the
+  nearest border pixel.
+
+  gradI is the derivative along the rows (i axis), gradJ along the columns
+  (j axis).
+*/
+inline void vpMbtImageGradient(const vpImage<unsigned char> &I, const double iSite, const double jSite,
+                               double &gradI, double &gradJ)
+{
+  static const int smooth[5] = { 1, 4, 6, 4, 1 };
+  static const int deriv[5] = { -1, -2, 0, 2, 1 };
+
+  const int height = (int)I.getHeight();
+  const int width = (int)I.getWidth();
+  const int i0 = (int)std::floor(iSite) - 2;
+  const int j0 = (int)std::floor(jSite) - 2;
+
+  int cols[5];
+  for (int l = 0; l < 5; l++) {
+    int j = j0 + l;
+    cols[l] = j < 0 ? 0 : (j > width - 1 ? width - 1 : j);
+  }
+
+  int sumI = 0, sumJ = 0;
+  for (int k = 0; k < 5; k++) {
+    int i = i0 + k;
+    const unsigned char *row = I[i < 0 ? 0 : (i > height - 1 ? height - 1 : i)];
+    int p0 = row[cols[0]], p1 = row[cols[1]], p2 = row[cols[2]], p3 = row[cols[3]], p4 = row[cols[4]];
+    int rowSmooth = p0 + 4*p1 + 6*p2 + 4*p3 + p4;
+    int rowDeriv = p4 - p0 + 2*(p3 - p1);
+    sumI += deriv[k] * rowSmooth;
+    sumJ += smooth[k] * rowDeriv;
+  }
+
+  gradI = (double)sumI;
+  gradJ = (double)sumJ;
+}
+
+/*
+  Angle in [0, M_PI/2] between the direction (cos(theta), sin(theta)) and the
+  gradient direction (u, v), the gradient sign being ignored. A null gradient
+  is considered as the direction (1, 0).
+*/
+inline double vpMbtGradientAngleError(const double cosTheta, const double sinTheta, double u, double v)
+{
+  double norm = std::sqrt(u*u + v*v);
+  if (norm <= 0) {
+    u = 1;
+    v = 0;
+    norm = 1;
+  }
+  double c = std::fabs(cosTheta*u + sinTheta*v) / norm;
+  return std::acos(c > 1 ? 1 : c);
+}
+
+#endif
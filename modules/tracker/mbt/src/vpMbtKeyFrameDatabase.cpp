@@ -0,0 +1,794 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Database of keyframes used to relocalize the model-based trackers.
+ *
+ *****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <visp3/core/vpException.h>
+#include <visp3/core/vpMath.h>
+#include <visp3/core/vpPixelMeterConversion.h>
+#include <visp3/core/vpThetaUVector.h>
+#include <visp3/vision/vpPose.h>
+#include <visp3/mbt/vpMbtKeyFrameDatabase.h>
+
+#define VP_ARCHIVE_TAG_MBT_KEYFRAMES 0x464b424d // "MBKF"
+
+namespace {
+// Circle of radius 3 of the FAST detector (dx, dy)
+const int fastCircle[16][2] = { {0, -3}, {1, -3}, {2, -2}, {3, -1}, {3, 0}, {3, 1}, {2, 2}, {1, 3},
+                                {0, 3}, {-1, 3}, {-2, 2}, {-3, 1}, {-3, 0}, {-3, -1}, {-2, -2}, {-1, -3} };
+
+// Radius of the disk in which the pairs of the descriptor are sampled
+const int patternRadius = 13;
+
+// Minimal distance in pixel between a keypoint and the border of its face
+const double faceBorderDistance = 7.0;
+
+// Maximal number of RANSAC iterations of a localization
+const int ransacMaxTrials = 200;
+
+struct vpFastCorner
+{
+  int i;
+  int j;
+  int score;
+};
+
+bool compareFastCorners(const vpFastCorner &c1, const vpFastCorner &c2)
+{
+  return c1.score > c2.score;
+}
+
+struct vpDescriptorMatch
+{
+  unsigned int keyFrame;
+  unsigned int point;
+  unsigned int distance;
+};
+
+bool compareDescriptorMatches(const vpDescriptorMatch &m1, const vpDescriptorMatch &m2)
+{
+  if (m1.keyFrame != m2.keyFrame)
+    return m1.keyFrame < m2.keyFrame;
+  return m1.distance < m2.distance;
+}
+
+bool compareHashKeys(const std::pair<unsigned int, unsigned int> &e1, const std::pair<unsigned int, unsigned int> &e2)
+{
+  return e1.first < e2.first;
+}
+
+// True if the circular 16 bits mask contains 9 consecutive bits
+bool hasArc(const unsigned int mask)
+{
+  unsigned int m = mask | (mask << 16);
+  unsigned int arc = m;
+  for (unsigned int k = 1; k < 9; k++)
+    arc &= m >> k;
+  return arc != 0;
+}
+
+// Uniform pseudo-random number in [0, 1[, independent of rand()
+double patternRandom(unsigned int &seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return ((seed >> 16) & 0x7fff) / 32768.0;
+}
+
+double distanceToSegment(const vpImagePoint &ip, const vpImagePoint &ip1, const vpImagePoint &ip2)
+{
+  double di = ip2.get_i() - ip1.get_i();
+  double dj = ip2.get_j() - ip1.get_j();
+  double length2 = di*di + dj*dj;
+  double t = 0;
+  if (length2 > 0) {
+    t = ((ip.get_i() - ip1.get_i())*di + (ip.get_j() - ip1.get_j())*dj) / length2;
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+  }
+  return sqrt(vpMath::sqr(ip1.get_i() + t*di - ip.get_i()) + vpMath::sqr(ip1.get_j() + t*dj - ip.get_j()));
+}
+}
+
+/*!
+  Create an empty database.
+*/
+vpMbtKeyFrameDatabase::vpMbtKeyFrameDatabase()
+  : m_fastThreshold(10), m_maxKeyPoints(500), m_maxKeyFrames(200), m_keyFrameTranslationRatio(0.05),
+    m_keyFrameRotation(vpMath::rad(10)), m_maxHammingDistance(64), m_matchingRatio(0.8), m_minInliers(15),
+    m_ransacThreshold(3.0), m_nbKeyFrameCandidates(3), m_patterns(), m_patchHalfWidth(), m_keyFramePoses(),
+    m_pointKeyFrame(), m_points(), m_descriptors()
+{
+  // Pairs of pixels sampled with an isotropic gaussian distribution in the
+  // patch, with a fixed seed so that the descriptors can be saved
+  const unsigned int nbBits = 8*DESCRIPTOR_SIZE;
+  const double sigma = (2*PATCH_RADIUS + 1) / 5.0;
+  std::vector<double> pairs(4*nbBits);
+  unsigned int seed = 0x5eed;
+  for (unsigned int b = 0; b < nbBits; b++) {
+    double *p = &pairs[4*b];
+    do {
+      for (unsigned int k = 0; k < 4; k++)
+        p[k] = vpMath::round((patternRandom(seed) + patternRandom(seed) + patternRandom(seed) + patternRandom(seed) - 2.0)
+                             * sqrt(3.0) * sigma);
+    } while (p[0]*p[0] + p[1]*p[1] > patternRadius*patternRadius || p[2]*p[2] + p[3]*p[3] > patternRadius*patternRadius
+             || (p[0] == p[2] && p[1] == p[3]));
+  }
+
+  m_patterns.resize(NB_ORIENTATIONS*4*nbBits);
+  for (unsigned int o = 0; o < NB_ORIENTATIONS; o++) {
+    double angle = 2*M_PI*o / NB_ORIENTATIONS;
+    double c = cos(angle), s = sin(angle);
+    int *pattern = &m_patterns[o*4*nbBits];
+    for (unsigned int b = 0; b < nbBits; b++) {
+      const double *p = &pairs[4*b];
+      pattern[4*b]   = vpMath::round(c*p[0] - s*p[1]);
+      pattern[4*b+1] = vpMath::round(s*p[0] + c*p[1]);
+      pattern[4*b+2] = vpMath::round(c*p[2] - s*p[3]);
+      pattern[4*b+3] = vpMath::round(s*p[2] + c*p[3]);
+    }
+  }
+
+  m_patchHalfWidth.resize(2*PATCH_RADIUS + 1);
+  for (int dy = -PATCH_RADIUS; dy <= PATCH_RADIUS; dy++)
+    m_patchHalfWidth[(unsigned int)(dy + PATCH_RADIUS)] = (int)floor(sqrt((double)(PATCH_RADIUS*PATCH_RADIUS - dy*dy)));
+}
+
+/*!
+  Add a keyframe to the database. The keypoints of the image that do not lie
+  on a face of the model, or that are too close to the border of their face,
+  are not kept.
+
+  \param I : Image at the pose of the keyframe.
+  \param cam : Camera parameters.
+  \param cMo : Pose of the camera.
+  \param faces : Visible faces of the model: their projection in the image,
+  and their corners with their coordinates in the camera frame, ordered from
+  the nearest to the farthest (see vpMbTracker::getPolygonFaces()).
+
+  \return true if the keyframe is added, false if the maximal number of
+  keyframes is reached or if not enough keypoints lie on the model.
+*/
+bool vpMbtKeyFrameDatabase::addKeyFrame(const vpImage<unsigned char> &I, const vpCameraParameters &cam,
+                                        const vpHomogeneousMatrix &cMo,
+                                        const std::pair<std::vector<vpPolygon>, std::vector<std::vector<vpPoint> > > &faces)
+{
+  if (m_keyFramePoses.size() >= m_maxKeyFrames)
+    return false;
+
+  std::vector<vpImagePoint> keyPoints;
+  std::vector<unsigned char> descriptors;
+  extract(I, keyPoints, descriptors);
+
+  // Plane n.P = d of each face in the camera frame
+  std::vector<vpPolygon> polygons = faces.first;
+  std::vector<double> planes(4*polygons.size(), 0.0);
+  for (size_t f = 0; f < polygons.size(); f++) {
+    const std::vector<vpPoint> &corners = faces.second[f];
+    double *plane = &planes[4*f];
+    for (size_t k = 2; k < corners.size(); k++) {
+      double u[3] = { corners[1].get_X() - corners[0].get_X(), corners[1].get_Y() - corners[0].get_Y(),
+                      corners[1].get_Z() - corners[0].get_Z() };
+      double v[3] = { corners[k].get_X() - corners[0].get_X(), corners[k].get_Y() - corners[0].get_Y(),
+                      corners[k].get_Z() - corners[0].get_Z() };
+      plane[0] = u[1]*v[2] - u[2]*v[1];
+      plane[1] = u[2]*v[0] - u[0]*v[2];
+      plane[2] = u[0]*v[1] - u[1]*v[0];
+      if (plane[0]*plane[0] + plane[1]*plane[1] + plane[2]*plane[2] > std::numeric_limits<double>::epsilon())
+        break;
+    }
+    if (corners.size() >= 3)
+      plane[3] = plane[0]*corners[0].get_X() + plane[1]*corners[0].get_Y() + plane[2]*corners[0].get_Z();
+  }
+
+  vpHomogeneousMatrix oMc = cMo.inverse();
+  std::vector<unsigned int> kept;
+  std::vector<double> points;
+  for (size_t k = 0; k < keyPoints.size(); k++) {
+    for (size_t f = 0; f < polygons.size(); f++) {
+      if (! polygons[f].isInside(keyPoints[k]))
+        continue;
+
+      // The nearest face containing the keypoint hides the other ones
+      const double *plane = &planes[4*f];
+      double x = 0, y = 0;
+      vpPixelMeterConversion::convertPoint(cam, keyPoints[k], x, y);
+      double den = plane[0]*x + plane[1]*y + plane[2];
+      if (std::fabs(den) < std::numeric_limits<double>::epsilon())
+        break;
+      double Z = plane[3] / den;
+      if (Z <= 0)
+        break;
+
+      // Avoid the keypoints whose patch overlaps the background or another face
+      const std::vector<vpImagePoint> &roi = polygons[f].getCorners();
+      bool nearBorder = false;
+      for (size_t c = 0; c < roi.size() && ! nearBorder; c++)
+        nearBorder = distanceToSegment(keyPoints[k], roi[c], roi[(c+1) % roi.size()]) < faceBorderDistance;
+      if (nearBorder)
+        break;
+
+      double X = x*Z, Y = y*Z;
+      kept.push_back((unsigned int)k);
+      points.push_back(oMc[0][0]*X + oMc[0][1]*Y + oMc[0][2]*Z + oMc[0][3]);
+      points.push_back(oMc[1][0]*X + oMc[1][1]*Y + oMc[1][2]*Z + oMc[1][3]);
+      points.push_back(oMc[2][0]*X + oMc[2][1]*Y + oMc[2][2]*Z + oMc[2][3]);
+      break;
+    }
+  }
+
+  if (kept.size() < m_minInliers)
+    return false;
+
+  unsigned int keyFrame = (unsigned int)m_keyFramePoses.size();
+  unsigned int first = (unsigned int)m_pointKeyFrame.size();
+  m_keyFramePoses.push_back(cMo);
+  m_points.insert(m_points.end(), points.begin(), points.end());
+  for (size_t k = 0; k < kept.size(); k++) {
+    m_pointKeyFrame.push_back(keyFrame);
+    const unsigned char *d = &descriptors[kept[k]*DESCRIPTOR_SIZE];
+    m_descriptors.insert(m_descriptors.end(), d, d + DESCRIPTOR_SIZE);
+  }
+  indexPoints(first);
+
+  return true;
+}
+
+/*!
+  Remove all the keyframes.
+*/
+void vpMbtKeyFrameDatabase::clear()
+{
+  m_keyFramePoses.clear();
+  m_pointKeyFrame.clear();
+  m_points.clear();
+  m_descriptors.clear();
+  for (unsigned int t = 0; t < NB_HASH_TABLES; t++)
+    m_hashTables[t].clear();
+}
+
+/*!
+  Detect the keypoints of an image and compute their descriptors.
+
+  \param I : Image.
+  \param keyPoints : Detected keypoints, at most the number set with setMaxKeyPoints().
+  \param descriptors : Descriptors of the keypoints, 32 bytes per keypoint.
+*/
+void vpMbtKeyFrameDatabase::extract(const vpImage<unsigned char> &I, std::vector<vpImagePoint> &keyPoints,
+                                    std::vector<unsigned char> &descriptors) const
+{
+  keyPoints.clear();
+  descriptors.clear();
+
+  const int height = (int)I.getHeight();
+  const int width = (int)I.getWidth();
+  const int margin = PATCH_RADIUS + 1;
+  if (height <= 2*margin || width <= 2*margin || m_maxKeyPoints == 0)
+    return;
+
+  // FAST corners: 9 contiguous pixels of the circle brighter or darker than the center
+  int offsets[16];
+  for (unsigned int k = 0; k < 16; k++)
+    offsets[k] = fastCircle[k][1]*width + fastCircle[k][0];
+
+  vpImage<int> score((unsigned int)height, (unsigned int)width, 0);
+  for (int i = margin; i < height - margin; i++) {
+    const unsigned char *row = I[(unsigned int)i];
+    for (int j = margin; j < width - margin; j++) {
+      const unsigned char *p = row + j;
+      const int high = *p + m_fastThreshold;
+      const int low = *p - m_fastThreshold;
+
+      // An arc of 9 pixels contains pixel 0 or 8, and pixel 4 or 12
+      const int p0 = p[offsets[0]], p8 = p[offsets[8]];
+      if (p0 <= high && p0 >= low && p8 <= high && p8 >= low)
+        continue;
+      const int p4 = p[offsets[4]], p12 = p[offsets[12]];
+      if (p4 <= high && p4 >= low && p12 <= high && p12 >= low)
+        continue;
+
+      unsigned int brighter = 0, darker = 0;
+      int sumBrighter = 0, sumDarker = 0;
+      for (unsigned int k = 0; k < 16; k++) {
+        int v = p[offsets[k]];
+        if (v > high) {
+          brighter |= 1u << k;
+          sumBrighter += v - high;
+        }
+        else if (v < low) {
+          darker |= 1u << k;
+          sumDarker += low - v;
+        }
+      }
+      if (hasArc(brighter))
+        score[(unsigned int)i][(unsigned int)j] = sumBrighter + 1;
+      else if (hasArc(darker))
+        score[(unsigned int)i][(unsigned int)j] = sumDarker + 1;
+    }
+  }
+
+  // Local maxima of the score
+  std::vector<vpFastCorner> corners;
+  for (int i = margin; i < height - margin; i++) {
+    for (int j = margin; j < width - margin; j++) {
+      const int s = score[(unsigned int)i][(unsigned int)j];
+      if (s == 0)
+        continue;
+      bool isMax = true;
+      for (int di = -1; di <= 1 && isMax; di++)
+        for (int dj = -1; dj <= 1; dj++)
+          if (score[(unsigned int)(i + di)][(unsigned int)(j + dj)] > s) {
+            isMax = false;
+            break;
+          }
+      if (isMax) {
+        vpFastCorner corner;
+        corner.i = i;
+        corner.j = j;
+        corner.score = s;
+        corners.push_back(corner);
+      }
+    }
+  }
+
+  // Keep the strongest corners, at most one per cell of a grid
+  std::sort(corners.begin(), corners.end(), compareFastCorners);
+  const int cellSize = 8;
+  const int gridWidth = (width + cellSize - 1) / cellSize;
+  std::vector<unsigned char> occupied((size_t)(gridWidth * ((height + cellSize - 1) / cellSize)), 0);
+  std::vector<vpFastCorner> selected;
+  for (size_t k = 0; k < corners.size() && selected.size() < m_maxKeyPoints; k++) {
+    unsigned char &cell = occupied[(size_t)((corners[k].i / cellSize)*gridWidth + corners[k].j / cellSize)];
+    if (cell)
+      continue;
+    cell = 1;
+    selected.push_back(corners[k]);
+  }
+
+  // Rotated BRIEF descriptors on the smoothed image
+  vpImage<unsigned char> S;
+  smooth(I, S);
+  const unsigned int nbBits = 8*DESCRIPTOR_SIZE;
+  keyPoints.resize(selected.size());
+  descriptors.resize(selected.size()*DESCRIPTOR_SIZE, 0);
+  for (size_t k = 0; k < selected.size(); k++) {
+    const int i = selected[k].i, j = selected[k].j;
+    keyPoints[k].set_ij(i, j);
+
+    // Orientation given by the intensity centroid of the patch
+    double m01 = 0, m10 = 0;
+    for (int dy = -PATCH_RADIUS; dy <= PATCH_RADIUS; dy++) {
+      const unsigned char *row = S[(unsigned int)(i + dy)] + j;
+      const int halfWidth = m_patchHalfWidth[(unsigned int)(dy + PATCH_RADIUS)];
+      int sum = 0, sumX = 0;
+      for (int dx = -halfWidth; dx <= halfWidth; dx++) {
+        sum += row[dx];
+        sumX += dx * row[dx];
+      }
+      m10 += sumX;
+      m01 += dy * sum;
+    }
+    double angle = atan2(m01, m10);
+    int orientation = vpMath::round(angle * NB_ORIENTATIONS / (2*M_PI));
+    orientation = (orientation + (int)NB_ORIENTATIONS) % (int)NB_ORIENTATIONS;
+
+    const int *pattern = &m_patterns[(unsigned int)orientation*4*nbBits];
+    unsigned char *d = &descriptors[k*DESCRIPTOR_SIZE];
+    for (unsigned int b = 0; b < nbBits; b++) {
+      const int *pair = pattern + 4*b;
+      if (S[(unsigned int)(i + pair[1])][j + pair[0]] < S[(unsigned int)(i + pair[3])][j + pair[2]])
+        d[b >> 3] |= (unsigned char)(1u << (b & 7));
+    }
+  }
+}
+
+/*!
+  Hamming distance between two descriptors.
+*/
+unsigned int vpMbtKeyFrameDatabase::hammingDistance(const unsigned char *d1, const unsigned char *d2)
+{
+  unsigned int distance = 0;
+  for (unsigned int k = 0; k < DESCRIPTOR_SIZE; k += 4) {
+    unsigned int v1, v2;
+    memcpy(&v1, d1 + k, 4);
+    memcpy(&v2, d2 + k, 4);
+    unsigned int v = v1 ^ v2;
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    distance += (((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+  }
+  return distance;
+}
+
+/*!
+  Key of a descriptor in a hash table: the bits of the descriptor from
+  table*HASH_KEY_BITS to (table+1)*HASH_KEY_BITS-1.
+*/
+unsigned int vpMbtKeyFrameDatabase::hashKey(const unsigned char *descriptor, const unsigned int table)
+{
+  const unsigned int bit = table * HASH_KEY_BITS;
+  const unsigned int byte = bit >> 3;
+  unsigned int value = descriptor[byte] | ((unsigned int)descriptor[byte + 1] << 8);
+  if (byte + 2 < DESCRIPTOR_SIZE)
+    value |= (unsigned int)descriptor[byte + 2] << 16;
+  return (value >> (bit & 7)) & ((1u << HASH_KEY_BITS) - 1);
+}
+
+/*!
+  Add the keypoints from index \e first to the hash tables.
+*/
+void vpMbtKeyFrameDatabase::indexPoints(const unsigned int first)
+{
+  const unsigned int nbPoints = (unsigned int)m_pointKeyFrame.size();
+  for (unsigned int t = 0; t < NB_HASH_TABLES; t++) {
+    std::vector<std::pair<unsigned int, unsigned int> > &table = m_hashTables[t];
+    size_t middle = table.size();
+    for (unsigned int p = first; p < nbPoints; p++)
+      table.push_back(std::make_pair(hashKey(&m_descriptors[p*DESCRIPTOR_SIZE], t), p));
+    std::sort(table.begin() + (std::ptrdiff_t)middle, table.end());
+    std::inplace_merge(table.begin(), table.begin() + (std::ptrdiff_t)middle, table.end());
+  }
+}
+
+/*!
+  Check if a pose is far enough from the poses of the keyframes to give a new
+  keyframe.
+
+  \param cMo : Pose of the camera.
+
+  \return true if the distance between the camera center and the camera
+  center of each keyframe is larger than the threshold, or if the rotation
+  between them is larger than the threshold (see setKeyFrameDistance()).
+  false if the maximal number of keyframes is reached.
+*/
+bool vpMbtKeyFrameDatabase::isNewKeyFrame(const vpHomogeneousMatrix &cMo) const
+{
+  if (m_keyFramePoses.size() >= m_maxKeyFrames)
+    return false;
+
+  const double distance = sqrt(vpMath::sqr(cMo[0][3]) + vpMath::sqr(cMo[1][3]) + vpMath::sqr(cMo[2][3]));
+  for (size_t k = 0; k < m_keyFramePoses.size(); k++) {
+    // Pose of the camera of the keyframe in the current camera frame
+    vpHomogeneousMatrix cMk = cMo * m_keyFramePoses[k].inverse();
+    double translation = sqrt(vpMath::sqr(cMk[0][3]) + vpMath::sqr(cMk[1][3]) + vpMath::sqr(cMk[2][3]));
+    if (translation >= m_keyFrameTranslationRatio * distance)
+      continue;
+    vpThetaUVector tu(cMk.getRotationMatrix());
+    if (sqrt(tu.sumSquare()) < m_keyFrameRotation)
+      return false;
+  }
+  return true;
+}
+
+/*!
+  Load a database saved with saveState(). The keyframes replace the current
+  ones.
+
+  \param ar : Archive opened for reading.
+*/
+void vpMbtKeyFrameDatabase::loadState(vpBinaryArchive &ar)
+{
+  ar.readSection(VP_ARCHIVE_TAG_MBT_KEYFRAMES, 1);
+  clear();
+
+  unsigned int nbKeyFrames, nbPoints;
+  ar.readValue(nbKeyFrames);
+  m_keyFramePoses.resize(nbKeyFrames);
+  for (unsigned int k = 0; k < nbKeyFrames; k++)
+    ar >> m_keyFramePoses[k];
+
+  ar.readValue(nbPoints);
+  m_pointKeyFrame.resize(nbPoints);
+  m_points.resize(3*nbPoints);
+  m_descriptors.resize(nbPoints*DESCRIPTOR_SIZE);
+  if (nbPoints) {
+    ar.readValues(&m_pointKeyFrame[0], nbPoints);
+    ar.readValues(&m_points[0], 3*nbPoints);
+    ar.readBytes(&m_descriptors[0], m_descriptors.size());
+  }
+
+  for (unsigned int p = 0; p < nbPoints; p++) {
+    if (m_pointKeyFrame[p] >= nbKeyFrames) {
+      clear();
+      throw vpException(vpException::ioError, "Bad keyframe index in the keyframe database");
+    }
+  }
+  indexPoints(0);
+}
+
+/*!
+  Localize the camera in an image from the keyframes of the database.
+
+  The keypoints of the image are matched with the keypoints of the keyframes
+  that get the most votes, and the pose is computed by RANSAC from these
+  matches. It is accepted if it has enough inliers (see setMinInliers() and
+  setRansacThreshold()).
+
+  \param I : Image.
+  \param cam : Camera parameters.
+  \param cMo : Computed pose, only modified when the localization succeeds.
+
+  \return true if the camera is localized.
+*/
+bool vpMbtKeyFrameDatabase::localize(const vpImage<unsigned char> &I, const vpCameraParameters &cam,
+                                     vpHomogeneousMatrix &cMo) const
+{
+  if (m_keyFramePoses.empty())
+    return false;
+
+  std::vector<vpImagePoint> keyPoints;
+  std::vector<unsigned char> descriptors;
+  extract(I, keyPoints, descriptors);
+
+  std::vector<std::pair<unsigned int, unsigned int> > matches;
+  match(descriptors, matches);
+  if (matches.size() < m_minInliers)
+    return false;
+
+  vpPose pose;
+  for (size_t m = 0; m < matches.size(); m++) {
+    const vpImagePoint &ip = keyPoints[matches[m].first];
+    const double *P = &m_points[3*matches[m].second];
+    double x = 0, y = 0;
+    vpPixelMeterConversion::convertPoint(cam, ip, x, y);
+    vpPoint pt;
+    pt.setWorldCoordinates(P[0], P[1], P[2]);
+    pt.set_x(x);
+    pt.set_y(y);
+    pose.addPoint(pt);
+  }
+
+  unsigned int consensus = (unsigned int)matches.size() / 3;
+  pose.setRansacNbInliersToReachConsensus(consensus > m_minInliers ? consensus : m_minInliers);
+  pose.setRansacThreshold(m_ransacThreshold / cam.get_px());
+  pose.setRansacMaxTrials(ransacMaxTrials);
+
+  vpHomogeneousMatrix cMo_;
+  try {
+    if (! pose.computePose(vpPose::RANSAC, cMo_))
+      return false;
+  }
+  catch(...) {
+    return false;
+  }
+  if (pose.getRansacNbInliers() < m_minInliers)
+    return false;
+
+  cMo = cMo_;
+  return true;
+}
+
+/*!
+  Match descriptors with the database. Each keyframe gets a vote for each
+  descriptor that has a distinctive match among its keypoints. The
+  descriptors are then matched with their best match among the keypoints of
+  the keyframes with the most votes.
+
+  \param descriptors : Descriptors of the keypoints of an image.
+  \param matches : Matches as (index of the keypoint of the image, index of
+  the keypoint of the database) pairs.
+*/
+void vpMbtKeyFrameDatabase::match(const std::vector<unsigned char> &descriptors,
+                                  std::vector<std::pair<unsigned int, unsigned int> > &matches) const
+{
+  matches.clear();
+
+  const unsigned int nbKeyFrames = (unsigned int)m_keyFramePoses.size();
+  const unsigned int nbQueries = (unsigned int)(descriptors.size() / DESCRIPTOR_SIZE);
+  if (nbKeyFrames == 0 || nbQueries == 0)
+    return;
+
+  std::vector<std::vector<std::pair<unsigned int, unsigned int> > > keyFrameMatches(nbKeyFrames);
+  std::vector<unsigned int> lastQuery(m_pointKeyFrame.size(), 0);
+  std::vector<vpDescriptorMatch> candidates;
+  for (unsigned int q = 0; q < nbQueries; q++) {
+    const unsigned char *d = &descriptors[q*DESCRIPTOR_SIZE];
+
+    // Keypoints of the database sharing a chunk of bits with the descriptor
+    candidates.clear();
+    for (unsigned int t = 0; t < NB_HASH_TABLES; t++) {
+      const std::vector<std::pair<unsigned int, unsigned int> > &table = m_hashTables[t];
+      std::pair<unsigned int, unsigned int> key(hashKey(d, t), 0);
+      for (std::vector<std::pair<unsigned int, unsigned int> >::const_iterator it
+           = std::lower_bound(table.begin(), table.end(), key, compareHashKeys);
+           it != table.end() && it->first == key.first; ++it) {
+        unsigned int p = it->second;
+        if (lastQuery[p] == q + 1)
+          continue;
+        lastQuery[p] = q + 1;
+
+        unsigned int distance = hammingDistance(d, &m_descriptors[p*DESCRIPTOR_SIZE]);
+        if (distance <= m_maxHammingDistance) {
+          vpDescriptorMatch candidate;
+          candidate.keyFrame = m_pointKeyFrame[p];
+          candidate.point = p;
+          candidate.distance = distance;
+          candidates.push_back(candidate);
+        }
+      }
+    }
+
+    // Best match in each keyframe, if distinctive enough in the keyframe
+    std::sort(candidates.begin(), candidates.end(), compareDescriptorMatches);
+    for (size_t c = 0; c < candidates.size(); ) {
+      size_t next = c + 1;
+      while (next < candidates.size() && candidates[next].keyFrame == candidates[c].keyFrame)
+        next++;
+      if (next == c + 1 || candidates[c].distance < m_matchingRatio * candidates[c+1].distance)
+        keyFrameMatches[candidates[c].keyFrame].push_back(std::make_pair(q, candidates[c].point));
+      c = next;
+    }
+  }
+
+  // Keyframes with the most votes
+  std::vector<std::pair<unsigned int, unsigned int> > votes;
+  for (unsigned int k = 0; k < nbKeyFrames; k++)
+    if (! keyFrameMatches[k].empty())
+      votes.push_back(std::make_pair((unsigned int)keyFrameMatches[k].size(), k));
+  std::sort(votes.rbegin(), votes.rend());
+
+  // Best match of each descriptor in these keyframes
+  std::vector<unsigned int> bestPoint(nbQueries, 0);
+  std::vector<unsigned int> bestDistance(nbQueries, m_maxHammingDistance + 1);
+  for (size_t v = 0; v < votes.size() && v < m_nbKeyFrameCandidates; v++) {
+    const std::vector<std::pair<unsigned int, unsigned int> > &keyFrameMatch = keyFrameMatches[votes[v].second];
+    for (size_t m = 0; m < keyFrameMatch.size(); m++) {
+      unsigned int q = keyFrameMatch[m].first, p = keyFrameMatch[m].second;
+      unsigned int distance = hammingDistance(&descriptors[q*DESCRIPTOR_SIZE], &m_descriptors[p*DESCRIPTOR_SIZE]);
+      if (distance < bestDistance[q]) {
+        bestDistance[q] = distance;
+        bestPoint[q] = p;
+      }
+    }
+  }
+  for (unsigned int q = 0; q < nbQueries; q++)
+    if (bestDistance[q] <= m_maxHammingDistance)
+      matches.push_back(std::make_pair(q, bestPoint[q]));
+}
+
+/*!
+  Save the keyframes of the database.
+
+  \param ar : Archive opened for writing.
+
+  \sa loadState()
+*/
+void vpMbtKeyFrameDatabase::saveState(vpBinaryArchive &ar) const
+{
+  ar.writeSection(VP_ARCHIVE_TAG_MBT_KEYFRAMES, 1);
+
+  ar.writeValue((unsigned int)m_keyFramePoses.size());
+  for (size_t k = 0; k < m_keyFramePoses.size(); k++)
+    ar << m_keyFramePoses[k];
+
+  unsigned int nbPoints = (unsigned int)m_pointKeyFrame.size();
+  ar.writeValue(nbPoints);
+  if (nbPoints) {
+    ar.writeValues(&m_pointKeyFrame[0], nbPoints);
+    ar.writeValues(&m_points[0], 3*nbPoints);
+    ar.writeBytes(&m_descriptors[0], m_descriptors.size());
+  }
+}
+
+/*!
+  Set the minimal distance between two keyframes. A pose gives a new keyframe
+  if, for each keyframe of the database, the distance between the camera
+  centers is larger than \e translationRatio times the distance between the
+  camera and the object frame origin, or the rotation between the two
+  cameras is larger than \e rotation.
+
+  \param translationRatio : Relative translation threshold (default 0.05).
+  \param rotation : Rotation threshold in radian (default 10 degrees).
+*/
+void vpMbtKeyFrameDatabase::setKeyFrameDistance(const double translationRatio, const double rotation)
+{
+  if (translationRatio < 0 || rotation < 0)
+    throw vpException(vpException::badValue, "The distance between keyframes must be positive");
+  m_keyFrameTranslationRatio = translationRatio;
+  m_keyFrameRotation = rotation;
+}
+
+/*!
+  Set the criteria used to match a descriptor with the descriptors of a
+  keyframe.
+
+  \param maxDistance : Maximal Hamming distance between two matched
+  descriptors, out of 256 bits (default 64).
+  \param ratio : The best match is only kept if its distance is smaller than
+  \e ratio times the distance of the second best match of the same keyframe
+  (default 0.8).
+*/
+void vpMbtKeyFrameDatabase::setMatchingThreshold(const unsigned int maxDistance, const double ratio)
+{
+  if (ratio <= 0 || ratio > 1)
+    throw vpException(vpException::badValue, "The matching ratio must be in ]0, 1]");
+  m_maxHammingDistance = maxDistance;
+  m_matchingRatio = ratio;
+}
+
+/*!
+  Set the maximal reprojection error of the inliers of the pose computed by
+  localize().
+
+  \param threshold : Threshold in pixel (default 3).
+*/
+void vpMbtKeyFrameDatabase::setRansacThreshold(const double threshold)
+{
+  if (threshold <= 0)
+    throw vpException(vpException::badValue, "The RANSAC threshold must be positive");
+  m_ransacThreshold = threshold;
+}
+
+/*!
+  Smooth an image with the 5x5 binomial filter.
+*/
+void vpMbtKeyFrameDatabase::smooth(const vpImage<unsigned char> &I, vpImage<unsigned char> &S)
+{
+  const int height = (int)I.getHeight();
+  const int width = (int)I.getWidth();
+  S.resize(I.getHeight(), I.getWidth());
+  if (height == 0 || width == 0)
+    return;
+
+  std::vector<unsigned short> tmp((size_t)(height*width));
+  int cols[5];
+  for (int i = 0; i < height; i++) {
+    const unsigned char *row = I[(unsigned int)i];
+    unsigned short *out = &tmp[(size_t)(i*width)];
+    for (int j = 0; j < width; j++) {
+      if (j >= 2 && j < width - 2) {
+        out[j] = (unsigned short)(row[j-2] + 4*row[j-1] + 6*row[j] + 4*row[j+1] + row[j+2]);
+      }
+      else {
+        for (int l = 0; l < 5; l++) {
+          int c = j + l - 2;
+          cols[l] = c < 0 ? 0 : (c > width - 1 ? width - 1 : c);
+        }
+        out[j] = (unsigned short)(row[cols[0]] + 4*row[cols[1]] + 6*row[cols[2]] + 4*row[cols[3]] + row[cols[4]]);
+      }
+    }
+  }
+
+  const unsigned short *rows[5];
+  for (int i = 0; i < height; i++) {
+    for (int l = 0; l < 5; l++) {
+      int r = i + l - 2;
+      rows[l] = &tmp[(size_t)((r < 0 ? 0 : (r > height - 1 ? height - 1 : r)) * width)];
+    }
+    unsigned char *out = S[(unsigned int)i];
+    for (int j = 0; j < width; j++)
+      out[j] = (unsigned char)((rows[0][j] + 4*rows[1][j] + 6*rows[2][j] + 4*rows[3][j] + rows[4][j] + 128) >> 8);
+  }
+}
@@ -0,0 +1,90 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Exception raised inside a parallel loop of the model-based trackers.
+ *
+ *****************************************************************************/
+
+#ifndef __vpMbtParallelError_impl_h_
+#define __vpMbtParallelError_impl_h_
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpException.h>
+#include <visp3/core/vpTrackingException.h>
+
+/*
+  Exception raised while processing the primitives or the cameras in
+  parallel. Only the exception of the first item (in the sequential order) is
+  kept so that the error reported does not depend on the scheduling of the
+  threads. The exception is rethrown as a vpTrackingException if it was one,
+  so that the callers can still catch the tracking errors.
+*/
+class vpMbtParallelError
+{
+public:
+  vpMbtParallelError() : m_index(-1), m_error(vpException::fatalError, ""), m_tracking(false) {}
+
+  void set(int index, const vpException &e)
+  {
+#ifdef VISP_HAVE_OPENMP
+    #pragma omp critical(vpMbtParallelError)
+#endif
+    {
+      if(m_index < 0 || index < m_index){
+        m_index = index;
+        m_error = e;
+        m_tracking = (dynamic_cast<const vpTrackingException *>(&e) != NULL);
+      }
+    }
+  }
+
+  bool raised() const
+  {
+    return m_index >= 0;
+  }
+
+  void rethrow() const
+  {
+    if(m_index >= 0){
+      if(m_tracking){
+        vpException e(m_error);
+        throw vpTrackingException(e.getCode(), e.getStringMessage());
+      }
+      throw m_error;
+    }
+  }
+
+private:
+  int m_index;
+  vpException m_error;
+  bool m_tracking;
+};
+
+#endif
@@ -49,6 +49,23 @@
 #include <visp3/mbt/vpMbtPolygon.h>
 #include <visp3/core/vpPolygon.h>
 
+#include <limits>
+
+namespace
+{
+  // Same as vpColVector::normalize() for a 3-dimensional vector.
+  void normalizeVector(double v[3])
+  {
+    double sum_square = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+    if (std::fabs(sum_square) > std::numeric_limits<double>::epsilon()) {
+      double norm = sqrt(sum_square);
+      v[0] /= norm;
+      v[1] /= norm;
+      v[2] /= norm;
+    }
+  }
+}
+
 /*!
   Basic constructor.
 */
@@ -158,31 +175,32 @@ vpMbtPolygon::isVisible(const vpHomogeneousMatrix &cMo, const double alpha, cons
   //Check visibility from normal
   //Newell's Method for calculating the normal of an arbitrary 3D polygon
   //https://www.opengl.org/wiki/Calculating_a_Surface_Normal
-  vpColVector faceNormal(3);
-  vpColVector currentVertex, nextVertex;
+  //The computation is done on plain doubles since this test is run for every
+  //face of the model at each frame.
+  double faceNormal[3] = {0., 0., 0.};
   for(unsigned int  i = 0; i<nbpt; i++) {
-    currentVertex = p[i].cP;
-    nextVertex = p[(i+1) % nbpt].cP;
+    const vpColVector &currentVertex = p[i].cP;
+    const vpColVector &nextVertex = p[(i+1) % nbpt].cP;
 
     faceNormal[0] += (currentVertex[1] - nextVertex[1]) * (currentVertex[2] + nextVertex[2]);
     faceNormal[1] += (currentVertex[2] - nextVertex[2]) * (currentVertex[0] + nextVertex[0]);
     faceNormal[2] += (currentVertex[0] - nextVertex[0]) * (currentVertex[1] + nextVertex[1]);
   }
-  faceNormal.normalize();
+  normalizeVector(faceNormal);
 
-  vpColVector e4(3) ;
-  vpPoint pt;
+  // The sum starts from a default vpPoint, whose Z coordinate is 1
+  double e4[3] = {0., 0., 1.};
   for (unsigned int i = 0; i < nbpt; i += 1){
-    pt.set_X(pt.get_X() + p[i].get_X());
-    pt.set_Y(pt.get_Y() + p[i].get_Y());
-    pt.set_Z(pt.get_Z() + p[i].get_Z());
+    e4[0] += p[i].get_X();
+    e4[1] += p[i].get_Y();
+    e4[2] += p[i].get_Z();
   }
-  e4[0] = -pt.get_X() / (double)nbpt;
-  e4[1] = -pt.get_Y() / (double)nbpt;
-  e4[2] = -pt.get_Z() / (double)nbpt;
-  e4.normalize();
+  e4[0] = -e4[0] / (double)nbpt;
+  e4[1] = -e4[1] / (double)nbpt;
+  e4[2] = -e4[2] / (double)nbpt;
+  normalizeVector(e4);
 
-  double angle = acos(vpColVector::dotProd(e4, faceNormal));
+  double angle = acos(e4[0]*faceNormal[0] + e4[1]*faceNormal[1] + e4[2]*faceNormal[2]);
 
 //  vpCTRACE << angle << "/" << vpMath::deg(angle) << "/" << vpMath::deg(alpha) << std::endl;
 
@@ -0,0 +1,261 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Robust pose minimization shared by the model-based trackers.
+ *
+ *****************************************************************************/
+
+#include <cmath>
+#include <limits>
+
+#include <visp3/core/vpTrackingException.h>
+#include <visp3/core/vpVelocityTwistMatrix.h>
+#include <visp3/mbt/vpMbtVVSSolver.h>
+
+/*!
+  Create a solver for a new pose estimation.
+
+  \param method : Gauss-Newton or Levenberg-Marquardt step.
+  \param gain : Gain applied to the increment.
+  \param maxIter : Maximum number of iterations.
+*/
+vpMbtVVSSolver::vpMbtVVSSolver(const vpMbTracker::vpMbtOptimizationMethod &method, const double gain,
+                               const unsigned int maxIter)
+  : m_method(method), m_gain(gain), m_mu(0.01), m_maxIter(maxIter), m_iter(0),
+    m_residualThreshold(1e-8), m_incrementThreshold(0), m_nbIncrements(0), m_residual(0), m_residualPrev(0),
+    m_incrementNorm(0), m_weights(), m_errorPrev(), m_wPrev(), m_meanSquarePrev(0)
+{
+  for (unsigned int i = 0; i < 6; i++) {
+    m_LTR[i] = 0;
+    for (unsigned int j = 0; j < 6; j++)
+      m_LTL[i][j] = 0;
+  }
+}
+
+/*!
+  Accumulate the normal equations of the current iteration.
+
+  \param L : Interaction matrix of the features, with 6 columns. It is not modified.
+  \param error : Error of the features.
+  \param w : Robust weights of the features.
+  \param factor : If not NULL, factors applied to the weights.
+  \param weightInteraction : If false, the rows of the interaction matrix are
+  not weighted, only the error is.
+*/
+void
+vpMbtVVSSolver::computeIncrement(const vpMatrix &L, const vpColVector &error, const vpColVector &w,
+                                 const vpColVector *factor, const bool weightInteraction)
+{
+  unsigned int nbRows = error.getRows();
+  if (L.getRows() != nbRows || L.getCols() != 6 || w.getRows() != nbRows
+      || (factor != NULL && factor->getRows() != nbRows)) {
+    throw vpException(vpException::dimensionError, "Bad size of the interaction matrix or of the weights");
+  }
+
+  for (unsigned int i = 0; i < 6; i++) {
+    m_LTR[i] = 0;
+    for (unsigned int j = i; j < 6; j++)
+      m_LTL[i][j] = 0;
+  }
+
+  m_weights.resize(nbRows, false);
+  double num = 0;
+  double den = 0;
+  for (unsigned int i = 0; i < nbRows; i++) {
+    double wi = w[i];
+    if (factor != NULL)
+      wi *= (*factor)[i];
+    m_weights[i] = wi;
+
+    double ei = error[i];
+    num += wi * ei * ei;
+    den += wi;
+
+    const double *Li = L[i];
+    double wl = weightInteraction ? wi : 1.0;
+    double we = wi * ei;
+    for (unsigned int k = 0; k < 6; k++) {
+      double a = wl * Li[k];
+      m_LTR[k] += a * we;
+      for (unsigned int l = k; l < 6; l++)
+        m_LTL[k][l] += a * wl * Li[l];
+    }
+  }
+
+  m_residualPrev = m_residual;
+  m_residual = den > 0 ? sqrt(num / den) : 0;
+  m_nbIncrements++;
+
+  if (m_method == vpMbTracker::LEVENBERG_MARQUARDT_OPT) {
+    m_errorPrev = error;
+    m_wPrev = w;
+    m_meanSquarePrev = nbRows > 0 ? error.sumSquare() / (double)nbRows : 0;
+  }
+}
+
+/*!
+  Compute the pose increment from the normal equations accumulated by
+  computeIncrement().
+
+  \param cMo : Current pose.
+  \param isoJoIdentity : If false, the increment is restricted to the degrees
+  of freedom selected by \e oJo, expressed in the object frame.
+  \param oJo : Selection of the degrees of freedom.
+  \param v : Increment of the pose (velocity in the camera frame).
+*/
+void
+vpMbtVVSSolver::getIncrement(const vpHomogeneousMatrix &cMo, const bool isoJoIdentity, const vpMatrix &oJo,
+                             vpColVector &v)
+{
+  vpMatrix LTL(6, 6);
+  vpColVector LTR(6);
+  for (unsigned int i = 0; i < 6; i++) {
+    LTR[i] = m_LTR[i];
+    for (unsigned int j = i; j < 6; j++)
+      LTL[i][j] = LTL[j][i] = m_LTL[i][j];
+  }
+
+  vpVelocityTwistMatrix cVo;
+  if (! isoJoIdentity) {
+    // (L cVo oJo)^T (L cVo oJo) = (cVo oJo)^T L^T L (cVo oJo)
+    cVo.buildFrom(cMo);
+    vpMatrix VJ = cVo * oJo;
+    vpMatrix VJt = VJ.t();
+    LTL = VJt * LTL * VJ;
+    LTR = VJt * LTR;
+  }
+
+  if (m_method == vpMbTracker::LEVENBERG_MARQUARDT_OPT) {
+    for (unsigned int i = 0; i < LTL.getRows(); i++)
+      LTL[i][i] += m_mu;
+  }
+
+  v = -m_gain * LTL.pseudoInverse(LTL.getRows() * std::numeric_limits<double>::epsilon()) * LTR;
+  if (! isoJoIdentity)
+    v = cVo * v;
+
+  if (m_method == vpMbTracker::LEVENBERG_MARQUARDT_OPT && m_iter != 0)
+    m_mu /= 10.0;
+
+  m_incrementNorm = sqrt(v.sumSquare());
+}
+
+/*!
+  \return true if the minimization is over: the maximum number of iterations
+  is reached, the weighted residual did not change or the last increment was
+  small enough.
+*/
+bool
+vpMbtVVSSolver::hasConverged() const
+{
+  if (m_iter >= m_maxIter)
+    return true;
+  if (m_nbIncrements >= 2 && std::fabs(m_residual - m_residualPrev) < m_residualThreshold)
+    return true;
+  if (m_nbIncrements >= 1 && m_incrementNorm < m_incrementThreshold)
+    return true;
+  return false;
+}
+
+/*!
+  Compute the kernel of the weighted interaction matrix expressed in the
+  object frame, from the normal equations accumulated by computeIncrement().
+
+  \param cMo : Current pose.
+  \param K : Kernel of the interaction matrix.
+
+  \return The rank of the interaction matrix.
+*/
+unsigned int
+vpMbtVVSSolver::kernel(const vpHomogeneousMatrix &cMo, vpMatrix &K) const
+{
+  vpMatrix LTL(6, 6);
+  for (unsigned int i = 0; i < 6; i++)
+    for (unsigned int j = i; j < 6; j++)
+      LTL[i][j] = LTL[j][i] = m_LTL[i][j];
+
+  vpVelocityTwistMatrix cVo;
+  cVo.buildFrom(cMo);
+  vpMatrix V(cVo);
+  vpMatrix LTLo = V.t() * LTL * V;
+
+  // The singular values of L^T L are the squares of the ones of L
+  return LTLo.kernel(K, 1e-12);
+}
+
+/*!
+  With the Levenberg-Marquardt method, check that the error at the current
+  pose is not larger than at the previous one. If it is, the damping factor
+  is increased and the error and the weights of the previous pose are
+  restored: the caller has to go back to the previous pose.
+
+  \param error : Error at the current pose, replaced by the previous one if
+  the increment is rejected.
+  \param w : Weights, replaced by the previous ones if the increment is
+  rejected.
+
+  \return true if the last increment is rejected.
+
+  \exception vpTrackingException::fatalError : If the minimization diverged.
+*/
+bool
+vpMbtVVSSolver::rejectIncrement(vpColVector &error, vpColVector &w)
+{
+  if (m_iter == 0 || m_nbIncrements == 0 || m_method != vpMbTracker::LEVENBERG_MARQUARDT_OPT)
+    return false;
+
+  unsigned int nbRows = error.getRows();
+  if (nbRows == 0 || error.sumSquare() / (double)nbRows <= m_meanSquarePrev)
+    return false;
+
+  m_mu *= 10.0;
+  if (m_mu > 1.0)
+    throw vpTrackingException(vpTrackingException::fatalError, "Optimization diverged");
+
+  error = m_errorPrev;
+  w = m_wPrev;
+  return true;
+}
+
+/*!
+  Set the criteria that stop the minimization before the maximum number of
+  iterations.
+
+  \param residualThreshold : The minimization stops when the weighted residual
+  varies by less than this threshold between two iterations.
+  \param incrementThreshold : The minimization stops when the norm of the pose
+  increment is below this threshold. 0 to disable this criterion.
+*/
+void
+vpMbtVVSSolver::setStopCriteria(const double residualThreshold, const double incrementThreshold)
+{
+  m_residualThreshold = residualThreshold;
+  m_incrementThreshold = incrementThreshold;
+}
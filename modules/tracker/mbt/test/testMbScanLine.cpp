@@ -0,0 +1,178 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Benchmark of the scanline visibility test.
+ *
+ *****************************************************************************/
+/*!
+  \example testMbScanLine.cpp
+
+  \brief Render scenes of 1000 to 50000 polygons with the scanline visibility
+  test, sequentially and with both image axes rendered in parallel. Both
+  renderings have to give the same visibility results.
+*/
+
+#include <cmath>
+#include <iostream>
+
+#include <visp3/core/vpTime.h>
+#include <visp3/mbt/vpMbHiddenFaces.h>
+
+namespace {
+// Sphere of nl x 2 nl quads partly occluded by a plate
+void createScene(vpMbHiddenFaces<vpMbtPolygon> &faces, unsigned int nl)
+{
+  int index = 0;
+  for (unsigned int a = 0; a < nl; a++) {
+    for (unsigned int b = 0; b < 2 * nl; b++) {
+      double t0 = M_PI * a / nl, t1 = M_PI * (a + 1) / nl, p0 = M_PI * b / nl, p1 = M_PI * (b + 1) / nl;
+      double theta[4] = { t0, t0, t1, t1 }, phi[4] = { p0, p1, p1, p0 };
+      double r = 0.2 * (1 + 0.02 * ((a * 7 + b * 3) % 5));
+      vpMbtPolygon polygon;
+      polygon.setNbPoint(4);
+      polygon.setIndex(index++);
+      for (unsigned int k = 0; k < 4; k++) {
+        vpPoint P(r * sin(theta[k]) * cos(phi[k]), r * sin(theta[k]) * sin(phi[k]), r * cos(theta[k]));
+        polygon.addPoint(k, P);
+      }
+      faces.addPolygon(&polygon);
+    }
+  }
+
+  vpMbtPolygon plate;
+  plate.setNbPoint(4);
+  plate.setIndex(index++);
+  plate.addPoint(0, vpPoint(-0.05, -0.3, -0.25));
+  plate.addPoint(1, vpPoint(0.05, -0.3, -0.25));
+  plate.addPoint(2, vpPoint(0.05, 0.3, -0.25));
+  plate.addPoint(3, vpPoint(-0.05, 0.3, -0.25));
+  faces.addPolygon(&plate);
+}
+
+// Render the scene and return the visible parts of the edges of the polygons
+void render(vpMbHiddenFaces<vpMbtPolygon> &faces, const vpCameraParameters &cam, const vpHomogeneousMatrix &cMo,
+            std::vector<std::pair<vpPoint, vpPoint> > &visibleLines, double &renderTime)
+{
+  bool changed = false;
+  faces.setVisible(cMo, vpMath::rad(89), vpMath::rad(89), changed);
+  faces.computeClippedPolygons(cMo, cam);
+
+  double t = vpTime::measureTimeMs();
+  faces.computeScanLineRender(cam, 640, 480);
+  renderTime += vpTime::measureTimeMs() - t;
+
+  visibleLines.clear();
+  for (unsigned int i = 0; i < faces.size(); i++) {
+    if (! faces[i]->isVisible())
+      continue;
+    std::vector<std::pair<vpPoint, unsigned int> > polygon;
+    faces[i]->getPolygonClipped(polygon);
+    for (size_t k = 0; k + 1 < polygon.size(); k++) {
+      std::vector<std::pair<vpPoint, vpPoint> > lines;
+      faces.computeScanLineQuery(polygon[k].first, polygon[k + 1].first, lines);
+      visibleLines.insert(visibleLines.end(), lines.begin(), lines.end());
+    }
+  }
+}
+
+template<class Type>
+bool sameImage(const vpImage<Type> &I1, const vpImage<Type> &I2)
+{
+  if (I1.getHeight() != I2.getHeight() || I1.getWidth() != I2.getWidth())
+    return false;
+  for (unsigned int i = 0; i < I1.getSize(); i++) {
+    if (I1.bitmap[i] != I2.bitmap[i])
+      return false;
+  }
+  return true;
+}
+
+bool samePoint(const vpPoint &P1, const vpPoint &P2)
+{
+  return P1.get_X() == P2.get_X() && P1.get_Y() == P2.get_Y() && P1.get_Z() == P2.get_Z();
+}
+
+bool testScene(unsigned int nl, unsigned int nbImages)
+{
+  vpMbHiddenFaces<vpMbtPolygon> faces, facesThreaded;
+  createScene(faces, nl);
+  createScene(facesThreaded, nl);
+  facesThreaded.getMbScanLineRenderer().setThreaded(true);
+
+  vpCameraParameters cam(600, 600, 320, 240);
+  double time = 0, timeThreaded = 0;
+  for (unsigned int n = 0; n < nbImages; n++) {
+    vpHomogeneousMatrix cMo(0.01 * sin(0.1 * n), 0.02 * cos(0.07 * n), 0.8 + 0.1 * sin(0.3 * n), 0.05 * n, 0.03 * n,
+                            0.02 * n);
+    std::vector<std::pair<vpPoint, vpPoint> > lines, linesThreaded;
+    render(faces, cam, cMo, lines, time);
+    render(facesThreaded, cam, cMo, linesThreaded, timeThreaded);
+
+    const vpMbScanLine &scanline = faces.getMbScanLineRenderer();
+    const vpMbScanLine &scanlineThreaded = facesThreaded.getMbScanLineRenderer();
+    if (! sameImage(scanline.getPrimitiveIDs(), scanlineThreaded.getPrimitiveIDs())
+        || ! sameImage(scanline.getMask(), scanlineThreaded.getMask())) {
+      std::cerr << "The parallel rendering differs from the sequential one" << std::endl;
+      return false;
+    }
+    if (lines.size() != linesThreaded.size()) {
+      std::cerr << "The visible lines of the parallel rendering differ from the sequential one" << std::endl;
+      return false;
+    }
+    for (size_t i = 0; i < lines.size(); i++) {
+      if (! samePoint(lines[i].first, linesThreaded[i].first) || ! samePoint(lines[i].second, linesThreaded[i].second)) {
+        std::cerr << "The visible lines of the parallel rendering differ from the sequential one" << std::endl;
+        return false;
+      }
+    }
+  }
+
+  std::cout << faces.size() << " polygons: " << time / nbImages << " ms sequential, " << timeThreaded / nbImages
+            << " ms parallel" << std::endl;
+  return true;
+}
+}
+
+int main()
+{
+  try {
+    // About 1000, 5000, 20000 and 50000 polygons
+    unsigned int nl[4] = { 23, 50, 100, 158 };
+    for (unsigned int i = 0; i < 4; i++) {
+      if (! testScene(nl[i], 3))
+        return 1;
+    }
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,225 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test saving and loading the state of the edge tracker with vpBinaryArchive.
+ *
+ *****************************************************************************/
+/*!
+  \example testMbTrackerState.cpp
+
+  \brief Track a synthetic cube with vpMbEdgeTracker, save the tracker state
+  in a binary archive and load it in another tracker. Both trackers have to
+  save the same state and to estimate the same poses in the next images.
+*/
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <visp3/core/vpBinaryArchive.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/mbt/vpMbEdgeTracker.h>
+
+namespace {
+const double cubeSize = 0.084;
+
+// Write the model of the cube [-s,0]x[0,s]x[0,s]
+void writeModel(const std::string &filename)
+{
+  std::ofstream file(filename.c_str());
+  file << "V1\n8\n"
+       << "0 0 0\n" << -cubeSize << " 0 0\n" << -cubeSize << " " << cubeSize << " 0\n0 " << cubeSize << " 0\n"
+       << "0 0 " << cubeSize << "\n" << -cubeSize << " 0 " << cubeSize << "\n"
+       << -cubeSize << " " << cubeSize << " " << cubeSize << "\n0 " << cubeSize << " " << cubeSize << "\n"
+       << "0\n0\n6\n4 0 4 5 1\n4 1 5 6 2\n4 6 7 3 2\n4 3 7 4 0\n4 0 1 2 3\n4 7 6 5 4\n0\n0\n";
+}
+
+// Render the cube covered by random blocks on a dark background
+void render(vpImage<unsigned char> &I, const vpCameraParameters &cam, const vpHomogeneousMatrix &cMo)
+{
+  I.resize(480, 640);
+  vpHomogeneousMatrix oMc = cMo.inverse();
+  double lo[3] = { -cubeSize, 0, 0 }, hi[3] = { 0, cubeSize, cubeSize };
+  for (unsigned int i = 0; i < I.getHeight(); i++) {
+    for (unsigned int j = 0; j < I.getWidth(); j++) {
+      double x = (j - cam.get_u0()) / cam.get_px(), y = (i - cam.get_v0()) / cam.get_py();
+      double d[3];
+      for (unsigned int k = 0; k < 3; k++)
+        d[k] = oMc[k][0] * x + oMc[k][1] * y + oMc[k][2];
+      // Intersection of the line of sight with the cube
+      double tnear = -1e9, tfar = 1e9;
+      unsigned int axis = 0;
+      for (unsigned int k = 0; k < 3; k++) {
+        double t1 = (lo[k] - oMc[k][3]) / d[k], t2 = (hi[k] - oMc[k][3]) / d[k];
+        if (t1 > t2) std::swap(t1, t2);
+        if (t1 > tnear) { tnear = t1; axis = k; }
+        if (t2 < tfar) tfar = t2;
+      }
+      unsigned char value = 25;
+      if (tnear < tfar && tnear > 0) {
+        double p[3];
+        for (unsigned int k = 0; k < 3; k++)
+          p[k] = oMc[k][3] + tnear * d[k];
+        int a = (int)floor(p[(axis + 1) % 3] * 250), b = (int)floor(p[(axis + 2) % 3] * 250);
+        unsigned int h = ((unsigned int)a * 73856093u) ^ ((unsigned int)b * 19349663u) ^ ((axis + 1) * 83492791u);
+        value = (unsigned char)(60 + 25 * (h % 7) + 10 * axis);
+      }
+      I[i][j] = value;
+    }
+  }
+}
+
+// Displacement of the camera between two images
+vpHomogeneousMatrix motion(unsigned int k)
+{
+  return vpHomogeneousMatrix(0.0008 * (1 + 0.3 * sin(0.5 * k)), 0.0005, 0.0003,
+                             vpMath::rad(0.3), vpMath::rad(0.2), vpMath::rad(0.25));
+}
+
+void setupTracker(vpMbEdgeTracker &tracker, const vpCameraParameters &cam)
+{
+  vpMe me;
+  me.setRange(8);
+  me.setThreshold(5000);
+  me.setSampleStep(4);
+  me.setMaskSize(5);
+  me.setMaskNumber(180);
+  me.setSubPixel(true);
+  tracker.setMovingEdge(me);
+  tracker.setCameraParameters(cam);
+  tracker.setAngleAppear(vpMath::rad(70));
+  tracker.setAngleDisappear(vpMath::rad(80));
+  tracker.setStopCriteria(1e-6, 1e-7);
+  tracker.setPosePrediction(vpMbTracker::KALMAN_PREDICTION);
+  tracker.setPosePredictionKalmanParameters(2e-5, 1e-6, 0.4);
+  tracker.setFeatureBudget(200);
+  tracker.setMovingEdgeThreaded(true);
+}
+
+std::string readFile(const std::string &filename)
+{
+  std::ifstream file(filename.c_str(), std::ifstream::in | std::ifstream::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+bool testState(const std::string &modelFile, const std::string &stateFile, const std::string &stateFile2)
+{
+  writeModel(modelFile);
+  vpCameraParameters cam(600, 600, 320, 240);
+  vpHomogeneousMatrix cMo(0.04, -0.04, 0.30, vpMath::rad(30), vpMath::rad(-35), vpMath::rad(15));
+  vpImage<unsigned char> I;
+
+  // Track a few images, so that the motion model is running
+  vpMbEdgeTracker tracker;
+  setupTracker(tracker, cam);
+  tracker.loadModel(modelFile);
+  render(I, cam, cMo);
+  tracker.initFromPose(I, cMo);
+  unsigned int k = 1;
+  for (; k <= 5; k++) {
+    cMo = motion(k) * cMo;
+    render(I, cam, cMo);
+    tracker.track(I);
+  }
+  {
+    vpBinaryArchive ar(stateFile, vpBinaryArchive::WRITE);
+    tracker.saveState(ar);
+  }
+
+  // Load the state in a tracker with the default settings, it has to save the same state
+  vpMbEdgeTracker tracker2;
+  tracker2.loadModel(modelFile);
+  {
+    vpBinaryArchive ar(stateFile, vpBinaryArchive::READ);
+    tracker2.loadState(ar);
+  }
+  {
+    vpBinaryArchive ar(stateFile2, vpBinaryArchive::WRITE);
+    tracker2.saveState(ar);
+  }
+  if (readFile(stateFile) != readFile(stateFile2)) {
+    std::cerr << "The loaded state differs from the saved one" << std::endl;
+    return false;
+  }
+  if (tracker2.getPosePrediction() != vpMbTracker::KALMAN_PREDICTION || tracker2.getFeatureBudget() != 200
+      || ! tracker2.getMovingEdgeThreaded() || ! tracker2.getMovingEdge().getSubPixel()) {
+    std::cerr << "Bad tracker settings" << std::endl;
+    return false;
+  }
+  std::cout << "Tracker state: ok" << std::endl;
+
+  // Restart both trackers from the current pose: the pose prediction continues the same way.
+  // The budget is distributed from the moving edges of the previous image, which are not
+  // part of the state, so it is disabled to compare the poses.
+  tracker.setFeatureBudget(0);
+  tracker2.setFeatureBudget(0);
+  tracker.initFromPose(I, tracker.getPose());
+  tracker2.initFromPose(I, tracker2.getPose());
+  for (; k <= 10; k++) {
+    cMo = motion(k) * cMo;
+    render(I, cam, cMo);
+    tracker.track(I);
+    tracker2.track(I);
+    vpHomogeneousMatrix cMo1 = tracker.getPose(), cMo2 = tracker2.getPose();
+    for (unsigned int i = 0; i < 12; i++) {
+      if (std::fabs(cMo1.data[i] - cMo2.data[i]) > 1e-9) {
+        std::cerr << "The poses estimated at image " << k << " differ" << std::endl;
+        return false;
+      }
+    }
+  }
+  std::cout << "Tracking from the loaded state: ok" << std::endl;
+
+  return true;
+}
+}
+
+int main()
+{
+  std::string modelFile = vpIoTools::createFilePath(vpIoTools::getTempPath(), "testMbTrackerState.cao");
+  std::string stateFile = vpIoTools::createFilePath(vpIoTools::getTempPath(), "testMbTrackerState.bin");
+  std::string stateFile2 = vpIoTools::createFilePath(vpIoTools::getTempPath(), "testMbTrackerState2.bin");
+  bool ok = false;
+  try {
+    ok = testState(modelFile, stateFile, stateFile2);
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+  }
+
+  if (vpIoTools::checkFilename(modelFile))
+    vpIoTools::remove(modelFile);
+  if (vpIoTools::checkFilename(stateFile))
+    vpIoTools::remove(stateFile);
+  if (vpIoTools::checkFilename(stateFile2))
+    vpIoTools::remove(stateFile2);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the interaction matrix and the residual of the KLT points of a face.
+ *
+ *****************************************************************************/
+/*!
+  \example testMbtDistanceKltPoints.cpp
+
+  \brief Track the KLT points of a planar face between two synthetic poses
+  and compare the interaction matrix and the residual computed by
+  vpMbtDistanceKltPoints with the ones computed point by point from the
+  geometry of the scene.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include <visp3/core/vpConfig.h>
+
+#if defined(VISP_HAVE_MODULE_KLT) && (!defined(VISP_HAVE_OPENCV) || (VISP_HAVE_OPENCV_VERSION >= 0x020100))
+
+#include <visp3/core/vpMeterPixelConversion.h>
+#include <visp3/core/vpPixelMeterConversion.h>
+#include <visp3/core/vpPlane.h>
+#include <visp3/core/vpPolygon.h>
+#include <visp3/klt/vpKltNative.h>
+#include <visp3/mbt/vpMbtDistanceKltPoints.h>
+#include <visp3/visual_features/vpFeaturePoint.h>
+
+namespace {
+// Point of the face seen in the image at (x, y) in meter, in the object frame
+vpColVector backProject(const vpMbtPolygon &face, const vpHomogeneousMatrix &cMo, double x, double y)
+{
+  vpPlane plane(face.p[0], face.p[1], face.p[2], vpPlane::object_frame);
+  plane.changeFrame(cMo);
+  double Z = -plane.getD() / (plane.getA() * x + plane.getB() * y + plane.getC());
+
+  vpColVector cP(4), oP;
+  cP[0] = x * Z;
+  cP[1] = y * Z;
+  cP[2] = Z;
+  cP[3] = 1;
+  oP = cMo.inverse() * cP;
+  return oP;
+}
+
+bool testFace(const vpHomogeneousMatrix &c0Mo, const vpHomogeneousMatrix &cMo, unsigned int seed)
+{
+  vpCameraParameters cam(600, 600, 320, 240);
+
+  vpMbtPolygon face;
+  face.setNbPoint(4);
+  face.setIndex(0);
+  face.addPoint(0, vpPoint(-0.1, -0.08, 0.02));
+  face.addPoint(1, vpPoint(0.1, -0.08, -0.03));
+  face.addPoint(2, vpPoint(0.1, 0.08, -0.03));
+  face.addPoint(3, vpPoint(-0.1, 0.08, 0.02));
+  face.changeFrame(c0Mo);
+  face.computePolygonClipped(cam);
+
+  // Points detected in the initial image, some of them outside the face
+  vpKltNative klt0;
+  srand(seed);
+  for (long id = 0; id < 1000; id++) {
+    float u = (float)(20 + rand() % 600) + 0.25f * (float)(rand() % 4);
+    float v = (float)(20 + rand() % 440) + 0.25f * (float)(rand() % 4);
+    klt0.addFeature(id, u, v);
+  }
+
+  vpMbtDistanceKltPoints kltFace;
+  kltFace.setCameraParameters(cam);
+  kltFace.polygon = &face;
+  kltFace.init(klt0);
+  if (kltFace.getInitialNumberPoint() < 100) {
+    std::cerr << "Not enough points in the face" << std::endl;
+    return false;
+  }
+
+  // Same points tracked in the current image: their position is the transfer
+  // of the initial one with a small noise, every fifth point is lost and
+  // points unknown by the face are added
+  vpKltNative klt;
+  for (int i = 0; i < klt0.getNbFeatures(); i++) {
+    int id;
+    float u, v;
+    klt0.getFeature(i, id, u, v);
+    if (id % 5 == 0)
+      continue;
+    double x0(0), y0(0), x(0), y(0), u_cur(0), v_cur(0);
+    vpPixelMeterConversion::convertPoint(cam, (double)u, (double)v, x0, y0);
+    vpColVector oP = backProject(face, c0Mo, x0, y0);
+    vpPoint P(oP[0], oP[1], oP[2]);
+    P.track(cMo);
+    x = P.get_x();
+    y = P.get_y();
+    vpMeterPixelConversion::convertPoint(cam, x, y, u_cur, v_cur);
+    klt.addFeature((long)id, (float)(u_cur + 0.3 * ((id % 7) - 3)), (float)(v_cur - 0.2 * ((id % 5) - 2)));
+  }
+  for (long id = 5000; id < 5020; id++)
+    klt.addFeature(id, (float)(300 + id - 5000), 240.f);
+
+  unsigned int nbPoints = kltFace.computeNbDetectedCurrent(klt);
+
+  vpHomography cHc0;
+  kltFace.computeHomography(cMo * c0Mo.inverse(), cHc0);
+  vpColVector R(2 * nbPoints);
+  vpMatrix L(2 * nbPoints, 6);
+  kltFace.computeInteractionMatrixAndResidu(R, L);
+
+  // Reference computed point by point: the initial point is transferred in
+  // the current image through the 3D point of the face it comes from, and
+  // the depth of the current point is the one of the face along its ray
+  unsigned int k = 0;
+  double maxErrorR = 0, maxErrorL = 0;
+  for (int i = 0; i < klt.getNbFeatures(); i++) {
+    int id;
+    float u, v;
+    klt.getFeature(i, id, u, v);
+    int i0 = -1;
+    for (int j = 0; j < klt0.getNbFeatures() && i0 < 0; j++) {
+      int id0;
+      float u0, v0;
+      klt0.getFeature(j, id0, u0, v0);
+      if (id0 == id) {
+        std::vector<vpImagePoint> roi;
+        face.getRoiClipped(cam, roi);
+        if (vpPolygon::isInside(roi, v0, u0))
+          i0 = j;
+      }
+    }
+    if (i0 < 0)
+      continue;
+    if (k >= nbPoints) {
+      std::cerr << "Too many points in the face" << std::endl;
+      return false;
+    }
+
+    int id0;
+    float u0, v0;
+    klt0.getFeature(i0, id0, u0, v0);
+    double x0(0), y0(0), x(0), y(0);
+    vpPixelMeterConversion::convertPoint(cam, (double)u0, (double)v0, x0, y0);
+    vpPixelMeterConversion::convertPoint(cam, (double)u, (double)v, x, y);
+
+    vpColVector oP0 = backProject(face, c0Mo, x0, y0);
+    vpPoint P0(oP0[0], oP0[1], oP0[2]);
+    P0.track(cMo);
+
+    vpColVector oP = backProject(face, cMo, x, y);
+    vpColVector cP = cMo * oP;
+    vpFeaturePoint s;
+    s.buildFrom(x, y, cP[2]);
+    vpMatrix Lk = s.interaction();
+
+    maxErrorR = (std::max)(maxErrorR, std::fabs(R[2 * k] - (P0.get_x() - x)));
+    maxErrorR = (std::max)(maxErrorR, std::fabs(R[2 * k + 1] - (P0.get_y() - y)));
+    for (unsigned int c = 0; c < 6; c++) {
+      maxErrorL = (std::max)(maxErrorL, std::fabs(L[2 * k][c] - Lk[0][c]));
+      maxErrorL = (std::max)(maxErrorL, std::fabs(L[2 * k + 1][c] - Lk[1][c]));
+    }
+    k++;
+  }
+
+  std::cout << nbPoints << " points, max error residual " << maxErrorR << " interaction matrix " << maxErrorL
+            << std::endl;
+  if (k != nbPoints) {
+    std::cerr << "Bad number of points in the face: " << nbPoints << " instead of " << k << std::endl;
+    return false;
+  }
+  if (maxErrorR > 1e-9 || maxErrorL > 1e-7) {
+    std::cerr << "The interaction matrix or the residual differs from the reference" << std::endl;
+    return false;
+  }
+  return true;
+}
+}
+
+int main()
+{
+  try {
+    vpHomogeneousMatrix c0Mo(0.01, -0.02, 0.5, vpMath::rad(10), vpMath::rad(-15), vpMath::rad(5));
+    vpHomogeneousMatrix cMo1 = vpHomogeneousMatrix(0.004, 0.002, -0.01, vpMath::rad(2), vpMath::rad(-1), vpMath::rad(3))
+        * c0Mo;
+    vpHomogeneousMatrix cMo2 = vpHomogeneousMatrix(-0.03, 0.02, 0.06, vpMath::rad(-8), vpMath::rad(12), vpMath::rad(-6))
+        * c0Mo;
+    if (! testFace(c0Mo, c0Mo, 1) || ! testFace(c0Mo, cMo1, 2) || ! testFace(c0Mo, cMo2, 3))
+      return 1;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+#else
+int main()
+{
+  std::cout << "This test requires the klt module" << std::endl;
+  return 0;
+}
+#endif
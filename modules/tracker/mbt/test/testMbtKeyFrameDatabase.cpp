@@ -0,0 +1,234 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the keyframe database used to relocalize the model-based trackers.
+ *
+ *****************************************************************************/
+/*!
+  \example testMbtKeyFrameDatabase.cpp
+
+  \brief Record keyframes of a synthetic textured cube, relocalize the camera
+  from views close to the keyframes and save the database in a binary
+  archive. The loaded database has to hold the same keyframes and to give
+  the same poses.
+*/
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include <visp3/core/vpBinaryArchive.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/core/vpPoseVector.h>
+#include <visp3/mbt/vpMbEdgeTracker.h>
+#include <visp3/mbt/vpMbtKeyFrameDatabase.h>
+
+namespace {
+const double cubeSize = 0.084;
+
+// Write the model of the cube [-s,0]x[0,s]x[0,s]
+void writeModel(const std::string &filename)
+{
+  std::ofstream file(filename.c_str());
+  file << "V1\n8\n"
+       << "0 0 0\n" << -cubeSize << " 0 0\n" << -cubeSize << " " << cubeSize << " 0\n0 " << cubeSize << " 0\n"
+       << "0 0 " << cubeSize << "\n" << -cubeSize << " 0 " << cubeSize << "\n"
+       << -cubeSize << " " << cubeSize << " " << cubeSize << "\n0 " << cubeSize << " " << cubeSize << "\n"
+       << "0\n0\n6\n4 0 4 5 1\n4 1 5 6 2\n4 6 7 3 2\n4 3 7 4 0\n4 0 1 2 3\n4 7 6 5 4\n0\n0\n";
+}
+
+// Render the cube covered by random blocks on a dark background
+void render(vpImage<unsigned char> &I, const vpCameraParameters &cam, const vpHomogeneousMatrix &cMo)
+{
+  I.resize(480, 640);
+  vpHomogeneousMatrix oMc = cMo.inverse();
+  double lo[3] = { -cubeSize, 0, 0 }, hi[3] = { 0, cubeSize, cubeSize };
+  for (unsigned int i = 0; i < I.getHeight(); i++) {
+    for (unsigned int j = 0; j < I.getWidth(); j++) {
+      double x = (j - cam.get_u0()) / cam.get_px(), y = (i - cam.get_v0()) / cam.get_py();
+      double d[3];
+      for (unsigned int k = 0; k < 3; k++)
+        d[k] = oMc[k][0] * x + oMc[k][1] * y + oMc[k][2];
+      // Intersection of the line of sight with the cube
+      double tnear = -1e9, tfar = 1e9;
+      unsigned int axis = 0;
+      for (unsigned int k = 0; k < 3; k++) {
+        double t1 = (lo[k] - oMc[k][3]) / d[k], t2 = (hi[k] - oMc[k][3]) / d[k];
+        if (t1 > t2) std::swap(t1, t2);
+        if (t1 > tnear) { tnear = t1; axis = k; }
+        if (t2 < tfar) tfar = t2;
+      }
+      unsigned char value = 25;
+      if (tnear < tfar && tnear > 0) {
+        double p[3];
+        for (unsigned int k = 0; k < 3; k++)
+          p[k] = oMc[k][3] + tnear * d[k];
+        int a = (int)floor(p[(axis + 1) % 3] * 250), b = (int)floor(p[(axis + 2) % 3] * 250);
+        unsigned int h = ((unsigned int)a * 73856093u) ^ ((unsigned int)b * 19349663u) ^ ((axis + 1) * 83492791u);
+        value = (unsigned char)(60 + 25 * (h % 7) + 10 * axis);
+      }
+      I[i][j] = value;
+    }
+  }
+}
+
+// Translation (mm) and rotation (deg) between two poses
+void poseError(const vpHomogeneousMatrix &cMo1, const vpHomogeneousMatrix &cMo2, double &t, double &r)
+{
+  vpPoseVector e(cMo1 * cMo2.inverse());
+  t = 1000 * sqrt(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+  r = vpMath::deg(sqrt(e[3] * e[3] + e[4] * e[4] + e[5] * e[5]));
+}
+
+bool samePose(const vpHomogeneousMatrix &cMo1, const vpHomogeneousMatrix &cMo2)
+{
+  for (unsigned int i = 0; i < 12; i++) {
+    if (cMo1.data[i] != cMo2.data[i])
+      return false;
+  }
+  return true;
+}
+
+bool testDatabase(const std::string &modelFile, const std::string &databaseFile)
+{
+  writeModel(modelFile);
+  vpCameraParameters cam(600, 600, 320, 240);
+  vpImage<unsigned char> I;
+
+  vpMbEdgeTracker tracker;
+  tracker.setCameraParameters(cam);
+  tracker.setAngleAppear(vpMath::rad(70));
+  tracker.setAngleDisappear(vpMath::rad(80));
+  tracker.loadModel(modelFile);
+
+  // Keyframes around the cube
+  vpHomogeneousMatrix cMo0(0.04, -0.04, 0.30, vpMath::rad(30), vpMath::rad(-35), vpMath::rad(15));
+  std::vector<vpHomogeneousMatrix> keyFramePoses;
+  keyFramePoses.push_back(cMo0);
+  keyFramePoses.push_back(vpHomogeneousMatrix(0.03, 0.01, 0.01, vpMath::rad(5), vpMath::rad(20), vpMath::rad(0)) * cMo0);
+  keyFramePoses.push_back(vpHomogeneousMatrix(-0.02, 0.02, 0.02, vpMath::rad(-15), vpMath::rad(-5), vpMath::rad(10)) * cMo0);
+
+  vpMbtKeyFrameDatabase database;
+  for (size_t k = 0; k < keyFramePoses.size(); k++) {
+    render(I, cam, keyFramePoses[k]);
+    tracker.initFromPose(I, keyFramePoses[k]);
+    if (! database.addKeyFrame(I, cam, keyFramePoses[k], tracker.getPolygonFaces(true, true))) {
+      std::cerr << "Cannot add the keyframe " << k << std::endl;
+      return false;
+    }
+  }
+  std::cout << database.getNbKeyFrames() << " keyframes, " << database.getNbPoints() << " points" << std::endl;
+  if (database.getNbKeyFrames() != keyFramePoses.size()) {
+    std::cerr << "Bad number of keyframes" << std::endl;
+    return false;
+  }
+
+  // Relocalize from views close to the keyframes
+  std::vector<vpHomogeneousMatrix> queryPoses, localizedPoses;
+  queryPoses.push_back(vpHomogeneousMatrix(0.004, -0.003, 0.005, vpMath::rad(2), vpMath::rad(-1), vpMath::rad(3))
+                       * keyFramePoses[0]);
+  queryPoses.push_back(vpHomogeneousMatrix(-0.005, 0.002, -0.004, vpMath::rad(-1), vpMath::rad(3), vpMath::rad(-2))
+                       * keyFramePoses[1]);
+  for (size_t k = 0; k < queryPoses.size(); k++) {
+    render(I, cam, queryPoses[k]);
+    vpHomogeneousMatrix cMo;
+    if (! database.localize(I, cam, cMo)) {
+      std::cerr << "Cannot localize the view " << k << std::endl;
+      return false;
+    }
+    double t, r;
+    poseError(cMo, queryPoses[k], t, r);
+    std::cout << "View " << k << ": error " << t << " mm, " << r << " deg" << std::endl;
+    if (t > 3 || r > 1) {
+      std::cerr << "The localized pose is too far from the true pose" << std::endl;
+      return false;
+    }
+    localizedPoses.push_back(cMo);
+  }
+
+  // A view of the background only cannot be localized
+  I = 25;
+  vpHomogeneousMatrix cMo;
+  if (database.localize(I, cam, cMo)) {
+    std::cerr << "An empty view should not be localized" << std::endl;
+    return false;
+  }
+
+  // Round-trip through a binary archive
+  {
+    vpBinaryArchive ar(databaseFile, vpBinaryArchive::WRITE);
+    database.saveState(ar);
+  }
+  vpMbtKeyFrameDatabase database2;
+  {
+    vpBinaryArchive ar(databaseFile, vpBinaryArchive::READ);
+    database2.loadState(ar);
+  }
+  if (database2.getNbKeyFrames() != database.getNbKeyFrames() || database2.getNbPoints() != database.getNbPoints()) {
+    std::cerr << "The loaded database has not the same keyframes" << std::endl;
+    return false;
+  }
+  for (unsigned int k = 0; k < database.getNbKeyFrames(); k++) {
+    if (! samePose(database2.getKeyFramePose(k), database.getKeyFramePose(k))) {
+      std::cerr << "The pose of the loaded keyframe " << k << " differs" << std::endl;
+      return false;
+    }
+  }
+  for (size_t k = 0; k < queryPoses.size(); k++) {
+    render(I, cam, queryPoses[k]);
+    if (! database2.localize(I, cam, cMo) || ! samePose(cMo, localizedPoses[k])) {
+      std::cerr << "The loaded database does not give the same pose for the view " << k << std::endl;
+      return false;
+    }
+  }
+  std::cout << "Database state: ok" << std::endl;
+
+  return true;
+}
+}
+
+int main()
+{
+  std::string modelFile = vpIoTools::createFilePath(vpIoTools::getTempPath(), "testMbtKeyFrameDatabase.cao");
+  std::string databaseFile = vpIoTools::createFilePath(vpIoTools::getTempPath(), "testMbtKeyFrameDatabase.bin");
+  bool ok = false;
+  try {
+    ok = testDatabase(modelFile, databaseFile);
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+  }
+
+  if (vpIoTools::checkFilename(modelFile))
+    vpIoTools::remove(modelFile);
+  if (vpIoTools::checkFilename(databaseFile))
+    vpIoTools::remove(databaseFile);
+  return ok ? 0 : 1;
+}
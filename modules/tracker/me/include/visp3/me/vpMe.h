@@ -49,6 +49,10 @@
 #include <visp3/core/vpMath.h>
 #include <visp3/core/vpImage.h>
 
+#include <vector>
+
+class vpBinaryArchive;
+
 /*!
   \class vpMe
   \ingroup module_me
@@ -85,6 +89,16 @@ private:
   //int graph ;
   vpMatrix *mask ; //! Array of matrices defining the different masks (one for every angle step).
 
+private:
+  //! Integer copy of the masks, mask_size x mask_size coefficients per mask stored row by row.
+  std::vector<short> mask_table;
+  //! If true, the position of the sites along the normal is refined to subpixel accuracy.
+  bool subpixel;
+  //! If true, the range of each site is adapted to its motion.
+  bool adaptive_range;
+  //! Minimal range of a site when the adaptive range is used.
+  unsigned int min_range;
+
 public:
   vpMe() ;
   vpMe(const vpMe &me) ;
@@ -104,6 +118,19 @@ public:
   */
   inline vpMatrix* getMask() const { return mask; }
 
+  /*!
+    Get the coefficients of a mask as a flat array of getMaskSize() x
+    getMaskSize() integers stored row by row. The coefficients are the same
+    as the ones of getMask()[index].
+
+    \param index : Index of the mask, in [0, getMaskNumber()[.
+
+    \return Pointer to the first coefficient of the mask.
+  */
+  inline const short* getMaskTable(const unsigned int index) const {
+    return &mask_table[index*mask_size*mask_size];
+  }
+
   /*!
     Set the number of mask applied to determine the object contour. The number of mask determines the precision of
     the normal of the edge for every sample. If precision is 2deg, then there
@@ -223,6 +250,44 @@ public:
     \return Value of range.
   */
   inline unsigned int getRange() const { return range; }
+
+  /*!
+    Enable or disable the adaptive range. When enabled, each site is sought
+    within a range that depends on its last displacement along the normal and
+    on the displacement predicted by its tracker
+    (see vpMeTracker::setPredictedDisplacement()): the range is the minimal
+    range plus these displacements, bounded by getRange(). Slow sites are then
+    sought in a small range, while fast ones keep the full range. When
+    disabled, the range is getRange() for all the sites.
+
+    \param adaptive : true to use an adaptive range. Default is false.
+
+    \sa setMinRange(), setRange()
+  */
+  void setAdaptiveRange(const bool adaptive) { adaptive_range = adaptive; }
+
+  /*!
+    \return true if the range of the sites is adapted to their motion.
+
+    \sa setAdaptiveRange()
+  */
+  inline bool getAdaptiveRange() const { return adaptive_range; }
+
+  /*!
+    Set the minimal range of a site when the adaptive range is used.
+
+    \param r : minimal range. Default is 2.
+
+    \sa setAdaptiveRange()
+  */
+  void setMinRange(const unsigned int &r) { min_range = r; }
+
+  /*!
+    \return The minimal range of a site when the adaptive range is used.
+
+    \sa setAdaptiveRange()
+  */
+  inline unsigned int getMinRange() const { return min_range; }
   
   /*!
     Set the angle step.
@@ -293,9 +358,32 @@ public:
     \return Value of threshold.
   */
   inline double getThreshold() const { return threshold; }
+
+  /*!
+    Enable or disable the subpixel localisation of the sites. When enabled,
+    the position of a site along the normal is refined by fitting a parabola
+    to the mask responses of the best candidate and of its two neighbours.
+
+    \param enable : true to localise the sites with a subpixel accuracy.
+    Default is false.
+  */
+  void setSubPixel(const bool enable) { subpixel = enable; }
+
+  /*!
+    \return true if the sites are localised with a subpixel accuracy.
+
+    \sa setSubPixel()
+  */
+  inline bool getSubPixel() const { return subpixel; }
 };
 
 
+//! Section tag of a vpMe in a vpBinaryArchive.
+#define VP_ARCHIVE_TAG_ME 0x2020454d // "ME  "
+
+VISP_EXPORT vpBinaryArchive &operator<<(vpBinaryArchive &ar, const vpMe &me);
+VISP_EXPORT vpBinaryArchive &operator>>(vpBinaryArchive &ar, vpMe &me);
+
 #endif
 
 
@@ -51,6 +51,7 @@
 #include <math.h>
 #include <iostream>
 #include <list>
+#include <vector>
 
 /*!
   \class vpMeNurbs
@@ -147,6 +148,10 @@ class VISP_EXPORT vpMeNurbs : public vpMeTracker
     double cannyTh1;
     //! Second canny threshold
     double cannyTh2;
+    //! Parameters at which the nurbs is sampled by sampleCurve().
+    std::vector<double> curveParams;
+    //! Points of the nurbs at the parameters curveParams.
+    std::vector<vpImagePoint> curvePoints;
 
   public:
     vpMeNurbs();
@@ -216,6 +221,8 @@ class VISP_EXPORT vpMeNurbs : public vpMeTracker
     void computeFreemanParameters( unsigned int element, vpImagePoint &diP);
     
     bool farFromImageEdge(const vpImage<unsigned char>& I, const vpImagePoint& iP);
+
+    void sampleCurve();
     
 public:
     static void display(const vpImage<unsigned char>& I, vpNurbs &n, vpColor color = vpColor::green);
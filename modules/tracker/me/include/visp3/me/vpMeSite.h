@@ -109,6 +109,10 @@ private:
   vpMeSiteDisplayType selectDisplay ;
   vpMeSiteState state;
 
+  void subPixelLocalisation(const vpImage<unsigned char>& I, const short *mask,
+                            const unsigned int msize, const int border,
+                            const double salpha, const double calpha);
+
 public:
   void init() ;
   void init(double ip, double jp, double alphap) ;
@@ -129,6 +133,10 @@ public:
   void track(const vpImage<unsigned char>& im,
 	     const vpMe *me,
 	     const  bool test_contraste=true);
+  void track(const vpImage<unsigned char>& im,
+             const vpMe *me,
+             const bool test_contraste,
+             const unsigned int range);
   
   /*!
     Set the angle of tangent at site
@@ -226,7 +234,7 @@ public:
 
     \return the distance between the two sites.
   */
-  static double distance (const vpMeSite S1, const vpMeSite S2) {
+  static double distance (const vpMeSite &S1, const vpMeSite &S2) {
     return(sqrt(vpMath::sqr(S1.ifloat-S2.ifloat)+vpMath::sqr(S1.jfloat-S2.jfloat)));}
     
   /*!
@@ -237,7 +245,7 @@ public:
 
     \return the distance between the two sites.
   */
-  static double sqrDistance (const vpMeSite S1, const vpMeSite S2) {
+  static double sqrDistance (const vpMeSite &S1, const vpMeSite &S2) {
     return(vpMath::sqr(S1.ifloat-S2.ifloat)+vpMath::sqr(S1.jfloat-S2.jfloat));}
     
   static void display(const vpImage<unsigned char>& I, const double &i, const double &j,
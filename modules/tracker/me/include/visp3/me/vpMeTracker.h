@@ -78,6 +78,8 @@ protected:
   
 protected:
   vpMeSite::vpMeSiteDisplayType selectDisplay ;
+  //! Expected displacement of the sites along their normal, in pixels.
+  double predicted_displacement;
 
 public:
   // Constructor/Destructor
@@ -106,6 +108,11 @@ public:
   
   int outOfImage( int i , int j , int half , int rows , int cols) ;
   int outOfImage( vpImagePoint iP , int half , int rows , int cols) ;
+
+protected:
+  unsigned int siteRange(const vpMeSite &s) const;
+
+public:
   
   void reset();
 
@@ -126,6 +133,23 @@ public:
     \return Value of init_range.
   */
   inline unsigned int getInitRange() { return init_range; }
+
+  /*!
+    Set the displacement of the sites along their normal that is expected
+    at the next call to track(), for instance from a motion model. It is only
+    used when the adaptive range is enabled in the moving edges parameters
+    (see vpMe::setAdaptiveRange()) to enlarge the range of the sites.
+
+    \param d : expected displacement in pixels. Default is 0.
+  */
+  void setPredictedDisplacement(const double d) { predicted_displacement = d; }
+
+  /*!
+    \return The expected displacement of the sites along their normal in pixels.
+
+    \sa setPredictedDisplacement()
+  */
+  inline double getPredictedDisplacement() const { return predicted_displacement; }
   
   /*!
     Set the moving edges initialisation parameters
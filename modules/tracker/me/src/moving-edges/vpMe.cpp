@@ -44,6 +44,7 @@
 
 
 #include <visp3/me/vpMe.h>
+#include <visp3/core/vpBinaryArchive.h>
 #include <visp3/core/vpColVector.h>
 #include <visp3/core/vpMath.h>
 #include <stdlib.h>
@@ -379,6 +380,14 @@ vpMe::initMask()
 
   calcul_masques(angle, mask_size, mask ) ;
 
+  // Masks coefficients are integers in [-100, 100]. Keep a packed copy used
+  // by vpMeSite to compute the convolutions with integer arithmetic.
+  unsigned int msize2 = mask_size*mask_size;
+  mask_table.resize(n_mask*msize2);
+  for (unsigned int n = 0 ; n < n_mask ; n++)
+    for (unsigned int a = 0 ; a < mask_size ; a++)
+      for (unsigned int b = 0 ; b < mask_size ; b++)
+        mask_table[n*msize2 + a*mask_size + b] = (short)vpMath::round(mask[n][a][b]);
 }
 
 
@@ -393,17 +402,20 @@ vpMe::print( )
   std::cout<<" Size of the convolution masks...."<<mask_size<<"x"<<mask_size<<" pixels"<<std::endl ;
   std::cout<<" Number of masks.................."<<n_mask<<"        "<<std::endl ;
   std::cout<<" Query range +/- J................"<<range<<" pixels  "<<std::endl ;
+  if (adaptive_range)
+    std::cout<<" Adaptive range, min +/- J........"<<min_range<<" pixels  "<<std::endl ;
   std::cout<<" Likelihood test ratio............"<<threshold<<std::endl ;
   std::cout<<" Contrast tolerance +/-..........."<< mu1 * 100<<"% and "<<mu2 * 100<<"%     "<<std::endl ;
   std::cout<<" Sample step......................"<<sample_step<<" pixels"<<std::endl ;
   std::cout<<" Strip............................"<<strip<<" pixels  "<<std::endl ;
   std::cout<<" Min_Samplestep..................."<<min_samplestep<<" pixels  "<<std::endl ;
+  std::cout<<" Subpixel localisation............"<<(subpixel ? "yes" : "no")<<std::endl ;
 }
 
 vpMe::vpMe()
   : threshold(1500), mu1(0.5), mu2(0.5), min_samplestep(4), anglestep(1), mask_sign(0),
     range(4), sample_step(10), ntotal_sample(0), points_to_track(500), mask_size(5),
-    n_mask(180), strip(2), mask(NULL)
+    n_mask(180), strip(2), mask(NULL), mask_table(), subpixel(false), adaptive_range(false), min_range(2)
 {
   //ntotal_sample = 0; // not sure that it is used
   //points_to_track = 500; // not sure that it is used
@@ -415,7 +427,7 @@ vpMe::vpMe()
 vpMe::vpMe(const vpMe &me)
   : threshold(1500), mu1(0.5), mu2(0.5), min_samplestep(4), anglestep(1), mask_sign(0),
     range(4), sample_step(10), ntotal_sample(0), points_to_track(500), mask_size(5),
-    n_mask(180), strip(2), mask(NULL)
+    n_mask(180), strip(2), mask(NULL), mask_table(), subpixel(false), adaptive_range(false), min_range(2)
 {
   *this = me;
 }
@@ -440,6 +452,9 @@ vpMe& vpMe::operator=(const vpMe &me)
   ntotal_sample = me.ntotal_sample;
   points_to_track = me.points_to_track;
   strip = me.strip ;
+  subpixel = me.subpixel ;
+  adaptive_range = me.adaptive_range ;
+  min_range = me.min_range ;
   
   initMask() ;
   return *this;
@@ -470,6 +485,84 @@ vpMe::setMaskSize(const unsigned int &s)
   initMask() ;
 }
 
+/*!
+  Save the moving-edges parameters in a binary archive.
 
+  \sa vpBinaryArchive
+*/
+vpBinaryArchive &operator<<(vpBinaryArchive &ar, const vpMe &me)
+{
+  ar.writeSection(VP_ARCHIVE_TAG_ME, 2);
+  ar.writeValue(me.getThreshold());
+  ar.writeValue(me.getMu1());
+  ar.writeValue(me.getMu2());
+  ar.writeValue(me.getMinSampleStep());
+  ar.writeValue(me.getSampleStep());
+  ar.writeValue(me.getAngleStep());
+  ar.writeValue(me.getMaskSign());
+  ar.writeValue(me.getRange());
+  ar.writeValue(me.getNbTotalSample());
+  ar.writeValue(me.getPointsToTrack());
+  ar.writeValue(me.getMaskSize());
+  ar.writeValue(me.getMaskNumber());
+  ar.writeValue(me.getStrip());
+  ar.writeValue((unsigned char)me.getSubPixel());
+  ar.writeValue((unsigned char)me.getAdaptiveRange());
+  ar.writeValue(me.getMinRange());
+  return ar;
+}
 
+/*!
+  Load the moving-edges parameters from a binary archive. The convolution masks
+  are computed again from the loaded parameters.
 
+  \sa vpBinaryArchive
+*/
+vpBinaryArchive &operator>>(vpBinaryArchive &ar, vpMe &me)
+{
+  unsigned int version = ar.readSection(VP_ARCHIVE_TAG_ME, 2);
+  double threshold, mu1, mu2, min_samplestep, sample_step;
+  unsigned int anglestep, range, mask_size, n_mask;
+  int mask_sign, ntotal_sample, points_to_track, strip;
+
+  ar.readValue(threshold);
+  ar.readValue(mu1);
+  ar.readValue(mu2);
+  ar.readValue(min_samplestep);
+  ar.readValue(sample_step);
+  ar.readValue(anglestep);
+  ar.readValue(mask_sign);
+  ar.readValue(range);
+  ar.readValue(ntotal_sample);
+  ar.readValue(points_to_track);
+  ar.readValue(mask_size);
+  ar.readValue(n_mask);
+  ar.readValue(strip);
+
+  me.setThreshold(threshold);
+  me.setMu1(mu1);
+  me.setMu2(mu2);
+  me.setMinSampleStep(min_samplestep);
+  me.setSampleStep(sample_step);
+  me.setMaskSign(mask_sign);
+  me.setRange(range);
+  me.setNbTotalSample(ntotal_sample);
+  me.setPointsToTrack(points_to_track);
+  me.setStrip(strip);
+  me.setMaskSize(mask_size);
+  me.setMaskNumber(n_mask);
+  me.setAngleStep(anglestep);
+
+  // Added in version 2
+  if (version >= 2) {
+    unsigned char subpixel, adaptive_range;
+    unsigned int min_range;
+    ar.readValue(subpixel);
+    ar.readValue(adaptive_range);
+    ar.readValue(min_range);
+    me.setSubPixel(subpixel != 0);
+    me.setAdaptiveRange(adaptive_range != 0);
+    me.setMinRange(min_range);
+  }
+  return ar;
+}
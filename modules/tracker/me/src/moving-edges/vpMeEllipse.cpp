@@ -49,6 +49,8 @@
 #include <limits>   // numeric_limits
 #include <vector>
 
+#include "vpMeNormalEquations_impl.h"
+
 void computeTheta(double &theta, vpColVector &K, vpImagePoint iP);
 
 /*!
@@ -385,16 +387,13 @@ vpMeEllipse::computeAngle(vpImagePoint pt1, vpImagePoint pt2)
 void
 vpMeEllipse::updateTheta()
 {
-  vpMeSite p_me;
   double theta;
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-    p_me = *it;
     vpImagePoint iP;
-    iP.set_i(p_me.ifloat);
-    iP.set_j(p_me.jfloat);
+    iP.set_i(it->ifloat);
+    iP.set_j(it->jfloat);
     computeTheta(theta, K, iP) ;
-    p_me.alpha = theta ;
-    *it = p_me;
+    it->alpha = theta ;
   }
 }
 
@@ -407,7 +406,7 @@ vpMeEllipse::suppressPoints()
   // Loop through list of sites to track
   std::list<vpMeSite>::iterator itList = list.begin();
   for(std::list<double>::iterator it=angle.begin(); it!=angle.end(); ){
-    vpMeSite s = *itList;//current reference pixel
+    const vpMeSite &s = *itList;//current reference pixel
     if (s.getState() != vpMeSite::NO_SUPPRESSION)
     {
       itList = list.erase(itList) ;
@@ -444,14 +443,10 @@ vpMeEllipse::seekExtremities(const vpImage<unsigned char>  &I)
 
   vpImagePoint ip;
 
-  unsigned int  memory_range = me->getRange() ;
-  me->setRange(2);
-
-  double  memory_mu1 = me->getMu1();
-  me->setMu1(0.5);
-
-  double  memory_mu2 = me->getMu2();
-  me->setMu2(0.5);
+  // The new points are searched in a small range. The shared moving-edges
+  // parameters are not modified so that several trackers can use them
+  // concurrently.
+  const unsigned int range = 2;
 
   double incr = vpMath::rad(2.0) ;
 
@@ -473,7 +468,7 @@ vpMeEllipse::seekExtremities(const vpImage<unsigned char>  &I)
 
       if(!outOfImage(P.i, P.j, 5, rows, cols))
       {
-        P.track(I,me,false) ;
+        P.track(I,me,false,range) ;
 
         if (P.getState() == vpMeSite::NO_SUPPRESSION)
         {
@@ -510,7 +505,7 @@ vpMeEllipse::seekExtremities(const vpImage<unsigned char>  &I)
 
       if(!outOfImage(P.i, P.j, 5, rows, cols))
       {
-        P.track(I,me,false) ;
+        P.track(I,me,false,range) ;
 
         if (P.getState() == vpMeSite::NO_SUPPRESSION)
         {
@@ -535,10 +530,6 @@ vpMeEllipse::seekExtremities(const vpImage<unsigned char>  &I)
   }
 
   suppressPoints() ;
-
-  me->setRange(memory_range);
-  me->setMu1(memory_mu1);
-  me->setMu2(memory_mu2);
 }
 
 
@@ -559,7 +550,7 @@ vpMeEllipse::setExtremities()
   std::list<double>::const_iterator itAngle = angle.begin();
 
   for(std::list<vpMeSite>::const_iterator itList=list.begin(); itList!=list.end(); ++itList){
-    vpMeSite s = *itList;//current reference pixel
+    const vpMeSite &s = *itList;//current reference pixel
     double alpha = *itAngle;
     if (alpha < alphamin)
     {
@@ -588,6 +579,13 @@ vpMeEllipse::setExtremities()
   Least squares method used to make the tracking more robust. It
   ensures that the points taken into account to compute the right
   equation belong to the ellipse.
+
+  The first solution is computed with the weights of the sites estimated at
+  the previous call (vpMeSite::weight). The M-estimator then recomputes all
+  the weights, and at each iteration the normal equations are only updated
+  for the sites whose weight changed. The
+  coordinates of the sites are centered and scaled to keep the normal
+  equations well conditioned.
 */
 void
 vpMeEllipse::leastSquare()
@@ -595,85 +593,114 @@ vpMeEllipse::leastSquare()
   // Construction du systeme Ax=b
   // i^2 + K0 j^2 + 2 K1 i j + 2 K2 i + 2 K3 j + K4
   // A = (j^2 2ij 2i 2j 1)   x = (K0 K1 K2 K3 K4)^T  b = (-i^2 )
-  unsigned int i ;
-
-  vpMeSite p_me ;
-
-  unsigned int iter =0 ;
-  vpColVector b_(numberOfSignal()) ;
-  vpRobust r(numberOfSignal()) ;
-  r.setThreshold(2);
-  r.setIteration(0) ;
-  vpMatrix D(numberOfSignal(),numberOfSignal()) ;
-  D.eye() ;
-  vpMatrix DA, DAmemory ;
-  vpColVector DAx ;
-  vpColVector w(numberOfSignal()) ;
-  w =1 ;
   unsigned int nos_1 = numberOfSignal() ;
 
-  if (list.size() < 3)
+  if (list.size() < 3 || nos_1 == 0)
   {
     throw(vpException(vpException::dimensionError,
                       "Not enought moving edges to track the ellipse")) ;
   }
 
-  vpMatrix A(numberOfSignal(),5) ;
+  // The system is written for the normalized coordinates u = (i - ic)/s and
+  // v = (j - jc)/s, where (ic, jc) is the centroid of the sites and s their
+  // mean distance to the centroid.
+  double ic = 0, jc = 0 ;
+  for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
+    if (it->getState() == vpMeSite::NO_SUPPRESSION)
+    {
+      ic += it->ifloat ;
+      jc += it->jfloat ;
+    }
+  }
+  ic /= nos_1 ;
+  jc /= nos_1 ;
+  double s = 0 ;
+  for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
+    if (it->getState() == vpMeSite::NO_SUPPRESSION)
+      s += sqrt(vpMath::sqr(it->ifloat - ic) + vpMath::sqr(it->jfloat - jc)) ;
+  }
+  s /= nos_1 ;
+  if (s < 1)
+    s = 1 ;
+  double s2 = s * s ;
+
+  vpMatrix A(nos_1,5) ;
+  vpColVector b_(nos_1) ;
+  vpColVector w(nos_1) ;
+  vpColVector residu(nos_1) ;
   vpColVector x(5);
+  vpMeNormalEquations normal(5) ;
 
   unsigned int k =0 ;
   for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
-    p_me = *it;
-    if (p_me.getState() == vpMeSite::NO_SUPPRESSION)
+    if (it->getState() == vpMeSite::NO_SUPPRESSION)
     {
-      A[k][0] = vpMath::sqr(p_me.jfloat) ;
-      A[k][1] = 2 * p_me.ifloat * p_me.jfloat ;
-      A[k][2] = 2 * p_me.ifloat ;
-      A[k][3] = 2 * p_me.jfloat ;
+      double u = (it->ifloat - ic) / s ;
+      double v = (it->jfloat - jc) / s ;
+      A[k][0] = vpMath::sqr(v) ;
+      A[k][1] = 2 * u * v ;
+      A[k][2] = 2 * u ;
+      A[k][3] = 2 * v ;
       A[k][4] = 1 ;
 
-      b_[k] = - vpMath::sqr(p_me.ifloat) ;
+      b_[k] = - vpMath::sqr(u) ;
+      w[k] = it->weight ;
+      normal.add(A[k], b_[k], vpMath::sqr(w[k])) ;
       k++ ;
     }
   }
 
+  vpRobust r(nos_1) ;
+  r.setThreshold(2);
+  r.setIteration(0) ;
+  vpColVector w_new(nos_1) ;
+  unsigned int iter =0 ;
   while (iter < 4 )
   {
-    DA = D*A ;
-    vpMatrix DAp ;
-
-    x = DA.pseudoInverse(1e-26) *D*b_ ;
+    x = normal.solve() ;
 
-    vpColVector residu(nos_1);
-    residu = b_ - A*x;
+    // Residuals are expressed in the original image coordinates
+    residu = (b_ - A*x) * s2 ;
     r.setIteration(iter) ;
-    r.MEstimator(vpRobust::TUKEY,residu,w) ;
+    // The previous weights only seed the first solution: the M-estimator
+    // starts from unit weights, so that the sites rejected at the previous
+    // image are considered again, then it keeps the null weights
+    if (iter == 0)
+      w_new = 1 ;
+    else
+      w_new = w ;
+    r.MEstimator(vpRobust::TUKEY,residu,w_new) ;
 
-    k = 0;
-    for (i=0 ; i < nos_1 ; i++)
+    for (k = 0 ; k < nos_1 ; k++)
     {
-      D[k][k] =w[k]  ;
-      k++;
+      if (w_new[k] != w[k]) {
+        normal.add(A[k], b_[k], vpMath::sqr(w_new[k]) - vpMath::sqr(w[k])) ;
+        w[k] = w_new[k] ;
+      }
     }
     iter++;
   }
 
   k =0 ;
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-    p_me = *it;
-    if (p_me.getState() == vpMeSite::NO_SUPPRESSION)
+    if (it->getState() == vpMeSite::NO_SUPPRESSION)
     {
+      it->weight = w[k] ;
       if (w[k] < thresholdWeight)
       {
-        p_me.setState(vpMeSite::M_ESTIMATOR);
-
-        *it = p_me;
+        it->setState(vpMeSite::M_ESTIMATOR);
       }
       k++ ;
     }
   }
-  for(i = 0; i < 5; i ++)
-    K[i] = x[i];
+
+  // Back to the image coordinates
+  K[0] = x[0] ;
+  K[1] = x[1] ;
+  K[2] = s * x[2] - ic - K[1] * jc ;
+  K[3] = s * x[3] - K[0] * jc - K[1] * ic ;
+  K[4] = s2 * x[4] - ic * ic - K[0] * jc * jc - 2 * K[1] * ic * jc
+      - 2 * K[2] * ic - 2 * K[3] * jc ;
 
   getParameters() ;
 }
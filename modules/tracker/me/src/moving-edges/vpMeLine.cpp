@@ -56,6 +56,8 @@
 #include <limits>   // numeric_limits
 #include <algorithm>    // std::min
 
+#include "vpMeNormalEquations_impl.h"
+
 #define INCR_MIN 1
 
 void computeDelta(double &delta, int i1, int j1, int i2, int j2);
@@ -283,31 +285,15 @@ vpMeLine::initTracking(const vpImage<unsigned char> &I)
   Least squares method used to make the tracking more robust. It
   ensures that the points taken into account to compute the right
   equation belong to the line.
+
+  The first solution is computed with the weights of the sites estimated at
+  the previous call (vpMeSite::weight). The M-estimator then recomputes all
+  the weights, and at each iteration the normal equations are only updated
+  for the sites whose weight changed.
 */
 void
 vpMeLine::leastSquare()
 {
-  vpMatrix A(numberOfSignal(),2) ;
-  vpColVector x(2), x_1(2) ;
-  x_1 = 0;
-
-  unsigned int i ;
-
-  vpRobust r(numberOfSignal()) ;
-  r.setThreshold(2);
-  r.setIteration(0) ;
-  vpMatrix D(numberOfSignal(),numberOfSignal()) ;
-  D.eye() ;
-  vpMatrix DA, DAmemory ;
-  vpColVector DAx ;
-  vpColVector w(numberOfSignal()) ;
-  vpColVector B(numberOfSignal()) ;
-  w =1 ;
-  vpMeSite p_me ;
-  unsigned int iter =0 ;
-  unsigned int nos_1 = 0 ;
-  double distance = 100;
-
   if (list.size() <= 2 || numberOfSignal() <= 2)
   {
     //vpERROR_TRACE("Not enough point") ;
@@ -316,132 +302,94 @@ vpMeLine::leastSquare()
                               "not enough point")) ;
   }
 
-  if ((fabs(b) >=0.9)) // Construction du systeme Ax=B
-    // a i + j + c = 0
-    // A = (i 1)   B = (-j)
-  {
-    nos_1 = numberOfSignal() ;
-    unsigned int k =0 ;
-    for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
-      p_me = *it;
-      if (p_me.getState() == vpMeSite::NO_SUPPRESSION)
-      {
-        A[k][0] = p_me.ifloat ;
-        A[k][1] = 1 ;
-        B[k] = -p_me.jfloat ;
-        k++ ;
-      }
-    }
-
-    while (iter < 4 && distance > 0.05)
-    {
-      DA = D*A ;
-      x = DA.pseudoInverse(1e-26) *D*B ;
-
-      vpColVector residu(nos_1);
-      residu = B - A*x;
-      r.setIteration(iter) ;
-      r.MEstimator(vpRobust::TUKEY,residu,w) ;
+  unsigned int nos_1 = numberOfSignal() ;
+  vpMatrix A(nos_1,2) ;
+  vpColVector B(nos_1) ;
+  vpColVector w(nos_1) ;
+  vpColVector residu(nos_1) ;
+  vpColVector x(2), x_1(2) ;
+  x_1 = 0;
 
-      k = 0;
-      for (i=0 ; i < nos_1 ; i++)
-      {
-        D[k][k] =w[k]  ;
-        k++;
-      }
-      iter++ ;
-      distance = fabs(x[0]-x_1[0])+fabs(x[1]-x_1[1]);
-      x_1 = x;
-    }
+  vpRobust r(nos_1) ;
+  r.setThreshold(2);
+  r.setIteration(0) ;
 
-    k =0 ;
-    for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-      p_me = *it;
-      if (p_me.getState() == vpMeSite::NO_SUPPRESSION)
-      {
-        if (w[k] < 0.2)
-        {
-          p_me.setState(vpMeSite::M_ESTIMATOR);
-          
-          *it = p_me;
-        }
-        k++ ;
-      }
+  // Construction du systeme Ax=B
+  //   if |b| >= 0.9: a i + j + c = 0, A = (i 1)   B = (-j)
+  //   else         : i + b j + c = 0, A = (j 1)   B = (-i)
+  bool horizontal = (fabs(b) >= 0.9) ;
+  vpMeNormalEquations normal(2) ;
+  unsigned int k = 0 ;
+  for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
+    if (it->getState() == vpMeSite::NO_SUPPRESSION)
+    {
+      A[k][0] = horizontal ? it->ifloat : it->jfloat ;
+      A[k][1] = 1 ;
+      B[k] = horizontal ? -it->jfloat : -it->ifloat ;
+      w[k] = it->weight ;
+      normal.add(A[k], B[k], vpMath::sqr(w[k])) ;
+      k++ ;
     }
-
-    // mise a jour de l'equation de la droite
-    a = x[0] ;
-    b = 1 ;
-    c = x[1] ;
-
-    double s =sqrt( vpMath::sqr(a)+vpMath::sqr(b)) ;
-    a /= s ;
-    b /= s ;
-    c /= s ;
   }
 
-
-  else		// Construction du systeme Ax=B
-    // i + bj + c = 0
-    // A = (j 1)   B = (-i)
+  vpColVector w_new(nos_1) ;
+  unsigned int iter = 0 ;
+  double distance = 100;
+  while (iter < 4 && distance > 0.05)
   {
-    nos_1 = numberOfSignal() ;
-    unsigned int k =0 ;
-    for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
-      p_me = *it;
-      if (p_me.getState() == vpMeSite::NO_SUPPRESSION)
-      {
-        A[k][0] = p_me.jfloat ;
-        A[k][1] = 1 ;
-        B[k] = -p_me.ifloat ;
-        k++ ;
-      }
-    }
+    x = normal.solve() ;
+
+    residu = B - A*x;
+    r.setIteration(iter) ;
+    // The previous weights only seed the first solution: the M-estimator
+    // starts from unit weights, so that the sites rejected at the previous
+    // image are considered again, then it keeps the null weights
+    if (iter == 0)
+      w_new = 1 ;
+    else
+      w_new = w ;
+    r.MEstimator(vpRobust::TUKEY,residu,w_new) ;
 
-    while (iter < 4 && distance > 0.05)
+    for (k = 0 ; k < nos_1 ; k++)
     {
-      DA = D*A ;
-      x = DA.pseudoInverse(1e-26) *D*B ;
-
-      vpColVector residu(nos_1);
-      residu = B - A*x;
-      r.setIteration(iter) ;
-      r.MEstimator(vpRobust::TUKEY,residu,w) ;
-
-      k = 0;
-      for (i=0 ; i < nos_1 ; i++)
-      {
-        D[k][k] =w[k]  ;
-        k++;
+      if (w_new[k] != w[k]) {
+        normal.add(A[k], B[k], vpMath::sqr(w_new[k]) - vpMath::sqr(w[k])) ;
+        w[k] = w_new[k] ;
       }
-      iter++ ;
-      distance = fabs(x[0]-x_1[0])+fabs(x[1]-x_1[1]);
-      x_1 = x;
     }
+    iter++ ;
+    distance = fabs(x[0]-x_1[0])+fabs(x[1]-x_1[1]);
+    x_1 = x;
+  }
 
-    k =0 ;
-    for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-      p_me = *it;
-      if (p_me.getState() == vpMeSite::NO_SUPPRESSION)
+  k =0 ;
+  for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
+    if (it->getState() == vpMeSite::NO_SUPPRESSION)
+    {
+      it->weight = w[k] ;
+      if (w[k] < 0.2)
       {
-        if (w[k] < 0.2)
-        {
-          p_me.setState(vpMeSite::M_ESTIMATOR);
-          
-          *it = p_me;
-        }
-        k++ ;
+        it->setState(vpMeSite::M_ESTIMATOR);
       }
+      k++ ;
     }
+  }
+
+  // mise a jour de l'equation de la droite
+  if (horizontal) {
+    a = x[0] ;
+    b = 1 ;
+  }
+  else {
     a = 1 ;
     b = x[0] ;
-    c = x[1] ;
-
-    double s = sqrt(vpMath::sqr(a)+vpMath::sqr(b)) ;
-    a /= s ;
-    b /= s ;
-    c /= s ;
   }
+  c = x[1] ;
+
+  double s =sqrt( vpMath::sqr(a)+vpMath::sqr(b)) ;
+  a /= s ;
+  b /= s ;
+  c /= s ;
 
   // mise a jour du delta
   delta = atan2(a,b) ;
@@ -523,7 +471,7 @@ vpMeLine::suppressPoints()
 {
   // Loop through list of sites to track
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ){
-    vpMeSite s = *it;//current reference pixel
+    const vpMeSite &s = *it;//current reference pixel
 
     if (s.getState() != vpMeSite::NO_SUPPRESSION)
       it = list.erase(it);
@@ -547,7 +495,7 @@ vpMeLine::setExtremities()
 
   // Loop through list of sites to track
   for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
-    vpMeSite s = *it;//current reference pixel
+    const vpMeSite &s = *it;//current reference pixel
     if (s.ifloat < imin)
     {
       imin = s.ifloat ;
@@ -569,7 +517,7 @@ vpMeLine::setExtremities()
   if (fabs(imin-imax) < 25)
   {
     for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
-      vpMeSite s = *it;//current reference pixel
+      const vpMeSite &s = *it;//current reference pixel
       if (s.jfloat < jmin)
       {
         imin = s.ifloat ;
@@ -642,8 +590,8 @@ vpMeLine::seekExtremities(const vpImage<unsigned char> &I)
   P.init((int) PExt[0].ifloat, (int)PExt[0].jfloat, delta_1, 0, sign) ;
   P.setDisplay(selectDisplay) ;
 
-  unsigned int  memory_range = me->getRange() ;
-  me->setRange(1);
+  // Search range of the new points
+  const unsigned int range = 1;
 
   vpImagePoint ip;
 
@@ -654,7 +602,7 @@ vpMeLine::seekExtremities(const vpImage<unsigned char> &I)
 
     if(!outOfImage(P.i, P.j, 5, rows, cols))
     {
-      P.track(I,me,false) ;
+      P.track(I,me,false,range) ;
 
       if (P.getState() == vpMeSite::NO_SUPPRESSION)
       {
@@ -685,7 +633,7 @@ vpMeLine::seekExtremities(const vpImage<unsigned char> &I)
 
     if(!outOfImage(P.i, P.j, 5, rows, cols))
     {
-      P.track(I,me,false) ;
+      P.track(I,me,false,range) ;
 
       if (P.getState() == vpMeSite::NO_SUPPRESSION)
       {
@@ -706,8 +654,6 @@ vpMeLine::seekExtremities(const vpImage<unsigned char> &I)
     }
   }
 
-  me->setRange(memory_range);
-
   vpCDEBUG(1) <<"end vpMeLine::sample() : " ;
   vpCDEBUG(1) << n_sample << " point inserted in the list " << std::endl  ;
 }
@@ -769,8 +715,6 @@ vpMeLine::reSample(const vpImage<unsigned char> &I)
 void
 vpMeLine::updateDelta()
 {
-  vpMeSite p_me ;
-
   double angle_ = delta + M_PI/2;
   double diff = 0;
 
@@ -793,10 +737,8 @@ vpMeLine::updateDelta()
   angle_1 = angle_;
 
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-    p_me = *it;
-    p_me.alpha = delta ;
-    p_me.mask_sign = sign;
-    *it = p_me;
+    it->alpha = delta ;
+    it->mask_sign = sign;
   }
   delta_1 = delta;
 }
@@ -1309,7 +1251,7 @@ void vpMeLine::display(const vpImage<unsigned char>& I,const vpMeSite &PExt1, co
   vpImagePoint ip;
   
   for(std::list<vpMeSite>::const_iterator it=site_list.begin(); it!=site_list.end(); ++it){
-    vpMeSite pix = *it;
+    const vpMeSite &pix = *it;
     ip.set_i( pix.ifloat );
     ip.set_j( pix.jfloat );
 
@@ -1391,7 +1333,7 @@ void vpMeLine::display(const vpImage<vpRGBa>& I,const vpMeSite &PExt1, const vpM
   vpImagePoint ip;
 
   for(std::list<vpMeSite>::const_iterator it=site_list.begin(); it!=site_list.end(); ++it){
-    vpMeSite pix = *it;
+    const vpMeSite &pix = *it;
     ip.set_i( pix.ifloat );
     ip.set_j( pix.jfloat );
 
@@ -0,0 +1,83 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Weighted normal equations of the moving edges least squares fits.
+ *
+ *****************************************************************************/
+
+#ifndef __vpMeNormalEquations_impl_h_
+#define __vpMeNormalEquations_impl_h_
+
+#include <visp3/core/vpColVector.h>
+#include <visp3/core/vpMatrix.h>
+
+/*!
+  Normal equations A^T W A x = A^T W b of a weighted linear least squares
+  problem, accumulated row by row. A row is added or removed in O(n^2) with n
+  the number of unknowns, whatever the number of rows, so that the robust fits
+  of vpMeLine and vpMeEllipse only update the sites whose weight changed.
+*/
+class vpMeNormalEquations
+{
+public:
+  explicit vpMeNormalEquations(unsigned int n) : AtA(n, n), Atb(n) {}
+
+  //! Add the row \e a with right-hand side \e b and weight \e w.
+  void add(const double *a, double b, double w)
+  {
+    unsigned int n = Atb.getRows();
+    for (unsigned int k = 0; k < n; k++) {
+      double wa = w * a[k];
+      for (unsigned int l = k; l < n; l++)
+        AtA[k][l] += wa * a[l];
+      Atb[k] += wa * b;
+    }
+  }
+
+  //! Remove a row previously added with the same weight.
+  void remove(const double *a, double b, double w) { add(a, b, -w); }
+
+  //! Least squares solution of the accumulated system.
+  vpColVector solve() const
+  {
+    vpMatrix M(AtA);
+    unsigned int n = Atb.getRows();
+    for (unsigned int k = 0; k < n; k++)
+      for (unsigned int l = 0; l < k; l++)
+        M[k][l] = M[l][k];
+    return M.pseudoInverse(1e-26) * Atb;
+  }
+
+private:
+  vpMatrix AtA; // upper triangle only
+  vpColVector Atb;
+};
+
+#endif
@@ -225,7 +225,7 @@ bool findCenterPoint(std::list<vpImagePoint> *ip_edges_list)
 */
 vpMeNurbs::vpMeNurbs()
   : nurbs(), dist(0.), nbControlPoints(20), beginPtFound(0), endPtFound(0), enableCannyDetection(false),
-    cannyTh1(100.), cannyTh2(200.)
+    cannyTh1(100.), cannyTh2(200.), curveParams(), curvePoints()
 {
 }
 
@@ -235,7 +235,7 @@ vpMeNurbs::vpMeNurbs()
 vpMeNurbs::vpMeNurbs(const vpMeNurbs &menurbs)
   : vpMeTracker(menurbs),
     nurbs(), dist(0.), nbControlPoints(20), beginPtFound(0), endPtFound(0), enableCannyDetection(false),
-    cannyTh1(100.), cannyTh2(200.)
+    cannyTh1(100.), cannyTh2(200.), curveParams(), curvePoints()
 {
   nurbs = menurbs.nurbs;
   dist = menurbs.dist;
@@ -245,6 +245,8 @@ vpMeNurbs::vpMeNurbs(const vpMeNurbs &menurbs)
   enableCannyDetection = menurbs.enableCannyDetection;
   cannyTh1 = menurbs.cannyTh1;
   cannyTh2 = menurbs.cannyTh2;
+  curveParams = menurbs.curveParams;
+  curvePoints = menurbs.curvePoints;
 }
 
 /*!
@@ -356,7 +358,7 @@ void
 vpMeNurbs::suppressPoints()
 {
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ){
-    vpMeSite s = *it;//current reference pixel
+    const vpMeSite &s = *it;//current reference pixel
 
     if (s.getState() != vpMeSite::NO_SUPPRESSION)
     {
@@ -375,34 +377,33 @@ vpMeNurbs::suppressPoints()
 void
 vpMeNurbs::updateDelta()
 {
-  double u = 0.0;
+  sampleCurve();
+
+  unsigned int k = 0;
+  unsigned int nbPoints = (unsigned int)curveParams.size();
   double d = 1e6;
   double d_1 = 1e6;
   std::list<vpMeSite>::iterator it=list.begin();
   
-  vpImagePoint Cu;
   vpImagePoint* der = NULL;
-  double step = 0.01;
-  while (u < 1 && it!=list.end())
+  while (k < nbPoints && curveParams[k] < 1 && it!=list.end())
   {
-    vpMeSite s = *it;
+    vpMeSite &s = *it;
     vpImagePoint pt(s.i,s.j);
-    while (d <= d_1 && u<1)
+    while (d <= d_1 && k < nbPoints && curveParams[k] < 1)
     {
-      Cu = nurbs.computeCurvePoint(u);
       d_1=d;
-      d = vpImagePoint::distance(pt,Cu);
-      u +=step;
+      d = vpImagePoint::distance(pt,curvePoints[k]);
+      k++;
     }
     
-    u-=step;
+    k--;
     if (der != NULL) delete[] der;
-    der = nurbs.computeCurveDersPoint(u, 1);
+    der = nurbs.computeCurveDersPoint(curveParams[k], 1);
       //vpImagePoint toto(der[0].get_i(),der[0].get_j());
       //vpDisplay::displayCross(I,toto,4,vpColor::red);
     
     s.alpha = computeDelta(der[1].get_i(),der[1].get_j());
-    *it = s;
     ++it;
     d = 1e6;
     d_1 = 1.5e6;
@@ -632,7 +633,7 @@ vpMeNurbs::seekExtremitiesCanny(const vpImage<unsigned char> & /* I */)
     if (findCenterPoint(&ip_edges_list))
     {
       for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); /*++it*/){
-        vpMeSite s = *it;
+        const vpMeSite &s = *it;
         vpImagePoint iP(s.ifloat,s.jfloat);
         if (inRectangle(iP,rect))
           it = list.erase(it) ;
@@ -646,7 +647,7 @@ vpMeNurbs::seekExtremitiesCanny(const vpImage<unsigned char> & /* I */)
       int nbr = 0;
       std::list<vpMeSite> addedPt;
       for(std::list<vpImagePoint>::const_iterator itEdges=ip_edges_list.begin(); itEdges!=ip_edges_list.end(); ++itEdges){
-        vpMeSite s = *itList;
+        const vpMeSite &s = *itList;
         vpImagePoint iPtemp = *itEdges + topLeft;
         vpMeSite pix;
         pix.init(iPtemp.get_i(), iPtemp.get_j(), delta);
@@ -678,9 +679,7 @@ vpMeNurbs::seekExtremitiesCanny(const vpImage<unsigned char> & /* I */)
       std::list<vpMeSite>::iterator itList2=list.begin();
       for (int j = 0; j < nbr; j++)
       {
-        vpMeSite s = *itList2;
-        s.track(I,me,false);
-        *itList2 = s;
+        itList2->track(I,me,false);
         ++itList2;
       }
       me->setRange(memory_range);
@@ -823,9 +822,7 @@ vpMeNurbs::seekExtremitiesCanny(const vpImage<unsigned char> & /* I */)
       --itList2; // Move to the last element
       for (int j = 0; j < nbr; j++)
       {
-        vpMeSite me_s = *itList2;
-        me_s.track(I,me,false);
-        *itList2 = me_s;
+        itList2->track(I,me,false);
         --itList2;
       }
       me->setRange(memory_range);
@@ -878,19 +875,19 @@ vpMeNurbs::localReSample(const vpImage<unsigned char> &I)
   vpImagePoint* iP = NULL;
   
   int n = (int)numberOfSignal();
+
+  sampleCurve();
   
 //  list.front();
   std::list<vpMeSite>::iterator it=list.begin();
   std::list<vpMeSite>::iterator itNext=list.begin();
   ++itNext;
 
-  unsigned int range_tmp = me->getRange();
-  me->setRange(2);
 
   while(itNext!=list.end() && n <= me->getPointsToTrack())
   {
-    vpMeSite s = *it;//current reference pixel
-    vpMeSite s_next = *itNext;//current reference pixel
+    const vpMeSite &s = *it;//current reference pixel
+    const vpMeSite &s_next = *itNext;//current reference pixel
     
     double d = vpMeSite::sqrDistance(s,s_next);
     if(d > 4 * vpMath::sqr(me->getSampleStep()) && d < 1600)
@@ -899,16 +896,15 @@ vpMeNurbs::localReSample(const vpImage<unsigned char> &I)
       vpImagePoint iPend(s_next.ifloat,s_next.jfloat);
       vpImagePoint iP_1(s.ifloat,s.jfloat);
 
-      double u = 0.0;
       double ubegin = 0.0;
       double uend = 0.0;
       double dmin1_1 = 1e6;
       double dmin2_1 = 1e6;
-      while(u < 1)
+      for (unsigned int k = 1; k < curveParams.size(); k++)
       {
-        u+=0.01;
-        double dmin1 = vpImagePoint::sqrDistance(nurbs.computeCurvePoint(u),iP0);
-        double dmin2 = vpImagePoint::sqrDistance(nurbs.computeCurvePoint(u),iPend);
+        double u = curveParams[k];
+        double dmin1 = vpImagePoint::sqrDistance(curvePoints[k],iP0);
+        double dmin2 = vpImagePoint::sqrDistance(curvePoints[k],iPend);
 
         if (dmin1 < dmin1_1)
         {
@@ -922,7 +918,7 @@ vpMeNurbs::localReSample(const vpImage<unsigned char> &I)
           uend = u;
         }
       }
-      u = ubegin;
+      double u = ubegin;
       
       //if(( u != 1.0 || uend != 1.0)
       if( (std::fabs(u-1.0) > std::fabs(vpMath::maximum(u, 1.0))*std::numeric_limits<double>::epsilon())
@@ -944,7 +940,7 @@ vpMeNurbs::localReSample(const vpImage<unsigned char> &I)
             vpMeSite pix ; //= list.value();
             pix.init(iP[0].get_i(), iP[0].get_j(), delta) ;
             pix.setDisplay(selectDisplay) ;
-            pix.track(I,me,false);
+            pix.track(I,me,false,2);
             if (pix.getState() == vpMeSite::NO_SUPPRESSION)
             {
               list.insert(it, pix);
@@ -961,7 +957,6 @@ vpMeNurbs::localReSample(const vpImage<unsigned char> &I)
     ++it;
     ++itNext;
   }
-  me->setRange(range_tmp);
 }
 
 
@@ -997,13 +992,9 @@ vpMeNurbs::supressNearPoints()
   std::list<vpMeSite>::iterator itNext=list.begin();
   ++itNext;
   for(;itNext!=list.end();){
-    vpMeSite s = *it;//current reference pixel
-    vpMeSite s_next = *itNext;//current reference pixel
+    if(vpMeSite::sqrDistance(*it,*itNext) < vpMath::sqr(me->getSampleStep())){
+      itNext->setState(vpMeSite::TOO_NEAR);
 
-    if(vpMeSite::sqrDistance(s,s_next) < vpMath::sqr(me->getSampleStep())){
-      s_next.setState(vpMeSite::TOO_NEAR);
-          
-      *itNext = s_next;
       ++it;
       ++itNext;
       if(itNext!=list.end()){
@@ -1053,26 +1044,40 @@ vpMeNurbs::track(const vpImage<unsigned char> &I)
 //   nurbs.globalCurveInterp(list);
   nurbs.globalCurveApprox(list,nbControlPoints);
   
-  double u = 0.0;
-  vpImagePoint pt;
-  vpImagePoint pt_1;
-  dist = 0;
-  while (u<=1.0)
-  {
-    pt = nurbs.computeCurvePoint(u);
-    //if(u!=0)
-    if(std::fabs(u) > std::numeric_limits<double>::epsilon())
-      dist = dist + vpImagePoint::distance(pt,pt_1);
-    pt_1 = pt;
-    u=u+0.01;
-  }
-
+  // updateDelta() samples the new nurbs, the same points give its length
   updateDelta();
 
+  dist = 0;
+  for (unsigned int k = 1; k < curveParams.size() && curveParams[k] <= 1.0; k++)
+    dist = dist + vpImagePoint::distance(curvePoints[k],curvePoints[k-1]);
+
   reSample(I);
 }
 
 
+/*!
+  Sample the nurbs at the parameters 0, 0.01, ..., 1 used to search the
+  points of the curve closest to the sites. The samples are shared by
+  localReSample(), updateDelta() and track() instead of evaluating the nurbs
+  again for each site.
+*/
+void
+vpMeNurbs::sampleCurve()
+{
+  curveParams.clear();
+  curvePoints.clear();
+  double u = 0.0;
+  curveParams.push_back(u);
+  curvePoints.push_back(nurbs.computeCurvePoint(u));
+  while (u < 1)
+  {
+    u += 0.01;
+    curveParams.push_back(u);
+    curvePoints.push_back(nurbs.computeCurvePoint(u));
+  }
+}
+
+
 /*!
   Display edge.
 
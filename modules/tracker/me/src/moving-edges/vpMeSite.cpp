@@ -63,6 +63,69 @@ bool horsImage(int i , int j, int half, int rows, int cols)
   //return((i < half + 1) || ( i > (rows - half - 3) )||(j < half + 1) || (j > (cols - half - 3) )) ;
   return( (0 < (half_1 - i) ) || ( (i - rows + half_3) > 0 ) || ( 0 < (half_1 -j) ) || ( (j - cols + half_3)  > 0 ) ) ;
 }
+
+// Index of the mask corresponding to the normal direction alpha
+static
+unsigned int maskIndex(double alpha, const vpMe *me)
+{
+  // Calculate tangent angle from normal
+  double theta  = alpha+M_PI/2;
+  // Move tangent angle to within 0->M_PI for a positive
+  // mask index
+  while (theta<0) theta += M_PI;
+  while (theta>M_PI) theta -= M_PI;
+
+  // Convert radians to degrees
+  int thetadeg = vpMath::round(theta * 180 / M_PI) ;
+
+  if(abs(thetadeg) == 180 )
+  {
+    thetadeg= 0 ;
+  }
+
+  return (unsigned int)(thetadeg/(double)me->getAngleStep());
+}
+
+// Integer convolution of a msize x msize mask with the image patch whose top
+// left corner is (i0, j0). The size is a template parameter for the usual
+// masks so that the inner loops are fully unrolled and vectorized.
+template <unsigned int msize>
+static
+int maskConvolution(const vpImage<unsigned char> &I, unsigned int i0, unsigned int j0,
+                    const short *mask)
+{
+  int conv = 0;
+  for (unsigned int a = 0 ; a < msize ; a++) {
+    const unsigned char *pix = I[i0+a] + j0;
+    const short *coef = mask + a*msize;
+    for (unsigned int b = 0 ; b < msize ; b++)
+      conv += coef[b] * pix[b];
+  }
+  return conv;
+}
+
+static
+int maskConvolution(const vpImage<unsigned char> &I, unsigned int i0, unsigned int j0,
+                    const short *mask, unsigned int msize)
+{
+  switch (msize) {
+  case 3: return maskConvolution<3>(I, i0, j0, mask);
+  case 5: return maskConvolution<5>(I, i0, j0, mask);
+  case 7: return maskConvolution<7>(I, i0, j0, mask);
+  case 9: return maskConvolution<9>(I, i0, j0, mask);
+  default:
+    break;
+  }
+
+  int conv = 0;
+  for (unsigned int a = 0 ; a < msize ; a++) {
+    const unsigned char *pix = I[i0+a] + j0;
+    const short *coef = mask + a*msize;
+    for (unsigned int b = 0 ; b < msize ; b++)
+      conv += coef[b] * pix[b];
+  }
+  return conv;
+}
 #endif
 
 void
@@ -321,41 +384,9 @@ vpMeSite::convolution(const vpImage<unsigned char>&I, const  vpMe *me)
   }
   else
   {
-    // Calculate tangent angle from normal
-    double theta  = alpha+M_PI/2;
-    // Move tangent angle to within 0->M_PI for a positive
-    // mask index
-    while (theta<0) theta += M_PI;
-    while (theta>M_PI) theta -= M_PI;
-
-    // Convert radians to degrees
-    int thetadeg = vpMath::round(theta * 180 / M_PI) ;
-
-    if(abs(thetadeg) == 180 )
-    {
-      thetadeg= 0 ;
-    }
-
-    unsigned int index_mask = (unsigned int)(thetadeg/(double)me->getAngleStep());
-
-    unsigned int i_ = static_cast<unsigned int>(i);
-    unsigned int j_ = static_cast<unsigned int>(j);
-    unsigned int half_ = static_cast<unsigned int>(half);
-
-    unsigned int ihalf = i_-half_ ;
-    unsigned int jhalf = j_-half_ ;
-
-    for(unsigned int a = 0 ; a < msize ; a++ )
-    {
-      unsigned int ihalfa = ihalf+a ;
-      for(unsigned int b = 0 ; b < msize ; b++ )
-      {
-        conv += mask_sign* me->getMask()[index_mask][a][b] *
-            //	  I(i-half+a,j-half+b) ;
-            I(ihalfa,jhalf+b) ;
-      }
-    }
-
+    const short *mask = me->getMaskTable(maskIndex(alpha, me));
+    conv = mask_sign * maskConvolution(I, static_cast<unsigned int>(i - half),
+                                       static_cast<unsigned int>(j - half), mask, msize);
   }
 
   return(conv) ;
@@ -366,6 +397,9 @@ vpMeSite::convolution(const vpImage<unsigned char>&I, const  vpMe *me)
 
   Specific function for ME.
 
+  When vpMe::getSubPixel() is true, the position of the site along the normal
+  is refined to subpixel accuracy.
+
   \warning To display the moving edges graphics a call to vpDisplay::flush()
   is needed.
 
@@ -374,6 +408,28 @@ void
 vpMeSite::track(const vpImage<unsigned char>& I,
                 const vpMe *me,
                 const bool test_contraste)
+{
+  track(I, me, test_contraste, me->getRange());
+}
+
+/*!
+
+  Specific function for ME. Same as track(const vpImage<unsigned char>&, const vpMe *, const bool)
+  but the site is sought in \e range pixels on both sides along the normal
+  instead of vpMe::getRange(). This allows to use a different range without
+  modifying the moving-edges parameters that may be shared by several trackers.
+
+  \param I : Image in which the site is tracked.
+  \param me : Moving-edges parameters.
+  \param test_contraste : When true, the contrast of the site is taken into account.
+  \param range : +/- range within which the site is sought.
+
+*/
+void
+vpMeSite::track(const vpImage<unsigned char>& I,
+                const vpMe *me,
+                const bool test_contraste,
+                const unsigned int range)
 {
   //   vpMeSite  *list_query_pixels ;
   //   int  max_rank =0 ;
@@ -497,110 +553,129 @@ vpMeSite::track(const vpImage<unsigned char>& I,
   //       delete []likelihood; // modif portage
   //     }
 
-  vpMeSite  *list_query_pixels ;
-  int  max_rank =-1 ;
-  //   int max_rank1=-1 ;
-  //   int max_rank2 = -1;
-  double  max_convolution = 0 ;
-  double max = 0 ;
-  double contraste = 0;
-  //  vpDisplay::display(I) ;
-  //  vpERROR_TRACE("getclcik %d",me->range) ;
-  //  vpDisplay::getClick(I) ;
-
-  // range = +/- range of pixels within which the correspondent
+  // range_ = +/- range of pixels within which the correspondent
   // of the current pixel will be sought
-  unsigned int range  = me->getRange() ;
-
-  //  std::cout << i << "  " << j<<"  " << range << "  " << suppress  << std::endl ;
-  list_query_pixels = getQueryList(I, (int)range) ;
+  int range_  = static_cast<int>(range) ;
 
   double  contraste_max = 1 + me->getMu2();
   double  contraste_min = 1 - me->getMu1();
+  double threshold = me->getThreshold() ;
+
+  int height_ = static_cast<int>(I.getHeight());
+  int width_  = static_cast<int>(I.getWidth());
+  unsigned int msize = me->getMaskSize();
+  int half = (static_cast<int>(msize) - 1) >> 1 ;
+  int border = half + me->getStrip();
 
-  // array in which likelihood ratios will be stored
-  double  *likelihood= new double[ 2 * range + 1 ] ;
+  // All the candidates lie along the normal to the contour: they share the
+  // same mask and are only represented by their coordinates.
+  const short *mask = me->getMaskTable(maskIndex(alpha, me));
+  double salpha = sin(alpha);
+  double calpha = cos(alpha);
 
-  int ii_1 = i ;
-  int jj_1 = j ;
-  i_1 = i ;
-  j_1 = j ;
-  double threshold;
-  threshold = me->getThreshold() ;
+  int  max_rank =-1 ;
+  double  max_convolution = 0 ;
+  double max = 0 ;
+  double contraste = 0;
   double diff = 1e6;
+  double max_ifloat = 0, max_jfloat = 0;
+  int max_i = 0, max_j = 0;
 
-  //    std::cout <<"---------------------"<<std::endl ;
-  for(unsigned int n = 0 ; n < 2 * range + 1 ; n++)
+  for(int k = -range_ ; k <= range_ ; k++)
   {
+    double ii = ifloat+k*salpha;
+    double jj = jfloat+k*calpha;
+    int ci = (int)ii;
+    int cj = (int)jj;
+
     //   convolution results
-    double convolution_ = list_query_pixels[n].convolution(I, me) ;
+    double convolution_ ;
+    if(horsImage(ci, cj, border, height_, width_))
+    {
+      convolution_ = 0.0;
+      ci = 0 ; cj = 0 ;
+    }
+    else
+      convolution_ = mask_sign * maskConvolution(I, static_cast<unsigned int>(ci - half),
+                                                 static_cast<unsigned int>(cj - half), mask, msize);
 
     // luminance ratio of reference pixel to potential correspondent pixel
     // the luminance must be similar, hence the ratio value should
     // lay between, for instance, 0.5 and 1.5 (parameter tolerance)
+    double likelihood ;
+    bool best = false ;
     if( test_contraste )
     {
-      likelihood[n] = fabs(convolution_ + convlt );
-      if (likelihood[n]> threshold)
+      likelihood = fabs(convolution_ + convlt );
+      if (likelihood > threshold)
       {
         contraste = convolution_ / convlt;
         if((contraste > contraste_min) && (contraste < contraste_max) && fabs(1-contraste) < diff)
         {
           diff = fabs(1-contraste);
-          max_convolution= convolution_;
-          max = likelihood[n] ;
-          max_rank = (int)n ;
-          // 	    max_rank2 = max_rank1;
-          // 	    max_rank1 = max_rank;
+          best = true;
         }
       }
     }
-
     else
     {
-      likelihood[n] = fabs(2*convolution_) ;
-      if (likelihood[n] > max  && likelihood[n] > threshold)
-      {
-        max_convolution= convolution_;
-        max = likelihood[n] ;
-        max_rank = (int)n ;
-        //           max_rank2 = max_rank1;
-        //           max_rank1 = max_rank;
-      }
+      likelihood = fabs(2*convolution_) ;
+      best = (likelihood > max  && likelihood > threshold);
+    }
+
+    if (best)
+    {
+      max_convolution= convolution_;
+      max = likelihood ;
+      max_rank = k + range_ ;
+      max_ifloat = ii ; max_jfloat = jj ;
+      max_i = ci ; max_j = cj ;
     }
   }
-  
-  // test on the likelihood threshold if threshold==-1 then
-  // the me->threshold is  selected
 
-  vpImagePoint ip;
+  if ((selectDisplay==RANGE_RESULT)||(selectDisplay==RANGE))
+  {
+    for(int k = -range_ ; k <= range_ ; k++)
+      vpDisplay::displayCross(I, vpImagePoint(ifloat+k*salpha, jfloat+k*calpha), 1, vpColor::yellow) ;
+  }
+
+  i_1 = i ;
+  j_1 = j ;
 
-  //  if (test_contrast)
   if(max_rank >= 0)
   {
     if ((selectDisplay==RANGE_RESULT)||(selectDisplay==RESULT))
-    {
-      ip.set_i( list_query_pixels[max_rank].i );
-      ip.set_j( list_query_pixels[max_rank].j );
-      vpDisplay::displayPoint(I, ip, vpColor::red);
-    }
-		
-    *this = list_query_pixels[max_rank] ;//The vpMeSite2 is replaced by the vpMeSite2 of max likelihood
+      vpDisplay::displayPoint(I, vpImagePoint(max_i, max_j), vpColor::red);
+
+    // The site is replaced by the candidate of max likelihood
+    i = max_i ;
+    j = max_j ;
+    ifloat = max_ifloat ;
+    jfloat = max_jfloat ;
+
+    v = 0 ;
+    // weight is kept: it is the robust weight of the site estimated by the
+    // tracker at the previous image, used to warm start its fit.
+    state = NO_SUPPRESSION ;
+#ifdef VISP_BUILD_DEPRECATED_FUNCTIONS
+    suppress = 0 ;
+#endif
     normGradient =  vpMath::sqr(max_convolution);
-
     convlt = max_convolution;
-    i_1 = ii_1; //list_query_pixels[max_rank].i ;
-    j_1 = jj_1; //list_query_pixels[max_rank].j ;
-    delete []list_query_pixels ;
-    delete []likelihood;
+
+    if (me->getSubPixel())
+      subPixelLocalisation(I, mask, msize, border, salpha, calpha);
   }
   else //none of the query sites is better than the threshold
   {
     if ((selectDisplay==RANGE_RESULT)||(selectDisplay==RESULT))
     {
-      ip.set_i( list_query_pixels[0].i );
-      ip.set_j( list_query_pixels[0].j );
-      vpDisplay::displayPoint(I, ip, vpColor::green);
+      int ci = (int)(ifloat-range_*salpha);
+      int cj = (int)(jfloat-range_*calpha);
+      if(horsImage(ci, cj, border, height_, width_)) {
+        ci = 0 ; cj = 0 ;
+      }
+      vpDisplay::displayPoint(I, vpImagePoint(ci, cj), vpColor::green);
     }
     normGradient = 0 ;
     //if(contraste != 0)
@@ -608,12 +683,58 @@ vpMeSite::track(const vpImage<unsigned char>& I,
       state = CONSTRAST; // contrast suppression
     else
       state = THRESHOLD; // threshold suppression
-
-    delete []list_query_pixels ;
-    delete []likelihood; // modif portage
   }
 }
 
+/*!
+  Refine the position of the site along the normal to the contour. The
+  convolution is evaluated at the two neighbours of the site in the 8-connected
+  direction closest to the normal, and the site is moved to the vertex of the
+  parabola through the three absolute convolution values. The site is left
+  unchanged when it is not a local maximum or when a neighbour is outside the
+  image.
+
+  \param I : Image in which the site is tracked.
+  \param mask : Integer convolution mask of the site, see vpMe::getMaskTable().
+  \param msize : Size of the mask.
+  \param border : Half size of the mask increased by the strip.
+  \param salpha, calpha : Sine and cosine of the angle of the normal.
+*/
+void
+vpMeSite::subPixelLocalisation(const vpImage<unsigned char>& I, const short *mask,
+                               const unsigned int msize, const int border,
+                               const double salpha, const double calpha)
+{
+  int height_ = static_cast<int>(I.getHeight());
+  int width_  = static_cast<int>(I.getWidth());
+  int half = (static_cast<int>(msize) - 1) >> 1 ;
+  int di = vpMath::round(salpha);
+  int dj = vpMath::round(calpha);
+
+  if (horsImage(i - di, j - dj, border, height_, width_) ||
+      horsImage(i + di, j + dj, border, height_, width_))
+    return;
+
+  double l_prev = fabs(maskConvolution(I, static_cast<unsigned int>(i - di - half),
+                                       static_cast<unsigned int>(j - dj - half), mask, msize));
+  double l_next = fabs(maskConvolution(I, static_cast<unsigned int>(i + di - half),
+                                       static_cast<unsigned int>(j + dj - half), mask, msize));
+  double l = fabs(convlt);
+
+  double denom = l_prev - 2 * l + l_next;
+  if (l < l_prev || l < l_next || denom >= 0)
+    return;
+
+  double offset = 0.5 * (l_prev - l_next) / denom;
+  if (offset > 0.5)
+    offset = 0.5;
+  else if (offset < -0.5)
+    offset = -0.5;
+
+  ifloat = i + offset * di;
+  jfloat = j + offset * dj;
+}
+
 int vpMeSite::operator!=(const vpMeSite &m)
 {
   return((m.i != i) || (m.j != j)) ;
@@ -49,6 +49,7 @@
 #include <visp3/core/vpTrackingException.h>
 #include <visp3/core/vpDebug.h>
 #include <algorithm>
+#include <cmath>
 
 #define DEBUG_LEVEL1 0
 #define DEBUG_LEVEL2 0
@@ -62,7 +63,8 @@ vpMeTracker::init()
 }
 
 vpMeTracker::vpMeTracker()
-  : list(), me(NULL), init_range(1), nGoodElement(0), selectDisplay(vpMeSite::NONE)
+  : list(), me(NULL), init_range(1), nGoodElement(0), selectDisplay(vpMeSite::NONE),
+    predicted_displacement(0)
 #ifdef VISP_BUILD_DEPRECATED_FUNCTIONS
   , query_range (0), display_point(false)
 #endif
@@ -72,7 +74,8 @@ vpMeTracker::vpMeTracker()
 
 vpMeTracker::vpMeTracker(const vpMeTracker& meTracker)
   : vpTracker(meTracker),
-    list(), me(NULL), init_range(1), nGoodElement(0), selectDisplay(vpMeSite::NONE)
+    list(), me(NULL), init_range(1), nGoodElement(0), selectDisplay(vpMeSite::NONE),
+    predicted_displacement(0)
 #ifdef VISP_BUILD_DEPRECATED_FUNCTIONS
     , query_range (0), display_point(false)
 #endif
@@ -84,6 +87,7 @@ vpMeTracker::vpMeTracker(const vpMeTracker& meTracker)
   nGoodElement = meTracker.nGoodElement;
   init_range = meTracker.init_range;
   selectDisplay = meTracker.selectDisplay;
+  predicted_displacement = meTracker.predicted_displacement;
   
   #ifdef VISP_BUILD_DEPRECATED_FUNCTIONS
   display_point = meTracker.display_point;
@@ -111,6 +115,7 @@ vpMeTracker::operator = (vpMeTracker& p_me)
   list = p_me.list;
   me = p_me.me;
   selectDisplay = p_me.selectDisplay ;
+  predicted_displacement = p_me.predicted_displacement;
 
   return *this;
 }
@@ -173,10 +178,6 @@ vpMeTracker::initTracking(const vpImage<unsigned char>& I)
       "Moving edges not initialized")) ;
   }
 
-  // Must set range to 0
-  unsigned int range_tmp = me->getRange();
-  me->setRange(init_range);
-
   nGoodElement=0;
 
   int d = 0;
@@ -184,14 +185,14 @@ vpMeTracker::initTracking(const vpImage<unsigned char>& I)
 
   // Loop through list of sites to track
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-    vpMeSite refp = *it;//current reference pixel
+    vpMeSite &refp = *it;//current reference pixel
 
     d++ ;
     // If element hasn't been suppressed
     if(refp.getState() == vpMeSite::NO_SUPPRESSION)
     {
       try {
-        refp.track(I,me,false);
+        refp.track(I,me,false,init_range);
       }
       catch(...)
       {
@@ -217,7 +218,6 @@ vpMeTracker::initTracking(const vpImage<unsigned char>& I)
       }
     }
 #endif
-    *it = refp;
   }
 
   /*
@@ -238,8 +238,31 @@ vpMeTracker::initTracking(const vpImage<unsigned char>& I)
   return res ;
   }
   */
+}
+
+/*!
+  Compute the range within which a site is sought when the adaptive range
+  is enabled: the minimal range increased by the last displacement of the site
+  and by the predicted displacement, bounded by vpMe::getRange().
+
+  \param s : Site to track.
 
-  me->setRange(range_tmp);
+  \return Range of the site.
+*/
+unsigned int
+vpMeTracker::siteRange(const vpMeSite &s) const
+{
+  // A newly sampled site has no previous position and is sought in the
+  // full range.
+  if (s.i_1 == 0 && s.j_1 == 0)
+    return me->getRange();
+
+  double d = sqrt(vpMath::sqr(s.i - s.i_1) + vpMath::sqr(s.j - s.j_1))
+      + std::fabs(predicted_displacement);
+  double r = me->getMinRange() + ceil(d);
+  if (r > me->getRange())
+    return me->getRange();
+  return (unsigned int)r;
 }
 
 /*!
@@ -269,10 +292,12 @@ vpMeTracker::track(const vpImage<unsigned char>& I)
 
   vpImagePoint ip1, ip2;
   nGoodElement=0;
+  unsigned int range = me->getRange();
+  bool adaptive_range = me->getAdaptiveRange() && (me->getMinRange() < range);
   //  int d =0;
   // Loop through list of sites to track
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-    vpMeSite s = *it;//current reference pixel
+    vpMeSite &s = *it;//current reference pixel
 
     //    d++ ;
     // If element hasn't been suppressed
@@ -282,7 +307,10 @@ vpMeTracker::track(const vpImage<unsigned char>& I)
       try{
         //	vpERROR_TRACE("%d",d ) ;
         //	vpERROR_TRACE("range %d",me->range) ;
-        s.track(I,me,true);
+        if (adaptive_range)
+          s.track(I,me,true,siteRange(s));
+        else
+          s.track(I,me,true,range);
       }
       catch(vpTrackingException)
       {
@@ -310,7 +338,6 @@ vpMeTracker::track(const vpImage<unsigned char>& I)
 #endif
 
       }
-      *it = s;
     }
   }
 }
@@ -336,9 +363,8 @@ vpMeTracker::display(const vpImage<unsigned char>& I)
     std::cout<<" There are "<<list.size()<< " sites in the list " << std::endl ;
   }
 #endif
-  for(std::list<vpMeSite>::const_iterator it=list.begin(); it!=list.end(); ++it){
-    vpMeSite p_me = *it;
-    p_me.display(I);
+  for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
+    it->display(I);
   }
 }
 
@@ -352,15 +378,11 @@ void
 vpMeTracker::display(const vpImage<unsigned char>& I,vpColVector &w, unsigned int &index_w)
 {
   for(std::list<vpMeSite>::iterator it=list.begin(); it!=list.end(); ++it){
-    vpMeSite P = *it;
-
-    if(P.getState() == vpMeSite::NO_SUPPRESSION)
+    if(it->getState() == vpMeSite::NO_SUPPRESSION)
     {
-      P.weight = w[index_w];
+      it->weight = w[index_w];
       index_w++;
     }
-
-    *it = P;
   }
   display(I);
 }
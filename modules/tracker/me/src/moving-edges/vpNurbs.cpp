@@ -41,6 +41,7 @@
 #include <visp3/core/vpColVector.h>
 #include <cmath>    // std::fabs
 #include <limits>   // numeric_limits
+#include <algorithm>  // std::min, std::max
 /*
   Compute the distance d = |Pw1-Pw2|
 */
@@ -52,6 +53,98 @@ inline double distance(const vpImagePoint &iP1, const double w1, const vpImagePo
   return sqrt(vpMath::sqr(distancei)+vpMath::sqr(distancej)+vpMath::sqr(distancew));
 }
 
+namespace {
+/*
+  Square matrix of size n whose nonzero elements lie at most l_p columns away
+  from the diagonal. Row i is stored in band[i*(2*l_p+1) .. (i+1)*(2*l_p+1)[
+  and element (i, c) at index c - i + l_p of the row.
+*/
+class vpBandMatrix
+{
+public:
+  vpBandMatrix(unsigned int n, unsigned int l_p)
+    : size(n), p(l_p), band(n*(2*l_p+1), 0.0) {}
+
+  double &operator()(unsigned int i, unsigned int c) { return band[i*(2*p+1) + c + p - i]; }
+
+  /*
+    Solve the system for the three right-hand sides by Gaussian elimination
+    without pivoting, which keeps the fill-in within the band. This is stable
+    for the B-spline collocation matrices and for the normal equations of the
+    least squares approximation. Return false if a pivot vanishes.
+  */
+  bool solve(vpColVector &x1, vpColVector &x2, vpColVector &x3)
+  {
+    double scale = 0;
+    for (unsigned int k = 0; k < band.size(); k++)
+      scale = std::max(scale, std::fabs(band[k]));
+
+    for (unsigned int c = 0; c < size; c++) {
+      double pivot = (*this)(c, c);
+      if (std::fabs(pivot) <= scale * 1e-12)
+        return false;
+      unsigned int last = std::min(size - 1, c + p);
+      for (unsigned int r = c + 1; r <= last; r++) {
+        double f = (*this)(r, c) / pivot;
+        if (f == 0.)
+          continue;
+        for (unsigned int col = c; col <= last; col++)
+          (*this)(r, col) -= f * (*this)(c, col);
+        x1[r] -= f * x1[c];
+        x2[r] -= f * x2[c];
+        x3[r] -= f * x3[c];
+      }
+    }
+    for (unsigned int c = size; c-- > 0; ) {
+      unsigned int last = std::min(size - 1, c + p);
+      for (unsigned int col = c + 1; col <= last; col++) {
+        x1[c] -= (*this)(c, col) * x1[col];
+        x2[c] -= (*this)(c, col) * x2[col];
+        x3[c] -= (*this)(c, col) * x3[col];
+      }
+      double pivot = (*this)(c, c);
+      x1[c] /= pivot;
+      x2[c] /= pivot;
+      x3[c] /= pivot;
+    }
+    return true;
+  }
+
+  vpMatrix toMatrix() const
+  {
+    vpMatrix M(size, size);
+    for (unsigned int i = 0; i < size; i++)
+      for (unsigned int c = (i > p ? i - p : 0); c <= std::min(size - 1, i + p); c++)
+        M[i][c] = band[i*(2*p+1) + c + p - i];
+    return M;
+  }
+
+private:
+  unsigned int size;
+  unsigned int p;
+  std::vector<double> band;
+};
+
+/*
+  Solve the banded system A x = b for three right-hand sides. When A is
+  singular, fall back on the least squares solution given by the
+  pseudo-inverse of A.
+*/
+void solveBanded(vpBandMatrix &A, vpColVector &x1, vpColVector &x2, vpColVector &x3)
+{
+  vpBandMatrix A_ = A;
+  vpColVector b1 = x1, b2 = x2, b3 = x3;
+  if (A.solve(x1, x2, x3))
+    return;
+
+  vpMatrix Minv;
+  A_.toMatrix().pseudoInverse(Minv);
+  x1 = Minv*b1;
+  x2 = Minv*b2;
+  x3 = Minv*b3;
+}
+}
+
 
 /*!
   Basic constructor.
@@ -735,31 +828,28 @@ void vpNurbs::globalCurveInterp(std::vector<vpImagePoint> &l_crossingPoints, uns
   for(unsigned int k = m-l_p; k <= m; k++)
     l_knots.push_back(1.0);
     
-  vpMatrix A(n+1,n+1);
+  // The collocation matrix is banded: row i only has the l_p+1 nonvanishing
+  // basis functions at ubar[i].
+  vpBandMatrix A(n+1, l_p);
   vpBasisFunction* N;
 
   for(unsigned int i = 0; i <= n; i++)
   {
     unsigned int span = findSpan(ubar[i], l_p, l_knots);
     N = computeBasisFuns(ubar[i], span, l_p, l_knots);
-    for (unsigned int k = 0; k <= l_p; k++) A[i][span-l_p+k] = N[k].value;
+    for (unsigned int k = 0; k <= l_p; k++) A(i, span-l_p+k) = N[k].value;
     delete[] N;
   }
-  //vpMatrix Ainv = A.inverseByLU();
-  vpMatrix Ainv;
-  A.pseudoInverse(Ainv);
-  vpColVector Qi(n+1);
-  vpColVector Qj(n+1);
-  vpColVector Qw(n+1);
+  vpColVector Pi(n+1);
+  vpColVector Pj(n+1);
+  vpColVector Pw(n+1);
   for (unsigned int k = 0; k <= n; k++)
   {
-    Qi[k] = l_crossingPoints[k].get_i();
-    Qj[k] = l_crossingPoints[k].get_j();
+    Pi[k] = l_crossingPoints[k].get_i();
+    Pj[k] = l_crossingPoints[k].get_j();
   }
-  Qw = 1;
-  vpColVector Pi = Ainv*Qi;
-  vpColVector Pj = Ainv*Qj;
-  vpColVector Pw = Ainv*Qw;
+  Pw = 1;
+  solveBanded(A, Pi, Pj, Pw);
 
   vpImagePoint pt;
   for (unsigned int k = 0; k <= n; k++)
@@ -902,80 +992,52 @@ void vpNurbs::globalCurveApprox(std::vector<vpImagePoint> &l_crossingPoints, uns
   for(unsigned int k = 0; k <= l_p ; k++)
     l_knots.push_back(1.0);
 
-  //Compute Rk
-  std::vector<vpImagePoint> Rk;
+  // Least squares system N^T N P = R for the l_n-1 inner control points, the
+  // first and last ones being the first and last data points. N^T N is
+  // banded, so it is accumulated directly with the l_p+1 nonvanishing basis
+  // functions at each data point.
+  vpBandMatrix AtA(l_n-1, l_p);
+  vpColVector Pi(l_n-1);
+  vpColVector Pj(l_n-1);
+  vpColVector Pw(l_n-1);
   vpBasisFunction* N;
   for(unsigned int k = 1; k <= m-1; k++)
   {
     unsigned int span = findSpan(ubar[k], l_p, l_knots);
-    if (span == l_p && span == l_n) 
-    {
-      N = computeBasisFuns(ubar[k], span, l_p, l_knots);
-      vpImagePoint pt(l_crossingPoints[k].get_i()-N[0].value*l_crossingPoints[0].get_i()-N[l_p].value*l_crossingPoints[m].get_i(),
-		      l_crossingPoints[k].get_j()-N[0].value*l_crossingPoints[0].get_j()-N[l_p].value*l_crossingPoints[m].get_j());
-      Rk.push_back(pt);
-      delete[] N;
+    N = computeBasisFuns(ubar[k], span, l_p, l_knots);
+
+    // Rk: data point minus the contribution of the end control points
+    double Rki = l_crossingPoints[k].get_i();
+    double Rkj = l_crossingPoints[k].get_j();
+    if (span == l_p) {
+      Rki -= N[0].value*l_crossingPoints[0].get_i();
+      Rkj -= N[0].value*l_crossingPoints[0].get_j();
     }
-    else if (span == l_p) 
-    {
-      N = computeBasisFuns(ubar[k], span, l_p, l_knots);
-      vpImagePoint pt(l_crossingPoints[k].get_i()-N[0].value*l_crossingPoints[0].get_i(),
-		      l_crossingPoints[k].get_j()-N[0].value*l_crossingPoints[0].get_j());
-      Rk.push_back(pt);
-      delete[] N;
-    }
-    else if (span == l_n)
-    {
-      N = computeBasisFuns(ubar[k], span, l_p, l_knots);
-      vpImagePoint pt(l_crossingPoints[k].get_i()-N[l_p].value*l_crossingPoints[m].get_i(),
-		      l_crossingPoints[k].get_j()-N[l_p].value*l_crossingPoints[m].get_j());
-      Rk.push_back(pt);
-      delete[] N;
-    }
-    else
-    {
-      Rk.push_back(l_crossingPoints[k]);
+    if (span == l_n) {
+      Rki -= N[l_p].value*l_crossingPoints[m].get_i();
+      Rkj -= N[l_p].value*l_crossingPoints[m].get_j();
     }
-  }
 
-  vpMatrix A(m-1,l_n-1);
-  //Compute A
-  for(unsigned int i = 1; i <= m-1; i++)
-  {
-    unsigned int span = findSpan(ubar[i], l_p, l_knots);
-    N = computeBasisFuns(ubar[i], span, l_p, l_knots);
-    for (unsigned int k = 0; k <= l_p; k++)
+    for (unsigned int a = 0; a <= l_p; a++)
     {
-      if (N[k].i > 0 && N[k].i < l_n)
-        A[i-1][N[k].i-1] = N[k].value;
+      if (N[a].i == 0 || N[a].i >= l_n)
+        continue;
+      unsigned int ra = N[a].i-1;
+      Pi[ra] += N[a].value*Rki;
+      Pj[ra] += N[a].value*Rkj;
+      Pw[ra] += N[a].value; //The crossing points weigths are equal to 1.
+      for (unsigned int b = 0; b <= l_p; b++)
+      {
+        if (N[b].i == 0 || N[b].i >= l_n)
+          continue;
+        AtA(ra, N[b].i-1) += N[a].value*N[b].value;
+      }
     }
     delete[] N;
   }
-  
-  vpColVector Ri(l_n-1);
-  vpColVector Rj(l_n-1);
-  vpColVector Rw(l_n-1);
-  for (unsigned int i = 0; i < l_n-1; i++)
-  {
-    double sum =0;
-    for (unsigned int k = 0; k < m-1; k++) sum = sum + A[k][i]*Rk[k].get_i();
-    Ri[i] = sum;
-    sum = 0;
-    for (unsigned int k = 0; k < m-1; k++) sum = sum + A[k][i]*Rk[k].get_j();
-    Rj[i] = sum;
-    sum = 0;
-    for (unsigned int k = 0; k < m-1; k++) sum = sum + A[k][i]; //The crossing points weigths are equal to 1.
-    Rw[i] = sum;
-  }
-  
-  vpMatrix AtA = A.AtA();
-  vpMatrix AtAinv;
-  AtA.pseudoInverse(AtAinv);
-  
-  vpColVector Pi = AtAinv*Ri;
-  vpColVector Pj = AtAinv*Rj;
-  vpColVector Pw = AtAinv*Rw;
-  
+
+  solveBanded(AtA, Pi, Pj, Pw);
+
   vpImagePoint pt;
   l_controlPoints.push_back(l_crossingPoints[0]);
   l_weights.push_back(1.0);
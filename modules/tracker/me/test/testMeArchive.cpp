@@ -0,0 +1,159 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test saving and loading the moving-edges parameters with vpBinaryArchive.
+ *
+ *****************************************************************************/
+/*!
+  \example testMeArchive.cpp
+
+  \brief Save the moving-edges parameters in a binary archive and load them
+  back, from the current version of the archive section and from version 1.
+*/
+
+#include <iostream>
+
+#include <visp3/core/vpBinaryArchive.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/me/vpMe.h>
+
+namespace {
+// Compare the parameters saved in all the versions of the archive section
+bool sameParameters(const vpMe &me1, const vpMe &me2)
+{
+  return me1.getThreshold() == me2.getThreshold() && me1.getMu1() == me2.getMu1() && me1.getMu2() == me2.getMu2()
+      && me1.getMinSampleStep() == me2.getMinSampleStep() && me1.getSampleStep() == me2.getSampleStep()
+      && me1.getAngleStep() == me2.getAngleStep() && me1.getMaskSign() == me2.getMaskSign()
+      && me1.getRange() == me2.getRange() && me1.getNbTotalSample() == me2.getNbTotalSample()
+      && me1.getPointsToTrack() == me2.getPointsToTrack() && me1.getMaskSize() == me2.getMaskSize()
+      && me1.getMaskNumber() == me2.getMaskNumber() && me1.getStrip() == me2.getStrip();
+}
+
+bool testArchive(const std::string &filename)
+{
+  vpMe me;
+  me.setThreshold(5000);
+  me.setMu1(0.4);
+  me.setMu2(0.6);
+  me.setMinSampleStep(3);
+  me.setSampleStep(7);
+  me.setMaskSign(1);
+  me.setRange(12);
+  me.setNbTotalSample(400);
+  me.setPointsToTrack(300);
+  me.setStrip(3);
+  me.setMaskSize(7);
+  me.setMaskNumber(90);
+  me.setSubPixel(true);
+  me.setAdaptiveRange(true);
+  me.setMinRange(5);
+
+  // Current version
+  {
+    vpBinaryArchive ar(filename, vpBinaryArchive::WRITE);
+    ar << me;
+  }
+  {
+    vpMe me2;
+    vpBinaryArchive ar(filename, vpBinaryArchive::READ);
+    ar >> me2;
+    if (! sameParameters(me, me2) || me2.getSubPixel() != me.getSubPixel()
+        || me2.getAdaptiveRange() != me.getAdaptiveRange() || me2.getMinRange() != me.getMinRange()) {
+      std::cerr << "Bad moving-edges parameters" << std::endl;
+      return false;
+    }
+    std::cout << "Moving-edges parameters: ok" << std::endl;
+  }
+
+  // Version 1, without the subpixel localisation and the adaptive range
+  {
+    vpBinaryArchive ar(filename, vpBinaryArchive::WRITE);
+    ar.writeSection(VP_ARCHIVE_TAG_ME, 1);
+    ar.writeValue(me.getThreshold());
+    ar.writeValue(me.getMu1());
+    ar.writeValue(me.getMu2());
+    ar.writeValue(me.getMinSampleStep());
+    ar.writeValue(me.getSampleStep());
+    ar.writeValue(me.getAngleStep());
+    ar.writeValue(me.getMaskSign());
+    ar.writeValue(me.getRange());
+    ar.writeValue(me.getNbTotalSample());
+    ar.writeValue(me.getPointsToTrack());
+    ar.writeValue(me.getMaskSize());
+    ar.writeValue(me.getMaskNumber());
+    ar.writeValue(me.getStrip());
+  }
+  {
+    vpMe me2;
+    vpBinaryArchive ar(filename, vpBinaryArchive::READ);
+    ar >> me2;
+    vpMe me_default;
+    if (! sameParameters(me, me2) || me2.getSubPixel() != me_default.getSubPixel()
+        || me2.getAdaptiveRange() != me_default.getAdaptiveRange() || me2.getMinRange() != me_default.getMinRange()) {
+      std::cerr << "Bad moving-edges parameters loaded from version 1" << std::endl;
+      return false;
+    }
+    std::cout << "Moving-edges parameters of version 1: ok" << std::endl;
+  }
+
+  // A newer version has to be rejected
+  {
+    vpBinaryArchive ar(filename, vpBinaryArchive::WRITE);
+    ar.writeSection(VP_ARCHIVE_TAG_ME, 100);
+  }
+  try {
+    vpMe me2;
+    vpBinaryArchive ar(filename, vpBinaryArchive::READ);
+    ar >> me2;
+    std::cerr << "Loading an unsupported version should fail" << std::endl;
+    return false;
+  }
+  catch(vpException &) {
+  }
+
+  return true;
+}
+}
+
+int main()
+{
+  std::string filename = vpIoTools::createFilePath(vpIoTools::getTempPath(), "testMeArchive.bin");
+  bool ok = false;
+  try {
+    ok = testArchive(filename);
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+  }
+
+  if (vpIoTools::checkFilename(filename))
+    vpIoTools::remove(filename);
+  return ok ? 0 : 1;
+}
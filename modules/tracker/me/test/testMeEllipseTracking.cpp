@@ -0,0 +1,133 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *
+ * Description:
+ * Benchmark of the moving-edges ellipse tracker on a synthetic sequence.
+ *
+ *****************************************************************************/
+/*!
+  \example testMeEllipseTracking.cpp
+
+  \brief Track an elliptic edge with vpMeEllipse along a synthetic sequence
+  and measure the per-frame moving-edges tracking time.
+*/
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpImagePoint.h>
+#include <visp3/core/vpMath.h>
+#include <visp3/core/vpTime.h>
+#include <visp3/me/vpMe.h>
+#include <visp3/me/vpMeEllipse.h>
+
+namespace {
+// Draw a bright ellipse of center (ic, jc), semi axes A and B and
+// orientation e on a dark background
+void drawEllipse(vpImage<unsigned char> &I, double ic, double jc, double A, double B, double e)
+{
+  double ce = cos(e), se = sin(e);
+  for (unsigned int i = 0; i < I.getHeight(); i++) {
+    for (unsigned int j = 0; j < I.getWidth(); j++) {
+      double u = (j - jc)*ce + (i - ic)*se;
+      double v = -(j - jc)*se + (i - ic)*ce;
+      double d = (sqrt(u*u/(A*A) + v*v/(B*B)) - 1) * std::min(A, B);
+      if (d < -0.5)
+        I[i][j] = 200;
+      else if (d > 0.5)
+        I[i][j] = 40;
+      else
+        I[i][j] = (unsigned char)(120 - 160*d);
+    }
+  }
+}
+}
+
+int main()
+{
+  try {
+    const unsigned int nframes = 100;
+    const double A = 120, B = 70, e = vpMath::rad(20.);
+    double ic = 240, jc = 320;
+
+    vpImage<unsigned char> I(480, 640);
+    drawEllipse(I, ic, jc, A, B, e);
+
+    vpMe me;
+    me.setRange(10);
+    me.setThreshold(5000);
+    me.setSampleStep(3);
+    me.setPointsToTrack(500);
+
+    vpMeEllipse ellipse;
+    ellipse.setMe(&me);
+    ellipse.setDisplay(vpMeSite::NONE);
+
+    // Five points on the edge in the trigonometric order
+    vpImagePoint ip[5];
+    for (unsigned int k = 0; k < 5; k++) {
+      double t = vpMath::rad(30. + 60.*k);
+      double u = A*cos(t), v = B*sin(t);
+      ip[k].set_ij(ic + u*sin(e) + v*cos(e), jc + u*cos(e) - v*sin(e));
+    }
+    ellipse.initTracking(I, 5, ip);
+
+    double t_track = 0;
+    for (unsigned int n = 0; n < nframes; n++) {
+      ic += (n % 20 < 10) ? 1.2 : -1.2;
+      jc += (n % 30 < 15) ? 0.7 : -0.7;
+      drawEllipse(I, ic, jc, A, B, e);
+
+      double t = vpTime::measureTimeMs();
+      ellipse.track(I);
+      t_track += vpTime::measureTimeMs() - t;
+
+      // The initial arc only covers part of the ellipse: once the tracker has
+      // sampled the whole contour the center must stay close to the true one.
+      vpImagePoint c = ellipse.getCenter();
+      double error = sqrt(vpMath::sqr(c.get_i() - ic) + vpMath::sqr(c.get_j() - jc));
+      if (n >= nframes / 2 && error > 2.) {
+        std::cerr << "Frame " << n << ": the center of the ellipse is " << error
+                  << " pixels away from the true one" << std::endl;
+        return 1;
+      }
+    }
+
+    std::cout << "Tracked " << ellipse.getMeList().size() << " sites over " << nframes << " frames" << std::endl;
+    std::cout << "Mean moving-edges tracking time: " << t_track / nframes << " ms/frame" << std::endl;
+    return 0;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+}
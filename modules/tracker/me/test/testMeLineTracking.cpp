@@ -0,0 +1,161 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *
+ * Description:
+ * Benchmark of the moving-edges line tracker on a synthetic sequence.
+ *
+ *****************************************************************************/
+/*!
+  \example testMeLineTracking.cpp
+
+  \brief Track a straight edge with vpMeLine along a synthetic sequence and
+  measure the per-frame moving-edges tracking time.
+*/
+
+#include <iostream>
+#include <cmath>
+#include <list>
+
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpImagePoint.h>
+#include <visp3/core/vpMath.h>
+#include <visp3/core/vpTime.h>
+#include <visp3/me/vpMe.h>
+#include <visp3/me/vpMeLine.h>
+
+namespace {
+// Draw a step edge along the line i*cos(theta) + j*sin(theta) = rho
+void drawEdge(vpImage<unsigned char> &I, double rho, double theta)
+{
+  double c = cos(theta), s = sin(theta);
+  for (unsigned int i = 0; i < I.getHeight(); i++) {
+    for (unsigned int j = 0; j < I.getWidth(); j++) {
+      double d = i*c + j*s - rho;
+      if (d < -0.5)
+        I[i][j] = 40;
+      else if (d > 0.5)
+        I[i][j] = 200;
+      else
+        I[i][j] = (unsigned char)(120 + 160*d);
+    }
+  }
+}
+
+// Track the moving edge over the sequence. Return false when the sites
+// drift away from the edge.
+bool trackEdge(bool refined, double &mean_error, double &t_track)
+{
+  const unsigned int nframes = 100;
+  const double theta = vpMath::rad(60.);
+  double rho = 200.;
+
+  vpImage<unsigned char> I(480, 640);
+  drawEdge(I, rho, theta);
+
+  vpMe me;
+  me.setRange(10);
+  me.setThreshold(5000);
+  me.setSampleStep(2);
+  me.setPointsToTrack(500);
+  me.setSubPixel(refined);
+  me.setAdaptiveRange(refined);
+
+  vpMeLine line;
+  line.setMe(&me);
+  line.setDisplay(vpMeSite::NONE);
+
+  // Two points on the edge, far from the image borders
+  double c = cos(theta), s = sin(theta);
+  vpImagePoint ip1(rho*c - 150*s, rho*s + 150*c);
+  vpImagePoint ip2(rho*c + 100*s, rho*s - 100*c);
+  line.initTracking(I, ip1, ip2);
+
+  t_track = 0;
+  mean_error = 0;
+  unsigned int nsites = 0, nerrors = 0;
+  for (unsigned int n = 0; n < nframes; n++) {
+    rho += (n % 20 < 10) ? 1.5 : -1.5;
+    drawEdge(I, rho, theta);
+
+    double t = vpTime::measureTimeMs();
+    line.track(I);
+    t_track += vpTime::measureTimeMs() - t;
+
+    // The edge moves between frames: check that most of the sites lie close
+    // to the true edge.
+    const std::list<vpMeSite> &sites = line.getMeList();
+    unsigned int ninliers = 0;
+    nsites = 0;
+    for (std::list<vpMeSite>::const_iterator it = sites.begin(); it != sites.end(); ++it) {
+      if (it->getState() != vpMeSite::NO_SUPPRESSION)
+        continue;
+      nsites ++;
+      double error = std::fabs(it->ifloat*c + it->jfloat*s - rho);
+      if (error < 3.)
+        ninliers ++;
+      mean_error += error;
+      nerrors ++;
+    }
+    if (nsites < 50 || ninliers < 0.9*nsites) {
+      std::cerr << "Frame " << n << ": only " << ninliers << " of " << nsites
+                << " tracked sites are on the edge" << std::endl;
+      return false;
+    }
+  }
+  mean_error /= nerrors;
+  t_track /= nframes;
+
+  std::cout << (refined ? "Subpixel and adaptive range: " : "Pixel and fixed range: ")
+            << nsites << " sites, mean distance to the edge " << mean_error
+            << " pixels, " << t_track << " ms/frame" << std::endl;
+  return true;
+}
+}
+
+int main()
+{
+  try {
+    double error, error_refined, t, t_refined;
+    if (! trackEdge(false, error, t))
+      return 1;
+    if (! trackEdge(true, error_refined, t_refined))
+      return 1;
+
+    if (error_refined > error) {
+      std::cerr << "Subpixel localisation does not improve the accuracy" << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,154 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *
+ * Description:
+ * Check that tracking moving-edges sites does not allocate memory.
+ *
+ *****************************************************************************/
+/*!
+  \example testMeSiteAllocation.cpp
+
+  \brief Count the heap allocations done while tracking moving-edges sites.
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <list>
+#include <new>
+
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpImagePoint.h>
+#include <visp3/core/vpMath.h>
+#include <visp3/me/vpMe.h>
+#include <visp3/me/vpMeLine.h>
+#include <visp3/me/vpMeSite.h>
+
+// Replace the global allocation functions to count the allocations
+#if (__cplusplus >= 201103L)
+#  define TEST_THROW_BAD_ALLOC
+#  define TEST_NO_THROW noexcept
+#else
+#  define TEST_THROW_BAD_ALLOC throw(std::bad_alloc)
+#  define TEST_NO_THROW throw()
+#endif
+
+static unsigned long nb_allocations = 0;
+
+void *operator new(std::size_t size) TEST_THROW_BAD_ALLOC
+{
+  nb_allocations ++;
+  void *p = malloc(size ? size : 1);
+  if (p == NULL)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](std::size_t size) TEST_THROW_BAD_ALLOC
+{
+  return operator new(size);
+}
+
+void operator delete(void *p) TEST_NO_THROW
+{
+  free(p);
+}
+
+void operator delete[](void *p) TEST_NO_THROW
+{
+  free(p);
+}
+
+#if (__cplusplus >= 201402L)
+void operator delete(void *p, std::size_t) TEST_NO_THROW
+{
+  free(p);
+}
+
+void operator delete[](void *p, std::size_t) TEST_NO_THROW
+{
+  free(p);
+}
+#endif
+
+int main()
+{
+  try {
+    // Step edge along i*cos(theta) + j*sin(theta) = rho
+    const double theta = vpMath::rad(30.);
+    const double rho = 250.;
+    vpImage<unsigned char> I(480, 640);
+    for (unsigned int i = 0; i < I.getHeight(); i++)
+      for (unsigned int j = 0; j < I.getWidth(); j++)
+        I[i][j] = (i*cos(theta) + j*sin(theta) < rho) ? 50 : 180;
+
+    vpMe me;
+    me.setRange(10);
+    me.setThreshold(5000);
+    me.setSampleStep(3);
+
+    vpMeLine line;
+    line.setMe(&me);
+    line.setDisplay(vpMeSite::NONE);
+    double c = cos(theta), s = sin(theta);
+    line.initTracking(I, vpImagePoint(rho*c - 150*s, rho*s + 150*c),
+                      vpImagePoint(rho*c + 150*s, rho*s - 150*c));
+
+    std::list<vpMeSite> &sites = line.getMeList();
+    std::cout << "Number of sites: " << sites.size() << std::endl;
+
+    // Track every site a few times along its normal
+    unsigned long nb = nb_allocations;
+    for (unsigned int n = 0; n < 10; n++)
+      for (std::list<vpMeSite>::iterator it = sites.begin(); it != sites.end(); ++it)
+        it->track(I, &me, false);
+    std::cout << "Allocations in vpMeSite::track(): " << nb_allocations - nb << std::endl;
+    if (nb_allocations != nb) {
+      std::cerr << "vpMeSite::track() should not allocate memory" << std::endl;
+      return 1;
+    }
+
+    // Track all the sites of the line as done at each frame
+    nb = nb_allocations;
+    for (unsigned int n = 0; n < 10; n++)
+      line.vpMeTracker::track(I);
+    std::cout << "Allocations in vpMeTracker::track(): " << nb_allocations - nb << std::endl;
+    if (nb_allocations != nb) {
+      std::cerr << "vpMeTracker::track() should not allocate memory" << std::endl;
+      return 1;
+    }
+
+    return 0;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+}
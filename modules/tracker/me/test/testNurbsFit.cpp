@@ -0,0 +1,111 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2015 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * ("GPL") version 2 as published by the Free Software Foundation.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *
+ * Description:
+ * Accuracy and timing of the NURBS interpolation and approximation.
+ *
+ *****************************************************************************/
+/*!
+  \example testNurbsFit.cpp
+
+  \brief Interpolate and approximate points of a smooth curve with a Nurbs,
+  check that the Nurbs lies on the curve and measure the fitting time for a
+  long contour.
+*/
+
+#include <iostream>
+#include <cmath>
+#include <list>
+
+#include <visp3/core/vpImagePoint.h>
+#include <visp3/core/vpMath.h>
+#include <visp3/core/vpTime.h>
+#include <visp3/me/vpNurbs.h>
+
+namespace {
+// Point of the curve j = 300 + 40 sin(i / 60) at row i
+vpImagePoint curvePoint(double i)
+{
+  return vpImagePoint(i, 300 + 40*sin(i/60.));
+}
+
+// Largest distance between the nurbs and the curve
+double fitError(vpNurbs &nurbs)
+{
+  double error = 0;
+  for (double u = 0; u <= 1.0; u += 0.001) {
+    vpImagePoint ip = nurbs.computeCurvePoint(u);
+    error = std::max(error, std::fabs(ip.get_j() - curvePoint(ip.get_i()).get_j()));
+  }
+  return error;
+}
+
+bool checkFit(const std::string &name, vpNurbs &nurbs, double t, double max_error)
+{
+  double error = fitError(nurbs);
+  std::cout << name << ": max error " << error << " pixels, " << t << " ms" << std::endl;
+  if (error > max_error) {
+    std::cerr << name << ": the nurbs does not fit the curve" << std::endl;
+    return false;
+  }
+  return true;
+}
+}
+
+int main()
+{
+  try {
+    std::list<vpImagePoint> points;
+    for (unsigned int k = 0; k <= 60; k++)
+      points.push_back(curvePoint(20 + 15*k));
+
+    vpNurbs interp;
+    double t = vpTime::measureTimeMs();
+    interp.globalCurveInterp(points);
+    if (! checkFit("Interpolation of 61 points", interp, vpTime::measureTimeMs() - t, 0.5))
+      return 1;
+
+    points.clear();
+    for (unsigned int k = 0; k <= 3000; k++)
+      points.push_back(curvePoint(20 + 0.3*k));
+
+    vpNurbs approx;
+    t = vpTime::measureTimeMs();
+    approx.globalCurveApprox(points, 300);
+    if (! checkFit("Approximation of 3001 points with 300 control points", approx, vpTime::measureTimeMs() - t, 0.5))
+      return 1;
+
+    return 0;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return 1;
+  }
+}